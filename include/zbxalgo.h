@@ -185,6 +185,60 @@ void	*zbx_hashset_iter_next(zbx_hashset_iter_t *iter);
 void	zbx_hashset_iter_remove(zbx_hashset_iter_t *iter);
 void	zbx_hashset_copy(zbx_hashset_t *dst, const zbx_hashset_t *src, size_t size);
 
+/* flat hashset */
+
+/* Open addressing hashset storing fixed size elements inline in the slot array. Slots are     */
+/* probed in groups of ZBX_FLATHASHSET_GROUP_SIZE by comparing one byte control metadata.      */
+/* Unlike zbx_hashset_t the element pointers stay valid only until the next insert operation. */
+
+#define ZBX_FLATHASHSET_GROUP_SIZE	16
+
+typedef struct
+{
+	char			*data;
+	unsigned char		*ctrl;
+	int			num_slots;
+	int			num_data;
+	int			num_deleted;
+	size_t			elem_size;
+	zbx_hash_func_t		hash_func;
+	zbx_compare_func_t	compare_func;
+	zbx_clean_func_t	clean_func;
+	zbx_mem_malloc_func_t	mem_malloc_func;
+	zbx_mem_free_func_t	mem_free_func;
+}
+zbx_flathashset_t;
+
+void	zbx_flathashset_create(zbx_flathashset_t *fhs, size_t init_size, size_t elem_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func);
+void	zbx_flathashset_create_ext(zbx_flathashset_t *fhs, size_t init_size, size_t elem_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_free_func_t mem_free_func);
+void	zbx_flathashset_destroy(zbx_flathashset_t *fhs);
+
+int	zbx_flathashset_reserve(zbx_flathashset_t *fhs, int num_data_req);
+void	*zbx_flathashset_insert(zbx_flathashset_t *fhs, const void *data, size_t size);
+void	*zbx_flathashset_search(const zbx_flathashset_t *fhs, const void *data);
+void	zbx_flathashset_remove(zbx_flathashset_t *fhs, const void *data);
+void	zbx_flathashset_remove_direct(zbx_flathashset_t *fhs, void *data);
+
+void	zbx_flathashset_clear(zbx_flathashset_t *fhs);
+
+typedef struct
+{
+	zbx_flathashset_t	*fhs;
+	int			slot;
+}
+zbx_flathashset_iter_t;
+
+void	zbx_flathashset_iter_reset(zbx_flathashset_t *fhs, zbx_flathashset_iter_t *iter);
+void	*zbx_flathashset_iter_next(zbx_flathashset_iter_t *iter);
+void	zbx_flathashset_iter_remove(zbx_flathashset_iter_t *iter);
+
 /* hashmap */
 
 /* currently, we only have a very specialized hashmap */
@@ -285,6 +339,61 @@ void			zbx_binary_heap_remove_direct(zbx_binary_heap_t *heap, zbx_uint64_t key);
 
 void			zbx_binary_heap_clear(zbx_binary_heap_t *heap);
 
+/* hierarchical timing wheel */
+
+#define ZBX_TIMEWHEEL_ROOT_BITS		8
+#define ZBX_TIMEWHEEL_LEVEL_BITS	6
+#define ZBX_TIMEWHEEL_LEVELS		4
+
+#define ZBX_TIMEWHEEL_ROOT_SIZE		(1 << ZBX_TIMEWHEEL_ROOT_BITS)
+#define ZBX_TIMEWHEEL_LEVEL_SIZE	(1 << ZBX_TIMEWHEEL_LEVEL_BITS)
+#define ZBX_TIMEWHEEL_SLOTS_NUM		(ZBX_TIMEWHEEL_ROOT_SIZE + \
+					(ZBX_TIMEWHEEL_LEVELS - 1) * ZBX_TIMEWHEEL_LEVEL_SIZE)
+
+typedef struct zbx_timewheel_node zbx_timewheel_node_t;
+
+/* Elements are scheduled into 1 second root slots or coarser upper level slots by their expiration */
+/* time and cascaded down as the wheel time advances. Expired elements are moved to the ready heap, */
+/* which orders them with the compare function, so elements expiring in the same second are         */
+/* returned in the same order as from a binary heap.                                                */
+typedef struct
+{
+	zbx_timewheel_node_t	*slots[ZBX_TIMEWHEEL_SLOTS_NUM];
+	int			levels_num[ZBX_TIMEWHEEL_LEVELS];	/* number of elements in each level */
+	int			now;					/* the wheel time */
+	zbx_hashset_t		nodes;					/* all elements by key */
+
+	/* binary heap of elements expired at wheel time */
+	zbx_timewheel_node_t	**ready;
+	int			ready_num;
+	int			ready_alloc;
+	zbx_binary_heap_elem_t	min;
+	zbx_compare_func_t	compare_func;
+
+	zbx_mem_malloc_func_t	mem_malloc_func;
+	zbx_mem_realloc_func_t	mem_realloc_func;
+	zbx_mem_free_func_t	mem_free_func;
+}
+zbx_timewheel_t;
+
+void			zbx_timewheel_create(zbx_timewheel_t *tw, zbx_compare_func_t compare_func);
+void			zbx_timewheel_create_ext(zbx_timewheel_t *tw, zbx_compare_func_t compare_func,
+							zbx_mem_malloc_func_t mem_malloc_func,
+							zbx_mem_realloc_func_t mem_realloc_func,
+							zbx_mem_free_func_t mem_free_func);
+void			zbx_timewheel_destroy(zbx_timewheel_t *tw);
+
+int			zbx_timewheel_empty(const zbx_timewheel_t *tw);
+int			zbx_timewheel_size(const zbx_timewheel_t *tw);
+zbx_binary_heap_elem_t	*zbx_timewheel_find_min(zbx_timewheel_t *tw);
+int			zbx_timewheel_next_expire(const zbx_timewheel_t *tw);
+void			zbx_timewheel_insert(zbx_timewheel_t *tw, zbx_binary_heap_elem_t *elem, int expire);
+void			zbx_timewheel_update_direct(zbx_timewheel_t *tw, zbx_binary_heap_elem_t *elem, int expire);
+void			zbx_timewheel_remove_min(zbx_timewheel_t *tw);
+void			zbx_timewheel_remove_direct(zbx_timewheel_t *tw, zbx_uint64_t key);
+
+void			zbx_timewheel_clear(zbx_timewheel_t *tw);
+
 /* vector implementation start */
 
 #define ZBX_VECTOR_STRUCT_DECL(__id, __type)									\
@@ -38,5 +38,17 @@ typedef void (*zbx_async_task_clear_cb_t)(void *data);
 
 void	zbx_async_poller_add_task(struct event_base *ev, struct evdns_base *dnsbase, const char *addr,
 		void *data, int timeout, zbx_async_task_process_cb_t process_cb, zbx_async_task_clear_cb_t clear_cb);
+
+typedef struct
+{
+	zbx_uint64_t	enters;		/* io_uring_enter() system calls */
+	zbx_uint64_t	submitted;	/* submitted requests */
+	zbx_uint64_t	completed;	/* reaped completions */
+}
+zbx_async_uring_stats_t;
+
+int	zbx_async_poller_uring_init(struct event_base *ev, char **error);
+void	zbx_async_poller_uring_destroy(void);
+int	zbx_async_poller_uring_get_stats(zbx_async_uring_stats_t *stats);
 #endif
 #endif
@@ -0,0 +1,39 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ATOMIC_H
+#define ZABBIX_ATOMIC_H
+
+#include "zbxsysinc.h"
+
+/* Memory ordering primitives for data shared between processes without locking.   */
+/* Code using them must provide a locking fallback when HAVE_ATOMIC_BUILTINS is not */
+/* defined.                                                                         */
+#if defined(HAVE_ATOMIC_BUILTINS)
+#	define ZBX_ATOMIC_LOAD_ACQUIRE(ptr)		__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#	define ZBX_ATOMIC_LOAD_RELAXED(ptr)		__atomic_load_n(ptr, __ATOMIC_RELAXED)
+#	define ZBX_ATOMIC_STORE_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#	define ZBX_ATOMIC_STORE_RELAXED(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELAXED)
+#	define ZBX_ATOMIC_FENCE_ACQUIRE()		__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#	define ZBX_ATOMIC_FENCE_RELEASE()		__atomic_thread_fence(__ATOMIC_RELEASE)
+#	define ZBX_ATOMIC_FENCE_FULL()			__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#	define ZBX_ATOMIC_EXCHANGE(ptr, value)		__atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST)
+#endif
+
+#endif /* ZABBIX_ATOMIC_H */
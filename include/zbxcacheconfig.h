@@ -247,6 +247,24 @@ typedef struct
 }
 zbx_history_sync_item_t;
 
+/* host information of exported history and trends */
+typedef struct
+{
+	zbx_uint64_t		hostid;
+	zbx_vector_str_t	groups;
+}
+zbx_history_export_host_t;
+
+/* item information of exported history and trends */
+typedef struct
+{
+	zbx_uint64_t			itemid;
+	char				*name;
+	const zbx_history_sync_item_t	*item;
+	zbx_vector_tags_t		item_tags;
+}
+zbx_history_export_item_t;
+
 typedef struct
 {
 	zbx_uint64_t	hostid;
@@ -762,6 +780,7 @@ void	zbx_dc_config_history_sync_get_triggers_by_itemids(zbx_hashset_t *trigger_i
 		int itemids_num);
 void	zbx_dc_config_clean_history_sync_items(zbx_history_sync_item_t *items, int *errcodes, size_t num);
 void	zbx_dc_config_history_sync_unset_existing_itemids(zbx_vector_uint64_t *itemids);
+void	zbx_dc_config_history_sync_get_export_info(zbx_hashset_t *hosts_info, zbx_hashset_t *items_info);
 
 void	zbx_dc_config_history_recv_get_items_by_keys(zbx_history_recv_item_t *items, const zbx_host_key_t *keys,
 		int *errcodes, size_t num);
@@ -776,7 +795,7 @@ void	zbx_connector_filter_free(zbx_connector_filter_t connector_filter);
 
 int	zbx_dc_config_get_active_items_count_by_hostid(zbx_uint64_t hostid);
 void	zbx_dc_config_get_active_items_by_hostid(zbx_dc_item_t *items, zbx_uint64_t hostid, int *errcodes, size_t num);
-void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_dc_um_shared_handle_t **um_handle,
+void	zbx_dc_config_get_preprocessable_items(zbx_flathashset_t *items, zbx_dc_um_shared_handle_t **um_handle,
 		zbx_uint64_t *revision);
 void	zbx_dc_config_get_functions_by_functionids(zbx_dc_function_t *functions,
 		zbx_uint64_t *functionids, int *errcodes, size_t num);
@@ -824,6 +843,14 @@ void	zbx_dc_config_delete_autoreg_host(const zbx_vector_ptr_t *autoreg_hosts);
 void	zbx_dc_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks, const int *errcodes, size_t num);
 void	zbx_dc_poller_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 		const int *errcodes, size_t num, unsigned char poller_type, int *nextcheck);
+int	zbx_dc_config_get_owned_poller_items(unsigned char poller_type, const zbx_uint64_t *itemids,
+		const zbx_uint64_t *revisions, int itemids_num, zbx_dc_item_t *items, zbx_vector_uint64_t *released,
+		zbx_uint64_t *revision);
+void	zbx_dc_poller_get_owned_nextchecks(const zbx_uint64_t *itemids, const int *lastclocks, int *nextchecks,
+		size_t num);
+void	zbx_dc_poller_validate_owned_items(unsigned char poller_type, const zbx_uint64_t *itemids,
+		const zbx_uint64_t *revisions, int itemids_num, zbx_vector_uint64_t *released, zbx_uint64_t *revision);
+void	zbx_dc_poller_flush_owned_nextchecks(const zbx_uint64_t *itemids, const int *nextchecks, size_t num);
 #ifdef HAVE_OPENIPMI
 void	zbx_dc_requeue_unreachable_items(zbx_uint64_t *itemids, size_t itemids_num);
 #endif
@@ -893,6 +920,55 @@ double		zbx_dc_get_required_performance(void);
 zbx_uint64_t	zbx_dc_get_host_count(void);
 void		zbx_dc_get_count_stats_all(zbx_config_cache_info_t *stats);
 
+#define ZBX_DC_SYNC_TABLES_MAX		48
+#define ZBX_DC_SYNC_TABLE_NAME_LEN	32
+
+/* configuration sync statistics of a single table */
+typedef struct
+{
+	char		name[ZBX_DC_SYNC_TABLE_NAME_LEN];
+	double		sql_sec;	/* time spent reading database (and comparing with cache) */
+	double		sync_sec;	/* time spent updating cache under write lock             */
+	zbx_uint64_t	add_num;
+	zbx_uint64_t	update_num;
+	zbx_uint64_t	remove_num;
+}
+zbx_dc_sync_table_stats_t;
+
+/* statistics of the last configuration sync */
+typedef struct
+{
+	int				sync_ts;
+	unsigned char			mode;		/* ZBX_DBSYNC_INIT or ZBX_DBSYNC_UPDATE */
+	int				changelog_num;
+	double				changelog_sec;
+	double				total_sec;
+	double				lock_sec;	/* total write lock hold time */
+	double				lock_max_sec;	/* the longest single write lock hold time */
+	int				lock_num;
+	int				tables_num;
+	zbx_dc_sync_table_stats_t	tables[ZBX_DC_SYNC_TABLES_MAX];
+}
+zbx_dc_sync_stats_t;
+
+void	zbx_dc_get_sync_stats(zbx_dc_sync_stats_t *stats);
+
+/* passive agent session statistics of asynchronous agent pollers */
+typedef struct
+{
+	zbx_uint64_t	connections;	/* connections opened for agent sessions */
+	zbx_uint64_t	reused;		/* batch requests sent over reused connection */
+	zbx_uint64_t	expired;	/* idle connections closed by timeout or agent */
+	zbx_uint64_t	requests;	/* batch requests sent */
+	zbx_uint64_t	checks;		/* checks sent in batch requests */
+	zbx_uint64_t	fallbacks;	/* agents detected without batch support */
+	zbx_uint64_t	idle;		/* idle connections kept by pollers */
+}
+zbx_dc_agent_session_stats_t;
+
+void	zbx_dc_add_agent_session_stats(const zbx_dc_agent_session_stats_t *stats, int idle_delta);
+void	zbx_dc_get_agent_session_stats(zbx_dc_agent_session_stats_t *stats);
+
 void	zbx_dc_get_status(zbx_vector_ptr_t *hosts_monitored, zbx_vector_ptr_t *hosts_not_monitored,
 		zbx_vector_ptr_t *items_active_normal, zbx_vector_ptr_t *items_active_notsupported,
 		zbx_vector_ptr_t *items_disabled, zbx_uint64_t *triggers_enabled_ok,
@@ -1228,6 +1304,8 @@ int	zbx_dc_httptest_next(time_t now, zbx_uint64_t *httptestid, time_t *nextcheck
 void	zbx_dc_httptest_queue(time_t now, zbx_uint64_t httptestid, int delay);
 
 zbx_uint64_t	zbx_dc_get_received_revision(void);
+zbx_uint64_t	zbx_dc_get_config_revision(void);
+zbx_uint64_t	zbx_dc_get_lld_rule_revision(zbx_uint64_t lld_ruleid);
 void	zbx_dc_update_received_revision(zbx_uint64_t revision);
 
 void	zbx_dc_get_proxy_config_updates(zbx_uint64_t proxyid, zbx_uint64_t revision, zbx_vector_uint64_t *hostids,
@@ -22,10 +22,16 @@
 
 #include "zbxcacheconfig.h"
 #include "zbxshmem.h"
+#include "zbxmutexs.h"
 
 #define ZBX_SYNC_DONE		0
 #define	ZBX_SYNC_MORE		1
 
+#define ZBX_HC_SHARDS_MAX	ZBX_MUTEX_CACHE_SHARDS_MAX
+
+/* the minimum history cache and history index cache size of a single shard */
+#define ZBX_HC_SHARD_SIZE_MIN	(128 * ZBX_KIBIBYTE)
+
 typedef struct
 {
 	zbx_uint64_t	history_counter;	/* the total number of processed values */
@@ -39,16 +45,33 @@ typedef struct
 }
 zbx_dc_stats_t;
 
-/* the write cache statistics */
+/* the history cache shard statistics */
 typedef struct
 {
-	zbx_dc_stats_t	stats;
 	zbx_uint64_t	history_free;
 	zbx_uint64_t	history_total;
 	zbx_uint64_t	index_free;
 	zbx_uint64_t	index_total;
-	zbx_uint64_t	trend_free;
-	zbx_uint64_t	trend_total;
+	zbx_uint64_t	items_num;
+	zbx_uint64_t	values_num;
+	zbx_uint64_t	lock_num;	/* the number of shard lock acquisitions */
+	double		lock_wait;	/* the total time spent waiting for shard lock, in seconds */
+}
+zbx_hc_shard_stats_t;
+
+/* the write cache statistics */
+typedef struct
+{
+	zbx_dc_stats_t		stats;
+	zbx_uint64_t		history_free;
+	zbx_uint64_t		history_total;
+	zbx_uint64_t		index_free;
+	zbx_uint64_t		index_total;
+	zbx_uint64_t		trend_free;
+	zbx_uint64_t		trend_total;
+	int			shards_num;
+	zbx_hc_shard_stats_t	shards[ZBX_HC_SHARDS_MAX];
+	zbx_db_insert_stats_t	insert_stats[ZBX_DB_INSERT_STATS_TABLES_NUM];
 }
 zbx_wcache_info_t;
 
@@ -61,11 +84,14 @@ void	zbx_log_sync_history_cache_progress(void);
 typedef void (*zbx_history_sync_f)(int *values_num, int *triggers_num, const zbx_events_funcs_t *events_cbs, int *more);
 
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history_sync_f sync_history,
-		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size,zbx_uint64_t *trends_cache_size,
-		char **error);
+		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size, int history_cache_shards,
+		zbx_uint64_t *trends_cache_size, char **error);
 
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs);
 
+int	zbx_hc_writer_start(char **error);
+void	zbx_hc_writer_stop(void);
+
 void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_events_funcs_t *events_cbs, int *more);
 
 #define ZBX_STATS_HISTORY_COUNTER	0
@@ -123,6 +149,7 @@ void	zbx_dc_update_interfaces_availability(void);
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num);
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index);
 void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items);
+int	zbx_hc_get_shard_stats(zbx_hc_shard_stats_t *shards);
 
 int	zbx_db_trigger_queue_locked(void);
 void	zbx_db_trigger_queue_unlock(void);
@@ -50,6 +50,9 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ *   Numeric values can be aggregated with zbx_vc_process_values() function, which passes
+ *   the cached values directly to the specified callback instead of copying them.
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
@@ -108,7 +111,18 @@ int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_
 int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
 		zbx_history_record_t *value);
 
+/* The callback used to process item values without copying them from cache. The values are passed in */
+/* blocks of consecutive values stored in ascending order, starting with the block of newest values.  */
+typedef void	(*zbx_vc_process_func_t)(const zbx_history_value_t *values, int values_num, void *data);
+
+/* the maximum size of the callback data, it is saved on stack to be restored if processing is repeated */
+#define ZBX_VC_PROCESS_DATA_MAX	256
+
+int	zbx_vc_process_values(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_process_func_t process_func, void *data, size_t data_size);
+
 int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush);
+void	zbx_vc_cache_values(zbx_vector_ptr_t *history);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
 
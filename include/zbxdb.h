@@ -139,6 +139,7 @@ int		zbx_db_statement_execute(int iters);
 void	zbx_mysql_escape_bin(const char *src, char *dst, size_t size);
 #elif defined(HAVE_POSTGRESQL)
 void	zbx_postgresql_escape_bin(const char *src, char **dst, size_t size);
+int	zbx_db_copy_from(const char *sql, const char *data, size_t data_len);
 #endif
 
 int		zbx_db_vexecute(const char *fmt, va_list args);
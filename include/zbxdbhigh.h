@@ -690,9 +690,26 @@ typedef struct
 	int			autoincrement;
 	/* the last id assigned by autoincrement */
 	zbx_uint64_t		lastid;
+	/* index of the table in bulk insert statistics or -1 if the table is not tracked */
+	int			stats_index;
+	/* 1 if rows can be written with COPY (string values are stored unescaped), 0 otherwise */
+	unsigned char		copy;
 }
 zbx_db_insert_t;
 
+/* the bulk insert statistics of history and trends tables */
+#define ZBX_DB_INSERT_STATS_TABLES_NUM	7
+
+typedef struct
+{
+	zbx_uint64_t	rows;		/* the number of written rows */
+	zbx_uint64_t	bytes;		/* the size of written row data */
+	zbx_uint64_t	copy_rows;	/* the number of rows written with COPY */
+	zbx_uint64_t	copy_fallbacks;	/* the number of failed COPY operations retried with INSERT */
+	double		time;		/* the time spent writing rows, in seconds */
+}
+zbx_db_insert_stats_t;
+
 void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const zbx_db_table_t *table, const zbx_db_field_t **fields,
 		int fields_num);
 void	zbx_db_insert_prepare(zbx_db_insert_t *self, const char *table, ...);
@@ -702,6 +719,9 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self);
 void	zbx_db_insert_clean(zbx_db_insert_t *self);
 void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name);
 zbx_uint64_t	zbx_db_insert_get_lastid(zbx_db_insert_t *self);
+const char	*zbx_db_insert_stats_table(int index);
+void	zbx_db_insert_stats_collect(zbx_db_insert_stats_t *stats);
+int	zbx_db_insert_format_copy(const zbx_db_insert_t *self, char **data, size_t *data_alloc, size_t *data_offset);
 
 int	zbx_db_get_database_type(void);
 
@@ -321,5 +321,25 @@ int	zbx_init_count_pattern(char *operator, char *pattern, unsigned char value_ty
 		zbx_eval_count_pattern_data_t *pdata, char **error);
 int	zbx_count_var_vector_with_pattern(zbx_eval_count_pattern_data_t *pdata, char *pattern, zbx_vector_var_t *values,
 		int limit, int *count, char **error);
+int	zbx_count_dbl_values_with_pattern(const zbx_eval_count_pattern_data_t *pdata, const double *values,
+		int values_num);
+int	zbx_count_ui64_values_with_pattern(const zbx_eval_count_pattern_data_t *pdata, const zbx_uint64_t *values,
+		int values_num);
 void	zbx_clear_count_pattern(zbx_eval_count_pattern_data_t *pdata);
+
+#define ZBX_EVAL_AGGR_ISA_SCALAR	0
+#define ZBX_EVAL_AGGR_ISA_SSE2		1
+#define ZBX_EVAL_AGGR_ISA_AVX2		2
+
+int		zbx_eval_aggr_set_isa(int isa);
+double		zbx_eval_aggr_sum_dbl(const double *values, int values_num);
+double		zbx_eval_aggr_min_dbl(const double *values, int values_num);
+double		zbx_eval_aggr_max_dbl(const double *values, int values_num);
+double		zbx_eval_aggr_sumsq_dbl(const double *values, int values_num, double mean);
+int		zbx_eval_aggr_count_dbl(const double *values, int values_num, int op, double pattern, double epsilon);
+zbx_uint64_t	zbx_eval_aggr_sum_ui64(const zbx_uint64_t *values, int values_num);
+zbx_uint64_t	zbx_eval_aggr_min_ui64(const zbx_uint64_t *values, int values_num);
+zbx_uint64_t	zbx_eval_aggr_max_ui64(const zbx_uint64_t *values, int values_num);
+int		zbx_eval_aggr_count_ui64(const zbx_uint64_t *values, int values_num, int op, zbx_uint64_t pattern,
+		zbx_uint64_t mask);
 #endif
@@ -26,13 +26,7 @@
 #define ZBX_FLAG_EXPTYPE_HISTORY	2
 #define ZBX_FLAG_EXPTYPE_TRENDS		4
 
-typedef struct
-{
-	char	*name;
-	FILE	*file;
-	int	missing;
-}
-zbx_export_file_t;
+typedef struct zbx_export_file	zbx_export_file_t;
 
 typedef zbx_export_file_t	*(*zbx_get_export_file_f)(void);
 
@@ -41,6 +35,10 @@ typedef struct
 	char		*dir;
 	char		*type;
 	zbx_uint64_t	file_size;
+	int		file_count;
+	int		compress;
+	int		fsync;
+	int		async;
 } zbx_config_export_t;
 
 int	zbx_init_library_export(zbx_config_export_t *zbx_config_export, char **error);
@@ -51,6 +49,9 @@ int	zbx_is_export_enabled(uint32_t flags);
 int	zbx_has_export_dir(void);
 void	zbx_export_deinit(zbx_export_file_t *file);
 
+int	zbx_export_writer_start(char **error);
+void	zbx_export_writer_stop(void);
+
 zbx_export_file_t	*zbx_problems_export_init(zbx_get_export_file_f get_export_file_cb, const char *process_name,
 		int process_num);
 void	zbx_problems_export_write(const char *buf, size_t count);
@@ -44,6 +44,10 @@ typedef struct
 }
 zbx_ipc_message_t;
 
+ZBX_PTR_VECTOR_DECL(ipcmsg, zbx_ipc_message_t *)
+
+typedef struct zbx_ipc_shm zbx_ipc_shm_t;
+
 /* Messaging socket, providing blocking connections to IPC service. */
 /* The IPC socket api is used for simple write/read operations.     */
 typedef struct
@@ -55,6 +59,9 @@ typedef struct
 	unsigned char	rx_buffer[ZBX_IPC_SOCKET_BUFFER_SIZE];
 	zbx_uint32_t	rx_buffer_bytes;
 	zbx_uint32_t	rx_buffer_offset;
+
+	/* shared memory ring for messages sent to service, NULL if not negotiated */
+	zbx_ipc_shm_t	*shm;
 }
 zbx_ipc_socket_t;
 
@@ -98,10 +105,13 @@ void	zbx_ipc_service_free_env(void);
 int	zbx_ipc_service_start(zbx_ipc_service_t *service, const char *service_name, char **error);
 int	zbx_ipc_service_recv(zbx_ipc_service_t *service, const zbx_timespec_t *timeout, zbx_ipc_client_t **client,
 		zbx_ipc_message_t **message);
+int	zbx_ipc_service_recv_batch(zbx_ipc_service_t *service, const zbx_timespec_t *timeout,
+		zbx_ipc_client_t **client, zbx_vector_ipcmsg_t *messages, int max_num);
 void	zbx_ipc_service_alert(zbx_ipc_service_t *service);
 void	zbx_ipc_service_close(zbx_ipc_service_t *service);
 
 int	zbx_ipc_client_send(zbx_ipc_client_t *client, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size);
+int	zbx_ipc_client_send_batch(zbx_ipc_client_t *client, const zbx_vector_ipcmsg_t *messages);
 void	zbx_ipc_client_close(zbx_ipc_client_t *client);
 int	zbx_ipc_client_get_fd(zbx_ipc_client_t *client);
 
@@ -114,9 +124,12 @@ void	zbx_ipc_client_set_userdata(zbx_ipc_client_t *client, void *userdata);
 void	*zbx_ipc_client_get_userdata(zbx_ipc_client_t *client);
 
 int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int timeout, char **error);
+int	zbx_ipc_socket_open_ext(zbx_ipc_socket_t *csocket, const char *service_name, int timeout, zbx_uint32_t shm_size,
+		char **error);
 void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket);
 int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data,
 		zbx_uint32_t size);
+int	zbx_ipc_socket_write_batch(zbx_ipc_socket_t *csocket, const zbx_vector_ipcmsg_t *messages);
 int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message);
 int	zbx_ipc_socket_connected(const zbx_ipc_socket_t *csocket);
 
@@ -208,6 +208,7 @@
 #define ZBX_PROTO_TAG_ACKNOWLEDGEID		"acknowledgeid"
 #define ZBX_PROTO_TAG_WAIT			"wait"
 #define ZBX_PROTO_TAG_RUNTIME_ERROR		"runtime_error"
+#define ZBX_PROTO_TAG_SESSION_TIMEOUT		"session_timeout"
 
 #define ZBX_PROTO_VALUE_FAILED		"failed"
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
@@ -225,6 +226,7 @@
 #define ZBX_PROTO_VALUE_PROXY_DATA		"proxy data"
 #define ZBX_PROTO_VALUE_PROXY_TASKS		"proxy tasks"
 #define ZBX_PROTO_VALUE_ACTIVE_CHECK_HEARTBEAT	"active check heartbeat"
+#define ZBX_PROTO_VALUE_PASSIVE_CHECKS		"passive checks"
 
 #define ZBX_PROTO_VALUE_GET_QUEUE_OVERVIEW	"overview"
 #define ZBX_PROTO_VALUE_GET_QUEUE_PROXY		"overview by proxy"
@@ -374,10 +376,20 @@ zbx_jsonobj_el_t;
 
 typedef struct zbx_jsonpath_index zbx_jsonpath_index_t;
 
+/* definite jsonpath query for streaming evaluation */
+typedef struct
+{
+	zbx_jsonpath_t	*path;
+	char		*output;	/* the matched value or NULL */
+}
+zbx_jsonpath_query_t;
+
 int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output);
 int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const char *path, char **output);
 void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
+int	zbx_jsonpath_is_streamable(const zbx_jsonpath_t *jsonpath);
+int	zbx_jsonpath_query_stream(const char *data, zbx_jsonpath_query_t *queries, int queries_num);
 
 zbx_jsonpath_index_t	*zbx_jsonpath_index_create(char **error);
 void	zbx_jsonpath_index_free(zbx_jsonpath_index_t *index);
@@ -385,6 +397,8 @@ void	zbx_jsonpath_index_free(zbx_jsonpath_index_t *index);
 int	zbx_jsonobj_open(const char *data, zbx_jsonobj_t *obj);
 void	zbx_jsonobj_clear(zbx_jsonobj_t *obj);
 int	zbx_jsonobj_query(zbx_jsonobj_t *obj, const char *path, char **output);
+int	zbx_jsonobj_query_compiled(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, zbx_jsonpath_t *jsonpath,
+		char **output);
 int	zbx_jsonobj_to_string(char **str, size_t *str_alloc, size_t *str_offset, zbx_jsonobj_t *obj);
 
 #endif /* ZABBIX_ZJSON_H */
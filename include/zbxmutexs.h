@@ -23,6 +23,9 @@
 #include "zbxcommon.h"
 #include "zbxprof.h"
 
+/* the maximum number of history cache shards, each shard is protected by its own mutex */
+#define ZBX_MUTEX_CACHE_SHARDS_MAX	16
+
 #ifdef _WINDOWS
 #	define ZBX_MUTEX_NULL		NULL
 
@@ -34,6 +37,7 @@ typedef HANDLE zbx_mutex_t;
 
 #	define zbx_mutex_lock(mutex)		__zbx_mutex_lock(__FILE__, __LINE__, mutex)
 #	define zbx_mutex_unlock(mutex)		__zbx_mutex_unlock(__FILE__, __LINE__, mutex)
+#	define zbx_mutex_trylock(mutex)		__zbx_mutex_trylock(__FILE__, __LINE__, mutex)
 #else	/* not _WINDOWS */
 typedef enum
 {
@@ -57,6 +61,8 @@ typedef enum
 	ZBX_MUTEX_REMOTE_COMMANDS,
 	ZBX_MUTEX_PROXY_BUFFER,
 	ZBX_MUTEX_VPS_MONITOR,
+	ZBX_MUTEX_CACHE_SHARD,
+	ZBX_MUTEX_CACHE_SHARD_LAST = ZBX_MUTEX_CACHE_SHARD + ZBX_MUTEX_CACHE_SHARDS_MAX - 1,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
 	ZBX_MUTEX_COUNT
 }
@@ -175,11 +181,18 @@ zbx_rwlock_t	zbx_rwlock_addr_get(zbx_rwlock_name_t rwlock_name);
 		zbx_prof_end();						\
 	}								\
 	while(0)
+
+/* successful lock is profiled as a lock without waiting, to match profiling in zbx_mutex_unlock() */
+#	define zbx_mutex_trylock(mutex)					\
+									\
+	(SUCCEED == __zbx_mutex_trylock(__FILE__, __LINE__, mutex) ?	\
+			(zbx_prof_start(__func__, ZBX_PROF_MUTEX), zbx_prof_end_wait(), SUCCEED) : FAIL)
 #endif	/* _WINDOWS */
 
 int	zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error);
 void	__zbx_mutex_lock(const char *filename, int line, zbx_mutex_t mutex);
 void	__zbx_mutex_unlock(const char *filename, int line, zbx_mutex_t mutex);
+int	__zbx_mutex_trylock(const char *filename, int line, zbx_mutex_t mutex);
 void	zbx_mutex_destroy(zbx_mutex_t *mutex);
 
 #ifdef _WINDOWS
@@ -90,7 +90,7 @@ void	zbx_pp_test_task_get_data(zbx_pp_task_t *task, zbx_ipc_client_t **client, z
 		zbx_pp_result_t **results, int *results_num, zbx_pp_history_t **history);
 void	zbx_pp_tasks_clear(zbx_vector_pp_task_ptr_t *tasks);
 
-zbx_hashset_t	*zbx_pp_manager_items(zbx_pp_manager_t *manager);
+zbx_flathashset_t	*zbx_pp_manager_items(zbx_pp_manager_t *manager);
 
 typedef struct
 {
@@ -101,6 +101,17 @@ zbx_pp_sequence_stats_t;
 
 ZBX_PTR_VECTOR_DECL(pp_sequence_stats_ptr, zbx_pp_sequence_stats_t *)
 
+/* shared preprocessing step prefix cache statistics of master item */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hits;
+	zbx_uint64_t	misses;
+}
+zbx_pp_prefix_stats_t;
+
+ZBX_PTR_VECTOR_DECL(pp_prefix_stats_ptr, zbx_pp_prefix_stats_t *)
+
 int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error);
 void zbx_preproc_stats_ext_get(struct zbx_json *json, const void *arg);
 zbx_uint64_t	zbx_preprocessor_get_queue_size(void);
@@ -109,8 +120,10 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
 		unsigned char item_flags, AGENT_RESULT *result, zbx_timespec_t *ts, unsigned char state, char *error);
 void	zbx_preprocessor_flush(void);
 int	zbx_preprocessor_get_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, char **error);
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_uint64_t *steals_num, double *lock_wait,
+		char **error);
 int	zbx_preprocessor_get_top_sequences(int limit, zbx_vector_pp_sequence_stats_ptr_t *sequences, char **error);
+int	zbx_preprocessor_get_top_prefixes(int limit, zbx_vector_pp_prefix_stats_ptr_t *prefixes, char **error);
 int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx_timespec_t *ts,
 		unsigned char state, const zbx_vector_pp_step_ptr_t *steps, zbx_vector_pp_result_ptr_t *results,
 		zbx_pp_history_t *history, char **error);
@@ -28,6 +28,21 @@
 #define SHMEM_MAX_BUCKET_SIZE		256 /* starting from this size all free chunks are put into the same bucket */
 #define ZBX_SHMEM_BUCKET_COUNT		((SHMEM_MAX_BUCKET_SIZE - ZBX_SHMEM_MIN_BUCKET_SIZE) / 8 + 1)
 
+#define ZBX_SHMEM_SLAB_CLASSES_MAX	8
+
+/* size class of fixed size objects served from slabs */
+typedef struct
+{
+	zbx_uint64_t	size;		/* object size, multiple of 8 */
+	zbx_uint64_t	slab_size;	/* size of slab chunk allocated from the shared memory */
+	void		*slabs;		/* slabs having free objects */
+	zbx_uint64_t	slabs_num;
+	zbx_uint64_t	used_num;
+	zbx_uint64_t	free_num;
+	unsigned int	objects_num;	/* objects per slab */
+}
+zbx_shmem_slab_class_t;
+
 typedef struct
 {
 	void		*base;
@@ -47,9 +62,22 @@ typedef struct
 
 	const char	*mem_descr;
 	const char	*mem_param;
+
+	/* optional fixed size object classes, see zbx_shmem_add_slab_class() */
+	zbx_shmem_slab_class_t	slab_classes[ZBX_SHMEM_SLAB_CLASSES_MAX];
+	int			slab_classes_num;
 }
 zbx_shmem_info_t;
 
+typedef struct
+{
+	zbx_uint64_t	size;
+	zbx_uint64_t	slabs_num;
+	zbx_uint64_t	used_num;
+	zbx_uint64_t	free_num;
+}
+zbx_shmem_slab_stats_t;
+
 typedef struct
 {
 	zbx_uint64_t	free_size;
@@ -60,6 +88,9 @@ typedef struct
 	unsigned int	chunks_num[ZBX_SHMEM_BUCKET_COUNT];
 	unsigned int	free_chunks;
 	unsigned int	used_chunks;
+
+	zbx_shmem_slab_stats_t	slab_classes[ZBX_SHMEM_SLAB_CLASSES_MAX];
+	int			slab_classes_num;
 }
 zbx_shmem_stats_t;
 
@@ -68,6 +99,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 int	zbx_shmem_create_min(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error);
 void	zbx_shmem_destroy(zbx_shmem_info_t *info);
+void	zbx_shmem_add_slab_class(zbx_shmem_info_t *info, size_t size);
 
 #define	zbx_shmem_malloc(info, old, size) __zbx_shmem_malloc(__FILE__, __LINE__, info, old, size)
 #define	zbx_shmem_realloc(info, old, size) __zbx_shmem_realloc(__FILE__, __LINE__, info, old, size)
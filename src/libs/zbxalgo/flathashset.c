@@ -0,0 +1,466 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxalgo.h"
+
+/*
+ * Open addressing hashset with inline elements.
+ *
+ * Every slot has a control byte - EMPTY, DELETED or the lower 7 bits of element hash when the
+ * slot is used. Slots are split into aligned groups of ZBX_FLATHASHSET_GROUP_SIZE slots and the
+ * upper hash bits select the first group to probe. Within group all control bytes are compared
+ * at once (with SSE2 where available), so the element compare function is called only for slots
+ * with matching hash bits. Groups are probed in triangular sequence until a group with an empty
+ * slot is found. The number of slots is a power of two, so the sequence visits every group.
+ */
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+#define FHS_CTRL_EMPTY		0x80
+#define FHS_CTRL_DELETED	0xfe
+
+#define FHS_H1(hash)		((hash) >> 7)
+#define FHS_H2(hash)		((unsigned char)((hash) & 0x7f))
+
+/* maximum load factor, including deleted slots */
+#define FHS_MAX_LOAD(slots)	((slots) / 8 * 7)
+
+#define FHS_ELEM_ALIGN		8
+
+#define FHS_SLOT_DATA(fhs, slot)	((fhs)->data + (size_t)(slot) * (fhs)->elem_size)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get bitmask of group control bytes equal to the specified value   *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned int	fhs_group_match(const unsigned char *group, unsigned char value)
+{
+#if defined(__SSE2__)
+	__m128i	ctrl = _mm_loadu_si128((const __m128i *)group);
+
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+	unsigned int	mask = 0;
+
+	for (int i = 0; i < ZBX_FLATHASHSET_GROUP_SIZE; i++)
+	{
+		if (group[i] == value)
+			mask |= 1u << i;
+	}
+
+	return mask;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get bitmask of empty or deleted group slots                       *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned int	fhs_group_match_free(const unsigned char *group)
+{
+#if defined(__SSE2__)
+	return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+	unsigned int	mask = 0;
+
+	for (int i = 0; i < ZBX_FLATHASHSET_GROUP_SIZE; i++)
+	{
+		if (0 != (group[i] & 0x80))
+			mask |= 1u << i;
+	}
+
+	return mask;
+#endif
+}
+
+static int	fhs_first_bit(unsigned int mask)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int	bit = 0;
+
+	while (0 == (mask & 1))
+	{
+		mask >>= 1;
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find slot of element matching the specified data                  *
+ *                                                                            *
+ * Return value: The slot index or -1 if element was not found.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	fhs_find(const zbx_flathashset_t *fhs, const void *data, zbx_hash_t hash)
+{
+	int		group_mask = fhs->num_slots / ZBX_FLATHASHSET_GROUP_SIZE - 1, group, step;
+	unsigned char	h2 = FHS_H2(hash);
+
+	group = (int)(FHS_H1(hash) & (zbx_hash_t)group_mask);
+
+	for (step = 1; step <= group_mask + 1; step++)
+	{
+		const unsigned char	*ctrl = fhs->ctrl + group * ZBX_FLATHASHSET_GROUP_SIZE;
+		unsigned int		match;
+
+		for (match = fhs_group_match(ctrl, h2); 0 != match; match &= match - 1)
+		{
+			int	slot = group * ZBX_FLATHASHSET_GROUP_SIZE + fhs_first_bit(match);
+
+			if (0 == fhs->compare_func(FHS_SLOT_DATA(fhs, slot), data))
+				return slot;
+		}
+
+		if (0 != fhs_group_match(ctrl, FHS_CTRL_EMPTY))
+			break;
+
+		group = (group + step) & group_mask;
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find first empty or deleted slot in element probe sequence        *
+ *                                                                            *
+ ******************************************************************************/
+static int	fhs_find_free(const unsigned char *ctrl, int num_slots, zbx_hash_t hash)
+{
+	int	group_mask = num_slots / ZBX_FLATHASHSET_GROUP_SIZE - 1, group, step;
+
+	group = (int)(FHS_H1(hash) & (zbx_hash_t)group_mask);
+
+	/* load factor is kept below 1, so there always is a free slot */
+	for (step = 1;; step++)
+	{
+		unsigned int	match;
+
+		if (0 != (match = fhs_group_match_free(ctrl + group * ZBX_FLATHASHSET_GROUP_SIZE)))
+			return group * ZBX_FLATHASHSET_GROUP_SIZE + fhs_first_bit(match);
+
+		group = (group + step) & group_mask;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get number of slots required to store the specified number of     *
+ *          elements                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	fhs_slots_required(size_t num_data)
+{
+	int	num_slots = ZBX_FLATHASHSET_GROUP_SIZE;
+
+	while ((size_t)FHS_MAX_LOAD(num_slots) < num_data + 1)
+		num_slots <<= 1;
+
+	return num_slots;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move elements into new slot array of the specified size          *
+ *                                                                            *
+ * Comments: The element data and control bytes are stored in single memory   *
+ *           block, so shared memory allocators can be used.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	fhs_rehash(zbx_flathashset_t *fhs, int num_slots)
+{
+	char		*data;
+	unsigned char	*ctrl;
+
+	if (NULL == (data = (char *)fhs->mem_malloc_func(NULL, (size_t)num_slots * (fhs->elem_size + 1))))
+		return FAIL;
+
+	ctrl = (unsigned char *)data + (size_t)num_slots * fhs->elem_size;
+	memset(ctrl, FHS_CTRL_EMPTY, (size_t)num_slots);
+
+	for (int i = 0; i < fhs->num_slots; i++)
+	{
+		zbx_hash_t	hash;
+		int		slot;
+
+		if (0 != (fhs->ctrl[i] & 0x80))
+			continue;
+
+		hash = fhs->hash_func(FHS_SLOT_DATA(fhs, i));
+		slot = fhs_find_free(ctrl, num_slots, hash);
+		ctrl[slot] = FHS_H2(hash);
+		memcpy(data + (size_t)slot * fhs->elem_size, FHS_SLOT_DATA(fhs, i), fhs->elem_size);
+	}
+
+	if (NULL != fhs->data)
+		fhs->mem_free_func(fhs->data);
+
+	fhs->data = data;
+	fhs->ctrl = ctrl;
+	fhs->num_slots = num_slots;
+	fhs->num_deleted = 0;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free element in the specified slot                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	fhs_erase(zbx_flathashset_t *fhs, int slot)
+{
+	if (NULL != fhs->clean_func)
+		fhs->clean_func(FHS_SLOT_DATA(fhs, slot));
+
+	/* Slot can be marked empty only if its group already had an empty slot - */
+	/* otherwise probe sequences of other elements might pass this group.     */
+	if (0 != fhs_group_match(fhs->ctrl + (slot & ~(ZBX_FLATHASHSET_GROUP_SIZE - 1)), FHS_CTRL_EMPTY))
+	{
+		fhs->ctrl[slot] = FHS_CTRL_EMPTY;
+	}
+	else
+	{
+		fhs->ctrl[slot] = FHS_CTRL_DELETED;
+		fhs->num_deleted++;
+	}
+
+	fhs->num_data--;
+}
+
+/* public flat hashset interface */
+
+void	zbx_flathashset_create(zbx_flathashset_t *fhs, size_t init_size, size_t elem_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func)
+{
+	zbx_flathashset_create_ext(fhs, init_size, elem_size, hash_func, compare_func, NULL,
+					ZBX_DEFAULT_MEM_MALLOC_FUNC,
+					ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	zbx_flathashset_create_ext(zbx_flathashset_t *fhs, size_t init_size, size_t elem_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_free_func_t mem_free_func)
+{
+	fhs->data = NULL;
+	fhs->ctrl = NULL;
+	fhs->num_slots = 0;
+	fhs->num_data = 0;
+	fhs->num_deleted = 0;
+	fhs->elem_size = (elem_size + FHS_ELEM_ALIGN - 1) & ~(size_t)(FHS_ELEM_ALIGN - 1);
+	fhs->hash_func = hash_func;
+	fhs->compare_func = compare_func;
+	fhs->clean_func = clean_func;
+	fhs->mem_malloc_func = mem_malloc_func;
+	fhs->mem_free_func = mem_free_func;
+
+	if (0 < init_size)
+		fhs_rehash(fhs, fhs_slots_required(init_size));
+}
+
+void	zbx_flathashset_destroy(zbx_flathashset_t *fhs)
+{
+	zbx_flathashset_clear(fhs);
+
+	if (NULL != fhs->data)
+	{
+		fhs->mem_free_func(fhs->data);
+		fhs->data = NULL;
+		fhs->ctrl = NULL;
+	}
+
+	fhs->num_slots = 0;
+	fhs->hash_func = NULL;
+	fhs->compare_func = NULL;
+	fhs->mem_malloc_func = NULL;
+	fhs->mem_free_func = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate slots for the required number of elements                *
+ *                                                                            *
+ * Parameters: fhs          - [IN] flat hashset                               *
+ *             num_data_req - [IN] number of elements to store                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_flathashset_reserve(zbx_flathashset_t *fhs, int num_data_req)
+{
+	int	num_slots;
+
+	if (num_data_req + fhs->num_deleted <= FHS_MAX_LOAD(fhs->num_slots) && 0 != fhs->num_slots)
+		return SUCCEED;
+
+	if ((num_slots = fhs_slots_required((size_t)num_data_req)) < fhs->num_slots)
+		num_slots = fhs->num_slots;
+
+	return fhs_rehash(fhs, num_slots);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: insert element into flat hashset                                  *
+ *                                                                            *
+ * Parameters: fhs  - [IN] flat hashset                                       *
+ *             data - [IN] element to insert                                  *
+ *             size - [IN] element size, must not exceed hashset element size *
+ *                                                                            *
+ * Return value: The inserted element or existing element with the same key.  *
+ *                                                                            *
+ * Comments: The insert can move elements, invalidating all pointers returned *
+ *           by previous insert, search and iterator calls.                   *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_flathashset_insert(zbx_flathashset_t *fhs, const void *data, size_t size)
+{
+	zbx_hash_t	hash;
+	int		slot;
+
+	if (size > fhs->elem_size)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return NULL;
+	}
+
+	hash = fhs->hash_func(data);
+
+	if (0 != fhs->num_slots && -1 != (slot = fhs_find(fhs, data, hash)))
+		return FHS_SLOT_DATA(fhs, slot);
+
+	if (fhs->num_data + fhs->num_deleted + 1 > FHS_MAX_LOAD(fhs->num_slots))
+	{
+		int	num_slots = fhs_slots_required((size_t)fhs->num_data + 1);
+
+		/* when most of the used slots are deleted - rehash in place */
+		if (num_slots < fhs->num_slots)
+			num_slots = fhs->num_slots;
+
+		if (SUCCEED != fhs_rehash(fhs, num_slots))
+			return NULL;
+	}
+
+	slot = fhs_find_free(fhs->ctrl, fhs->num_slots, hash);
+
+	if (FHS_CTRL_DELETED == fhs->ctrl[slot])
+		fhs->num_deleted--;
+
+	fhs->ctrl[slot] = FHS_H2(hash);
+	memcpy(FHS_SLOT_DATA(fhs, slot), data, size);
+	fhs->num_data++;
+
+	return FHS_SLOT_DATA(fhs, slot);
+}
+
+void	*zbx_flathashset_search(const zbx_flathashset_t *fhs, const void *data)
+{
+	int	slot;
+
+	if (0 == fhs->num_data)
+		return NULL;
+
+	if (-1 == (slot = fhs_find(fhs, data, fhs->hash_func(data))))
+		return NULL;
+
+	return FHS_SLOT_DATA(fhs, slot);
+}
+
+void	zbx_flathashset_remove(zbx_flathashset_t *fhs, const void *data)
+{
+	int	slot;
+
+	if (0 == fhs->num_data)
+		return;
+
+	if (-1 != (slot = fhs_find(fhs, data, fhs->hash_func(data))))
+		fhs_erase(fhs, slot);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove element using a data pointer returned by insert, search or *
+ *          iterator functions                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_flathashset_remove_direct(zbx_flathashset_t *fhs, void *data)
+{
+	fhs_erase(fhs, (int)(((char *)data - fhs->data) / (ptrdiff_t)fhs->elem_size));
+}
+
+void	zbx_flathashset_clear(zbx_flathashset_t *fhs)
+{
+	if (0 == fhs->num_slots)
+		return;
+
+	if (NULL != fhs->clean_func)
+	{
+		for (int i = 0; i < fhs->num_slots; i++)
+		{
+			if (0 == (fhs->ctrl[i] & 0x80))
+				fhs->clean_func(FHS_SLOT_DATA(fhs, i));
+		}
+	}
+
+	memset(fhs->ctrl, FHS_CTRL_EMPTY, (size_t)fhs->num_slots);
+	fhs->num_data = 0;
+	fhs->num_deleted = 0;
+}
+
+void	zbx_flathashset_iter_reset(zbx_flathashset_t *fhs, zbx_flathashset_iter_t *iter)
+{
+	iter->fhs = fhs;
+	iter->slot = -1;
+}
+
+void	*zbx_flathashset_iter_next(zbx_flathashset_iter_t *iter)
+{
+	const zbx_flathashset_t	*fhs = iter->fhs;
+
+	while (++iter->slot < fhs->num_slots)
+	{
+		if (0 == (fhs->ctrl[iter->slot] & 0x80))
+			return FHS_SLOT_DATA(fhs, iter->slot);
+	}
+
+	return NULL;
+}
+
+void	zbx_flathashset_iter_remove(zbx_flathashset_iter_t *iter)
+{
+	if (0 > iter->slot || iter->slot >= iter->fhs->num_slots || 0 != (iter->fhs->ctrl[iter->slot] & 0x80))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	fhs_erase(iter->fhs, iter->slot);
+}
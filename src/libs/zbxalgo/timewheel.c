@@ -0,0 +1,564 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxalgo.h"
+
+#define TW_ROOT_MASK	(ZBX_TIMEWHEEL_ROOT_SIZE - 1)
+#define TW_LEVEL_MASK	(ZBX_TIMEWHEEL_LEVEL_SIZE - 1)
+
+/* ready elements have negative slot index, encoding their position in ready heap */
+#define TW_IS_READY(node)		(0 > (node)->slot)
+#define TW_READY_INDEX(node)		(-(node)->slot - 1)
+#define TW_SET_READY_INDEX(node, index)	(node)->slot = -(index) - 1
+
+#define ARRAY_GROWTH_FACTOR	3/2
+
+/* maximum expiration offset from wheel time that can be scheduled without clamping */
+#define TW_SPAN_MAX	(1u << (ZBX_TIMEWHEEL_ROOT_BITS + (ZBX_TIMEWHEEL_LEVELS - 1) * ZBX_TIMEWHEEL_LEVEL_BITS))
+
+struct zbx_timewheel_node
+{
+	zbx_uint64_t		key;
+	void			*data;
+	zbx_timewheel_node_t	*prev;
+	zbx_timewheel_node_t	*next;
+	int			expire;
+	int			slot;
+};
+
+/* private timing wheel functions */
+
+static int	tw_level_shift(int level)
+{
+	return ZBX_TIMEWHEEL_ROOT_BITS + (level - 1) * ZBX_TIMEWHEEL_LEVEL_BITS;
+}
+
+static int	tw_level_offset(int level)
+{
+	return ZBX_TIMEWHEEL_ROOT_SIZE + (level - 1) * ZBX_TIMEWHEEL_LEVEL_SIZE;
+}
+
+static int	tw_slot_level(int slot)
+{
+	if (ZBX_TIMEWHEEL_ROOT_SIZE > slot)
+		return 0;
+
+	return 1 + (slot - ZBX_TIMEWHEEL_ROOT_SIZE) / ZBX_TIMEWHEEL_LEVEL_SIZE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates wheel slot for the specified expiration time           *
+ *                                                                            *
+ * Parameters: tw     - [IN] the timing wheel                                 *
+ *             expire - [IN] the expiration time, must be after wheel time    *
+ *                                                                            *
+ * Comments: Expiration times further than the wheel can cover are placed in  *
+ *           the last slot covered by the top level. They will be rescheduled *
+ *           when that slot is cascaded.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	tw_get_slot(const zbx_timewheel_t *tw, int expire)
+{
+	unsigned int	diff, ts = (unsigned int)expire;
+	int		level, shift;
+
+	diff = ts - (unsigned int)tw->now;
+
+	if (ZBX_TIMEWHEEL_ROOT_SIZE > diff)
+		return (int)(ts & TW_ROOT_MASK);
+
+	if (TW_SPAN_MAX <= diff)
+		ts = (unsigned int)tw->now + TW_SPAN_MAX - 1;
+
+	for (level = 1; level < ZBX_TIMEWHEEL_LEVELS - 1; level++)
+	{
+		if ((1u << (tw_level_shift(level) + ZBX_TIMEWHEEL_LEVEL_BITS)) > diff)
+			break;
+	}
+
+	shift = tw_level_shift(level);
+
+	return tw_level_offset(level) + (int)((ts >> shift) & TW_LEVEL_MASK);
+}
+
+static void	tw_link(zbx_timewheel_t *tw, zbx_timewheel_node_t *node, int slot)
+{
+	node->slot = slot;
+	node->prev = NULL;
+
+	if (NULL != (node->next = tw->slots[slot]))
+		node->next->prev = node;
+
+	tw->slots[slot] = node;
+	tw->levels_num[tw_slot_level(slot)]++;
+}
+
+static void	tw_unlink(zbx_timewheel_t *tw, zbx_timewheel_node_t *node)
+{
+	if (NULL != node->prev)
+		node->prev->next = node->next;
+	else
+		tw->slots[node->slot] = node->next;
+
+	if (NULL != node->next)
+		node->next->prev = node->prev;
+
+	tw->levels_num[tw_slot_level(node->slot)]--;
+}
+
+/* ready heap functions */
+
+static int	tw_ready_compare(const zbx_timewheel_t *tw, const zbx_timewheel_node_t *node1,
+		const zbx_timewheel_node_t *node2)
+{
+	zbx_binary_heap_elem_t	elem1 = {node1->key, node1->data}, elem2 = {node2->key, node2->data};
+
+	return tw->compare_func(&elem1, &elem2);
+}
+
+static void	tw_ready_set(zbx_timewheel_t *tw, int index, zbx_timewheel_node_t *node)
+{
+	tw->ready[index] = node;
+	TW_SET_READY_INDEX(node, index);
+}
+
+static void	tw_ready_bubble_up(zbx_timewheel_t *tw, int index)
+{
+	zbx_timewheel_node_t	*node = tw->ready[index];
+
+	while (0 != index)
+	{
+		int	parent = (index - 1) / 2;
+
+		if (0 >= tw_ready_compare(tw, tw->ready[parent], node))
+			break;
+
+		tw_ready_set(tw, index, tw->ready[parent]);
+		index = parent;
+	}
+
+	tw_ready_set(tw, index, node);
+}
+
+static void	tw_ready_bubble_down(zbx_timewheel_t *tw, int index)
+{
+	zbx_timewheel_node_t	*node = tw->ready[index];
+
+	while (1)
+	{
+		int	child = 2 * index + 1;
+
+		if (child >= tw->ready_num)
+			break;
+
+		if (child + 1 < tw->ready_num && 0 > tw_ready_compare(tw, tw->ready[child + 1], tw->ready[child]))
+			child++;
+
+		if (0 <= tw_ready_compare(tw, tw->ready[child], node))
+			break;
+
+		tw_ready_set(tw, index, tw->ready[child]);
+		index = child;
+	}
+
+	tw_ready_set(tw, index, node);
+}
+
+static void	tw_ready_update(zbx_timewheel_t *tw, zbx_timewheel_node_t *node)
+{
+	int	index = TW_READY_INDEX(node);
+
+	tw_ready_bubble_up(tw, index);
+
+	if (index == TW_READY_INDEX(node))
+		tw_ready_bubble_down(tw, index);
+}
+
+static void	tw_ready_insert(zbx_timewheel_t *tw, zbx_timewheel_node_t *node)
+{
+	if (tw->ready_num == tw->ready_alloc)
+	{
+		int	ready_alloc = (0 == tw->ready_alloc ? 32 : MAX(tw->ready_alloc + 1,
+				tw->ready_alloc * ARRAY_GROWTH_FACTOR));
+
+		/* set the allocated size only after successful allocation, see binary heap implementation */
+		tw->ready = (zbx_timewheel_node_t **)tw->mem_realloc_func(tw->ready, (size_t)ready_alloc *
+				sizeof(zbx_timewheel_node_t *));
+
+		if (NULL == tw->ready)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			exit(EXIT_FAILURE);
+		}
+
+		tw->ready_alloc = ready_alloc;
+	}
+
+	tw->ready[tw->ready_num] = node;
+	tw_ready_bubble_up(tw, tw->ready_num++);
+}
+
+static void	tw_ready_remove(zbx_timewheel_t *tw, zbx_timewheel_node_t *node)
+{
+	int	index = TW_READY_INDEX(node);
+
+	if (index == --tw->ready_num)
+		return;
+
+	tw_ready_set(tw, index, tw->ready[tw->ready_num]);
+	tw_ready_update(tw, tw->ready[index]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: schedules node either in wheel or in ready heap if it's expired   *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_schedule(zbx_timewheel_t *tw, zbx_timewheel_node_t *node)
+{
+	if (node->expire <= tw->now)
+		tw_ready_insert(tw, node);
+	else
+		tw_link(tw, node, tw_get_slot(tw, node->expire));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reschedules all nodes of the specified slot                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_cascade(zbx_timewheel_t *tw, int slot)
+{
+	zbx_timewheel_node_t	*node, *next;
+
+	node = tw->slots[slot];
+	tw->slots[slot] = NULL;
+
+	for (; NULL != node; node = next)
+	{
+		next = node->next;
+		tw->levels_num[tw_slot_level(slot)]--;
+		tw_schedule(tw, node);
+	}
+}
+
+static int	tw_scheduled_num(const zbx_timewheel_t *tw)
+{
+	int	i, num = 0;
+
+	for (i = 0; i < ZBX_TIMEWHEEL_LEVELS; i++)
+		num += tw->levels_num[i];
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advances wheel time to the next second that can have expired     *
+ *          elements                                                          *
+ *                                                                            *
+ * Comments: Empty lower levels are skipped by jumping straight to the next   *
+ *           slot boundary of the lowest non-empty level, so advancing over   *
+ *           long idle periods takes a few steps.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_advance(zbx_timewheel_t *tw)
+{
+	unsigned int	now = (unsigned int)tw->now;
+	int		level;
+
+	for (level = 0; level < ZBX_TIMEWHEEL_LEVELS - 1 && 0 == tw->levels_num[level]; level++)
+		;
+
+	if (0 != level)
+	{
+		int	shift = tw_level_shift(level);
+
+		now = (((now >> shift) + 1) << shift) - 1;
+	}
+
+	tw->now = (int)++now;
+
+	if (0 == (now & TW_ROOT_MASK))
+	{
+		for (level = 1; level < ZBX_TIMEWHEEL_LEVELS; level++)
+		{
+			int	index = (int)((now >> tw_level_shift(level)) & TW_LEVEL_MASK);
+
+			tw_cascade(tw, tw_level_offset(level) + index);
+
+			if (0 != index)
+				break;
+		}
+	}
+
+	tw_cascade(tw, (int)(now & TW_ROOT_MASK));
+}
+
+static zbx_timewheel_node_t	*tw_get_node(zbx_timewheel_t *tw, zbx_uint64_t key, const char *operation)
+{
+	zbx_timewheel_node_t	*node;
+
+	if (NULL == (node = (zbx_timewheel_node_t *)zbx_hashset_search(&tw->nodes, &key)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "element with key " ZBX_FS_UI64 " not found in timing wheel for %s", key,
+				operation);
+		exit(EXIT_FAILURE);
+	}
+
+	return node;
+}
+
+/* public timing wheel interface */
+
+void	zbx_timewheel_create(zbx_timewheel_t *tw, zbx_compare_func_t compare_func)
+{
+	zbx_timewheel_create_ext(tw, compare_func, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	zbx_timewheel_create_ext(zbx_timewheel_t *tw, zbx_compare_func_t compare_func,
+		zbx_mem_malloc_func_t mem_malloc_func, zbx_mem_realloc_func_t mem_realloc_func,
+		zbx_mem_free_func_t mem_free_func)
+{
+	memset(tw->slots, 0, sizeof(tw->slots));
+	memset(tw->levels_num, 0, sizeof(tw->levels_num));
+	tw->now = 0;
+
+	zbx_hashset_create_ext(&tw->nodes, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			mem_malloc_func, mem_realloc_func, mem_free_func);
+
+	tw->ready = NULL;
+	tw->ready_num = 0;
+	tw->ready_alloc = 0;
+	tw->compare_func = compare_func;
+
+	tw->mem_malloc_func = mem_malloc_func;
+	tw->mem_realloc_func = mem_realloc_func;
+	tw->mem_free_func = mem_free_func;
+}
+
+void	zbx_timewheel_destroy(zbx_timewheel_t *tw)
+{
+	if (NULL != tw->ready)
+	{
+		tw->mem_free_func(tw->ready);
+		tw->ready = NULL;
+		tw->ready_num = 0;
+		tw->ready_alloc = 0;
+	}
+
+	zbx_hashset_destroy(&tw->nodes);
+	memset(tw->slots, 0, sizeof(tw->slots));
+	memset(tw->levels_num, 0, sizeof(tw->levels_num));
+}
+
+int	zbx_timewheel_empty(const zbx_timewheel_t *tw)
+{
+	return (0 == tw->nodes.num_data ? SUCCEED : FAIL);
+}
+
+int	zbx_timewheel_size(const zbx_timewheel_t *tw)
+{
+	return tw->nodes.num_data;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the element with the earliest expiration time             *
+ *                                                                            *
+ * Comments: Advances wheel time up to the earliest expiration time if there  *
+ *           are no expired elements, so elements inserted later with earlier *
+ *           expiration time go directly to the ready heap.                   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_binary_heap_elem_t	*zbx_timewheel_find_min(zbx_timewheel_t *tw)
+{
+	while (0 == tw->ready_num)
+	{
+		if (0 == tw_scheduled_num(tw))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "asking for a minimum in an empty timing wheel");
+			exit(EXIT_FAILURE);
+		}
+
+		tw_advance(tw);
+	}
+
+	tw->min.key = tw->ready[0]->key;
+	tw->min.data = tw->ready[0]->data;
+
+	return &tw->min;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the earliest expiration time without advancing the wheel  *
+ *                                                                            *
+ * Return value: The earliest expiration time if there are expired elements   *
+ *               or the earliest element is in root level. Otherwise the      *
+ *               start of the earliest upper level slot, which is never later *
+ *               than the earliest expiration time.                           *
+ *               FAIL if the timing wheel is empty.                           *
+ *                                                                            *
+ * Comments: This function does not modify the timing wheel, so it can be     *
+ *           used with read lock.                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_timewheel_next_expire(const zbx_timewheel_t *tw)
+{
+	const zbx_timewheel_node_t	*node;
+	unsigned int			now = (unsigned int)tw->now, expire = 0;
+	int				i, level, found = 0;
+
+	if (0 != tw->ready_num)
+		return tw->ready[0]->expire;
+
+	if (0 == tw_scheduled_num(tw))
+		return FAIL;
+
+	if (0 != tw->levels_num[0])
+	{
+		for (i = 1; i < ZBX_TIMEWHEEL_ROOT_SIZE; i++)
+		{
+			if (NULL != (node = tw->slots[(now + (unsigned int)i) & TW_ROOT_MASK]))
+			{
+				expire = (unsigned int)node->expire;
+				found = 1;
+				break;
+			}
+		}
+	}
+
+	for (level = 1; level < ZBX_TIMEWHEEL_LEVELS; level++)
+	{
+		int		shift;
+		unsigned int	block;
+
+		if (0 == tw->levels_num[level])
+			continue;
+
+		shift = tw_level_shift(level);
+
+		for (i = 1; i <= ZBX_TIMEWHEEL_LEVEL_SIZE; i++)
+		{
+			block = (now >> shift) + (unsigned int)i;
+
+			if (NULL == tw->slots[tw_level_offset(level) + (int)(block & TW_LEVEL_MASK)])
+				continue;
+
+			if (0 == found || (block << shift) - now < expire - now)
+			{
+				expire = block << shift;
+				found = 1;
+			}
+
+			break;
+		}
+	}
+
+	return (int)expire;
+}
+
+void	zbx_timewheel_insert(zbx_timewheel_t *tw, zbx_binary_heap_elem_t *elem, int expire)
+{
+	zbx_timewheel_node_t	*node, node_local;
+	int			num_data = tw->nodes.num_data;
+
+	node_local.key = elem->key;
+	node_local.data = elem->data;
+	node_local.expire = expire;
+
+	node = (zbx_timewheel_node_t *)zbx_hashset_insert(&tw->nodes, &node_local, sizeof(node_local));
+
+	if (num_data == tw->nodes.num_data)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "inserting a duplicate key into a timing wheel");
+		exit(EXIT_FAILURE);
+	}
+
+	/* wheel time can be moved forward without ticking when there is nothing to cascade */
+	if (0 == tw_scheduled_num(tw) && expire - 1 > tw->now)
+		tw->now = expire - 1;
+
+	tw_schedule(tw, node);
+}
+
+void	zbx_timewheel_update_direct(zbx_timewheel_t *tw, zbx_binary_heap_elem_t *elem, int expire)
+{
+	zbx_timewheel_node_t	*node;
+
+	node = tw_get_node(tw, elem->key, "update");
+	node->data = elem->data;
+
+	if (TW_IS_READY(node))
+	{
+		node->expire = expire;
+
+		if (expire <= tw->now)
+		{
+			tw_ready_update(tw, node);
+			return;
+		}
+
+		tw_ready_remove(tw, node);
+	}
+	else
+	{
+		tw_unlink(tw, node);
+		node->expire = expire;
+	}
+
+	tw_schedule(tw, node);
+}
+
+void	zbx_timewheel_remove_min(zbx_timewheel_t *tw)
+{
+	zbx_timewheel_node_t	*node;
+
+	zbx_timewheel_find_min(tw);
+
+	node = tw->ready[0];
+	tw_ready_remove(tw, node);
+	zbx_hashset_remove_direct(&tw->nodes, node);
+}
+
+void	zbx_timewheel_remove_direct(zbx_timewheel_t *tw, zbx_uint64_t key)
+{
+	zbx_timewheel_node_t	*node;
+
+	node = tw_get_node(tw, key, "remove");
+
+	if (TW_IS_READY(node))
+		tw_ready_remove(tw, node);
+	else
+		tw_unlink(tw, node);
+
+	zbx_hashset_remove_direct(&tw->nodes, node);
+}
+
+void	zbx_timewheel_clear(zbx_timewheel_t *tw)
+{
+	memset(tw->slots, 0, sizeof(tw->slots));
+	memset(tw->levels_num, 0, sizeof(tw->levels_num));
+
+	tw->ready_num = 0;
+	zbx_hashset_clear(&tw->nodes);
+}
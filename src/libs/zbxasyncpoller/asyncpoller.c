@@ -18,6 +18,7 @@
 **/
 
 #include "zbxasyncpoller.h"
+#include "asyncuring.h"
 #include "zbxcommon.h"
 #include "zbxcomms.h"
 
@@ -36,6 +37,8 @@ typedef struct
 	char				ip[65];
 	int				timeout;
 	char				*error;
+	int				uring;		/* socket readiness is polled through io_uring */
+	zbx_uint64_t			pollid;		/* pending io_uring poll request */
 }
 zbx_async_task_t;
 
@@ -70,6 +73,16 @@ static const char	*task_state_to_str(zbx_async_task_state_t task_state)
 	}
 }
 
+static void	async_uring_event(evutil_socket_t fd, short what, void *arg);
+
+static int	async_task_uring_poll(zbx_async_task_t *task, int fd, short what)
+{
+	if (0 == task->uring)
+		return FAIL;
+
+	return async_uring_poll_add(fd, what, async_uring_event, (void *)task, &task->pollid);
+}
+
 static void	async_event(evutil_socket_t fd, short what, void *arg)
 {
 	zbx_async_task_t	*task = (zbx_async_task_t *)arg;
@@ -78,6 +91,13 @@ static void	async_event(evutil_socket_t fd, short what, void *arg)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	/* the task was woken up by timeout while waiting for socket */
+	if (0 != task->pollid)
+	{
+		async_uring_poll_cancel(task->pollid);
+		task->pollid = 0;
+	}
+
 	ret = task->process_cb(what, task->data, &fd, task->ip, task->error);
 
 	switch (ret)
@@ -86,6 +106,9 @@ static void	async_event(evutil_socket_t fd, short what, void *arg)
 			async_task_remove(task);
 			break;
 		case ZBX_ASYNC_TASK_READ:
+			if (SUCCEED == async_task_uring_poll(task, fd, EV_READ))
+				break;
+
 			if (fd_in != fd || NULL == task->rx_event)
 			{
 				ev = event_get_base(task->timeout_event);
@@ -98,6 +121,9 @@ static void	async_event(evutil_socket_t fd, short what, void *arg)
 			event_add(task->rx_event, NULL);
 			break;
 		case ZBX_ASYNC_TASK_WRITE:
+			if (SUCCEED == async_task_uring_poll(task, fd, EV_WRITE))
+				break;
+
 			if (fd_in != fd || NULL == task->tx_event)
 			{
 				ev = event_get_base(task->timeout_event);
@@ -115,6 +141,14 @@ static void	async_event(evutil_socket_t fd, short what, void *arg)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, task_state_to_str(ret));
 }
 
+static void	async_uring_event(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_async_task_t	*task = (zbx_async_task_t *)arg;
+
+	task->pollid = 0;
+	async_event(fd, what, arg);
+}
+
 static void	async_dns_event(int err, struct evutil_addrinfo *ai, void *arg)
 {
 	zbx_async_task_t	*task = (zbx_async_task_t *)arg;
@@ -160,6 +194,8 @@ void	zbx_async_poller_add_task(struct event_base *ev, struct evdns_base *dnsbase
 	task->rx_event = NULL;
 	task->tx_event = NULL;
 	task->error = NULL;
+	task->uring = (SUCCEED == async_uring_attached(ev) ? 1 : 0);
+	task->pollid = 0;
 
 	memset(&hints, 0, sizeof(hints));
 
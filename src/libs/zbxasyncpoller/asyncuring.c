@@ -0,0 +1,580 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "asyncuring.h"
+#include "zbxcommon.h"
+
+#ifdef HAVE_LIBEVENT
+
+#ifdef HAVE_IO_URING
+#include "zbxalgo.h"
+
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+
+/*
+ * Socket readiness of asynchronous tasks is polled through io_uring instead of libevent.
+ *
+ * One-shot poll requests are queued in the submission ring and submitted with a single io_uring_enter() call at
+ * the end of event loop pass, so checks started or continued during the pass share one system call instead of one
+ * epoll_ctl() call per socket operation. The io_uring file descriptor is watched by the libevent loop while there
+ * are pending poll requests; completions are reaped from the shared ring without system calls. Timers and DNS
+ * resolution are left to libevent.
+ */
+
+#define ASYNC_URING_SQ_ENTRIES	256
+#define ASYNC_URING_CQ_ENTRIES	4096
+
+typedef struct
+{
+	zbx_uint64_t		id;
+	int			fd;
+	short			what;
+	event_callback_fn	cb;
+	void			*arg;
+}
+zbx_async_uring_poll_t;
+
+typedef struct
+{
+	int			fd;
+	struct event_base	*base;
+
+	/* completion ring readiness, added while there are pending poll requests */
+	struct event		*ring_event;
+	int			ring_event_added;
+
+	/* submits queued requests at the end of event loop pass */
+	struct event		*flush_event;
+	int			flush_scheduled;
+
+	void			*sq_ptr;
+	size_t			sq_size;
+	unsigned int		*sq_head;
+	unsigned int		*sq_tail;
+	unsigned int		*sq_mask;
+	unsigned int		*sq_flags;
+	unsigned int		*sq_array;
+	unsigned int		sq_entries;
+	unsigned int		sq_unsubmitted;
+	struct io_uring_sqe	*sqes;
+	size_t			sqes_size;
+
+	void			*cq_ptr;
+	size_t			cq_size;
+	unsigned int		*cq_head;
+	unsigned int		*cq_tail;
+	unsigned int		*cq_mask;
+	struct io_uring_cqe	*cqes;
+
+	/* pending poll requests, completions of removed requests are ignored */
+	zbx_hashset_t		polls;
+	zbx_uint64_t		last_pollid;
+
+	zbx_async_uring_stats_t	stats;
+}
+zbx_async_uring_t;
+
+static zbx_async_uring_t	*async_uring = NULL;
+
+static int	async_uring_setup(unsigned int entries, struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int	async_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: submits queued requests to kernel                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_uring_submit(zbx_async_uring_t *uring)
+{
+	while (0 != uring->sq_unsubmitted)
+	{
+		int	ret;
+
+		uring->stats.enters++;
+
+		if (0 >= (ret = async_uring_enter(uring->fd, uring->sq_unsubmitted, 0, 0)))
+		{
+			if (0 > ret && EINTR == errno)
+				continue;
+
+			/* EBUSY and EAGAIN are retried after reaping completions */
+			if (0 > ret && EBUSY != errno && EAGAIN != errno)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot submit io_uring requests: %s",
+						zbx_strerror(errno));
+			}
+
+			return FAIL;
+		}
+
+		uring->sq_unsubmitted -= (unsigned int)ret;
+		uring->stats.submitted += (zbx_uint64_t)ret;
+	}
+
+	return SUCCEED;
+}
+
+static void	async_uring_flush_event(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_async_uring_t	*uring = (zbx_async_uring_t *)arg;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	uring->flush_scheduled = 0;
+	async_uring_submit(uring);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets free submission queue entry                                  *
+ *                                                                            *
+ * Return value: submission queue entry or NULL if submission queue is full   *
+ *                                                                            *
+ ******************************************************************************/
+static struct io_uring_sqe	*async_uring_get_sqe(zbx_async_uring_t *uring)
+{
+	unsigned int		tail = *uring->sq_tail, index;
+	struct io_uring_sqe	*sqe;
+
+	if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) == uring->sq_entries)
+	{
+		async_uring_submit(uring);
+
+		if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) == uring->sq_entries)
+			return NULL;
+	}
+
+	index = tail & *uring->sq_mask;
+	sqe = &uring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	uring->sq_array[index] = index;
+
+	return sqe;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues prepared submission queue entry and schedules submission   *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_uring_push_sqe(zbx_async_uring_t *uring)
+{
+	__atomic_store_n(uring->sq_tail, *uring->sq_tail + 1, __ATOMIC_RELEASE);
+	uring->sq_unsubmitted++;
+
+	if (0 == uring->flush_scheduled)
+	{
+		event_active(uring->flush_event, 0, 0);
+		uring->flush_scheduled = 1;
+	}
+}
+
+static void	async_uring_update_ring_event(zbx_async_uring_t *uring)
+{
+	if (0 == uring->polls.num_data)
+	{
+		if (0 != uring->ring_event_added)
+		{
+			event_del(uring->ring_event);
+			uring->ring_event_added = 0;
+		}
+	}
+	else if (0 == uring->ring_event_added)
+	{
+		event_add(uring->ring_event, NULL);
+		uring->ring_event_added = 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reaps completions and calls callbacks of completed poll requests  *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_uring_reap(zbx_async_uring_t *uring)
+{
+	unsigned int	head = *uring->cq_head;
+
+	while (1)
+	{
+		while (head != __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE))
+		{
+			zbx_uint64_t		id;
+			zbx_async_uring_poll_t	*poll, poll_local;
+
+			id = uring->cqes[head & *uring->cq_mask].user_data;
+			__atomic_store_n(uring->cq_head, ++head, __ATOMIC_RELEASE);
+			uring->stats.completed++;
+
+			/* poll removal requests and removed poll requests are not tracked */
+			if (NULL == (poll = (zbx_async_uring_poll_t *)zbx_hashset_search(&uring->polls, &id)))
+				continue;
+
+			poll_local = *poll;
+			zbx_hashset_remove_direct(&uring->polls, poll);
+
+			/* callback can queue new requests and remove pending ones */
+			poll_local.cb(poll_local.fd, poll_local.what, poll_local.arg);
+		}
+#ifdef IORING_SQ_CQ_OVERFLOW
+		/* flush completions the kernel kept aside while completion ring was full */
+		if (0 != (__atomic_load_n(uring->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW))
+		{
+			uring->stats.enters++;
+
+			if (0 <= async_uring_enter(uring->fd, 0, 0, IORING_ENTER_GETEVENTS))
+				continue;
+		}
+#endif
+		break;
+	}
+
+	async_uring_update_ring_event(uring);
+}
+
+static void	async_uring_ring_event(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_async_uring_t	*uring = (zbx_async_uring_t *)arg;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	async_uring_reap(uring);
+
+	/* retry submission rejected while completion ring was full */
+	if (0 != uring->sq_unsubmitted && 0 == uring->flush_scheduled)
+		async_uring_submit(uring);
+}
+
+static void	async_uring_free(zbx_async_uring_t *uring)
+{
+	if (NULL != uring->ring_event)
+		event_free(uring->ring_event);
+
+	if (NULL != uring->flush_event)
+		event_free(uring->flush_event);
+
+	if (NULL != uring->sqes)
+		munmap(uring->sqes, uring->sqes_size);
+
+	if (NULL != uring->cq_ptr && uring->cq_ptr != uring->sq_ptr)
+		munmap(uring->cq_ptr, uring->cq_size);
+
+	if (NULL != uring->sq_ptr)
+		munmap(uring->sq_ptr, uring->sq_size);
+
+	/* closing io_uring file descriptor cancels pending requests */
+	if (-1 != uring->fd)
+		close(uring->fd);
+
+	zbx_hashset_destroy(&uring->polls);
+	zbx_free(uring);
+}
+
+static void	*async_uring_mmap(int fd, size_t size, off_t offset)
+{
+	void	*ptr;
+
+	if (MAP_FAILED == (ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset)))
+		return NULL;
+
+	return ptr;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates io_uring instance and attaches it to event base           *
+ *                                                                            *
+ * Parameters: ev    - [IN] event base of the asynchronous tasks              *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - io_uring is used for socket readiness of tasks     *
+ *                         added to the event base                            *
+ *               FAIL    - io_uring is not supported, libevent is used        *
+ *                                                                            *
+ * Comments: One io_uring instance per process is supported.                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_async_poller_uring_init(struct event_base *ev, char **error)
+{
+	zbx_async_uring_t	*uring;
+	struct io_uring_params	params;
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != async_uring)
+	{
+		*error = zbx_strdup(NULL, "io_uring is already initialized");
+		goto out;
+	}
+
+	uring = (zbx_async_uring_t *)zbx_malloc(NULL, sizeof(zbx_async_uring_t));
+	memset(uring, 0, sizeof(zbx_async_uring_t));
+	zbx_hashset_create(&uring->polls, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	uring->base = ev;
+
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = ASYNC_URING_CQ_ENTRIES;
+
+	if (-1 == (uring->fd = async_uring_setup(ASYNC_URING_SQ_ENTRIES, &params)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot create io_uring instance: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	/* without NODROP completions of pending requests can be lost when completion ring is full */
+	if (0 == (params.features & IORING_FEAT_NODROP))
+	{
+		*error = zbx_strdup(NULL, "kernel does not support io_uring completion overflow handling");
+		goto fail;
+	}
+
+	uring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	uring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (0 != (params.features & IORING_FEAT_SINGLE_MMAP))
+		uring->sq_size = uring->cq_size = MAX(uring->sq_size, uring->cq_size);
+
+	if (NULL == (uring->sq_ptr = async_uring_mmap(uring->fd, uring->sq_size, IORING_OFF_SQ_RING)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot map io_uring submission ring: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (0 != (params.features & IORING_FEAT_SINGLE_MMAP))
+	{
+		uring->cq_ptr = uring->sq_ptr;
+	}
+	else if (NULL == (uring->cq_ptr = async_uring_mmap(uring->fd, uring->cq_size, IORING_OFF_CQ_RING)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot map io_uring completion ring: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	if (NULL == (uring->sqes = (struct io_uring_sqe *)async_uring_mmap(uring->fd, uring->sqes_size,
+			IORING_OFF_SQES)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot map io_uring submission entries: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	uring->sq_head = (unsigned int *)((char *)uring->sq_ptr + params.sq_off.head);
+	uring->sq_tail = (unsigned int *)((char *)uring->sq_ptr + params.sq_off.tail);
+	uring->sq_mask = (unsigned int *)((char *)uring->sq_ptr + params.sq_off.ring_mask);
+	uring->sq_flags = (unsigned int *)((char *)uring->sq_ptr + params.sq_off.flags);
+	uring->sq_array = (unsigned int *)((char *)uring->sq_ptr + params.sq_off.array);
+	uring->sq_entries = params.sq_entries;
+
+	uring->cq_head = (unsigned int *)((char *)uring->cq_ptr + params.cq_off.head);
+	uring->cq_tail = (unsigned int *)((char *)uring->cq_ptr + params.cq_off.tail);
+	uring->cq_mask = (unsigned int *)((char *)uring->cq_ptr + params.cq_off.ring_mask);
+	uring->cqes = (struct io_uring_cqe *)((char *)uring->cq_ptr + params.cq_off.cqes);
+
+	if (NULL == (uring->ring_event = event_new(ev, uring->fd, EV_READ | EV_PERSIST, async_uring_ring_event,
+			uring)) || NULL == (uring->flush_event = event_new(ev, -1, 0, async_uring_flush_event, uring)))
+	{
+		*error = zbx_strdup(NULL, "cannot create io_uring events");
+		goto fail;
+	}
+
+	async_uring = uring;
+	ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "io_uring submission entries:%u completion entries:%u features:0x%x",
+			params.sq_entries, params.cq_entries, params.features);
+	goto out;
+fail:
+	async_uring_free(uring);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+void	zbx_async_poller_uring_destroy(void)
+{
+	if (NULL == async_uring)
+		return;
+
+	async_uring_free(async_uring);
+	async_uring = NULL;
+}
+
+int	zbx_async_poller_uring_get_stats(zbx_async_uring_stats_t *stats)
+{
+	if (NULL == async_uring)
+		return FAIL;
+
+	*stats = async_uring->stats;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if socket readiness of tasks added to the event base is    *
+ *          polled through io_uring                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	async_uring_attached(struct event_base *ev)
+{
+	if (NULL == async_uring || ev != async_uring->base)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues one-shot socket readiness poll request                     *
+ *                                                                            *
+ * Parameters: fd   - [IN] socket                                             *
+ *             what - [IN] EV_READ or EV_WRITE                                *
+ *             cb   - [IN] callback to call when socket is ready              *
+ *             arg  - [IN] callback argument                                  *
+ *             id   - [OUT] poll request identifier                           *
+ *                                                                            *
+ * Return value: SUCCEED - poll request was queued                            *
+ *               FAIL    - submission queue is full                           *
+ *                                                                            *
+ ******************************************************************************/
+int	async_uring_poll_add(int fd, short what, event_callback_fn cb, void *arg, zbx_uint64_t *id)
+{
+	zbx_async_uring_t	*uring = async_uring;
+	zbx_async_uring_poll_t	poll_local;
+	struct io_uring_sqe	*sqe;
+
+	if (NULL == uring || NULL == (sqe = async_uring_get_sqe(uring)))
+		return FAIL;
+
+	poll_local.id = ++uring->last_pollid;
+	poll_local.fd = fd;
+	poll_local.what = what;
+	poll_local.cb = cb;
+	poll_local.arg = arg;
+	zbx_hashset_insert(&uring->polls, &poll_local, sizeof(poll_local));
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll_events = (0 != (what & EV_READ) ? POLLIN : POLLOUT);
+	sqe->user_data = poll_local.id;
+
+	async_uring_push_sqe(uring);
+	async_uring_update_ring_event(uring);
+
+	*id = poll_local.id;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes pending poll request                                      *
+ *                                                                            *
+ * Comments: Poll request keeps reference to the socket, so it must be        *
+ *           removed from kernel even if the socket is already closed.        *
+ *                                                                            *
+ ******************************************************************************/
+void	async_uring_poll_cancel(zbx_uint64_t id)
+{
+	zbx_async_uring_t	*uring = async_uring;
+	zbx_async_uring_poll_t	*poll;
+	struct io_uring_sqe	*sqe;
+
+	if (NULL == uring || NULL == (poll = (zbx_async_uring_poll_t *)zbx_hashset_search(&uring->polls, &id)))
+		return;
+
+	zbx_hashset_remove_direct(&uring->polls, poll);
+
+	if (NULL == (sqe = async_uring_get_sqe(uring)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot remove io_uring poll request " ZBX_FS_UI64 ": submission queue is"
+				" full", id);
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = id;
+		sqe->user_data = 0;
+
+		async_uring_push_sqe(uring);
+	}
+
+	async_uring_update_ring_event(uring);
+}
+#else
+int	zbx_async_poller_uring_init(struct event_base *ev, char **error)
+{
+	ZBX_UNUSED(ev);
+
+	*error = zbx_strdup(NULL, "support for io_uring was not compiled in");
+
+	return FAIL;
+}
+
+void	zbx_async_poller_uring_destroy(void)
+{
+}
+
+int	zbx_async_poller_uring_get_stats(zbx_async_uring_stats_t *stats)
+{
+	ZBX_UNUSED(stats);
+
+	return FAIL;
+}
+
+int	async_uring_attached(struct event_base *ev)
+{
+	ZBX_UNUSED(ev);
+
+	return FAIL;
+}
+
+int	async_uring_poll_add(int fd, short what, event_callback_fn cb, void *arg, zbx_uint64_t *id)
+{
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(cb);
+	ZBX_UNUSED(arg);
+	ZBX_UNUSED(id);
+
+	return FAIL;
+}
+
+void	async_uring_poll_cancel(zbx_uint64_t id)
+{
+	ZBX_UNUSED(id);
+}
+#endif
+#endif
@@ -54,8 +54,27 @@
 
 int	sync_in_progress = 0;
 
-#define START_SYNC	do { WRLOCK_CACHE_CONFIG_HISTORY; WRLOCK_CACHE; sync_in_progress = 1; } while(0)
-#define FINISH_SYNC	do { sync_in_progress = 0; UNLOCK_CACHE; UNLOCK_CACHE_CONFIG_HISTORY; } while(0)
+/* configuration sync write lock hold time accounting */
+static double	sync_lock_ts, sync_lock_sec, sync_lock_max_sec;
+static int	sync_lock_num;
+
+static void	dc_sync_lock_account(void)
+{
+	double	sec;
+
+	sec = zbx_time() - sync_lock_ts;
+	sync_lock_sec += sec;
+
+	if (sec > sync_lock_max_sec)
+		sync_lock_max_sec = sec;
+
+	sync_lock_num++;
+}
+
+#define START_SYNC	do { WRLOCK_CACHE_CONFIG_HISTORY; WRLOCK_CACHE; sync_in_progress = 1;			\
+				sync_lock_ts = zbx_time(); } while(0)
+#define FINISH_SYNC	do { dc_sync_lock_account(); sync_in_progress = 0; UNLOCK_CACHE;			\
+				UNLOCK_CACHE_CONFIG_HISTORY; } while(0)
 
 #define ZBX_SNMP_OID_TYPE_NORMAL	0
 #define ZBX_SNMP_OID_TYPE_DYNAMIC	1
@@ -481,21 +500,30 @@ static char	*dc_expand_user_macros_dyn(const char *text, const zbx_uint64_t *hos
 	return str;
 }
 
-int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface, int flags, int now,
-		char **error)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate item nextcheck without modifying the item               *
+ *                                                                            *
+ * Parameters: item      - [IN]                                               *
+ *             interface - [IN] item interface (optional)                     *
+ *             flags     - [IN] ZBX_ITEM_NEW, ZBX_HOST_UNREACHABLE flags      *
+ *             now       - [IN] the time nextcheck is calculated from         *
+ *             nextcheck - [OUT]                                              *
+ *             error     - [OUT] the error message (optional)                 *
+ *                                                                            *
+ * Return value: SUCCEED - nextcheck was calculated                           *
+ *               FAIL    - item has invalid update interval, nextcheck is set *
+ *                         to ZBX_JAN_2038                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_item_nextcheck_calculate(const ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface, int flags,
+		int now, int *nextcheck, char **error)
 {
 	zbx_uint64_t		seed;
 	int			simple_interval, disable_until, ret;
 	zbx_custom_interval_t	*custom_intervals;
 	char			*delay_s;
 
-	if (0 == (flags & ZBX_ITEM_COLLECTED) && 0 != item->nextcheck &&
-			0 == (flags & ZBX_ITEM_KEY_CHANGED) && 0 == (flags & ZBX_ITEM_TYPE_CHANGED) &&
-			0 == (flags & ZBX_ITEM_DELAY_CHANGED))
-	{
-		return SUCCEED;	/* avoid unnecessary nextcheck updates when syncing items in cache */
-	}
-
 	seed = get_item_nextcheck_seed(item->itemid, item->interfaceid, item->type, item->key);
 
 	delay_s = dc_expand_user_macros_dyn(item->delay, &item->hostid, 1, ZBX_MACRO_ENV_NONSECURE);
@@ -509,15 +537,15 @@ int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface
 		/* and such changes will be detected during configuration synchronization. DCsync_items()  */
 		/* detects item configuration changes affecting check scheduling and passes them in flags. */
 
-		item->nextcheck = ZBX_JAN_2038;
+		*nextcheck = ZBX_JAN_2038;
 		return FAIL;
 	}
 
 	if (0 != (flags & ZBX_HOST_UNREACHABLE) && NULL != interface && 0 != (disable_until =
 			DCget_disable_until(item, interface)))
 	{
-		item->nextcheck = zbx_calculate_item_nextcheck_unreachable(simple_interval,
-				custom_intervals, disable_until);
+		*nextcheck = zbx_calculate_item_nextcheck_unreachable(simple_interval, custom_intervals,
+				disable_until);
 	}
 	else
 	{
@@ -526,15 +554,15 @@ int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface
 				ITEM_TYPE_ZABBIX_ACTIVE != item->type &&
 				ZBX_DEFAULT_ITEM_UPDATE_INTERVAL < simple_interval)
 		{
-			item->nextcheck = zbx_calculate_item_nextcheck(seed, item->type,
-					ZBX_DEFAULT_ITEM_UPDATE_INTERVAL, NULL, now);
+			*nextcheck = zbx_calculate_item_nextcheck(seed, item->type, ZBX_DEFAULT_ITEM_UPDATE_INTERVAL,
+					NULL, now);
 		}
 		else
 		{
 			/* supported items and items that could not have been scheduled previously, but had */
 			/* their update interval fixed, should be scheduled using their update intervals */
-			item->nextcheck = zbx_calculate_item_nextcheck(seed, item->type, simple_interval,
-					custom_intervals, now);
+			*nextcheck = zbx_calculate_item_nextcheck(seed, item->type, simple_interval, custom_intervals,
+					now);
 		}
 	}
 
@@ -543,6 +571,19 @@ int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface
 	return SUCCEED;
 }
 
+int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface, int flags, int now,
+		char **error)
+{
+	if (0 == (flags & ZBX_ITEM_COLLECTED) && 0 != item->nextcheck &&
+			0 == (flags & ZBX_ITEM_KEY_CHANGED) && 0 == (flags & ZBX_ITEM_TYPE_CHANGED) &&
+			0 == (flags & ZBX_ITEM_DELAY_CHANGED))
+	{
+		return SUCCEED;	/* avoid unnecessary nextcheck updates when syncing items in cache */
+	}
+
+	return dc_item_nextcheck_calculate(item, interface, flags, now, &item->nextcheck, error);
+}
+
 static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *dc_host, int flags)
 {
 	unsigned char	poller_type;
@@ -767,7 +808,7 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE == item->location && old_poller_type != item->poller_type)
 	{
 		item->location = ZBX_LOC_NOWHERE;
-		zbx_binary_heap_remove_direct(&config->queues[old_poller_type], item->itemid);
+		zbx_timewheel_remove_direct(&config->queues[old_poller_type], item->itemid);
 	}
 
 	if (item->poller_type == ZBX_NO_POLLER)
@@ -782,10 +823,10 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE != item->location)
 	{
 		item->location = ZBX_LOC_QUEUE;
-		zbx_binary_heap_insert(&config->queues[item->poller_type], &elem);
+		zbx_timewheel_insert(&config->queues[item->poller_type], &elem, item->nextcheck);
 	}
 	else
-		zbx_binary_heap_update_direct(&config->queues[item->poller_type], &elem);
+		zbx_timewheel_update_direct(&config->queues[item->poller_type], &elem, item->nextcheck);
 }
 
 static void	DCupdate_proxy_queue(ZBX_DC_PROXY *proxy)
@@ -883,7 +924,13 @@ static int	DCsync_config(zbx_dbsync_t *sync, zbx_uint64_t revision, int *flags)
 		memset(config->config, 0, sizeof(ZBX_DC_CONFIG_TABLE));
 	}
 
-	if (SUCCEED != (ret = zbx_dbsync_next(sync, &rowid, &db_row, &tag)))
+	if (SUCCEED != (ret = zbx_dbsync_next(sync, &rowid, &db_row, &tag)) && ZBX_DBSYNC_UPDATE == sync->mode)
+	{
+		/* config table was not changed since the last sync */
+		goto out;
+	}
+
+	if (SUCCEED != ret || ZBX_DBSYNC_ROW_REMOVE == tag)
 	{
 		/* load default config data */
 
@@ -897,8 +944,9 @@ static int	DCsync_config(zbx_dbsync_t *sync, zbx_uint64_t revision, int *flags)
 	}
 	else
 	{
+		/* the first selected column is configid */
 		for (i = 0; i < ARRSIZE(selected_fields); i++)
-			row[i] = db_row[i];
+			row[i] = db_row[i + 1];
 	}
 
 	/* store the config data */
@@ -1197,7 +1245,7 @@ static int	DCsync_config(zbx_dbsync_t *sync, zbx_uint64_t revision, int *flags)
 
 	if (SUCCEED == ret && SUCCEED == zbx_dbsync_next(sync, &rowid, &db_row, &tag))	/* table must have */
 		zabbix_log(LOG_LEVEL_ERR, "table 'config' has multiple records");	/* only one record */
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return SUCCEED;
@@ -1232,25 +1280,40 @@ static void	DCsync_autoreg_config(zbx_dbsync_t *sync, zbx_uint64_t revision)
 	char		**db_row;
 	zbx_uint64_t	rowid;
 	unsigned char	tag;
+	int		found = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED == zbx_dbsync_next(sync, &rowid, &db_row, &tag))
+	/* changeset lists added and updated rows before removed rows, so when the PSK record is */
+	/* replaced the removal of the old record must not reset the new PSK                   */
+	while (SUCCEED == zbx_dbsync_next(sync, &rowid, &db_row, &tag))
 	{
 		switch (tag)
 		{
 			case ZBX_DBSYNC_ROW_ADD:
 			case ZBX_DBSYNC_ROW_UPDATE:
-				zbx_strlcpy(config->autoreg_psk_identity, db_row[0],
+				if (0 != found)
+				{
+					zabbix_log(LOG_LEVEL_ERR, "table 'config_autoreg_tls' has multiple records");
+					continue;
+				}
+
+				/* the first selected column is autoreg_tlsid */
+				zbx_strlcpy(config->autoreg_psk_identity, db_row[1],
 						sizeof(config->autoreg_psk_identity));
-				zbx_strlcpy(config->autoreg_psk, db_row[1], sizeof(config->autoreg_psk));
+				zbx_strlcpy(config->autoreg_psk, db_row[2], sizeof(config->autoreg_psk));
+				found = 1;
 				break;
 			case ZBX_DBSYNC_ROW_REMOVE:
+				if (0 != found)
+					continue;
+
 				config->autoreg_psk_identity[0] = '\0';
 				zbx_guaranteed_memset(config->autoreg_psk, 0, sizeof(config->autoreg_psk));
 				break;
 			default:
 				THIS_SHOULD_NEVER_HAPPEN;
+				continue;
 		}
 
 		config->revision.autoreg_tls = revision;
@@ -2734,6 +2797,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (SUCCEED == dc_strpool_replace(found, &item->key, row[5]))
 			flags |= ZBX_ITEM_KEY_CHANGED;
 
+		dc_strpool_replace(found, &item->name, row[50]);
+
 		if (0 == found)
 		{
 			item->triggers = NULL;
@@ -3460,9 +3525,10 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		}
 
 		if (ZBX_LOC_QUEUE == item->location)
-			zbx_binary_heap_remove_direct(&config->queues[item->poller_type], item->itemid);
+			zbx_timewheel_remove_direct(&config->queues[item->poller_type], item->itemid);
 
 		dc_strpool_release(item->key);
+		dc_strpool_release(item->name);
 		dc_strpool_release(item->error);
 		dc_strpool_release(item->delay);
 		dc_strpool_release(item->history_period);
@@ -3561,13 +3627,14 @@ static void	DCsync_template_items(zbx_dbsync_t *sync)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	DCsync_prototype_items(zbx_dbsync_t *sync)
+static void	DCsync_prototype_items(zbx_dbsync_t *sync, zbx_uint64_t revision)
 {
 	char			**row;
 	zbx_uint64_t		rowid, itemid;
 	unsigned char		tag;
 	int			ret, found;
 	ZBX_DC_PROTOTYPE_ITEM	*item;
+	ZBX_DC_HOST		*host;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -3583,6 +3650,10 @@ static void	DCsync_prototype_items(zbx_dbsync_t *sync)
 
 		ZBX_STR2UINT64(item->hostid, row[1]);
 		ZBX_DBROW2UINT64(item->templateid, row[2]);
+
+		/* discovery rules use host revision to detect prototype changes */
+		if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
+			dc_host_update_revision(host, revision);
 	}
 
 	/* remove deleted prototype items from buffer */
@@ -3591,6 +3662,9 @@ static void	DCsync_prototype_items(zbx_dbsync_t *sync)
 		if (NULL == (item = (ZBX_DC_PROTOTYPE_ITEM *)zbx_hashset_search(&config->prototype_items, &rowid)))
 			continue;
 
+		if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
+			dc_host_update_revision(host, revision);
+
 		zbx_hashset_remove_direct(&config->prototype_items, item);
 	}
 
@@ -3719,7 +3793,18 @@ static void	DCsync_triggers(zbx_dbsync_t *sync, zbx_uint64_t revision)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	DCconfig_sort_triggers_topologically(void);
+/* trigger dependency graph node, used to calculate trigger topology without modifying configuration cache */
+typedef struct
+{
+	zbx_uint64_t		triggerid;
+	zbx_vector_uint64_t	dependencies;
+	unsigned char		topoindex;
+}
+zbx_dc_trigger_topo_t;
+
+static void	dc_trigger_topology_calculate(const zbx_dbsync_t *triggers_sync, const zbx_dbsync_t *tdep_sync,
+		zbx_hashset_t *topology);
+static void	dc_trigger_topology_destroy(zbx_hashset_t *topology);
 
 /******************************************************************************
  *                                                                            *
@@ -5028,6 +5113,55 @@ static int	dc_compare_hgroups(const void *d1, const void *d2)
 	return strcmp(g1->name, g2->name);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds host group to the host group index of a host                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_host_group_index_add(zbx_uint64_t hostid, zbx_dc_hostgroup_t *group)
+{
+	zbx_dc_host_group_index_t	*index_entry;
+	int				found;
+
+	index_entry = (zbx_dc_host_group_index_t *)DCfind_id(&config->host_groups_index, hostid,
+			sizeof(zbx_dc_host_group_index_t), &found);
+
+	if (0 == found)
+	{
+		zbx_vector_ptr_create_ext(&index_entry->groups, __config_shmem_malloc_func,
+				__config_shmem_realloc_func, __config_shmem_free_func);
+	}
+
+	zbx_vector_ptr_append(&index_entry->groups, group);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes host group from the host group index of a host            *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_host_group_index_remove(zbx_uint64_t hostid, const zbx_dc_hostgroup_t *group)
+{
+	zbx_dc_host_group_index_t	*index_entry;
+	int				index;
+
+	if (NULL == (index_entry = (zbx_dc_host_group_index_t *)zbx_hashset_search(&config->host_groups_index,
+			&hostid)))
+	{
+		return;
+	}
+
+	if (FAIL != (index = zbx_vector_ptr_search(&index_entry->groups, group, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+		zbx_vector_ptr_remove_noorder(&index_entry->groups, index);
+
+	/* remove index entry if it's empty */
+	if (0 == index_entry->groups.values_num)
+	{
+		zbx_vector_ptr_destroy(&index_entry->groups);
+		zbx_hashset_remove_direct(&config->host_groups_index, index_entry);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Updates host groups configuration cache                           *
@@ -5078,9 +5212,17 @@ static void	DCsync_hostgroups(zbx_dbsync_t *sync)
 
 	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
 	{
+		zbx_hashset_iter_t	iter;
+		zbx_uint64_t		*phostid;
+
 		if (NULL == (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups, &rowid)))
 			continue;
 
+		zbx_hashset_iter_reset(&group->hostids, &iter);
+
+		while (NULL != (phostid = (zbx_uint64_t *)zbx_hashset_iter_next(&iter)))
+			dc_host_group_index_remove(*phostid, group);
+
 		if (FAIL != (index = zbx_vector_ptr_search(&config->hostgroups_name, group,
 				ZBX_DEFAULT_PTR_COMPARE_FUNC)))
 		{
@@ -5683,7 +5825,12 @@ static void	DCsync_hostgroup_hosts(zbx_dbsync_t *sync)
 			continue;
 
 		ZBX_STR2UINT64(hostid, row[1]);
+
+		if (NULL != zbx_hashset_search(&group->hostids, &hostid))
+			continue;
+
 		zbx_hashset_insert(&group->hostids, &hostid, sizeof(hostid));
+		dc_host_group_index_add(hostid, group);
 	}
 
 	/* remove deleted group hostids from cache */
@@ -5695,7 +5842,12 @@ static void	DCsync_hostgroup_hosts(zbx_dbsync_t *sync)
 			continue;
 
 		ZBX_STR2UINT64(hostid, row[1]);
+
+		if (NULL == zbx_hashset_search(&group->hostids, &hostid))
+			continue;
+
 		zbx_hashset_remove(&group->hostids, &hostid);
+		dc_host_group_index_remove(hostid, group);
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -6318,11 +6470,30 @@ static void	dc_sync_httpstep_fields(zbx_dbsync_t *sync, zbx_uint64_t revision)
  *                                                                            *
  * Purpose: updates trigger topology after trigger dependency changes         *
  *                                                                            *
+ * Parameters: topology - [IN] the trigger topology calculated for the synced *
+ *                             dependencies, NULL to calculate it from cache  *
+ *                                                                            *
+ * Comments: Must be called in the same write locked section as               *
+ *           DCsync_trigdeps(), so the dependencies and the topological       *
+ *           indexes are published together.                                  *
+ *                                                                            *
  ******************************************************************************/
-static void	dc_trigger_update_topology(void)
+static void	dc_trigger_update_topology(zbx_hashset_t *topology)
 {
-	zbx_hashset_iter_t	iter;
-	ZBX_DC_TRIGGER		*trigger;
+	zbx_hashset_iter_t		iter;
+	ZBX_DC_TRIGGER			*trigger;
+	const zbx_dc_trigger_topo_t	*node;
+	zbx_hashset_t			topology_local;
+	unsigned char			topoindex;
+	int				changed_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL == topology)
+	{
+		dc_trigger_topology_calculate(NULL, NULL, &topology_local);
+		topology = &topology_local;
+	}
 
 	zbx_hashset_iter_reset(&config->triggers, &iter);
 	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
@@ -6330,10 +6501,22 @@ static void	dc_trigger_update_topology(void)
 		if (ZBX_FLAG_DISCOVERY_PROTOTYPE == trigger->flags)
 			continue;
 
-		trigger->topoindex = 1;
+		if (NULL == (node = (const zbx_dc_trigger_topo_t *)zbx_hashset_search(topology, &trigger->triggerid)))
+			topoindex = 1;
+		else
+			topoindex = node->topoindex;
+
+		if (trigger->topoindex != topoindex)
+		{
+			trigger->topoindex = topoindex;
+			changed_num++;
+		}
 	}
 
-	DCconfig_sort_triggers_topologically();
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() nodes:%d changed:%d", __func__, topology->num_data, changed_num);
+
+	if (&topology_local == topology)
+		dc_trigger_topology_destroy(&topology_local);
 }
 
 static int	zbx_default_ptr_pair_ptr_compare_func(const void *d1, const void *d2)
@@ -6997,6 +7180,40 @@ static void	DCsync_proxies(zbx_dbsync_t *sync, zbx_uint64_t revision, const zbx_
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds table synchronization statistics                             *
+ *                                                                            *
+ * Parameters: stats    - [IN/OUT] the sync statistics                        *
+ *             name     - [IN] the table name                                 *
+ *             sql_sec  - [IN] the time spent reading and comparing data      *
+ *             sync_sec - [IN] the time spent updating cache                  *
+ *             sync     - [IN] the table changeset                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_stats_add_table(zbx_dc_sync_stats_t *stats, const char *name, double sql_sec, double sync_sec,
+		const zbx_dbsync_t *sync)
+{
+	zbx_dc_sync_table_stats_t	*table;
+
+	if (ZBX_DC_SYNC_TABLES_MAX == stats->tables_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	table = &stats->tables[stats->tables_num++];
+
+	zbx_strlcpy(table->name, name, sizeof(table->name));
+	table->sql_sec = sql_sec;
+	table->sync_sec = sync_sec;
+	table->add_num = sync->add_num;
+	table->update_num = sync->update_num;
+	table->remove_num = sync->remove_num;
+
+	stats->total_sec += sql_sec + sync_sec;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Synchronize configuration data from database                      *
@@ -7027,8 +7244,9 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 			drules_sync, dchecks_sync, httptest_sync, httptest_field_sync, httpstep_sync,
 			httpstep_field_sync, autoreg_host_sync, connector_sync, connector_tag_sync, proxy_sync;
 
-	double		autoreg_csec, autoreg_csec2, autoreg_host_csec, autoreg_host_csec2;
+	double		autoreg_csec, autoreg_csec2, autoreg_host_csec, autoreg_host_csec2, topology_sec = 0;
 	zbx_dbsync_t	autoreg_config_sync;
+	zbx_hashset_t	trigger_topology, *topology = NULL;
 	zbx_uint64_t	update_flags = 0;
 	unsigned char	changelog_sync_mode = mode;	/* sync mode for objects using incremental sync */
 
@@ -7038,9 +7256,14 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	zbx_uint64_t		new_revision = config->revision.config + 1;
 	int			connectors_num = 0;
 	zbx_hashset_t		psk_owners;
+	zbx_dc_sync_stats_t	sync_stats;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	sync_lock_sec = 0;
+	sync_lock_max_sec = 0;
+	sync_lock_num = 0;
+
 	zbx_hashset_create(&activated_hosts, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	sec = zbx_time();
@@ -7055,15 +7278,13 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	else if (ZBX_DBSYNC_STATUS_INITIALIZED != sync_status)
 		changelog_sync_mode = ZBX_DBSYNC_INIT;
 
-	/* global configuration must be synchronized directly with database */
-	zbx_dbsync_init(&config_sync, ZBX_DBSYNC_INIT);
-
-	zbx_dbsync_init(&autoreg_config_sync, mode);
+	zbx_dbsync_init(&config_sync, changelog_sync_mode);
+	zbx_dbsync_init(&autoreg_config_sync, changelog_sync_mode);
 	zbx_dbsync_init(&autoreg_host_sync, mode);
 	zbx_dbsync_init(&hosts_sync, changelog_sync_mode);
 	zbx_dbsync_init(&hi_sync, mode);
 	zbx_dbsync_init(&htmpl_sync, mode);
-	zbx_dbsync_init(&gmacro_sync, mode);
+	zbx_dbsync_init(&gmacro_sync, changelog_sync_mode);
 	zbx_dbsync_init(&hmacro_sync, mode);
 	zbx_dbsync_init(&if_sync, mode);
 	zbx_dbsync_init(&items_sync, changelog_sync_mode);
@@ -7074,7 +7295,7 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	zbx_dbsync_init(&tdep_sync, mode);
 	zbx_dbsync_init(&func_sync, changelog_sync_mode);
 	zbx_dbsync_init(&expr_sync, mode);
-	zbx_dbsync_init(&action_sync, mode);
+	zbx_dbsync_init(&action_sync, changelog_sync_mode);
 
 	/* Action operation sync produces virtual rows with two columns - actionid, opflags. */
 	/* Because of this it cannot return the original database select and must always be  */
@@ -7085,15 +7306,15 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	zbx_dbsync_init(&trigger_tag_sync, changelog_sync_mode);
 	zbx_dbsync_init(&item_tag_sync, changelog_sync_mode);
 	zbx_dbsync_init(&host_tag_sync, changelog_sync_mode);
-	zbx_dbsync_init(&correlation_sync, mode);
+	zbx_dbsync_init(&correlation_sync, changelog_sync_mode);
 	zbx_dbsync_init(&corr_condition_sync, mode);
 	zbx_dbsync_init(&corr_operation_sync, mode);
-	zbx_dbsync_init(&hgroups_sync, mode);
+	zbx_dbsync_init(&hgroups_sync, changelog_sync_mode);
 	zbx_dbsync_init(&hgroup_host_sync, mode);
 	zbx_dbsync_init(&itempp_sync, changelog_sync_mode);
 	zbx_dbsync_init(&itemscrp_sync, mode);
 
-	zbx_dbsync_init(&maintenance_sync, mode);
+	zbx_dbsync_init(&maintenance_sync, changelog_sync_mode);
 	zbx_dbsync_init(&maintenance_period_sync, mode);
 	zbx_dbsync_init(&maintenance_tag_sync, mode);
 	zbx_dbsync_init(&maintenance_group_sync, mode);
@@ -7366,7 +7587,7 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	tisec2 = zbx_time() - sec;
 
 	sec = zbx_time();
-	DCsync_prototype_items(&prototype_items_sync);
+	DCsync_prototype_items(&prototype_items_sync, new_revision);
 	pisec2 = zbx_time() - sec;
 
 	sec = zbx_time();
@@ -7457,6 +7678,19 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 		goto out;
 	corr_operation_sec = zbx_time() - sec;
 
+	/* Calculate trigger topology for the synced dependencies with read lock, so it can be applied together */
+	/* with dependency changes. Initial sync changesets must be applied before calculating the topology.   */
+	if (ZBX_DBSYNC_UPDATE == tdep_sync.mode && ZBX_DBSYNC_UPDATE == triggers_sync.mode &&
+			0 != tdep_sync.add_num + tdep_sync.update_num + tdep_sync.remove_num)
+	{
+		sec = zbx_time();
+		RDLOCK_CACHE;
+		dc_trigger_topology_calculate(&triggers_sync, &tdep_sync, &trigger_topology);
+		UNLOCK_CACHE;
+		topology = &trigger_topology;
+		topology_sec = zbx_time() - sec;
+	}
+
 	START_SYNC;
 
 	sec = zbx_time();
@@ -7550,9 +7784,17 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 		connectors_num = config->connectors.num_data;
 	}
 
-	/* update trigger topology if trigger dependency was changed */
+	update_sec = zbx_time() - sec;
+
+	/* trigger topology must be updated in the same write locked section as trigger dependencies */
 	if (0 != (update_flags & ZBX_DBSYNC_UPDATE_TRIGGER_DEPENDENCY))
-		dc_trigger_update_topology();
+	{
+		sec = zbx_time();
+		dc_trigger_update_topology(topology);
+		topology_sec += zbx_time() - sec;
+	}
+
+	sec = zbx_time();
 
 	/* update various trigger related links in cache */
 	if (0 != (update_flags & (ZBX_DBSYNC_UPDATE_HOSTS | ZBX_DBSYNC_UPDATE_ITEMS | ZBX_DBSYNC_UPDATE_FUNCTIONS |
@@ -7562,12 +7804,73 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 		dc_schedule_trigger_timers((ZBX_DBSYNC_INIT == mode ? &trend_queue : NULL), time(NULL));
 	}
 
-	update_sec = zbx_time() - sec;
+	update_sec += zbx_time() - sec;
 
 	config->revision.config = new_revision;
 
+	FINISH_SYNC;
+
+	if (NULL != topology)
+		dc_trigger_topology_destroy(topology);
+
+	memset(&sync_stats, 0, sizeof(sync_stats));
+	sync_stats.mode = changelog_sync_mode;
+	sync_stats.changelog_num = changelog_num;
+	sync_stats.changelog_sec = changelog_sec;
+	sync_stats.total_sec = um_cache_sec + update_sec + topology_sec;
+
+	dc_sync_stats_add_table(&sync_stats, "config", csec, csec2, &config_sync);
+	dc_sync_stats_add_table(&sync_stats, "config_autoreg_tls", autoreg_csec, autoreg_csec2, &autoreg_config_sync);
+	dc_sync_stats_add_table(&sync_stats, "autoreg_host", autoreg_host_csec, autoreg_host_csec2, &autoreg_host_sync);
+	dc_sync_stats_add_table(&sync_stats, "hosts", hsec, hsec2, &hosts_sync);
+	dc_sync_stats_add_table(&sync_stats, "host_inventory", hisec, hisec2, &hi_sync);
+	dc_sync_stats_add_table(&sync_stats, "hosts_templates", htsec, 0, &htmpl_sync);
+	dc_sync_stats_add_table(&sync_stats, "globalmacro", gmsec, 0, &gmacro_sync);
+	dc_sync_stats_add_table(&sync_stats, "hostmacro", hmsec, 0, &hmacro_sync);
+	dc_sync_stats_add_table(&sync_stats, "host_tag", host_tag_sec, host_tag_sec2, &host_tag_sync);
+	dc_sync_stats_add_table(&sync_stats, "proxy", proxy_sec, proxy_sec2, &proxy_sync);
+	dc_sync_stats_add_table(&sync_stats, "hstgrp", hgroups_sec, hgroups_sec2, &hgroups_sync);
+	dc_sync_stats_add_table(&sync_stats, "hosts_groups", 0, 0, &hgroup_host_sync);
+	dc_sync_stats_add_table(&sync_stats, "maintenances", maintenance_sec, maintenance_sec2, &maintenance_sync);
+	dc_sync_stats_add_table(&sync_stats, "maintenances_windows", 0, 0, &maintenance_period_sync);
+	dc_sync_stats_add_table(&sync_stats, "maintenance_tag", 0, 0, &maintenance_tag_sync);
+	dc_sync_stats_add_table(&sync_stats, "maintenances_groups", 0, 0, &maintenance_group_sync);
+	dc_sync_stats_add_table(&sync_stats, "maintenances_hosts", 0, 0, &maintenance_host_sync);
+	dc_sync_stats_add_table(&sync_stats, "drules", drules_sec, drules_sec2, &drules_sync);
+	dc_sync_stats_add_table(&sync_stats, "dchecks", 0, 0, &dchecks_sync);
+	dc_sync_stats_add_table(&sync_stats, "httptest", httptest_sec, httptest_sec2, &httptest_sync);
+	dc_sync_stats_add_table(&sync_stats, "httptest_field", 0, 0, &httptest_field_sync);
+	dc_sync_stats_add_table(&sync_stats, "httpstep", 0, 0, &httpstep_sync);
+	dc_sync_stats_add_table(&sync_stats, "httpstep_field", 0, 0, &httpstep_field_sync);
+	dc_sync_stats_add_table(&sync_stats, "connector", connector_sec, connector_sec2, &connector_sync);
+	dc_sync_stats_add_table(&sync_stats, "connector_tag", 0, 0, &connector_tag_sync);
+	dc_sync_stats_add_table(&sync_stats, "interface", ifsec, ifsec2, &if_sync);
+	dc_sync_stats_add_table(&sync_stats, "items", isec, isec2, &items_sync);
+	dc_sync_stats_add_table(&sync_stats, "template_items", tisec, tisec2, &template_items_sync);
+	dc_sync_stats_add_table(&sync_stats, "prototype_items", pisec, pisec2, &prototype_items_sync);
+	dc_sync_stats_add_table(&sync_stats, "item_discovery", idsec, idsec2, &item_discovery_sync);
+	dc_sync_stats_add_table(&sync_stats, "item_preproc", itempp_sec, itempp_sec2, &itempp_sync);
+	dc_sync_stats_add_table(&sync_stats, "item_parameter", itemscrp_sec, itemscrp_sec2, &itemscrp_sync);
+	dc_sync_stats_add_table(&sync_stats, "item_tag", item_tag_sec, item_tag_sec2, &item_tag_sync);
+	dc_sync_stats_add_table(&sync_stats, "functions", fsec, fsec2, &func_sync);
+	dc_sync_stats_add_table(&sync_stats, "triggers", tsec, tsec2, &triggers_sync);
+	dc_sync_stats_add_table(&sync_stats, "trigger_depends", dsec, dsec2, &tdep_sync);
+	dc_sync_stats_add_table(&sync_stats, "trigger_tag", trigger_tag_sec, trigger_tag_sec2, &trigger_tag_sync);
+	dc_sync_stats_add_table(&sync_stats, "expressions", expr_sec, expr_sec2, &expr_sync);
+	dc_sync_stats_add_table(&sync_stats, "actions", action_sec, action_sec2, &action_sync);
+	dc_sync_stats_add_table(&sync_stats, "operations", action_op_sec, action_op_sec2, &action_op_sync);
+	dc_sync_stats_add_table(&sync_stats, "conditions", action_condition_sec, action_condition_sec2,
+			&action_condition_sync);
+	dc_sync_stats_add_table(&sync_stats, "correlation", correlation_sec, correlation_sec2, &correlation_sync);
+	dc_sync_stats_add_table(&sync_stats, "corr_condition", corr_condition_sec, corr_condition_sec2,
+			&corr_condition_sync);
+	dc_sync_stats_add_table(&sync_stats, "corr_operation", corr_operation_sec, corr_operation_sec2,
+			&corr_operation_sync);
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
+		RDLOCK_CACHE;
+
 		total = csec + hsec + hisec + htsec + gmsec + hmsec + ifsec + idsec + isec +  tisec + pisec + tsec +
 				dsec + fsec + expr_sec + action_sec + action_op_sec + action_condition_sec +
 				trigger_tag_sec + correlation_sec + corr_condition_sec + corr_operation_sec +
@@ -7577,7 +7880,7 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 				expr_sec2 + action_op_sec2 + action_sec2 + action_condition_sec2 + trigger_tag_sec2 +
 				correlation_sec2 + corr_condition_sec2 + corr_operation_sec2 + hgroups_sec2 +
 				itempp_sec2 + maintenance_sec2 + item_tag_sec2 + update_sec + um_cache_sec +
-				drules_sec2 + httptest_sec2 + connector_sec2 + proxy_sec2;
+				drules_sec2 + httptest_sec2 + connector_sec2 + proxy_sec2 + topology_sec;
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() changelog  : sql:" ZBX_FS_DBL " sec (%d records)",
 				__func__, changelog_sec, changelog_num);
@@ -7743,6 +8046,7 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() macro cache: " ZBX_FS_DBL " sec.", __func__, um_cache_sec);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() reindex    : " ZBX_FS_DBL " sec.", __func__, update_sec);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() topology   : " ZBX_FS_DBL " sec.", __func__, topology_sec);
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sql  : " ZBX_FS_DBL " sec.", __func__, total);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sync : " ZBX_FS_DBL " sec.", __func__, total2);
@@ -7871,8 +8175,8 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 
 		for (i = 0; ZBX_POLLER_TYPE_COUNT > i; i++)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d allocated)", __func__,
-					i, config->queues[i].elems_num, config->queues[i].elems_alloc);
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d expired)", __func__,
+					i, zbx_timewheel_size(&config->queues[i]), config->queues[i].ready_num);
 		}
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() pqueue     : %d (%d allocated)", __func__,
@@ -7890,6 +8194,8 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 				config->strpool.num_data, config->strpool.num_slots);
 
 		zbx_shmem_dump_stats(LOG_LEVEL_DEBUG, config_mem);
+
+		UNLOCK_CACHE;
 	}
 
 	dberr = ZBX_DB_OK;
@@ -7900,6 +8206,18 @@ out:
 	config->status->last_update = 0;
 	config->sync_ts = time(NULL);
 
+	if (ZBX_DB_OK == dberr)
+	{
+		double	sec_lock = zbx_time() - sync_lock_ts;
+
+		sync_stats.sync_ts = config->sync_ts;
+		sync_stats.lock_sec = sync_lock_sec + sec_lock;
+		sync_stats.lock_max_sec = MAX(sync_lock_max_sec, sec_lock);
+		sync_stats.lock_num = sync_lock_num + 1;
+
+		memcpy(&config->sync_stats, &sync_stats, sizeof(zbx_dc_sync_stats_t));
+	}
+
 	FINISH_SYNC;
 
 #ifdef HAVE_ORACLE
@@ -8428,6 +8746,7 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 	CREATE_HASHSET(config->hostgroups, 0);
 	zbx_vector_ptr_create_ext(&config->hostgroups_name, __config_shmem_malloc_func, __config_shmem_realloc_func,
 			__config_shmem_free_func);
+	CREATE_HASHSET(config->host_groups_index, 0);
 
 	zbx_vector_ptr_create_ext(&config->kvs_paths, __config_shmem_malloc_func, __config_shmem_realloc_func,
 			__config_shmem_free_func);
@@ -8463,25 +8782,22 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 		switch (i)
 		{
 			case ZBX_POLLER_TYPE_JAVA:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_timewheel_create_ext(&config->queues[i],
 						__config_java_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_shmem_malloc_func,
 						__config_shmem_realloc_func,
 						__config_shmem_free_func);
 				break;
 			case ZBX_POLLER_TYPE_PINGER:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_timewheel_create_ext(&config->queues[i],
 						__config_pinger_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_shmem_malloc_func,
 						__config_shmem_realloc_func,
 						__config_shmem_free_func);
 				break;
 			default:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_timewheel_create_ext(&config->queues[i],
 						__config_heap_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_shmem_malloc_func,
 						__config_shmem_realloc_func,
 						__config_shmem_free_func);
@@ -8535,6 +8851,8 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 
 	config->availability_diff_ts = 0;
 	config->sync_ts = 0;
+	memset(&config->sync_stats, 0, sizeof(zbx_dc_sync_stats_t));
+	memset(&config->agent_session_stats, 0, sizeof(zbx_dc_agent_session_stats_t));
 
 	config->internal_actions = 0;
 	config->auto_registration_actions = 0;
@@ -9745,15 +10063,15 @@ static void	dc_preproc_sync_masteritem(zbx_pp_item_preproc_t *preproc, const ZBX
 	preproc->dep_itemids_num = masteritem->dep_itemids.values_num;
 }
 
-static void	dc_preproc_sync_item(zbx_hashset_t *items, ZBX_DC_ITEM *dc_item, zbx_uint64_t revision)
+static void	dc_preproc_sync_item(zbx_flathashset_t *items, ZBX_DC_ITEM *dc_item, zbx_uint64_t revision)
 {
 	zbx_pp_item_t	*pp_item;
 
-	if (NULL == (pp_item = (zbx_pp_item_t *)zbx_hashset_search(items, &dc_item->itemid)))
+	if (NULL == (pp_item = (zbx_pp_item_t *)zbx_flathashset_search(items, &dc_item->itemid)))
 	{
 		zbx_pp_item_t	pp_item_local = {.itemid = dc_item->itemid};
 
-		pp_item = (zbx_pp_item_t *)zbx_hashset_insert(items, &pp_item_local, sizeof(pp_item_local));
+		pp_item = (zbx_pp_item_t *)zbx_flathashset_insert(items, &pp_item_local, sizeof(pp_item_local));
 	}
 	else
 		zbx_pp_item_preproc_release(pp_item->preproc);
@@ -9813,12 +10131,13 @@ static void	dc_preproc_add_item_rec(ZBX_DC_ITEM *dc_item, zbx_vector_dc_item_ptr
  *             timestamp   - [IN/OUT] timestamp of a last update              *
  *                                                                            *
  ******************************************************************************/
-void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_dc_um_shared_handle_t **um_handle,
+void	zbx_dc_config_get_preprocessable_items(zbx_flathashset_t *items, zbx_dc_um_shared_handle_t **um_handle,
 		zbx_uint64_t *revision)
 {
 	ZBX_DC_HOST			*dc_host;
 	zbx_pp_item_t			*pp_item;
 	zbx_hashset_iter_t		iter;
+	zbx_flathashset_iter_t		items_iter;
 	int				i;
 	zbx_vector_dc_item_ptr_t	items_sync;
 	zbx_dc_um_shared_handle_t	*um_handle_new = NULL;
@@ -9868,7 +10187,7 @@ void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_dc_um_shar
 			/* Update unchanged item preprocessing revision and remove from sync list if already synced,  */
 			/* dependent items might have been unchanged but need to be added if their master is enabled. */
 			if (items_sync.values[i]->revision <= *revision &&
-					NULL != (pp_item = (zbx_pp_item_t *)zbx_hashset_search(items,
+					NULL != (pp_item = (zbx_pp_item_t *)zbx_flathashset_search(items,
 						&items_sync.values[i]->itemid)))
 			{
 				pp_item->revision = config->revision.config;
@@ -9890,13 +10209,13 @@ void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_dc_um_shar
 
 	/* remove items without preprocessing */
 
-	zbx_hashset_iter_reset(items, &iter);
-	while (NULL != (pp_item = (zbx_pp_item_t *)zbx_hashset_iter_next(&iter)))
+	zbx_flathashset_iter_reset(items, &items_iter);
+	while (NULL != (pp_item = (zbx_pp_item_t *)zbx_flathashset_iter_next(&items_iter)))
 	{
 		if (pp_item->revision == *revision)
 			continue;
 
-		zbx_hashset_iter_remove(&iter);
+		zbx_flathashset_iter_remove(&items_iter);
 	}
 
 	zbx_vector_dc_item_ptr_destroy(&items_sync);
@@ -10812,23 +11131,9 @@ unlock:
  * Return value: nextcheck or FAIL if no items for the specified queue        *
  *                                                                            *
  ******************************************************************************/
-static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
+static int	dc_config_get_queue_nextcheck(const zbx_timewheel_t *queue)
 {
-	int				nextcheck;
-	const zbx_binary_heap_elem_t	*min;
-	const ZBX_DC_ITEM		*dc_item;
-
-	if (FAIL == zbx_binary_heap_empty(queue))
-	{
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (const ZBX_DC_ITEM *)min->data;
-
-		nextcheck = dc_item->nextcheck;
-	}
-	else
-		nextcheck = FAIL;
-
-	return nextcheck;
+	return zbx_timewheel_next_expire(queue);
 }
 
 /******************************************************************************
@@ -10843,7 +11148,7 @@ static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
 int	zbx_dc_config_get_poller_nextcheck(unsigned char poller_type)
 {
 	int			nextcheck;
-	zbx_binary_heap_t	*queue;
+	zbx_timewheel_t		*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -10928,7 +11233,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 		int config_max_concurrent_checks, zbx_dc_item_t **items)
 {
 	int			now, num = 0, max_items, items_alloc = 0;
-	zbx_binary_heap_t	*queue;
+	zbx_timewheel_t		*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -10959,7 +11264,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 
 	WRLOCK_CACHE;
 
-	while (num < max_items && FAIL == zbx_binary_heap_empty(queue))
+	while (num < max_items && FAIL == zbx_timewheel_empty(queue))
 	{
 		int				disable_until;
 		const zbx_binary_heap_elem_t	*min;
@@ -10968,7 +11273,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 		ZBX_DC_ITEM			*dc_item;
 		static const ZBX_DC_ITEM	*dc_item_prev = NULL;
 
-		min = zbx_binary_heap_find_min(queue);
+		min = zbx_timewheel_find_min(queue);
 		dc_item = (ZBX_DC_ITEM *)min->data;
 
 		if (dc_item->nextcheck > now)
@@ -10991,7 +11296,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 			}
 		}
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_timewheel_remove_min(queue);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -11097,7 +11402,7 @@ int	zbx_dc_config_get_ipmi_poller_items(int now, int items_num, int config_timeo
 		int *nextcheck)
 {
 	int			num = 0;
-	zbx_binary_heap_t	*queue;
+	zbx_timewheel_t		*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -11105,7 +11410,7 @@ int	zbx_dc_config_get_ipmi_poller_items(int now, int items_num, int config_timeo
 
 	WRLOCK_CACHE;
 
-	while (num < items_num && FAIL == zbx_binary_heap_empty(queue))
+	while (num < items_num && FAIL == zbx_timewheel_empty(queue))
 	{
 		int				disable_until;
 		const zbx_binary_heap_elem_t	*min;
@@ -11113,13 +11418,13 @@ int	zbx_dc_config_get_ipmi_poller_items(int now, int items_num, int config_timeo
 		ZBX_DC_INTERFACE		*dc_interface;
 		ZBX_DC_ITEM			*dc_item;
 
-		min = zbx_binary_heap_find_min(queue);
+		min = zbx_timewheel_find_min(queue);
 		dc_item = (ZBX_DC_ITEM *)min->data;
 
 		if (dc_item->nextcheck > now)
 			break;
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_timewheel_remove_min(queue);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -11356,6 +11661,273 @@ void	zbx_dc_poller_requeue_items(const zbx_uint64_t *itemids, const int *lastclo
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get configuration revision of item check related data            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	dc_item_get_check_revision(const ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *dc_host)
+{
+	zbx_uint64_t	revision;
+
+	revision = MAX(dc_item->revision, dc_host->revision);
+
+	um_cache_get_host_revision(config->um_cache, ZBX_UM_CACHE_GLOBAL_MACRO_HOSTID, &revision);
+	um_cache_get_host_revision(config->um_cache, dc_host->hostid, &revision);
+
+	return revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get configuration revision of discovery rule and its prototypes   *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN]                                              *
+ *                                                                            *
+ * Return value: The revision or 0 if discovery rule is not cached.           *
+ *                                                                            *
+ * Comments: Discovery rule, item prototype and user macro changes increase   *
+ *           the revision.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_dc_get_lld_rule_revision(zbx_uint64_t lld_ruleid)
+{
+	const ZBX_DC_ITEM	*dc_item;
+	const ZBX_DC_HOST	*dc_host;
+	zbx_uint64_t		revision = 0;
+
+	RDLOCK_CACHE;
+
+	if (NULL != (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &lld_ruleid)) &&
+			NULL != (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+	{
+		revision = dc_item_get_check_revision(dc_item, dc_host);
+	}
+
+	UNLOCK_CACHE;
+
+	return revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if item owned by poller can still be checked by its owner   *
+ *                                                                            *
+ * Parameters: dc_item     - [IN]                                             *
+ *             poller_type - [IN] the owner poller type                       *
+ *             revision    - [IN] the configuration revision the item was     *
+ *                                validated at                                *
+ *             pdc_host    - [OUT] the item host                              *
+ *                                                                            *
+ * Return value: SUCCEED - item can be checked by its owner                   *
+ *               FAIL    - item must be returned to the poller queue          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_owned_item_validate(const ZBX_DC_ITEM *dc_item, unsigned char poller_type, zbx_uint64_t revision,
+		const ZBX_DC_HOST **pdc_host)
+{
+	const ZBX_DC_HOST	*dc_host;
+	const ZBX_DC_INTERFACE	*dc_interface;
+
+	if (ZBX_LOC_POLLER != dc_item->location || ITEM_STATUS_ACTIVE != dc_item->status ||
+			poller_type != dc_item->poller_type)
+	{
+		return FAIL;
+	}
+
+	if (NULL == (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+		return FAIL;
+
+	if (HOST_STATUS_MONITORED != dc_host->status)
+		return FAIL;
+
+	if (revision < dc_item_get_check_revision(dc_item, dc_host))
+		return FAIL;
+
+	if (SUCCEED == DCin_maintenance_without_data_collection(dc_host, dc_item))
+		return FAIL;
+
+	/* items on unreachable interfaces are throttled by the poller queue */
+	dc_interface = (const ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &dc_item->interfaceid);
+
+	if (0 != DCget_disable_until(dc_item, dc_interface))
+		return FAIL;
+
+	*pdc_host = dc_host;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get items owned by asynchronous poller                            *
+ *                                                                            *
+ * Parameters: poller_type - [IN] the owner poller type                       *
+ *             itemids     - [IN] the owned items to check                    *
+ *             revisions   - [IN] the configuration revisions owned items     *
+ *                                were validated at                           *
+ *             itemids_num - [IN] the number of owned items                   *
+ *             items       - [OUT] the items that can be checked by owner,    *
+ *                                 must have space for itemids_num items      *
+ *             released    - [OUT] the items that must be returned to the     *
+ *                                 poller queue                               *
+ *             revision    - [OUT] the configuration revision returned items  *
+ *                                 were validated at                          *
+ *                                                                            *
+ * Return value: number of items in items array                               *
+ *                                                                            *
+ * Comments: Owned items keep ZBX_LOC_POLLER location and are not present in  *
+ *           poller queue, so they are retrieved under read lock. Released    *
+ *           items must be returned with zbx_dc_poller_requeue_items().       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_config_get_owned_poller_items(unsigned char poller_type, const zbx_uint64_t *itemids,
+		const zbx_uint64_t *revisions, int itemids_num, zbx_dc_item_t *items, zbx_vector_uint64_t *released,
+		zbx_uint64_t *revision)
+{
+	int	i, num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d num:%d", __func__, (int)poller_type, itemids_num);
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < itemids_num; i++)
+	{
+		const ZBX_DC_ITEM	*dc_item;
+		const ZBX_DC_HOST	*dc_host;
+
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+				SUCCEED != dc_owned_item_validate(dc_item, poller_type, revisions[i], &dc_host))
+		{
+			zbx_vector_uint64_append(released, itemids[i]);
+			continue;
+		}
+
+		DCget_host(&items[num].host, dc_host);
+		DCget_item(&items[num], dc_item);
+		num++;
+	}
+
+	*revision = config->revision.config;
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d released:%d", __func__, num, released->values_num);
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate next checks of collected items owned by poller          *
+ *                                                                            *
+ * Parameters: itemids    - [IN]                                              *
+ *             lastclocks - [IN] the item collection times                    *
+ *             nextchecks - [OUT] the item next checks or FAIL if item was    *
+ *                                removed                                     *
+ *             num        - [IN] the number of items                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_poller_get_owned_nextchecks(const zbx_uint64_t *itemids, const int *lastclocks, int *nextchecks,
+		size_t num)
+{
+	size_t	i;
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		const ZBX_DC_ITEM	*dc_item;
+		const ZBX_DC_INTERFACE	*dc_interface;
+
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+		{
+			nextchecks[i] = FAIL;
+			continue;
+		}
+
+		dc_interface = (const ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces,
+				&dc_item->interfaceid);
+
+		dc_item_nextcheck_calculate(dc_item, dc_interface, ZBX_ITEM_COLLECTED, lastclocks[i], &nextchecks[i],
+				NULL);
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validate items owned by poller after configuration changes        *
+ *                                                                            *
+ * Parameters: poller_type - [IN] the owner poller type                       *
+ *             itemids     - [IN] the owned items                             *
+ *             revisions   - [IN] the configuration revisions owned items     *
+ *                                were validated at                           *
+ *             itemids_num - [IN] the number of owned items                   *
+ *             released    - [OUT] the items that must be returned to the     *
+ *                                 poller queue                               *
+ *             revision    - [OUT] the configuration revision the items that  *
+ *                                 were not released are validated at         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_poller_validate_owned_items(unsigned char poller_type, const zbx_uint64_t *itemids,
+		const zbx_uint64_t *revisions, int itemids_num, zbx_vector_uint64_t *released, zbx_uint64_t *revision)
+{
+	int	i;
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < itemids_num; i++)
+	{
+		const ZBX_DC_ITEM	*dc_item;
+		const ZBX_DC_HOST	*dc_host;
+
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+				SUCCEED != dc_owned_item_validate(dc_item, poller_type, revisions[i], &dc_host))
+		{
+			zbx_vector_uint64_append(released, itemids[i]);
+		}
+	}
+
+	*revision = config->revision.config;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update next checks of items owned by poller                       *
+ *                                                                            *
+ * Parameters: itemids    - [IN]                                              *
+ *             nextchecks - [IN]                                              *
+ *             num        - [IN] the number of items                          *
+ *                                                                            *
+ * Comments: Owned items are scheduled by their owner. Their next checks are  *
+ *           written back in batches so the item queue statistics stay       *
+ *           accurate without locking configuration cache for every check.   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_poller_flush_owned_nextchecks(const zbx_uint64_t *itemids, const int *nextchecks, size_t num)
+{
+	size_t	i;
+
+	WRLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		ZBX_DC_ITEM	*dc_item;
+
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+			continue;
+
+		if (ZBX_LOC_POLLER == dc_item->location)
+			dc_item->nextcheck = nextchecks[i];
+	}
+
+	UNLOCK_CACHE;
+}
+
 #ifdef HAVE_OPENIPMI
 /******************************************************************************
  *                                                                            *
@@ -11879,79 +12451,263 @@ int	zbx_dc_config_check_trigger_dependencies(zbx_uint64_t triggerid)
 	return ret;
 }
 
+/* trigger state after applying trigger changeset */
+typedef struct
+{
+	zbx_uint64_t	triggerid;
+	unsigned char	flags;
+	unsigned char	tag;
+}
+zbx_dc_trigger_synced_t;
+
 /******************************************************************************
  *                                                                            *
- * Comments: helper function for DCconfig_sort_triggers_topologically()       *
+ * Purpose: get flags of trigger as it will be after applying trigger         *
+ *          changeset                                                         *
+ *                                                                            *
+ * Parameters: synced    - [IN] the triggers from trigger changeset           *
+ *             triggerid - [IN] the trigger identifier                        *
+ *             flags     - [OUT] the trigger flags                            *
+ *                                                                            *
+ * Return value: SUCCEED - the trigger will be in configuration cache         *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static unsigned char	DCconfig_sort_triggers_topologically_rec(const ZBX_DC_TRIGGER_DEPLIST *trigdep, int level)
+static int	dc_trigger_topology_get_flags(zbx_hashset_t *synced, zbx_uint64_t triggerid, unsigned char *flags)
 {
-	int				i;
-	unsigned char			topoindex = 2, next_topoindex;
-	const ZBX_DC_TRIGGER_DEPLIST	*next_trigdep;
+	const zbx_dc_trigger_synced_t	*trigger_synced;
+	const ZBX_DC_TRIGGER		*trigger;
+
+	if (NULL != (trigger_synced = (const zbx_dc_trigger_synced_t *)zbx_hashset_search(synced, &triggerid)))
+	{
+		if (ZBX_DBSYNC_ROW_REMOVE == trigger_synced->tag)
+			return FAIL;
+
+		*flags = trigger_synced->flags;
+
+		return SUCCEED;
+	}
+
+	if (NULL == (trigger = (const ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &triggerid)))
+		return FAIL;
+
+	*flags = trigger->flags;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get trigger dependency graph node, adding it if necessary         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_dc_trigger_topo_t	*dc_trigger_topology_add_node(zbx_hashset_t *topology, zbx_uint64_t triggerid)
+{
+	zbx_dc_trigger_topo_t	*node, node_local;
+
+	if (NULL == (node = (zbx_dc_trigger_topo_t *)zbx_hashset_search(topology, &triggerid)))
+	{
+		node_local.triggerid = triggerid;
+		node_local.topoindex = 1;
+		zbx_vector_uint64_create(&node_local.dependencies);
+
+		node = (zbx_dc_trigger_topo_t *)zbx_hashset_insert(topology, &node_local, sizeof(node_local));
+	}
+
+	return node;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees trigger dependency graph                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_topology_destroy(zbx_hashset_t *topology)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_dc_trigger_topo_t	*node;
+
+	zbx_hashset_iter_reset(topology, &iter);
+	while (NULL != (node = (zbx_dc_trigger_topo_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_destroy(&node->dependencies);
+
+	zbx_hashset_destroy(topology);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: helper function for dc_trigger_topology_calculate()              *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	dc_trigger_topology_sort_rec(zbx_hashset_t *topology, zbx_dc_trigger_topo_t *node,
+		int level)
+{
+	int			i;
+	unsigned char		topoindex = 2, next_topoindex;
+	zbx_dc_trigger_topo_t	*next_node;
 
 	if (32 < level)
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "recursive trigger dependency is too deep (triggerid:" ZBX_FS_UI64 ")",
-				trigdep->triggerid);
+				node->triggerid);
 		goto exit;
 	}
 
-	if (0 == trigdep->trigger->topoindex)
+	if (0 == node->topoindex)
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "trigger dependencies contain a cycle (triggerid:" ZBX_FS_UI64 ")",
-				trigdep->triggerid);
+				node->triggerid);
 		goto exit;
 	}
 
-	trigdep->trigger->topoindex = 0;
+	node->topoindex = 0;
 
-	for (i = 0; i < trigdep->dependencies.values_num; i++)
+	for (i = 0; i < node->dependencies.values_num; i++)
 	{
-		next_trigdep = (const ZBX_DC_TRIGGER_DEPLIST *)trigdep->dependencies.values[i];
+		/* triggers without dependencies have index 1 and are not in the graph */
+		if (NULL == (next_node = (zbx_dc_trigger_topo_t *)zbx_hashset_search(topology,
+				&node->dependencies.values[i])))
+		{
+			continue;
+		}
 
-		if (1 < (next_topoindex = next_trigdep->trigger->topoindex))
+		if (1 < (next_topoindex = next_node->topoindex))
 			goto next;
 
-		if (0 == next_trigdep->dependencies.values_num)
+		if (0 == next_node->dependencies.values_num)
 			continue;
 
-		next_topoindex = DCconfig_sort_triggers_topologically_rec(next_trigdep, level + 1);
+		next_topoindex = dc_trigger_topology_sort_rec(topology, next_node, level + 1);
 next:
 		if (topoindex < next_topoindex + 1)
 			topoindex = next_topoindex + 1;
 	}
 
-	trigdep->trigger->topoindex = topoindex;
+	node->topoindex = topoindex;
 exit:
 	return topoindex;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: assign each trigger an index based on trigger dependency topology *
+ * Purpose: calculate index for each trigger based on trigger dependency      *
+ *          topology after applying trigger and trigger dependency changesets *
+ *                                                                            *
+ * Parameters: triggers_sync - [IN] the trigger changeset, NULL if the        *
+ *                                  changes are already applied to cache      *
+ *             tdep_sync     - [IN] the trigger dependency changeset, NULL if *
+ *                                  the changes are already applied to cache  *
+ *             topology      - [OUT] the trigger dependency graph with        *
+ *                                   calculated indexes, triggers without     *
+ *                                   dependencies are not included            *
+ *                                                                            *
+ * Comments: Only reads configuration cache, so configuration syncer can call *
+ *           it with read lock before applying the changesets. The changesets *
+ *           must be in update mode.                                          *
+ *           Dependencies are applied like DCsync_trigdeps() does - the new   *
+ *           dependencies of triggers that are not cached are ignored.        *
  *                                                                            *
  ******************************************************************************/
-static void	DCconfig_sort_triggers_topologically(void)
+static void	dc_trigger_topology_calculate(const zbx_dbsync_t *triggers_sync, const zbx_dbsync_t *tdep_sync,
+		zbx_hashset_t *topology)
 {
+	zbx_hashset_t			synced;
 	zbx_hashset_iter_t		iter;
-	ZBX_DC_TRIGGER			*trigger;
 	const ZBX_DC_TRIGGER_DEPLIST	*trigdep;
+	zbx_dc_trigger_topo_t		*node;
+	const zbx_dbsync_row_t		*row;
+	zbx_uint64_t			triggerid_down, triggerid_up;
+	unsigned char			flags;
+	int				i, index;
+
+	zbx_hashset_create(topology, (size_t)config->trigdeps.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&synced, NULL == triggers_sync ? 0 : (size_t)triggers_sync->rows.values_num,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	if (NULL != triggers_sync)
+	{
+		for (i = 0; i < triggers_sync->rows.values_num; i++)
+		{
+			zbx_dc_trigger_synced_t	trigger_local;
+
+			row = (const zbx_dbsync_row_t *)triggers_sync->rows.values[i];
+
+			trigger_local.triggerid = row->rowid;
+			trigger_local.tag = row->tag;
+			trigger_local.flags = 0;
+
+			/* sync this with DCsync_triggers() */
+			if (ZBX_DBSYNC_ROW_REMOVE != row->tag)
+				ZBX_STR2UCHAR(trigger_local.flags, row->row[19]);
+
+			zbx_hashset_insert(&synced, &trigger_local, sizeof(trigger_local));
+		}
+	}
 
 	zbx_hashset_iter_reset(&config->trigdeps, &iter);
+	while (NULL != (trigdep = (const ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 == trigdep->dependencies.values_num)
+			continue;
 
-	while (NULL != (trigdep = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_iter_next(&iter)))
+		node = dc_trigger_topology_add_node(topology, trigdep->triggerid);
+
+		for (i = 0; i < trigdep->dependencies.values_num; i++)
+		{
+			zbx_vector_uint64_append(&node->dependencies,
+					((const ZBX_DC_TRIGGER_DEPLIST *)trigdep->dependencies.values[i])->triggerid);
+		}
+	}
+
+	if (NULL != tdep_sync)
 	{
-		trigger = trigdep->trigger;
+		for (i = 0; i < tdep_sync->rows.values_num; i++)
+		{
+			row = (const zbx_dbsync_row_t *)tdep_sync->rows.values[i];
+
+			ZBX_STR2UINT64(triggerid_down, row->row[0]);
+			ZBX_STR2UINT64(triggerid_up, row->row[1]);
 
-		if (NULL == trigger || ZBX_FLAG_DISCOVERY_PROTOTYPE == trigger->flags || 1 < trigger->topoindex ||
-				0 == trigdep->dependencies.values_num)
+			if (ZBX_DBSYNC_ROW_REMOVE == row->tag)
+			{
+				if (NULL != (node = (zbx_dc_trigger_topo_t *)zbx_hashset_search(topology,
+						&triggerid_down)) && FAIL != (index = zbx_vector_uint64_search(
+						&node->dependencies, triggerid_up, ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+				{
+					zbx_vector_uint64_remove_noorder(&node->dependencies, index);
+				}
+
+				continue;
+			}
+
+			if (SUCCEED != dc_trigger_topology_get_flags(&synced, triggerid_down, &flags) ||
+					SUCCEED != dc_trigger_topology_get_flags(&synced, triggerid_up, &flags))
+			{
+				continue;
+			}
+
+			node = dc_trigger_topology_add_node(topology, triggerid_down);
+			zbx_vector_uint64_append(&node->dependencies, triggerid_up);
+		}
+	}
+
+	zbx_hashset_iter_reset(topology, &iter);
+	while (NULL != (node = (zbx_dc_trigger_topo_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (1 < node->topoindex || 0 == node->dependencies.values_num)
+			continue;
+
+		if (SUCCEED != dc_trigger_topology_get_flags(&synced, node->triggerid, &flags) ||
+				ZBX_FLAG_DISCOVERY_PROTOTYPE == flags)
 		{
 			continue;
 		}
 
-		DCconfig_sort_triggers_topologically_rec(trigdep, 0);
+		dc_trigger_topology_sort_rec(topology, node, 0);
 	}
+
+	zbx_hashset_destroy(&synced);
 }
 
 /******************************************************************************
@@ -12743,6 +13499,64 @@ void	zbx_dc_get_count_stats_all(zbx_config_cache_info_t *stats)
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets statistics of the last configuration cache synchronization   *
+ *                                                                            *
+ * Parameters: stats - [OUT] the configuration sync statistics                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_sync_stats(zbx_dc_sync_stats_t *stats)
+{
+	RDLOCK_CACHE;
+	memcpy(stats, &config->sync_stats, sizeof(zbx_dc_sync_stats_t));
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds passive agent session statistics collected by poller         *
+ *                                                                            *
+ * Parameters: stats      - [IN] the counters collected since the last call,  *
+ *                               idle connection count is ignored             *
+ *             idle_delta - [IN] the change of idle connection count          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_add_agent_session_stats(const zbx_dc_agent_session_stats_t *stats, int idle_delta)
+{
+	zbx_dc_agent_session_stats_t	*dst = &config->agent_session_stats;
+
+	WRLOCK_CACHE;
+
+	dst->connections += stats->connections;
+	dst->reused += stats->reused;
+	dst->expired += stats->expired;
+	dst->requests += stats->requests;
+	dst->checks += stats->checks;
+	dst->fallbacks += stats->fallbacks;
+
+	if (0 > idle_delta && dst->idle < (zbx_uint64_t)-idle_delta)
+		dst->idle = 0;
+	else
+		dst->idle += (zbx_uint64_t)idle_delta;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets passive agent session statistics                             *
+ *                                                                            *
+ * Parameters: stats - [OUT]                                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_agent_session_stats(zbx_dc_agent_session_stats_t *stats)
+{
+	RDLOCK_CACHE;
+	memcpy(stats, &config->agent_session_stats, sizeof(zbx_dc_agent_session_stats_t));
+	UNLOCK_CACHE;
+}
+
 static void	proxy_counter_ui64_push(zbx_vector_ptr_t *vector, zbx_uint64_t proxyid, zbx_uint64_t counter)
 {
 	zbx_proxy_counter_t	*proxy_counter;
@@ -15899,6 +16713,19 @@ zbx_uint64_t	zbx_dc_get_received_revision(void)
 	return config->revision.upstream;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the configuration cache revision                              *
+ *                                                                            *
+ * Comments: The revision is read without locking, so it can be only used to  *
+ *           check if configuration cache has been updated.                   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_dc_get_config_revision(void)
+{
+	return config->revision.config;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: cache the configuration revision received from server             *
@@ -16057,6 +16884,10 @@ void	zbx_dc_get_unused_macro_templates(zbx_hashset_t *templates, const zbx_vecto
 #ifdef HAVE_TESTS
 #	include "../../../tests/libs/zbxdbcache/dc_item_poller_type_update_test.c"
 #	include "../../../tests/libs/zbxdbcache/dc_function_calculate_nextcheck_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_trigger_update_topology_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_poller_validate_owned_items_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_history_export_info_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_config_sync_test.c"
 #endif
 
 void	zbx_recalc_time_period(time_t *ts_from, int table_group)
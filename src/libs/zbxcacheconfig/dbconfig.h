@@ -125,6 +125,7 @@ typedef struct
 	zbx_uint64_t		lastlogsize;
 	zbx_uint64_t		valuemapid;
 	const char		*key;
+	const char		*name;
 	const char		*port;
 	const char		*error;
 	const char		*delay;
@@ -702,6 +703,14 @@ typedef struct
 }
 zbx_dc_host_tag_index_t;
 
+typedef struct
+{
+	zbx_uint64_t		hostid;
+	zbx_vector_ptr_t	groups;
+		/* references to zbx_dc_hostgroup_t records cached in config-> hostgroups hashset */
+}
+zbx_dc_host_group_index_t;
+
 typedef struct
 {
 	const char	*tag;
@@ -972,6 +981,7 @@ typedef struct
 	zbx_hashset_t		corr_operations;
 	zbx_hashset_t		hostgroups;
 	zbx_vector_ptr_t	hostgroups_name;	/* host groups sorted by name */
+	zbx_hashset_t		host_groups_index;	/* host group index by hostid */
 	zbx_vector_ptr_t	kvs_paths;
 	zbx_hashset_t		gmacro_kv;
 	zbx_hashset_t		hmacro_kv;
@@ -994,7 +1004,7 @@ typedef struct
 	zbx_hashset_t		connectors;
 	zbx_hashset_t		connector_tags;
 	zbx_hashset_t		sessions[ZBX_SESSION_TYPE_COUNT];
-	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
+	zbx_timewheel_t		queues[ZBX_POLLER_TYPE_COUNT];
 	zbx_binary_heap_t	pqueue;
 	zbx_binary_heap_t	trigger_queue;
 	zbx_binary_heap_t	drule_queue;
@@ -1006,6 +1016,8 @@ typedef struct
 	char			autoreg_psk_identity[HOST_TLS_PSK_IDENTITY_LEN_MAX];	/* autoregistration PSK */
 	char			autoreg_psk[HOST_TLS_PSK_LEN_MAX];
 	zbx_vps_monitor_t	vps_monitor;
+	zbx_dc_sync_stats_t	sync_stats;		/* statistics of the last configuration sync */
+	zbx_dc_agent_session_stats_t	agent_session_stats;
 }
 ZBX_DC_CONFIG;
 
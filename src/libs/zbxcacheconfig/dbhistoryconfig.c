@@ -235,6 +235,81 @@ void	zbx_dc_config_history_sync_unset_existing_itemids(zbx_vector_uint64_t *item
 	UNLOCK_CACHE_CONFIG_HISTORY;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get host group names, item names and item tags of exported       *
+ *          history and trends                                                *
+ *                                                                            *
+ * Parameters: hosts_info - [IN/OUT] the hosts to get group names for         *
+ *             items_info - [IN/OUT] the items to get names and tags for      *
+ *                                                                            *
+ * Comments: Host groups are sorted by name and item tags by tag and value.   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_config_history_sync_get_export_info(zbx_hashset_t *hosts_info, zbx_hashset_t *items_info)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_history_export_host_t	*host_info;
+	zbx_history_export_item_t	*item_info;
+	const ZBX_DC_ITEM		*dc_item;
+	const zbx_dc_host_group_index_t	*group_index;
+	int				i;
+
+	RDLOCK_CACHE_CONFIG_HISTORY;
+
+	zbx_hashset_iter_reset(hosts_info, &iter);
+
+	while (NULL != (host_info = (zbx_history_export_host_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == (group_index = (const zbx_dc_host_group_index_t *)zbx_hashset_search(
+				&config->host_groups_index, &host_info->hostid)))
+		{
+			continue;
+		}
+
+		for (i = 0; i < group_index->groups.values_num; i++)
+		{
+			const zbx_dc_hostgroup_t	*group;
+
+			group = (const zbx_dc_hostgroup_t *)group_index->groups.values[i];
+			zbx_vector_str_append(&host_info->groups, zbx_strdup(NULL, group->name));
+		}
+	}
+
+	zbx_hashset_iter_reset(items_info, &iter);
+
+	while (NULL != (item_info = (zbx_history_export_item_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &item_info->itemid)))
+			continue;
+
+		item_info->name = zbx_strdup(item_info->name, dc_item->name);
+
+		for (i = 0; i < dc_item->tags.values_num; i++)
+		{
+			const zbx_dc_item_tag_t	*dc_tag = (const zbx_dc_item_tag_t *)dc_item->tags.values[i];
+			zbx_tag_t		*tag;
+
+			tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
+			tag->tag = zbx_strdup(NULL, dc_tag->tag);
+			tag->value = zbx_strdup(NULL, dc_tag->value);
+			zbx_vector_tags_append(&item_info->item_tags, tag);
+		}
+	}
+
+	UNLOCK_CACHE_CONFIG_HISTORY;
+
+	zbx_hashset_iter_reset(hosts_info, &iter);
+
+	while (NULL != (host_info = (zbx_history_export_host_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_str_sort(&host_info->groups, ZBX_DEFAULT_STR_COMPARE_FUNC);
+
+	zbx_hashset_iter_reset(items_info, &iter);
+
+	while (NULL != (item_info = (zbx_history_export_item_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_tags_sort(&item_info->item_tags, zbx_compare_tags);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Get functions by IDs                                              *
@@ -53,8 +53,15 @@
 #define ZBX_DBSYNC_OBJ_CONNECTOR	17
 #define ZBX_DBSYNC_OBJ_CONNECTOR_TAG	18
 #define ZBX_DBSYNC_OBJ_PROXY		19
+#define ZBX_DBSYNC_OBJ_GLOBALMACRO	20
+#define ZBX_DBSYNC_OBJ_HOSTGROUP	21
+#define ZBX_DBSYNC_OBJ_ACTION		22
+#define ZBX_DBSYNC_OBJ_CORRELATION	23
+#define ZBX_DBSYNC_OBJ_MAINTENANCE	24
+#define ZBX_DBSYNC_OBJ_CONFIG		25
+#define ZBX_DBSYNC_OBJ_AUTOREG_TLS	26
 /* number of dbsync objects - keep in sync with above defines */
-#define ZBX_DBSYNC_OBJ_COUNT		19
+#define ZBX_DBSYNC_OBJ_COUNT		26
 
 #define ZBX_DBSYNC_JOURNAL(X)		(X - 1)
 
@@ -702,6 +709,25 @@ static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes updated objects not matching sync query filter            *
+ *                                                                            *
+ * Comments: The journal updates left after dbsync_read_journal() belong to   *
+ *           objects filtered out by the query (for example disabled), so     *
+ *           they must be removed from configuration cache.                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_remove_filtered_rows(zbx_dbsync_t *sync, const zbx_dbsync_journal_t *journal)
+{
+	int	i;
+
+	for (i = 0; i < journal->updates.values_num; i++)
+		dbsync_add_row(sync, journal->updates.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+
+	sync->remove_num += (zbx_uint64_t)journal->updates.values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initializes changeset                                             *
@@ -856,11 +882,14 @@ static char	*encode_expression(const zbx_eval_context_t *ctx)
  ******************************************************************************/
 int	zbx_dbsync_compare_config(zbx_dbsync_t *sync)
 {
-	zbx_db_result_t	result;
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = SUCCEED;
 
-#define SELECTED_CONFIG_FIELD_COUNT	42	/* number of columns in the following zbx_db_select() */
+#define SELECTED_CONFIG_FIELD_COUNT	44	/* number of columns in the following select */
 
-	if (NULL == (result = zbx_db_select("select discovery_groupid,snmptrap_logging,"
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"select configid,discovery_groupid,snmptrap_logging,"
 				"severity_name_0,severity_name_1,severity_name_2,"
 				"severity_name_3,severity_name_4,severity_name_5,"
 				"hk_events_mode,hk_events_trigger,hk_events_internal,"
@@ -872,27 +901,24 @@ int	zbx_dbsync_compare_config(zbx_dbsync_t *sync)
 				"auditlog_enabled,timeout_zabbix_agent,timeout_simple_check,timeout_snmp_agent,"
 				"timeout_external_check,timeout_db_monitor,timeout_http_agent,timeout_ssh_agent,"
 				"timeout_telnet_agent,timeout_script"
-			" from config"
-			" order by configid")))	/* if you change number of columns in zbx_db_select(), */
+			" from config");	/* if you change number of columns in select, */
 						/* adjust SELECTED_CONFIG_FIELD_COUNT */
-	{
-		return FAIL;
-	}
 
 	dbsync_prepare(sync, SELECTED_CONFIG_FIELD_COUNT, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
+		if (NULL == (sync->dbresult = zbx_db_select("%s order by configid", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_db_free_result(result);
-
-	/* global configuration will be always synchronized directly with database */
-	THIS_SHOULD_NEVER_HAPPEN;
+	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "configid", "where", NULL,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_CONFIG)]);
+out:
+	zbx_free(sql);
 
-	return FAIL;
+	return ret;
 #undef SELECTED_CONFIG_FIELD_COUNT
 }
 
@@ -907,63 +933,40 @@ int	zbx_dbsync_compare_config(zbx_dbsync_t *sync)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  * Comments:                                                                  *
- *     On success this function produces a changeset with 0 or 1 record       *
- *     because 'config_autoreg_tls' table can have no more than 1 record.     *
+ *     'config_autoreg_tls' table can have no more than 1 record.             *
  *     If in future you want to support multiple autoregistration PSKs and/or *
- *     select more columns in zbx_db_select() then do not forget to sync      *
- *     changes with DCsync_autoreg_config() !!!                               *
+ *     select more columns then do not forget to sync changes with            *
+ *     DCsync_autoreg_config() !!!                                            *
  *                                                                            *
  ******************************************************************************/
 int	zbx_dbsync_compare_autoreg_psk(zbx_dbsync_t *sync)
 {
-	zbx_db_result_t	result;
-	zbx_db_row_t	dbrow;
-	int		num_records = 0;
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = SUCCEED;
 
-#define CONFIG_AUTOREG_TLS_FIELD_COUNT	2	/* number of columns in the following zbx_db_select() */
+#define CONFIG_AUTOREG_TLS_FIELD_COUNT	3	/* number of columns in the following select */
 
-	if (NULL == (result = zbx_db_select("select tls_psk_identity,tls_psk"
-			" from config_autoreg_tls"
-			" order by autoreg_tlsid")))	/* if you change number of columns in zbx_db_select(), */
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"select autoreg_tlsid,tls_psk_identity,tls_psk"
+			" from config_autoreg_tls");	/* if you change number of columns in select, */
 							/* adjust CONFIG_AUTOREG_TLS_FIELD_COUNT */
-	{
-		return FAIL;
-	}
 
 	dbsync_prepare(sync, CONFIG_AUTOREG_TLS_FIELD_COUNT, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	/* 0 or 1 records are expected */
-
-	if (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		if (FAIL == dbsync_compare_str(dbrow[0], dbsync_env.cache->autoreg_psk_identity) ||
-				FAIL == dbsync_compare_str(dbrow[1], dbsync_env.cache->autoreg_psk))
-		{
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-		}
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, 0, tag, dbrow);	/* fictitious rowid 0 is used, there is only 1 record */
-
-		num_records = 1;
+		if (NULL == (sync->dbresult = zbx_db_select("%s order by autoreg_tlsid", sql)))
+			ret = FAIL;
+		goto out;
 	}
-	else if ('\0' != dbsync_env.cache->autoreg_psk_identity[0])
-			dbsync_add_row(sync, 0, ZBX_DBSYNC_ROW_REMOVE, NULL);
 
-	if (1 == num_records && NULL != zbx_db_fetch(result))
-		zabbix_log(LOG_LEVEL_ERR, "table 'config_autoreg_tls' has multiple records");
-
-	zbx_db_free_result(result);
+	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "autoreg_tlsid", "where", NULL,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_AUTOREG_TLS)]);
+out:
+	zbx_free(sql);
 
-	return SUCCEED;
+	return ret;
 #undef CONFIG_AUTOREG_TLS_FIELD_COUNT
 }
 
@@ -1223,67 +1226,6 @@ int	zbx_dbsync_compare_host_templates(zbx_dbsync_t *sync)
 	return SUCCEED;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: compares global macro table row with cached configuration data    *
- *                                                                            *
- * Parameter: gmacro - [IN] the cached global macro data                      *
- *            dbrow    - [IN] the database row                                *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_global_macro(const zbx_um_macro_t *gmacro, const zbx_db_row_t dbrow)
-{
-	char	*macro = NULL, *context = NULL;
-	int	ret = FAIL;
-	unsigned char	context_op;
-
-	if (FAIL == dbsync_compare_uchar(dbrow[3], gmacro->type))
-		return FAIL;
-
-	if (ZBX_MACRO_VALUE_VAULT == atoi(dbrow[3]))
-	{
-		if (FAIL == um_macro_check_vault_location(gmacro, dbrow[2]))
-			return FAIL;
-	}
-	else
-	{
-		if (FAIL == dbsync_compare_str(dbrow[2], gmacro->value))
-			return FAIL;
-	}
-
-	if (SUCCEED != zbx_user_macro_parse_dyn(dbrow[1], &macro, &context, NULL, &context_op))
-		return FAIL;
-
-	if (0 != strcmp(gmacro->name, macro))
-		goto out;
-
-	if (NULL == context)
-	{
-		if (NULL != gmacro->context)
-			goto out;
-
-		ret = SUCCEED;
-		goto out;
-	}
-
-	if (NULL == gmacro->context)
-		goto out;
-
-	if (gmacro->context_op != context_op)
-		goto out;
-
-	if (0 == strcmp(gmacro->context, context))
-		ret = SUCCEED;
-out:
-	zbx_free(macro);
-	zbx_free(context);
-
-	return ret;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: compares global macros table with cached configuration data       *
@@ -1296,58 +1238,29 @@ out:
  ******************************************************************************/
 int	zbx_dbsync_compare_global_macros(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid, *prowid = &rowid;
-	zbx_um_macro_t		**pmacro;
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = SUCCEED;
 
-	if (NULL == (result = zbx_db_select(
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
 			"select globalmacroid,macro,value,type"
-			" from globalmacro")))
-	{
-		return FAIL;
-	}
+			" from globalmacro");
 
 	dbsync_prepare(sync, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->gmacros.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		if (NULL == (pmacro = (zbx_um_macro_t **)zbx_hashset_search(&dbsync_env.cache->gmacros, &prowid)))
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_global_macro(*pmacro, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
-	}
-
-	zbx_hashset_iter_reset(&dbsync_env.cache->gmacros, &iter);
-	while (NULL != (pmacro = (zbx_um_macro_t **)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &(*pmacro)->macroid))
-			dbsync_add_row(sync, (*pmacro)->macroid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "globalmacroid", "where", NULL,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_GLOBALMACRO)]);
+out:
+	zbx_free(sql);
 
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
@@ -1718,7 +1631,7 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 				"i.master_itemid,i.timeout,i.url,i.query_fields,i.posts,i.status_codes,"
 				"i.follow_redirects,i.post_type,i.http_proxy,i.headers,i.retrieve_mode,"
 				"i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,i.ssl_key_password,"
-				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null"
+				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null,i.name"
 			" from items i"
 			" inner join hosts h on i.hostid=h.hostid"
 			" join item_rtdata ir on i.itemid=ir.itemid"
@@ -1726,7 +1639,7 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_NORMAL,
 			ZBX_FLAG_DISCOVERY_RULE, ZBX_FLAG_DISCOVERY_CREATED);
 
-	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+	dbsync_prepare(sync, 51, dbsync_item_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2284,32 +2197,6 @@ int	zbx_dbsync_compare_expressions(zbx_dbsync_t *sync)
 	return SUCCEED;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: compares actions table row with cached configuration data         *
- *                                                                            *
- * Parameter: action - [IN] the cached action                                 *
- *            dbrow  - [IN] the database row                                  *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_action(const zbx_dc_action_t *action, const zbx_db_row_t dbrow)
-{
-
-	if (FAIL == dbsync_compare_uchar(dbrow[1], action->eventsource))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_uchar(dbrow[2], action->evaltype))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_str(dbrow[3], action->formula))
-		return FAIL;
-
-	return SUCCEED;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: compares actions table with cached configuration data             *
@@ -2322,61 +2209,36 @@ static int	dbsync_compare_action(const zbx_dc_action_t *action, const zbx_db_row
  ******************************************************************************/
 int	zbx_dbsync_compare_actions(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
-	zbx_dc_action_t		*action;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret = SUCCEED;
+	zbx_dbsync_journal_t	*journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ACTION)];
 
-	if (NULL == (result = zbx_db_select(
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select actionid,eventsource,evaltype,formula"
 			" from actions"
 			" where eventsource<>%d"
 				" and status=%d",
-			EVENT_SOURCE_SERVICE, ZBX_ACTION_STATUS_ACTIVE)))
-	{
-		return FAIL;
-	}
+			EVENT_SOURCE_SERVICE, ZBX_ACTION_STATUS_ACTIVE);
 
 	dbsync_prepare(sync, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->actions.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		if (NULL == (action = (zbx_dc_action_t *)zbx_hashset_search(&dbsync_env.cache->actions, &rowid)))
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_action(action, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->actions, &iter);
-	while (NULL != (action = (zbx_dc_action_t *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == (ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "actionid", "and", NULL,
+			journal)))
 	{
-		if (NULL == zbx_hashset_search(&ids, &action->actionid))
-			dbsync_add_row(sync, action->actionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		dbsync_remove_filtered_rows(sync, journal);
 	}
+out:
+	zbx_free(sql);
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
-
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
@@ -2681,31 +2543,6 @@ out:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: compares correlation table row with cached configuration data     *
- *                                                                            *
- * Parameter: correlation - [IN] the cached correlation rule                  *
- *            dbrow       - [IN] the database row                             *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_correlation(const zbx_dc_correlation_t *correlation, const zbx_db_row_t dbrow)
-{
-	if (FAIL == dbsync_compare_str(dbrow[1], correlation->name))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_uchar(dbrow[2], correlation->evaltype))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_str(dbrow[3], correlation->formula))
-		return FAIL;
-
-	return SUCCEED;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: compares correlation table with cached configuration data         *
@@ -2718,63 +2555,35 @@ static int	dbsync_compare_correlation(const zbx_dc_correlation_t *correlation, c
  ******************************************************************************/
 int	zbx_dbsync_compare_correlations(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
-	zbx_dc_correlation_t	*correlation;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret = SUCCEED;
+	zbx_dbsync_journal_t	*journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_CORRELATION)];
 
-	if (NULL == (result = zbx_db_select(
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select correlationid,name,evaltype,formula"
 			" from correlation"
 			" where status=%d",
-			ZBX_CORRELATION_ENABLED)))
-	{
-		return FAIL;
-	}
+			ZBX_CORRELATION_ENABLED);
 
 	dbsync_prepare(sync, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->correlations.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		if (NULL == (correlation = (zbx_dc_correlation_t *)zbx_hashset_search(&dbsync_env.cache->correlations,
-				&rowid)))
-		{
-			tag = ZBX_DBSYNC_ROW_ADD;
-		}
-		else if (FAIL == dbsync_compare_correlation(correlation, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->correlations, &iter);
-	while (NULL != (correlation = (zbx_dc_correlation_t *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == (ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "correlationid", "and",
+			NULL, journal)))
 	{
-		if (NULL == zbx_hashset_search(&ids, &correlation->correlationid))
-			dbsync_add_row(sync, correlation->correlationid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		dbsync_remove_filtered_rows(sync, journal);
 	}
+out:
+	zbx_free(sql);
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
-
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
@@ -3009,25 +2818,6 @@ int	zbx_dbsync_compare_corr_operations(zbx_dbsync_t *sync)
 	return SUCCEED;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: compares host group table row with cached configuration data      *
- *                                                                            *
- * Parameter: group - [IN] the cached host group                              *
- *            dbrow - [IN] the database row                                   *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_host_group(const zbx_dc_hostgroup_t *group, const zbx_db_row_t dbrow)
-{
-	if (FAIL == dbsync_compare_str(dbrow[1], group->name))
-		return FAIL;
-
-	return SUCCEED;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: compares host groups table with cached configuration data         *
@@ -3040,54 +2830,28 @@ static int	dbsync_compare_host_group(const zbx_dc_hostgroup_t *group, const zbx_
  ******************************************************************************/
 int	zbx_dbsync_compare_host_groups(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
-	zbx_dc_hostgroup_t	*group;
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = SUCCEED;
 
-	if (NULL == (result = zbx_db_select("select groupid,name from hstgrp where type=%d", HOSTGROUP_TYPE_HOST)))
-		return FAIL;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select groupid,name from hstgrp where type=%d",
+			HOSTGROUP_TYPE_HOST);
 
 	dbsync_prepare(sync, 2, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->hostgroups.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		if (NULL == (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&dbsync_env.cache->hostgroups, &rowid)))
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_host_group(group, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
-	}
-
-	zbx_hashset_iter_reset(&dbsync_env.cache->hostgroups, &iter);
-	while (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &group->groupid))
-			dbsync_add_row(sync, group->groupid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "groupid", "and", NULL,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOSTGROUP)]);
+out:
+	zbx_free(sql);
 
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
@@ -3127,34 +2891,6 @@ out:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: compares maintenance table row with cached configuration data     *
- *                                                                            *
- * Parameter: maintenance - [IN] the cached maintenance data                  *
- *            dbrow       - [IN] the database row                             *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_maintenance(const zbx_dc_maintenance_t *maintenance, const zbx_db_row_t dbrow)
-{
-	if (FAIL == dbsync_compare_uchar(dbrow[1], maintenance->type))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_int(dbrow[2], maintenance->active_since))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_int(dbrow[3], maintenance->active_until))
-		return FAIL;
-
-	if (FAIL == dbsync_compare_uchar(dbrow[4], maintenance->tags_evaltype))
-		return FAIL;
-
-	return SUCCEED;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: compares item script params table row with cached configuration   *
@@ -3276,59 +3012,29 @@ int	zbx_dbsync_compare_item_script_param(zbx_dbsync_t *sync)
  ******************************************************************************/
 int	zbx_dbsync_compare_maintenances(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
-	zbx_dc_maintenance_t	*maintenance;
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = SUCCEED;
 
-	if (NULL == (result = zbx_db_select("select maintenanceid,maintenance_type,active_since,active_till,tags_evaltype"
-						" from maintenances")))
-	{
-		return FAIL;
-	}
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"select maintenanceid,maintenance_type,active_since,active_till,tags_evaltype"
+			" from maintenances");
 
 	dbsync_prepare(sync, 5, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->maintenances.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		maintenance = (zbx_dc_maintenance_t *)zbx_hashset_search(&dbsync_env.cache->maintenances, &rowid);
-
-		if (NULL == maintenance)
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_maintenance(maintenance, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
-	}
-
-	zbx_hashset_iter_reset(&dbsync_env.cache->maintenances, &iter);
-	while (NULL != (maintenance = (zbx_dc_maintenance_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &maintenance->maintenanceid))
-			dbsync_add_row(sync, maintenance->maintenanceid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "maintenanceid", "where", NULL,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_MAINTENANCE)]);
+out:
+	zbx_free(sql);
 
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
@@ -19,6 +19,7 @@
 
 #include "zbxcachehistory.h"
 #include "dbcache.h"
+#include "history_writer.h"
 #include "zbxcachevalue.h"
 #include "zbxmutexs.h"
 #include "zbxexpression.h"
@@ -38,10 +39,14 @@
 #include "zbxcrypto.h"
 #include "zbxeval.h"
 
-static zbx_shmem_info_t	*hc_index_mem = NULL;
-static zbx_shmem_info_t	*hc_mem = NULL;
+static zbx_shmem_info_t	*hc_header_mem = NULL;
 static zbx_shmem_info_t	*trend_mem = NULL;
 
+/* history cache shard memory and locks, indexed by shard index */
+static zbx_shmem_info_t	*hc_shard_index_mem[ZBX_HC_SHARDS_MAX];
+static zbx_shmem_info_t	*hc_shard_mem[ZBX_HC_SHARDS_MAX];
+static zbx_mutex_t	hc_shard_locks[ZBX_HC_SHARDS_MAX];
+
 #define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
 #define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
@@ -63,6 +68,9 @@ static zbx_history_sync_f	sync_history_cb = NULL;
 
 #define ZBX_HC_ITEMS_INIT_SIZE	1000
 
+/* the size of shared memory segment for history cache header and proxy queue */
+#define ZBX_HC_HEADER_SIZE	ZBX_MEBIBYTE
+
 #define ZBX_TRENDS_CLEANUP_TIME	(SEC_PER_MIN * 55)
 
 /* the minimum processed item percentage of item candidates to continue synchronizing */
@@ -104,13 +112,26 @@ zbx_hc_proxyqueue_t;
 
 typedef struct
 {
-	zbx_hashset_t		trends;
-	zbx_dc_stats_t		stats;
+	int			index;
 
 	zbx_hashset_t		history_items;
 	zbx_binary_heap_t	history_queue;
+	zbx_dc_stats_t		stats;
 
 	int			history_num;
+
+	zbx_uint64_t		lock_num;	/* the number of times the shard lock was acquired */
+	double			lock_wait;	/* the total time spent waiting for the shard lock */
+}
+zbx_hc_shard_t;
+
+typedef struct
+{
+	zbx_hashset_t		trends;
+
+	zbx_hc_shard_t		*shards;
+	int			shards_num;
+
 	int			trends_num;
 	int			trends_last_cleanup_hour;
 	int			history_num_total;
@@ -119,11 +140,21 @@ typedef struct
 	unsigned char		db_trigger_queue_lock;
 
 	zbx_hc_proxyqueue_t	proxyqueue;
+
+	/* history and trends write statistics collected from history syncers */
+	zbx_db_insert_stats_t	insert_stats[ZBX_DB_INSERT_STATS_TABLES_NUM];
 }
 ZBX_DC_CACHE;
 
 static ZBX_DC_CACHE	*cache = NULL;
 
+typedef struct
+{
+	zbx_uint64_t	total_size;
+	zbx_uint64_t	free_size;
+}
+zbx_hc_mem_size_t;
+
 /* local history cache */
 #define ZBX_MAX_VALUES_LOCAL	256
 #define ZBX_STRUCT_REALLOC_STEP	8
@@ -168,9 +199,12 @@ static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
 static void	hc_add_item_values(dc_item_value_t *values, int values_num);
-static void	hc_queue_item(zbx_hc_item_t *item);
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_get_history_compression_age(void);
+static zbx_hc_shard_t	*hc_shard_lock(int index);
+static void	hc_shard_unlock(const zbx_hc_shard_t *shard);
+static int	hc_get_history_num(void);
 
 void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
 {
@@ -178,6 +212,58 @@ void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
 		zbx_free(opt->source);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds history cache shard value counters to the total counters     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_stats_add(zbx_dc_stats_t *total, const zbx_dc_stats_t *stats)
+{
+	total->history_counter += stats->history_counter;
+	total->history_float_counter += stats->history_float_counter;
+	total->history_uint_counter += stats->history_uint_counter;
+	total->history_str_counter += stats->history_str_counter;
+	total->history_log_counter += stats->history_log_counter;
+	total->history_text_counter += stats->history_text_counter;
+	total->history_bin_counter += stats->history_bin_counter;
+	total->notsupported_counter += stats->notsupported_counter;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets value counters and memory usage summed over all history      *
+ *          cache shards                                                      *
+ *                                                                            *
+ * Parameters: stats     - [OUT] the value counters                           *
+ *             data_mem  - [OUT] the history data memory size                 *
+ *             index_mem - [OUT] the history index memory size                *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_shards_stats(zbx_dc_stats_t *stats, zbx_hc_mem_size_t *data_mem, zbx_hc_mem_size_t *index_mem)
+{
+	int	i;
+
+	memset(stats, 0, sizeof(zbx_dc_stats_t));
+	memset(data_mem, 0, sizeof(zbx_hc_mem_size_t));
+	memset(index_mem, 0, sizeof(zbx_hc_mem_size_t));
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
+
+		shard = hc_shard_lock(i);
+
+		hc_stats_add(stats, &shard->stats);
+
+		data_mem->total_size += hc_shard_mem[i]->total_size;
+		data_mem->free_size += hc_shard_mem[i]->free_size;
+		index_mem->total_size += hc_shard_index_mem[i]->total_size;
+		index_mem->free_size += hc_shard_index_mem[i]->free_size;
+
+		hc_shard_unlock(shard);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves all internal metrics of the database cache              *
@@ -187,21 +273,53 @@ void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
  ******************************************************************************/
 void	zbx_dc_get_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	int	i;
+
+	memset(&wcache_info->stats, 0, sizeof(wcache_info->stats));
+	wcache_info->history_free = 0;
+	wcache_info->history_total = 0;
+	wcache_info->index_free = 0;
+	wcache_info->index_total = 0;
+	wcache_info->shards_num = cache->shards_num;
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_stats_t	*shard_stats = &wcache_info->shards[i];
+		zbx_hc_shard_t		*shard;
+
+		shard = hc_shard_lock(i);
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+		hc_stats_add(&wcache_info->stats, &shard->stats);
+
+		shard_stats->history_free = hc_shard_mem[i]->free_size;
+		shard_stats->history_total = hc_shard_mem[i]->total_size;
+		shard_stats->index_free = hc_shard_index_mem[i]->free_size;
+		shard_stats->index_total = hc_shard_index_mem[i]->total_size;
+		shard_stats->items_num = (zbx_uint64_t)shard->history_items.num_data;
+		shard_stats->values_num = (zbx_uint64_t)shard->history_num;
+		shard_stats->lock_num = shard->lock_num;
+		shard_stats->lock_wait = shard->lock_wait;
+
+		hc_shard_unlock(shard);
+
+		wcache_info->history_free += shard_stats->history_free;
+		wcache_info->history_total += shard_stats->history_total;
+		wcache_info->index_free += shard_stats->index_free;
+		wcache_info->index_total += shard_stats->index_total;
+	}
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
+		LOCK_CACHE;
+
 		wcache_info->trend_free = trend_mem->free_size;
 		wcache_info->trend_total = trend_mem->orig_size;
-	}
+		memcpy(wcache_info->insert_stats, cache->insert_stats, sizeof(cache->insert_stats));
 
-	UNLOCK_CACHE;
+		UNLOCK_CACHE;
+	}
+	else
+		memset(wcache_info->insert_stats, 0, sizeof(wcache_info->insert_stats));
 }
 
 /******************************************************************************
@@ -214,111 +332,127 @@ void	*zbx_dc_get_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	zbx_dc_stats_t		stats;
+	zbx_hc_mem_size_t	hc_mem_size, hc_index_mem_size, trend_mem_size = {0, 0};
 
-	LOCK_CACHE;
+	/* history cache statistics are protected by shard locks, only trend cache requires cache lock */
+	switch (request)
+	{
+		case ZBX_STATS_TREND_TOTAL:
+		case ZBX_STATS_TREND_USED:
+		case ZBX_STATS_TREND_FREE:
+		case ZBX_STATS_TREND_PUSED:
+		case ZBX_STATS_TREND_PFREE:
+			LOCK_CACHE;
+			trend_mem_size.total_size = trend_mem->orig_size;
+			trend_mem_size.free_size = trend_mem->free_size;
+			UNLOCK_CACHE;
+			break;
+		default:
+			hc_get_shards_stats(&stats, &hc_mem_size, &hc_index_mem_size);
+	}
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = hc_mem_size.total_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = hc_mem_size.total_size - hc_mem_size.free_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = hc_mem_size.free_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(hc_mem_size.total_size - hc_mem_size.free_size) /
+					hc_mem_size.total_size;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)hc_mem_size.free_size / hc_mem_size.total_size;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
-			value_uint = trend_mem->orig_size;
+			value_uint = trend_mem_size.total_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_USED:
-			value_uint = trend_mem->orig_size - trend_mem->free_size;
+			value_uint = trend_mem_size.total_size - trend_mem_size.free_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_FREE:
-			value_uint = trend_mem->free_size;
+			value_uint = trend_mem_size.free_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_PUSED:
-			value_double = 100 * (double)(trend_mem->orig_size - trend_mem->free_size) /
-					trend_mem->orig_size;
+			value_double = 100 * (double)(trend_mem_size.total_size - trend_mem_size.free_size) /
+					trend_mem_size.total_size;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_PFREE:
-			value_double = 100 * (double)trend_mem->free_size / trend_mem->orig_size;
+			value_double = 100 * (double)trend_mem_size.free_size / trend_mem_size.total_size;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = hc_index_mem_size.total_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = hc_index_mem_size.total_size - hc_index_mem_size.free_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = hc_index_mem_size.free_size;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(hc_index_mem_size.total_size - hc_index_mem_size.free_size) /
+					hc_index_mem_size.total_size;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)hc_index_mem_size.free_size / hc_index_mem_size.total_size;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_BIN_COUNTER:
-			value_uint = cache->stats.history_bin_counter;
+			value_uint = stats.history_bin_counter;
 			ret = (void *)&value_uint;
 			break;
 		default:
 			ret = NULL;
 	}
 
-	UNLOCK_CACHE;
-
 	return ret;
 }
 
@@ -964,13 +1098,6 @@ static void	DBmass_update_trends(const ZBX_DC_TREND *trends, int trends_num,
 	}
 }
 
-typedef struct
-{
-	zbx_uint64_t		hostid;
-	zbx_vector_ptr_t	groups;
-}
-zbx_host_info_t;
-
 /******************************************************************************
  *                                                                            *
  * Purpose: frees resources allocated to store host groups names              *
@@ -978,191 +1105,56 @@ zbx_host_info_t;
  * Parameters: host_info - [IN] host information                              *
  *                                                                            *
  ******************************************************************************/
-static void	zbx_host_info_clean(zbx_host_info_t *host_info)
-{
-	zbx_vector_ptr_clear_ext(&host_info->groups, zbx_ptr_free);
-	zbx_vector_ptr_destroy(&host_info->groups);
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: get hosts groups names                                            *
- *                                                                            *
- * Parameters: hosts_info - [IN/OUT] output names of host groups for a host   *
- *             hostids    - [IN] hosts identifiers                            *
- *                                                                            *
- ******************************************************************************/
-static void	db_get_hosts_info_by_hostid(zbx_hashset_t *hosts_info, const zbx_vector_uint64_t *hostids)
-{
-	int		i;
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-
-	for (i = 0; i < hostids->values_num; i++)
-	{
-		zbx_host_info_t	host_info = {.hostid = hostids->values[i]};
-
-		zbx_vector_ptr_create(&host_info.groups);
-		zbx_hashset_insert(hosts_info, &host_info, sizeof(host_info));
-	}
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-				"select distinct hg.hostid,g.name"
-				" from hstgrp g,hosts_groups hg"
-				" where g.groupid=hg.groupid"
-					" and");
-
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.hostid", hostids->values, hostids->values_num);
-
-	result = zbx_db_select("%s", sql);
-
-	while (NULL != (row = zbx_db_fetch(result)))
-	{
-		zbx_uint64_t	hostid;
-		zbx_host_info_t	*host_info;
-
-		ZBX_DBROW2UINT64(hostid, row[0]);
-
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &hostid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
-
-		zbx_vector_ptr_append(&host_info->groups, zbx_strdup(NULL, row[1]));
-	}
-	zbx_db_free_result(result);
-}
-
-typedef struct
+static void	history_export_host_clean(zbx_history_export_host_t *host_info)
 {
-	zbx_uint64_t		itemid;
-	char			*name;
-	zbx_history_sync_item_t	*item;
-	zbx_vector_tags_t	item_tags;
+	zbx_vector_str_clear_ext(&host_info->groups, zbx_str_free);
+	zbx_vector_str_destroy(&host_info->groups);
 }
-zbx_item_info_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item names                                                    *
+ * Purpose: frees resources allocated to store item tags and name             *
  *                                                                            *
- * Parameters: items_info - [IN/OUT] output item names                        *
- *             itemids    - [IN] the item identifiers                         *
+ * Parameters: item_info - [IN] item information                              *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_item_names_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
+static void	history_export_item_clean(zbx_history_export_item_t *item_info)
 {
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,name from items where");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
-
-	result = zbx_db_select("%s", sql);
-
-	while (NULL != (row = zbx_db_fetch(result)))
-	{
-		zbx_uint64_t	itemid;
-		zbx_item_info_t	*item_info;
-
-		ZBX_DBROW2UINT64(itemid, row[0]);
-
-		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
-
-		item_info->name = zbx_strdup(item_info->name, row[1]);
-	}
-
-	zbx_db_free_result(result);
+	zbx_vector_tags_clear_ext(&item_info->item_tags, zbx_free_tag);
+	zbx_vector_tags_destroy(&item_info->item_tags);
+	zbx_free(item_info->name);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item tags                                                     *
+ * Purpose: adds item and its host to the exported items and hosts           *
  *                                                                            *
- * Parameters: items_info - [IN/OUT] output item tags                         *
- *             itemids    - [IN] the item identifiers                         *
+ * Parameters: hosts_info - [IN/OUT] the exported hosts                       *
+ *             items_info - [IN/OUT] the exported items                       *
+ *             item       - [IN] the item                                     *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_item_tags_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
+static void	history_export_add_item(zbx_hashset_t *hosts_info, zbx_hashset_t *items_info,
+		const zbx_history_sync_item_t *item)
 {
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-	zbx_item_info_t	*item_info = NULL;
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,tag,value from item_tag where");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by itemid");
+	zbx_history_export_item_t	item_info;
+	zbx_history_export_host_t	host_info;
 
-	result = zbx_db_select("%s", sql);
-
-	while (NULL != (row = zbx_db_fetch(result)))
+	if (NULL == zbx_hashset_search(items_info, &item->itemid))
 	{
-		zbx_uint64_t	itemid;
-		zbx_tag_t	*item_tag;
-
-		ZBX_DBROW2UINT64(itemid, row[0]);
-
-		if (NULL == item_info || item_info->itemid != itemid)
-		{
-			if (NULL != item_info)
-			{
-				zbx_vector_tags_sort(&item_info->item_tags, zbx_compare_tags);
-			}
-			if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				continue;
-			}
-		}
-
-		item_tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(*item_tag));
-		item_tag->tag = zbx_strdup(NULL, row[1]);
-		item_tag->value = zbx_strdup(NULL, row[2]);
-		zbx_vector_tags_append(&item_info->item_tags, item_tag);
+		item_info.itemid = item->itemid;
+		item_info.name = NULL;
+		item_info.item = item;
+		zbx_vector_tags_create(&item_info.item_tags);
+		zbx_hashset_insert(items_info, &item_info, sizeof(item_info));
 	}
 
-	if (NULL != item_info)
+	if (NULL == zbx_hashset_search(hosts_info, &item->host.hostid))
 	{
-		zbx_vector_tags_sort(&item_info->item_tags, zbx_compare_tags);
+		host_info.hostid = item->host.hostid;
+		zbx_vector_str_create(&host_info.groups);
+		zbx_hashset_insert(hosts_info, &host_info, sizeof(host_info));
 	}
-
-	zbx_db_free_result(result);
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: get item names and item tags                                      *
- *                                                                            *
- * Parameters: items_info - [IN/OUT] output item name and item tags           *
- *             itemids    - [IN] the item identifiers                         *
- *                                                                            *
- ******************************************************************************/
-static void	db_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
-{
-	db_get_item_names_by_itemid(items_info, itemids);
-	db_get_item_tags_by_itemid(items_info, itemids);
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: frees resources allocated to store item tags and name             *
- *                                                                            *
- * Parameters: item_info - [IN] item information                              *
- *                                                                            *
- ******************************************************************************/
-static void	zbx_item_info_clean(zbx_item_info_t *item_info)
-{
-	zbx_vector_tags_clear_ext(&item_info->item_tags, zbx_free_tag);
-	zbx_vector_tags_destroy(&item_info->item_tags);
-	zbx_free(item_info->name);
 }
 
 /******************************************************************************
@@ -1182,8 +1174,8 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 	const ZBX_DC_TREND		*trend = NULL;
 	int				i, j;
 	const zbx_history_sync_item_t	*item;
-	zbx_host_info_t			*host_info;
-	zbx_item_info_t			*item_info;
+	zbx_history_export_host_t	*host_info;
+	zbx_history_export_item_t	*item_info;
 	zbx_uint128_t			avg;	/* calculate the trend average value */
 
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
@@ -1192,12 +1184,13 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 	{
 		trend = &trends[i];
 
-		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &trend->itemid)))
+		if (NULL == (item_info = (zbx_history_export_item_t *)zbx_hashset_search(items_info, &trend->itemid)))
 			continue;
 
 		item = item_info->item;
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->host.hostid)))
+		if (NULL == (host_info = (zbx_history_export_host_t *)zbx_hashset_search(hosts_info,
+				&item->host.hostid)))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
@@ -1280,8 +1273,8 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 	const zbx_dc_history_t		*h;
 	const zbx_history_sync_item_t	*item;
 	int				i, j;
-	zbx_host_info_t			*host_info;
-	zbx_item_info_t			*item_info;
+	zbx_history_export_host_t	*host_info;
+	zbx_history_export_item_t	*item_info;
 	struct zbx_json			json;
 	zbx_connector_object_t		connector_object;
 
@@ -1301,7 +1294,7 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 			continue;
 		}
 
-		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &h->itemid)))
+		if (NULL == (item_info = (zbx_history_export_item_t *)zbx_hashset_search(items_info, &h->itemid)))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
@@ -1309,7 +1302,8 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 
 		item = item_info->item;
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->host.hostid)))
+		if (NULL == (host_info = (zbx_history_export_host_t *)zbx_hashset_search(hosts_info,
+				&item->host.hostid)))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
@@ -1442,18 +1436,16 @@ static void	DCexport_history_and_trends(const zbx_dc_history_t *history, int his
 		zbx_vector_connector_filter_t *connector_filters, unsigned char **data, size_t *data_alloc,
 		size_t *data_offset)
 {
-	int			i, index;
-	zbx_vector_uint64_t	hostids, item_info_ids;
-	zbx_hashset_t		hosts_info, items_info;
-	zbx_history_sync_item_t	*item;
-	zbx_item_info_t		item_info;
+	int				i, index;
+	zbx_hashset_t			hosts_info, items_info;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d trends_num:%d", __func__, history_num, trends_num);
 
-	zbx_vector_uint64_create(&hostids);
-	zbx_vector_uint64_create(&item_info_ids);
 	zbx_hashset_create_ext(&items_info, itemids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_item_info_clean,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)history_export_item_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create_ext(&hosts_info, itemids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)history_export_host_clean,
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 
 	for (i = 0; i < history_num; i++)
@@ -1472,16 +1464,7 @@ static void	DCexport_history_and_trends(const zbx_dc_history_t *history, int his
 		if (SUCCEED != errcodes[index])
 			continue;
 
-		item = &items[index];
-
-		zbx_vector_uint64_append(&hostids, item->host.hostid);
-		zbx_vector_uint64_append(&item_info_ids, item->itemid);
-
-		item_info.itemid = item->itemid;
-		item_info.name = NULL;
-		item_info.item = item;
-		zbx_vector_tags_create(&item_info.item_tags);
-		zbx_hashset_insert(&items_info, &item_info, sizeof(item_info));
+		history_export_add_item(&hosts_info, &items_info, &items[index]);
 	}
 
 	if (0 == history_num)
@@ -1500,33 +1483,15 @@ static void	DCexport_history_and_trends(const zbx_dc_history_t *history, int his
 			if (SUCCEED != errcodes[index])
 				continue;
 
-			item = &items[index];
-
-			zbx_vector_uint64_append(&hostids, item->host.hostid);
-			zbx_vector_uint64_append(&item_info_ids, item->itemid);
-
-			item_info.itemid = item->itemid;
-			item_info.name = NULL;
-			item_info.item = item;
-			zbx_vector_tags_create(&item_info.item_tags);
-			zbx_hashset_insert(&items_info, &item_info, sizeof(item_info));
+			history_export_add_item(&hosts_info, &items_info, &items[index]);
 		}
 	}
 
-	if (0 == item_info_ids.values_num)
+	if (0 == items_info.num_data)
 		goto clean;
 
-	zbx_vector_uint64_sort(&item_info_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	zbx_hashset_create_ext(&hosts_info, hostids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_host_info_clean,
-			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-	db_get_hosts_info_by_hostid(&hosts_info, &hostids);
-
-	db_get_items_info_by_itemid(&items_info, &item_info_ids);
+	/* host groups, item names and tags are taken from configuration cache without database queries */
+	zbx_dc_config_history_sync_get_export_info(&hosts_info, &items_info);
 
 	if (0 != history_num)
 	{
@@ -1536,12 +1501,9 @@ static void	DCexport_history_and_trends(const zbx_dc_history_t *history, int his
 
 	if (0 != trends_num)
 		DCexport_trends(trends, trends_num, &hosts_info, &items_info);
-
-	zbx_hashset_destroy(&hosts_info);
 clean:
+	zbx_hashset_destroy(&hosts_info);
 	zbx_hashset_destroy(&items_info);
-	zbx_vector_uint64_destroy(&item_info_ids);
-	zbx_vector_uint64_destroy(&hostids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -2523,7 +2485,10 @@ static void	remove_history_duplicates(zbx_vector_ptr_t *history)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static int	add_history(zbx_dc_history_t *history, int history_num, zbx_vector_ptr_t *history_values, int *ret_flush)
+typedef int	(*zbx_add_history_func_t)(zbx_vector_ptr_t *history, int *ret_flush);
+
+static int	add_history(zbx_dc_history_t *history, int history_num, zbx_vector_ptr_t *history_values, int *ret_flush,
+		zbx_add_history_func_t add_history_func)
 {
 	int	i, ret = SUCCEED;
 
@@ -2538,44 +2503,54 @@ static int	add_history(zbx_dc_history_t *history, int history_num, zbx_vector_pt
 	}
 
 	if (0 != history_values->values_num)
-		ret = zbx_vc_add_values(history_values, ret_flush);
+		ret = add_history_func(history_values, ret_flush);
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds values to history storage without updating value cache      *
+ *                                                                            *
+ ******************************************************************************/
+static int	history_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+{
+	return zbx_history_add_values(history, ret_flush);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: inserting new history data after new value is received            *
  *                                                                            *
- * Parameters: history     - array of history data                            *
- *             history_num - number of history structures                     *
+ * Parameters: history          - [IN] array of history data                  *
+ *             history_num      - [IN] number of history structures           *
+ *             history_values   - [OUT] the values added to history           *
+ *             add_history_func - [IN] the function to add values to history  *
  *                                                                            *
  ******************************************************************************/
-static int	DBmass_add_history(zbx_dc_history_t *history, int history_num)
+static int	DBmass_add_history(zbx_dc_history_t *history, int history_num, zbx_vector_ptr_t *history_values,
+		zbx_add_history_func_t add_history_func)
 {
-	int			ret, ret_flush = FLUSH_SUCCEED, num;
-	zbx_vector_ptr_t	history_values;
+	int	ret, ret_flush = FLUSH_SUCCEED, num;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_vector_ptr_create(&history_values);
-	zbx_vector_ptr_reserve(&history_values, history_num);
+	zbx_vector_ptr_reserve(history_values, (size_t)history_num);
 
-	if (FAIL == (ret = add_history(history, history_num, &history_values, &ret_flush)) &&
+	if (FAIL == (ret = add_history(history, history_num, history_values, &ret_flush, add_history_func)) &&
 			FLUSH_DUPL_REJECTED == ret_flush)
 	{
-		num = history_values.values_num;
-		remove_history_duplicates(&history_values);
-		zbx_vector_ptr_clear(&history_values);
+		num = history_values->values_num;
+		remove_history_duplicates(history_values);
+		zbx_vector_ptr_clear(history_values);
 
-		if (SUCCEED == (ret = add_history(history, history_num, &history_values, &ret_flush)))
-			zabbix_log(LOG_LEVEL_WARNING, "skipped %d duplicates", num - history_values.values_num);
+		if (SUCCEED == (ret = add_history(history, history_num, history_values, &ret_flush,
+				add_history_func)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "skipped %d duplicates", num - history_values->values_num);
+		}
 	}
 
-	zbx_vps_monitor_add_written((zbx_uint64_t)history_values.values_num);
-
-	zbx_vector_ptr_destroy(&history_values);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return ret;
@@ -2885,56 +2860,206 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
 	}
 }
 
+/* history synchronization batch */
+typedef struct
+{
+	zbx_dc_history_t		history[ZBX_HC_SYNC_MAX];
+	int				history_num;
+	int				ret;			/* the history write result */
+	zbx_history_sync_item_t		*items;
+	int				*errcodes;
+	zbx_vector_ptr_t		history_items;
+	zbx_vector_uint64_t		itemids;
+	zbx_vector_uint64_t		triggerids;
+	zbx_vector_ptr_t		item_diff;
+	zbx_vector_ptr_t		inventory_values;
+	zbx_vector_uint64_pair_t	proxy_subscriptions;
+	zbx_vector_ptr_t		history_values;		/* the values added to history */
+	zbx_vector_ptr_t		item_events;		/* the deferred internal item events */
+	zbx_dc_um_handle_t		*um_handle;
+}
+zbx_hc_sync_batch_t;
+
+/* internal item event generated while preparing history, but added only after history is written */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_timespec_t	ts;
+	int		state;
+	char		*error;
+}
+zbx_hc_item_event_t;
+
+static zbx_vector_ptr_t	*hc_item_events;
+
+static void	hc_item_event_free(zbx_hc_item_event_t *event)
+{
+	zbx_free(event->error);
+	zbx_free(event);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: flush history cache to database, process triggers of flushed      *
- *          and timer triggers from timer queue                               *
- *                                                                            *
- * Parameters:                                                                *
- *             values_num   - [IN/OUT] the number of synced values            *
- *             triggers_num - [IN/OUT] the number of processed timers         *
- *             events_cbs   - [IN]                                            *
- *             more         - [OUT] a flag indicating the cache emptiness:    *
- *                               ZBX_SYNC_DONE - nothing to sync, go idle     *
- *                               ZBX_SYNC_MORE - more data to sync            *
+ * Purpose: defers internal item event until history of the batch is written  *
  *                                                                            *
- * Comments: This function loops syncing history values by 1k batches and     *
- *           processing timer triggers by batches of 500 triggers.            *
- *           Unless full sync is being done the loop is aborted if either     *
- *           timeout has passed or there are no more data to process.         *
- *           The last is assumed when the following is true:                  *
- *            a) history cache is empty or less than 10% of batch values were *
- *               processed (the other items were locked by triggers)          *
- *            b) less than 500 (full batch) timer triggers were processed     *
+ * Comments: In pipelined mode history of a batch is prepared before the      *
+ *           events of the previous batch are processed, so internal item     *
+ *           events are stored and added later by hc_add_item_events().       *
  *                                                                            *
  ******************************************************************************/
-void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_events_funcs_t *events_cbs, int *more)
+static zbx_db_event	*hc_defer_item_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *event_name, const char *error)
 {
-	static ZBX_HISTORY_FLOAT	*history_float;
-	static ZBX_HISTORY_INTEGER	*history_integer;
-	static ZBX_HISTORY_STRING	*history_string;
-	static ZBX_HISTORY_TEXT		*history_text;
-	static ZBX_HISTORY_LOG		*history_log;
-	static int			module_enabled = FAIL;
-	int				i, history_num, history_float_num, history_integer_num, history_string_num,
-					history_text_num, history_log_num, txn_error, compression_age,
-					connectors_retrieved = FAIL;
-	unsigned int			item_retrieve_mode;
-	time_t				sync_start;
-	zbx_vector_uint64_t		triggerids ;
-	zbx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values, trigger_timers;
-	zbx_vector_dc_trigger_t		trigger_order;
-	zbx_vector_uint64_pair_t	trends_diff, proxy_subscriptions;
-	zbx_dc_history_t		history[ZBX_HC_SYNC_MAX];
+	zbx_hc_item_event_t	*event;
+
+	ZBX_UNUSED(source);
+	ZBX_UNUSED(object);
+	ZBX_UNUSED(trigger_description);
+	ZBX_UNUSED(trigger_expression);
+	ZBX_UNUSED(trigger_recovery_expression);
+	ZBX_UNUSED(trigger_priority);
+	ZBX_UNUSED(trigger_type);
+	ZBX_UNUSED(trigger_tags);
+	ZBX_UNUSED(trigger_correlation_mode);
+	ZBX_UNUSED(trigger_correlation_tag);
+	ZBX_UNUSED(trigger_value);
+	ZBX_UNUSED(trigger_opdata);
+	ZBX_UNUSED(event_name);
+
+	event = (zbx_hc_item_event_t *)zbx_malloc(NULL, sizeof(zbx_hc_item_event_t));
+	event->itemid = objectid;
+	event->ts = *timespec;
+	event->state = value;
+	event->error = (NULL != error ? zbx_strdup(NULL, error) : NULL);
+
+	zbx_vector_ptr_append(hc_item_events, event);
+
+	return NULL;
+}
+
+static void	hc_add_item_events(const zbx_vector_ptr_t *item_events, zbx_add_event_func_t add_event_cb)
+{
+	int	i;
+
+	if (NULL == add_event_cb)
+		return;
+
+	for (i = 0; i < item_events->values_num; i++)
+	{
+		const zbx_hc_item_event_t	*event = (const zbx_hc_item_event_t *)item_events->values[i];
+
+		add_event_cb(EVENT_SOURCE_INTERNAL, EVENT_OBJECT_ITEM, event->itemid, &event->ts, event->state, NULL,
+				NULL, NULL, 0, 0, NULL, 0, NULL, 0, NULL, NULL, event->error);
+	}
+}
+
+static void	hc_sync_batch_init(zbx_hc_sync_batch_t *batch)
+{
+	batch->history_num = 0;
+	batch->ret = SUCCEED;
+	batch->items = NULL;
+	batch->errcodes = NULL;
+	batch->um_handle = NULL;
+
+	zbx_vector_ptr_create(&batch->history_items);
+	zbx_vector_ptr_reserve(&batch->history_items, ZBX_HC_SYNC_MAX);
+	zbx_vector_uint64_create(&batch->itemids);
+	zbx_vector_uint64_create(&batch->triggerids);
+	zbx_vector_uint64_reserve(&batch->triggerids, ZBX_HC_SYNC_MAX);
+	zbx_vector_ptr_create(&batch->item_diff);
+	zbx_vector_ptr_create(&batch->inventory_values);
+	zbx_vector_uint64_pair_create(&batch->proxy_subscriptions);
+	zbx_vector_ptr_create(&batch->history_values);
+	zbx_vector_ptr_create(&batch->item_events);
+}
+
+static void	hc_sync_batch_destroy(zbx_hc_sync_batch_t *batch)
+{
+	zbx_free(batch->items);
+	zbx_free(batch->errcodes);
+
+	zbx_vector_ptr_destroy(&batch->history_items);
+	zbx_vector_uint64_destroy(&batch->itemids);
+	zbx_vector_uint64_destroy(&batch->triggerids);
+	zbx_vector_ptr_destroy(&batch->item_diff);
+	zbx_vector_ptr_destroy(&batch->inventory_values);
+	zbx_vector_uint64_pair_destroy(&batch->proxy_subscriptions);
+	zbx_vector_ptr_destroy(&batch->history_values);
+	zbx_vector_ptr_destroy(&batch->item_events);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes batch history to history storage, executed by history      *
+ *          writer thread                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_batch_write(void *data)
+{
+	zbx_hc_sync_batch_t	*batch = (zbx_hc_sync_batch_t *)data;
+
+	batch->ret = DBmass_add_history(batch->history, batch->history_num, &batch->history_values,
+			history_add_values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flush history cache to database, process triggers of flushed      *
+ *          and timer triggers from timer queue                               *
+ *                                                                            *
+ * Parameters:                                                                *
+ *             values_num   - [IN/OUT] the number of synced values            *
+ *             triggers_num - [IN/OUT] the number of processed timers         *
+ *             events_cbs   - [IN]                                            *
+ *             more         - [OUT] a flag indicating the cache emptiness:    *
+ *                               ZBX_SYNC_DONE - nothing to sync, go idle     *
+ *                               ZBX_SYNC_MORE - more data to sync            *
+ *                                                                            *
+ * Comments: This function loops syncing history values by 1k batches and     *
+ *           processing timer triggers by batches of 500 triggers.            *
+ *           Unless full sync is being done the loop is aborted if either     *
+ *           timeout has passed or there are no more data to process.         *
+ *           The last is assumed when the following is true:                  *
+ *            a) history cache is empty or less than 10% of batch values were *
+ *               processed (the other items were locked by triggers)          *
+ *            b) less than 500 (full batch) timer triggers were processed     *
+ *                                                                            *
+ *           When history writer thread is started the history of the next    *
+ *           batch is written by writer thread while triggers of the current  *
+ *           batch are processed. Triggers are processed only after history   *
+ *           of their batch is written and added to value cache. The items    *
+ *           and triggers of the batch being written stay locked, so they     *
+ *           cannot be selected into the batch being processed and the write  *
+ *           order of item values is preserved.                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_events_funcs_t *events_cbs, int *more)
+{
+	static ZBX_HISTORY_FLOAT	*history_float;
+	static ZBX_HISTORY_INTEGER	*history_integer;
+	static ZBX_HISTORY_STRING	*history_string;
+	static ZBX_HISTORY_TEXT		*history_text;
+	static ZBX_HISTORY_LOG		*history_log;
+	static int			module_enabled = FAIL;
+	int				i, history_float_num, history_integer_num, history_string_num,
+					history_text_num, history_log_num, txn_error, compression_age,
+					connectors_retrieved = FAIL, pipeline, draining = 0;
+	unsigned int			item_retrieve_mode;
+	time_t				sync_start;
+	zbx_vector_ptr_t		trigger_diff, trigger_timers;
+	zbx_vector_dc_trigger_t		trigger_order;
+	zbx_vector_uint64_pair_t	trends_diff;
 	zbx_uint64_t			trigger_itemids[ZBX_HC_SYNC_MAX];
 	zbx_timespec_t			trigger_timespecs[ZBX_HC_SYNC_MAX];
-	zbx_history_sync_item_t		*items = NULL;
-	int				*errcodes = NULL;
-	zbx_vector_uint64_t		itemids;
 	zbx_hashset_t			trigger_info;
 	unsigned char			*data = NULL;
 	size_t				data_alloc = 0, data_offset;
 	zbx_vector_connector_filter_t	connector_filters_history, connector_filters_events;
+	zbx_hc_sync_batch_t		batches[2], *batch, *next;
 
 	if (NULL == history_float && NULL != history_float_cbs)
 	{
@@ -2975,57 +3100,59 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 	zbx_vector_connector_filter_create(&connector_filters_history);
 	zbx_vector_connector_filter_create(&connector_filters_events);
-	zbx_vector_ptr_create(&inventory_values);
-	zbx_vector_ptr_create(&item_diff);
 	zbx_vector_ptr_create(&trigger_diff);
 	zbx_vector_uint64_pair_create(&trends_diff);
-	zbx_vector_uint64_pair_create(&proxy_subscriptions);
-
-	zbx_vector_uint64_create(&triggerids);
-	zbx_vector_uint64_reserve(&triggerids, ZBX_HC_SYNC_MAX);
 
 	zbx_vector_ptr_create(&trigger_timers);
 	zbx_vector_ptr_reserve(&trigger_timers, ZBX_HC_TIMER_MAX);
 
-	zbx_vector_ptr_create(&history_items);
-	zbx_vector_ptr_reserve(&history_items, ZBX_HC_SYNC_MAX);
-
 	zbx_vector_dc_trigger_create(&trigger_order);
 	zbx_hashset_create(&trigger_info, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	zbx_vector_uint64_create(&itemids);
+	pipeline = hc_writer_started();
+
+	/* without writer thread the same batch is written and processed */
+	hc_sync_batch_init(&batches[0]);
+	next = &batches[0];
+
+	if (SUCCEED == pipeline)
+	{
+		hc_sync_batch_init(&batches[1]);
+		batch = &batches[1];
+	}
+	else
+		batch = next;
 
 	sync_start = time(NULL);
 
 	item_retrieve_mode = 0 == zbx_has_export_dir() ? ZBX_ITEM_GET_SYNC : ZBX_ITEM_GET_SYNC_EXPORT;
 
-	do
+	for (;;)
 	{
-		int			trends_num = 0, timers_num = 0, ret = SUCCEED;
+		int			trends_num = 0, timers_num = 0;
 		ZBX_DC_TREND		*trends = NULL;
 
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
-
-		if (0 != history_items.values_num)
+		/* select and take items out of history cache, unless the last written batch is being processed */
+		if (0 == draining)
 		{
-			if (0 == (history_num = zbx_dc_config_lock_triggers_by_history_items(&history_items, &triggerids)))
+			hc_pop_items(&next->history_items);
+
+			if (0 != next->history_items.values_num)
 			{
-				LOCK_CACHE;
-				hc_push_items(&history_items);
-				UNLOCK_CACHE;
-				zbx_vector_ptr_clear(&history_items);
+				if (0 == (next->history_num = zbx_dc_config_lock_triggers_by_history_items(
+						&next->history_items, &next->triggerids)))
+				{
+					hc_push_items(&next->history_items);
+					zbx_vector_ptr_clear(&next->history_items);
+				}
 			}
 		}
-		else
-			history_num = 0;
 
-		if (0 != history_num)
+		if (0 != next->history_num)
 		{
-			zbx_dc_um_handle_t	*um_handle;
+			zbx_add_event_func_t	add_event_cb;
 
 			if (FAIL == connectors_retrieved)
 			{
@@ -3038,36 +3165,68 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 					item_retrieve_mode = ZBX_ITEM_GET_SYNC_EXPORT;
 			}
 
-			zbx_vector_ptr_sort(&history_items, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
-			hc_get_item_values(history, &history_items);	/* copy item data from history cache */
+			zbx_vector_ptr_sort(&next->history_items, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
 
-			if (NULL == items)
+			/* copy item data from history cache */
+			hc_get_item_values(next->history, &next->history_items);
+
+			if (NULL == next->items)
 			{
-				items = (zbx_history_sync_item_t *)zbx_malloc(NULL, sizeof(zbx_history_sync_item_t) *
-						(size_t)ZBX_HC_SYNC_MAX);
+				next->items = (zbx_history_sync_item_t *)zbx_malloc(NULL,
+						sizeof(zbx_history_sync_item_t) * (size_t)ZBX_HC_SYNC_MAX);
 			}
 
-			if (NULL == errcodes)
-				errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)ZBX_HC_SYNC_MAX);
+			if (NULL == next->errcodes)
+				next->errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)ZBX_HC_SYNC_MAX);
+
+			zbx_vector_uint64_reserve(&next->itemids, next->history_num);
 
-			zbx_vector_uint64_reserve(&itemids, history_num);
+			for (i = 0; i < next->history_num; i++)
+				zbx_vector_uint64_append(&next->itemids, next->history[i].itemid);
 
-			for (i = 0; i < history_num; i++)
-				zbx_vector_uint64_append(&itemids, history[i].itemid);
+			zbx_dc_config_history_sync_get_items_by_itemids(next->items, next->itemids.values,
+					next->errcodes, (size_t)next->history_num, item_retrieve_mode);
 
-			zbx_dc_config_history_sync_get_items_by_itemids(items, itemids.values, errcodes,
-					(size_t)history_num, item_retrieve_mode);
+			next->um_handle = zbx_dc_open_user_macros();
 
-			um_handle = zbx_dc_open_user_macros();
+			if (SUCCEED == pipeline)
+			{
+				hc_item_events = &next->item_events;
+				add_event_cb = hc_defer_item_event;
+			}
+			else
+				add_event_cb = events_cbs->add_event_cb;
 
-			DCmass_prepare_history(history, items, errcodes, history_num,
-					events_cbs->add_event_cb, &item_diff,
-					&inventory_values, compression_age, &proxy_subscriptions);
+			DCmass_prepare_history(next->history, next->items, next->errcodes, next->history_num,
+					add_event_cb, &next->item_diff, &next->inventory_values, compression_age,
+					&next->proxy_subscriptions);
 
-			if (FAIL != (ret = DBmass_add_history(history, history_num)))
+			if (SUCCEED == pipeline)
 			{
-				zbx_dc_config_items_apply_changes(&item_diff);
-				DCmass_update_trends(history, history_num, &trends, &trends_num, compression_age);
+				hc_writer_submit(hc_sync_batch_write, next);
+			}
+			else
+			{
+				next->ret = DBmass_add_history(next->history, next->history_num, &next->history_values,
+						zbx_vc_add_values);
+			}
+		}
+
+		if (0 != batch->history_num)
+		{
+			if (SUCCEED == pipeline && SUCCEED == batch->ret)
+				zbx_vc_cache_values(&batch->history_values);
+
+			zbx_vps_monitor_add_written((zbx_uint64_t)batch->history_values.values_num);
+			zbx_vector_ptr_clear(&batch->history_values);
+
+			if (FAIL != batch->ret)
+			{
+				hc_add_item_events(&batch->item_events, events_cbs->add_event_cb);
+
+				zbx_dc_config_items_apply_changes(&batch->item_diff);
+				DCmass_update_trends(batch->history, batch->history_num, &trends, &trends_num,
+						compression_age);
 
 				if (0 != trends_num)
 					zbx_tfc_invalidate_trends(trends, trends_num);
@@ -3076,7 +3235,7 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				{
 					zbx_db_begin();
 
-					DBmass_update_items(&item_diff, &inventory_values);
+					DBmass_update_items(&batch->item_diff, &batch->inventory_values);
 					DBmass_update_trends(trends, trends_num, &trends_diff);
 
 					if (NULL != events_cbs->process_events_cb)
@@ -3099,16 +3258,17 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				while (ZBX_DB_DOWN == txn_error);
 			}
 
-			zbx_dc_close_user_macros(um_handle);
+			zbx_dc_close_user_macros(batch->um_handle);
 
 			if (NULL != events_cbs->clean_events_cb)
 				events_cbs->clean_events_cb();
 
-			zbx_vector_ptr_clear_ext(&inventory_values, (zbx_clean_func_t)DCinventory_value_free);
-			zbx_vector_ptr_clear_ext(&item_diff, (zbx_clean_func_t)zbx_ptr_free);
+			zbx_vector_ptr_clear_ext(&batch->item_events, (zbx_clean_func_t)hc_item_event_free);
+			zbx_vector_ptr_clear_ext(&batch->inventory_values, (zbx_clean_func_t)DCinventory_value_free);
+			zbx_vector_ptr_clear_ext(&batch->item_diff, (zbx_clean_func_t)zbx_ptr_free);
 		}
 
-		if (FAIL != ret)
+		if (FAIL != batch->ret)
 		{
 			/* don't process trigger timers when server is shutting down */
 			if (ZBX_IS_RUNNING())
@@ -3122,29 +3282,29 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 			if (ZBX_HC_TIMER_SOFT_MAX <= timers_num)
 				*more = ZBX_SYNC_MORE;
 
-			if (0 != history_num || 0 != timers_num)
+			if (0 != batch->history_num || 0 != timers_num)
 			{
 				for (i = 0; i < trigger_timers.values_num; i++)
 				{
 					zbx_trigger_timer_t	*timer = (zbx_trigger_timer_t *)trigger_timers.values[i];
 
 					if (0 != timer->lock)
-						zbx_vector_uint64_append(&triggerids, timer->triggerid);
+						zbx_vector_uint64_append(&batch->triggerids, timer->triggerid);
 				}
 
 				do
 				{
 					zbx_db_begin();
 
-					recalculate_triggers(history, history_num, &itemids, items, errcodes,
-							&trigger_timers, events_cbs->add_event_cb, &trigger_diff,
-							trigger_itemids,
+					recalculate_triggers(batch->history, batch->history_num, &batch->itemids,
+							batch->items, batch->errcodes, &trigger_timers,
+							events_cbs->add_event_cb, &trigger_diff, trigger_itemids,
 							trigger_timespecs, &trigger_info, &trigger_order);
 
 					if (NULL != events_cbs->process_events_cb)
 					{
 						/* process trigger events generated by recalculate_triggers() */
-						events_cbs->process_events_cb(&trigger_diff, &triggerids);
+						events_cbs->process_events_cb(&trigger_diff, &batch->triggerids);
 					}
 
 					if (0 != trigger_diff.values_num)
@@ -3165,11 +3325,11 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 			}
 		}
 
-		if (0 != triggerids.values_num)
+		if (0 != batch->triggerids.values_num)
 		{
-			*triggers_num += triggerids.values_num;
-			zbx_dc_config_unlock_triggers(&triggerids);
-			zbx_vector_uint64_clear(&triggerids);
+			*triggers_num += batch->triggerids.values_num;
+			zbx_dc_config_unlock_triggers(&batch->triggerids);
+			zbx_vector_uint64_clear(&batch->triggerids);
 		}
 
 		if (0 != trigger_timers.values_num)
@@ -3178,18 +3338,16 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 			zbx_vector_ptr_clear(&trigger_timers);
 		}
 
-		if (0 != proxy_subscriptions.values_num)
+		if (0 != batch->proxy_subscriptions.values_num)
 		{
-			zbx_vector_uint64_pair_sort(&proxy_subscriptions, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-			zbx_dc_proxy_update_nodata(&proxy_subscriptions);
-			zbx_vector_uint64_pair_clear(&proxy_subscriptions);
+			zbx_vector_uint64_pair_sort(&batch->proxy_subscriptions, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_dc_proxy_update_nodata(&batch->proxy_subscriptions);
+			zbx_vector_uint64_pair_clear(&batch->proxy_subscriptions);
 		}
 
-		if (0 != history_num)
+		if (0 != batch->history_num)
 		{
-			LOCK_CACHE;
-			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
+			hc_push_items(&batch->history_items);	/* return items to history cache */
 
 			if (0 != hc_queue_get_size())
 			{
@@ -3198,20 +3356,18 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				/* Otherwise better to wait a bit for other syncers to unlock      */
 				/* items rather than trying and failing to sync locked items over  */
 				/* and over again.                                                 */
-				if (ZBX_HC_SYNC_MIN_PCNT <= history_num * 100 / history_items.values_num)
+				if (ZBX_HC_SYNC_MIN_PCNT <= batch->history_num * 100 / batch->history_items.values_num)
 					*more = ZBX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
-
-			*values_num += history_num;
+			*values_num += batch->history_num;
 		}
 
-		if (FAIL != ret)
+		if (FAIL != batch->ret)
 		{
 			int	event_export_enabled = FAIL;
 
-			if (0 != history_num)
+			if (0 != batch->history_num)
 			{
 				const zbx_dc_history_t	*phistory = NULL;
 				const ZBX_DC_TREND	*ptrends = NULL;
@@ -3220,10 +3376,10 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 				if (SUCCEED == module_enabled)
 				{
-					DCmodule_prepare_history(history, history_num, history_float, &history_float_num,
-							history_integer, &history_integer_num, history_string,
-							&history_string_num, history_text, &history_text_num, history_log,
-							&history_log_num);
+					DCmodule_prepare_history(batch->history, batch->history_num, history_float,
+							&history_float_num, history_integer, &history_integer_num,
+							history_string, &history_string_num, history_text,
+							&history_text_num, history_log, &history_log_num);
 
 					DCmodule_sync_history(history_float_num, history_integer_num, history_string_num,
 							history_text_num, history_log_num, history_float,
@@ -3234,8 +3390,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 						zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_HISTORY)) ||
 						0 != connector_filters_history.values_num)
 				{
-					phistory = history;
-					history_num_loc = history_num;
+					phistory = batch->history;
+					history_num_loc = batch->history_num;
 				}
 
 				if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_TRENDS))
@@ -3247,8 +3403,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				if (NULL != phistory || NULL != ptrends)
 				{
 					data_offset = 0;
-					DCexport_history_and_trends(phistory, history_num_loc, &itemids, items,
-							errcodes, ptrends, trends_num_loc, history_export_enabled,
+					DCexport_history_and_trends(phistory, history_num_loc, &batch->itemids, batch->items,
+							batch->errcodes, ptrends, trends_num_loc, history_export_enabled,
 							&connector_filters_history, &data, &data_alloc, &data_offset);
 
 					if (0 != data_offset)
@@ -3290,32 +3446,59 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 			}
 		}
 
-		if (0 != history_num || 0 != timers_num)
+		if (0 != batch->history_num || 0 != timers_num)
 		{
 			if (NULL != events_cbs->clean_events_cb)
 				events_cbs->clean_events_cb();
 		}
 
-		if (0 != history_num)
+		if (0 != batch->history_num)
 		{
 			zbx_free(trends);
-			zbx_dc_config_clean_history_sync_items(items, errcodes, (size_t)history_num);
+			zbx_dc_config_clean_history_sync_items(batch->items, batch->errcodes, (size_t)batch->history_num);
 
-			zbx_vector_ptr_clear(&history_items);
-			hc_free_item_values(history, history_num);
+			zbx_vector_ptr_clear(&batch->history_items);
+			hc_free_item_values(batch->history, batch->history_num);
+			batch->history_num = 0;
 		}
 
-		zbx_vector_uint64_clear(&itemids);
+		zbx_vector_uint64_clear(&batch->itemids);
+		batch->ret = SUCCEED;
+
+		if (SUCCEED == pipeline)
+		{
+			zbx_hc_sync_batch_t	*written = next;
+
+			/* wait for the next batch history to be written before processing it */
+			if (0 != next->history_num)
+				hc_writer_wait();
+
+			next = batch;
+			batch = written;
+		}
 
 		/* Exit from sync loop if we have spent too much time here.       */
 		/* This is done to allow syncer process to update its statistics. */
+		if (ZBX_SYNC_MORE == *more && ZBX_HC_SYNC_TIME_MAX >= time(NULL) - sync_start)
+		{
+			draining = 0;
+			continue;
+		}
+
+		/* process the last written batch before leaving */
+		if (0 == batch->history_num)
+			break;
+
+		draining = 1;
 	}
-	while (ZBX_SYNC_MORE == *more && ZBX_HC_SYNC_TIME_MAX >= time(NULL) - sync_start);
 
-	zbx_free(items);
-	zbx_free(errcodes);
 	zbx_free(data);
 
+	hc_sync_batch_destroy(&batches[0]);
+
+	if (SUCCEED == pipeline)
+		hc_sync_batch_destroy(&batches[1]);
+
 	zbx_vector_connector_filter_clear_ext(&connector_filters_events, zbx_connector_filter_free);
 	zbx_vector_connector_filter_clear_ext(&connector_filters_history, zbx_connector_filter_free);
 	zbx_vector_connector_filter_destroy(&connector_filters_events);
@@ -3323,16 +3506,10 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 	zbx_vector_dc_trigger_destroy(&trigger_order);
 	zbx_hashset_destroy(&trigger_info);
 
-	zbx_vector_uint64_destroy(&itemids);
-	zbx_vector_ptr_destroy(&history_items);
-	zbx_vector_ptr_destroy(&inventory_values);
-	zbx_vector_ptr_destroy(&item_diff);
 	zbx_vector_ptr_destroy(&trigger_diff);
 	zbx_vector_uint64_pair_destroy(&trends_diff);
-	zbx_vector_uint64_pair_destroy(&proxy_subscriptions);
 
 	zbx_vector_ptr_destroy(&trigger_timers);
-	zbx_vector_uint64_destroy(&triggerids);
 }
 
 /******************************************************************************
@@ -3347,12 +3524,12 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
  ******************************************************************************/
 static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queue[ZBX_HC_SHARDS_MAX];
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -3371,18 +3548,24 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 		zbx_dc_config_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard = &cache->shards[i];
 
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+		tmp_history_queue[i] = shard->history_queue;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		zbx_binary_heap_create(&shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(shard, item);
+			}
 		}
 	}
 
@@ -3395,15 +3578,18 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 			sync_history_cb(&values_num, &triggers_num, events_cbs, &more);
 
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
 		while (0 != hc_queue_get_size());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_binary_heap_destroy(&cache->shards[i].history_queue);
+		cache->shards[i].history_queue = tmp_history_queue[i];
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3416,7 +3602,9 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -3431,16 +3619,16 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3472,12 +3660,20 @@ void	zbx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	zbx_sync_history_cache(const zbx_events_funcs_t *events_cbs, int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	*values_num = 0;
 	*triggers_num = 0;
 
 	sync_history_cb(values_num, triggers_num, events_cbs, more);
+
+	if (0 != *values_num)
+	{
+		LOCK_CACHE;
+		zbx_db_insert_stats_collect(cache->insert_stats);
+		hc_writer_stats_collect(cache->insert_stats);
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -3995,14 +4191,8 @@ void	zbx_dc_flush_history(void)
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
-
 	hc_add_item_values(item_values, item_values_num);
 
-	cache->history_num += item_values_num;
-
-	UNLOCK_CACHE;
-
 	zbx_vps_monitor_add_collected((zbx_uint64_t)item_values_num);
 
 	item_values_num = 0;
@@ -4014,8 +4204,120 @@ void	zbx_dc_flush_history(void)
  * history cache storage                                                      *
  *                                                                            *
  ******************************************************************************/
-ZBX_SHMEM_FUNC_IMPL(__hc_index, hc_index_mem)
-ZBX_SHMEM_FUNC_IMPL(__hc, hc_mem)
+ZBX_SHMEM_FUNC_IMPL(__hc_header, hc_header_mem)
+
+/* History index hashset and queue of a shard are allocated in shard index memory. As allocator callbacks */
+/* have no context, a set of callbacks is defined for every possible shard.                               */
+#define HC_INDEX_SHMEM_FUNC_IMPL(index)	ZBX_SHMEM_FUNC_IMPL(__hc_index ## index, hc_shard_index_mem[index])
+#define HC_INDEX_SHMEM_FUNCS(index)								\
+	{__hc_index ## index ## _shmem_malloc_func, __hc_index ## index ## _shmem_realloc_func,	\
+	__hc_index ## index ## _shmem_free_func}
+
+HC_INDEX_SHMEM_FUNC_IMPL(0)
+HC_INDEX_SHMEM_FUNC_IMPL(1)
+HC_INDEX_SHMEM_FUNC_IMPL(2)
+HC_INDEX_SHMEM_FUNC_IMPL(3)
+HC_INDEX_SHMEM_FUNC_IMPL(4)
+HC_INDEX_SHMEM_FUNC_IMPL(5)
+HC_INDEX_SHMEM_FUNC_IMPL(6)
+HC_INDEX_SHMEM_FUNC_IMPL(7)
+HC_INDEX_SHMEM_FUNC_IMPL(8)
+HC_INDEX_SHMEM_FUNC_IMPL(9)
+HC_INDEX_SHMEM_FUNC_IMPL(10)
+HC_INDEX_SHMEM_FUNC_IMPL(11)
+HC_INDEX_SHMEM_FUNC_IMPL(12)
+HC_INDEX_SHMEM_FUNC_IMPL(13)
+HC_INDEX_SHMEM_FUNC_IMPL(14)
+HC_INDEX_SHMEM_FUNC_IMPL(15)
+
+typedef struct
+{
+	zbx_mem_malloc_func_t	malloc_func;
+	zbx_mem_realloc_func_t	realloc_func;
+	zbx_mem_free_func_t	free_func;
+}
+zbx_hc_index_shmem_funcs_t;
+
+static const zbx_hc_index_shmem_funcs_t	hc_index_shmem_funcs[ZBX_HC_SHARDS_MAX] = {
+	HC_INDEX_SHMEM_FUNCS(0), HC_INDEX_SHMEM_FUNCS(1), HC_INDEX_SHMEM_FUNCS(2), HC_INDEX_SHMEM_FUNCS(3),
+	HC_INDEX_SHMEM_FUNCS(4), HC_INDEX_SHMEM_FUNCS(5), HC_INDEX_SHMEM_FUNCS(6), HC_INDEX_SHMEM_FUNCS(7),
+	HC_INDEX_SHMEM_FUNCS(8), HC_INDEX_SHMEM_FUNCS(9), HC_INDEX_SHMEM_FUNCS(10), HC_INDEX_SHMEM_FUNCS(11),
+	HC_INDEX_SHMEM_FUNCS(12), HC_INDEX_SHMEM_FUNCS(13), HC_INDEX_SHMEM_FUNCS(14), HC_INDEX_SHMEM_FUNCS(15)
+};
+
+#undef HC_INDEX_SHMEM_FUNCS
+#undef HC_INDEX_SHMEM_FUNC_IMPL
+
+/* history data of a shard is allocated in shard data memory */
+#define hc_shard_malloc(shard, size)		zbx_shmem_malloc(hc_shard_mem[(shard)->index], NULL, size)
+#define hc_shard_free(shard, ptr)		zbx_shmem_free(hc_shard_mem[(shard)->index], ptr)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns index of the history cache shard the item belongs to      *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_shard_index(zbx_uint64_t itemid)
+{
+	if (1 == cache->shards_num)
+		return 0;
+
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % (zbx_hash_t)cache->shards_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locks history cache shard                                         *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ * Return value: the locked shard                                             *
+ *                                                                            *
+ * Comments: The lock wait time is measured only when the shard is locked by  *
+ *           other process, to keep uncontended locking cheap.                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hc_shard_t	*hc_shard_lock(int index)
+{
+	zbx_hc_shard_t	*shard = &cache->shards[index];
+
+	if (SUCCEED != zbx_mutex_trylock(hc_shard_locks[index]))
+	{
+		double	time_start;
+
+		time_start = zbx_time();
+		zbx_mutex_lock(hc_shard_locks[index]);
+		shard->lock_wait += zbx_time() - time_start;
+	}
+
+	shard->lock_num++;
+
+	return shard;
+}
+
+static void	hc_shard_unlock(const zbx_hc_shard_t *shard)
+{
+	zbx_mutex_unlock(hc_shard_locks[shard->index]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the number of values in history cache                     *
+ *                                                                            *
+ * Comments: The shards are not locked - the result is used for logging and   *
+ *           progress estimation only, where a slightly outdated value is     *
+ *           acceptable.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < cache->shards_num; i++)
+		history_num += cache->shards[i].history_num;
+
+	return history_num;
+}
 
 /******************************************************************************
  *                                                                            *
@@ -4038,14 +4340,15 @@ static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
  *                                                                            *
  * Purpose: free history item data allocated in history cache                 *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: shard - [IN] the shard owning the data                         *
+ *             data  - [IN] history item data                                 *
  *                                                                            *
  ******************************************************************************/
-static void	hc_free_data(zbx_hc_data_t *data)
+static void	hc_free_data(const zbx_hc_shard_t *shard, zbx_hc_data_t *data)
 {
 	if (ITEM_STATE_NOTSUPPORTED == data->state)
 	{
-		__hc_shmem_free_func(data->value.str);
+		hc_shard_free(shard, data->value.str);
 	}
 	else
 	{
@@ -4056,15 +4359,15 @@ static void	hc_free_data(zbx_hc_data_t *data)
 				case ITEM_VALUE_TYPE_STR:
 				case ITEM_VALUE_TYPE_TEXT:
 				case ITEM_VALUE_TYPE_BIN:
-					__hc_shmem_free_func(data->value.str);
+					hc_shard_free(shard, data->value.str);
 					break;
 				case ITEM_VALUE_TYPE_LOG:
-					__hc_shmem_free_func(data->value.log->value);
+					hc_shard_free(shard, data->value.log->value);
 
 					if (NULL != data->value.log->source)
-						__hc_shmem_free_func(data->value.log->source);
+						hc_shard_free(shard, data->value.log->source);
 
-					__hc_shmem_free_func(data->value.log);
+					hc_shard_free(shard, data->value.log);
 					break;
 				case ITEM_VALUE_TYPE_UINT64:
 				case ITEM_VALUE_TYPE_FLOAT:
@@ -4077,69 +4380,73 @@ static void	hc_free_data(zbx_hc_data_t *data)
 		}
 	}
 
-	__hc_shmem_free_func(data);
+	hc_shard_free(shard, data);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: put back item into history queue                                  *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: shard - [IN] the shard owning the item                         *
+ *             item  - [IN] history item                                      *
  *                                                                            *
  ******************************************************************************/
-static void	hc_queue_item(zbx_hc_item_t *item)
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&shard->history_queue, &elem);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: returns history item by itemid                                    *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
+ * Parameters: shard  - [IN] the shard owning the item                        *
+ *             itemid - [IN] the item id                                      *
  *                                                                            *
  * Return value: the history item or NULL if the requested item is not in     *
  *               history cache                                                *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
+static zbx_hc_item_t	*hc_get_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&shard->history_items, &itemid);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: adds a new item to history cache                                  *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
- *                      [IN] the item data                                    *
+ * Parameters: shard  - [IN] the shard to add item to                         *
+ *             itemid - [IN] the item id                                      *
+ *             data   - [IN] the item data                                    *
  *                                                                            *
  * Return value: the added history item                                       *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
+static zbx_hc_item_t	*hc_add_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: shard - [IN] the shard to copy value to                        *
+ *             str   - [IN] the string value                                  *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(const zbx_hc_shard_t *shard, const dc_value_str_t *str)
 {
 	char	*ptr;
 
-	if (NULL == (ptr = (char *)__hc_shmem_malloc_func(NULL, str->len)))
+	if (NULL == (ptr = (char *)hc_shard_malloc(shard, str->len)))
 		return NULL;
 
 	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
@@ -4152,8 +4459,9 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
- *             str - [IN] the string value to clone                           *
+ * Parameters: shard - [IN] the shard to clone value to                       *
+ *             dst   - [IN/OUT] a reference to the cloned value               *
+ *             str   - [IN] the string value to clone                         *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
  *                         (it was empty or already cloned) or the string was *
@@ -4164,7 +4472,7 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(const zbx_hc_shard_t *shard, char **dst, const dc_value_str_t *str)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -4172,7 +4480,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(shard, str)))
 		return SUCCEED;
 
 	return FAIL;
@@ -4182,7 +4490,8 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones log value into history data memory                         *
  *                                                                            *
- * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
+ * Parameters: shard      - [IN] the shard to clone value to                  *
+ *             dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
@@ -4192,21 +4501,21 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(const zbx_hc_shard_t *shard, zbx_log_value_t **dst,
+		const dc_item_value_t *item_value)
 {
 	if (NULL == *dst)
 	{
-		/* using realloc instead of malloc just to suppress 'not used' warning for realloc */
-		if (NULL == (*dst = (zbx_log_value_t *)__hc_shmem_realloc_func(NULL, sizeof(zbx_log_value_t))))
+		if (NULL == (*dst = (zbx_log_value_t *)hc_shard_malloc(shard, sizeof(zbx_log_value_t))))
 			return FAIL;
 
 		memset(*dst, 0, sizeof(zbx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(shard, &(*dst)->value, &item_value->value.value_str))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(shard, &(*dst)->source, &item_value->source))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -4220,7 +4529,8 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Purpose: clones item value from local cache into history cache             *
  *                                                                            *
- * Parameters: data       - [IN/OUT] a reference to the cloned value          *
+ * Parameters: shard      - [IN] the shard to clone value to                  *
+ *             data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
@@ -4230,11 +4540,11 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_hc_shard_t *shard, zbx_hc_data_t **data, const dc_item_value_t *item_value)
 {
 	if (NULL == *data)
 	{
-		if (NULL == (*data = (zbx_hc_data_t *)__hc_shmem_malloc_func(NULL, sizeof(zbx_hc_data_t))))
+		if (NULL == (*data = (zbx_hc_data_t *)hc_shard_malloc(shard, sizeof(zbx_hc_data_t))))
 			return FAIL;
 
 		memset(*data, 0, sizeof(zbx_hc_data_t));
@@ -4252,24 +4562,24 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(shard, &item_value->value.value_str)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		shard->stats.notsupported_counter++;
 
 		return SUCCEED;
 	}
 
 	if (0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(shard, &item_value->value.value_str)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		shard->stats.history_text_counter++;
+		shard->stats.history_counter++;
 
 		return SUCCEED;
 	}
@@ -4287,14 +4597,14 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 			case ITEM_VALUE_TYPE_STR:
 			case ITEM_VALUE_TYPE_TEXT:
 			case ITEM_VALUE_TYPE_BIN:
-				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
+				if (SUCCEED != hc_clone_history_str_data(shard, &(*data)->value.str,
 						&item_value->value.value_str))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(shard, &(*data)->value.log, item_value))
 					return FAIL;
 				break;
 			case ITEM_VALUE_TYPE_NONE:
@@ -4306,22 +4616,22 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				shard->stats.history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				shard->stats.history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				shard->stats.history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				shard->stats.history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				shard->stats.history_log_counter++;
 				break;
 			case ITEM_VALUE_TYPE_BIN:
-				cache->stats.history_bin_counter++;
+				shard->stats.history_bin_counter++;
 				break;
 			case ITEM_VALUE_TYPE_NONE:
 			default:
@@ -4329,7 +4639,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				exit(EXIT_FAILURE);
 		}
 
-		cache->stats.history_counter++;
+		shard->stats.history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -4339,31 +4649,44 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
+ * Purpose: adds item values belonging to the specified shard to the history  *
+ *          cache                                                             *
  *                                                                            *
  * Parameters: values     - [IN] the item values to add                       *
  *             values_num - [IN] the number of item values to add             *
+ *             shards     - [IN] the shard indexes of item values             *
+ *             index      - [IN] the index of shard to add values to          *
  *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
+ * Return value: the number of added values                                   *
+ *                                                                            *
+ * Comments: If the history cache shard is full this function will wait until *
  *           history syncers processes values freeing enough space to store   *
  *           the new value.                                                   *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static int	hc_add_shard_item_values(dc_item_value_t *values, int values_num, const unsigned char *shards,
+		int index)
 {
 	dc_item_value_t	*item_value;
-	int		i;
+	int		i, added_num = 0;
 	zbx_hc_item_t	*item;
+	zbx_hc_shard_t	*shard;
+
+	shard = hc_shard_lock(index);
 
 	for (i = 0; i < values_num; i++)
 	{
 		zbx_hc_data_t	*data = NULL;
 
+		if (index != shards[i])
+			continue;
+
+		added_num++;
 		item_value = &values[i];
 
 		/* a record with metadata and no value can be dropped if  */
 		/* the metadata update is copied to the last queued value */
-		if (NULL != (item = hc_get_item(item_value->itemid)) &&
+		if (NULL != (item = hc_get_item(shard, item_value->itemid)) &&
 				0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE) &&
 				0 != (item_value->flags & ZBX_DC_FLAG_META))
 		{
@@ -4378,26 +4701,26 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 			}
 		}
 
-		if (SUCCEED != hc_clone_history_data(&data, item_value))
+		if (SUCCEED != hc_clone_history_data(shard, &data, item_value))
 		{
 			do
 			{
-				UNLOCK_CACHE;
+				hc_shard_unlock(shard);
 
 				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
 				sleep(1);
 
-				LOCK_CACHE;
+				shard = hc_shard_lock(index);
 			}
-			while (SUCCEED != hc_clone_history_data(&data, item_value));
+			while (SUCCEED != hc_clone_history_data(shard, &data, item_value));
 
-			item = hc_get_item(item_value->itemid);
+			item = hc_get_item(shard, item_value->itemid);
 		}
 
 		if (NULL == item)
 		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
+			item = hc_add_item(shard, item_value->itemid, data);
+			hc_queue_item(shard, item);
 		}
 		else
 		{
@@ -4405,6 +4728,42 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 			item->head = data;
 		}
 		item->values_num++;
+		shard->history_num++;
+	}
+
+	hc_shard_unlock(shard);
+
+	return added_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values to the history cache                             *
+ *                                                                            *
+ * Parameters: values     - [IN] the item values to add                       *
+ *             values_num - [IN] the number of item values to add             *
+ *                                                                            *
+ * Comments: Values are added by shards, locking each affected shard once.    *
+ *           Values of the same item always belong to the same shard, so the  *
+ *           value order of each item is preserved.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+{
+	unsigned char	shards[ZBX_MAX_VALUES_LOCAL];
+	int		i, values_left = values_num;
+
+	for (i = 0; i < values_num; i++)
+		shards[i] = (unsigned char)hc_shard_index(values[i].itemid);
+
+	for (i = 0; 0 < values_left; i++)
+	{
+		int	shard = shards[i];
+
+		if (i != 0 && NULL != memchr(shards, shard, (size_t)i))
+			continue;
+
+		values_left -= hc_add_shard_item_values(values, values_num, shards, shard);
 	}
 }
 
@@ -4487,17 +4846,46 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
  ******************************************************************************/
 void	hc_pop_items(zbx_vector_ptr_t *history_items)
 {
+	static int		shard_first;
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
+	zbx_hc_shard_t		*shard;
+	int			i, pass, limit, quota;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	/* first take an equal share of items from each shard, then fill the rest */
+	/* of batch from any shard - starting with a different shard each time   */
+	/* so syncers are spread over the shards                                 */
+	quota = (ZBX_HC_SYNC_MAX + cache->shards_num - 1) / cache->shards_num;
+
+	for (pass = 0; pass < 2 && ZBX_HC_SYNC_MAX > history_items->values_num; pass++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = (zbx_hc_item_t *)elem->data;
-		zbx_vector_ptr_append(history_items, item);
+		for (i = 0; i < cache->shards_num && ZBX_HC_SYNC_MAX > history_items->values_num; i++)
+		{
+			if (0 == pass)
+				limit = MIN(ZBX_HC_SYNC_MAX, history_items->values_num + quota);
+			else
+				limit = ZBX_HC_SYNC_MAX;
+
+			shard = hc_shard_lock((shard_first + i) % cache->shards_num);
+
+			while (limit > history_items->values_num &&
+					FAIL == zbx_binary_heap_empty(&shard->history_queue))
+			{
+				elem = zbx_binary_heap_find_min(&shard->history_queue);
+				item = (zbx_hc_item_t *)elem->data;
+				zbx_vector_ptr_append(history_items, item);
+
+				zbx_binary_heap_remove_min(&shard->history_queue);
+			}
+
+			hc_shard_unlock(shard);
+		}
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
+		if (1 == cache->shards_num)
+			break;
 	}
+
+	shard_first = (shard_first + 1) % cache->shards_num;
 }
 
 /******************************************************************************
@@ -4526,6 +4914,39 @@ void	hc_get_item_values(zbx_dc_history_t *history, zbx_vector_ptr_t *history_ite
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: push back the processed history item into history cache shard     *
+ *                                                                            *
+ * Parameters: shard - [IN] the shard owning the item                         *
+ *             item  - [IN] the processed (available) or busy history item    *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_push_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item)
+{
+	zbx_hc_data_t	*data_free;
+
+	switch (item->status)
+	{
+		case ZBX_HC_ITEM_STATUS_BUSY:
+			/* reset item status before returning it to queue */
+			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+			hc_queue_item(shard, item);
+			break;
+		case ZBX_HC_ITEM_STATUS_NORMAL:
+			item->values_num--;
+			shard->history_num--;
+			data_free = item->tail;
+			item->tail = item->tail->next;
+			hc_free_data(shard, data_free);
+			if (NULL == item->tail)
+				zbx_hashset_remove(&shard->history_items, item);
+			else
+				hc_queue_item(shard, item);
+			break;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: push back the processed history items into history cache          *
@@ -4536,36 +4957,33 @@ void	hc_get_item_values(zbx_dc_history_t *history, zbx_vector_ptr_t *history_ite
  * Comments: This function removes processed value from history cache.        *
  *           If there is no more data for this item, then the item itself is  *
  *           removed from history index.                                      *
+ *           Items are pushed back by shards, locking each affected shard     *
+ *           once.                                                            *
  *                                                                            *
  ******************************************************************************/
 void	hc_push_items(zbx_vector_ptr_t *history_items)
 {
-	int		i;
-	zbx_hc_item_t	*item;
-	zbx_hc_data_t	*data_free;
+	int		i, index;
+	unsigned char	shards[ZBX_HC_SYNC_MAX], *pshard;
+	zbx_hc_shard_t	*shard;
 
 	for (i = 0; i < history_items->values_num; i++)
+		shards[i] = (unsigned char)hc_shard_index(((zbx_hc_item_t *)history_items->values[i])->itemid);
+
+	for (index = 0; index < cache->shards_num; index++)
 	{
-		item = (zbx_hc_item_t *)history_items->values[i];
+		if (NULL == (pshard = (unsigned char *)memchr(shards, index, (size_t)history_items->values_num)))
+			continue;
+
+		shard = hc_shard_lock(index);
 
-		switch (item->status)
+		for (i = (int)(pshard - shards); i < history_items->values_num; i++)
 		{
-			case ZBX_HC_ITEM_STATUS_BUSY:
-				/* reset item status before returning it to queue */
-				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
-				break;
-			case ZBX_HC_ITEM_STATUS_NORMAL:
-				item->values_num--;
-				data_free = item->tail;
-				item->tail = item->tail->next;
-				hc_free_data(data_free);
-				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
-				else
-					hc_queue_item(item);
-				break;
+			if (index == shards[i])
+				hc_push_item(shard, (zbx_hc_item_t *)history_items->values[i]);
 		}
+
+		hc_shard_unlock(shard);
 	}
 }
 
@@ -4573,10 +4991,18 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
  *                                                                            *
  * Purpose: retrieve the size of history queue                                *
  *                                                                            *
+ * Comments: The shards are not locked, the same as with unsharded cache the  *
+ *           result is used only to decide whether to continue syncing.       *
+ *                                                                            *
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0;
+
+	for (i = 0; i < cache->shards_num; i++)
+		size += cache->shards[i].history_queue.elems_num;
+
+	return size;
 }
 
 int	hc_get_history_compression_age(void)
@@ -4653,10 +5079,10 @@ out:
  *                                                                            *
  ******************************************************************************/
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history_sync_f sync_history,
-		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size,zbx_uint64_t *trends_cache_size,
-		char **error)
+		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size, int history_cache_shards,
+		zbx_uint64_t *trends_cache_size, char **error)
 {
-	int	ret;
+	int	ret, i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -4669,45 +5095,94 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history
 		goto out;
 	}
 
-	if (SUCCEED != (ret = zbx_mutex_create(&cache_lock, ZBX_MUTEX_CACHE, error)))
-		goto out;
-
-	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
+	if (ZBX_HC_SHARD_SIZE_MIN > history_cache_size / (zbx_uint64_t)history_cache_shards)
+	{
+		*error = zbx_dsprintf(*error, "\"HistoryCacheSize\" must be at least " ZBX_FS_UI64 " bytes for %d"
+				" history cache shards", ZBX_HC_SHARD_SIZE_MIN * (zbx_uint64_t)history_cache_shards,
+				history_cache_shards);
+		ret = FAIL;
 		goto out;
+	}
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_mem, history_cache_size, "history cache",
-			"HistoryCacheSize", 1, error)))
+	if (ZBX_HC_SHARD_SIZE_MIN > history_index_cache_size / (zbx_uint64_t)history_cache_shards)
 	{
+		*error = zbx_dsprintf(*error, "\"HistoryIndexCacheSize\" must be at least " ZBX_FS_UI64 " bytes for %d"
+				" history cache shards", ZBX_HC_SHARD_SIZE_MIN * (zbx_uint64_t)history_cache_shards,
+				history_cache_shards);
+		ret = FAIL;
 		goto out;
 	}
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_index_mem, history_index_cache_size, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
+	if (SUCCEED != (ret = zbx_mutex_create(&cache_lock, ZBX_MUTEX_CACHE, error)))
+		goto out;
+
+	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
+		goto out;
+
+	/* history cache header has fixed size and is not controlled by any configuration parameter */
+	if (SUCCEED != (ret = zbx_shmem_create(&hc_header_mem, ZBX_HC_HEADER_SIZE, "history cache header", NULL, 0,
+			error)))
 	{
 		goto out;
 	}
 
-	cache = (ZBX_DC_CACHE *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
+	cache = (ZBX_DC_CACHE *)__hc_header_shmem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
 
-	ids = (ZBX_DC_IDS *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
+	ids = (ZBX_DC_IDS *)__hc_header_shmem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+	cache->shards_num = history_cache_shards;
+	cache->shards = (zbx_hc_shard_t *)__hc_header_shmem_malloc_func(NULL,
+			sizeof(zbx_hc_shard_t) * (size_t)history_cache_shards);
+	memset(cache->shards, 0, sizeof(zbx_hc_shard_t) * (size_t)history_cache_shards);
+
+	/* history data and index memory is split evenly between shards */
+	for (i = 0; i < history_cache_shards; i++)
+	{
+		if (SUCCEED != (ret = zbx_mutex_create(&hc_shard_locks[i], (zbx_mutex_name_t)(ZBX_MUTEX_CACHE_SHARD + i),
+				error)))
+		{
+			goto out;
+		}
 
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_mem[i], history_cache_size / history_cache_shards,
+				"history cache", "HistoryCacheSize", 1, error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_index_mem[i],
+				history_index_cache_size / history_cache_shards, "history index cache",
+				"HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
+
+		/* history values and item index entries are the most frequent allocations */
+		zbx_shmem_add_slab_class(hc_shard_mem[i], sizeof(zbx_hc_data_t));
+		zbx_shmem_add_slab_class(hc_shard_index_mem[i], ZBX_HASHSET_ENTRY_OFFSET + sizeof(zbx_hc_item_t));
+
+		cache->shards[i].index = i;
+
+		zbx_hashset_create_ext(&cache->shards[i].history_items, ZBX_HC_ITEMS_INIT_SIZE,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				hc_index_shmem_funcs[i].malloc_func, hc_index_shmem_funcs[i].realloc_func,
+				hc_index_shmem_funcs[i].free_func);
+
+		zbx_binary_heap_create_ext(&cache->shards[i].history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, hc_index_shmem_funcs[i].malloc_func,
+				hc_index_shmem_funcs[i].realloc_func, hc_index_shmem_funcs[i].free_func);
+	}
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		zbx_hashset_create_ext(&(cache->proxyqueue.index), ZBX_HC_SYNC_MAX,
 			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+			__hc_header_shmem_malloc_func, __hc_header_shmem_realloc_func, __hc_header_shmem_free_func);
 
-		zbx_list_create_ext(&(cache->proxyqueue.list), __hc_index_shmem_malloc_func,
-				__hc_index_shmem_free_func);
+		zbx_list_create_ext(&(cache->proxyqueue.list), __hc_header_shmem_malloc_func,
+				__hc_header_shmem_free_func);
 
 		cache->proxyqueue.state = ZBX_HC_PROXYQUEUE_STATE_NORMAL;
 
@@ -4752,17 +5227,26 @@ static void	DCsync_all(const zbx_events_funcs_t *events_cbs)
  ******************************************************************************/
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (ZBX_SYNC_ALL == sync)
 		DCsync_all(events_cbs);
 
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_shmem_destroy(hc_shard_mem[i]);
+		hc_shard_mem[i] = NULL;
+		zbx_shmem_destroy(hc_shard_index_mem[i]);
+		hc_shard_index_mem[i] = NULL;
+		zbx_mutex_destroy(&hc_shard_locks[i]);
+	}
+
 	cache = NULL;
 
-	zbx_shmem_destroy(hc_mem);
-	hc_mem = NULL;
-	zbx_shmem_destroy(hc_index_mem);
-	hc_index_mem = NULL;
+	zbx_shmem_destroy(hc_header_mem);
+	hc_header_mem = NULL;
 
 	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
@@ -4885,12 +5369,65 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	int	i;
+
+	*values_num = 0;
+	*items_num = 0;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
 
-	UNLOCK_CACHE;
+		shard = hc_shard_lock(i);
+
+		*values_num += (zbx_uint64_t)shard->history_num;
+		*items_num += (zbx_uint64_t)shard->history_items.num_data;
+
+		hc_shard_unlock(shard);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds shared memory allocator statistics of a history cache shard  *
+ *          to the total statistics                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_mem_stats_add(zbx_shmem_stats_t *total, const zbx_shmem_stats_t *stats, int first)
+{
+	int	i;
+
+	if (0 != first)
+	{
+		*total = *stats;
+		return;
+	}
+
+	if (0 != stats->free_chunks)
+	{
+		if (0 == total->free_chunks || total->min_chunk_size > stats->min_chunk_size)
+			total->min_chunk_size = stats->min_chunk_size;
+
+		if (total->max_chunk_size < stats->max_chunk_size)
+			total->max_chunk_size = stats->max_chunk_size;
+	}
+
+	for (i = 0; i < ZBX_SHMEM_BUCKET_COUNT; i++)
+		total->chunks_num[i] += stats->chunks_num[i];
+
+	/* all shards have the same slab classes */
+	for (i = 0; i < stats->slab_classes_num; i++)
+	{
+		total->slab_classes[i].slabs_num += stats->slab_classes[i].slabs_num;
+		total->slab_classes[i].used_num += stats->slab_classes[i].used_num;
+		total->slab_classes[i].free_num += stats->slab_classes[i].free_num;
+	}
+
+	total->free_size += stats->free_size;
+	total->used_size += stats->used_size;
+	total->overhead += stats->overhead;
+	total->free_chunks += stats->free_chunks;
+	total->used_chunks += stats->used_chunks;
 }
 
 /******************************************************************************
@@ -4900,15 +5437,49 @@ void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
  ******************************************************************************/
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index)
 {
-	LOCK_CACHE;
+	int			i;
+	zbx_shmem_stats_t	stats;
 
-	if (NULL != data)
-		zbx_shmem_get_stats(hc_mem, data);
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
 
-	if (NULL != index)
-		zbx_shmem_get_stats(hc_index_mem, index);
+		shard = hc_shard_lock(i);
 
-	UNLOCK_CACHE;
+		if (NULL != data)
+		{
+			zbx_shmem_get_stats(hc_shard_mem[i], &stats);
+			hc_mem_stats_add(data, &stats, 0 == i);
+		}
+
+		if (NULL != index)
+		{
+			zbx_shmem_get_stats(hc_shard_index_mem[i], &stats);
+			hc_mem_stats_add(index, &stats, 0 == i);
+		}
+
+		hc_shard_unlock(shard);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history cache shard statistics                                *
+ *                                                                            *
+ * Parameters: shards - [OUT] the shard statistics, must be able to hold      *
+ *                            ZBX_HC_SHARDS_MAX elements                      *
+ *                                                                            *
+ * Return value: the number of history cache shards                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hc_get_shard_stats(zbx_hc_shard_stats_t *shards)
+{
+	zbx_wcache_info_t	wcache_info;
+
+	zbx_dc_get_stats_all(&wcache_info);
+	memcpy(shards, wcache_info.shards, sizeof(zbx_hc_shard_stats_t) * (size_t)wcache_info.shards_num);
+
+	return wcache_info.shards_num;
 }
 
 /******************************************************************************
@@ -4920,19 +5491,25 @@ void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	LOCK_CACHE;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		shard = hc_shard_lock(i);
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
-	}
+		zbx_vector_uint64_pair_reserve(items, (size_t)(items->values_num + shard->history_items.num_data));
 
-	UNLOCK_CACHE;
+		zbx_hashset_iter_reset(&shard->history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
+
+		hc_shard_unlock(shard);
+	}
 }
 
 /******************************************************************************
@@ -5032,6 +5609,37 @@ static void	zbx_hc_proxyqueue_clear(void)
 	zbx_hashset_clear(&cache->proxyqueue.index);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns memory usage of the most used history cache shard         *
+ *                                                                            *
+ * Return value: the used memory percentage of the most used shard            *
+ *                                                                            *
+ * Comments: Values of an item always go to the same shard, so a single full  *
+ *           shard blocks adding values even if other shards have free space. *
+ *                                                                            *
+ ******************************************************************************/
+static double	hc_get_shards_max_pused(void)
+{
+	double	pused, max_pused = 0;
+	int	i;
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard;
+
+		shard = hc_shard_lock(i);
+		pused = 100 * (double)(hc_shard_mem[i]->total_size - hc_shard_mem[i]->free_size) /
+				hc_shard_mem[i]->total_size;
+		hc_shard_unlock(shard);
+
+		if (pused > max_pused)
+			max_pused = pused;
+	}
+
+	return max_pused;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: check status of a history cache usage, enqueue/dequeue proxy      *
@@ -5050,9 +5658,9 @@ int	zbx_hc_check_proxy(zbx_uint64_t proxyid)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxyid:"ZBX_FS_UI64, __func__, proxyid);
 
-	LOCK_CACHE;
+	hc_pused = hc_get_shards_max_pused();
 
-	hc_pused = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+	LOCK_CACHE;
 
 	if (20 >= hc_pused)
 	{
@@ -5103,23 +5711,3 @@ out:
 
 	return ret;
 }
-
-void	dbcache_lock(void)
-{
-	LOCK_CACHE;
-}
-
-void	dbcache_unlock(void)
-{
-	UNLOCK_CACHE;
-}
-
-void	dbcache_set_history_num(int num)
-{
-	cache->history_num = num;
-}
-
-int	dbcache_get_history_num(void)
-{
-	return cache->history_num;
-}
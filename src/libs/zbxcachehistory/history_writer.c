@@ -0,0 +1,266 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "history_writer.h"
+
+#include "zbxcachehistory.h"
+#include "zbxthreads.h"
+#include "zbxstr.h"
+
+/* history writer thread, used by history syncer to write history of one batch while */
+/* the triggers of the previous batch are being processed                           */
+typedef struct
+{
+	pthread_t		thread;
+	pthread_mutex_t		lock;
+	pthread_cond_t		event;
+
+	/* the submitted write job, reset to NULL when the job is finished */
+	zbx_hc_write_func_t	write_func;
+	void			*data;
+
+	int			stop;
+	int			started;
+
+	/* bulk insert statistics of writer thread */
+	zbx_db_insert_stats_t	insert_stats[ZBX_DB_INSERT_STATS_TABLES_NUM];
+}
+zbx_hc_writer_t;
+
+static zbx_hc_writer_t	writer;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: history writer thread entry                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	*hc_writer_entry(void *args)
+{
+	sigset_t		mask;
+	int			err;
+	zbx_hc_write_func_t	write_func;
+	void			*data;
+
+	ZBX_UNUSED(args);
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGALRM);
+
+	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, NULL)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot block signals: %s", zbx_strerror(err));
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "history writer thread started");
+
+	/* database connection is thread local, so writer has its own connection */
+	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+	pthread_mutex_lock(&writer.lock);
+
+	for (;;)
+	{
+		while (NULL == writer.write_func && 0 == writer.stop)
+			pthread_cond_wait(&writer.event, &writer.lock);
+
+		if (NULL == (write_func = writer.write_func))
+			break;
+
+		data = writer.data;
+		pthread_mutex_unlock(&writer.lock);
+
+		write_func(data);
+
+		pthread_mutex_lock(&writer.lock);
+		zbx_db_insert_stats_collect(writer.insert_stats);
+		writer.write_func = NULL;
+		pthread_cond_broadcast(&writer.event);
+	}
+
+	pthread_mutex_unlock(&writer.lock);
+
+	zbx_db_close();
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "history writer thread stopped");
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts history writer thread                                      *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the writer thread was started                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: When history writer is started the history syncer writes history *
+ *           of a batch in writer thread while it processes triggers of the   *
+ *           previous batch.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hc_writer_start(char **error)
+{
+	pthread_attr_t	attr;
+	int		err;
+
+	if (0 != (err = pthread_mutex_init(&writer.lock, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize history writer mutex: %s", zbx_strerror(err));
+		return FAIL;
+	}
+
+	if (0 != (err = pthread_cond_init(&writer.event, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize history writer conditional variable: %s",
+				zbx_strerror(err));
+		pthread_mutex_destroy(&writer.lock);
+		return FAIL;
+	}
+
+	writer.write_func = NULL;
+	writer.stop = 0;
+	memset(writer.insert_stats, 0, sizeof(writer.insert_stats));
+
+	zbx_pthread_init_attr(&attr);
+
+	if (0 != (err = pthread_create(&writer.thread, &attr, hc_writer_entry, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot create history writer thread: %s", zbx_strerror(err));
+		pthread_cond_destroy(&writer.event);
+		pthread_mutex_destroy(&writer.lock);
+		return FAIL;
+	}
+
+	writer.started = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops history writer thread                                       *
+ *                                                                            *
+ * Comments: The submitted write job is finished before thread exits.         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_writer_stop(void)
+{
+	void	*retval;
+
+	if (0 == writer.started)
+		return;
+
+	pthread_mutex_lock(&writer.lock);
+	writer.stop = 1;
+	pthread_cond_broadcast(&writer.event);
+	pthread_mutex_unlock(&writer.lock);
+
+	pthread_join(writer.thread, &retval);
+
+	pthread_cond_destroy(&writer.event);
+	pthread_mutex_destroy(&writer.lock);
+
+	writer.started = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if history writer thread is running                        *
+ *                                                                            *
+ ******************************************************************************/
+int	hc_writer_started(void)
+{
+	return 0 != writer.started ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: submits history write job to writer thread                        *
+ *                                                                            *
+ * Parameters: write_func - [IN] the function to execute in writer thread     *
+ *             data       - [IN] the function data                            *
+ *                                                                            *
+ * Comments: Only one job can be submitted at a time, the caller must wait    *
+ *           for the previous job to finish with hc_writer_wait().            *
+ *                                                                            *
+ ******************************************************************************/
+void	hc_writer_submit(zbx_hc_write_func_t write_func, void *data)
+{
+	pthread_mutex_lock(&writer.lock);
+
+	if (NULL != writer.write_func)
+		THIS_SHOULD_NEVER_HAPPEN;
+
+	writer.write_func = write_func;
+	writer.data = data;
+	pthread_cond_broadcast(&writer.event);
+
+	pthread_mutex_unlock(&writer.lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits for the submitted history write job to finish              *
+ *                                                                            *
+ ******************************************************************************/
+void	hc_writer_wait(void)
+{
+	pthread_mutex_lock(&writer.lock);
+
+	while (NULL != writer.write_func)
+		pthread_cond_wait(&writer.event, &writer.lock);
+
+	pthread_mutex_unlock(&writer.lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds bulk insert statistics of writer thread to the specified     *
+ *          statistics and resets them                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	hc_writer_stats_collect(zbx_db_insert_stats_t *stats)
+{
+	int	i;
+
+	if (0 == writer.started)
+		return;
+
+	pthread_mutex_lock(&writer.lock);
+
+	for (i = 0; i < ZBX_DB_INSERT_STATS_TABLES_NUM; i++)
+	{
+		stats[i].rows += writer.insert_stats[i].rows;
+		stats[i].bytes += writer.insert_stats[i].bytes;
+		stats[i].copy_rows += writer.insert_stats[i].copy_rows;
+		stats[i].copy_fallbacks += writer.insert_stats[i].copy_fallbacks;
+		stats[i].time += writer.insert_stats[i].time;
+	}
+
+	memset(writer.insert_stats, 0, sizeof(writer.insert_stats));
+
+	pthread_mutex_unlock(&writer.lock);
+}
@@ -0,0 +1,32 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_HISTORY_WRITER_H
+#define ZABBIX_HISTORY_WRITER_H
+
+#include "zbxdbhigh.h"
+
+typedef void	(*zbx_hc_write_func_t)(void *data);
+
+int	hc_writer_started(void);
+void	hc_writer_submit(zbx_hc_write_func_t write_func, void *data);
+void	hc_writer_wait(void);
+void	hc_writer_stats_collect(zbx_db_insert_stats_t *stats);
+
+#endif
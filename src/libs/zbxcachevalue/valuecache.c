@@ -22,6 +22,7 @@
 #include "zbxmutexs.h"
 #include "zbxtime.h"
 #include "zbxvariant.h"
+#include "zbxatomic.h"
 
 /*
  * The cache (zbx_vc_cache_t) is organized as a hashset of item records (zbx_vc_item_t).
@@ -47,6 +48,14 @@
  *
  * The low memory mode can't be turned off - it will persist until server is rebooted.
  * In low memory mode a warning message is written into log every 5 minutes.
+ *
+ * Values are read from cache and appended to cached items with cache read lock, so history
+ * syncers do not block readers. Appending processes are serialized by a separate append lock
+ * and publish new values by updating item modification sequence number (seqlock), which is
+ * used by readers to validate the copied values. Memory released while appending values is
+ * not freed but retired and freed when cache is write locked next time, so concurrent readers
+ * never access reused memory. All other modifications (caching values from database, removing
+ * items, adding out of order values) are done with cache write lock.
  */
 
 /* the period of low memory warning messages */
@@ -82,6 +91,32 @@ ZBX_SHMEM_FUNC_IMPL(__vc, vc_mem)
 
 #define ZBX_VC_ITEM_EXPIRE_PERIOD	SEC_PER_DAY
 
+#if defined(HAVE_ATOMIC_BUILTINS)
+/* values are appended to cached items with cache read lock, concurrently with readers */
+#	define VC_SHARED_APPEND
+#endif
+
+/* item history data modified by appending processes must be accessed with memory ordering */
+/* constraints, so readers never see a published pointer or index before the data it refers to */
+#if defined(VC_SHARED_APPEND)
+#	define VC_LOAD(var)		ZBX_ATOMIC_LOAD_ACQUIRE(&(var))
+#	define VC_STORE(var, value)	ZBX_ATOMIC_STORE_RELEASE(&(var), value)
+#else
+#	define VC_LOAD(var)		(var)
+#	define VC_STORE(var, value)	((var) = (value))
+#endif
+
+/* the number of attempts to read item values while they are being appended */
+#define VC_READ_ATTEMPTS	100
+
+/* the maximum number of memory blocks released when copying or removing a single */
+/* value - log value structure with source and value strings                     */
+#define VC_VALUE_FREES_MAX	3
+
+/* the number of memory blocks that can be retired before cache is write locked */
+#define VC_RETIRED_MIN		256
+#define VC_RETIRED_MAX		65536
+
 /* the data chunk used to store data fragment */
 typedef struct zbx_vc_chunk
 {
@@ -100,18 +135,26 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
-	/* the item value data */
-	zbx_history_record_t	slots[1];
+	/* the item values, followed by the item value timestamps */
+	zbx_history_value_t	values[1];
 }
 zbx_vc_chunk_t;
 
+/* The chunk data is stored in columns - the values and their timestamps are kept in separate */
+/* arrays, so numeric values can be aggregated without accessing timestamps.                */
+#define VC_CHUNK_TIMESTAMPS(chunk)	((zbx_timespec_t *)&(chunk)->values[(chunk)->slots_num])
+#define VC_CHUNK_TS(chunk, index)	(VC_CHUNK_TIMESTAMPS(chunk)[index])
+
+#define VC_CHUNK_SIZE(nslots)		(sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_value_t) * (size_t)((nslots) - 1) + \
+		sizeof(zbx_timespec_t) * (size_t)(nslots))
+
 /* min/max number of item history values to store in chunk */
 
 #define ZBX_VC_MIN_CHUNK_RECORDS	2
 
 /* the maximum number is calculated so that the chunk size does not exceed 64KB */
-#define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
-		sizeof(zbx_history_record_t) + 1)
+#define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_value_t)) / \
+		(sizeof(zbx_history_value_t) + sizeof(zbx_timespec_t)))
 
 /* the value cache item data */
 typedef struct
@@ -175,9 +218,18 @@ typedef struct
 
 	/* the first (oldest) chunk of item history data              */
 	zbx_vc_chunk_t	*tail;
+
+	/* The item history data modification sequence number.        */
+	/* It's odd while values are being appended with cache read   */
+	/* lock and is used to validate concurrently read values.     */
+	unsigned int	seq;
 }
 zbx_vc_item_t;
 
+/* the callback to process consecutive chunk values from first to last index */
+typedef void	(*vc_chunk_process_func_t)(const zbx_vc_item_t *item, const zbx_vc_chunk_t *chunk, int first, int last,
+		void *data);
+
 /* the value cache data  */
 typedef struct
 {
@@ -204,6 +256,11 @@ typedef struct
 
 	/* the string pool for str, text and log item values */
 	zbx_hashset_t	strpool;
+
+	/* memory released while appending values, freed when cache is write locked */
+	void		**retired;
+	int		retired_num;
+	int		retired_max;
 }
 zbx_vc_cache_t;
 
@@ -251,6 +308,14 @@ zbx_vc_item_update_t;
 ZBX_VECTOR_DECL(vc_itemupdate, zbx_vc_item_update_t)
 ZBX_VECTOR_IMPL(vc_itemupdate, zbx_vc_item_update_t)
 
+/* the item value processing callback and its data */
+typedef struct
+{
+	zbx_vc_process_func_t	process_func;
+	void			*data;
+}
+zbx_vc_process_t;
+
 static zbx_vector_vc_itemupdate_t	vc_itemupdates;
 
 static void	vc_cache_item_update(zbx_uint64_t itemid, zbx_vc_item_update_type_t type, int arg1, int arg2)
@@ -270,10 +335,21 @@ static void	vc_cache_item_update(zbx_uint64_t itemid, zbx_vc_item_update_type_t
 /* the value cache */
 static zbx_vc_cache_t	*vc_cache = NULL;
 
+/* serializes processes appending values with cache read lock */
+static zbx_mutex_t	vc_append_lock = ZBX_MUTEX_NULL;
+
+/* set while the current process is appending values with cache read lock */
+static int	vc_appending = 0;
+
+static void	vc_release_retired(void);
+
 #define	RDLOCK_CACHE	zbx_rwlock_rdlock(vc_lock)
-#define	WRLOCK_CACHE	zbx_rwlock_wrlock(vc_lock)
+#define	WRLOCK_CACHE	do { zbx_rwlock_wrlock(vc_lock); vc_release_retired(); } while (0)
 #define	UNLOCK_CACHE	zbx_rwlock_unlock(vc_lock)
 
+#define	LOCK_APPEND	zbx_mutex_lock(vc_append_lock)
+#define	UNLOCK_APPEND	zbx_mutex_unlock(vc_append_lock)
+
 /* function prototypes */
 static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type);
 static void	vc_history_record_vector_clean(zbx_vector_history_record_t *vector, int value_type);
@@ -283,6 +359,56 @@ static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk);
 static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num);
 static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp);
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees value cache memory                                          *
+ *                                                                            *
+ * Parameters: ptr - [IN] the memory to free                                  *
+ *                                                                            *
+ * Comments: Memory released while appending values with cache read lock     *
+ *           might still be accessed by concurrent readers. Such memory is    *
+ *           retired and freed when cache is write locked next time.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_mem_free_func(void *ptr)
+{
+	if (0 == vc_appending)
+	{
+		__vc_shmem_free_func(ptr);
+		return;
+	}
+
+	/* appending values must fail before exhausting retired memory space */
+	if (vc_cache->retired_num == vc_cache->retired_max)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	vc_cache->retired[vc_cache->retired_num++] = ptr;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees memory retired while appending values                       *
+ *                                                                            *
+ * Comments: This function must be called with cache write lock, when no      *
+ *           readers can access the retired memory.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_release_retired(void)
+{
+	int	i;
+
+	if (NULL == vc_cache)
+		return;
+
+	for (i = 0; i < vc_cache->retired_num; i++)
+		__vc_shmem_free_func(vc_cache->retired[i]);
+
+	vc_cache->retired_num = 0;
+}
+
 /*********************************************************************************
  *                                                                               *
  * Purpose: reads item history data from database                                *
@@ -731,6 +857,30 @@ static void	vc_dump_items_statistics(void)
 	zabbix_log(LOG_LEVEL_WARNING, "==================================================");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if low memory warning must be logged or the low memory     *
+ *          mode reset                                                        *
+ *                                                                            *
+ * Return value: SUCCEED - vc_warn_low_memory() must be called                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_low_memory_warning_due(void)
+{
+	int	now;
+
+	now = (int)time(NULL);
+
+	if (now - vc_cache->mode_time > ZBX_VC_LOW_MEMORY_RESET_PERIOD ||
+			now - vc_cache->last_warning_time > ZBX_VC_LOW_MEMORY_WARNING_PERIOD)
+	{
+		return SUCCEED;
+	}
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: logs low memory warning                                           *
@@ -823,6 +973,10 @@ static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
 	size_t				freed;
 	zbx_vector_vc_itemweight_t	items;
 
+	/* items cannot be removed while values are being read concurrently */
+	if (0 != vc_appending)
+		return;
+
 	/* reserve at least min_free_request bytes to avoid spamming with free space requests */
 	if (space < vc_cache->min_free_request)
 		space = vc_cache->min_free_request;
@@ -1077,7 +1231,7 @@ static zbx_log_value_t	*vc_item_logdup(zbx_vc_item_t *item, const zbx_log_value_
 fail:
 	vc_item_strfree(plog->source);
 
-	__vc_shmem_free_func(plog);
+	vc_mem_free_func(plog);
 
 	return NULL;
 }
@@ -1103,7 +1257,7 @@ static size_t	vc_item_logfree(zbx_log_value_t *log)
 		freed += vc_item_strfree(log->source);
 		freed += vc_item_strfree(log->value);
 
-		__vc_shmem_free_func(log);
+		vc_mem_free_func(log);
 		freed += sizeof(zbx_log_value_t);
 	}
 
@@ -1122,7 +1276,7 @@ static size_t	vc_item_logfree(zbx_log_value_t *log)
  * Return value: the number of bytes freed                                    *
  *                                                                            *
  ******************************************************************************/
-static size_t	vc_item_free_values(zbx_vc_item_t *item, zbx_history_record_t *values, int first, int last)
+static size_t	vc_item_free_values(zbx_vc_item_t *item, zbx_history_value_t *values, int first, int last)
 {
 	size_t	freed = 0;
 	int 	i;
@@ -1132,11 +1286,11 @@ static size_t	vc_item_free_values(zbx_vc_item_t *item, zbx_history_record_t *val
 		case ITEM_VALUE_TYPE_STR:
 		case ITEM_VALUE_TYPE_TEXT:
 			for (i = first; i <= last; i++)
-				freed += vc_item_strfree(values[i].value.str);
+				freed += vc_item_strfree(values[i].str);
 			break;
 		case ITEM_VALUE_TYPE_LOG:
 			for (i = first; i <= last; i++)
-				freed += vc_item_logfree(values[i].value.log);
+				freed += vc_item_logfree(values[i].log);
 			break;
 		case ITEM_VALUE_TYPE_UINT64:
 		case ITEM_VALUE_TYPE_FLOAT:
@@ -1295,7 +1449,7 @@ static void	vch_item_update_range(zbx_vc_item_t *item, int range, int now)
 		diff += 0xff;
 
 	if (NULL != item->head)
-		last_value_timestamp = item->head->slots[item->head->last_value].timestamp.sec;
+		last_value_timestamp = VC_CHUNK_TS(item->head, item->head->last_value).sec;
 	else
 		last_value_timestamp = now;
 
@@ -1361,11 +1515,8 @@ static int	vch_item_chunk_slot_count(zbx_vc_item_t *item, int values_new)
 static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *insert_before)
 {
 	zbx_vc_chunk_t	*chunk;
-	size_t		chunk_size;
 
-	chunk_size =sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_record_t) * (size_t)(nslots - 1);
-
-	if (NULL == (chunk = (zbx_vc_chunk_t *)vc_item_malloc(item, chunk_size)))
+	if (NULL == (chunk = (zbx_vc_chunk_t *)vc_item_malloc(item, VC_CHUNK_SIZE(nslots))))
 		return FAIL;
 
 	memset(chunk, 0, sizeof(zbx_vc_chunk_t));
@@ -1417,7 +1568,7 @@ static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const z
 	int	start = chunk->first_value, end = chunk->last_value, middle;
 
 	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
+	if (0 >= zbx_timespec_compare(&VC_CHUNK_TS(chunk, end), ts))
 		return end;
 
 	/* chunk contains only one value, which did not pass the above check, return failure */
@@ -1429,13 +1580,13 @@ static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const z
 	{
 		middle = start + (end - start) / 2;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
+		if (0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, middle), ts))
 		{
 			end = middle;
 			continue;
 		}
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
+		if (0 >= zbx_timespec_compare(&VC_CHUNK_TS(chunk, middle + 1), ts))
 		{
 			start = middle;
 			continue;
@@ -1469,19 +1620,19 @@ static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const z
 static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
 		int *pindex)
 {
-	zbx_vc_chunk_t	*chunk = item->head;
+	zbx_vc_chunk_t	*chunk = VC_LOAD(item->head);
 	int		index;
 
 	if (NULL == chunk)
 		return FAIL;
 
-	index = chunk->last_value;
+	index = VC_LOAD(chunk->last_value);
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	if (0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, index), ts))
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
+		while (0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, VC_LOAD(chunk->first_value)), ts))
 		{
-			chunk = chunk->prev;
+			chunk = VC_LOAD(chunk->prev);
 			/* there are no values for requested range, return failure */
 			if (NULL == chunk)
 				return FAIL;
@@ -1514,26 +1665,26 @@ static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec
 static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
 		const zbx_history_record_t *source_value)
 {
-	zbx_history_record_t	*value;
+	zbx_history_value_t	*value;
 	int			ret = FAIL;
 
-	value = &chunk->slots[index];
+	value = &chunk->values[index];
 
 	switch (item->value_type)
 	{
 		case ITEM_VALUE_TYPE_STR:
 		case ITEM_VALUE_TYPE_TEXT:
-			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
+			if (NULL == (value->str = vc_item_strdup(item, source_value->value.str)))
 				goto out;
 			break;
 		case ITEM_VALUE_TYPE_LOG:
-			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
+			if (NULL == (value->log = vc_item_logdup(item, source_value->value.log)))
 				goto out;
 			break;
 		default:
-			value->value = source_value->value;
+			*value = source_value->value;
 	}
-	value->timestamp = source_value->timestamp;
+	VC_CHUNK_TS(chunk, index) = source_value->timestamp;
 
 	ret = SUCCEED;
 out:
@@ -1558,7 +1709,8 @@ out:
  ******************************************************************************/
 static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
 {
-	int	i, ret = FAIL, first_value = item->tail->first_value;
+	int		i, ret = FAIL, first_value = item->tail->first_value;
+	zbx_vc_chunk_t	*tail = item->tail;
 
 	switch (item->value_type)
 	{
@@ -1566,13 +1718,14 @@ static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_r
 		case ITEM_VALUE_TYPE_TEXT:
 			for (i = values_num - 1; i >= 0; i--)
 			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
-
-				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
+				if (NULL == (tail->values[tail->first_value - 1].str = vc_item_strdup(item,
+						values[i].value.str)))
+				{
 					goto out;
+				}
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
+				VC_CHUNK_TS(tail, tail->first_value - 1) = values[i].timestamp;
+				tail->first_value--;
 			}
 			ret = SUCCEED;
 
@@ -1580,21 +1733,25 @@ static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_r
 		case ITEM_VALUE_TYPE_LOG:
 			for (i = values_num - 1; i >= 0; i--)
 			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
-
-				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
+				if (NULL == (tail->values[tail->first_value - 1].log = vc_item_logdup(item,
+						values[i].value.log)))
+				{
 					goto out;
+				}
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
+				VC_CHUNK_TS(tail, tail->first_value - 1) = values[i].timestamp;
+				tail->first_value--;
 			}
 			ret = SUCCEED;
 
 			break;
 		default:
-			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
-					(size_t)values_num * sizeof(zbx_history_record_t));
-			item->tail->first_value -= values_num;
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				tail->first_value--;
+				tail->values[tail->first_value] = values[i].value;
+				VC_CHUNK_TS(tail, tail->first_value) = values[i].timestamp;
+			}
 			ret = SUCCEED;
 	}
 out:
@@ -1617,10 +1774,10 @@ static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
 	size_t	freed;
 
-	freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
-	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+	freed = VC_CHUNK_SIZE(chunk->slots_num);
+	freed += vc_item_free_values(item, chunk->values, chunk->first_value, chunk->last_value);
 
-	__vc_shmem_free_func(chunk);
+	vc_mem_free_func(chunk);
 
 	return freed;
 }
@@ -1636,16 +1793,16 @@ static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
 	if (NULL != chunk->next)
-		chunk->next->prev = chunk->prev;
+		VC_STORE(chunk->next->prev, chunk->prev);
 
 	if (NULL != chunk->prev)
-		chunk->prev->next = chunk->next;
+		VC_STORE(chunk->prev->next, chunk->next);
 
 	if (chunk == item->head)
-		item->head = chunk->prev;
+		VC_STORE(item->head, chunk->prev);
 
 	if (chunk == item->tail)
-		item->tail = chunk->next;
+		VC_STORE(item->tail, chunk->next);
 
 	vch_item_free_chunk(item, chunk);
 }
@@ -1673,9 +1830,9 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 		/* Try to remove chunks with all history values older than maximum request range, maximum */
 		/* request range should be calculated from last received value with which active range    */
 		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
+		while (NULL != chunk && VC_CHUNK_TS(chunk, chunk->last_value).sec < timestamp &&
+				VC_CHUNK_TS(chunk, chunk->last_value).sec !=
+						VC_CHUNK_TS(item->head, item->head->last_value).sec)
 		{
 			/* don't remove the head chunk */
 			if (NULL == (next = chunk->next))
@@ -1689,18 +1846,18 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 			/* In this case increase the first value index of the next chunk until the first  */
 			/* value timestamp is greater.                                                    */
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
+			if (VC_CHUNK_TS(next, next->first_value).sec != VC_CHUNK_TS(next, next->last_value).sec)
 			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
+				while (VC_CHUNK_TS(next, next->first_value).sec ==
+						VC_CHUNK_TS(chunk, chunk->last_value).sec)
 				{
-					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
-					next->first_value++;
+					vc_item_free_values(item, next->values, next->first_value, next->first_value);
+					VC_STORE(next->first_value, next->first_value + 1);
 				}
 			}
 
 			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+			VC_STORE(item->db_cached_from, VC_CHUNK_TS(chunk, chunk->last_value).sec + 1);
 
 			vch_item_remove_chunk(item, chunk);
 
@@ -1709,7 +1866,7 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 
 		/* reset the status flags if data was removed from cache */
 		if (tail != item->tail)
-			item->status = 0;
+			VC_STORE(item->status, 0);
 	}
 }
 
@@ -1731,18 +1888,18 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
 		item->status = 0;
 
 	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	while (NULL != chunk && VC_CHUNK_TS(chunk, chunk->first_value).sec < timestamp)
 	{
 		zbx_vc_chunk_t	*next;
 
 		/* If chunk contains values with timestamp greater or equal - remove */
 		/* only the values with less timestamp. Otherwise remove the while   */
 		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
+		if (VC_CHUNK_TS(chunk, chunk->last_value).sec >= timestamp)
 		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+			while (VC_CHUNK_TS(chunk, chunk->first_value).sec < timestamp)
 			{
-				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
+				vc_item_free_values(item, chunk->values, chunk->first_value, chunk->first_value);
 				chunk->first_value++;
 			}
 
@@ -1776,9 +1933,9 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	zbx_vc_chunk_t	*chunk, *schunk;
 
 	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+			0 < zbx_timespec_compare(&VC_CHUNK_TS(item->head, item->head->last_value), &value->timestamp))
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
+		if (0 < zbx_timespec_compare(&VC_CHUNK_TS(item->tail, item->tail->first_value), &value->timestamp))
 		{
 			/* If the added value has the same or older timestamp as the first value in cache */
 			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
@@ -1817,7 +1974,8 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 
 		do
 		{
-			chunk->slots[index] = schunk->slots[sindex];
+			chunk->values[index] = schunk->values[sindex];
+			VC_CHUNK_TS(chunk, index) = VC_CHUNK_TS(schunk, sindex);
 
 			chunk = schunk;
 			index = sindex;
@@ -1826,7 +1984,8 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 			{
 				if (NULL == (schunk = schunk->prev))
 				{
-					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
+					memset(&chunk->values[index], 0, sizeof(zbx_history_value_t));
+					memset(&VC_CHUNK_TS(chunk, index), 0, sizeof(zbx_timespec_t));
 					THIS_SHOULD_NEVER_HAPPEN;
 
 					goto out;
@@ -1835,7 +1994,7 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 				sindex = schunk->last_value;
 			}
 		}
-		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
+		while (0 < zbx_timespec_compare(&VC_CHUNK_TS(schunk, sindex), &value->timestamp));
 	}
 	else
 	{
@@ -1865,6 +2024,198 @@ out:
 	return ret;
 }
 
+#if defined(VC_SHARED_APPEND)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: marks the start of item history data modification done with      *
+ *          cache read lock                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_item_write_begin(zbx_vc_item_t *item)
+{
+	ZBX_ATOMIC_STORE_RELAXED(&item->seq, item->seq + 1);
+	ZBX_ATOMIC_FENCE_RELEASE();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: marks the end of item history data modification done with cache  *
+ *          read lock                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_item_write_end(zbx_vc_item_t *item)
+{
+	ZBX_ATOMIC_STORE_RELEASE(&item->seq, item->seq + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts reading item history data                                  *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *             seq  - [OUT] the item modification sequence number            *
+ *                                                                            *
+ * Return value: SUCCEED - the item data can be read                          *
+ *               FAIL    - the item data is being modified                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_item_read_begin(const zbx_vc_item_t *item, unsigned int *seq)
+{
+	*seq = ZBX_ATOMIC_LOAD_ACQUIRE(&item->seq);
+
+	return 0 == (*seq & 1) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if item history data was not modified while being read    *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *             seq  - [IN] the sequence number returned by                    *
+ *                         vc_item_read_begin()                               *
+ *                                                                            *
+ * Return value: SUCCEED - the read data is consistent                        *
+ *               FAIL    - the item data was modified, read data must be      *
+ *                         discarded                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_item_read_validate(const zbx_vc_item_t *item, unsigned int seq)
+{
+	ZBX_ATOMIC_FENCE_ACQUIRE();
+
+	return seq == ZBX_ATOMIC_LOAD_RELAXED(&item->seq) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimates the number of memory blocks released by removing old    *
+ *          item history data after a new chunk is added                      *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] last timestamp in active range               *
+ *                                                                            *
+ * Return value: the maximum number of memory blocks released by              *
+ *               vch_item_clean_cache() function                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_clean_cache_frees(const zbx_vc_item_t *item, int timestamp)
+{
+	const zbx_vc_chunk_t	*chunk;
+	int			frees = 0, value_frees;
+
+	if (0 == item->active_range)
+		return 0;
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			value_frees = 1;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			value_frees = VC_VALUE_FREES_MAX;
+			break;
+		default:
+			value_frees = 0;
+	}
+
+	timestamp -= item->active_range;
+
+	for (chunk = item->tail; NULL != chunk && VC_CHUNK_TS(chunk, chunk->last_value).sec < timestamp;
+			chunk = chunk->next)
+	{
+		frees += 1 + value_frees * (chunk->last_value - chunk->first_value + 1);
+	}
+
+	/* values with matching timestamp seconds might be removed from the next chunk */
+	if (NULL != chunk)
+		frees += value_frees * (chunk->last_value - chunk->first_value + 1);
+
+	return frees;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends one item history value at the end of item's history data  *
+ *          with cache read lock                                              *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              value  - [IN] the item history data value                     *
+ *                                                                            *
+ * Return value: SUCCEED - the history data value was appended                *
+ *               FAIL - the value must be added with cache write lock (the    *
+ *                      value is older than the last cached value, the item   *
+ *                      has no cached values or there is not enough memory),  *
+ *                      the item history data is not changed                  *
+ *                                                                            *
+ * Comments: This function must be called with cache read lock and append     *
+ *           lock. Readers might access the item history data concurrently,   *
+ *           so new slots and chunks are initialized before being published   *
+ *           and released memory is retired instead of being freed.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_append_value(zbx_vc_item_t *item, const zbx_history_record_t *value)
+{
+	zbx_vc_chunk_t	*head = item->head, *chunk;
+	int		last_value_timestamp, nslots;
+
+	if (NULL == head || 0 < zbx_timespec_compare(&VC_CHUNK_TS(head, head->last_value), &value->timestamp))
+		return FAIL;
+
+	if (head->slots_num - 1 != head->last_value)
+	{
+		if (vc_cache->retired_max - vc_cache->retired_num < VC_VALUE_FREES_MAX)
+			return FAIL;
+
+		/* the slot after the last value is not accessed by readers */
+		if (SUCCEED != vch_item_copy_value(item, head, head->last_value + 1, value))
+			return FAIL;
+
+		vc_item_write_begin(item);
+		VC_STORE(head->last_value, head->last_value + 1);
+		VC_STORE(item->values_total, item->values_total + 1);
+		vc_item_write_end(item);
+
+		return SUCCEED;
+	}
+
+	last_value_timestamp = VC_CHUNK_TS(head, head->last_value).sec;
+
+	if (vc_cache->retired_max - vc_cache->retired_num <
+			VC_VALUE_FREES_MAX + 1 + vch_item_clean_cache_frees(item, last_value_timestamp))
+	{
+		return FAIL;
+	}
+
+	nslots = vch_item_chunk_slot_count(item, 1);
+	if (NULL == (chunk = (zbx_vc_chunk_t *)vc_item_malloc(item, VC_CHUNK_SIZE(nslots))))
+		return FAIL;
+
+	memset(chunk, 0, sizeof(zbx_vc_chunk_t));
+	chunk->slots_num = nslots;
+	chunk->prev = head;
+
+	if (SUCCEED != vch_item_copy_value(item, chunk, 0, value))
+	{
+		vc_mem_free_func(chunk);
+		return FAIL;
+	}
+
+	vc_item_write_begin(item);
+
+	VC_STORE(head->next, chunk);
+	VC_STORE(item->head, chunk);
+	VC_STORE(item->values_total, item->values_total + 1);
+
+	/* try to remove old (unused) chunks as a new chunk was added */
+	vch_item_clean_cache(item, last_value_timestamp);
+
+	vc_item_write_end(item);
+
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds item history values at the beginning of current item's       *
@@ -1888,7 +2239,7 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 	/* skip values already added to the item cache by another process */
 	if (NULL != item->tail)
 	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+		int	sec = VC_CHUNK_TS(item->tail, item->tail->first_value).sec;
 
 		while (--count >= 0 && values[count].timestamp.sec >= sec)
 			;
@@ -1929,146 +2280,241 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: cache item history data for the specified time period             *
+ * Purpose: checks if item history data for the specified time period is      *
+ *          cached                                                            *
  *                                                                            *
  * Parameters: item        - [IN] the item                                    *
  *             range_start - [IN] the interval start time                     *
+ *             range_end   - [OUT] the end of interval that must be read from *
+ *                                 database (optional)                        *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
- *                                                                            *
- * Comments: This function checks if the requested value range is cached and  *
- *           updates cache from database if necessary.                        *
+ * Return value:  SUCCEED - the requested period is cached                    *
+ *                FAIL    - the values must be read from database             *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+static int	vch_item_is_cached_by_time(const zbx_vc_item_t *item, int range_start, int *range_end)
 {
-	int				ret, range_end;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
+	const zbx_vc_chunk_t	*tail;
+	int			end, db_cached_from;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+	if (ZBX_ITEM_STATUS_CACHED_ALL == VC_LOAD(item->status))
 		return SUCCEED;
 
 	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+	if (0 != (db_cached_from = VC_LOAD(item->db_cached_from)) && range_start >= db_cached_from)
 		return SUCCEED;
 
 	/* find if the cache should be updated to cover the required range */
-	if (NULL != (*item)->tail)
+	if (NULL != (tail = VC_LOAD(item->tail)))
 	{
 		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		end = VC_CHUNK_TS(tail, VC_LOAD(tail->first_value)).sec - 1;
 	}
 	else
-		range_end = ZBX_JAN_2038;
+		end = ZBX_JAN_2038;
 
 	/* update cache if necessary */
-	if (range_start >= range_end)
+	if (range_start >= end)
 		return SUCCEED;
 
-	zbx_vector_history_record_create(&records);
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
+	if (NULL != range_end)
+		*range_end = end;
 
-	UNLOCK_CACHE;
+	return FAIL;
+}
 
-	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
-	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the specified number of item history data values for    *
+ *          time period since timestamp is cached                             *
+ *                                                                            *
+ * Parameters: item           - [IN] the item                                 *
+ *             range_start    - [IN] the interval start time                  *
+ *             count          - [IN] the number of history values to retrieve *
+ *             ts             - [IN] the target timestamp                     *
+ *             cached_records - [OUT] the number of cached values matching    *
+ *                                    the request (optional)                  *
+ *                                                                            *
+ * Return value:  SUCCEED - the requested values are cached                   *
+ *                FAIL    - the values must be read from database             *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_is_cached_by_time_and_count(const zbx_vc_item_t *item, int range_start, int count,
+		const zbx_timespec_t *ts, int *cached_records)
+{
+	int	records = 0, db_cached_from;
 
-	WRLOCK_CACHE;
+	if (ZBX_ITEM_STATUS_CACHED_ALL == VC_LOAD(item->status))
+		return SUCCEED;
 
-	if (SUCCEED != ret)
-		goto out;
+	/* check if the requested period is in the cached range */
+	if (0 != (db_cached_from = VC_LOAD(item->db_cached_from)) && range_start >= db_cached_from)
+		return SUCCEED;
 
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	/* find if the cache should be updated to cover the required count */
+	if (NULL != VC_LOAD(item->head))
 	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+		zbx_vc_chunk_t	*chunk;
+		int		index;
 
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item,
-				sizeof(new_item))))
+		if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
 		{
-			ret = FAIL;
-			goto out;
+			records = index - VC_LOAD(chunk->first_value) + 1;
+
+			while (NULL != (chunk = VC_LOAD(chunk->prev)) && records < count)
+				records += VC_LOAD(chunk->last_value) - VC_LOAD(chunk->first_value) + 1;
 		}
 	}
 
-	/* when updating cache with time based request we can always reset status flags */
-	/* flag even if the requested period contains no data                           */
-	(*item)->status = 0;
-
-	if (0 < records.values_num)
-	{
-		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
-			goto out;
-	}
+	/* update cache if necessary */
+	if (records >= count)
+		return SUCCEED;
 
-	ret = records.values_num;
-	vc_item_update_db_cached_from(*item, range_start);
-out:
-	zbx_history_record_vector_destroy(&records, value_type);
+	if (NULL != cached_records)
+		*cached_records = records;
 
-	return ret;
+	return FAIL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: cache the specified number of history data values for time period *
- *          since timestamp                                                   *
+ * Purpose: checks if the requested item history data is cached               *
  *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
- *             count       - [IN] the number of history values to retrieve    *
- *             ts          - [IN] the target timestamp                        *
+ * Parameters: item - [IN/OUT] the item, updated after cache is relocked      *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Return value: SUCCEED - the item values can be read from cache             *
+ *               FAIL    - the item was removed from cache                    *
  *                                                                            *
- * Comments: This function checks if the requested number of values is cached *
- *           and updates cache from database if necessary.                    *
+ * Comments: Values are cached from database with cache read lock released    *
+ *           and the cache is write locked afterwards. When the requested     *
+ *           values are already cached (appended after the cached values      *
+ *           lookup failed) the cache must be write locked before reading     *
+ *           them, because with read lock values can be appended              *
+ *           concurrently.                                                    *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
-		const zbx_timespec_t *ts)
+static int	vch_item_cached(zbx_vc_item_t **item)
 {
-	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
+#if defined(VC_SHARED_APPEND)
+	zbx_uint64_t	itemid = (*item)->itemid;
+
+	UNLOCK_CACHE;
+	WRLOCK_CACHE;
+
+	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+		return FAIL;
+#else
+	ZBX_UNUSED(item);
+#endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache item history data for the specified time period             *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested value range is cached and  *
+ *           updates cache from database if necessary.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+{
+	int				ret, range_end;
 	zbx_vector_history_record_t	records;
 	zbx_uint64_t			itemid;
 	unsigned char			value_type;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
+	if (SUCCEED == vch_item_is_cached_by_time(*item, range_start, &range_end))
+		return vch_item_cached(item);
 
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+	zbx_vector_history_record_create(&records);
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
 
-	/* find if the cache should be updated to cover the required count */
-	if (NULL != (*item)->head)
+	UNLOCK_CACHE;
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
 	{
-		zbx_vc_chunk_t	*chunk;
-		int		index;
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
 
-		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index))
-		{
-			cached_records = index - chunk->first_value + 1;
+	WRLOCK_CACHE;
 
-			while (NULL != (chunk = chunk->prev) && cached_records < count)
-				cached_records += chunk->last_value - chunk->first_value + 1;
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+
+		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item,
+				sizeof(new_item))))
+		{
+			ret = FAIL;
+			goto out;
 		}
 	}
 
-	/* update cache if necessary */
-	if (cached_records >= count)
-		return SUCCEED;
+	/* when updating cache with time based request we can always reset status flags */
+	/* flag even if the requested period contains no data                           */
+	(*item)->status = 0;
+
+	if (0 < records.values_num)
+	{
+		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
+			goto out;
+	}
+
+	ret = records.values_num;
+	vc_item_update_db_cached_from(*item, range_start);
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache the specified number of history data values for time period *
+ *          since timestamp                                                   *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *             count       - [IN] the number of history values to retrieve    *
+ *             ts          - [IN] the target timestamp                        *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested number of values is cached *
+ *           and updates cache from database if necessary.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
+		const zbx_timespec_t *ts)
+{
+	int				ret = SUCCEED, cached_records, range_end, records_offset;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (SUCCEED == vch_item_is_cached_by_time_and_count(*item, range_start, count, ts, &cached_records))
+		return vch_item_cached(item);
 
 	/* get the end timestamp to which (including) the values should be cached */
-	if (NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+	if (NULL != VC_LOAD((*item)->head))
+	{
+		const zbx_vc_chunk_t	*tail = VC_LOAD((*item)->tail);
+
+		range_end = VC_CHUNK_TS(tail, VC_LOAD(tail->first_value)).sec - 1;
+	}
 	else
 		range_end = ZBX_JAN_2038;
 
@@ -2127,7 +2573,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
 	{
 		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+				VC_CHUNK_TS((*item)->tail, (*item)->tail->first_value).sec);
 	}
 	else if (0 != range_start)
 		vc_item_update_db_cached_from(*item, range_start);
@@ -2140,19 +2586,25 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: processes item history data stored in cache for the specified     *
+ *          time period                                                       *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order                           *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             ts        - [IN] the requested period end timestamp            *
+ * Parameters: item         - [IN] the item                                   *
+ *             seconds      - [IN] the time period                            *
+ *             ts           - [IN] the requested period end timestamp         *
+ *             process_func - [IN] the callback to process consecutive values *
+ *                                 of a chunk                                 *
+ *             data         - [IN] the callback data                          *
+ *                                                                            *
+ * Return value: the number of processed values                               *
+ *                                                                            *
+ * Comments: The chunks are processed starting with the newest values.        *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		const zbx_timespec_t *ts)
+static int	vch_item_process_values_by_time(const zbx_vc_item_t *item, int seconds, const zbx_timespec_t *ts,
+		vc_chunk_process_func_t process_func, void *data)
 {
-	int		index, now;
+	int		index, last, now, values_num = 0;
 	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
 	zbx_vc_chunk_t	*chunk;
 
@@ -2168,43 +2620,57 @@ static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_hi
 
 	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
 	{
-		/* Cache does not contain records for the specified timeshift & seconds range. */
-		/* Return empty vector with success.                                           */
-		return;
+		/* cache does not contain records for the specified timeshift & seconds range */
+		return 0;
 	}
 
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	/* process item history values until the start timestamp is reached */
+	while (0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, VC_LOAD(chunk->last_value)), &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+		int	first = VC_LOAD(chunk->first_value);
 
-		if (NULL == (chunk = chunk->prev))
+		last = index;
+
+		while (index >= first && 0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, index), &start))
+			index--;
+
+		if (index != last)
+		{
+			process_func(item, chunk, index + 1, last, data);
+			values_num += last - index;
+		}
+
+		if (NULL == (chunk = VC_LOAD(chunk->prev)))
 			break;
 
-		index = chunk->last_value;
+		index = VC_LOAD(chunk->last_value);
 	}
+
+	return values_num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: processes the specified number of item history data values        *
+ *          stored in cache for time period since timestamp                   *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period                               *
- *             count     - [IN] the number of history values to retrieve      *
- *             timestamp - [IN] the target timestamp                          *
+ * Parameters: item         - [IN] the item                                   *
+ *             seconds      - [IN] the time period                            *
+ *             count        - [IN] the number of history values to process    *
+ *             ts           - [IN] the target timestamp                       *
+ *             process_func - [IN] the callback to process consecutive values *
+ *                                 of a chunk                                 *
+ *             data         - [IN] the callback data                          *
+ *                                                                            *
+ * Return value: the number of processed values                               *
+ *                                                                            *
+ * Comments: The chunks are processed starting with the newest values.        *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+static int	vch_item_process_values_by_time_and_count(const zbx_vc_item_t *item, int seconds, int count,
+		const zbx_timespec_t *ts, vc_chunk_process_func_t process_func, void *data)
 {
-	int		index, now, range_timestamp;
+	int		index, last, now, range_timestamp, values_num = 0;
 	zbx_vc_chunk_t	*chunk;
 	zbx_timespec_t	start;
 
@@ -2221,47 +2687,115 @@ static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vecto
 	}
 
 	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* return empty vector with success */
 		goto out;
-	}
 
-	/* fill the values vector with item history values until the <count> values are read    */
-	/* or no more values within specified time period                                       */
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	/* process item history values until the <count> values are processed or */
+	/* no more values within specified time period                           */
+	while (0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, VC_LOAD(chunk->last_value)), &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
+		int	first = VC_LOAD(chunk->first_value);
+
+		last = index;
+
+		while (index >= first && values_num + last - index < count &&
+				0 < zbx_timespec_compare(&VC_CHUNK_TS(chunk, index), &start))
 		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+			index--;
+		}
 
-			if (values->values_num == count)
-				goto out;
+		if (index != last)
+		{
+			process_func(item, chunk, index + 1, last, data);
+			values_num += last - index;
 		}
 
-		if (NULL == (chunk = chunk->prev))
+		if (values_num == count)
+		{
+			/* the requested number of values was processed, set the range to the oldest value timestamp */
+			range_timestamp = VC_CHUNK_TS(chunk, index + 1).sec - 1;
+			goto update;
+		}
+
+		if (NULL == (chunk = VC_LOAD(chunk->prev)))
 			break;
 
-		index = chunk->last_value;
+		index = VC_LOAD(chunk->last_value);
 	}
 out:
-	if (count > values->values_num)
-	{
-		if (0 == seconds)
-			return;
+	if (0 == seconds)
+		return values_num;
 
-		/* not enough data in the requested period, set the range equal to the period plus */
-		/* one second to include nanosecond shifts                                         */
-		range_timestamp = ts->sec - seconds;
-	}
-	else
+	/* not enough data in the requested period, set the range equal to the period plus */
+	/* one second to include nanosecond shifts                                         */
+	range_timestamp = ts->sec - seconds;
+update:
+	now = (int)time(NULL);
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+
+	return values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends chunk values to history record vector                     *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             chunk - [IN] the chunk                                         *
+ *             first - [IN] the index of the first (oldest) value to append   *
+ *             last  - [IN] the index of the last (newest) value to append    *
+ *             data  - [OUT] the history record vector                        *
+ *                                                                            *
+ * Comments: The values are appended in descending order.                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_chunk_append_values(const zbx_vc_item_t *item, const zbx_vc_chunk_t *chunk, int first, int last,
+		void *data)
+{
+	zbx_vector_history_record_t	*values = (zbx_vector_history_record_t *)data;
+	zbx_history_record_t		record;
+	int				i;
+
+	for (i = last; i >= first; i--)
 	{
-		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
-		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
+		record.timestamp = VC_CHUNK_TS(chunk, i);
+		record.value = chunk->values[i];
+		vc_history_record_vector_append(values, item->value_type, &record);
 	}
+}
 
-	now = (int)time(NULL);
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in undefined order                           *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             ts        - [IN] the requested period end timestamp            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
+		const zbx_timespec_t *ts)
+{
+	vch_item_process_values_by_time(item, seconds, ts, vch_chunk_append_values, values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in undefined order                           *
+ *             seconds   - [IN] the time period                               *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             timestamp - [IN] the target timestamp                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	vch_item_process_values_by_time_and_count(item, seconds, count, ts, vch_chunk_append_values, values);
 }
 
 /******************************************************************************
@@ -2337,6 +2871,255 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item values for the specified range if they are cached        *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in descending order                          *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the requested range is not cached                 *
+ *                                                                            *
+ * Comments: Unlike vch_item_get_values() this function does not modify cache *
+ *           and can be used with cache read lock.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_cached_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int	range_start;
+
+	zbx_vector_history_record_clear(values);
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (SUCCEED != vch_item_is_cached_by_time(item, range_start, NULL))
+			return FAIL;
+
+		vch_item_get_values_by_time(item, values, seconds, ts);
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (SUCCEED != vch_item_is_cached_by_time_and_count(item, range_start, count, ts, NULL))
+			return FAIL;
+
+		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item values for the specified range if they are cached        *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             values     - [OUT] the item history data stored time/value     *
+ *                          pairs in descending order                         *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item or the requested range is not cached or  *
+ *                          the values were modified while being read         *
+ *                                                                            *
+ * Comments: This function must be called with cache read lock. Values might  *
+ *           be appended to the item concurrently, so the read values are     *
+ *           validated with item modification sequence number.                *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	zbx_vc_item_t	*item;
+	int		ret = FAIL;
+#if defined(VC_SHARED_APPEND)
+	int		i;
+	unsigned int	seq;
+#endif
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)) ||
+			item->value_type != value_type)
+	{
+		return FAIL;
+	}
+
+#if defined(VC_SHARED_APPEND)
+	for (i = 0; i < VC_READ_ATTEMPTS; i++)
+	{
+		if (SUCCEED != vc_item_read_begin(item, &seq))
+			continue;
+
+		ret = vch_item_get_cached_values(item, values, seconds, count, ts);
+
+		if (SUCCEED == vc_item_read_validate(item, seq))
+			break;
+
+		vc_history_record_vector_clean(values, value_type);
+		ret = FAIL;
+	}
+#else
+	ret = vch_item_get_cached_values(item, values, seconds, count, ts);
+#endif
+	if (SUCCEED == ret)
+		vc_cache_item_update(itemid, ZBX_VC_UPDATE_STATS, values->values_num, 0);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes chunk values to value processing callback                  *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             chunk - [IN] the chunk                                         *
+ *             first - [IN] the index of the first (oldest) value to process  *
+ *             last  - [IN] the index of the last (newest) value to process   *
+ *             data  - [IN] the value processing callback and its data        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_chunk_process_values(const zbx_vc_item_t *item, const zbx_vc_chunk_t *chunk, int first, int last,
+		void *data)
+{
+	const zbx_vc_process_t	*process = (const zbx_vc_process_t *)data;
+
+	ZBX_UNUSED(item);
+
+	process->process_func(&chunk->values[first], last - first + 1, process->data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process item values for the specified range if they are cached    *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             seconds    - [IN] the time period to process data for          *
+ *             count      - [IN] the number of history values to process      *
+ *             ts         - [IN] the target timestamp                         *
+ *             process    - [IN] the value processing callback and its data   *
+ *             values_num - [OUT] the number of processed values              *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was processed successfully  *
+ *                FAIL    - the requested range is not cached                 *
+ *                                                                            *
+ * Comments: This function does not modify cache and can be used with cache   *
+ *           read lock.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_process_cached_values(const zbx_vc_item_t *item, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_process_t *process, int *values_num)
+{
+	int	range_start;
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (SUCCEED != vch_item_is_cached_by_time(item, range_start, NULL))
+			return FAIL;
+
+		*values_num = vch_item_process_values_by_time(item, seconds, ts, vch_chunk_process_values, process);
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (SUCCEED != vch_item_is_cached_by_time_and_count(item, range_start, count, ts, NULL))
+			return FAIL;
+
+		*values_num = vch_item_process_values_by_time_and_count(item, seconds, count, ts,
+				vch_chunk_process_values, process);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process item values for the specified range if they are cached    *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period to process data for          *
+ *             count      - [IN] the number of history values to process      *
+ *             ts         - [IN] the period end timestamp                     *
+ *             process    - [IN] the value processing callback and its data   *
+ *             data_size  - [IN] the size of callback data                    *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was processed successfully  *
+ *                FAIL    - the item or the requested range is not cached or  *
+ *                          the values were modified while being processed,   *
+ *                          the callback data is left in its initial state    *
+ *                                                                            *
+ * Comments: This function must be called with cache read lock. Values might  *
+ *           be appended to the item concurrently, so the processing is       *
+ *           validated with item modification sequence number and repeated    *
+ *           with restored callback data if necessary.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_process_cached_values(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_process_t *process, size_t data_size)
+{
+	zbx_vc_item_t	*item;
+	int		ret = FAIL, values_num = 0;
+#if defined(VC_SHARED_APPEND)
+	int		i;
+	unsigned int	seq;
+	unsigned char	data_initial[ZBX_VC_PROCESS_DATA_MAX];
+
+	if (sizeof(data_initial) < data_size)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return FAIL;
+	}
+#endif
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)) ||
+			item->value_type != value_type)
+	{
+		return FAIL;
+	}
+
+#if defined(VC_SHARED_APPEND)
+	memcpy(data_initial, process->data, data_size);
+
+	for (i = 0; i < VC_READ_ATTEMPTS; i++)
+	{
+		if (SUCCEED != vc_item_read_begin(item, &seq))
+			continue;
+
+		ret = vch_item_process_cached_values(item, seconds, count, ts, process, &values_num);
+
+		if (SUCCEED == vc_item_read_validate(item, seq))
+			break;
+
+		memcpy(process->data, data_initial, data_size);
+		ret = FAIL;
+	}
+#else
+	ZBX_UNUSED(data_size);
+
+	ret = vch_item_process_cached_values(item, seconds, count, ts, process, &values_num);
+#endif
+	if (SUCCEED == ret)
+		vc_cache_item_update(itemid, ZBX_VC_UPDATE_STATS, values_num, 0);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: frees resources allocated for item history data                   *
@@ -2390,6 +3173,11 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 	if (SUCCEED != (ret = zbx_rwlock_create(&vc_lock, ZBX_RWLOCK_VALUECACHE, error)))
 		goto out;
 
+#if defined(VC_SHARED_APPEND)
+	if (SUCCEED != (ret = zbx_mutex_create(&vc_append_lock, ZBX_MUTEX_VALUECACHE, error)))
+		goto out;
+#endif
+
 	size_reserved = zbx_shmem_required_size(1, "value cache size", "ValueCacheSize");
 
 	if (SUCCEED != zbx_shmem_create(&vc_mem, value_cache_size, "value cache size", "ValueCacheSize", 1,
@@ -2400,6 +3188,8 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 
 	value_cache_size -= size_reserved;
 
+	zbx_shmem_add_slab_class(vc_mem, ZBX_HASHSET_ENTRY_OFFSET + sizeof(zbx_vc_item_t));
+
 	vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
 
 	if (NULL == vc_cache)
@@ -2421,7 +3211,7 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 
 	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
 			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
-			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+			__vc_shmem_malloc_func, __vc_shmem_realloc_func, vc_mem_free_func);
 
 	if (NULL == vc_cache->strpool.slots)
 	{
@@ -2429,6 +3219,20 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 		goto out;
 	}
 
+	/* reserve space to retire memory released while appending values, one block per 1KB of cache */
+	vc_cache->retired_max = (int)(value_cache_size / ZBX_KIBIBYTE);
+	if (VC_RETIRED_MIN > vc_cache->retired_max)
+		vc_cache->retired_max = VC_RETIRED_MIN;
+	if (VC_RETIRED_MAX < vc_cache->retired_max)
+		vc_cache->retired_max = VC_RETIRED_MAX;
+
+	if (NULL == (vc_cache->retired = (void **)__vc_shmem_malloc_func(NULL,
+			sizeof(void *) * (size_t)vc_cache->retired_max)))
+	{
+		*error = zbx_strdup(*error, "cannot allocate retired memory list for value cache");
+		goto out;
+	}
+
 	/* the free space request should be 5% of cache size, but no more than 128KB */
 	vc_cache->min_free_request = (value_cache_size / 100) * 5;
 	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
@@ -2462,12 +3266,17 @@ void	zbx_vc_destroy(void)
 		zbx_hashset_destroy(&vc_cache->items);
 		zbx_hashset_destroy(&vc_cache->strpool);
 
+		vc_release_retired();
+		__vc_shmem_free_func(vc_cache->retired);
 		__vc_shmem_free_func(vc_cache);
 		vc_cache = NULL;
 
 		zbx_shmem_destroy(vc_mem);
 		vc_mem = NULL;
 		zbx_rwlock_destroy(&vc_lock);
+#if defined(VC_SHARED_APPEND)
+		zbx_mutex_destroy(&vc_append_lock);
+#endif
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -2514,28 +3323,19 @@ void	zbx_vc_reset(void)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history and value cache                   *
+ * Purpose: adds values to cached items                                       *
  *                                                                            *
  * Parameters: history - [IN] item history values                             *
  *                                                                            *
- * Return value: SUCCEED - the values were added successfully                 *
- *               FAIL    - otherwise                                          *
+ * Comments: This function must be called with cache write lock.              *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+static void	vc_add_values(const zbx_vector_ptr_t *history)
 {
 	zbx_vc_item_t		*item;
 	int			i;
 	zbx_dc_history_t	*h;
 
-	if (SUCCEED != zbx_history_add_values(history, ret_flush))
-		return FAIL;
-
-	if (ZBX_VC_DISABLED == vc_state)
-		return SUCCEED;
-
-	WRLOCK_CACHE;
-
 	for (i = 0; i < history->values_num; i++)
 	{
 		h = (zbx_dc_history_t *)history->values[i];
@@ -2547,7 +3347,7 @@ int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
 			int			last_value_timestamp;
 
 			if (NULL != head)
-				last_value_timestamp = head->slots[head->last_value].timestamp.sec;
+				last_value_timestamp = VC_CHUNK_TS(head, head->last_value).sec;
 			else
 				last_value_timestamp = (int)time(NULL);
 
@@ -2568,8 +3368,130 @@ int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
 				vch_item_clean_cache(item, last_value_timestamp);
 		}
 	}
+}
+
+#if defined(VC_SHARED_APPEND)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends values to cached items with cache read lock               *
+ *                                                                            *
+ * Parameters: history        - [IN] item history values                      *
+ *             history_locked - [OUT] values that must be added with cache    *
+ *                                    write lock                              *
+ *                                                                            *
+ * Comments: Once a value of an item cannot be appended, all following values *
+ *           of that item are also added with cache write lock to preserve    *
+ *           their order.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_append_values(const zbx_vector_ptr_t *history, zbx_vector_ptr_t *history_locked)
+{
+	zbx_vc_item_t		*item;
+	int			i;
+	zbx_dc_history_t	*h;
+	zbx_vector_uint64_t	itemids_locked;
+
+	zbx_vector_uint64_create(&itemids_locked);
+
+	/* lock append first so that appending processes waiting for their turn do */
+	/* not hold cache read lock, starving cache write lock requests            */
+	LOCK_APPEND;
+	RDLOCK_CACHE;
+
+	vc_appending = 1;
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		zbx_history_record_t	record;
+
+		h = (zbx_dc_history_t *)history->values[i];
+
+		if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
+			continue;
+
+		if (0 != itemids_locked.values_num && FAIL != zbx_vector_uint64_search(&itemids_locked, h->itemid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			zbx_vector_ptr_append(history_locked, h);
+			continue;
+		}
+
+		record.timestamp = h->ts;
+		record.value = h->value;
+
+		if (item->value_type != h->value_type || SUCCEED != vch_item_append_value(item, &record))
+		{
+			zbx_vector_uint64_append(&itemids_locked, h->itemid);
+			zbx_vector_ptr_append(history_locked, h);
+		}
+	}
+
+	vc_appending = 0;
 
 	UNLOCK_CACHE;
+	UNLOCK_APPEND;
+
+	zbx_vector_uint64_destroy(&itemids_locked);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values already written to history to the value cache    *
+ *                                                                            *
+ * Parameters: history - [IN] item history values                             *
+ *                                                                            *
+ * Comments: Values are appended to cached items with cache read lock, only   *
+ *           the values that cannot be simply appended (out of order values,  *
+ *           items without cached values, not enough memory) are added with   *
+ *           cache write lock.                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_cache_values(zbx_vector_ptr_t *history)
+{
+#if defined(VC_SHARED_APPEND)
+	zbx_vector_ptr_t	history_locked;
+#endif
+	if (ZBX_VC_DISABLED == vc_state)
+		return;
+
+#if defined(VC_SHARED_APPEND)
+	zbx_vector_ptr_create(&history_locked);
+
+	vc_append_values(history, &history_locked);
+
+	if (0 != history_locked.values_num)
+	{
+		WRLOCK_CACHE;
+		vc_add_values(&history_locked);
+		UNLOCK_CACHE;
+	}
+
+	zbx_vector_ptr_destroy(&history_locked);
+#else
+	WRLOCK_CACHE;
+	vc_add_values(history);
+	UNLOCK_CACHE;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values to the history and value cache                   *
+ *                                                                            *
+ * Parameters: history   - [IN] item history values                           *
+ *             ret_flush - [OUT] the history flush result                     *
+ *                                                                            *
+ * Return value: SUCCEED - the values were added successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+{
+	if (SUCCEED != zbx_history_add_values(history, ret_flush))
+		return FAIL;
+
+	zbx_vc_cache_values(history);
 
 	return SUCCEED;
 }
@@ -2611,9 +3533,18 @@ int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_
 	if (ZBX_VC_DISABLED == vc_state)
 		goto out;
 
+	/* read the already cached values without blocking processes appending new values */
+	if ((ZBX_VC_MODE_LOWMEM != vc_cache->mode || SUCCEED != vc_low_memory_warning_due()) &&
+			SUCCEED == (ret = vc_get_cached_values(itemid, value_type, values, seconds, count, ts)))
+	{
+		goto out;
+	}
+
 	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
 		vc_warn_low_memory();
 
+	/* the cache is write locked only if values must be cached from database */
+
 	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
 		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
@@ -2693,6 +3624,75 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process item history data for the specified time period           *
+ *                                                                            *
+ * Parameters: itemid       - [IN] the item id                                *
+ *             value_type   - [IN] the item value type                        *
+ *             seconds      - [IN] the time period to process data for        *
+ *             count        - [IN] the number of history values to process    *
+ *             ts           - [IN] the period end timestamp                   *
+ *             process_func - [IN] the callback to process values             *
+ *             data         - [IN/OUT] the callback data                      *
+ *             data_size    - [IN] the size of callback data                  *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was processed successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The range is defined the same way as in zbx_vc_get_values()      *
+ *           function.                                                        *
+ *                                                                            *
+ *           Cached numeric values are passed to the callback directly from   *
+ *           cache with cache read lock, so the callback must only aggregate  *
+ *           the values. If the values are modified while being processed the *
+ *           callback data is restored to its initial state (data_size bytes, *
+ *           up to ZBX_VC_PROCESS_DATA_MAX) and the processing is repeated.   *
+ *           Values that are not cached are retrieved with                    *
+ *           zbx_vc_get_values() and passed one by one.                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_process_values(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_process_func_t process_func, void *data, size_t data_size)
+{
+	zbx_vector_history_record_t	values;
+	zbx_vc_process_t		process = {.process_func = process_func, .data = data};
+	int				i, ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type || ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		RDLOCK_CACHE;
+
+		if (ZBX_VC_DISABLED != vc_state &&
+				(ZBX_VC_MODE_LOWMEM != vc_cache->mode || SUCCEED != vc_low_memory_warning_due()))
+		{
+			ret = vc_process_cached_values(itemid, value_type, seconds, count, ts, &process, data_size);
+		}
+
+		UNLOCK_CACHE;
+
+		if (SUCCEED == ret)
+			goto out;
+	}
+
+	zbx_history_record_vector_create(&values);
+
+	if (SUCCEED == (ret = zbx_vc_get_values(itemid, value_type, &values, seconds, count, ts)))
+	{
+		for (i = 0; i < values.values_num; i++)
+			process_func(&values.values[i].value, 1, data);
+	}
+
+	zbx_history_record_vector_destroy(&values, value_type);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves usage cache statistics                                  *
@@ -2788,9 +3788,11 @@ void	zbx_vc_get_mem_stats(zbx_shmem_stats_t *mem)
 		return;
 	}
 
+	LOCK_APPEND;
 	RDLOCK_CACHE;
 	zbx_shmem_get_stats(vc_mem, mem);
 	UNLOCK_CACHE;
+	UNLOCK_APPEND;
 }
 
 /******************************************************************************
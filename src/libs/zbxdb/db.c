@@ -65,18 +65,19 @@ struct zbx_db_result
 #endif
 };
 
-static int		txn_level = 0;	/* transaction level, nested transactions are not supported */
-static int		txn_error = ZBX_DB_OK;	/* failed transaction */
-static int		txn_end_error = ZBX_DB_OK;	/* transaction result */
+/* connection state is thread local to allow history writer thread to use its own connection */
+static ZBX_THREAD_LOCAL int	txn_level = 0;	/* transaction level, nested transactions are not supported */
+static ZBX_THREAD_LOCAL int	txn_error = ZBX_DB_OK;	/* failed transaction */
+static ZBX_THREAD_LOCAL int	txn_end_error = ZBX_DB_OK;	/* transaction result */
 
-static char		*last_db_strerror = NULL;	/* last database error message */
+static ZBX_THREAD_LOCAL char	*last_db_strerror = NULL;	/* last database error message */
 
 static int		config_log_slow_queries;
 
 static int		db_auto_increment;
 
 #if defined(HAVE_MYSQL)
-static MYSQL			*conn = NULL;
+static ZBX_THREAD_LOCAL MYSQL	*conn = NULL;
 static zbx_uint32_t		ZBX_MYSQL_SVERSION = ZBX_DBVERSION_UNDEFINED;
 static int			ZBX_MARIADB_SFORK = OFF;
 #elif defined(HAVE_ORACLE)
@@ -95,18 +96,19 @@ zbx_oracle_db_handle_t;
 
 static zbx_uint32_t		ZBX_ORACLE_SVERSION = ZBX_DBVERSION_UNDEFINED;
 
-static zbx_oracle_db_handle_t	oracle;
+static ZBX_THREAD_LOCAL zbx_oracle_db_handle_t	oracle;
 
 static ub4	OCI_DBserver_status(void);
 
 #define ORA_ERR_UNIQ_CONSTRAINT	-1
 
 #elif defined(HAVE_POSTGRESQL)
-static PGconn			*conn = NULL;
-static unsigned int		ZBX_PG_BYTEAOID = 0;
+static ZBX_THREAD_LOCAL PGconn	*conn = NULL;
+/* server version and settings are set on connect, so every thread has values of its own connection */
+static ZBX_THREAD_LOCAL unsigned int	ZBX_PG_BYTEAOID = 0;
 static int			ZBX_TSDB_VERSION = -1;
-static zbx_uint32_t		ZBX_PG_SVERSION = ZBX_DBVERSION_UNDEFINED;
-char				ZBX_PG_ESCAPE_BACKSLASH = 1;
+static ZBX_THREAD_LOCAL zbx_uint32_t	ZBX_PG_SVERSION = ZBX_DBVERSION_UNDEFINED;
+static ZBX_THREAD_LOCAL char	ZBX_PG_ESCAPE_BACKSLASH = 1;
 static int 			ZBX_TIMESCALE_COMPRESSION_AVAILABLE = OFF;
 #elif defined(HAVE_SQLITE3)
 static sqlite3			*conn = NULL;
@@ -118,7 +120,7 @@ static void	OCI_DBclean_result_handle(zbx_db_result_t result);
 static void	OCI_DBclean_result(zbx_db_result_t result);
 #endif
 
-static zbx_err_codes_t last_db_errcode;
+static ZBX_THREAD_LOCAL zbx_err_codes_t	last_db_errcode;
 
 static void	zbx_db_errlog(zbx_err_codes_t zbx_errno, int db_errno, const char *db_error, const char *context)
 {
@@ -195,7 +197,7 @@ zbx_err_codes_t	zbx_db_last_errcode(void)
 #if defined(HAVE_ORACLE)
 static const char	*zbx_oci_error(sword status, sb4 *err)
 {
-	static char	errbuf[512];
+	static ZBX_THREAD_LOCAL char	errbuf[512];
 	sb4		errcode, *perrcode;
 
 	perrcode = (NULL == err ? &errcode : err);
@@ -792,6 +794,8 @@ int	zbx_db_connect_basic(const zbx_config_dbhigh_t *cfg)
 	if (ZBX_DB_FAIL == ret || ZBX_DB_DOWN == ret)
 		goto out;
 
+	ZBX_PG_SVERSION = (zbx_uint32_t)PQserverVersion(conn);
+
 	result = zbx_db_select_basic("select oid from pg_type where typname='bytea'");
 
 	if ((zbx_db_result_t)ZBX_DB_DOWN == result || NULL == result)
@@ -1619,6 +1623,130 @@ clean:
 	return ret;
 }
 
+#if defined(HAVE_POSTGRESQL)
+/* the maximum size of data sent to server with single PQputCopyData() call */
+#define ZBX_DB_COPY_CHUNK_SIZE	(ZBX_MEBIBYTE)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes COPY FROM STDIN statement                                *
+ *                                                                            *
+ * Parameters: sql      - [IN] the COPY statement                             *
+ *             data     - [IN] the rows in COPY text format                   *
+ *             data_len - [IN] the data length in bytes                       *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ * Comments: Failed COPY does not mark transaction as failed - it is up to    *
+ *           the caller to roll back to a savepoint made before the COPY and  *
+ *           retry with other statements.                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_from(const char *sql, const char *data, size_t data_len)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK;
+	size_t		offset, size;
+	double		sec = 0;
+
+	if (0 != config_log_slow_queries)
+		sec = zbx_time();
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] data size:" ZBX_FS_SIZE_T, txn_level, sql,
+			(zbx_fs_size_t)data_len);
+
+	if (NULL == (result = PQexec(conn, sql)))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		return CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN;
+	}
+
+	if (PGRES_COPY_IN != PQresultStatus(result))
+	{
+		zbx_postgresql_error(&error, result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		PQclear(result);
+
+		return ret;
+	}
+
+	PQclear(result);
+
+	for (offset = 0; offset < data_len; offset += size)
+	{
+		size = MIN(data_len - offset, ZBX_DB_COPY_CHUNK_SIZE);
+
+		if (1 != PQputCopyData(conn, data + offset, (int)size))
+		{
+			zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+			return ZBX_DB_DOWN;
+		}
+	}
+
+	if (1 != PQputCopyEnd(conn, NULL))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+		return ZBX_DB_DOWN;
+	}
+
+	if (NULL == (result = PQgetResult(conn)))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+	else
+	{
+		if (PGRES_COMMAND_OK != PQresultStatus(result))
+		{
+			zbx_err_codes_t	errcode;
+
+			zbx_postgresql_error(&error, result);
+
+			if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "23505"))
+				errcode = ERR_Z3008;
+			else
+				errcode = ERR_Z3005;
+
+			zbx_db_errlog(errcode, 0, error, sql);
+			zbx_free(error);
+
+			ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		}
+		else
+			ret = atoi(PQcmdTuples(result));
+
+		PQclear(result);
+
+		/* consume the remaining results to return connection into idle state */
+		while (NULL != (result = PQgetResult(conn)))
+			PQclear(result);
+	}
+
+	if (0 != config_log_slow_queries)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)config_log_slow_queries / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	return ret;
+}
+
+#undef ZBX_DB_COPY_CHUNK_SIZE
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute a select statement                                        *
@@ -1998,7 +2126,7 @@ zbx_db_row_t	zbx_db_fetch_basic(zbx_db_result_t result)
 #if defined(HAVE_ORACLE)
 	int		i;
 	sword		rc;
-	static char	errbuf[512];
+	static ZBX_THREAD_LOCAL char	errbuf[512];
 	sb4		errcode;
 #endif
 
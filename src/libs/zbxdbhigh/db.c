@@ -62,7 +62,7 @@
 
 ZBX_PTR_VECTOR_IMPL(db_event, zbx_db_event *)
 
-static int	connection_failure;
+static ZBX_THREAD_LOCAL int	connection_failure;
 
 static const zbx_config_dbhigh_t	*zbx_cfg_dbhigh = NULL;
 
@@ -1640,7 +1640,7 @@ out:
  ******************************************************************************/
 const char	*zbx_db_sql_id_cmp(zbx_uint64_t id)
 {
-	static char		buf[22];	/* 1 - '=', 20 - value size, 1 - '\0' */
+	static ZBX_THREAD_LOCAL char	buf[22];	/* 1 - '=', 20 - value size, 1 - '\0' */
 	static const char	is_null[9] = " is null";
 
 	if (0 == id)
@@ -1804,8 +1804,8 @@ clean:
  ******************************************************************************/
 const char	*zbx_db_sql_id_ins(zbx_uint64_t id)
 {
-	static unsigned char	n = 0;
-	static char		buf[4][21];	/* 20 - value size, 1 - '\0' */
+	static ZBX_THREAD_LOCAL unsigned char	n = 0;
+	static ZBX_THREAD_LOCAL char		buf[4][21];	/* 20 - value size, 1 - '\0' */
 	static const char	null[5] = "null";
 
 	if (0 == id)
@@ -2593,6 +2593,294 @@ static char	*zbx_db_format_values(zbx_db_field_t **fields, const zbx_db_value_t
 }
 #endif
 
+/* history and trends tables tracked by bulk insert statistics and written with COPY on PostgreSQL */
+static const char	*db_insert_stats_tables[ZBX_DB_INSERT_STATS_TABLES_NUM] = {"history", "history_uint",
+		"history_str", "history_log", "history_text", "trends", "trends_uint"};
+
+/* the bulk insert statistics of the current thread */
+static ZBX_THREAD_LOCAL zbx_db_insert_stats_t	db_insert_stats[ZBX_DB_INSERT_STATS_TABLES_NUM];
+
+static int	db_insert_stats_index(const char *table)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DB_INSERT_STATS_TABLES_NUM; i++)
+	{
+		if (0 == strcmp(table, db_insert_stats_tables[i]))
+			return i;
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns name of the table tracked by bulk insert statistics       *
+ *                                                                            *
+ * Parameters: index - [IN] the table index (0..ZBX_DB_INSERT_STATS_TABLES_NUM-1) *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_db_insert_stats_table(int index)
+{
+	return db_insert_stats_tables[index];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds bulk insert statistics of the current thread to the          *
+ *          specified statistics and resets them                              *
+ *                                                                            *
+ * Parameters: stats - [IN/OUT] array of ZBX_DB_INSERT_STATS_TABLES_NUM       *
+ *                              statistics                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_insert_stats_collect(zbx_db_insert_stats_t *stats)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DB_INSERT_STATS_TABLES_NUM; i++)
+	{
+		stats[i].rows += db_insert_stats[i].rows;
+		stats[i].bytes += db_insert_stats[i].bytes;
+		stats[i].copy_rows += db_insert_stats[i].copy_rows;
+		stats[i].copy_fallbacks += db_insert_stats[i].copy_fallbacks;
+		stats[i].time += db_insert_stats[i].time;
+	}
+
+	memset(db_insert_stats, 0, sizeof(db_insert_stats));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends string to COPY data in text format                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_strcpy_alloc(char **data, size_t *data_alloc, size_t *data_offset, const char *src)
+{
+	size_t	len;
+
+	while (1)
+	{
+		len = strcspn(src, "\\\t\n\r");
+		zbx_strncpy_alloc(data, data_alloc, data_offset, src, len);
+		src += len;
+
+		switch (*src++)
+		{
+			case '\\':
+				zbx_strcpy_alloc(data, data_alloc, data_offset, "\\\\");
+				break;
+			case '\t':
+				zbx_strcpy_alloc(data, data_alloc, data_offset, "\\t");
+				break;
+			case '\n':
+				zbx_strcpy_alloc(data, data_alloc, data_offset, "\\n");
+				break;
+			case '\r':
+				zbx_strcpy_alloc(data, data_alloc, data_offset, "\\r");
+				break;
+			default:
+				return;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: formats bulk insert rows in COPY text format                      *
+ *                                                                            *
+ * Parameters: self        - [IN] the bulk insert data with unescaped strings *
+ *             data        - [IN/OUT] the formatted rows                      *
+ *             data_alloc  - [IN/OUT] the allocated size of data              *
+ *             data_offset - [IN/OUT] the data length                         *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were formatted                            *
+ *               FAIL    - the fields cannot be written with COPY             *
+ *                                                                            *
+ * Comments: Columns are separated by tab and rows are terminated by newline, *
+ *           so tab, newline, carriage return and backslash in strings are    *
+ *           escaped. Zero IDs are written as NULL (\N).                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_insert_format_copy(const zbx_db_insert_t *self, char **data, size_t *data_alloc, size_t *data_offset)
+{
+	const zbx_db_field_t	*field;
+	int			i, j;
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		const zbx_db_value_t	*values = (const zbx_db_value_t *)self->rows.values[i];
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_value_t	*value = &values[j];
+
+			field = (const zbx_db_field_t *)self->fields.values[j];
+
+			if (0 != j)
+				zbx_chrcpy_alloc(data, data_alloc, data_offset, '\t');
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+					db_copy_strcpy_alloc(data, data_alloc, data_offset, value->str);
+					break;
+				case ZBX_TYPE_INT:
+					zbx_snprintf_alloc(data, data_alloc, data_offset, "%d", value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(data, data_alloc, data_offset, ZBX_FS_DBL64, value->dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					zbx_snprintf_alloc(data, data_alloc, data_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					if (0 == value->ui64)
+					{
+						zbx_strcpy_alloc(data, data_alloc, data_offset, "\\N");
+						break;
+					}
+
+					zbx_snprintf_alloc(data, data_alloc, data_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					return FAIL;
+			}
+		}
+
+		zbx_chrcpy_alloc(data, data_alloc, data_offset, '\n');
+	}
+
+	return SUCCEED;
+}
+
+#ifdef HAVE_POSTGRESQL
+/* the minimum number of rows to write with COPY, smaller batches are not worth the savepoint overhead */
+#define ZBX_DB_COPY_ROWS_MIN	16
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes bulk insert rows with COPY                                 *
+ *                                                                            *
+ * Parameters: self  - [IN] the bulk insert data                              *
+ *             bytes - [OUT] the size of written data                         *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were written                              *
+ *               FAIL    - the rows must be written with INSERT               *
+ *                                                                            *
+ * Comments: Inside transaction COPY is protected by savepoint, so that       *
+ *           failed COPY can be rolled back and retried with INSERT.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_copy(const zbx_db_insert_t *self, size_t *bytes)
+{
+	char			*sql = NULL, *data = NULL, delim[2] = {',', '('};
+	size_t			sql_alloc = 0, sql_offset = 0, data_alloc = 0, data_offset = 0;
+	int			i, rc, ret = FAIL, savepoint = 0;
+	const zbx_db_field_t	*field;
+
+	if (ZBX_DB_COPY_ROWS_MIN > self->rows.values_num)
+		return FAIL;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s ", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const zbx_db_field_t *)self->fields.values[i];
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, delim[0 == i]);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin");
+
+	data_alloc = (size_t)self->rows.values_num * 64;
+	data = (char *)zbx_malloc(NULL, data_alloc);
+
+	if (SUCCEED != zbx_db_insert_format_copy(self, &data, &data_alloc, &data_offset))
+		goto out;
+
+	if (0 < zbx_db_txn_level())
+	{
+		if (ZBX_DB_OK > zbx_db_execute("savepoint zbx_copy"))
+			goto out;
+
+		savepoint = 1;
+	}
+
+	if (ZBX_DB_OK <= (rc = zbx_db_copy_from(sql, data, data_offset)))
+	{
+		if (0 != savepoint)
+			zbx_db_execute("release savepoint zbx_copy");
+
+		*bytes = data_offset;
+		ret = SUCCEED;
+		goto out;
+	}
+
+	/* lost connection is not a COPY failure, INSERT will fail the same way */
+	if (ZBX_DB_FAIL == rc)
+	{
+		if (0 != savepoint)
+			zbx_db_execute("rollback to savepoint zbx_copy");
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write %d rows into table \"%s\" with COPY, retrying with INSERT",
+				self->rows.values_num, self->table->table);
+
+		db_insert_stats[self->stats_index].copy_fallbacks++;
+	}
+out:
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: escapes string values stored for COPY to be used in INSERT        *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_insert_escape_strings(zbx_db_insert_t *self)
+{
+	int	i, j;
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*row = (zbx_db_value_t *)self->rows.values[i];
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			zbx_db_field_t	*field = (zbx_db_field_t *)self->fields.values[j];
+			char		*str;
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+					/* values are already truncated to field length */
+					str = zbx_db_dyn_escape_string(row[j].str);
+					zbx_free(row[j].str);
+					row[j].str = str;
+					break;
+			}
+		}
+	}
+
+	self->copy = 0;
+}
+
+#undef ZBX_DB_COPY_ROWS_MIN
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: releases resources allocated by bulk insert operations            *
@@ -2669,6 +2957,12 @@ void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const zbx_db_table_t *tabl
 
 	self->autoincrement = -1;
 	self->lastid = 0;
+	self->stats_index = db_insert_stats_index(table->table);
+#ifdef HAVE_POSTGRESQL
+	self->copy = (-1 != self->stats_index);
+#else
+	self->copy = 0;
+#endif
 
 	zbx_vector_ptr_create(&self->fields);
 	zbx_vector_ptr_create(&self->rows);
@@ -2771,7 +3065,9 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, zbx_db_value_t **values
 #ifdef HAVE_ORACLE
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
-				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+				/* values for COPY are escaped when formatting COPY data */
+				row[i].str = DBdyn_escape_field_len(field, value->str,
+						0 == self->copy ? ESCAPE_SEQUENCE_ON : ESCAPE_SEQUENCE_OFF);
 #endif
 				break;
 			case ZBX_TYPE_INT:
@@ -2905,11 +3201,12 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 	int			ret = FAIL, i, j;
 	const zbx_db_field_t	*field;
 	char			*sql_command, delim[2] = {',', '('};
-	size_t			sql_command_alloc = 512, sql_command_offset = 0;
+	size_t			sql_command_alloc = 512, sql_command_offset = 0, bytes = 0;
+	double			time_start;
 
 #ifndef HAVE_ORACLE
 	char		*sql;
-	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
+	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0, row_offset;
 
 #	ifdef HAVE_MYSQL
 	char		*sql_values = NULL;
@@ -2942,6 +3239,22 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		self->autoincrement = -1;
 	}
 
+	time_start = zbx_time();
+
+#ifdef HAVE_POSTGRESQL
+	if (0 != self->copy)
+	{
+		if (SUCCEED == db_insert_copy(self, &bytes))
+		{
+			db_insert_stats[self->stats_index].copy_rows += (zbx_uint64_t)self->rows.values_num;
+			ret = SUCCEED;
+			goto stats;
+		}
+
+		db_insert_escape_strings(self);
+	}
+#endif
+
 #ifndef HAVE_ORACLE
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 #endif
@@ -3056,6 +3369,7 @@ retry_oracle:
 	{
 		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
 
+		row_offset = sql_offset;
 #	ifdef HAVE_MULTIROW_INSERT
 		if (16 > sql_offset)
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_command);
@@ -3116,6 +3430,7 @@ retry_oracle:
 #	endif
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ")" ZBX_ROW_DL);
+		bytes += sql_offset - row_offset;
 
 		if (SUCCEED != (ret = zbx_db_execute_overflowed_sql(&sql, &sql_alloc, &sql_offset)))
 			goto out;
@@ -3149,6 +3464,18 @@ out:
 #else
 	zbx_free(contexts);
 #endif
+#ifdef HAVE_POSTGRESQL
+stats:
+#endif
+	if (SUCCEED == ret && -1 != self->stats_index)
+	{
+		zbx_db_insert_stats_t	*stats = &db_insert_stats[self->stats_index];
+
+		stats->rows += (zbx_uint64_t)self->rows.values_num;
+		stats->bytes += bytes;
+		stats->time += zbx_time() - time_start;
+	}
+
 	return ret;
 }
 
@@ -140,6 +140,18 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 
 	zbx_unblock_signals(&orig_mask);
 
+	if (0 != dbsyncer_args->config_history_sync_pipeline && 0 != (info->program_type & ZBX_PROGRAM_TYPE_SERVER))
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != zbx_hc_writer_start(&error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot start history writer, history will be synced without"
+					" pipelining: %s", error);
+			zbx_free(error);
+		}
+	}
+
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_HISTORY))
 		history_export = zbx_history_export_init(get_history_export, "history-syncer", process_num);
 
@@ -149,6 +161,19 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_EVENTS))
 		problems_export = zbx_problems_export_init(get_problems_export, "history-syncer", process_num);
 
+	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_HISTORY | ZBX_FLAG_EXPTYPE_TRENDS |
+			ZBX_FLAG_EXPTYPE_EVENTS))
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != zbx_export_writer_start(&error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot start export writer, export files will be written by"
+					" history syncer: %s", error);
+			zbx_free(error);
+		}
+	}
+
 	for (;;)
 	{
 		sec = zbx_time();
@@ -225,11 +250,14 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 	if (SUCCEED != zbx_db_trigger_queue_locked())
 		zbx_db_flush_timer_queue();
 
+	zbx_hc_writer_stop();
 	zbx_db_close();
 	zbx_unblock_signals(&orig_mask);
 
 	zbx_log_sync_history_cache_progress();
 
+	zbx_export_writer_stop();
+
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_HISTORY))
 		zbx_export_deinit(history_export);
 
@@ -1707,6 +1707,111 @@ static int	DBpatch_6050143(void)
 	return SUCCEED;
 }
 
+static int	DBpatch_6050144(void)
+{
+	return DBcreate_changelog_insert_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_6050145(void)
+{
+	return DBcreate_changelog_update_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_6050146(void)
+{
+	return DBcreate_changelog_delete_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_6050147(void)
+{
+	return DBcreate_changelog_insert_trigger("hstgrp", "groupid");
+}
+
+static int	DBpatch_6050148(void)
+{
+	return DBcreate_changelog_update_trigger("hstgrp", "groupid");
+}
+
+static int	DBpatch_6050149(void)
+{
+	return DBcreate_changelog_delete_trigger("hstgrp", "groupid");
+}
+
+static int	DBpatch_6050150(void)
+{
+	return DBcreate_changelog_insert_trigger("actions", "actionid");
+}
+
+static int	DBpatch_6050151(void)
+{
+	return DBcreate_changelog_update_trigger("actions", "actionid");
+}
+
+static int	DBpatch_6050152(void)
+{
+	return DBcreate_changelog_delete_trigger("actions", "actionid");
+}
+
+static int	DBpatch_6050153(void)
+{
+	return DBcreate_changelog_insert_trigger("correlation", "correlationid");
+}
+
+static int	DBpatch_6050154(void)
+{
+	return DBcreate_changelog_update_trigger("correlation", "correlationid");
+}
+
+static int	DBpatch_6050155(void)
+{
+	return DBcreate_changelog_delete_trigger("correlation", "correlationid");
+}
+
+static int	DBpatch_6050156(void)
+{
+	return DBcreate_changelog_insert_trigger("maintenances", "maintenanceid");
+}
+
+static int	DBpatch_6050157(void)
+{
+	return DBcreate_changelog_update_trigger("maintenances", "maintenanceid");
+}
+
+static int	DBpatch_6050158(void)
+{
+	return DBcreate_changelog_delete_trigger("maintenances", "maintenanceid");
+}
+
+static int	DBpatch_6050159(void)
+{
+	return DBcreate_changelog_insert_trigger("config", "configid");
+}
+
+static int	DBpatch_6050160(void)
+{
+	return DBcreate_changelog_update_trigger("config", "configid");
+}
+
+static int	DBpatch_6050161(void)
+{
+	return DBcreate_changelog_delete_trigger("config", "configid");
+}
+
+static int	DBpatch_6050162(void)
+{
+	return DBcreate_changelog_insert_trigger("config_autoreg_tls", "autoreg_tlsid");
+}
+
+static int	DBpatch_6050163(void)
+{
+	return DBcreate_changelog_update_trigger("config_autoreg_tls", "autoreg_tlsid");
+}
+
+static int	DBpatch_6050164(void)
+{
+	return DBcreate_changelog_delete_trigger("config_autoreg_tls", "autoreg_tlsid");
+}
+
 #endif
 
 DBPATCH_START(6050)
@@ -1855,5 +1960,26 @@ DBPATCH_ADD(6050140, 0, 1)
 DBPATCH_ADD(6050141, 0, 1)
 DBPATCH_ADD(6050142, 0, 1)
 DBPATCH_ADD(6050143, 0, 1)
+DBPATCH_ADD(6050144, 0, 1)
+DBPATCH_ADD(6050145, 0, 1)
+DBPATCH_ADD(6050146, 0, 1)
+DBPATCH_ADD(6050147, 0, 1)
+DBPATCH_ADD(6050148, 0, 1)
+DBPATCH_ADD(6050149, 0, 1)
+DBPATCH_ADD(6050150, 0, 1)
+DBPATCH_ADD(6050151, 0, 1)
+DBPATCH_ADD(6050152, 0, 1)
+DBPATCH_ADD(6050153, 0, 1)
+DBPATCH_ADD(6050154, 0, 1)
+DBPATCH_ADD(6050155, 0, 1)
+DBPATCH_ADD(6050156, 0, 1)
+DBPATCH_ADD(6050157, 0, 1)
+DBPATCH_ADD(6050158, 0, 1)
+DBPATCH_ADD(6050159, 0, 1)
+DBPATCH_ADD(6050160, 0, 1)
+DBPATCH_ADD(6050161, 0, 1)
+DBPATCH_ADD(6050162, 0, 1)
+DBPATCH_ADD(6050163, 0, 1)
+DBPATCH_ADD(6050164, 0, 1)
 
 DBPATCH_END()
@@ -23,6 +23,7 @@
 #include "zbxalgo.h"
 #include "zbxshmem.h"
 #include "zbxcachehistory.h"
+#include "zbxcacheconfig.h"
 #include "zbxconnector.h"
 #include "zbxlog.h"
 #include "zbxmutexs.h"
@@ -37,6 +38,7 @@
 #define ZBX_DIAG_HISTORYCACHE_VALUES		0x00000002
 #define ZBX_DIAG_HISTORYCACHE_MEMORY_DATA	0x00000004
 #define ZBX_DIAG_HISTORYCACHE_MEMORY_INDEX	0x00000008
+#define ZBX_DIAG_HISTORYCACHE_SHARDS		0x00000010
 
 #define ZBX_DIAG_HISTORYCACHE_SIMPLE	(ZBX_DIAG_HISTORYCACHE_ITEMS | \
 					ZBX_DIAG_HISTORYCACHE_VALUES)
@@ -47,6 +49,10 @@
 #define ZBX_DIAG_CONNECTOR_VALUES			0x00000001
 #define ZBX_DIAG_CONNECTOR_SIMPLE		(ZBX_DIAG_CONNECTOR_VALUES)
 
+#define ZBX_DIAG_CONFIGCACHE_SYNC	0x00000001
+#define ZBX_DIAG_CONFIGCACHE_LOCK	0x00000002
+#define ZBX_DIAG_CONFIGCACHE_TABLES	0x00000004
+
 static zbx_diag_add_section_info_func_t	add_diag_cb;
 
 void	zbx_diag_map_free(zbx_diag_map_t *map)
@@ -200,6 +206,29 @@ void	zbx_diag_add_mem_stats(struct zbx_json *json, const char *name, const zbx_s
 
 	zbx_json_close(json);
 	zbx_json_close(json);
+
+	if (0 != stats->slab_classes_num)
+	{
+		zbx_json_addarray(json, "slabs");
+
+		for (i = 0; i < stats->slab_classes_num; i++)
+		{
+			const zbx_shmem_slab_stats_t	*slab_class = &stats->slab_classes[i];
+
+			zbx_json_addobject(json, NULL);
+			zbx_json_adduint64(json, "size", slab_class->size);
+			zbx_json_adduint64(json, "slabs", slab_class->slabs_num);
+			zbx_json_adduint64(json, "used", slab_class->used_num);
+			zbx_json_adduint64(json, "free", slab_class->free_num);
+			zbx_json_addfloat(json, "pused", 0 == slab_class->used_num ? 0 : 100 *
+					(double)slab_class->used_num / (double)(slab_class->used_num +
+					slab_class->free_num));
+			zbx_json_close(json);
+		}
+
+		zbx_json_close(json);
+	}
+
 	zbx_json_close(json);
 }
 
@@ -243,6 +272,35 @@ static void	diag_historycache_add_items(struct zbx_json *json, const char *field
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add history cache shards diagnostic statistics to json            *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_historycache_add_shards(struct zbx_json *json, const zbx_hc_shard_stats_t *shards,
+		int shards_num)
+{
+	int	i;
+
+	zbx_json_addarray(json, "shards");
+
+	for (i = 0; i < shards_num; i++)
+	{
+		zbx_json_addobject(json, NULL);
+		zbx_json_adduint64(json, "items", shards[i].items_num);
+		zbx_json_adduint64(json, "values", shards[i].values_num);
+		zbx_json_adduint64(json, "data.free", shards[i].history_free);
+		zbx_json_adduint64(json, "data.total", shards[i].history_total);
+		zbx_json_adduint64(json, "index.free", shards[i].index_free);
+		zbx_json_adduint64(json, "index.total", shards[i].index_total);
+		zbx_json_adduint64(json, "locks", shards[i].lock_num);
+		zbx_json_addfloat(json, "lock.wait", shards[i].lock_wait);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add requested history cache diagnostic information to json data   *
@@ -262,12 +320,14 @@ int	zbx_diag_add_historycache_info(const struct zbx_json_parse *jp, struct zbx_j
 	double			time1, time2, time_total = 0;
 	zbx_uint64_t		fields;
 	zbx_diag_map_t		field_map[] = {
-					{"", ZBX_DIAG_HISTORYCACHE_SIMPLE | ZBX_DIAG_HISTORYCACHE_MEMORY},
+					{"", ZBX_DIAG_HISTORYCACHE_SIMPLE | ZBX_DIAG_HISTORYCACHE_MEMORY |
+							ZBX_DIAG_HISTORYCACHE_SHARDS},
 					{"items", ZBX_DIAG_HISTORYCACHE_ITEMS},
 					{"values", ZBX_DIAG_HISTORYCACHE_VALUES},
 					{"memory", ZBX_DIAG_HISTORYCACHE_MEMORY},
 					{"memory.data", ZBX_DIAG_HISTORYCACHE_MEMORY_DATA},
 					{"memory.index", ZBX_DIAG_HISTORYCACHE_MEMORY_INDEX},
+					{"shards", ZBX_DIAG_HISTORYCACHE_SHARDS},
 					{NULL, 0}
 					};
 
@@ -312,6 +372,19 @@ int	zbx_diag_add_historycache_info(const struct zbx_json_parse *jp, struct zbx_j
 			zbx_json_close(json);
 		}
 
+		if (0 != (fields & ZBX_DIAG_HISTORYCACHE_SHARDS))
+		{
+			zbx_hc_shard_stats_t	shards[ZBX_HC_SHARDS_MAX];
+			int			shards_num;
+
+			time1 = zbx_time();
+			shards_num = zbx_hc_get_shard_stats(shards);
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			diag_historycache_add_shards(json, shards, shards_num);
+		}
+
 		if (0 != tops.values_num)
 		{
 			zbx_json_addobject(json, "top");
@@ -361,6 +434,110 @@ int	zbx_diag_add_historycache_info(const struct zbx_json_parse *jp, struct zbx_j
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add configuration cache table sync statistics to json             *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_configcache_add_tables(struct zbx_json *json, const zbx_dc_sync_stats_t *stats)
+{
+	int	i;
+
+	zbx_json_addarray(json, "tables");
+
+	for (i = 0; i < stats->tables_num; i++)
+	{
+		const zbx_dc_sync_table_stats_t	*table = &stats->tables[i];
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addstring(json, "table", table->name, ZBX_JSON_TYPE_STRING);
+		zbx_json_addfloat(json, "sql", table->sql_sec);
+		zbx_json_addfloat(json, "sync", table->sync_sec);
+		zbx_json_adduint64(json, "add", table->add_num);
+		zbx_json_adduint64(json, "update", table->update_num);
+		zbx_json_adduint64(json, "remove", table->remove_num);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add requested configuration cache diagnostic information to json  *
+ *          data                                                              *
+ *                                                                            *
+ * Parameters: jp    - [IN] the request                                       *
+ *             json  - [IN/OUT] the json to update                            *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the information was added successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_diag_add_configcache_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error)
+{
+	zbx_vector_ptr_t	tops;
+	int			ret;
+	double			time1;
+	zbx_uint64_t		fields;
+	zbx_dc_sync_stats_t	stats;
+	zbx_diag_map_t		field_map[] = {
+					{"", ZBX_DIAG_CONFIGCACHE_SYNC | ZBX_DIAG_CONFIGCACHE_LOCK |
+							ZBX_DIAG_CONFIGCACHE_TABLES},
+					{"sync", ZBX_DIAG_CONFIGCACHE_SYNC},
+					{"lock", ZBX_DIAG_CONFIGCACHE_LOCK},
+					{"tables", ZBX_DIAG_CONFIGCACHE_TABLES},
+					{NULL, 0}
+					};
+
+	zbx_vector_ptr_create(&tops);
+
+	if (SUCCEED == (ret = zbx_diag_parse_request(jp, field_map, &fields, &tops, error)))
+	{
+		if (0 != tops.values_num)
+		{
+			*error = zbx_dsprintf(*error, "Unsupported top field: %s",
+					((zbx_diag_map_t *)tops.values[0])->name);
+			ret = FAIL;
+			goto out;
+		}
+
+		time1 = zbx_time();
+		zbx_dc_get_sync_stats(&stats);
+
+		zbx_json_addobject(json, ZBX_DIAG_CONFIGCACHE);
+
+		if (0 != (fields & ZBX_DIAG_CONFIGCACHE_SYNC))
+		{
+			zbx_json_addstring(json, "mode", (ZBX_DBSYNC_INIT == stats.mode ? "full" : "incremental"),
+					ZBX_JSON_TYPE_STRING);
+			zbx_json_addint64(json, "clock", stats.sync_ts);
+			zbx_json_addint64(json, "changelog", stats.changelog_num);
+			zbx_json_addfloat(json, "changelog.time", stats.changelog_sec);
+			zbx_json_addfloat(json, "sync.time", stats.total_sec);
+		}
+
+		if (0 != (fields & ZBX_DIAG_CONFIGCACHE_LOCK))
+		{
+			zbx_json_addint64(json, "locks", stats.lock_num);
+			zbx_json_addfloat(json, "lock.time", stats.lock_sec);
+			zbx_json_addfloat(json, "lock.max", stats.lock_max_sec);
+		}
+
+		if (0 != (fields & ZBX_DIAG_CONFIGCACHE_TABLES))
+			diag_configcache_add_tables(json, &stats);
+
+		zbx_json_addfloat(json, "time", zbx_time() - time1);
+		zbx_json_close(json);
+	}
+out:
+	zbx_vector_ptr_clear_ext(&tops, (zbx_ptr_free_func_t)zbx_diag_map_free);
+	zbx_vector_ptr_destroy(&tops);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add top list to output json                                       *
@@ -413,14 +590,14 @@ void	zbx_diag_add_locks_info(struct zbx_json *json)
 {
 	int		i;
 #ifdef HAVE_VMINFO_T_UPDATES
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
+	const char	*names[ZBX_MUTEX_CACHE_SHARD] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
 				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_REMOTE_COMMANDS", "ZBX_MUTEX_PROXY_BUFFER",
 				"ZBX_MUTEX_VPS_MONITOR"};
 #else
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
+	const char	*names[ZBX_MUTEX_CACHE_SHARD] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
@@ -429,13 +606,23 @@ void	zbx_diag_add_locks_info(struct zbx_json *json)
 #endif
 	zbx_json_addarray(json, ZBX_DIAG_LOCKS);
 
-	for (i = 0; i < ZBX_MUTEX_COUNT; i++)
+	for (i = 0; i < ZBX_MUTEX_CACHE_SHARD; i++)
 	{
 		zbx_json_addobject(json, NULL);
 		zbx_json_addhex(json, names[i], (zbx_uint64_t)zbx_mutex_addr_get(i));
 		zbx_json_close(json);
 	}
 
+	for (i = ZBX_MUTEX_CACHE_SHARD; i < ZBX_MUTEX_COUNT; i++)
+	{
+		char	name[ZBX_DIAG_FIELD_MAX];
+
+		zbx_snprintf(name, sizeof(name), "ZBX_MUTEX_CACHE_SHARD_%d", i - ZBX_MUTEX_CACHE_SHARD);
+		zbx_json_addobject(json, NULL);
+		zbx_json_addhex(json, name, (zbx_uint64_t)zbx_mutex_addr_get(i));
+		zbx_json_close(json);
+	}
+
 	zbx_json_addobject(json, NULL);
 	zbx_json_addhex(json, "ZBX_RWLOCK_CONFIG", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_CONFIG));
 	zbx_json_close(json);
@@ -538,10 +725,10 @@ static void	diag_prepare_default_request(struct zbx_json *j, unsigned int flags)
 		diag_add_section_request(j, ZBX_DIAG_VALUECACHE, "values", "request.values", NULL);
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_PREPROCESSING)))
-		diag_add_section_request(j, ZBX_DIAG_PREPROCESSING, "sequences", NULL);
+		diag_add_section_request(j, ZBX_DIAG_PREPROCESSING, "sequences", "prefixes", NULL);
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_LLD)))
-		diag_add_section_request(j, ZBX_DIAG_LLD, "values", NULL);
+		diag_add_section_request(j, ZBX_DIAG_LLD, "values", "time", NULL);
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_ALERTING)))
 		diag_add_section_request(j, ZBX_DIAG_ALERTING, "media.alerts", "source.alerts", NULL);
@@ -555,6 +742,9 @@ static void	diag_prepare_default_request(struct zbx_json *j, unsigned int flags)
 	if (0 != (flags & (1 << ZBX_DIAGINFO_PROXYBUFFER)))
 		diag_add_section_request(j, ZBX_DIAG_PROXYBUFFER, NULL);
 
+	if (0 != (flags & (1 << ZBX_DIAGINFO_CONFIGCACHE)))
+		diag_add_section_request(j, ZBX_DIAG_CONFIGCACHE, NULL);
+
 }
 
 /******************************************************************************
@@ -768,6 +958,7 @@ static void	diag_log_lld(struct zbx_json_parse *jp, char **out, size_t *out_allo
 	zbx_free(msg);
 
 	diag_log_top_view(jp, "top.values", "$.top.values", out, out_alloc, out_offset);
+	diag_log_top_view(jp, "top.time", "$.top.time", out, out_alloc, out_offset);
 
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
 }
@@ -832,6 +1023,27 @@ static void	diag_log_proxybuffer(struct zbx_json_parse *jp, char **out, size_t *
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: log configuration cache diagnostic information                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_log_configcache(struct zbx_json_parse *jp, char **out, size_t *out_alloc, size_t *out_offset)
+{
+	char	*msg = NULL;
+
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset,
+			"== configuration cache diagnostic information ==");
+
+	diag_get_simple_values(jp, &msg);
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "%s", msg);
+	zbx_free(msg);
+
+	diag_log_top_view(jp, "tables", "$.tables", out, out_alloc, out_offset);
+
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: log diagnostic information                                        *
@@ -898,6 +1110,8 @@ void	zbx_diag_log_info(unsigned int flags, char **result)
 				diag_log_connector(&jp_section, result, &result_alloc, &result_offset);
 			else if (0 == strcmp(section, ZBX_DIAG_PROXYBUFFER))
 				diag_log_proxybuffer(&jp_section, result, &result_alloc, &result_offset);
+			else if (0 == strcmp(section, ZBX_DIAG_CONFIGCACHE))
+				diag_log_configcache(&jp_section, result, &result_alloc, &result_offset);
 		}
 	}
 	else
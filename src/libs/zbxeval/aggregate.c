@@ -0,0 +1,844 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxeval.h"
+
+/*
+ * Aggregation kernels over contiguous arrays of numeric values.
+ *
+ * On x86-64 the kernels are implemented with SSE2 (always available) and AVX2 (selected at
+ * runtime if supported by CPU) instructions. Scalar kernels are used on other platforms.
+ * Floating point sums are always calculated sequentially, because vectorized summation
+ * changes the order of additions and the result would depend on CPU. Vectorized kernels
+ * of other functions return the same results as scalar kernels, including NaN handling -
+ * NaN values are skipped by minimum/maximum unless the first value is NaN. Only the sign of
+ * zero minimum/maximum can differ when both positive and negative zeros are present.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__) && (defined(__clang__) || 5 <= __GNUC__)
+#	define ZBX_AGGR_X86
+#	include <immintrin.h>
+#	define ZBX_AGGR_AVX2	__attribute__((target("avx2")))
+#endif
+
+static int	aggr_isa = -1;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the best instruction set supported by CPU                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	aggr_isa_detect(void)
+{
+#if defined(ZBX_AGGR_X86)
+	__builtin_cpu_init();
+
+	if (0 != __builtin_cpu_supports("avx2"))
+		return ZBX_EVAL_AGGR_ISA_AVX2;
+
+	return ZBX_EVAL_AGGR_ISA_SSE2;
+#else
+	return ZBX_EVAL_AGGR_ISA_SCALAR;
+#endif
+}
+
+static int	aggr_isa_get(void)
+{
+	if (-1 == aggr_isa)
+		aggr_isa = aggr_isa_detect();
+
+	return aggr_isa;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: selects instruction set used by aggregation kernels               *
+ *                                                                            *
+ * Parameters: isa - [IN] the instruction set (ZBX_EVAL_AGGR_ISA_*)           *
+ *                                                                            *
+ * Return value: SUCCEED - the instruction set was selected                   *
+ *               FAIL    - the instruction set is not supported               *
+ *                                                                            *
+ * Comments: By default the best supported instruction set is used, this      *
+ *           function is intended for benchmarking and testing.               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_aggr_set_isa(int isa)
+{
+	if (isa < ZBX_EVAL_AGGR_ISA_SCALAR || isa > aggr_isa_detect())
+		return FAIL;
+
+	aggr_isa = isa;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Scalar kernels                                                             *
+ *                                                                            *
+ ******************************************************************************/
+
+static double	aggr_sum_dbl_scalar(const double *values, int values_num)
+{
+	double	sum = 0;
+	int	i;
+
+	for (i = 0; i < values_num; i++)
+		sum += values[i];
+
+	return sum;
+}
+
+static double	aggr_min_dbl_scalar(const double *values, int values_num)
+{
+	double	min = values[0];
+	int	i;
+
+	for (i = 1; i < values_num; i++)
+	{
+		if (values[i] < min)
+			min = values[i];
+	}
+
+	return min;
+}
+
+static double	aggr_max_dbl_scalar(const double *values, int values_num)
+{
+	double	max = values[0];
+	int	i;
+
+	for (i = 1; i < values_num; i++)
+	{
+		if (values[i] > max)
+			max = values[i];
+	}
+
+	return max;
+}
+
+static double	aggr_sumsq_dbl_scalar(const double *values, int values_num, double mean)
+{
+	double	sum = 0;
+	int	i;
+
+	for (i = 0; i < values_num; i++)
+	{
+		double	diff = values[i] - mean;
+
+		sum += diff * diff;
+	}
+
+	return sum;
+}
+
+static int	aggr_count_dbl_scalar(const double *values, int values_num, int op, double pattern, double epsilon)
+{
+	int	i, count = 0;
+
+	switch (op)
+	{
+		case OP_EQ:
+			for (i = 0; i < values_num; i++)
+				count += (fabs(values[i] - pattern) <= epsilon);
+			break;
+		case OP_NE:
+			for (i = 0; i < values_num; i++)
+				count += !(fabs(values[i] - pattern) <= epsilon);
+			break;
+		case OP_GT:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] - pattern > epsilon);
+			break;
+		case OP_GE:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] - pattern >= -epsilon);
+			break;
+		case OP_LT:
+			for (i = 0; i < values_num; i++)
+				count += (pattern - values[i] > epsilon);
+			break;
+		case OP_LE:
+			for (i = 0; i < values_num; i++)
+				count += (pattern - values[i] >= -epsilon);
+			break;
+	}
+
+	return count;
+}
+
+static zbx_uint64_t	aggr_sum_ui64_scalar(const zbx_uint64_t *values, int values_num)
+{
+	zbx_uint64_t	sum = 0;
+	int		i;
+
+	for (i = 0; i < values_num; i++)
+		sum += values[i];
+
+	return sum;
+}
+
+static zbx_uint64_t	aggr_min_ui64_scalar(const zbx_uint64_t *values, int values_num)
+{
+	zbx_uint64_t	min = values[0];
+	int		i;
+
+	for (i = 1; i < values_num; i++)
+	{
+		if (values[i] < min)
+			min = values[i];
+	}
+
+	return min;
+}
+
+static zbx_uint64_t	aggr_max_ui64_scalar(const zbx_uint64_t *values, int values_num)
+{
+	zbx_uint64_t	max = values[0];
+	int		i;
+
+	for (i = 1; i < values_num; i++)
+	{
+		if (values[i] > max)
+			max = values[i];
+	}
+
+	return max;
+}
+
+static int	aggr_count_ui64_scalar(const zbx_uint64_t *values, int values_num, int op, zbx_uint64_t pattern,
+		zbx_uint64_t mask)
+{
+	int	i, count = 0;
+
+	switch (op)
+	{
+		case OP_EQ:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] == pattern);
+			break;
+		case OP_NE:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] != pattern);
+			break;
+		case OP_GT:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] > pattern);
+			break;
+		case OP_GE:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] >= pattern);
+			break;
+		case OP_LT:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] < pattern);
+			break;
+		case OP_LE:
+			for (i = 0; i < values_num; i++)
+				count += (values[i] <= pattern);
+			break;
+		case OP_BITAND:
+			for (i = 0; i < values_num; i++)
+				count += ((values[i] & mask) == pattern);
+			break;
+	}
+
+	return count;
+}
+
+#if defined(ZBX_AGGR_X86)
+/******************************************************************************
+ *                                                                            *
+ * SSE2 kernels                                                               *
+ *                                                                            *
+ ******************************************************************************/
+
+static double	aggr_min_dbl_sse2(const double *values, int values_num)
+{
+	__m128d	acc;
+	double	min[2];
+	int	i;
+
+	if (2 > values_num)
+		return values[0];
+
+	/* all lanes start with the first value and are replaced only by smaller values, like in scalar kernel */
+	acc = _mm_set1_pd(values[0]);
+
+	for (i = 0; i + 2 <= values_num; i += 2)
+		acc = _mm_min_pd(_mm_loadu_pd(values + i), acc);
+
+	_mm_storeu_pd(min, acc);
+
+	if (min[1] < min[0])
+		min[0] = min[1];
+
+	for (; i < values_num; i++)
+	{
+		if (values[i] < min[0])
+			min[0] = values[i];
+	}
+
+	return min[0];
+}
+
+static double	aggr_max_dbl_sse2(const double *values, int values_num)
+{
+	__m128d	acc;
+	double	max[2];
+	int	i;
+
+	if (2 > values_num)
+		return values[0];
+
+	/* all lanes start with the first value and are replaced only by greater values, like in scalar kernel */
+	acc = _mm_set1_pd(values[0]);
+
+	for (i = 0; i + 2 <= values_num; i += 2)
+		acc = _mm_max_pd(_mm_loadu_pd(values + i), acc);
+
+	_mm_storeu_pd(max, acc);
+
+	if (max[1] > max[0])
+		max[0] = max[1];
+
+	for (; i < values_num; i++)
+	{
+		if (values[i] > max[0])
+			max[0] = values[i];
+	}
+
+	return max[0];
+}
+
+/* comparison results are all-ones masks, counted by subtracting them from lane accumulators */
+#define AGGR_COUNT_SSE2(cmp)									\
+	do											\
+	{											\
+		for (i = 0; i + 2 <= values_num; i += 2)					\
+		{										\
+			v = _mm_loadu_pd(values + i);						\
+			acc = _mm_sub_epi64(acc, _mm_castpd_si128(cmp));			\
+		}										\
+	}											\
+	while (0)
+
+static int	aggr_count_dbl_sse2(const double *values, int values_num, int op, double pattern, double epsilon)
+{
+	__m128d		p = _mm_set1_pd(pattern), eps = _mm_set1_pd(epsilon), neg_eps = _mm_set1_pd(-epsilon),
+			abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL)), v;
+	__m128i		acc = _mm_setzero_si128();
+	zbx_uint64_t	count[2];
+	int		i = 0;
+
+	switch (op)
+	{
+		case OP_EQ:
+			AGGR_COUNT_SSE2(_mm_cmple_pd(_mm_and_pd(_mm_sub_pd(v, p), abs_mask), eps));
+			break;
+		case OP_NE:
+			AGGR_COUNT_SSE2(_mm_cmpnle_pd(_mm_and_pd(_mm_sub_pd(v, p), abs_mask), eps));
+			break;
+		case OP_GT:
+			AGGR_COUNT_SSE2(_mm_cmpgt_pd(_mm_sub_pd(v, p), eps));
+			break;
+		case OP_GE:
+			AGGR_COUNT_SSE2(_mm_cmpge_pd(_mm_sub_pd(v, p), neg_eps));
+			break;
+		case OP_LT:
+			AGGR_COUNT_SSE2(_mm_cmpgt_pd(_mm_sub_pd(p, v), eps));
+			break;
+		case OP_LE:
+			AGGR_COUNT_SSE2(_mm_cmpge_pd(_mm_sub_pd(p, v), neg_eps));
+			break;
+		default:
+			return 0;
+	}
+
+	_mm_storeu_si128((__m128i *)count, acc);
+
+	return (int)(count[0] + count[1]) + aggr_count_dbl_scalar(values + i, values_num - i, op, pattern, epsilon);
+}
+
+#undef AGGR_COUNT_SSE2
+
+static zbx_uint64_t	aggr_sum_ui64_sse2(const zbx_uint64_t *values, int values_num)
+{
+	__m128i		acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+	zbx_uint64_t	sum[2];
+	int		i;
+
+	for (i = 0; i + 4 <= values_num; i += 4)
+	{
+		acc0 = _mm_add_epi64(acc0, _mm_loadu_si128((const __m128i *)(values + i)));
+		acc1 = _mm_add_epi64(acc1, _mm_loadu_si128((const __m128i *)(values + i + 2)));
+	}
+
+	_mm_storeu_si128((__m128i *)sum, _mm_add_epi64(acc0, acc1));
+
+	return sum[0] + sum[1] + aggr_sum_ui64_scalar(values + i, values_num - i);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * AVX2 kernels                                                               *
+ *                                                                            *
+ ******************************************************************************/
+
+ZBX_AGGR_AVX2 static double	aggr_min_dbl_avx2(const double *values, int values_num)
+{
+	__m256d	acc;
+	double	min[4];
+	int	i, j;
+
+	if (4 > values_num)
+		return aggr_min_dbl_scalar(values, values_num);
+
+	acc = _mm256_set1_pd(values[0]);
+
+	for (i = 0; i + 4 <= values_num; i += 4)
+		acc = _mm256_min_pd(_mm256_loadu_pd(values + i), acc);
+
+	_mm256_storeu_pd(min, acc);
+
+	for (j = 1; j < 4; j++)
+	{
+		if (min[j] < min[0])
+			min[0] = min[j];
+	}
+
+	for (; i < values_num; i++)
+	{
+		if (values[i] < min[0])
+			min[0] = values[i];
+	}
+
+	return min[0];
+}
+
+ZBX_AGGR_AVX2 static double	aggr_max_dbl_avx2(const double *values, int values_num)
+{
+	__m256d	acc;
+	double	max[4];
+	int	i, j;
+
+	if (4 > values_num)
+		return aggr_max_dbl_scalar(values, values_num);
+
+	acc = _mm256_set1_pd(values[0]);
+
+	for (i = 0; i + 4 <= values_num; i += 4)
+		acc = _mm256_max_pd(_mm256_loadu_pd(values + i), acc);
+
+	_mm256_storeu_pd(max, acc);
+
+	for (j = 1; j < 4; j++)
+	{
+		if (max[j] > max[0])
+			max[0] = max[j];
+	}
+
+	for (; i < values_num; i++)
+	{
+		if (values[i] > max[0])
+			max[0] = values[i];
+	}
+
+	return max[0];
+}
+
+#define AGGR_COUNT_AVX2(load, cmp)								\
+	do											\
+	{											\
+		for (i = 0; i + 4 <= values_num; i += 4)					\
+		{										\
+			v = load;								\
+			acc = _mm256_sub_epi64(acc, cmp);					\
+		}										\
+	}											\
+	while (0)
+
+#define AGGR_LOAD_DBL	_mm256_loadu_pd(values + i)
+#define AGGR_CMP_DBL(a, b, pred)	_mm256_castpd_si256(_mm256_cmp_pd(a, b, pred))
+
+ZBX_AGGR_AVX2 static int	aggr_count_dbl_avx2(const double *values, int values_num, int op, double pattern,
+		double epsilon)
+{
+	__m256d		p = _mm256_set1_pd(pattern), eps = _mm256_set1_pd(epsilon), neg_eps = _mm256_set1_pd(-epsilon),
+			abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL)), v;
+	__m256i		acc = _mm256_setzero_si256();
+	zbx_uint64_t	count[4];
+	int		i = 0;
+
+	switch (op)
+	{
+		case OP_EQ:
+			AGGR_COUNT_AVX2(AGGR_LOAD_DBL,
+					AGGR_CMP_DBL(_mm256_and_pd(_mm256_sub_pd(v, p), abs_mask), eps, _CMP_LE_OQ));
+			break;
+		case OP_NE:
+			AGGR_COUNT_AVX2(AGGR_LOAD_DBL,
+					AGGR_CMP_DBL(_mm256_and_pd(_mm256_sub_pd(v, p), abs_mask), eps, _CMP_NLE_UQ));
+			break;
+		case OP_GT:
+			AGGR_COUNT_AVX2(AGGR_LOAD_DBL, AGGR_CMP_DBL(_mm256_sub_pd(v, p), eps, _CMP_GT_OQ));
+			break;
+		case OP_GE:
+			AGGR_COUNT_AVX2(AGGR_LOAD_DBL, AGGR_CMP_DBL(_mm256_sub_pd(v, p), neg_eps, _CMP_GE_OQ));
+			break;
+		case OP_LT:
+			AGGR_COUNT_AVX2(AGGR_LOAD_DBL, AGGR_CMP_DBL(_mm256_sub_pd(p, v), eps, _CMP_GT_OQ));
+			break;
+		case OP_LE:
+			AGGR_COUNT_AVX2(AGGR_LOAD_DBL, AGGR_CMP_DBL(_mm256_sub_pd(p, v), neg_eps, _CMP_GE_OQ));
+			break;
+		default:
+			return 0;
+	}
+
+	_mm256_storeu_si256((__m256i *)count, acc);
+
+	return (int)(count[0] + count[1] + count[2] + count[3]) +
+			aggr_count_dbl_scalar(values + i, values_num - i, op, pattern, epsilon);
+}
+
+#undef AGGR_CMP_DBL
+#undef AGGR_LOAD_DBL
+
+ZBX_AGGR_AVX2 static zbx_uint64_t	aggr_sum_ui64_avx2(const zbx_uint64_t *values, int values_num)
+{
+	__m256i		acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+	zbx_uint64_t	sum[4];
+	int		i;
+
+	for (i = 0; i + 8 <= values_num; i += 8)
+	{
+		acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((const __m256i *)(values + i)));
+		acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((const __m256i *)(values + i + 4)));
+	}
+
+	_mm256_storeu_si256((__m256i *)sum, _mm256_add_epi64(acc0, acc1));
+
+	return sum[0] + sum[1] + sum[2] + sum[3] + aggr_sum_ui64_scalar(values + i, values_num - i);
+}
+
+/* AVX2 has only signed 64-bit comparison, unsigned values are compared with flipped sign bits */
+#define AGGR_SIGN_FLIP(v)	_mm256_xor_si256(v, _mm256_set1_epi64x((long long)0x8000000000000000ULL))
+
+ZBX_AGGR_AVX2 static zbx_uint64_t	aggr_min_ui64_avx2(const zbx_uint64_t *values, int values_num)
+{
+	__m256i		acc, v;
+	zbx_uint64_t	min[4];
+	int		i, j;
+
+	if (4 > values_num)
+		return aggr_min_ui64_scalar(values, values_num);
+
+	acc = AGGR_SIGN_FLIP(_mm256_loadu_si256((const __m256i *)values));
+
+	for (i = 4; i + 4 <= values_num; i += 4)
+	{
+		v = AGGR_SIGN_FLIP(_mm256_loadu_si256((const __m256i *)(values + i)));
+		acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(acc, v));
+	}
+
+	_mm256_storeu_si256((__m256i *)min, AGGR_SIGN_FLIP(acc));
+
+	for (j = 1; j < 4; j++)
+	{
+		if (min[j] < min[0])
+			min[0] = min[j];
+	}
+
+	for (; i < values_num; i++)
+	{
+		if (values[i] < min[0])
+			min[0] = values[i];
+	}
+
+	return min[0];
+}
+
+ZBX_AGGR_AVX2 static zbx_uint64_t	aggr_max_ui64_avx2(const zbx_uint64_t *values, int values_num)
+{
+	__m256i		acc, v;
+	zbx_uint64_t	max[4];
+	int		i, j;
+
+	if (4 > values_num)
+		return aggr_max_ui64_scalar(values, values_num);
+
+	acc = AGGR_SIGN_FLIP(_mm256_loadu_si256((const __m256i *)values));
+
+	for (i = 4; i + 4 <= values_num; i += 4)
+	{
+		v = AGGR_SIGN_FLIP(_mm256_loadu_si256((const __m256i *)(values + i)));
+		acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(v, acc));
+	}
+
+	_mm256_storeu_si256((__m256i *)max, AGGR_SIGN_FLIP(acc));
+
+	for (j = 1; j < 4; j++)
+	{
+		if (max[j] > max[0])
+			max[0] = max[j];
+	}
+
+	for (; i < values_num; i++)
+	{
+		if (values[i] > max[0])
+			max[0] = values[i];
+	}
+
+	return max[0];
+}
+
+#define AGGR_LOAD_UI64	_mm256_loadu_si256((const __m256i *)(values + i))
+
+ZBX_AGGR_AVX2 static int	aggr_count_ui64_avx2(const zbx_uint64_t *values, int values_num, int op,
+		zbx_uint64_t pattern, zbx_uint64_t mask)
+{
+	__m256i		p = _mm256_set1_epi64x((long long)pattern), ps = AGGR_SIGN_FLIP(p),
+			msk = _mm256_set1_epi64x((long long)mask), acc = _mm256_setzero_si256(), v;
+	zbx_uint64_t	count[4];
+	int		i = 0, invert = 0;
+
+	switch (op)
+	{
+		case OP_EQ:
+			AGGR_COUNT_AVX2(AGGR_LOAD_UI64, _mm256_cmpeq_epi64(v, p));
+			break;
+		case OP_NE:
+			AGGR_COUNT_AVX2(AGGR_LOAD_UI64, _mm256_cmpeq_epi64(v, p));
+			invert = 1;
+			break;
+		case OP_GT:
+			AGGR_COUNT_AVX2(AGGR_SIGN_FLIP(AGGR_LOAD_UI64), _mm256_cmpgt_epi64(v, ps));
+			break;
+		case OP_GE:
+			AGGR_COUNT_AVX2(AGGR_SIGN_FLIP(AGGR_LOAD_UI64), _mm256_cmpgt_epi64(ps, v));
+			invert = 1;
+			break;
+		case OP_LT:
+			AGGR_COUNT_AVX2(AGGR_SIGN_FLIP(AGGR_LOAD_UI64), _mm256_cmpgt_epi64(ps, v));
+			break;
+		case OP_LE:
+			AGGR_COUNT_AVX2(AGGR_SIGN_FLIP(AGGR_LOAD_UI64), _mm256_cmpgt_epi64(v, ps));
+			invert = 1;
+			break;
+		case OP_BITAND:
+			AGGR_COUNT_AVX2(AGGR_LOAD_UI64, _mm256_cmpeq_epi64(_mm256_and_si256(v, msk), p));
+			break;
+		default:
+			return 0;
+	}
+
+	_mm256_storeu_si256((__m256i *)count, acc);
+	count[0] += count[1] + count[2] + count[3];
+
+	/* negated comparisons count the values not matching the opposite comparison */
+	if (0 != invert)
+		count[0] = (zbx_uint64_t)i - count[0];
+
+	return (int)count[0] + aggr_count_ui64_scalar(values + i, values_num - i, op, pattern, mask);
+}
+
+#undef AGGR_LOAD_UI64
+#undef AGGR_COUNT_AVX2
+
+#undef AGGR_SIGN_FLIP
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates sum of floating point values                           *
+ *                                                                            *
+ * Comments: The values are summed sequentially with all instruction sets, so *
+ *           the result does not depend on CPU.                               *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_eval_aggr_sum_dbl(const double *values, int values_num)
+{
+	return aggr_sum_dbl_scalar(values, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds minimum of floating point values                            *
+ *                                                                            *
+ * Comments: The values array must not be empty. NaN values are skipped,      *
+ *           unless the first value is NaN - then NaN is returned.            *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_eval_aggr_min_dbl(const double *values, int values_num)
+{
+#if defined(ZBX_AGGR_X86)
+	switch (aggr_isa_get())
+	{
+		case ZBX_EVAL_AGGR_ISA_AVX2:
+			return aggr_min_dbl_avx2(values, values_num);
+		case ZBX_EVAL_AGGR_ISA_SSE2:
+			return aggr_min_dbl_sse2(values, values_num);
+	}
+#endif
+	return aggr_min_dbl_scalar(values, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds maximum of floating point values                            *
+ *                                                                            *
+ * Comments: The values array must not be empty. NaN values are skipped,      *
+ *           unless the first value is NaN - then NaN is returned.            *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_eval_aggr_max_dbl(const double *values, int values_num)
+{
+#if defined(ZBX_AGGR_X86)
+	switch (aggr_isa_get())
+	{
+		case ZBX_EVAL_AGGR_ISA_AVX2:
+			return aggr_max_dbl_avx2(values, values_num);
+		case ZBX_EVAL_AGGR_ISA_SSE2:
+			return aggr_max_dbl_sse2(values, values_num);
+	}
+#endif
+	return aggr_max_dbl_scalar(values, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates sum of squared differences between floating point      *
+ *          values and the specified mean                                     *
+ *                                                                            *
+ * Comments: With zero mean the sum of squares is calculated. The values are  *
+ *           summed sequentially with all instruction sets, so the result     *
+ *           does not depend on CPU.                                          *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_eval_aggr_sumsq_dbl(const double *values, int values_num, double mean)
+{
+	return aggr_sumsq_dbl_scalar(values, values_num, mean);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts floating point values matching the specified numeric       *
+ *          pattern                                                           *
+ *                                                                            *
+ * Parameters: values     - [IN] the values                                   *
+ *             values_num - [IN] the number of values                         *
+ *             op         - [IN] the comparison operator (OP_EQ ... OP_LE)    *
+ *             pattern    - [IN] the value to compare with                    *
+ *             epsilon    - [IN] the comparison precision                     *
+ *                                                                            *
+ * Return value: the number of matching values                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_aggr_count_dbl(const double *values, int values_num, int op, double pattern, double epsilon)
+{
+#if defined(ZBX_AGGR_X86)
+	switch (aggr_isa_get())
+	{
+		case ZBX_EVAL_AGGR_ISA_AVX2:
+			return aggr_count_dbl_avx2(values, values_num, op, pattern, epsilon);
+		case ZBX_EVAL_AGGR_ISA_SSE2:
+			return aggr_count_dbl_sse2(values, values_num, op, pattern, epsilon);
+	}
+#endif
+	return aggr_count_dbl_scalar(values, values_num, op, pattern, epsilon);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates sum of unsigned integer values                         *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_eval_aggr_sum_ui64(const zbx_uint64_t *values, int values_num)
+{
+#if defined(ZBX_AGGR_X86)
+	switch (aggr_isa_get())
+	{
+		case ZBX_EVAL_AGGR_ISA_AVX2:
+			return aggr_sum_ui64_avx2(values, values_num);
+		case ZBX_EVAL_AGGR_ISA_SSE2:
+			return aggr_sum_ui64_sse2(values, values_num);
+	}
+#endif
+	return aggr_sum_ui64_scalar(values, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds minimum of unsigned integer values                          *
+ *                                                                            *
+ * Comments: The values array must not be empty. SSE2 has no 64-bit integer   *
+ *           comparison, so scalar kernel is used instead.                    *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_eval_aggr_min_ui64(const zbx_uint64_t *values, int values_num)
+{
+#if defined(ZBX_AGGR_X86)
+	if (ZBX_EVAL_AGGR_ISA_AVX2 == aggr_isa_get())
+		return aggr_min_ui64_avx2(values, values_num);
+#endif
+	return aggr_min_ui64_scalar(values, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds maximum of unsigned integer values                          *
+ *                                                                            *
+ * Comments: The values array must not be empty.                              *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_eval_aggr_max_ui64(const zbx_uint64_t *values, int values_num)
+{
+#if defined(ZBX_AGGR_X86)
+	if (ZBX_EVAL_AGGR_ISA_AVX2 == aggr_isa_get())
+		return aggr_max_ui64_avx2(values, values_num);
+#endif
+	return aggr_max_ui64_scalar(values, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts unsigned integer values matching the specified numeric     *
+ *          pattern                                                           *
+ *                                                                            *
+ * Parameters: values     - [IN] the values                                   *
+ *             values_num - [IN] the number of values                         *
+ *             op         - [IN] the comparison operator (OP_EQ ... OP_LE,    *
+ *                               OP_BITAND)                                   *
+ *             pattern    - [IN] the value to compare with                    *
+ *             mask       - [IN] the mask for OP_BITAND operator              *
+ *                                                                            *
+ * Return value: the number of matching values                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_aggr_count_ui64(const zbx_uint64_t *values, int values_num, int op, zbx_uint64_t pattern,
+		zbx_uint64_t mask)
+{
+#if defined(ZBX_AGGR_X86)
+	if (ZBX_EVAL_AGGR_ISA_AVX2 == aggr_isa_get())
+		return aggr_count_ui64_avx2(values, values_num, op, pattern, mask);
+#endif
+	return aggr_count_ui64_scalar(values, values_num, op, pattern, mask);
+}
@@ -50,13 +50,7 @@ static int	zbx_is_normal_double(double dbl)
  ******************************************************************************/
 static double	calc_arithmetic_mean(const zbx_vector_dbl_t *v)
 {
-	double	sum = 0;
-	int	i;
-
-	for (i = 0; i < v->values_num; i++)
-		sum += v->values[i];
-
-	return sum / v->values_num;
+	return zbx_eval_aggr_sum_dbl(v->values, v->values_num) / v->values_num;
 }
 
 /******************************************************************************
@@ -250,8 +244,7 @@ err:
  ******************************************************************************/
 int	zbx_eval_calc_stddevpop(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	mean, std_dev = 0;
-	int	i;
+	double	mean, std_dev;
 
 	/* step 1: calculate arithmetic mean */
 	mean = calc_arithmetic_mean(values);
@@ -261,12 +254,7 @@ int	zbx_eval_calc_stddevpop(zbx_vector_dbl_t *values, double *result, char **err
 
 	/* step 2: calculate the standard deviation */
 
-	for (i = 0; i < values->values_num; i++)
-	{
-		double	diff = values->values[i] - mean;
-
-		std_dev += diff * diff;
-	}
+	std_dev = zbx_eval_aggr_sumsq_dbl(values->values, values->values_num, mean);
 
 	std_dev = sqrt(std_dev / values->values_num);
 
@@ -300,8 +288,7 @@ err:
  ******************************************************************************/
 int	zbx_eval_calc_stddevsamp(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	mean, std_dev = 0;
-	int	i;
+	double	mean, std_dev;
 
 	if (2 > values->values_num)	/* stddevsamp requires at least 2 data values */
 	{
@@ -317,12 +304,7 @@ int	zbx_eval_calc_stddevsamp(zbx_vector_dbl_t *values, double *result, char **er
 
 	/* step 2: calculate the standard deviation */
 
-	for (i = 0; i < values->values_num; i++)
-	{
-		double	diff = values->values[i] - mean;
-
-		std_dev += diff * diff;
-	}
+	std_dev = zbx_eval_aggr_sumsq_dbl(values->values, values->values_num, mean);
 
 	std_dev = sqrt(std_dev / (values->values_num - 1));	/* divided by 'n - 1' because */
 								/* sample standard deviation */
@@ -352,11 +334,9 @@ err:
  ******************************************************************************/
 int	zbx_eval_calc_sumofsquares(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	sum = 0;
-	int	i;
+	double	sum;
 
-	for (i = 0; i < values->values_num; i++)
-		sum += values->values[i] * values->values[i];
+	sum = zbx_eval_aggr_sumsq_dbl(values->values, values->values_num, 0);
 
 	if (SUCCEED != zbx_is_normal_double(sum))
 	{
@@ -386,8 +366,7 @@ int	zbx_eval_calc_sumofsquares(zbx_vector_dbl_t *values, double *result, char **
  ******************************************************************************/
 int	zbx_eval_calc_varpop(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	mean, res = 0;
-	int	i;
+	double	mean, res;
 
 	/* step 1: calculate arithmetic mean */
 	mean = calc_arithmetic_mean(values);
@@ -397,12 +376,7 @@ int	zbx_eval_calc_varpop(zbx_vector_dbl_t *values, double *result, char **error)
 
 	/* step 2: calculate the population variance */
 
-	for (i = 0; i < values->values_num; i++)
-	{
-		double	diff = values->values[i] - mean;
-
-		res += diff * diff;
-	}
+	res = zbx_eval_aggr_sumsq_dbl(values->values, values->values_num, mean);
 
 	res /= values->values_num;	/* divide by 'number of values' for population variance */
 
@@ -435,8 +409,7 @@ err:
  ******************************************************************************/
 int	zbx_eval_calc_varsamp(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	mean, res = 0;
-	int	i;
+	double	mean, res;
 
 	if (2 > values->values_num)	/* varsamp requires at least 2 data values */
 	{
@@ -452,12 +425,7 @@ int	zbx_eval_calc_varsamp(zbx_vector_dbl_t *values, double *result, char **error
 
 	/* step 2: calculate the sample variance */
 
-	for (i = 0; i < values->values_num; i++)
-	{
-		double	diff = values->values[i] - mean;
-
-		res += diff * diff;
-	}
+	res = zbx_eval_aggr_sumsq_dbl(values->values, values->values_num, mean);
 
 	res /= values->values_num - 1;	/* divide by 'number of values' - 1 for unbiased sample variance */
 
@@ -674,24 +642,13 @@ int	zbx_eval_calc_avg(zbx_vector_dbl_t *values, double *result, char **error)
  ******************************************************************************/
 int	zbx_eval_calc_min(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	value;
-	int	i;
-
 	if (0 == values->values_num)
 	{
 		*error = zbx_strdup(*error, "no data (at least one value is required)");
 		return FAIL;
 	}
 
-	value = values->values[0];
-
-	for (i = 1; i < values->values_num; i++)
-	{
-		if (values->values[i] < value)
-			value = values->values[i];
-	}
-
-	*result = value;
+	*result = zbx_eval_aggr_min_dbl(values->values, values->values_num);
 
 	return SUCCEED;
 }
@@ -710,24 +667,13 @@ int	zbx_eval_calc_min(zbx_vector_dbl_t *values, double *result, char **error)
  ******************************************************************************/
 int	zbx_eval_calc_max(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	value;
-	int	i;
-
 	if (0 == values->values_num)
 	{
 		*error = zbx_strdup(*error, "no data (at least one value is required)");
 		return FAIL;
 	}
 
-	value = values->values[0];
-
-	for (i = 1; i < values->values_num; i++)
-	{
-		if (values->values[i] > value)
-			value = values->values[i];
-	}
-
-	*result = value;
+	*result = zbx_eval_aggr_max_dbl(values->values, values->values_num);
 
 	return SUCCEED;
 }
@@ -746,21 +692,13 @@ int	zbx_eval_calc_max(zbx_vector_dbl_t *values, double *result, char **error)
  ******************************************************************************/
 int	zbx_eval_calc_sum(zbx_vector_dbl_t *values, double *result, char **error)
 {
-	double	value;
-	int	i;
-
 	if (0 == values->values_num)
 	{
 		*error = zbx_strdup(*error, "no data (at least one value is required)");
 		return FAIL;
 	}
 
-	value = 0;
-
-	for (i = 0; i < values->values_num; i++)
-		value += values->values[i];
-
-	*result = value;
+	*result = zbx_eval_aggr_sum_dbl(values->values, values->values_num);
 
 	return SUCCEED;
 }
@@ -384,3 +384,37 @@ int	zbx_count_var_vector_with_pattern(zbx_eval_count_pattern_data_t *pdata, char
 
 	return SUCCEED;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts floating point values matching numeric search pattern      *
+ *                                                                            *
+ * Parameters: pdata      - [IN] the pattern data with numeric search         *
+ *             values     - [IN] the values                                   *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ * Return value: the number of matching values                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_count_dbl_values_with_pattern(const zbx_eval_count_pattern_data_t *pdata, const double *values,
+		int values_num)
+{
+	return zbx_eval_aggr_count_dbl(values, values_num, pdata->op, pdata->pattern_dbl, zbx_get_double_epsilon());
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts unsigned integer values matching numeric search pattern    *
+ *                                                                            *
+ * Parameters: pdata      - [IN] the pattern data with numeric search         *
+ *             values     - [IN] the values                                   *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ * Return value: the number of matching values                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_count_ui64_values_with_pattern(const zbx_eval_count_pattern_data_t *pdata, const zbx_uint64_t *values,
+		int values_num)
+{
+	return zbx_eval_aggr_count_ui64(values, values_num, pdata->op, pdata->pattern_ui64, pdata->pattern2_ui64);
+}
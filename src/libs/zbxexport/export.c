@@ -22,6 +22,11 @@
 #include "zbxcommon.h"
 #include "zbxstr.h"
 #include "zbxtypes.h"
+#include "zbxthreads.h"
+
+#ifdef HAVE_ZLIB
+#include "zlib.h"
+#endif
 
 #define ZBX_OPTION_EXPTYPE_EVENTS	"events"
 #define ZBX_OPTION_EXPTYPE_HISTORY	"history"
@@ -185,6 +190,14 @@ int	zbx_init_library_export(zbx_config_export_t *zbx_config_export, char **error
 		return FAIL;
 	}
 
+#ifndef HAVE_ZLIB
+	if (0 != zbx_config_export->compress)
+	{
+		*error = zbx_strdup(*error, "Misconfiguration: \"ExportCompress\" is enabled while Zabbix was compiled"
+				" without zlib support.");
+		return FAIL;
+	}
+#endif
 	config_export = zbx_config_export;
 
 	return SUCCEED;
@@ -202,19 +215,329 @@ void	zbx_deinit_library_export(void)
 	get_problems_file = NULL;
 }
 
+/* export data are passed to writer when the buffer exceeds this size even if not flushed */
+#define ZBX_EXPORT_BUFFER_SIZE		ZBX_MEBIBYTE
+
+/* the process waits for writer when the queued export data exceed this size */
+#define ZBX_EXPORT_QUEUE_MAX		(64 * ZBX_MEBIBYTE)
+
+#define ZBX_EXPORT_FILES_MAX		4
+
+struct zbx_export_file
+{
+	char		*name;
+	char		*base;
+	const char	*ext;
+	int		fd;
+	int		missing;
+
+	/* size of the currently open export file */
+	zbx_uint64_t	size;
+
+	/* export data written by the process and not yet passed to writer */
+	char		*data;
+	size_t		data_alloc;
+	size_t		data_offset;
+
+	/* export data passed to writer, protected by writer lock */
+	char		*queue;
+	size_t		queue_alloc;
+	size_t		queue_offset;
+
+	/* export data being written by writer */
+	char		*out;
+	size_t		out_alloc;
+	size_t		out_offset;
+
+	/* compressed export data */
+	char		*zbuf;
+	size_t		zbuf_alloc;
+
+	/* time of the last logged write error, the file is written either by process or by writer */
+	time_t		last_log_time;
+};
+
+/* export writer thread, used to write export files of a process so that the process */
+/* only appends export data to memory buffers                                        */
+typedef struct
+{
+	pthread_t		thread;
+	pthread_mutex_t		lock;
+	pthread_cond_t		event;
+
+	/* the size of export data queued for writing */
+	size_t			queued;
+
+	int			stop;
+	int			started;
+}
+zbx_export_writer_t;
+
+static zbx_export_writer_t	writer;
+
+static zbx_export_file_t	*export_files[ZBX_EXPORT_FILES_MAX];
+static int			export_files_num;
+
 static int	open_export_file(zbx_export_file_t *file, char **error)
 {
-	if (NULL == (file->file = fopen(file->name, "a")))
+	zbx_stat_t	st;
+
+	if (-1 == (file->fd = open(file->name, O_WRONLY | O_CREAT | O_APPEND, 0666)))
 	{
 		*error = zbx_dsprintf(*error, "cannot open export file '%s': %s", file->name, zbx_strerror(errno));
 		return FAIL;
 	}
 
+	if (0 != zbx_fstat(file->fd, &st))
+	{
+		*error = zbx_dsprintf(*error, "cannot obtain information about export file '%s': %s", file->name,
+				zbx_strerror(errno));
+		close(file->fd);
+		file->fd = -1;
+		return FAIL;
+	}
+
+	file->size = (zbx_uint64_t)st.st_size;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "successfully created export file '%s'", file->name);
 
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rotates export files                                              *
+ *                                                                            *
+ * Comments: With single rotated file the current file is renamed to          *
+ *           <name>.old, otherwise the rotated files are numbered from 1      *
+ *           (the newest) to ExportFileCount and the oldest one is removed.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	rotate_export_file(zbx_export_file_t *file, char **error)
+{
+	char	filename_old[MAX_STRING_LEN], filename_new[MAX_STRING_LEN];
+	int	i;
+
+	if (1 == config_export->file_count)
+	{
+		zbx_snprintf(filename_old, sizeof(filename_old), "%s.old%s", file->base, file->ext);
+
+		if (0 != rename(file->name, filename_old))
+		{
+			*error = zbx_dsprintf(*error, "cannot rename export file '%s': %s", file->name,
+					zbx_strerror(errno));
+			return FAIL;
+		}
+
+		return SUCCEED;
+	}
+
+	zbx_snprintf(filename_old, sizeof(filename_old), "%s.%d%s", file->base, config_export->file_count,
+			file->ext);
+
+	if (0 != remove(filename_old) && ENOENT != errno)
+	{
+		*error = zbx_dsprintf(*error, "cannot remove export file '%s': %s", filename_old, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	for (i = config_export->file_count - 1; 0 < i; i--)
+	{
+		zbx_snprintf(filename_new, sizeof(filename_new), "%s.%d%s", file->base, i, file->ext);
+
+		if (0 != rename(filename_new, filename_old) && ENOENT != errno)
+		{
+			*error = zbx_dsprintf(*error, "cannot rename export file '%s': %s", filename_new,
+					zbx_strerror(errno));
+			return FAIL;
+		}
+
+		zbx_strscpy(filename_old, filename_new);
+	}
+
+	if (0 != rename(file->name, filename_old))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename export file '%s': %s", file->name, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compresses export data into a single gzip member                  *
+ *                                                                            *
+ * Comments: Gzip members are concatenated in export file, which is still a   *
+ *           valid gzip stream.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compress_export_data(zbx_export_file_t *file, const char *buf, size_t count, size_t *size,
+		char **error)
+{
+#ifdef HAVE_ZLIB
+	z_stream	zs;
+	size_t		bound;
+	int		ret;
+
+	memset(&zs, 0, sizeof(zs));
+
+	if (Z_OK != (ret = deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY)))
+	{
+		*error = zbx_dsprintf(*error, "cannot initialize compression of export file '%s': error %d",
+				file->name, ret);
+		return FAIL;
+	}
+
+	if (file->zbuf_alloc < (bound = deflateBound(&zs, (uLong)count)))
+	{
+		file->zbuf_alloc = bound;
+		file->zbuf = (char *)zbx_realloc(file->zbuf, file->zbuf_alloc);
+	}
+
+	zs.next_in = (Bytef *)buf;
+	zs.avail_in = (uInt)count;
+	zs.next_out = (Bytef *)file->zbuf;
+	zs.avail_out = (uInt)file->zbuf_alloc;
+
+	ret = deflate(&zs, Z_FINISH);
+	*size = zs.total_out;
+	deflateEnd(&zs);
+
+	if (Z_STREAM_END != ret)
+	{
+		*error = zbx_dsprintf(*error, "cannot compress data of export file '%s': error %d", file->name, ret);
+		return FAIL;
+	}
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(buf);
+	ZBX_UNUSED(count);
+	ZBX_UNUSED(size);
+
+	*error = zbx_dsprintf(*error, "cannot compress data of export file '%s': zlib support is not compiled in",
+			file->name);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes buffered export data to export file                        *
+ *                                                                            *
+ * Parameters: file  - [IN] the export file                                   *
+ *             buf   - [IN] the export data (newline delimited JSON)          *
+ *             count - [IN] the export data size                              *
+ *                                                                            *
+ * Comments: The file is checked for removal and rotation once per buffer and *
+ *           its size is tracked instead of querying the file position.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_file_write(zbx_export_file_t *file, const char *buf, size_t count)
+{
+#define ZBX_LOGGING_SUSPEND_TIME	10
+
+	time_t	now;
+	char	*error_msg = NULL;
+	ssize_t	n;
+
+	if (0 != config_export->compress)
+	{
+		if (SUCCEED != compress_export_data(file, buf, count, &count, &error_msg))
+			goto error;
+
+		buf = file->zbuf;
+	}
+
+	if (0 == file->missing && -1 != file->fd && 0 != access(file->name, F_OK))
+	{
+		if (0 != close(file->fd))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot close export file '%s': %s", file->name,
+					zbx_strerror(errno));
+		}
+
+		file->fd = -1;
+	}
+
+	if (-1 == file->fd && FAIL == open_export_file(file, &error_msg))
+	{
+		file->missing = 1;
+		goto error;
+	}
+
+	if (1 == file->missing)
+	{
+		file->missing = 0;
+		zabbix_log(LOG_LEVEL_ERR, "regained access to export file '%s'", file->name);
+	}
+
+	if (0 != file->size && config_export->file_size <= count + file->size + 1)
+	{
+		if (0 != close(file->fd))
+		{
+			error_msg = zbx_dsprintf(error_msg, "cannot close export file %s': %s",
+					file->name, zbx_strerror(errno));
+			file->fd = -1;
+			goto error;
+		}
+		file->fd = -1;
+
+		if (SUCCEED != rotate_export_file(file, &error_msg))
+			goto error;
+
+		if (FAIL == open_export_file(file, &error_msg))
+			goto error;
+	}
+
+	while (0 != count)
+	{
+		if (-1 == (n = write(file->fd, buf, count)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			error_msg = zbx_dsprintf(error_msg, "cannot write to export file '%s': %s", file->name,
+					zbx_strerror(errno));
+			goto error;
+		}
+
+		buf += n;
+		count -= (size_t)n;
+		file->size += (zbx_uint64_t)n;
+	}
+
+	if (0 != config_export->fsync && 0 != fsync(file->fd))
+	{
+		error_msg = zbx_dsprintf(error_msg, "cannot synchronize export file '%s': %s", file->name,
+				zbx_strerror(errno));
+		goto error;
+	}
+
+	return;
+error:
+	if (-1 != file->fd && 0 != close(file->fd))
+	{
+		error_msg = zbx_dsprintf(error_msg, "%s; cannot close export file %s': %s",
+				error_msg, file->name, zbx_strerror(errno));
+	}
+
+	file->fd = -1;
+	now = time(NULL);
+
+	if (ZBX_LOGGING_SUSPEND_TIME < now - file->last_log_time)
+	{
+		zabbix_log(LOG_LEVEL_ERR, "%s", error_msg);
+		file->last_log_time = now;
+	}
+
+	zbx_free(error_msg);
+
+#undef ZBX_LOGGING_SUSPEND_TIME
+}
+
 static zbx_export_file_t	*export_init(const char *process_type, const char *process_name, int process_num)
 {
 	char			*export_dir, *error = NULL;
@@ -226,12 +549,22 @@ static zbx_export_file_t	*export_init(const char *process_type, const char *proc
 		exit(EXIT_FAILURE);
 	}
 
+	if (ZBX_EXPORT_FILES_MAX == export_files_num)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "too many export files");
+		exit(EXIT_FAILURE);
+	}
+
 	export_dir = zbx_strdup(NULL, config_export->dir);
 	if ('/' == export_dir[strlen(export_dir) - 1])
 		export_dir[strlen(export_dir) - 1] = '\0';
 
 	file = (zbx_export_file_t *)zbx_malloc(NULL, sizeof(zbx_export_file_t));
-	file->name = zbx_dsprintf(NULL, "%s/%s-%s-%d.ndjson", export_dir, process_type, process_name, process_num);
+	memset(file, 0, sizeof(zbx_export_file_t));
+
+	file->base = zbx_dsprintf(NULL, "%s/%s-%s-%d.ndjson", export_dir, process_type, process_name, process_num);
+	file->ext = (0 != config_export->compress ? ".gz" : "");
+	file->name = zbx_dsprintf(NULL, "%s%s", file->base, file->ext);
 
 	free(export_dir);
 
@@ -242,6 +575,7 @@ static zbx_export_file_t	*export_init(const char *process_type, const char *proc
 	}
 
 	file->missing = 0;
+	export_files[export_files_num++] = file;
 
 	return file;
 }
@@ -270,117 +604,105 @@ zbx_export_file_t	*zbx_problems_export_init(zbx_get_export_file_f get_export_fil
 	return export_init("problems", process_name, process_num);
 }
 
-void	zbx_export_deinit(zbx_export_file_t *file)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes buffered export data to writer                             *
+ *                                                                            *
+ * Comments: The buffers are swapped if writer has no pending data of the     *
+ *           file, so usually only pointers are exchanged under the lock.     *
+ *           The process waits if writer falls too far behind.                *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_queue(zbx_export_file_t *file)
 {
-	zbx_fclose(file->file);
-	zbx_free(file->name);
-	zbx_free(file);
-}
+	pthread_mutex_lock(&writer.lock);
 
-static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
-{
-#define ZBX_LOGGING_SUSPEND_TIME	10
+	while (ZBX_EXPORT_QUEUE_MAX <= writer.queued)
+		pthread_cond_wait(&writer.event, &writer.lock);
 
-	static time_t	last_log_time = 0;
-	time_t		now;
-	char		*error_msg = NULL;
-	long		file_offset;
+	writer.queued += file->data_offset;
 
-	if (NULL == config_export)
+	if (0 == file->queue_offset)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "export library is not initialized");
-		exit(EXIT_FAILURE);
-	}
+		char	*data = file->queue;
+		size_t	data_alloc = file->queue_alloc;
 
-	if (0 == file->missing && 0 != access(file->name, F_OK))
-	{
-		if (NULL != file->file && 0 != fclose(file->file))
-			zabbix_log(LOG_LEVEL_DEBUG, "cannot close export file '%s': %s",file->name,
-					zbx_strerror(errno));
+		file->queue = file->data;
+		file->queue_alloc = file->data_alloc;
+		file->queue_offset = file->data_offset;
 
-		file->file = NULL;
+		file->data = data;
+		file->data_alloc = data_alloc;
 	}
-
-	if (NULL == file->file && FAIL == open_export_file(file, &error_msg))
+	else
 	{
-		file->missing = 1;
-		goto error;
+		zbx_strncpy_alloc(&file->queue, &file->queue_alloc, &file->queue_offset, file->data,
+				file->data_offset);
 	}
 
-	if (1 == file->missing)
-	{
-		file->missing = 0;
-		zabbix_log(LOG_LEVEL_ERR, "regained access to export file '%s'", file->name);
-	}
+	pthread_cond_broadcast(&writer.event);
+	pthread_mutex_unlock(&writer.lock);
 
-	if (-1 == (file_offset = ftell(file->file)))
-	{
-		error_msg = zbx_dsprintf(error_msg, "cannot get current position in export file '%s': %s",
-				file->name, zbx_strerror(errno));
-		goto error;
-	}
+	file->data_offset = 0;
+}
 
-	if (config_export->file_size <= count + (size_t)file_offset + 1)
+static void	export_flush(zbx_export_file_t *file)
+{
+	if (NULL == file || 0 == file->data_offset)
+		return;
+
+	if (0 != writer.started)
 	{
-		char	filename_old[MAX_STRING_LEN];
+		export_queue(file);
+		return;
+	}
 
-		zbx_strscpy(filename_old, file->name);
-		zbx_strlcat(filename_old, ".old", MAX_STRING_LEN);
+	export_file_write(file, file->data, file->data_offset);
+	file->data_offset = 0;
+}
 
-		if (0 == access(filename_old, F_OK) && 0 != remove(filename_old))
-		{
-			error_msg = zbx_dsprintf(error_msg, "cannot remove export file '%s': %s",
-					filename_old, zbx_strerror(errno));
-			goto error;
-		}
+void	zbx_export_deinit(zbx_export_file_t *file)
+{
+	int	i;
 
-		if (0 != fclose(file->file))
-		{
-			error_msg = zbx_dsprintf(error_msg, "cannot close export file %s': %s",
-					file->name, zbx_strerror(errno));
-			file->file = NULL;
-			goto error;
-		}
-		file->file = NULL;
+	/* writer flushes and writes the data of all files before exiting, so it is stopped only once */
+	zbx_export_writer_stop();
+	export_flush(file);
 
-		if (0 != rename(file->name, filename_old))
+	for (i = 0; i < export_files_num; i++)
+	{
+		if (export_files[i] == file)
 		{
-			error_msg = zbx_dsprintf(error_msg, "cannot rename export file '%s': %s",
-					file->name, zbx_strerror(errno));
-			goto error;
+			export_files[i] = export_files[--export_files_num];
+			break;
 		}
-
-		if (FAIL == open_export_file(file, &error_msg))
-			goto error;
 	}
 
-	if (count != fwrite(buf, 1, count, file->file) || '\n' != fputc('\n', file->file))
-	{
-		error_msg = zbx_dsprintf(error_msg, "cannot write to export file '%s': %s", file->name,
-				zbx_strerror(errno));
-		goto error;
-	}
-
-	return;
-error:
-	if (NULL != file->file && 0 != fclose(file->file))
-	{
-		error_msg = zbx_dsprintf(error_msg, "%s; cannot close export file %s': %s",
-				error_msg, file->name, zbx_strerror(errno));
-	}
+	if (-1 != file->fd)
+		close(file->fd);
 
-	file->file = NULL;
-	now = time(NULL);
+	zbx_free(file->data);
+	zbx_free(file->queue);
+	zbx_free(file->out);
+	zbx_free(file->zbuf);
+	zbx_free(file->base);
+	zbx_free(file->name);
+	zbx_free(file);
+}
 
-	if (ZBX_LOGGING_SUSPEND_TIME < now - last_log_time)
+static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
+{
+	if (NULL == config_export)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "%s", error_msg);
-		last_log_time = now;
+		zabbix_log(LOG_LEVEL_CRIT, "export library is not initialized");
+		exit(EXIT_FAILURE);
 	}
 
-	zbx_free(error_msg);
+	zbx_strncpy_alloc(&file->data, &file->data_alloc, &file->data_offset, buf, count);
+	zbx_chrcpy_alloc(&file->data, &file->data_alloc, &file->data_offset, '\n');
 
-#undef ZBX_LOGGING_SUSPEND_TIME
+	if (ZBX_EXPORT_BUFFER_SIZE <= file->data_offset)
+		export_flush(file);
 }
 
 void	zbx_problems_export_write(const char *buf, size_t count)
@@ -398,12 +720,6 @@ void	zbx_trends_export_write(const char *buf, size_t count)
 	export_write(buf, count, get_trends_file());
 }
 
-static void	export_flush(zbx_export_file_t *file)
-{
-	if (NULL != file && NULL != file->file && 0 != fflush(file->file))
-		zabbix_log(LOG_LEVEL_ERR, "cannot flush export file '%s': %s", file->name, zbx_strerror(errno));
-}
-
 void	zbx_problems_export_flush(void)
 {
 	export_flush(get_problems_file());
@@ -418,3 +734,167 @@ void	zbx_trends_export_flush(void)
 {
 	export_flush(get_trends_file());
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: export writer thread entry                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	*export_writer_entry(void *args)
+{
+	sigset_t		mask;
+	int			err, i;
+	zbx_export_file_t	*file;
+	char			*out;
+	size_t			out_alloc;
+
+	ZBX_UNUSED(args);
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGALRM);
+
+	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, NULL)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot block signals: %s", zbx_strerror(err));
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "export writer thread started");
+
+	pthread_mutex_lock(&writer.lock);
+
+	for (;;)
+	{
+		for (file = NULL, i = 0; i < export_files_num; i++)
+		{
+			if (0 != export_files[i]->queue_offset)
+			{
+				file = export_files[i];
+				break;
+			}
+		}
+
+		if (NULL == file)
+		{
+			if (0 != writer.stop)
+				break;
+
+			pthread_cond_wait(&writer.event, &writer.lock);
+			continue;
+		}
+
+		out = file->out;
+		out_alloc = file->out_alloc;
+
+		file->out = file->queue;
+		file->out_alloc = file->queue_alloc;
+		file->out_offset = file->queue_offset;
+
+		file->queue = out;
+		file->queue_alloc = out_alloc;
+		file->queue_offset = 0;
+
+		writer.queued -= file->out_offset;
+		pthread_cond_broadcast(&writer.event);
+		pthread_mutex_unlock(&writer.lock);
+
+		export_file_write(file, file->out, file->out_offset);
+		file->out_offset = 0;
+
+		pthread_mutex_lock(&writer.lock);
+	}
+
+	pthread_mutex_unlock(&writer.lock);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "export writer thread stopped");
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts export writer thread                                       *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the writer thread was started or asynchronous      *
+ *                         export is disabled                                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: When export writer is started the export data flushed by the     *
+ *           process are written to export files by the writer thread. It     *
+ *           must be started after export files of the process have been      *
+ *           initialized.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_export_writer_start(char **error)
+{
+	int	err;
+
+	if (NULL == config_export || 0 == config_export->async || 0 != writer.started)
+		return SUCCEED;
+
+	if (0 != (err = pthread_mutex_init(&writer.lock, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize export writer mutex: %s", zbx_strerror(err));
+		return FAIL;
+	}
+
+	if (0 != (err = pthread_cond_init(&writer.event, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize export writer conditional variable: %s",
+				zbx_strerror(err));
+		pthread_mutex_destroy(&writer.lock);
+		return FAIL;
+	}
+
+	writer.queued = 0;
+	writer.stop = 0;
+
+	if (0 != (err = pthread_create(&writer.thread, NULL, export_writer_entry, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot create export writer thread: %s", zbx_strerror(err));
+		pthread_cond_destroy(&writer.event);
+		pthread_mutex_destroy(&writer.lock);
+		return FAIL;
+	}
+
+	writer.started = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops export writer thread                                        *
+ *                                                                            *
+ * Comments: The buffered export data of all files are flushed first and      *
+ *           written before thread exits.                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_export_writer_stop(void)
+{
+	void	*retval;
+	int	i;
+
+	if (0 == writer.started)
+		return;
+
+	for (i = 0; i < export_files_num; i++)
+		export_flush(export_files[i]);
+
+	pthread_mutex_lock(&writer.lock);
+	writer.stop = 1;
+	pthread_cond_broadcast(&writer.event);
+	pthread_mutex_unlock(&writer.lock);
+
+	pthread_join(writer.thread, &retval);
+
+	pthread_cond_destroy(&writer.event);
+	pthread_mutex_destroy(&writer.lock);
+
+	writer.started = 0;
+}
@@ -1000,6 +1000,10 @@ static void	zbx_vector_history_record_log_uniq(zbx_vector_history_record_t *vect
 	}
 }
 
+/* numeric history values are stored in 8 byte union, so value arrays can be processed as plain number arrays */
+#define HISTORY_VALUES_DBL(values)	(&(values)->dbl)
+#define HISTORY_VALUES_UI64(values)	(&(values)->ui64)
+
 /* flags for evaluate_COUNT() */
 #define COUNT_ALL	0
 #define COUNT_UNIQUE	1
@@ -1047,6 +1051,37 @@ int	zbx_execute_count_with_pattern(char *pattern, unsigned char value_type, zbx_
 	return ret;
 }
 
+/* the numeric item value counting state */
+typedef struct
+{
+	unsigned char				value_type;
+	const zbx_eval_count_pattern_data_t	*pdata;
+	int					count;
+}
+zbx_count_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to count numeric item values matching        *
+ *          numeric search pattern                                            *
+ *                                                                            *
+ * Parameters: values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *             data       - [IN/OUT] the counting state                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	count_values(const zbx_history_value_t *values, int values_num, void *data)
+{
+	zbx_count_t	*cnt = (zbx_count_t *)data;
+
+	if (OP_ANY == cnt->pdata->op)
+		cnt->count += values_num;
+	else if (ITEM_VALUE_TYPE_FLOAT == cnt->value_type)
+		cnt->count += zbx_count_dbl_values_with_pattern(cnt->pdata, HISTORY_VALUES_DBL(values), values_num);
+	else
+		cnt->count += zbx_count_ui64_values_with_pattern(cnt->pdata, HISTORY_VALUES_UI64(values), values_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate functions 'count' and 'find' for the item.               *
@@ -1137,6 +1172,25 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	/* count all numeric values directly in value cache */
+	if (COUNT_ALL == unique && (OP_ANY == pdata.op || 0 != pdata.numeric_search) &&
+			(ITEM_VALUE_TYPE_FLOAT == item->value_type || ITEM_VALUE_TYPE_UINT64 == item->value_type))
+	{
+		zbx_count_t	cnt = {.value_type = item->value_type, .pdata = &pdata};
+
+		if (FAIL == zbx_vc_process_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				count_values, &cnt, sizeof(cnt)))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto clean;
+		}
+
+		if ((count = cnt.count) > limit)
+			count = limit;
+
+		goto result;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1187,7 +1241,7 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 		if ((count = values.values_num) > limit)
 			count = limit;
 	}
-
+result:
 	zbx_variant_set_dbl(value, count);
 
 	ret = SUCCEED;
@@ -1204,6 +1258,150 @@ out:
 	return ret;
 }
 
+/* the numeric item value aggregation state */
+typedef struct
+{
+	unsigned char		value_type;
+
+	/* the number of aggregated values */
+	int			values_num;
+
+	/* the sum, minimum or maximum value */
+	zbx_history_value_t	value;
+
+	/* the average value */
+	double			avg;
+}
+zbx_aggregate_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to sum numeric item values                   *
+ *                                                                            *
+ * Parameters: values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *             data       - [IN/OUT] the aggregation state                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_sum(const zbx_history_value_t *values, int values_num, void *data)
+{
+	zbx_aggregate_t	*aggr = (zbx_aggregate_t *)data;
+
+	if (ITEM_VALUE_TYPE_FLOAT == aggr->value_type)
+		aggr->value.dbl += zbx_eval_aggr_sum_dbl(HISTORY_VALUES_DBL(values), values_num);
+	else
+		aggr->value.ui64 += zbx_eval_aggr_sum_ui64(HISTORY_VALUES_UI64(values), values_num);
+
+	aggr->values_num += values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to average numeric item values               *
+ *                                                                            *
+ * Parameters: values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *             data       - [IN/OUT] the aggregation state                    *
+ *                                                                            *
+ * Comments: Floating point values are averaged by blocks to avoid overflow,  *
+ *           falling back to incremental averaging if the block sum           *
+ *           overflows. Unsigned values are summed and the sum must be        *
+ *           divided by the number of values afterwards.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_avg(const zbx_history_value_t *values, int values_num, void *data)
+{
+	zbx_aggregate_t	*aggr = (zbx_aggregate_t *)data;
+	int		i;
+
+	if (ITEM_VALUE_TYPE_FLOAT == aggr->value_type)
+	{
+		double	sum = zbx_eval_aggr_sum_dbl(HISTORY_VALUES_DBL(values), values_num);
+
+		if (FP_INFINITE != fpclassify(sum) && FP_NAN != fpclassify(sum))
+		{
+			aggr->values_num += values_num;
+			aggr->avg += (sum / values_num - aggr->avg) * ((double)values_num / aggr->values_num);
+			return;
+		}
+
+		for (i = values_num - 1; i >= 0; i--)
+		{
+			aggr->avg += values[i].dbl / (aggr->values_num + 1) - aggr->avg / (aggr->values_num + 1);
+			aggr->values_num++;
+		}
+	}
+	else
+	{
+		for (i = values_num - 1; i >= 0; i--)
+			aggr->avg += (double)values[i].ui64;
+
+		aggr->values_num += values_num;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to find minimum numeric item value           *
+ *                                                                            *
+ * Parameters: values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *             data       - [IN/OUT] the aggregation state                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_min(const zbx_history_value_t *values, int values_num, void *data)
+{
+	zbx_aggregate_t	*aggr = (zbx_aggregate_t *)data;
+
+	if (ITEM_VALUE_TYPE_UINT64 == aggr->value_type)
+	{
+		zbx_uint64_t	min = zbx_eval_aggr_min_ui64(HISTORY_VALUES_UI64(values), values_num);
+
+		if (0 == aggr->values_num || min < aggr->value.ui64)
+			aggr->value.ui64 = min;
+	}
+	else
+	{
+		double	min = zbx_eval_aggr_min_dbl(HISTORY_VALUES_DBL(values), values_num);
+
+		if (0 == aggr->values_num || min < aggr->value.dbl)
+			aggr->value.dbl = min;
+	}
+
+	aggr->values_num += values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to find maximum numeric item value           *
+ *                                                                            *
+ * Parameters: values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *             data       - [IN/OUT] the aggregation state                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_max(const zbx_history_value_t *values, int values_num, void *data)
+{
+	zbx_aggregate_t	*aggr = (zbx_aggregate_t *)data;
+
+	if (ITEM_VALUE_TYPE_UINT64 == aggr->value_type)
+	{
+		zbx_uint64_t	max = zbx_eval_aggr_max_ui64(HISTORY_VALUES_UI64(values), values_num);
+
+		if (0 == aggr->values_num || max > aggr->value.ui64)
+			aggr->value.ui64 = max;
+	}
+	else
+	{
+		double	max = zbx_eval_aggr_max_dbl(HISTORY_VALUES_DBL(values), values_num);
+
+		if (0 == aggr->values_num || max > aggr->value.dbl)
+			aggr->value.dbl = max;
+	}
+
+	aggr->values_num += values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'sum' for the item.                             *
@@ -1222,16 +1420,13 @@ out:
 static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_history_value_t		result;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_aggregate_t		aggr = {.value_type = item->value_type};
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1265,32 +1460,21 @@ static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
 	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
+		aggr.value.dbl = 0;
 	else
-	{
-		result.ui64 = 0;
+		aggr.value.ui64 = 0;
 
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
+	if (FAIL == zbx_vc_process_values(item->itemid, item->value_type, seconds, nvalues, &ts_end, aggregate_sum,
+			&aggr, sizeof(aggr)))
+	{
+		*error = zbx_strdup(*error, "cannot get values from value cache");
+		goto out;
 	}
 
-	zbx_history_value2variant(&result, item->value_type, value);
+	zbx_history_value2variant(&aggr.value, item->value_type, value);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1314,15 +1498,13 @@ out:
 static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_aggregate_t		aggr = {.value_type = item->value_type};
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1356,29 +1538,19 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_process_values(item->itemid, item->value_type, seconds, nvalues, &ts_end, aggregate_avg,
+			&aggr, sizeof(aggr)))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		double	avg = 0;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
-		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += (double)values.values[i].value.ui64;
+		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+			aggr.avg = aggr.avg / aggr.values_num;
 
-			avg = avg / values.values_num;
-		}
-		zbx_variant_set_dbl(value, avg);
+		zbx_variant_set_dbl(value, aggr.avg);
 
 		ret = SUCCEED;
 	}
@@ -1388,8 +1560,6 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1432,17 +1602,6 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 #define EVALUATE_MIN	0
 #define EVALUATE_MAX	1
 
-#define LOOP_FIND_MIN_OR_MAX(type, mode_op)							\
-	do											\
-	{											\
-		for (i = 1; i < values.values_num; i++)							\
-		{											\
-			if (values.values[i].value.type mode_op values.values[index].value.type)	\
-				index = i;								\
-		}											\
-	}												\
-	while(0)
-
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'min' or 'max' for the item.                    *
@@ -1462,15 +1621,13 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error, int min_or_max)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_aggregate_t		aggr = {.value_type = item->value_type};
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1504,40 +1661,16 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_process_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			EVALUATE_MIN == min_or_max ? aggregate_min : aggregate_max, &aggr, sizeof(aggr)))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, >);
-			}
-		}
-		else
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, >);
-			}
-		}
-
-		zbx_history_value2variant(&values.values[index].value, item->value_type, value);
+		zbx_history_value2variant(&aggr.value, item->value_type, value);
 		ret = SUCCEED;
 	}
 	else
@@ -1546,7 +1679,6 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -2539,9 +2671,62 @@ out:
 	return ret;
 }
 
+/* the numeric item value copying state */
+typedef struct
+{
+	unsigned char		value_type;
+	zbx_vector_dbl_t	*values;
+
+	/* the number of copied values, kept outside vector to be restored on value cache retries */
+	int			values_num;
+}
+zbx_history_dbl_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to copy numeric item values into vector of   *
+ *          doubles                                                           *
+ *                                                                            *
+ * Parameters: values     - [IN] the values in ascending order                *
+ *             values_num - [IN] the number of values                         *
+ *             data       - [IN/OUT] the copying state                        *
+ *                                                                            *
+ * Comments: The values are copied starting with the newest, in the same      *
+ *           order as returned by zbx_vc_get_values().                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	history_values_to_dbl(const zbx_history_value_t *values, int values_num, void *data)
+{
+	zbx_history_dbl_t	*hist = (zbx_history_dbl_t *)data;
+	double			*out;
+	int			i;
+
+	if (hist->values_num + values_num > hist->values->values_alloc)
+	{
+		zbx_vector_dbl_reserve(hist->values, (size_t)MAX(hist->values_num + values_num,
+				hist->values->values_alloc * 2));
+	}
+
+	out = hist->values->values + hist->values_num;
+
+	if (ITEM_VALUE_TYPE_FLOAT == hist->value_type)
+	{
+		for (i = values_num - 1; i >= 0; i--)
+			*out++ = values[i].dbl;
+	}
+	else
+	{
+		for (i = values_num - 1; i >= 0; i--)
+			*out++ = (double)values[i].ui64;
+	}
+
+	hist->values_num += values_num;
+}
+
 static int	validate_params_and_get_data(const zbx_dc_evaluate_item_t *item, const char *parameters,
-		const zbx_timespec_t *ts, zbx_vector_history_record_t *values, char **error)
+		const zbx_timespec_t *ts, zbx_vector_dbl_t *values, char **error)
 {
+	zbx_history_dbl_t	hist = {.value_type = item->value_type, .values = values};
 	int			arg1, seconds = 0, nvalues = 0, time_shift;
 	zbx_value_type_t	arg1_type;
 	zbx_timespec_t		ts_end = *ts;
@@ -2581,12 +2766,15 @@ static int	validate_params_and_get_data(const zbx_dc_evaluate_item_t *item, cons
 			return FAIL;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_process_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			history_values_to_dbl, &hist, sizeof(hist)))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		return FAIL;
 	}
 
+	values->values_num = hist.values_num;
+
 	return SUCCEED;
 }
 
@@ -3353,25 +3541,6 @@ out:
 	return ret;
 }
 
-static void	history_to_dbl_vector(const zbx_history_record_t *v, int n, unsigned char value_type,
-		zbx_vector_dbl_t *values)
-{
-	int	i;
-
-	zbx_vector_dbl_reserve(values, (size_t)n);
-
-	if (ITEM_VALUE_TYPE_FLOAT == value_type)
-	{
-		for (i = 0; i < n; i++)
-			zbx_vector_dbl_append(values, v[i].value.dbl);
-	}
-	else
-	{
-		for (i = 0; i < n; i++)
-			zbx_vector_dbl_append(values, (double)v[i].value.ui64);
-	}
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: common operations for aggregate function calculation.             *
@@ -3394,34 +3563,27 @@ static int	evaluate_statistical_func(zbx_variant_t *value, const zbx_dc_evaluate
 		const char *parameters, const zbx_timespec_t *ts, zbx_statistical_func_t stat_func, int min_values,
 		char **error)
 {
-	int				ret = FAIL;
-	zbx_vector_history_record_t	values;
+	int			ret = FAIL;
+	zbx_vector_dbl_t	values;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
+	zbx_vector_dbl_create(&values);
 
 	if (SUCCEED != validate_params_and_get_data(item, parameters, ts, &values, error))
 		goto out;
 
 	if (min_values <= values.values_num)
 	{
-		zbx_vector_dbl_t	values_dbl;
-		double			result;
-
-		zbx_vector_dbl_create(&values_dbl);
-
-		history_to_dbl_vector(values.values, values.values_num, item->value_type, &values_dbl);
+		double	result;
 
-		if (SUCCEED == (ret = stat_func(&values_dbl, &result, error)))
+		if (SUCCEED == (ret = stat_func(&values, &result, error)))
 			zbx_variant_set_dbl(value, result);
-
-		zbx_vector_dbl_destroy(&values_dbl);
 	}
 	else
 		*error = zbx_strdup(*error, "not enough data");
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
+	zbx_vector_dbl_destroy(&values);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -61,7 +61,9 @@ typedef struct
 }
 zbx_elastic_writer_t;
 
-static zbx_elastic_writer_t	writer;
+/* the history writer and the buffers are thread local, as history syncer can write history */
+/* in writer thread while reading history in main thread                                 */
+static ZBX_THREAD_LOCAL zbx_elastic_writer_t	writer;
 
 typedef struct
 {
@@ -71,7 +73,7 @@ typedef struct
 }
 zbx_httppage_t;
 
-static zbx_httppage_t	page_r;
+static ZBX_THREAD_LOCAL zbx_httppage_t	page_r;
 
 typedef struct
 {
@@ -80,7 +82,7 @@ typedef struct
 }
 zbx_curlpage_t;
 
-static zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_BIN + 1];
+static ZBX_THREAD_LOCAL zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_BIN + 1];
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -126,7 +128,7 @@ static zbx_history_value_t	history_str2value(char *str, unsigned char value_type
 
 static const char	*history_value2str(const zbx_dc_history_t *h)
 {
-	static char	buffer[ZBX_MAX_DOUBLE_LEN + 1];
+	static ZBX_THREAD_LOCAL char	buffer[ZBX_MAX_DOUBLE_LEN + 1];
 
 	switch (h->value_type)
 	{
@@ -658,21 +660,23 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	CURLcode		err;
 	struct zbx_json		query;
 	struct curl_slist	*curl_headers = NULL;
-	char			*scroll_id = NULL, *scroll_query = NULL, errbuf[CURL_ERROR_SIZE];
+	char			*scroll_id = NULL, *scroll_query = NULL, *url = NULL, errbuf[CURL_ERROR_SIZE];
 	CURLoption		opt;
+	CURL			*handle;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	ret = FAIL;
 
-	if (NULL == (data->handle = curl_easy_init()))
+	/* the interface data is used by history writer, so reading uses its own cURL session */
+	if (NULL == (handle = curl_easy_init()))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
 
 		return FAIL;
 	}
 
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
+	zbx_snprintf_alloc(&url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
 			value_type_str[hist->value_type]);
 
 	/* prepare the json query for elasticsearch, apply ranges if needed */
@@ -720,15 +724,15 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 
 	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/json");
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
+	if (CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_URL, url)) ||
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_WRITEFUNCTION,
 					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_HTTPHEADER, curl_headers)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER, errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_HTTPHEADER, curl_headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_ERRORBUFFER, errbuf)) ||
+			CURLE_OK != (err = curl_easy_setopt(handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
 		goto out;
@@ -738,9 +742,9 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
 	/* CURLOPT_PROTOCOLS was deprecated in favor of CURLOPT_PROTOCOLS_STR starting with version 7.85.0 (0x075500) */
 #	if LIBCURL_VERSION_NUM >= 0x075500
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PROTOCOLS_STR, "HTTP,HTTPS")))
+	if (CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_PROTOCOLS_STR, "HTTP,HTTPS")))
 #	else
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PROTOCOLS,
+	if (CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_PROTOCOLS,
 			CURLPROTO_HTTP | CURLPROTO_HTTPS)))
 #	endif
 	{
@@ -749,20 +753,20 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	}
 #endif
 
-	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", data->post_url, query.buffer);
+	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", url, query.buffer);
 
 	page_r.offset = 0;
 	*errbuf = '\0';
-	if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+	if (CURLE_OK != (err = curl_easy_perform(handle)))
 	{
-		elastic_log_error(data->handle, err, errbuf);
+		elastic_log_error(handle, err, errbuf);
 		goto out;
 	}
 
 	url_offset = 0;
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll", data->base_url);
+	zbx_snprintf_alloc(&url, &url_alloc, &url_offset, "%s/_search/scroll", data->base_url);
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_URL, data->post_url)))
+	if (CURLE_OK != (err = curl_easy_setopt(handle, CURLOPT_URL, url)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_URL,
 				curl_easy_strerror(err));
@@ -833,7 +837,7 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 		zbx_snprintf_alloc(&scroll_query, &scroll_alloc, &scroll_offset,
 				"{\"scroll\":\"10s\",\"scroll_id\":\"%s\"}\n", ZBX_NULL2EMPTY_STR(scroll_id));
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_POSTFIELDS, scroll_query)))
+		if (CURLE_OK != (err = curl_easy_setopt(handle, CURLOPT_POSTFIELDS, scroll_query)))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_POSTFIELDS,
 					curl_easy_strerror(err));
@@ -842,9 +846,9 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 
 		page_r.offset = 0;
 		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+		if (CURLE_OK != (err = curl_easy_perform(handle)))
 		{
-			elastic_log_error(data->handle, err, errbuf);
+			elastic_log_error(handle, err, errbuf);
 			break;
 		}
 	}
@@ -854,12 +858,12 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	if (NULL != scroll_id)
 	{
 		url_offset = 0;
-		zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll/%s", data->base_url,
+		zbx_snprintf_alloc(&url, &url_alloc, &url_offset, "%s/_search/scroll/%s", data->base_url,
 				scroll_id);
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, "")) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_CUSTOMREQUEST, "DELETE")))
+		if (CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_URL, url)) ||
+				CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_POSTFIELDS, "")) ||
+				CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_CUSTOMREQUEST, "DELETE")))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt,
 					curl_easy_strerror(err));
@@ -867,16 +871,17 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 			goto out;
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", data->post_url);
+		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", url);
 
 		page_r.offset = 0;
 		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
-			elastic_log_error(data->handle, err, errbuf);
+		if (CURLE_OK != (err = curl_easy_perform(handle)))
+			elastic_log_error(handle, err, errbuf);
 	}
 
 out:
-	elastic_close(hist);
+	curl_easy_cleanup(handle);
+	zbx_free(url);
 
 	curl_slist_free_all(curl_headers);
 
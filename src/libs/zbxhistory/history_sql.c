@@ -31,7 +31,7 @@ typedef struct
 }
 zbx_sql_writer_t;
 
-static zbx_sql_writer_t	writer;
+static ZBX_THREAD_LOCAL zbx_sql_writer_t	writer;
 
 typedef void (*vc_str2value_func_t)(zbx_history_value_t *value, zbx_db_row_t row);
 
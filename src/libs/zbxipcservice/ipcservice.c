@@ -7,10 +7,15 @@
 #	include <event2/thread.h>
 #endif
 
+#include <sys/uio.h>
+
 #include "zbxipcservice.h"
+#include "ipcshm.h"
 #include "zbxalgo.h"
 #include "zbxstr.h"
 
+ZBX_PTR_VECTOR_IMPL(ipcmsg, zbx_ipc_message_t *)
+
 #define ZBX_IPC_PATH_MAX	sizeof(((struct sockaddr_un *)0)->sun_path)
 
 #define ZBX_IPC_DATA_DUMP_SIZE		128
@@ -43,6 +48,9 @@ struct zbx_ipc_client
 	zbx_queue_ptr_t		tx_queue;
 	struct event		*tx_event;
 
+	/* shared memory ring data notification event */
+	struct event		*shm_event;
+
 	zbx_uint64_t		id;
 	unsigned char		state;
 
@@ -60,6 +68,20 @@ struct zbx_ipc_client
 #define ZBX_IPC_MESSAGE_CODE	0
 #define ZBX_IPC_MESSAGE_SIZE	1
 
+/* maximum number of messages read from shared memory ring per event */
+#define ZBX_IPC_SHM_READ_MAX	256
+
+/* Reserved message code of batch frame. The frame data contains multiple messages, */
+/* each stored as message code, data size and data (see ipcshm.h for other codes).  */
+#define ZBX_IPC_BATCH			0xfffffff2u
+
+/* maximum batch frame data size, larger batches are split into multiple frames - batching */
+/* pays off for small messages while large ones are cheaper to send without extra copy  */
+#define ZBX_IPC_BATCH_SIZE_MAX		ZBX_MEBIBYTE
+
+/* minimum number of writev() vector elements guaranteed by POSIX */
+#define ZBX_IPC_IOV_MAX_MIN		16
+
 #if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
 typedef int evutil_socket_t;
 
@@ -229,6 +251,109 @@ static int	ipc_read_data(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_u
 	return SUCCEED;
 }
 
+#ifdef ZBX_HAVE_IPC_SHM
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores shared memory ring descriptors received from client        *
+ *                                                                            *
+ * Parameters: csocket - [IN] the socket                                      *
+ *             fds     - [IN] the received descriptors                        *
+ *             fds_num - [IN] the number of received descriptors              *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_socket_set_shm_fds(zbx_ipc_socket_t *csocket, const int *fds, int fds_num)
+{
+	int	i;
+
+	/* only one ring can be negotiated per connection */
+	if (NULL != csocket->shm)
+	{
+		for (i = 0; i < fds_num; i++)
+			close(fds[i]);
+
+		return;
+	}
+
+	csocket->shm = ipc_shm_create_pending(fds, fds_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads data from a socket, accepting descriptors of shared memory  *
+ *          ring passed by client                                             *
+ *                                                                            *
+ * Parameters: csocket   - [IN] the socket                                    *
+ *             buffer    - [IN] the data                                      *
+ *             size      - [IN] the data size                                 *
+ *             read_size - [IN] the actual size read from socket              *
+ *                                                                            *
+ * Return value: SUCCEED - the data was successfully read                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_socket_read_data(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size,
+		zbx_uint32_t *read_size)
+{
+	struct msghdr	msg;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	ssize_t		n;
+	union
+	{
+		struct cmsghdr	align;
+		char		buf[CMSG_SPACE(sizeof(int) * ZBX_IPC_SHM_FDS_NUM)];
+	}
+	control;
+
+	*read_size = 0;
+
+	iov.iov_base = buffer;
+	iov.iov_len = size;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	while (-1 == (n = recvmsg(csocket->fd, &msg, MSG_CMSG_CLOEXEC)))
+	{
+		if (EINTR == errno)
+			continue;
+
+		if (EWOULDBLOCK == errno || EAGAIN == errno)
+			return SUCCEED;
+
+		return FAIL;
+	}
+
+	if (0 == n)
+		return FAIL;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); NULL != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		int	fds[ZBX_IPC_SHM_FDS_NUM], fds_num;
+
+		if (SOL_SOCKET != cmsg->cmsg_level || SCM_RIGHTS != cmsg->cmsg_type)
+			continue;
+
+		fds_num = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+		memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * (size_t)fds_num);
+		ipc_socket_set_shm_fds(csocket, fds, fds_num);
+	}
+
+	*read_size = (zbx_uint32_t)n;
+
+	return SUCCEED;
+}
+#else
+static int	ipc_socket_read_data(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size,
+		zbx_uint32_t *read_size)
+{
+	return ipc_read_data(csocket->fd, buffer, size, read_size);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: reads data from a socket until the requested data has been read   *
@@ -455,7 +580,7 @@ static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *head
 			}
 		}
 
-		if (FAIL == ipc_read_data(csocket->fd, csocket->rx_buffer, ZBX_IPC_SOCKET_BUFFER_SIZE, &read_size))
+		if (FAIL == ipc_socket_read_data(csocket, csocket->rx_buffer, ZBX_IPC_SOCKET_BUFFER_SIZE, &read_size))
 			goto out;
 
 		/* it's possible that nothing will be read on non-blocking sockets, return success */
@@ -497,6 +622,12 @@ static void	ipc_client_free_events(zbx_ipc_client_t *client)
 		event_free(client->tx_event);
 		client->tx_event = NULL;
 	}
+
+	if (NULL != client->shm_event)
+	{
+		event_free(client->shm_event);
+		client->shm_event = NULL;
+	}
 }
 
 /******************************************************************************
@@ -551,6 +682,65 @@ static void	ipc_client_push_rx_message(zbx_ipc_client_t *client)
 	client->rx_bytes = 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unpacks received batch frame into received messages queue         *
+ *                                                                            *
+ * Parameters: client - [IN] the client with completed batch frame            *
+ *                                                                            *
+ * Return value: SUCCEED - the batch was unpacked                             *
+ *               FAIL    - the batch frame is malformed                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_client_push_rx_batch(zbx_ipc_client_t *client)
+{
+	zbx_ipc_message_t	*message;
+	const unsigned char	*ptr = client->rx_data, *end = client->rx_data + client->rx_header[ZBX_IPC_MESSAGE_SIZE];
+	zbx_uint32_t		header[2];
+	int			ret = SUCCEED;
+
+	while (ptr < end)
+	{
+		if ((size_t)(end - ptr) < ZBX_IPC_HEADER_SIZE)
+		{
+			ret = FAIL;
+			break;
+		}
+
+		memcpy(header, ptr, ZBX_IPC_HEADER_SIZE);
+		ptr += ZBX_IPC_HEADER_SIZE;
+
+		if ((size_t)(end - ptr) < header[ZBX_IPC_MESSAGE_SIZE])
+		{
+			ret = FAIL;
+			break;
+		}
+
+		message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
+		message->code = header[ZBX_IPC_MESSAGE_CODE];
+		message->size = header[ZBX_IPC_MESSAGE_SIZE];
+
+		if (0 != message->size)
+		{
+			message->data = (unsigned char *)zbx_malloc(NULL, message->size);
+			memcpy(message->data, ptr, message->size);
+			ptr += message->size;
+		}
+		else
+			message->data = NULL;
+
+		zbx_queue_ptr_push(&client->rx_queue, message);
+	}
+
+	if (SUCCEED != ret)
+		zabbix_log(LOG_LEVEL_WARNING, "received malformed IPC batch frame");
+
+	zbx_free(client->rx_data);
+	client->rx_bytes = 0;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: prepares to send the next message in send queue                   *
@@ -575,6 +765,55 @@ static void	ipc_client_pop_tx_message(zbx_ipc_client_t *client)
 	zbx_free(message);
 }
 
+#ifdef ZBX_HAVE_IPC_SHM
+/******************************************************************************
+ *                                                                            *
+ * Purpose: attaches shared memory ring requested by client and sends the     *
+ *          result back                                                       *
+ *                                                                            *
+ * Parameters: client - [IN] the client with completed ring request message   *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_attach_shm(zbx_ipc_client_t *client)
+{
+	zbx_uint32_t	size = 0;
+	int		status = FAIL;
+	char		*error = NULL;
+
+	if (sizeof(size) == client->rx_header[ZBX_IPC_MESSAGE_SIZE])
+		memcpy(&size, client->rx_data, sizeof(size));
+
+	if (NULL == client->csocket.shm)
+	{
+		error = zbx_strdup(NULL, "shared memory descriptors were not received");
+	}
+	else if (SUCCEED == ipc_shm_attach(client->csocket.shm, size, &error))
+	{
+		client->shm_event = event_new(client->service->ev, ipc_shm_get_notify_fd(client->csocket.shm),
+				EV_READ | EV_PERSIST, ipc_client_read_event_cb, (void *)client);
+		event_add(client->shm_event, NULL);
+		status = SUCCEED;
+	}
+	else if (SUCCEED != ipc_shm_is_attached(client->csocket.shm))
+	{
+		ipc_shm_free(client->csocket.shm);
+		client->csocket.shm = NULL;
+	}
+
+	if (SUCCEED != status)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot attach shared memory ring of IPC client " ZBX_FS_UI64 ": %s",
+				client->id, error);
+		zbx_free(error);
+	}
+
+	zbx_free(client->rx_data);
+	client->rx_bytes = 0;
+
+	zbx_ipc_client_send(client, ZBX_IPC_SHM_RESPONSE, (unsigned char *)&status, sizeof(status));
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: reads data from IPC service client                                *
@@ -583,13 +822,25 @@ static void	ipc_client_pop_tx_message(zbx_ipc_client_t *client)
  *                                                                            *
  * Return value:  FAIL - read error/connection was closed                     *
  *                                                                            *
- * Comments: This function reads data from socket, parses it and adds         *
- *           parsed messages to received messages queue.                      *
+ * Comments: This function reads data from socket and shared memory ring if   *
+ *           attached, parses it and adds parsed messages to received         *
+ *           messages queue. Batch frames are unpacked into separate          *
+ *           messages.                                                        *
  *                                                                            *
  ******************************************************************************/
 static int	ipc_client_read(zbx_ipc_client_t *client)
 {
-	int	rc;
+	int		rc, ret = SUCCEED;
+#ifdef ZBX_HAVE_IPC_SHM
+	zbx_uint64_t	shm_head = 0;
+
+	/* Ring messages written after the socket has been read might have been preceded by socket */
+	/* messages written meanwhile, so only messages written before reading socket are read.    */
+	/* Client sends through socket only after ring is empty, so the read ring messages cannot  */
+	/* precede socket messages that were not read yet.                                         */
+	if (NULL != client->shm_event)
+		shm_head = ipc_shm_get_head(client->csocket.shm);
+#endif
 
 	do
 	{
@@ -598,16 +849,50 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 		{
 			zbx_free(client->rx_data);
 			client->rx_bytes = 0;
-			return FAIL;
+			ret = FAIL;
+			break;
 		}
 
 		if (SUCCEED == (rc = ipc_message_is_completed(client->rx_header, client->rx_bytes)))
+		{
+#ifdef ZBX_HAVE_IPC_SHM
+			if (ZBX_IPC_SHM_REQUEST == client->rx_header[ZBX_IPC_MESSAGE_CODE] && NULL != client->service)
+			{
+				ipc_client_attach_shm(client);
+				continue;
+			}
+#endif
+			if (ZBX_IPC_BATCH == client->rx_header[ZBX_IPC_MESSAGE_CODE])
+			{
+				if (SUCCEED != ipc_client_push_rx_batch(client))
+				{
+					ret = FAIL;
+					break;
+				}
+
+				continue;
+			}
+
 			ipc_client_push_rx_message(client);
+		}
 	}
-
 	while (SUCCEED == rc);
 
-	return SUCCEED;
+#ifdef ZBX_HAVE_IPC_SHM
+	/* client writes to ring only after messages sent through socket, so they must be queued first - */
+	/* also ring must be drained after client has disconnected                                       */
+	if (NULL != client->shm_event && FAIL == ret)
+		shm_head = ipc_shm_get_head(client->csocket.shm);
+
+	if (NULL != client->shm_event && SUCCEED != ipc_shm_read_messages(client->csocket.shm, &client->rx_queue,
+			ZBX_IPC_SHM_READ_MAX, shm_head))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "corrupted data in IPC client shared memory ring");
+		ret = FAIL;
+	}
+#endif
+
+	return ret;
 }
 
 /******************************************************************************
@@ -1083,6 +1368,172 @@ static int	ipc_check_running_service(const char *service_name)
  *                                                                            *
  ******************************************************************************/
 int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int timeout, char **error)
+{
+	return zbx_ipc_socket_open_ext(csocket, service_name, timeout, 0, error);
+}
+
+#ifdef ZBX_HAVE_IPC_SHM
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes IPC message with attached file descriptors to blocking     *
+ *          socket                                                            *
+ *                                                                            *
+ * Parameters: fd      - [IN] the socket file descriptor                      *
+ *             code    - [IN] the message code                                *
+ *             data    - [IN] the data                                        *
+ *             size    - [IN] the data size                                   *
+ *             fds     - [IN] the file descriptors to pass                    *
+ *             fds_num - [IN] the number of file descriptors                  *
+ *                                                                            *
+ * Return value: SUCCEED - the message was sent                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_socket_write_fds(int fd, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size,
+		const int *fds, int fds_num)
+{
+	struct msghdr	msg;
+	struct iovec	iov[2];
+	struct cmsghdr	*cmsg;
+	zbx_uint32_t	header[2], size_sent;
+	ssize_t		n;
+	union
+	{
+		struct cmsghdr	align;
+		char		buf[CMSG_SPACE(sizeof(int) * ZBX_IPC_SHM_FDS_NUM)];
+	}
+	control;
+
+	header[ZBX_IPC_MESSAGE_CODE] = code;
+	header[ZBX_IPC_MESSAGE_SIZE] = size;
+
+	iov[0].iov_base = header;
+	iov[0].iov_len = ZBX_IPC_HEADER_SIZE;
+	iov[1].iov_base = (void *)data;
+	iov[1].iov_len = size;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)fds_num);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)fds_num);
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * (size_t)fds_num);
+
+	while (-1 == (n = sendmsg(fd, &msg, 0)))
+	{
+		if (EINTR != errno)
+			return FAIL;
+	}
+
+	/* descriptors are passed with the first byte, the rest is written as normal data */
+	if ((zbx_uint32_t)n < ZBX_IPC_HEADER_SIZE + size)
+	{
+		unsigned char	*buffer;
+		int		ret;
+
+		buffer = (unsigned char *)zbx_malloc(NULL, ZBX_IPC_HEADER_SIZE + size);
+		memcpy(buffer, header, ZBX_IPC_HEADER_SIZE);
+		memcpy(buffer + ZBX_IPC_HEADER_SIZE, data, size);
+
+		ret = ipc_write_data(fd, buffer + n, ZBX_IPC_HEADER_SIZE + size - (zbx_uint32_t)n, &size_sent);
+		zbx_free(buffer);
+
+		if (SUCCEED != ret || size_sent != ZBX_IPC_HEADER_SIZE + size - (zbx_uint32_t)n)
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: negotiates shared memory ring for sending messages to service     *
+ *                                                                            *
+ * Parameters: csocket - [IN] the opened blocking IPC socket                  *
+ *             size    - [IN] the requested ring size                         *
+ *                                                                            *
+ * Comments: On failure the socket is used without shared memory ring.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_socket_open_shm(zbx_ipc_socket_t *csocket, zbx_uint32_t size)
+{
+	zbx_ipc_shm_t		*shm;
+	zbx_ipc_message_t	message;
+	int			fds[ZBX_IPC_SHM_FDS_NUM], status = FAIL;
+	char			*error = NULL;
+
+	if (NULL == (shm = ipc_shm_create(size, &error)))
+		goto out;
+
+	size = ipc_shm_get_size(shm);
+	ipc_shm_get_fds(shm, fds);
+
+	if (SUCCEED != ipc_socket_write_fds(csocket->fd, ZBX_IPC_SHM_REQUEST, (unsigned char *)&size, sizeof(size),
+			fds, ZBX_IPC_SHM_FDS_NUM))
+	{
+		error = zbx_dsprintf(NULL, "cannot send shared memory ring request: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	if (SUCCEED != zbx_ipc_socket_read(csocket, &message))
+	{
+		error = zbx_strdup(NULL, "cannot read shared memory ring response");
+		goto out;
+	}
+
+	if (ZBX_IPC_SHM_RESPONSE == message.code && sizeof(status) == message.size)
+		memcpy(&status, message.data, sizeof(status));
+
+	zbx_ipc_message_clean(&message);
+
+	if (SUCCEED != status)
+	{
+		error = zbx_strdup(NULL, "service did not accept shared memory ring");
+		goto out;
+	}
+
+	ipc_shm_close_memfd(shm);
+	csocket->shm = shm;
+	shm = NULL;
+out:
+	if (NULL != shm)
+		ipc_shm_free(shm);
+
+	if (NULL != error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot use shared memory ring for IPC socket: %s", error);
+		zbx_free(error);
+	}
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens socket to an IPC service listening on the specified path    *
+ *          and optionally negotiates shared memory ring for sending messages *
+ *                                                                            *
+ * Parameters: csocket      - [OUT] the IPC socket to the service             *
+ *             service_name - [IN] the IPC service name                       *
+ *             timeout      - [IN] the connection timeout                     *
+ *             shm_size     - [IN] the shared memory ring size, 0 - messages  *
+ *                                 are sent only through socket               *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the socket was successfully opened                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Shared memory ring is used only when supported by system, the    *
+ *           socket is opened also if the ring cannot be negotiated. Messages *
+ *           not fitting the ring are sent through socket.                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_socket_open_ext(zbx_ipc_socket_t *csocket, const char *service_name, int timeout, zbx_uint32_t shm_size,
+		char **error)
 {
 	struct sockaddr_un	addr;
 	time_t			start;
@@ -1092,6 +1543,8 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	csocket->shm = NULL;
+
 	if (NULL == (socket_path = ipc_make_path(service_name, error)))
 		goto out;
 
@@ -1123,6 +1576,12 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 	csocket->rx_buffer_bytes = 0;
 	csocket->rx_buffer_offset = 0;
 
+#ifdef ZBX_HAVE_IPC_SHM
+	if (0 != shm_size)
+		ipc_socket_open_shm(csocket, shm_size);
+#else
+	ZBX_UNUSED(shm_size);
+#endif
 	ret = SUCCEED;
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -1146,6 +1605,13 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 		csocket->fd = -1;
 	}
 
+#ifdef ZBX_HAVE_IPC_SHM
+	if (NULL != csocket->shm)
+	{
+		ipc_shm_free(csocket->shm);
+		csocket->shm = NULL;
+	}
+#endif
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -1169,6 +1635,23 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+#ifdef ZBX_HAVE_IPC_SHM
+	if (NULL != csocket->shm)
+	{
+		if (SUCCEED == ipc_shm_fits(csocket->shm, size))
+		{
+			ret = ipc_shm_write(csocket->shm, csocket->fd, code, data, size);
+			goto out;
+		}
+
+		/* wait until service has read the ring, so messages sent through socket are not reordered */
+		if (SUCCEED != ipc_shm_wait_empty(csocket->shm, csocket->fd))
+		{
+			ret = FAIL;
+			goto out;
+		}
+	}
+#endif
 	if (SUCCEED == ipc_socket_write_message(csocket, code, data, size, &size_sent) &&
 			size_sent == size + ZBX_IPC_HEADER_SIZE)
 	{
@@ -1176,7 +1659,188 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 	}
 	else
 		ret = FAIL;
+#ifdef ZBX_HAVE_IPC_SHM
+out:
+#endif
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds messages to be sent in one batch frame                      *
+ *                                                                            *
+ * Parameters: messages - [IN] the messages to send                           *
+ *             start    - [IN] the index of the first message in frame        *
+ *             max_num  - [IN] the maximum number of messages in frame        *
+ *             size     - [OUT] the frame data size                           *
+ *                                                                            *
+ * Return value: The index after the last message in frame.                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_batch_get_frame(const zbx_vector_ipcmsg_t *messages, int start, int max_num, zbx_uint32_t *size)
+{
+	zbx_uint64_t	frame_size = 0;
+	int		i;
+
+	for (i = start; i < messages->values_num && i - start < max_num; i++)
+	{
+		zbx_uint64_t	message_size = ZBX_IPC_HEADER_SIZE + (zbx_uint64_t)messages->values[i]->size;
+
+		if (i != start && frame_size + message_size > ZBX_IPC_BATCH_SIZE_MAX)
+			break;
+
+		frame_size += message_size;
+	}
+
+	/* single message frames are sent as normal messages, so the size is used only for smaller frames */
+	*size = (zbx_uint32_t)MIN(frame_size, ZBX_IPC_BATCH_SIZE_MAX);
+
+	return i;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns maximum number of writev() vector elements                *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_get_iov_max(void)
+{
+	static long	iov_max = 0;
+
+	if (0 == iov_max && ZBX_IPC_IOV_MAX_MIN > (iov_max = sysconf(_SC_IOV_MAX)))
+		iov_max = ZBX_IPC_IOV_MAX_MIN;
+
+	return (int)iov_max;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes data vector to blocking socket                             *
+ *                                                                            *
+ * Parameters: fd      - [IN] the socket file descriptor                      *
+ *             iov     - [IN] the data vector, modified during write          *
+ *             iov_num - [IN] the number of vector elements                   *
+ *                                                                            *
+ * Return value: SUCCEED - the data was written                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_writev_data(int fd, struct iovec *iov, int iov_num)
+{
+	ssize_t	n;
 
+	while (0 < iov_num)
+	{
+		if (-1 == (n = writev(fd, iov, iov_num)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot write to IPC socket: %s", strerror(errno));
+			return FAIL;
+		}
+
+		while (0 < iov_num && (size_t)n >= iov->iov_len)
+		{
+			n -= (ssize_t)iov->iov_len;
+			iov++;
+			iov_num--;
+		}
+
+		if (0 < iov_num)
+		{
+			iov->iov_base = (unsigned char *)iov->iov_base + n;
+			iov->iov_len -= (size_t)n;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes multiple messages to IPC service                           *
+ *                                                                            *
+ * Parameters: csocket  - [IN] an opened IPC socket to the service            *
+ *             messages - [IN] the messages to write                          *
+ *                                                                            *
+ * Return value: SUCCEED - the messages were successfully written             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The messages are sent in batch frames with a single system call  *
+ *           per frame and are received by service as separate messages.      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_socket_write_batch(zbx_ipc_socket_t *csocket, const zbx_vector_ipcmsg_t *messages)
+{
+	struct iovec		*iov;
+	zbx_uint32_t		*headers, size;
+	int			i, j, end, iov_num, max_num, ret = SUCCEED;
+	zbx_ipc_message_t	*message;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() messages:%d", __func__, messages->values_num);
+
+#ifdef ZBX_HAVE_IPC_SHM
+	/* writing to ring does not involve system calls and service is woken up only once */
+	if (NULL != csocket->shm)
+	{
+		for (i = 0; i < messages->values_num && SUCCEED == ret; i++)
+		{
+			message = messages->values[i];
+			ret = zbx_ipc_socket_write(csocket, message->code, message->data, message->size);
+		}
+
+		goto out;
+	}
+#endif
+	max_num = MIN((ipc_get_iov_max() - 1) / 2, messages->values_num);
+
+	iov = (struct iovec *)zbx_malloc(NULL, sizeof(struct iovec) * (size_t)(max_num * 2 + 1));
+	headers = (zbx_uint32_t *)zbx_malloc(NULL, sizeof(zbx_uint32_t) * 2 * (size_t)(max_num + 1));
+
+	for (i = 0; i < messages->values_num && SUCCEED == ret; i = end)
+	{
+		if (1 == (end = ipc_batch_get_frame(messages, i, max_num, &size)) - i)
+		{
+			message = messages->values[i];
+			ret = zbx_ipc_socket_write(csocket, message->code, message->data, message->size);
+			continue;
+		}
+
+		headers[ZBX_IPC_MESSAGE_CODE] = ZBX_IPC_BATCH;
+		headers[ZBX_IPC_MESSAGE_SIZE] = size;
+		iov[0].iov_base = headers;
+		iov[0].iov_len = ZBX_IPC_HEADER_SIZE;
+		iov_num = 1;
+
+		for (j = i; j < end; j++)
+		{
+			zbx_uint32_t	*header = headers + (j - i + 1) * 2;
+
+			message = messages->values[j];
+
+			header[ZBX_IPC_MESSAGE_CODE] = message->code;
+			header[ZBX_IPC_MESSAGE_SIZE] = message->size;
+			iov[iov_num].iov_base = header;
+			iov[iov_num++].iov_len = ZBX_IPC_HEADER_SIZE;
+
+			if (0 != message->size)
+			{
+				iov[iov_num].iov_base = message->data;
+				iov[iov_num++].iov_len = message->size;
+			}
+		}
+
+		ret = ipc_writev_data(csocket->fd, iov, iov_num);
+	}
+
+	zbx_free(headers);
+	zbx_free(iov);
+#ifdef ZBX_HAVE_IPC_SHM
+out:
+#endif
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1552,6 +2216,38 @@ void	zbx_ipc_service_close(zbx_ipc_service_t *service)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes service events, waiting for them if there are no        *
+ *          clients with received messages                                    *
+ *                                                                            *
+ * Parameters: service - [IN] the IPC service                                 *
+ *             timeout - [IN] the timeout                                     *
+ *                                                                            *
+ * Return value: The libevent loop flags used.                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_service_run_events(zbx_ipc_service_t *service, const zbx_timespec_t *timeout)
+{
+	int	flags;
+
+	if ((0 != timeout->sec || 0 != timeout->ns) && SUCCEED == zbx_queue_ptr_empty(&service->clients_recv))
+	{
+		if (ZBX_IPC_WAIT_FOREVER != timeout->sec)
+		{
+			struct timeval	tv = {timeout->sec, timeout->ns / 1000};
+			evtimer_add(service->ev_timer, &tv);
+		}
+		flags = EVLOOP_ONCE;
+	}
+	else
+		flags = EVLOOP_NONBLOCK;
+
+	event_base_loop(service->ev, flags);
+
+	return flags;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: receives ipc message from a connected client                      *
@@ -1585,19 +2281,7 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, const zbx_timespec_t *timeo
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() timeout:%d.%03d", __func__, timeout->sec, timeout->ns / 1000000);
 
-	if ((0 != timeout->sec || 0 != timeout->ns) && SUCCEED == zbx_queue_ptr_empty(&service->clients_recv))
-	{
-		if (ZBX_IPC_WAIT_FOREVER != timeout->sec)
-		{
-			struct timeval	tv = {timeout->sec, timeout->ns / 1000};
-			evtimer_add(service->ev_timer, &tv);
-		}
-		flags = EVLOOP_ONCE;
-	}
-	else
-		flags = EVLOOP_NONBLOCK;
-
-	event_base_loop(service->ev, flags);
+	flags = ipc_service_run_events(service, timeout);
 
 	if (NULL != (*client = ipc_service_pop_client(service)))
 	{
@@ -1632,6 +2316,82 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, const zbx_timespec_t *timeo
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: receives multiple ipc messages from a connected client            *
+ *                                                                            *
+ * Parameters: service  - [IN] the IPC service                                *
+ *             timeout  - [IN] the timeout. (0,0) is used for nonblocking     *
+ *                             call and (ZBX_IPC_WAIT_FOREVER, *) is used for *
+ *                             blocking call without timeout                  *
+ *             client   - [OUT] the client that sent the messages or NULL if  *
+ *                              there are no messages and the specified       *
+ *                              timeout passed.                               *
+ *                              The client must be released by caller with    *
+ *                              zbx_ipc_client_release() function.            *
+ *             messages - [OUT] the received messages, empty if the client    *
+ *                              connection was closed.                        *
+ *                              The messages must be freed by caller with     *
+ *                              zbx_ipc_message_free() function.              *
+ *             max_num  - [IN] the maximum number of messages to return       *
+ *                                                                            *
+ * Return value: ZBX_IPC_RECV_IMMEDIATE - returned immediately without        *
+ *                                        waiting for socket events           *
+ *                                        (pending events are processed)      *
+ *               ZBX_IPC_RECV_WAIT      - returned after receiving socket     *
+ *                                        event                               *
+ *               ZBX_IPC_RECV_TIMEOUT   - returned after timeout expired      *
+ *                                                                            *
+ * Comments: The messages already queued for the client are returned without *
+ *           running event loop for each message.                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_service_recv_batch(zbx_ipc_service_t *service, const zbx_timespec_t *timeout,
+		zbx_ipc_client_t **client, zbx_vector_ipcmsg_t *messages, int max_num)
+{
+	int			ret, flags;
+	zbx_ipc_message_t	*message;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() timeout:%d.%03d", __func__, timeout->sec, timeout->ns / 1000000);
+
+	flags = ipc_service_run_events(service, timeout);
+
+	if (NULL != (*client = ipc_service_pop_client(service)))
+	{
+		while (messages->values_num < max_num &&
+				NULL != (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&(*client)->rx_queue)))
+		{
+			if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
+			{
+				char	*data = NULL;
+
+				zbx_ipc_message_format(message, &data);
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() %s", __func__, data);
+
+				zbx_free(data);
+			}
+
+			zbx_vector_ipcmsg_append(messages, message);
+		}
+
+		if (0 != messages->values_num)
+		{
+			ipc_service_push_client(service, *client);
+			zbx_ipc_client_addref(*client);
+		}
+
+		ret = (EVLOOP_NONBLOCK == flags ? ZBX_IPC_RECV_IMMEDIATE : ZBX_IPC_RECV_WAIT);
+	}
+	else
+		ret = ZBX_IPC_RECV_TIMEOUT;
+
+	evtimer_del(service->ev_timer);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d messages:%d", __func__, ret, messages->values_num);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: interrupt IPC service recv loop from another thread               *
@@ -1692,6 +2452,71 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends multiple IPC messages to client                             *
+ *                                                                            *
+ * Parameters: client   - [IN] the IPC client                                 *
+ *             messages - [IN] the messages to send                           *
+ *                                                                            *
+ * Return value: SUCCEED - the messages were successfully sent or queued      *
+ *                         (socket send buffer is full)                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The messages are packed into batch frames, which are unpacked by *
+ *           services and asynchronous sockets. Blocking IPC sockets can read *
+ *           only messages sent with zbx_ipc_client_send() function.          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_client_send_batch(zbx_ipc_client_t *client, const zbx_vector_ipcmsg_t *messages)
+{
+	zbx_uint32_t		size;
+	int			i, j, end, ret = SUCCEED;
+	zbx_ipc_message_t	*message;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() clientid:" ZBX_FS_UI64 " messages:%d", __func__, client->id,
+			messages->values_num);
+
+	for (i = 0; i < messages->values_num && SUCCEED == ret; i = end)
+	{
+		unsigned char	*data, *ptr;
+
+		if (1 == (end = ipc_batch_get_frame(messages, i, messages->values_num, &size)) - i)
+		{
+			message = messages->values[i];
+			ret = zbx_ipc_client_send(client, message->code, message->data, message->size);
+			continue;
+		}
+
+		ptr = data = (unsigned char *)zbx_malloc(NULL, size);
+
+		for (j = i; j < end; j++)
+		{
+			zbx_uint32_t	header[2];
+
+			message = messages->values[j];
+			header[ZBX_IPC_MESSAGE_CODE] = message->code;
+			header[ZBX_IPC_MESSAGE_SIZE] = message->size;
+
+			memcpy(ptr, header, ZBX_IPC_HEADER_SIZE);
+			ptr += ZBX_IPC_HEADER_SIZE;
+
+			if (0 != message->size)
+			{
+				memcpy(ptr, message->data, message->size);
+				ptr += message->size;
+			}
+		}
+
+		ret = zbx_ipc_client_send(client, ZBX_IPC_BATCH, data, size);
+		zbx_free(data);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: closes client socket and frees resources allocated for client     *
@@ -0,0 +1,650 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "config.h"
+
+#ifdef HAVE_MEMFD_EVENTFD
+#	if !defined(_GNU_SOURCE)
+#		define _GNU_SOURCE	/* required for memfd_create() */
+#	endif
+#	include <sys/mman.h>
+#	include <sys/eventfd.h>
+#endif
+
+#include "zbxcommon.h"
+
+#ifdef HAVE_IPCSERVICE
+
+#include "ipcshm.h"
+
+#ifdef ZBX_HAVE_IPC_SHM
+
+#include "zbxatomic.h"
+
+/*
+ * Single producer, single consumer ring buffer in shared memory.
+ *
+ * The ring header is followed by the data area of power of two size. Head and tail are
+ * monotonic byte counters - head is advanced by producer after a record is written and tail
+ * is advanced by consumer after a record is read. Records are stored as message code and
+ * size followed by the message data and can wrap around the end of data area.
+ *
+ * The consumer is notified through eventfd when producer writes to an empty ring and the
+ * producer is notified through another eventfd when consumer frees space while producer is
+ * waiting for it.
+ */
+
+#define ZBX_IPC_SHM_CACHE_LINE		64
+#define ZBX_IPC_SHM_RECORD_HEADER_SIZE	(zbx_uint32_t)(sizeof(zbx_uint32_t) * 2)
+
+/* timeout in milliseconds after which producer checks if the service is still running */
+#define ZBX_IPC_SHM_WAIT_TIMEOUT	1000
+
+typedef struct
+{
+	/* number of bytes written by producer */
+	zbx_uint64_t	head;
+	unsigned char	pad_head[ZBX_IPC_SHM_CACHE_LINE - sizeof(zbx_uint64_t)];
+
+	/* number of bytes read by consumer */
+	zbx_uint64_t	tail;
+
+	/* 1 - producer is waiting for free space */
+	zbx_uint32_t	waiting;
+	unsigned char	pad_tail[ZBX_IPC_SHM_CACHE_LINE - sizeof(zbx_uint64_t) - sizeof(zbx_uint32_t)];
+}
+zbx_ipc_shm_ring_t;
+
+struct zbx_ipc_shm
+{
+	zbx_ipc_shm_ring_t	*ring;
+	unsigned char		*data;
+	size_t			map_size;
+
+	/* data area size, power of two */
+	zbx_uint32_t		size;
+
+	int			memfd;
+
+	/* signalled by producer when data is written to empty ring */
+	int			data_fd;
+
+	/* signalled by consumer when space is freed for waiting producer */
+	int			space_fd;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rounds ring size up to the nearest supported power of two         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	ipc_shm_round_size(zbx_uint32_t size)
+{
+	zbx_uint32_t	rounded = ZBX_IPC_SHM_SIZE_MIN;
+
+	while (rounded < size && rounded < ZBX_IPC_SHM_SIZE_MAX)
+		rounded <<= 1;
+
+	return rounded;
+}
+
+static void	ipc_shm_notify(int fd)
+{
+	zbx_uint64_t	value = 1;
+
+	while (-1 == write(fd, &value, sizeof(value)) && EINTR == errno)
+		;
+}
+
+static void	ipc_shm_drain_notify(int fd)
+{
+	zbx_uint64_t	value;
+
+	while (-1 == read(fd, &value, sizeof(value)) && EINTR == errno)
+		;
+}
+
+static zbx_ipc_shm_t	*ipc_shm_new(void)
+{
+	zbx_ipc_shm_t	*shm;
+
+	shm = (zbx_ipc_shm_t *)zbx_malloc(NULL, sizeof(zbx_ipc_shm_t));
+	memset(shm, 0, sizeof(zbx_ipc_shm_t));
+	shm->memfd = -1;
+	shm->data_fd = -1;
+	shm->space_fd = -1;
+
+	return shm;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: maps shared memory ring                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_map(zbx_ipc_shm_t *shm, zbx_uint32_t size, char **error)
+{
+	void	*addr;
+
+	shm->map_size = sizeof(zbx_ipc_shm_ring_t) + size;
+
+	if (MAP_FAILED == (addr = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->memfd, 0)))
+	{
+		*error = zbx_dsprintf(*error, "cannot map shared memory ring: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	shm->ring = (zbx_ipc_shm_ring_t *)addr;
+	shm->data = (unsigned char *)addr + sizeof(zbx_ipc_shm_ring_t);
+	shm->size = size;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates shared memory ring on producer side                       *
+ *                                                                            *
+ * Parameters: size  - [IN] requested data area size, rounded up to power of  *
+ *                          two                                               *
+ *             error - [OUT]                                                  *
+ *                                                                            *
+ * Return value: The created ring or NULL on error.                           *
+ *                                                                            *
+ ******************************************************************************/
+zbx_ipc_shm_t	*ipc_shm_create(zbx_uint32_t size, char **error)
+{
+	zbx_ipc_shm_t	*shm;
+
+	shm = ipc_shm_new();
+	size = ipc_shm_round_size(size);
+
+	if (-1 == (shm->memfd = memfd_create("zabbix_ipc", MFD_CLOEXEC)))
+	{
+		*error = zbx_dsprintf(*error, "cannot create shared memory file: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (-1 == ftruncate(shm->memfd, (off_t)(sizeof(zbx_ipc_shm_ring_t) + size)))
+	{
+		*error = zbx_dsprintf(*error, "cannot set shared memory file size: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (-1 == (shm->data_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) ||
+			-1 == (shm->space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)))
+	{
+		*error = zbx_dsprintf(*error, "cannot create event file descriptor: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (SUCCEED != ipc_shm_map(shm, size, error))
+		goto fail;
+
+	return shm;
+fail:
+	ipc_shm_free(shm);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates consumer side ring from descriptors received from         *
+ *          producer, the ring must be attached before use                    *
+ *                                                                            *
+ * Parameters: fds     - [IN] memfd, data and space notification descriptors  *
+ *             fds_num - [IN] number of received descriptors                  *
+ *                                                                            *
+ * Return value: The created ring or NULL if unexpected descriptors were      *
+ *               received (the descriptors are closed).                       *
+ *                                                                            *
+ ******************************************************************************/
+zbx_ipc_shm_t	*ipc_shm_create_pending(const int *fds, int fds_num)
+{
+	zbx_ipc_shm_t	*shm;
+
+	if (ZBX_IPC_SHM_FDS_NUM != fds_num)
+	{
+		int	i;
+
+		for (i = 0; i < fds_num; i++)
+			close(fds[i]);
+
+		return NULL;
+	}
+
+	shm = ipc_shm_new();
+	shm->memfd = fds[0];
+	shm->data_fd = fds[1];
+	shm->space_fd = fds[2];
+
+	return shm;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: maps the ring created by producer                                 *
+ *                                                                            *
+ * Parameters: shm   - [IN] pending consumer side ring                        *
+ *             size  - [IN] data area size announced by producer              *
+ *             error - [OUT]                                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the ring was attached                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	ipc_shm_attach(zbx_ipc_shm_t *shm, zbx_uint32_t size, char **error)
+{
+	struct stat	st;
+	int		ret;
+
+	if (NULL != shm->ring)
+	{
+		*error = zbx_strdup(*error, "shared memory ring is already attached");
+		return FAIL;
+	}
+
+	if (size < ZBX_IPC_SHM_SIZE_MIN || size > ZBX_IPC_SHM_SIZE_MAX || 0 != (size & (size - 1)))
+	{
+		*error = zbx_dsprintf(*error, "invalid shared memory ring size %u", size);
+		return FAIL;
+	}
+
+	if (-1 == fstat(shm->memfd, &st))
+	{
+		*error = zbx_dsprintf(*error, "cannot obtain shared memory file size: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if ((off_t)(sizeof(zbx_ipc_shm_ring_t) + size) != st.st_size)
+	{
+		*error = zbx_dsprintf(*error, "shared memory file size does not match ring size %u", size);
+		return FAIL;
+	}
+
+	if (SUCCEED == (ret = ipc_shm_map(shm, size, error)))
+		ipc_shm_close_memfd(shm);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unmaps ring and closes its descriptors                            *
+ *                                                                            *
+ ******************************************************************************/
+void	ipc_shm_free(zbx_ipc_shm_t *shm)
+{
+	if (NULL != shm->ring)
+		munmap((void *)shm->ring, shm->map_size);
+
+	ipc_shm_close_memfd(shm);
+
+	if (-1 != shm->data_fd)
+		close(shm->data_fd);
+
+	if (-1 != shm->space_fd)
+		close(shm->space_fd);
+
+	zbx_free(shm);
+}
+
+void	ipc_shm_get_fds(const zbx_ipc_shm_t *shm, int *fds)
+{
+	fds[0] = shm->memfd;
+	fds[1] = shm->data_fd;
+	fds[2] = shm->space_fd;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes shared memory file descriptor, the mapping stays valid     *
+ *                                                                            *
+ ******************************************************************************/
+void	ipc_shm_close_memfd(zbx_ipc_shm_t *shm)
+{
+	if (-1 != shm->memfd)
+	{
+		close(shm->memfd);
+		shm->memfd = -1;
+	}
+}
+
+int	ipc_shm_is_attached(const zbx_ipc_shm_t *shm)
+{
+	return NULL != shm->ring ? SUCCEED : FAIL;
+}
+
+int	ipc_shm_get_notify_fd(const zbx_ipc_shm_t *shm)
+{
+	return shm->data_fd;
+}
+
+zbx_uint32_t	ipc_shm_get_size(const zbx_ipc_shm_t *shm)
+{
+	return shm->size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if message of the specified size can be written to ring    *
+ *                                                                            *
+ ******************************************************************************/
+int	ipc_shm_fits(const zbx_ipc_shm_t *shm, zbx_uint32_t size)
+{
+	return size <= shm->size - ZBX_IPC_SHM_RECORD_HEADER_SIZE ? SUCCEED : FAIL;
+}
+
+static void	ipc_shm_copy_in(zbx_ipc_shm_t *shm, zbx_uint64_t pos, const void *src, zbx_uint32_t size)
+{
+	zbx_uint32_t	offset, chunk;
+
+	offset = (zbx_uint32_t)(pos & (shm->size - 1));
+	chunk = MIN(size, shm->size - offset);
+
+	memcpy(shm->data + offset, src, chunk);
+
+	if (chunk < size)
+		memcpy(shm->data, (const unsigned char *)src + chunk, size - chunk);
+}
+
+static void	ipc_shm_copy_out(const zbx_ipc_shm_t *shm, zbx_uint64_t pos, void *dst, zbx_uint32_t size)
+{
+	zbx_uint32_t	offset, chunk;
+
+	offset = (zbx_uint32_t)(pos & (shm->size - 1));
+	chunk = MIN(size, shm->size - offset);
+
+	memcpy(dst, shm->data + offset, chunk);
+
+	if (chunk < size)
+		memcpy((unsigned char *)dst + chunk, shm->data, size - chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the service on the other side of socket is running      *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_check_peer(int sockfd)
+{
+	char	buf;
+	ssize_t	n;
+
+	while (-1 == (n = recv(sockfd, &buf, 1, MSG_PEEK | MSG_DONTWAIT)))
+	{
+		if (EINTR == errno)
+			continue;
+
+		if (EWOULDBLOCK == errno || EAGAIN == errno)
+			return SUCCEED;
+
+		return FAIL;
+	}
+
+	return 0 == n ? FAIL : SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits until ring has the requested free space                     *
+ *                                                                            *
+ * Parameters: shm    - [IN] producer side ring                               *
+ *             sockfd - [IN] socket connected to the service, used to detect  *
+ *                           when the service has stopped                     *
+ *             size   - [IN] required free space                              *
+ *                                                                            *
+ * Return value: SUCCEED - the space is available                             *
+ *               FAIL    - the service has closed connection                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_wait_space(zbx_ipc_shm_t *shm, int sockfd, zbx_uint32_t size)
+{
+	zbx_uint64_t	head;
+
+	head = ZBX_ATOMIC_LOAD_RELAXED(&shm->ring->head);
+
+	if (shm->size - (head - ZBX_ATOMIC_LOAD_ACQUIRE(&shm->ring->tail)) >= size)
+		return SUCCEED;
+
+	/* when ring is full wait for a larger chunk of free space to avoid waking up after every message */
+	size = MAX(size, shm->size / 4);
+
+	while (shm->size - (head - ZBX_ATOMIC_LOAD_ACQUIRE(&shm->ring->tail)) < size)
+	{
+		struct pollfd	pd;
+		int		rc;
+
+		ZBX_ATOMIC_STORE_RELAXED(&shm->ring->waiting, 1);
+		ZBX_ATOMIC_FENCE_FULL();
+
+		/* consumer might have freed space before seeing the waiting flag */
+		if (shm->size - (head - ZBX_ATOMIC_LOAD_ACQUIRE(&shm->ring->tail)) >= size)
+			break;
+
+		pd.fd = shm->space_fd;
+		pd.events = POLLIN;
+
+		if (-1 == (rc = poll(&pd, 1, ZBX_IPC_SHM_WAIT_TIMEOUT)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for shared memory ring space: %s",
+					zbx_strerror(errno));
+			return FAIL;
+		}
+
+		if (0 == rc)
+		{
+			if (SUCCEED != ipc_shm_check_peer(sockfd))
+				return FAIL;
+
+			continue;
+		}
+
+		ipc_shm_drain_notify(shm->space_fd);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes message to ring, waiting for free space if necessary       *
+ *                                                                            *
+ * Parameters: shm    - [IN] producer side ring                               *
+ *             sockfd - [IN] socket connected to the service                  *
+ *             code   - [IN] message code                                     *
+ *             data   - [IN] message data                                     *
+ *             size   - [IN] message data size, must fit the ring             *
+ *                                                                            *
+ * Return value: SUCCEED - the message was written                            *
+ *               FAIL    - the service has closed connection                  *
+ *                                                                            *
+ ******************************************************************************/
+int	ipc_shm_write(zbx_ipc_shm_t *shm, int sockfd, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size)
+{
+	zbx_uint64_t	head;
+	zbx_uint32_t	header[2], record_size = size + ZBX_IPC_SHM_RECORD_HEADER_SIZE;
+
+	if (SUCCEED != ipc_shm_wait_space(shm, sockfd, record_size))
+		return FAIL;
+
+	head = ZBX_ATOMIC_LOAD_RELAXED(&shm->ring->head);
+
+	header[0] = code;
+	header[1] = size;
+	ipc_shm_copy_in(shm, head, header, ZBX_IPC_SHM_RECORD_HEADER_SIZE);
+
+	if (0 != size)
+		ipc_shm_copy_in(shm, head + ZBX_IPC_SHM_RECORD_HEADER_SIZE, data, size);
+
+	ZBX_ATOMIC_STORE_RELEASE(&shm->ring->head, head + record_size);
+	ZBX_ATOMIC_FENCE_FULL();
+
+	/* consumer goes to sleep only after emptying the ring */
+	if (ZBX_ATOMIC_LOAD_RELAXED(&shm->ring->tail) == head)
+		ipc_shm_notify(shm->data_fd);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits until consumer has read all messages from ring              *
+ *                                                                            *
+ * Comments: Used before sending messages larger than ring through socket to  *
+ *           preserve message order.                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	ipc_shm_wait_empty(zbx_ipc_shm_t *shm, int sockfd)
+{
+	return ipc_shm_wait_space(shm, sockfd, shm->size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns position after the last message written to ring          *
+ *                                                                            *
+ * Comments: Used by consumer to read only messages written before the socket *
+ *           was read, as messages written to socket later must not be passed *
+ *           by ring messages written after them.                             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	ipc_shm_get_head(const zbx_ipc_shm_t *shm)
+{
+	return ZBX_ATOMIC_LOAD_ACQUIRE(&shm->ring->head);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads the next message from ring                                  *
+ *                                                                            *
+ * Parameters: shm     - [IN] consumer side ring                              *
+ *             head    - [IN] position up to which messages are read          *
+ *             message - [OUT] the read message or NULL if there are no       *
+ *                             messages before head                           *
+ *                                                                            *
+ * Return value: SUCCEED - the message was read or there are no messages      *
+ *               FAIL    - ring contents are corrupted                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_read(zbx_ipc_shm_t *shm, zbx_uint64_t head, zbx_ipc_message_t **message)
+{
+	zbx_uint64_t	tail, used;
+	zbx_uint32_t	header[2];
+
+	tail = ZBX_ATOMIC_LOAD_RELAXED(&shm->ring->tail);
+
+	if (head == tail)
+	{
+		*message = NULL;
+		return SUCCEED;
+	}
+
+	used = head - tail;
+
+	if (ZBX_IPC_SHM_RECORD_HEADER_SIZE > used || shm->size < used)
+		return FAIL;
+
+	ipc_shm_copy_out(shm, tail, header, ZBX_IPC_SHM_RECORD_HEADER_SIZE);
+
+	if (header[1] > used - ZBX_IPC_SHM_RECORD_HEADER_SIZE)
+		return FAIL;
+
+	*message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
+	(*message)->code = header[0];
+	(*message)->size = header[1];
+
+	if (0 != header[1])
+	{
+		(*message)->data = (unsigned char *)zbx_malloc(NULL, header[1]);
+		ipc_shm_copy_out(shm, tail + ZBX_IPC_SHM_RECORD_HEADER_SIZE, (*message)->data, header[1]);
+	}
+	else
+		(*message)->data = NULL;
+
+	ZBX_ATOMIC_STORE_RELEASE(&shm->ring->tail, tail + ZBX_IPC_SHM_RECORD_HEADER_SIZE + header[1]);
+	ZBX_ATOMIC_FENCE_FULL();
+
+	if (0 != ZBX_ATOMIC_LOAD_RELAXED(&shm->ring->waiting) && 0 != ZBX_ATOMIC_EXCHANGE(&shm->ring->waiting, 0))
+		ipc_shm_notify(shm->space_fd);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads messages from ring into queue                               *
+ *                                                                            *
+ * Parameters: shm     - [IN] consumer side ring                              *
+ *             queue   - [OUT] the read messages                              *
+ *             max_num - [IN] maximum number of messages to read              *
+ *             head    - [IN] position up to which messages are read, see     *
+ *                            ipc_shm_get_head()                              *
+ *                                                                            *
+ * Return value: SUCCEED - the messages were read                             *
+ *               FAIL    - ring contents are corrupted                        *
+ *                                                                            *
+ * Comments: The notification is reset only after ring is emptied, so the     *
+ *           consumer will be woken up again if messages were left in ring.   *
+ *                                                                            *
+ ******************************************************************************/
+int	ipc_shm_read_messages(zbx_ipc_shm_t *shm, zbx_queue_ptr_t *queue, int max_num, zbx_uint64_t head)
+{
+	zbx_ipc_message_t	*message;
+	zbx_uint64_t		tail;
+	int			num = 0;
+
+	while (num < max_num)
+	{
+		if (SUCCEED != ipc_shm_read(shm, head, &message))
+			return FAIL;
+
+		if (NULL == message)
+			break;
+
+		zbx_queue_ptr_push(queue, message);
+		num++;
+	}
+
+	tail = ZBX_ATOMIC_LOAD_RELAXED(&shm->ring->tail);
+
+	if (tail == ZBX_ATOMIC_LOAD_ACQUIRE(&shm->ring->head))
+	{
+		/* reset notification and check for messages written meanwhile */
+		ipc_shm_drain_notify(shm->data_fd);
+		ZBX_ATOMIC_FENCE_FULL();
+
+		if (tail == ZBX_ATOMIC_LOAD_ACQUIRE(&shm->ring->head))
+			return SUCCEED;
+	}
+
+	/* notification might have been reset while ring is not empty */
+	ipc_shm_notify(shm->data_fd);
+
+	return SUCCEED;
+}
+
+#endif
+
+#endif
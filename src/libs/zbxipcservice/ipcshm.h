@@ -0,0 +1,62 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_IPCSHM_H
+#define ZABBIX_IPCSHM_H
+
+#include "zbxipcservice.h"
+
+#if defined(HAVE_MEMFD_EVENTFD) && defined(HAVE_ATOMIC_BUILTINS)
+#	define ZBX_HAVE_IPC_SHM
+#endif
+
+#ifdef ZBX_HAVE_IPC_SHM
+
+/* reserved message codes used to negotiate shared memory ring with the service */
+#define ZBX_IPC_SHM_REQUEST	0xfffffff0u
+#define ZBX_IPC_SHM_RESPONSE	0xfffffff1u
+
+/* memfd, data notification and free space notification descriptors */
+#define ZBX_IPC_SHM_FDS_NUM	3
+
+#define ZBX_IPC_SHM_SIZE_MIN	(64 * ZBX_KIBIBYTE)
+#define ZBX_IPC_SHM_SIZE_MAX	(64 * ZBX_MEBIBYTE)
+
+zbx_ipc_shm_t	*ipc_shm_create(zbx_uint32_t size, char **error);
+zbx_ipc_shm_t	*ipc_shm_create_pending(const int *fds, int fds_num);
+int		ipc_shm_attach(zbx_ipc_shm_t *shm, zbx_uint32_t size, char **error);
+void		ipc_shm_free(zbx_ipc_shm_t *shm);
+
+void		ipc_shm_get_fds(const zbx_ipc_shm_t *shm, int *fds);
+void		ipc_shm_close_memfd(zbx_ipc_shm_t *shm);
+int		ipc_shm_is_attached(const zbx_ipc_shm_t *shm);
+int		ipc_shm_get_notify_fd(const zbx_ipc_shm_t *shm);
+zbx_uint32_t	ipc_shm_get_size(const zbx_ipc_shm_t *shm);
+
+int		ipc_shm_fits(const zbx_ipc_shm_t *shm, zbx_uint32_t size);
+int		ipc_shm_write(zbx_ipc_shm_t *shm, int sockfd, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size);
+int		ipc_shm_wait_empty(zbx_ipc_shm_t *shm, int sockfd);
+
+zbx_uint64_t	ipc_shm_get_head(const zbx_ipc_shm_t *shm);
+int		ipc_shm_read_messages(zbx_ipc_shm_t *shm, zbx_queue_ptr_t *queue, int max_num, zbx_uint64_t head);
+
+#endif
+
+#endif
@@ -66,7 +66,7 @@ zbx_int64_t	json_error(const char *message, const char *ptr, char **error)
  *               message.                                                     *
  *                                                                            *
  ******************************************************************************/
-static zbx_int64_t	json_parse_string(const char *start, char **str, char **error)
+zbx_int64_t	json_parse_string(const char *start, char **str, char **error)
 {
 	const char	*ptr = start;
 
@@ -327,7 +327,6 @@ static zbx_int64_t	json_parse_literal(const char *start, const char *text, char
  ******************************************************************************/
 zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, int depth, char **error)
 {
-#define ZBX_MAX_JSON_DEPTH	64
 	const char	*ptr = start;
 	zbx_int64_t	len;
 	char		*str = NULL;
@@ -408,7 +407,6 @@ zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, int depth, c
 	}
 
 	return ptr - start + len;
-#undef ZBX_MAX_JSON_DEPTH
 }
 
 /******************************************************************************
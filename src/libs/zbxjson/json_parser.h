@@ -23,8 +23,11 @@
 #include "zbxtypes.h"
 #include "jsonobj.h"
 
+#define ZBX_MAX_JSON_DEPTH	64
+
 zbx_int64_t	zbx_json_validate(const char *start, char **error);
 
+zbx_int64_t	json_parse_string(const char *start, char **str, char **error);
 zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, int depth, char **error);
 
 zbx_int64_t	json_error(const char *message, const char *ptr, char **error);
@@ -2866,30 +2866,27 @@ static void	jsonpath_ctx_clear(zbx_jsonpath_context_t *ctx)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: perform jsonpath query on the specified json object               *
+ * Purpose: perform compiled jsonpath query on the specified json object      *
  *                                                                            *
- * Parameters: obj    - [IN] json object                                  *
- *             index  - [IN] jsonpath index (optional)                        *
- *             path   - [IN] jsonpath                                         *
- *             output - [OUT] output value                                    *
+ * Parameters: obj      - [IN] json object                                    *
+ *             index    - [IN] jsonpath index (optional)                      *
+ *             jsonpath - [IN] compiled jsonpath                              *
+ *             output   - [OUT] output value                                  *
  *                                                                            *
  * Return value: SUCCEED - the query was performed successfully (empty result *
  *                         being counted as successful query)                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const char *path, char **output)
+int	zbx_jsonobj_query_compiled(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, zbx_jsonpath_t *jsonpath,
+		char **output)
 {
 	zbx_jsonpath_context_t	ctx;
-	zbx_jsonpath_t		jsonpath;
 	int			ret = SUCCEED;
 
-	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
-		return FAIL;
-
 	ctx.found = 0;
 	ctx.root = obj;
-	ctx.path = &jsonpath;
+	ctx.path = jsonpath;
 	zbx_vector_jsonobj_ref_create(&ctx.objects);
 	ctx.index = index;
 
@@ -2908,15 +2905,15 @@ int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const
 	if (SUCCEED == ret)
 	{
 		zbx_vector_jsonobj_ref_t	out;
-		int				definite_path = jsonpath.definite, path_depth;
+		int				definite_path = jsonpath->definite, path_depth;
 
 		zbx_vector_jsonobj_ref_create(&out);
 
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
+		if (path_depth < jsonpath->segments_num)
 		{
 			if (SUCCEED == (ret = jsonpath_apply_functions(&ctx, path_depth, &definite_path, &out)))
 				ret = jsonpath_format_query_result(&out, definite_path, output);
@@ -2929,6 +2926,34 @@ int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const
 	}
 
 	jsonpath_ctx_clear(&ctx);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: perform jsonpath query on the specified json object               *
+ *                                                                            *
+ * Parameters: obj    - [IN] json object                                      *
+ *             index  - [IN] jsonpath index (optional)                        *
+ *             path   - [IN] jsonpath                                         *
+ *             output - [OUT] output value                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const char *path, char **output)
+{
+	zbx_jsonpath_t	jsonpath;
+	int		ret;
+
+	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
+		return FAIL;
+
+	ret = zbx_jsonobj_query_compiled(obj, index, &jsonpath, output);
+
 	zbx_jsonpath_clear(&jsonpath);
 
 	return ret;
@@ -2939,6 +2964,500 @@ int	zbx_jsonobj_query(zbx_jsonobj_t *obj, const char *path, char **output)
 	return zbx_jsonobj_query_ext(obj, NULL, path, output);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if jsonpath can be evaluated by streaming query             *
+ *                                                                            *
+ * Parameters: jsonpath - [IN] compiled jsonpath                              *
+ *                                                                            *
+ * Return value: SUCCEED - the jsonpath consists only of single name or       *
+ *                         non-negative index segments                        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_is_streamable(const zbx_jsonpath_t *jsonpath)
+{
+	if (1 != jsonpath->definite || 0 == jsonpath->segments_num)
+		return FAIL;
+
+	for (int i = 0; i < jsonpath->segments_num; i++)
+	{
+		const zbx_jsonpath_segment_t	*segment = &jsonpath->segments[i];
+
+		if (ZBX_JSONPATH_SEGMENT_MATCH_LIST != segment->type || 0 != segment->detached)
+			return FAIL;
+
+		if (NULL == segment->data.list.values || NULL != segment->data.list.values->next)
+			return FAIL;
+
+		if (ZBX_JSONPATH_LIST_INDEX == segment->data.list.type)
+		{
+			int	index;
+
+			/* negative indexes require array size, which is not known until the array is parsed */
+			memcpy(&index, segment->data.list.values->data, sizeof(index));
+			if (0 > index)
+				return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+typedef struct
+{
+	zbx_jsonpath_query_t	*queries;
+	char			*error;
+}
+zbx_jsonpath_stream_t;
+
+static zbx_int64_t	jsonpath_stream_value(zbx_jsonpath_stream_t *stream, const char *start, int depth,
+		const int *active, int active_num, int path_depth);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set query output from the matched json object                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonpath_stream_set_output(zbx_jsonpath_query_t *query, zbx_jsonobj_t *obj)
+{
+	size_t	output_alloc = 0, output_offset = 0;
+
+	zbx_free(query->output);
+
+	if (NULL != obj)
+		(void)jsonpath_str_copy_value(&query->output, &output_alloc, &output_offset, obj);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: follow the rest of definite jsonpath in parsed json object        *
+ *                                                                            *
+ * Return value: The matched object or NULL.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_jsonobj_t	*jsonpath_stream_follow(zbx_jsonobj_t *obj, const zbx_jsonpath_t *jsonpath, int path_depth)
+{
+	for (; path_depth < jsonpath->segments_num; path_depth++)
+	{
+		const zbx_jsonpath_list_t	*list = &jsonpath->segments[path_depth].data.list;
+
+		if (ZBX_JSON_TYPE_OBJECT == obj->type && ZBX_JSONPATH_LIST_NAME == list->type)
+		{
+			zbx_jsonobj_el_t	el_local, *el;
+
+			el_local.name = list->values->data;
+			if (NULL == (el = (zbx_jsonobj_el_t *)zbx_hashset_search(&obj->data.object, &el_local)))
+				return NULL;
+
+			obj = &el->value;
+		}
+		else if (ZBX_JSON_TYPE_ARRAY == obj->type && ZBX_JSONPATH_LIST_INDEX == list->type)
+		{
+			int	index;
+
+			memcpy(&index, list->values->data, sizeof(index));
+			if (index >= obj->data.array.values_num)
+				return NULL;
+
+			obj = obj->data.array.values[index];
+		}
+		else
+			return NULL;
+	}
+
+	return obj;
+}
+
+/* jsonpath name segment of active streaming query */
+typedef struct
+{
+	const char	*name;
+	size_t		len;
+	int		query;
+}
+zbx_jsonpath_stream_name_t;
+
+static int	jsonpath_stream_name_compare(const void *d1, const void *d2)
+{
+	const zbx_jsonpath_stream_name_t	*n1 = (const zbx_jsonpath_stream_name_t *)d1;
+	const zbx_jsonpath_stream_name_t	*n2 = (const zbx_jsonpath_stream_name_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(n1->len, n2->len);
+
+	return memcmp(n1->name, n2->name, n1->len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find active queries matching object member name                   *
+ *                                                                            *
+ * Parameters: names       - [IN] sorted name segments of active queries      *
+ *             names_num   - [IN] the number of name segments                 *
+ *             start       - [IN] the quoted member name                      *
+ *             len         - [IN] the quoted member name length               *
+ *             matched     - [OUT] the matched queries                        *
+ *                                                                            *
+ * Return value: The number of matched queries.                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_stream_match_name(const zbx_jsonpath_stream_name_t *names, int names_num, const char *start,
+		zbx_int64_t len, int *matched)
+{
+	zbx_jsonpath_stream_name_t	name_local;
+	char				*name = NULL;
+	int				lo = 0, hi = names_num, matched_num = 0;
+
+	if (0 == names_num)
+		return 0;
+
+	if (NULL == memchr(start + 1, '\\', (size_t)len - 2))
+	{
+		name_local.name = start + 1;
+		name_local.len = (size_t)len - 2;
+	}
+	else
+	{
+		if (0 == json_parse_string(start, &name, NULL))
+			return 0;
+
+		name_local.name = name;
+		name_local.len = strlen(name);
+	}
+
+	/* find the first matching name, duplicate names are adjacent */
+	while (lo < hi)
+	{
+		int	mid = lo + (hi - lo) / 2;
+
+		if (0 > jsonpath_stream_name_compare(&names[mid], &name_local))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < names_num && 0 == jsonpath_stream_name_compare(&names[lo], &name_local); lo++)
+		matched[matched_num++] = names[lo].query;
+
+	zbx_free(name);
+
+	return matched_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stream json object, matching its members against active queries *
+ *                                                                            *
+ * Comments: Mirrors json_parse_object() validation.                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_int64_t	jsonpath_stream_object(zbx_jsonpath_stream_t *stream, const char *start, int depth,
+		const int *active, int active_num, int path_depth)
+{
+	const char			*ptr = start;
+	zbx_int64_t			len;
+	int				*matched, matched_num, names_num = 0;
+	zbx_jsonpath_stream_name_t	*names;
+
+	matched = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)active_num);
+	names = (zbx_jsonpath_stream_name_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_stream_name_t) *
+			(size_t)active_num);
+
+	for (int i = 0; i < active_num; i++)
+	{
+		const zbx_jsonpath_list_t	*list = &stream->queries[active[i]].path->segments[path_depth].data.list;
+
+		if (ZBX_JSONPATH_LIST_NAME != list->type)
+			continue;
+
+		names[names_num].name = list->values->data;
+		names[names_num].len = strlen(list->values->data);
+		names[names_num++].query = active[i];
+	}
+
+	qsort(names, (size_t)names_num, sizeof(zbx_jsonpath_stream_name_t), jsonpath_stream_name_compare);
+
+	ptr++;
+	SKIP_WHITESPACE(ptr);
+
+	if ('}' != *ptr)
+	{
+		while (1)
+		{
+			const char	*name = ptr;
+			zbx_int64_t	name_len;
+
+			if ('"' != *ptr)
+			{
+				len = json_error("invalid object name", ptr, &stream->error);
+				goto out;
+			}
+
+			if (0 == (name_len = json_parse_string(ptr, NULL, &stream->error)))
+			{
+				len = 0;
+				goto out;
+			}
+
+			ptr += name_len;
+
+			SKIP_WHITESPACE(ptr);
+
+			if (':' != *ptr)
+			{
+				len = json_error("invalid object name/value separator", ptr, &stream->error);
+				goto out;
+			}
+
+			ptr++;
+
+			matched_num = jsonpath_stream_match_name(names, names_num, name, name_len, matched);
+
+			if (0 == (len = jsonpath_stream_value(stream, ptr, depth, matched, matched_num, path_depth + 1)))
+				goto out;
+
+			ptr += len;
+
+			SKIP_WHITESPACE(ptr);
+
+			if (',' != *ptr)
+				break;
+
+			ptr++;
+			SKIP_WHITESPACE(ptr);
+		}
+
+		if ('}' != *ptr)
+		{
+			len = json_error("invalid object format, expected closing character '}'", ptr, &stream->error);
+			goto out;
+		}
+	}
+
+	len = ptr - start + 1;
+out:
+	zbx_free(names);
+	zbx_free(matched);
+
+	return len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stream json array, matching its elements against active queries  *
+ *                                                                            *
+ * Comments: Mirrors json_parse_array() validation.                           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_int64_t	jsonpath_stream_array(zbx_jsonpath_stream_t *stream, const char *start, int depth,
+		const int *active, int active_num, int path_depth)
+{
+	const char		*ptr = start;
+	zbx_int64_t		len;
+	int			*matched, matched_num, index = 0, indexes_num = 0, next = 0;
+	zbx_uint64_pair_t	*indexes;
+
+	matched = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)active_num);
+	indexes = (zbx_uint64_pair_t *)zbx_malloc(NULL, sizeof(zbx_uint64_pair_t) * (size_t)active_num);
+
+	/* array elements are visited in order, so sorted index segments can be matched by advancing position */
+	for (int i = 0; i < active_num; i++)
+	{
+		const zbx_jsonpath_list_t	*list = &stream->queries[active[i]].path->segments[path_depth].data.list;
+		int				query_index;
+
+		if (ZBX_JSONPATH_LIST_INDEX != list->type)
+			continue;
+
+		memcpy(&query_index, list->values->data, sizeof(query_index));
+		indexes[indexes_num].first = (zbx_uint64_t)query_index;
+		indexes[indexes_num++].second = (zbx_uint64_t)active[i];
+	}
+
+	qsort(indexes, (size_t)indexes_num, sizeof(zbx_uint64_pair_t), ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+
+	ptr++;
+	SKIP_WHITESPACE(ptr);
+
+	if (']' != *ptr)
+	{
+		while (1)
+		{
+			for (matched_num = 0; next < indexes_num && indexes[next].first == (zbx_uint64_t)index; next++)
+				matched[matched_num++] = (int)indexes[next].second;
+
+			if (0 == (len = jsonpath_stream_value(stream, ptr, depth, matched, matched_num, path_depth + 1)))
+				goto out;
+
+			ptr += len;
+			SKIP_WHITESPACE(ptr);
+
+			if (',' != *ptr)
+				break;
+
+			ptr++;
+			index++;
+		}
+
+		if (']' != *ptr)
+		{
+			len = json_error("invalid array format, expected closing character ']'", ptr, &stream->error);
+			goto out;
+		}
+	}
+
+	len = ptr - start + 1;
+out:
+	zbx_free(indexes);
+	zbx_free(matched);
+
+	return len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stream json value, matching it against active queries            *
+ *                                                                            *
+ * Parameters: stream     - [IN/OUT] the streaming query data                 *
+ *             start      - [IN] the json value                               *
+ *             depth      - [IN] the json nesting depth                       *
+ *             active     - [IN] the queries matching path up to this value   *
+ *             active_num - [IN] the number of active queries                 *
+ *             path_depth - [IN] the number of matched jsonpath segments      *
+ *                                                                            *
+ * Return value: The number of characters parsed. On error 0 is returned and  *
+ *               stream error contains allocated error message.               *
+ *                                                                            *
+ * Comments: Values not matched by any query are only validated. Values       *
+ *           matched by query end are parsed and formatted like in tree based *
+ *           query. If the same member is met again it replaces previous      *
+ *           results, as when building json object.                           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_int64_t	jsonpath_stream_value(zbx_jsonpath_stream_t *stream, const char *start, int depth,
+		const int *active, int active_num, int path_depth)
+{
+	const char	*ptr = start;
+	zbx_int64_t	len;
+	int		i, terminal = 0;
+
+	if (0 == active_num)
+		return json_parse_value(start, NULL, depth, &stream->error);
+
+	for (i = 0; i < active_num; i++)
+	{
+		zbx_jsonpath_query_t	*query = &stream->queries[active[i]];
+
+		if (query->path->segments_num == path_depth)
+			terminal = 1;
+
+		zbx_free(query->output);
+	}
+
+	if (0 != terminal)
+	{
+		zbx_jsonobj_t	obj;
+
+		jsonobj_init(&obj, ZBX_JSON_TYPE_UNKNOWN);
+
+		if (0 != (len = json_parse_value(start, &obj, depth, &stream->error)))
+		{
+			for (i = 0; i < active_num; i++)
+			{
+				zbx_jsonpath_query_t	*query = &stream->queries[active[i]];
+
+				jsonpath_stream_set_output(query, jsonpath_stream_follow(&obj, query->path, path_depth));
+			}
+		}
+
+		zbx_jsonobj_clear(&obj);
+
+		return len;
+	}
+
+	SKIP_WHITESPACE(ptr);
+
+	/* let the parser validate scalar values and report errors, including depth limit */
+	if (ZBX_MAX_JSON_DEPTH < depth || ('{' != *ptr && '[' != *ptr))
+		return json_parse_value(start, NULL, depth, &stream->error);
+
+	if ('{' == *ptr)
+		len = jsonpath_stream_object(stream, ptr, depth + 1, active, active_num, path_depth);
+	else
+		len = jsonpath_stream_array(stream, ptr, depth + 1, active, active_num, path_depth);
+
+	if (0 == len)
+		return 0;
+
+	return ptr - start + len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: perform multiple definite jsonpath queries with single pass over  *
+ *          json data                                                         *
+ *                                                                            *
+ * Parameters: data        - [IN] the json data                               *
+ *             queries     - [IN/OUT] the queries with compiled jsonpaths,    *
+ *                                    which must be streamable                *
+ *             queries_num - [IN] the number of queries                       *
+ *                                                                            *
+ * Return value: SUCCEED - the data was parsed successfully, query output is  *
+ *                         set to the matched value or NULL                   *
+ *               FAIL    - invalid json data                                  *
+ *                                                                            *
+ * Comments: The json tree is not built, only the matched values are parsed.  *
+ *           The results and errors are the same as when opening json object  *
+ *           and querying it with zbx_jsonobj_query().                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_query_stream(const char *data, zbx_jsonpath_query_t *queries, int queries_num)
+{
+	zbx_jsonpath_stream_t	stream = {.queries = queries, .error = NULL};
+	int			*active, i, ret = FAIL;
+
+	active = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)MAX(1, queries_num));
+
+	for (i = 0; i < queries_num; i++)
+	{
+		queries[i].output = NULL;
+		active[i] = i;
+	}
+
+	SKIP_WHITESPACE(data);
+
+	switch (*data)
+	{
+		case '{':
+			if (0 == jsonpath_stream_object(&stream, data, 0, active, queries_num, 0))
+				goto out;
+			break;
+		case '[':
+			if (0 == jsonpath_stream_array(&stream, data, 0, active, queries_num, 0))
+				goto out;
+			break;
+		default:
+			(void)json_error("invalid object format, expected opening character '{' or '['", data,
+					&stream.error);
+			goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	if (FAIL == ret)
+	{
+		for (i = 0; i < queries_num; i++)
+			zbx_free(queries[i].output);
+
+		zbx_set_json_strerror("%s", stream.error);
+		zbx_free(stream.error);
+	}
+
+	zbx_free(active);
+
+	return ret;
+}
+
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
 /* jsonobject index hashset support */
 
@@ -473,6 +473,84 @@ void	__zbx_mutex_lock(const char *filename, int line, zbx_mutex_t mutex)
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Tries to lock the mutex without waiting                           *
+ *                                                                            *
+ * Parameters: filename - [IN] source filename (for tracking)                 *
+ *             line     - [IN] source filename line number (for tracking)     *
+ *             mutex    - [IN] handle of mutex                                *
+ *                                                                            *
+ * Return value: SUCCEED - the mutex was locked                               *
+ *               FAIL    - the mutex is locked by other process               *
+ *                                                                            *
+ ******************************************************************************/
+int	__zbx_mutex_trylock(const char *filename, int line, zbx_mutex_t mutex)
+{
+#ifndef _WINDOWS
+#ifndef	HAVE_PTHREAD_PROCESS_SHARED
+	struct sembuf	sem_lock;
+#else
+	int		err;
+#endif
+#else
+	DWORD   dwWaitResult;
+#endif
+
+	if (ZBX_MUTEX_NULL == mutex)
+		return SUCCEED;
+
+#ifdef _WINDOWS
+	dwWaitResult = WaitForSingleObject(mutex, 0);
+
+	switch (dwWaitResult)
+	{
+		case WAIT_OBJECT_0:
+			return SUCCEED;
+		case WAIT_TIMEOUT:
+			return FAIL;
+		case WAIT_ABANDONED:
+			THIS_SHOULD_NEVER_HAPPEN;
+			exit(EXIT_FAILURE);
+		default:
+			zbx_error("[file:'%s',line:%d] lock failed: %s",
+				filename, line, zbx_strerror_from_system(GetLastError()));
+			exit(EXIT_FAILURE);
+	}
+#else
+#ifdef	HAVE_PTHREAD_PROCESS_SHARED
+	if (0 != locks_disabled)
+		return SUCCEED;
+
+	if (0 != (err = pthread_mutex_trylock(mutex)))
+	{
+		if (EBUSY == err)
+			return FAIL;
+
+		zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(err));
+		exit(EXIT_FAILURE);
+	}
+#else
+	sem_lock.sem_num = mutex;
+	sem_lock.sem_op = -1;
+	sem_lock.sem_flg = SEM_UNDO | IPC_NOWAIT;
+
+	while (-1 == semop(ZBX_SEM_LIST_ID, &sem_lock, 1))
+	{
+		if (EAGAIN == errno)
+			return FAIL;
+
+		if (EINTR != errno)
+		{
+			zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+#endif
+	return SUCCEED;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Unlock the mutex                                                  *
@@ -23,6 +23,7 @@
 #include "zbxjson.h"
 #include "zbxprometheus.h"
 #include "preproc_snmp.h"
+#include "zbxstr.h"
 
 /******************************************************************************
  *                                                                            *
@@ -58,10 +59,49 @@ zbx_pp_cache_t	*pp_cache_create(const zbx_pp_item_preproc_t *preproc, const zbx_
 	cache->data = NULL;
 	cache->refcount = 1;
 	cache->error = NULL;
+	zbx_vector_str_create(&cache->jsonpaths);
+	cache->prefixes = NULL;
+	cache->prefix_hits = 0;
+	cache->prefix_misses = 0;
 
 	return cache;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free compiled jsonpath step parameters                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_cache_jsonpath_query_clear(void *d)
+{
+	zbx_pp_cache_jsonpath_query_t	*query = (zbx_pp_cache_jsonpath_query_t *)d;
+
+	if (NULL == query->error)
+		zbx_jsonpath_clear(&query->path);
+
+	zbx_free(query->params);
+	zbx_free(query->output);
+	zbx_free(query->error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free jsonpath cache                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_cache_jsonpath_free(zbx_pp_cache_jsonpath_t *jsonpath)
+{
+	if (1 == jsonpath->opened)
+		zbx_jsonobj_clear(&jsonpath->obj);
+
+	zbx_hashset_destroy(&jsonpath->queries);
+	zbx_jsonpath_index_free(jsonpath->index);
+	pthread_mutex_destroy(&jsonpath->lock);
+	zbx_free(jsonpath->data);
+	zbx_free(jsonpath->error);
+	zbx_free(jsonpath);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: free preprocessing cache                                          *
@@ -76,8 +116,8 @@ static void	pp_cache_free(zbx_pp_cache_t *cache)
 		switch (cache->type)
 		{
 			case ZBX_PREPROC_JSONPATH:
-				zbx_jsonobj_clear(&((zbx_pp_cache_jsonpath_t *)cache->data)->obj);
-				zbx_jsonpath_index_free(((zbx_pp_cache_jsonpath_t *)cache->data)->index);
+				pp_cache_jsonpath_free((zbx_pp_cache_jsonpath_t *)cache->data);
+				cache->data = NULL;
 				break;
 			case ZBX_PREPROC_PROMETHEUS_PATTERN:
 				zbx_prometheus_clear((zbx_prometheus_t *)cache->data);
@@ -90,6 +130,19 @@ static void	pp_cache_free(zbx_pp_cache_t *cache)
 		zbx_free(cache->data);
 	}
 
+	zbx_vector_str_clear_ext(&cache->jsonpaths, zbx_str_free);
+	zbx_vector_str_destroy(&cache->jsonpaths);
+
+	if (NULL != cache->prefixes)
+	{
+		cache->prefixes->hits += cache->prefix_hits;
+		cache->prefixes->misses += cache->prefix_misses;
+
+		zbx_hashset_destroy(&cache->prefix_results);
+		pthread_mutex_destroy(&cache->prefix_lock);
+		pp_prefixes_release(cache->prefixes);
+	}
+
 	zbx_free(cache->error);
 	zbx_free(cache);
 }
@@ -170,3 +223,618 @@ int	pp_cache_is_supported(zbx_pp_item_preproc_t *preproc)
 
 	return FAIL;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add jsonpath of dependent item to be queried when initializing    *
+ *          jsonpath cache                                                    *
+ *                                                                            *
+ * Parameters: cache  - [IN] preprocessing cache                              *
+ *             params - [IN] jsonpath step parameters                         *
+ *                                                                            *
+ * Comments: Parameters containing user macros are skipped, because they are  *
+ *           known only after macro expansion and will be compiled on demand. *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_cache_add_jsonpath(zbx_pp_cache_t *cache, const char *params)
+{
+	if (NULL != strstr(params, "{$"))
+		return;
+
+	zbx_vector_str_append(&cache->jsonpaths, zbx_strdup(NULL, params));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile jsonpath step parameters and add them to jsonpath cache   *
+ *                                                                            *
+ * Comments: The compilation errors are cached together with parameters.      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_cache_jsonpath_query_t	*pp_cache_jsonpath_add_query(zbx_pp_cache_jsonpath_t *jsonpath,
+		const char *params)
+{
+	zbx_pp_cache_jsonpath_query_t	query_local = {0};
+
+	query_local.params = zbx_strdup(NULL, params);
+
+	if (FAIL == zbx_jsonpath_compile(params, &query_local.path))
+		query_local.error = zbx_strdup(NULL, zbx_json_strerror());
+
+	return (zbx_pp_cache_jsonpath_query_t *)zbx_hashset_insert(&jsonpath->queries, &query_local,
+			sizeof(query_local));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize jsonpath cache                                         *
+ *                                                                            *
+ * Parameters: cache - [IN] preprocessing cache                               *
+ *             value - [IN/OUT] json data - it will be moved to cache         *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was initialized                          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The definite jsonpaths of dependent items are compiled and       *
+ *           answered with single streaming pass over json data. The json     *
+ *           object is parsed later only if other jsonpaths are queried.      *
+ *           This function is called by the first dependent item task, before *
+ *           the cache is shared with the other dependent items.              *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_cache_jsonpath_init(zbx_pp_cache_t *cache, zbx_variant_t *value, char **error)
+{
+	zbx_pp_cache_jsonpath_t		*jsonpath;
+	zbx_jsonpath_query_t		*queries;
+	zbx_pp_cache_jsonpath_query_t	**streamed;
+	int				i, queries_num = 0, err, ret = FAIL;
+
+	jsonpath = (zbx_pp_cache_jsonpath_t *)zbx_malloc(NULL, sizeof(zbx_pp_cache_jsonpath_t));
+
+	if (NULL == (jsonpath->index = zbx_jsonpath_index_create(error)))
+	{
+		zbx_free(jsonpath);
+		cache->type = ZBX_PREPROC_NONE;
+		return FAIL;
+	}
+
+	if (0 != (err = pthread_mutex_init(&jsonpath->lock, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize jsonpath cache mutex: %s", zbx_strerror(err));
+		zbx_jsonpath_index_free(jsonpath->index);
+		zbx_free(jsonpath);
+		cache->type = ZBX_PREPROC_NONE;
+		return FAIL;
+	}
+
+	jsonpath->data = value->data.str;
+	zbx_variant_set_none(value);
+	jsonpath->opened = 0;
+	jsonpath->error = NULL;
+
+	zbx_hashset_create_ext(&jsonpath->queries, (size_t)cache->jsonpaths.values_num,
+			ZBX_DEFAULT_STRING_PTR_HASH_FUNC, ZBX_DEFAULT_STR_COMPARE_FUNC, pp_cache_jsonpath_query_clear,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	queries = (zbx_jsonpath_query_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_query_t) *
+			(size_t)MAX(1, cache->jsonpaths.values_num));
+	streamed = (zbx_pp_cache_jsonpath_query_t **)zbx_malloc(NULL, sizeof(zbx_pp_cache_jsonpath_query_t *) *
+			(size_t)MAX(1, cache->jsonpaths.values_num));
+
+	for (i = 0; i < cache->jsonpaths.values_num; i++)
+	{
+		zbx_pp_cache_jsonpath_query_t	*query;
+
+		if (NULL != zbx_hashset_search(&jsonpath->queries, &cache->jsonpaths.values[i]))
+			continue;
+
+		query = pp_cache_jsonpath_add_query(jsonpath, cache->jsonpaths.values[i]);
+
+		if (NULL != query->error || SUCCEED != zbx_jsonpath_is_streamable(&query->path))
+			continue;
+
+		queries[queries_num].path = &query->path;
+		streamed[queries_num++] = query;
+	}
+
+	if (0 != queries_num)
+	{
+		if (SUCCEED != zbx_jsonpath_query_stream(jsonpath->data, queries, queries_num))
+		{
+			cache->error = zbx_strdup(NULL, zbx_json_strerror());
+			*error = zbx_strdup(NULL, cache->error);
+			pp_cache_jsonpath_free(jsonpath);
+			goto out;
+		}
+
+		for (i = 0; i < queries_num; i++)
+		{
+			streamed[i]->output = queries[i].output;
+			streamed[i]->streamed = 1;
+		}
+	}
+
+	cache->data = (void *)jsonpath;
+	ret = SUCCEED;
+out:
+	zbx_vector_str_clear_ext(&cache->jsonpaths, zbx_str_free);
+	zbx_free(streamed);
+	zbx_free(queries);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: query jsonpath cache                                              *
+ *                                                                            *
+ * Parameters: cache  - [IN] preprocessing cache                              *
+ *             params - [IN] jsonpath                                         *
+ *             output - [OUT] query result or NULL if nothing was matched     *
+ *             error  - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The cache is shared between dependent items processed by         *
+ *           multiple workers. Jsonpaths not answered by streaming query are  *
+ *           compiled once and queried from json object, which is parsed on   *
+ *           first use.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_cache_jsonpath_query(zbx_pp_cache_t *cache, const char *params, char **output, char **error)
+{
+	zbx_pp_cache_jsonpath_t		*jsonpath = (zbx_pp_cache_jsonpath_t *)cache->data;
+	zbx_pp_cache_jsonpath_query_t	*query;
+
+	pthread_mutex_lock(&jsonpath->lock);
+
+	if (NULL == (query = (zbx_pp_cache_jsonpath_query_t *)zbx_hashset_search(&jsonpath->queries, &params)))
+		query = pp_cache_jsonpath_add_query(jsonpath, params);
+
+	if (1 == query->streamed)
+	{
+		pthread_mutex_unlock(&jsonpath->lock);
+
+		if (NULL != query->output)
+			*output = zbx_strdup(NULL, query->output);
+
+		return SUCCEED;
+	}
+
+	if (0 == jsonpath->opened && NULL == jsonpath->error)
+	{
+		if (SUCCEED == zbx_jsonobj_open(jsonpath->data, &jsonpath->obj))
+			jsonpath->opened = 1;
+		else
+			jsonpath->error = zbx_strdup(NULL, zbx_json_strerror());
+	}
+
+	if (NULL != jsonpath->error)
+	{
+		*error = zbx_strdup(*error, jsonpath->error);
+		goto fail;
+	}
+
+	if (NULL != query->error)
+	{
+		*error = zbx_strdup(*error, query->error);
+		goto fail;
+	}
+
+	pthread_mutex_unlock(&jsonpath->lock);
+
+	/* compiled jsonpath and parsed json object are not modified by queries */
+	if (FAIL == zbx_jsonobj_query_compiled(&jsonpath->obj, jsonpath->index, &query->path, output))
+	{
+		*error = zbx_strdup(*error, zbx_json_strerror());
+		return FAIL;
+	}
+
+	return SUCCEED;
+fail:
+	pthread_mutex_unlock(&jsonpath->lock);
+
+	return FAIL;
+}
+
+/* preprocessing step prefix node used when searching for shared prefixes */
+typedef struct
+{
+	zbx_uint64_t		parentid;
+	const zbx_pp_step_t	*step;
+	unsigned char		value_type;
+	zbx_uint64_t		prefixid;
+	int			items_num;
+}
+zbx_pp_prefix_node_t;
+
+static zbx_hash_t	pp_prefix_node_hash(const void *d)
+{
+	const zbx_pp_prefix_node_t	*node = (const zbx_pp_prefix_node_t *)d;
+	const char			*params = ZBX_NULL2EMPTY_STR(node->step->params),
+					*error_handler_params = ZBX_NULL2EMPTY_STR(node->step->error_handler_params);
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&node->parentid, sizeof(node->parentid), ZBX_DEFAULT_HASH_SEED);
+	hash = ZBX_DEFAULT_HASH_ALGO(&node->step->type, sizeof(node->step->type), hash);
+	hash = ZBX_DEFAULT_HASH_ALGO(&node->step->error_handler, sizeof(node->step->error_handler), hash);
+	hash = ZBX_DEFAULT_HASH_ALGO(&node->value_type, sizeof(node->value_type), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(params, strlen(params), hash);
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(error_handler_params, strlen(error_handler_params), hash);
+}
+
+static int	pp_prefix_node_compare(const void *d1, const void *d2)
+{
+	const zbx_pp_prefix_node_t	*n1 = (const zbx_pp_prefix_node_t *)d1;
+	const zbx_pp_prefix_node_t	*n2 = (const zbx_pp_prefix_node_t *)d2;
+	int				ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(n1->parentid, n2->parentid);
+	ZBX_RETURN_IF_NOT_EQUAL(n1->step->type, n2->step->type);
+	ZBX_RETURN_IF_NOT_EQUAL(n1->step->error_handler, n2->step->error_handler);
+	ZBX_RETURN_IF_NOT_EQUAL(n1->value_type, n2->value_type);
+
+	if (0 != (ret = strcmp(ZBX_NULL2EMPTY_STR(n1->step->params), ZBX_NULL2EMPTY_STR(n2->step->params))))
+		return ret;
+
+	return strcmp(ZBX_NULL2EMPTY_STR(n1->step->error_handler_params),
+			ZBX_NULL2EMPTY_STR(n2->step->error_handler_params));
+}
+
+static void	pp_prefix_item_clear(void *d)
+{
+	zbx_pp_prefix_item_t	*item = (zbx_pp_prefix_item_t *)d;
+
+	zbx_free(item->prefixids);
+	zbx_pp_item_preproc_release(item->preproc);
+}
+
+static void	pp_prefix_result_clear(void *d)
+{
+	zbx_pp_prefix_result_t	*result = (zbx_pp_prefix_result_t *)d;
+
+	zbx_variant_clear(&result->value);
+	zbx_variant_clear(&result->value_raw);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if preprocessing step result can be shared between items    *
+ *                                                                            *
+ * Comments: The steps using history depend on the previous values of each    *
+ *           item and scripts can have side effects, so they are executed     *
+ *           separately for every item.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_prefix_step_is_shareable(int type)
+{
+	if (ZBX_PREPROC_SCRIPT == type || SUCCEED == zbx_pp_preproc_has_history(type))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find preprocessing step prefixes shared by dependent items        *
+ *                                                                            *
+ * Parameters: revision     - [IN] preprocessing configuration revision       *
+ *             preprocs     - [IN] dependent item preprocessing data          *
+ *             preprocs_num - [IN] number of dependent items                  *
+ *                                                                            *
+ * Return value: The step prefixes shared by at least two dependent items.    *
+ *                                                                            *
+ * Comments: The prefix is identified by its last step together with parent   *
+ *           prefix, so identical leading step chains get the same prefix     *
+ *           identifiers. The item preprocessing data is referenced by the    *
+ *           returned object.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pp_prefixes_t	*pp_prefixes_create(zbx_uint64_t revision, zbx_pp_item_preproc_t **preprocs, int preprocs_num)
+{
+	zbx_pp_prefixes_t	*prefixes;
+	zbx_hashset_t		nodes;
+
+	prefixes = (zbx_pp_prefixes_t *)zbx_malloc(NULL, sizeof(zbx_pp_prefixes_t));
+	prefixes->refcount = 1;
+	prefixes->revision = revision;
+	prefixes->hits = 0;
+	prefixes->misses = 0;
+
+	zbx_hashset_create_ext(&prefixes->items, 0, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC,
+			pp_prefix_item_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	if (2 > preprocs_num)
+		return prefixes;
+
+	zbx_hashset_create(&nodes, (size_t)preprocs_num, pp_prefix_node_hash, pp_prefix_node_compare);
+
+	for (int i = 0; i < preprocs_num; i++)
+	{
+		zbx_uint64_t	parentid = 0;
+
+		for (int j = 0; j < preprocs[i]->steps_num; j++)
+		{
+			zbx_pp_prefix_node_t	node_local, *node;
+
+			if (SUCCEED != pp_prefix_step_is_shareable(preprocs[i]->steps[j].type))
+				break;
+
+			node_local.parentid = parentid;
+			node_local.step = &preprocs[i]->steps[j];
+			node_local.value_type = preprocs[i]->value_type;
+
+			if (NULL == (node = (zbx_pp_prefix_node_t *)zbx_hashset_search(&nodes, &node_local)))
+			{
+				node_local.prefixid = (zbx_uint64_t)nodes.num_data + 1;
+				node_local.items_num = 0;
+				node = (zbx_pp_prefix_node_t *)zbx_hashset_insert(&nodes, &node_local, sizeof(node_local));
+			}
+
+			node->items_num++;
+			parentid = node->prefixid;
+		}
+	}
+
+	for (int i = 0; i < preprocs_num; i++)
+	{
+		zbx_pp_prefix_item_t	item_local;
+		zbx_uint64_t		parentid = 0;
+
+		if (NULL != zbx_hashset_search(&prefixes->items, &preprocs[i]))
+			continue;
+
+		item_local.prefixids = NULL;
+		item_local.prefixes_num = 0;
+
+		/* the number of items sharing prefix can only decrease with prefix length */
+		for (int j = 0; j < preprocs[i]->steps_num; j++)
+		{
+			zbx_pp_prefix_node_t	node_local, *node;
+
+			if (SUCCEED != pp_prefix_step_is_shareable(preprocs[i]->steps[j].type))
+				break;
+
+			node_local.parentid = parentid;
+			node_local.step = &preprocs[i]->steps[j];
+			node_local.value_type = preprocs[i]->value_type;
+
+			node = (zbx_pp_prefix_node_t *)zbx_hashset_search(&nodes, &node_local);
+
+			if (2 > node->items_num)
+				break;
+
+			if (NULL == item_local.prefixids)
+			{
+				item_local.prefixids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) *
+						(size_t)preprocs[i]->steps_num);
+			}
+
+			item_local.prefixids[item_local.prefixes_num++] = node->prefixid;
+			parentid = node->prefixid;
+		}
+
+		if (0 == item_local.prefixes_num)
+			continue;
+
+		item_local.preproc = zbx_pp_item_preproc_copy(preprocs[i]);
+		zbx_hashset_insert(&prefixes->items, &item_local, sizeof(item_local));
+	}
+
+	zbx_hashset_destroy(&nodes);
+
+	return prefixes;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copy preprocessing step prefixes                                  *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pp_prefixes_t	*pp_prefixes_copy(zbx_pp_prefixes_t *prefixes)
+{
+	if (NULL == prefixes)
+		return NULL;
+
+	prefixes->refcount++;
+
+	return prefixes;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: release preprocessing step prefixes                               *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_prefixes_release(zbx_pp_prefixes_t *prefixes)
+{
+	if (NULL == prefixes || 0 != --prefixes->refcount)
+		return;
+
+	zbx_hashset_destroy(&prefixes->items);
+	zbx_free(prefixes);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get preprocessing step prefixes of configuration revision        *
+ *                                                                            *
+ * Parameters: prefixes - [IN] prefixes found for dependent items of master   *
+ *                             item (can be NULL)                             *
+ *             revision - [IN] preprocessing configuration revision           *
+ *             preproc  - [IN] master item preprocessing data                 *
+ *             items    - [IN] preprocessing items                            *
+ *                                                                            *
+ * Return value: The step prefixes of dependent items for the revision.       *
+ *                                                                            *
+ * Comments: Prefixes of older revision are released and found again, the     *
+ *           cache statistics are kept.                                       *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pp_prefixes_t	*pp_prefixes_update(zbx_pp_prefixes_t *prefixes, zbx_uint64_t revision,
+		const zbx_pp_item_preproc_t *preproc, zbx_flathashset_t *items)
+{
+	zbx_pp_item_preproc_t	**preprocs;
+	zbx_pp_prefixes_t	*prefixes_new;
+	int			preprocs_num = 0;
+
+	if (NULL != prefixes && prefixes->revision == revision)
+		return prefixes;
+
+	preprocs = (zbx_pp_item_preproc_t **)zbx_malloc(NULL, sizeof(zbx_pp_item_preproc_t *) *
+			(size_t)preproc->dep_itemids_num);
+
+	for (int i = 0; i < preproc->dep_itemids_num; i++)
+	{
+		zbx_pp_item_t	*item;
+
+		if (NULL != (item = (zbx_pp_item_t *)zbx_flathashset_search(items, &preproc->dep_itemids[i])))
+			preprocs[preprocs_num++] = item->preproc;
+	}
+
+	prefixes_new = pp_prefixes_create(revision, preprocs, preprocs_num);
+	zbx_free(preprocs);
+
+	if (NULL != prefixes)
+	{
+		prefixes_new->hits = prefixes->hits;
+		prefixes_new->misses = prefixes->misses;
+		pp_prefixes_release(prefixes);
+	}
+
+	return prefixes_new;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enable sharing of step prefix results between dependent items     *
+ *                                                                            *
+ * Parameters: cache    - [IN] preprocessing cache                            *
+ *             prefixes - [IN] shared step prefixes of dependent items (can   *
+ *                             be NULL)                                       *
+ *                                                                            *
+ * Comments: This function must be called before the cache is shared with    *
+ *           dependent item tasks.                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_cache_set_prefixes(zbx_pp_cache_t *cache, zbx_pp_prefixes_t *prefixes)
+{
+	int	err;
+
+	if (NULL == prefixes || 0 == prefixes->items.num_data)
+		return;
+
+	if (0 != (err = pthread_mutex_init(&cache->prefix_lock, NULL)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize preprocessing prefix cache mutex: %s",
+				zbx_strerror(err));
+		return;
+	}
+
+	zbx_hashset_create_ext(&cache->prefix_results, 0, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, pp_prefix_result_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	cache->prefixes = pp_prefixes_copy(prefixes);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get shared step prefixes of dependent item                        *
+ *                                                                            *
+ * Parameters: cache   - [IN] preprocessing cache                             *
+ *             preproc - [IN] dependent item preprocessing data               *
+ *                                                                            *
+ * Return value: The shared step prefixes or NULL if item has none.           *
+ *                                                                            *
+ ******************************************************************************/
+const zbx_pp_prefix_item_t	*pp_cache_get_prefix_item(zbx_pp_cache_t *cache, const zbx_pp_item_preproc_t *preproc)
+{
+	if (NULL == cache->prefixes)
+		return NULL;
+
+	/* prefixes are not modified after being attached to cache */
+	return (const zbx_pp_prefix_item_t *)zbx_hashset_search(&cache->prefixes->items, &preproc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached result of shared step prefix                           *
+ *                                                                            *
+ * Parameters: cache       - [IN] preprocessing cache                         *
+ *             prefixid    - [IN] step prefix identifier                      *
+ *             value       - [OUT] the step result                            *
+ *             value_raw   - [OUT] the step result before error handling      *
+ *             action      - [OUT] the error handling action                  *
+ *             quote_error - [OUT] 1 - the error was set by step itself       *
+ *                                                                            *
+ * Return value: SUCCEED - the prefix result was returned                     *
+ *               FAIL    - the prefix was not executed yet                    *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_cache_get_prefix_result(zbx_pp_cache_t *cache, zbx_uint64_t prefixid, zbx_variant_t *value,
+		zbx_variant_t *value_raw, int *action, int *quote_error)
+{
+	zbx_pp_prefix_result_t	*result;
+	int			ret = FAIL;
+
+	pthread_mutex_lock(&cache->prefix_lock);
+
+	if (NULL != (result = (zbx_pp_prefix_result_t *)zbx_hashset_search(&cache->prefix_results, &prefixid)))
+	{
+		zbx_variant_clear(value);
+		zbx_variant_copy(value, &result->value);
+		zbx_variant_copy(value_raw, &result->value_raw);
+		*action = result->action;
+		*quote_error = result->quote_error;
+
+		cache->prefix_hits++;
+		ret = SUCCEED;
+	}
+	else
+		cache->prefix_misses++;
+
+	pthread_mutex_unlock(&cache->prefix_lock);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache result of shared step prefix                                *
+ *                                                                            *
+ * Parameters: cache       - [IN] preprocessing cache                         *
+ *             prefixid    - [IN] step prefix identifier                      *
+ *             value       - [IN] the step result                             *
+ *             value_raw   - [IN] the step result before error handling       *
+ *             action      - [IN] the error handling action                   *
+ *             quote_error - [IN] 1 - the error was set by step itself        *
+ *                                                                            *
+ * Comments: The same prefix can be executed by several workers at the same   *
+ *           time, in this case the first result is kept.                     *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_cache_add_prefix_result(zbx_pp_cache_t *cache, zbx_uint64_t prefixid, const zbx_variant_t *value,
+		const zbx_variant_t *value_raw, int action, int quote_error)
+{
+	pthread_mutex_lock(&cache->prefix_lock);
+
+	if (NULL == zbx_hashset_search(&cache->prefix_results, &prefixid))
+	{
+		zbx_pp_prefix_result_t	result_local;
+
+		result_local.prefixid = prefixid;
+		zbx_variant_copy(&result_local.value, value);
+		zbx_variant_copy(&result_local.value_raw, value_raw);
+		result_local.action = action;
+		result_local.quote_error = quote_error;
+
+		zbx_hashset_insert(&cache->prefix_results, &result_local, sizeof(result_local));
+	}
+
+	pthread_mutex_unlock(&cache->prefix_lock);
+}
@@ -23,20 +23,77 @@
 #include "zbxpreproc.h"
 #include "zbxvariant.h"
 
+/* compiled jsonpath step parameters */
 typedef struct
 {
+	char		*params;
+	zbx_jsonpath_t	path;
+	char		*output;	/* the streaming query result */
+	char		*error;		/* the jsonpath compilation error */
+	unsigned char	streamed;	/* 1 - the output is set by streaming query */
+}
+zbx_pp_cache_jsonpath_query_t;
+
+typedef struct
+{
+	char			*data;
 	zbx_jsonobj_t		obj;
 	zbx_jsonpath_index_t	*index;
+	unsigned char		opened;		/* 1 - the json object is parsed from data */
+	char			*error;		/* the json object parsing error */
+	zbx_hashset_t		queries;
+	pthread_mutex_t		lock;
 }
 zbx_pp_cache_jsonpath_t;
 
+/* shared step prefixes of dependent item preprocessing */
+typedef struct
+{
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_uint64_t		*prefixids;	/* prefix identifiers of the leading steps */
+	int			prefixes_num;
+}
+zbx_pp_prefix_item_t;
+
+/* preprocessing step prefixes shared by dependent items of a master item */
 typedef struct
 {
 	zbx_uint32_t	refcount;
+	zbx_uint64_t	revision;
+	zbx_hashset_t	items;
+	zbx_uint64_t	hits;
+	zbx_uint64_t	misses;
+}
+zbx_pp_prefixes_t;
+
+/* the result of a shared step prefix */
+typedef struct
+{
+	zbx_uint64_t	prefixid;
 	zbx_variant_t	value;
-	int		type;
-	void		*data;
-	char		*error;
+	zbx_variant_t	value_raw;
+	int		action;
+	int		quote_error;
+}
+zbx_pp_prefix_result_t;
+
+typedef struct
+{
+	zbx_uint32_t		refcount;
+	zbx_variant_t		value;
+	int			type;
+	void			*data;
+	char			*error;
+
+	/* jsonpath parameters of dependent items to be answered with single pass over value */
+	zbx_vector_str_t	jsonpaths;
+
+	/* step prefix results shared by dependent items, can be NULL */
+	zbx_pp_prefixes_t	*prefixes;
+	zbx_hashset_t		prefix_results;
+	pthread_mutex_t		prefix_lock;
+	zbx_uint64_t		prefix_hits;
+	zbx_uint64_t		prefix_misses;
 }
 zbx_pp_cache_t;
 
@@ -47,4 +104,21 @@ zbx_pp_cache_t	*pp_cache_copy(zbx_pp_cache_t *cache);
 void	pp_cache_prepare_output_value(zbx_pp_cache_t *cache, int step_type, zbx_variant_t *value);
 int	pp_cache_is_supported(zbx_pp_item_preproc_t *preproc);
 
+void	pp_cache_add_jsonpath(zbx_pp_cache_t *cache, const char *params);
+int	pp_cache_jsonpath_init(zbx_pp_cache_t *cache, zbx_variant_t *value, char **error);
+int	pp_cache_jsonpath_query(zbx_pp_cache_t *cache, const char *params, char **output, char **error);
+
+zbx_pp_prefixes_t	*pp_prefixes_create(zbx_uint64_t revision, zbx_pp_item_preproc_t **preprocs, int preprocs_num);
+zbx_pp_prefixes_t	*pp_prefixes_copy(zbx_pp_prefixes_t *prefixes);
+void			pp_prefixes_release(zbx_pp_prefixes_t *prefixes);
+zbx_pp_prefixes_t	*pp_prefixes_update(zbx_pp_prefixes_t *prefixes, zbx_uint64_t revision,
+		const zbx_pp_item_preproc_t *preproc, zbx_flathashset_t *items);
+
+void	pp_cache_set_prefixes(zbx_pp_cache_t *cache, zbx_pp_prefixes_t *prefixes);
+const zbx_pp_prefix_item_t	*pp_cache_get_prefix_item(zbx_pp_cache_t *cache, const zbx_pp_item_preproc_t *preproc);
+int	pp_cache_get_prefix_result(zbx_pp_cache_t *cache, zbx_uint64_t prefixid, zbx_variant_t *value,
+		zbx_variant_t *value_raw, int *action, int *quote_error);
+void	pp_cache_add_prefix_result(zbx_pp_cache_t *cache, zbx_uint64_t prefixid, const zbx_variant_t *value,
+		const zbx_variant_t *value_raw, int action, int quote_error);
+
 #endif
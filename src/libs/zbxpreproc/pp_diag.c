@@ -47,6 +47,36 @@ static void	diag_add_preproc_sequences(struct zbx_json *json, const char *field,
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add master item shared step prefix cache top list to output json  *
+ *                                                                            *
+ * Parameters: json     - [OUT] the output json                               *
+ *             field    - [IN] the field name                                 *
+ *             prefixes - [IN] a top item list                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_preproc_prefixes(struct zbx_json *json, const char *field,
+		const zbx_vector_pp_prefix_stats_ptr_t *prefixes)
+{
+	zbx_json_addarray(json, field);
+
+	for (int i = 0; i < prefixes->values_num; i++)
+	{
+		const zbx_pp_prefix_stats_t	*stat = prefixes->values[i];
+		zbx_uint64_t			total = stat->hits + stat->misses;
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_adduint64(json, "itemid", stat->itemid);
+		zbx_json_adduint64(json, "hits", stat->hits);
+		zbx_json_adduint64(json, "misses", stat->misses);
+		zbx_json_addfloat(json, "hit ratio", 0 != total ? (double)stat->hits / (double)total : 0);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add requested preprocessing diagnostic information to json data   *
@@ -78,11 +108,12 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 
 		if (0 != (fields & ZBX_DIAG_PREPROC_SIMPLE))
 		{
-			zbx_uint64_t	preproc_num, pending_num, finished_num, sequences_num;
+			zbx_uint64_t	preproc_num, pending_num, finished_num, sequences_num, steals_num;
+			double		lock_wait;
 
 			time1 = zbx_time();
 			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&preproc_num, &pending_num, &finished_num,
-					&sequences_num, error)))
+					&sequences_num, &steals_num, &lock_wait, error)))
 			{
 				goto out;
 			}
@@ -96,6 +127,8 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 				zbx_json_adduint64(json, "pending tasks", pending_num);
 				zbx_json_adduint64(json, "finished tasks", finished_num);
 				zbx_json_adduint64(json, "task sequences", sequences_num);
+				zbx_json_adduint64(json, "task steals", steals_num);
+				zbx_json_addfloat(json, "queue lock wait", lock_wait);
 			}
 		}
 
@@ -132,6 +165,29 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 							(zbx_pp_sequence_stats_ptr_free_func_t)(zbx_ptr_free));
 					zbx_vector_pp_sequence_stats_ptr_destroy(&sequences);
 				}
+				else if (0 == strcmp(map->name, "prefixes"))
+				{
+					zbx_vector_pp_prefix_stats_ptr_t	prefixes;
+
+					zbx_vector_pp_prefix_stats_ptr_create(&prefixes);
+					time1 = zbx_time();
+
+					if (SUCCEED != (ret = zbx_preprocessor_get_top_prefixes((int)map->value,
+							&prefixes, error)))
+					{
+						zbx_vector_pp_prefix_stats_ptr_destroy(&prefixes);
+						goto out;
+					}
+
+					time2 = zbx_time();
+					time_total += time2 - time1;
+
+					diag_add_preproc_prefixes(json, map->name, &prefixes);
+
+					zbx_vector_pp_prefix_stats_ptr_clear_ext(&prefixes,
+							(zbx_pp_prefix_stats_ptr_free_func_t)(zbx_ptr_free));
+					zbx_vector_pp_prefix_stats_ptr_destroy(&prefixes);
+				}
 				else
 				{
 					*error = zbx_dsprintf(*error, "Unsupported top field: %s", map->name);
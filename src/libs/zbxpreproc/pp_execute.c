@@ -274,45 +274,23 @@ static int	pp_excute_jsonpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value,
 	}
 	else
 	{
-		zbx_pp_cache_jsonpath_t	*index;
-
 		if (NULL != cache->error)
 		{
 			*errmsg = zbx_strdup(NULL, cache->error);
 			return FAIL;
 		}
 
-		if (NULL == (index = (zbx_pp_cache_jsonpath_t *)cache->data))
+		if (NULL == cache->data)
 		{
 			if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 				return FAIL;
 
-			index = (zbx_pp_cache_jsonpath_t *)zbx_malloc(NULL, sizeof(zbx_pp_cache_jsonpath_t));
-
-			if (SUCCEED != zbx_jsonobj_open(value->data.str, &index->obj))
-			{
-				cache->error = zbx_strdup(NULL, zbx_json_strerror());
-				*errmsg = zbx_strdup(NULL, cache->error);
-				zbx_free(index);
-				return FAIL;
-			}
-
-			if (NULL == (index->index = zbx_jsonpath_index_create(errmsg)))
-			{
-				zbx_jsonobj_clear(&index->obj);
-				zbx_free(index);
-				cache->type = ZBX_PREPROC_NONE;
+			if (SUCCEED != pp_cache_jsonpath_init(cache, value, errmsg))
 				return FAIL;
-			}
-
-			cache->data = (void *)index;
 		}
 
-		if (FAIL == zbx_jsonobj_query_ext(&index->obj, index->index, params, &data))
-		{
-			*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
+		if (FAIL == pp_cache_jsonpath_query(cache, params, &data, errmsg))
 			return FAIL;
-		}
 	}
 
 	if (NULL == data)
@@ -1190,10 +1168,12 @@ void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_ca
 		const char *config_source_ip, zbx_variant_t *value_out, zbx_pp_result_t **results_out,
 		int *results_num_out)
 {
-	zbx_pp_result_t		*results;
-	zbx_pp_history_t	*history;
-	int			quote_error, results_num, action;
-	zbx_variant_t		value_raw;
+	zbx_pp_result_t			*results;
+	zbx_pp_history_t		*history;
+	int				quote_error, results_num, action;
+	zbx_variant_t			value_raw;
+	zbx_pp_cache_t			*shared_cache = cache;
+	const zbx_pp_prefix_item_t	*prefix = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s(): value:%s type:%s", __func__,
 			zbx_variant_value_desc(NULL == cache ? value_in : &cache->value),
@@ -1218,6 +1198,8 @@ void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_ca
 
 		/* set input value for error reporting */
 		value_in = &cache->value;
+
+		prefix = pp_cache_get_prefix_item(cache, preproc);
 	}
 
 	results = (zbx_pp_result_t *)zbx_malloc(NULL, sizeof(zbx_pp_result_t) * (size_t)preproc->steps_num);
@@ -1239,17 +1221,33 @@ void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_ca
 
 		zbx_pp_history_pop(preproc->history, i, &history_value, &history_ts);
 
-		if (SUCCEED != pp_execute_step(ctx, cache, um_handle, preproc->hostid, preproc->value_type, value_out,
-				ts, preproc->steps + i, &history_value, &history_ts, config_source_ip))
+		/* the leading steps shared with other dependent items are executed once per master item value */
+		if (NULL != prefix && i < prefix->prefixes_num && SUCCEED == pp_cache_get_prefix_result(shared_cache,
+				prefix->prefixids[i], value_out, &value_raw, &action, &quote_error))
 		{
-			zbx_variant_copy(&value_raw, value_out);
-			if (ZBX_PREPROC_FAIL_DEFAULT == (action = pp_error_on_fail(value_out, preproc->steps + i)))
-				zbx_variant_clear(&value_raw);
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() step:%d result is shared with other dependent items", __func__,
+					preproc->steps[i].type);
 		}
 		else
 		{
-			if (ZBX_VARIANT_ERR == value_out->type)
-				quote_error = 1;
+			if (SUCCEED != pp_execute_step(ctx, cache, um_handle, preproc->hostid, preproc->value_type,
+					value_out, ts, preproc->steps + i, &history_value, &history_ts, config_source_ip))
+			{
+				zbx_variant_copy(&value_raw, value_out);
+				if (ZBX_PREPROC_FAIL_DEFAULT == (action = pp_error_on_fail(value_out, preproc->steps + i)))
+					zbx_variant_clear(&value_raw);
+			}
+			else
+			{
+				if (ZBX_VARIANT_ERR == value_out->type)
+					quote_error = 1;
+			}
+
+			if (NULL != prefix && i < prefix->prefixes_num)
+			{
+				pp_cache_add_prefix_result(shared_cache, prefix->prefixids[i], value_out, &value_raw,
+						action, quote_error);
+			}
 		}
 
 		pp_result_set(results + results_num++, value_out, action, &value_raw);
@@ -49,6 +49,23 @@
 
 static zbx_flush_value_func_t	flush_value_func_cb = NULL;
 
+ZBX_PTR_VECTOR_IMPL(pp_prefix_stats_ptr, zbx_pp_prefix_stats_t *)
+
+/* shared step prefixes of master item dependents */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	zbx_pp_prefixes_t	*prefixes;
+}
+zbx_pp_manager_prefixes_t;
+
+static void	pp_manager_prefixes_clear(void *d)
+{
+	zbx_pp_manager_prefixes_t	*entry = (zbx_pp_manager_prefixes_t *)d;
+
+	pp_prefixes_release(entry->prefixes);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize xml library, called before creating worker threads     *
@@ -134,7 +151,7 @@ static zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb
 	manager = (zbx_pp_manager_t *)zbx_malloc(NULL, sizeof(zbx_pp_manager_t));
 	memset(manager, 0, sizeof(zbx_pp_manager_t));
 
-	if (SUCCEED != pp_task_queue_init(&manager->queue, error))
+	if (SUCCEED != pp_task_queue_init(&manager->queue, workers_num, error))
 		goto out;
 
 	manager->timekeeper = zbx_timekeeper_create(workers_num, NULL);
@@ -153,8 +170,12 @@ static zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb
 		pp_worker_set_finished_cb(&manager->workers[i], finished_cb, finished_data);
 	}
 
-	zbx_hashset_create_ext(&manager->items, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
-			(zbx_clean_func_t)zbx_pp_item_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+	zbx_flathashset_create_ext(&manager->items, 100, sizeof(zbx_pp_item_t), ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_pp_item_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	zbx_hashset_create_ext(&manager->prefixes, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			pp_manager_prefixes_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
 			ZBX_DEFAULT_MEM_FREE_FUNC);
 
 	/* wait for threads to start */
@@ -220,7 +241,8 @@ static void	zbx_pp_manager_free(zbx_pp_manager_t *manager)
 	zbx_free(manager->workers);
 
 	pp_task_queue_destroy(&manager->queue);
-	zbx_hashset_destroy(&manager->items);
+	zbx_hashset_destroy(&manager->prefixes);
+	zbx_flathashset_destroy(&manager->items);
 
 	zbx_timekeeper_free(manager->timekeeper);
 
@@ -300,7 +322,7 @@ static zbx_pp_task_t	*zbx_pp_manager_create_task(zbx_pp_manager_t *manager, zbx_
 	if (ZBX_VARIANT_NONE == value->type)
 		return NULL;
 
-	if (NULL == (item = (zbx_pp_item_t *)zbx_hashset_search(&manager->items, &itemid)))
+	if (NULL == (item = (zbx_pp_item_t *)zbx_flathashset_search(&manager->items, &itemid)))
 		return NULL;
 
 	if (0 == item->preproc->dep_itemids_num && 0 == item->preproc->steps_num)
@@ -337,7 +359,7 @@ static zbx_pp_item_t	*pp_manager_get_cacheable_dependent_item(zbx_pp_manager_t *
 
 	for (int i = 0; i < itemids_num; i++)
 	{
-		if (NULL == (item = (zbx_pp_item_t *)zbx_hashset_search(&manager->items, &itemids[i])))
+		if (NULL == (item = (zbx_pp_item_t *)zbx_flathashset_search(&manager->items, &itemids[i])))
 			continue;
 
 		if (SUCCEED == pp_cache_is_supported(item->preproc))
@@ -347,11 +369,78 @@ static zbx_pp_item_t	*pp_manager_get_cacheable_dependent_item(zbx_pp_manager_t *
 	return NULL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add jsonpaths of dependent items to preprocessing cache, so they  *
+ *          can be answered with single pass over the cached value            *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             preproc - [IN] master item preprocessing data                  *
+ *             cache   - [IN] preprocessing cache                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_manager_cache_add_jsonpaths(zbx_pp_manager_t *manager, const zbx_pp_item_preproc_t *preproc,
+		zbx_pp_cache_t *cache)
+{
+	if (ZBX_PREPROC_JSONPATH != cache->type)
+		return;
+
+	for (int i = 0; i < preproc->dep_itemids_num; i++)
+	{
+		zbx_pp_item_t	*item;
+
+		if (NULL == (item = (zbx_pp_item_t *)zbx_flathashset_search(&manager->items, &preproc->dep_itemids[i])))
+			continue;
+
+		if (0 == item->preproc->steps_num || ZBX_PREPROC_JSONPATH != item->preproc->steps[0].type)
+			continue;
+
+		pp_cache_add_jsonpath(cache, item->preproc->steps[0].params);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get preprocessing step prefixes shared by dependent items         *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             itemid  - [IN] master itemid                                   *
+ *             preproc - [IN] master item preprocessing data                  *
+ *                                                                            *
+ * Return value: The shared step prefixes or NULL if master item has less     *
+ *               than two dependent items.                                    *
+ *                                                                            *
+ * Comments: The prefixes are found again after configuration changes, the    *
+ *           cache statistics are kept.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_prefixes_t	*pp_manager_get_prefixes(zbx_pp_manager_t *manager, zbx_uint64_t itemid,
+		const zbx_pp_item_preproc_t *preproc)
+{
+	zbx_pp_manager_prefixes_t	*entry;
+
+	if (2 > preproc->dep_itemids_num)
+		return NULL;
+
+	if (NULL == (entry = (zbx_pp_manager_prefixes_t *)zbx_hashset_search(&manager->prefixes, &itemid)))
+	{
+		zbx_pp_manager_prefixes_t	entry_local = {.itemid = itemid, .prefixes = NULL};
+
+		entry = (zbx_pp_manager_prefixes_t *)zbx_hashset_insert(&manager->prefixes, &entry_local,
+				sizeof(entry_local));
+	}
+
+	entry->prefixes = pp_prefixes_update(entry->prefixes, manager->revision, preproc, &manager->items);
+
+	return entry->prefixes;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: create and queue tasks for dependent items                        *
  *                                                                            *
  * Parameters: manager        - [IN] manager                                  *
+ *             itemid         - [IN] master itemid                            *
  *             preproc        - [IN] master item preprocessing data           *
  *             um_handle      - [IN] shared user macro cache handle           *
  *             exclude_itemid - [IN] dependent itemid to exclude, can be 0    *
@@ -363,9 +452,9 @@ static zbx_pp_item_t	*pp_manager_get_cacheable_dependent_item(zbx_pp_manager_t *
  * Comments: This function called within task queue lock.                     *
  *                                                                            *
  ******************************************************************************/
-static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_preproc_t *preproc,
-		zbx_dc_um_shared_handle_t *um_handle, zbx_uint64_t exclude_itemid, const zbx_variant_t *value,
-		zbx_timespec_t ts, zbx_pp_cache_t *cache)
+static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_uint64_t itemid,
+		zbx_pp_item_preproc_t *preproc, zbx_dc_um_shared_handle_t *um_handle, zbx_uint64_t exclude_itemid,
+		const zbx_variant_t *value, zbx_timespec_t ts, zbx_pp_cache_t *cache)
 {
 	int	queued_num = 0;
 
@@ -375,7 +464,10 @@ static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_p
 	cache = pp_cache_copy(cache);
 
 	if (NULL == cache)
+	{
 		cache = pp_cache_create(preproc, value);
+		pp_cache_set_prefixes(cache, pp_manager_get_prefixes(manager, itemid, preproc));
+	}
 
 	for (int i = 0; i < preproc->dep_itemids_num; i++)
 	{
@@ -387,7 +479,7 @@ static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_p
 			continue;
 
 		/* skip disabled/removed items */
-		if (NULL == (item = (zbx_pp_item_t *)zbx_hashset_search(&manager->items, &preproc->dep_itemids[i])))
+		if (NULL == (item = (zbx_pp_item_t *)zbx_flathashset_search(&manager->items, &preproc->dep_itemids[i])))
 			continue;
 
 		if (ZBX_PP_PROCESS_PARALLEL == item->preproc->mode)
@@ -440,6 +532,8 @@ static void	pp_manager_queue_value_task_result(zbx_pp_manager_t *manager, zbx_pp
 		zbx_pp_task_dependent_t	*d_dep = (zbx_pp_task_dependent_t *)PP_TASK_DATA(dep_task);
 
 		d_dep->cache = pp_cache_create(item->preproc, &d->result);
+		pp_manager_cache_add_jsonpaths(manager, d->preproc, d_dep->cache);
+		pp_cache_set_prefixes(d_dep->cache, pp_manager_get_prefixes(manager, task->itemid, d->preproc));
 		zbx_variant_set_none(&value);
 
 		d_dep->primary = pp_task_value_create(item->itemid, item->preproc, d->um_handle, &value, d->ts,
@@ -449,7 +543,10 @@ static void	pp_manager_queue_value_task_result(zbx_pp_manager_t *manager, zbx_pp
 		pp_task_queue_notify(&manager->queue);
 	}
 	else
-		pp_manager_queue_dependents(manager, d->preproc, d->um_handle, 0, &d->result, d->ts, NULL);
+	{
+		pp_manager_queue_dependents(manager, task->itemid, d->preproc, d->um_handle, 0, &d->result, d->ts,
+				NULL);
+	}
 }
 
 /******************************************************************************
@@ -469,7 +566,8 @@ static zbx_pp_task_t	*pp_manager_queue_dependent_task_result(zbx_pp_manager_t *m
 	zbx_pp_task_value_t	*dp = (zbx_pp_task_value_t *)PP_TASK_DATA(task_value);
 
 	pp_manager_queue_value_task_result(manager, d->primary);
-	pp_manager_queue_dependents(manager, d->preproc, dp->um_handle, task_value->itemid, &dp->result, dp->ts, d->cache);
+	pp_manager_queue_dependents(manager, task->itemid, d->preproc, dp->um_handle, task_value->itemid, &dp->result,
+			dp->ts, d->cache);
 
 	d->primary = NULL;
 	pp_task_free(task);
@@ -575,6 +673,8 @@ static void	zbx_pp_manager_process_finished(zbx_pp_manager_t *manager, zbx_vecto
 		zbx_vector_pp_task_ptr_append(tasks, task);
 	}
 
+	pp_task_queue_update_stats(&manager->queue);
+
 	*pending_num = manager->queue.pending_num;
 	*finished_num = manager->queue.finished_num;
 	*processing_num = manager->queue.processing_num;
@@ -602,12 +702,12 @@ static void	zbx_pp_manager_process_finished(zbx_pp_manager_t *manager, zbx_vecto
  ******************************************************************************/
 static void	zbx_pp_manager_dump_items(zbx_pp_manager_t *manager)
 {
-	zbx_hashset_iter_t	iter;
+	zbx_flathashset_iter_t	iter;
 	zbx_pp_item_t		*item;
 
-	zbx_hashset_iter_reset(&manager->items, &iter);
+	zbx_flathashset_iter_reset(&manager->items, &iter);
 
-	while (NULL != (item = (zbx_pp_item_t *)zbx_hashset_iter_next(&iter)))
+	while (NULL != (item = (zbx_pp_item_t *)zbx_flathashset_iter_next(&iter)))
 	{
 		zabbix_log(LOG_LEVEL_TRACE, "itemid:" ZBX_FS_UI64 " hostid:" ZBX_FS_UI64 " revision:" ZBX_FS_UI64
 				" type:%u value_type:%u mode:%u flags:%u",
@@ -636,7 +736,7 @@ static void	zbx_pp_manager_dump_items(zbx_pp_manager_t *manager)
  * Purpose: get item configuration data for reading and updates               *
  *                                                                            *
  ******************************************************************************/
-zbx_hashset_t  *zbx_pp_manager_items(zbx_pp_manager_t *manager)
+zbx_flathashset_t	*zbx_pp_manager_items(zbx_pp_manager_t *manager)
 {
 	return &manager->items;
 }
@@ -647,12 +747,20 @@ zbx_hashset_t  *zbx_pp_manager_items(zbx_pp_manager_t *manager)
  *                                                                            *
  ******************************************************************************/
 static void	zbx_pp_manager_get_diag_stats(zbx_pp_manager_t *manager, zbx_uint64_t *preproc_num,
-		zbx_uint64_t *pending_num, zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num)
+		zbx_uint64_t *pending_num, zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num,
+		zbx_uint64_t *steals_num, double *lock_wait)
 {
+	pp_task_queue_lock(&manager->queue);
+	pp_task_queue_update_stats(&manager->queue);
+
 	*preproc_num = (zbx_uint64_t)manager->items.num_data;
 	*pending_num = manager->queue.pending_num;
 	*finished_num = manager->queue.finished_num;
 	*sequences_num = (zbx_uint64_t)manager->queue.sequences.num_data;
+	*steals_num = manager->queue.steals_num;
+	*lock_wait = manager->queue.lock_wait;
+
+	pp_task_queue_unlock(&manager->queue);
 }
 
 /******************************************************************************
@@ -693,6 +801,20 @@ static void	preprocessor_sync_configuration(zbx_pp_manager_t *manager)
 	zbx_dc_config_get_preprocessable_items(&manager->items, &manager->um_handle, &revision);
 	manager->revision = revision;
 
+	if (revision != old_revision)
+	{
+		zbx_hashset_iter_t		iter;
+		zbx_pp_manager_prefixes_t	*entry;
+
+		/* drop shared step prefixes of removed master items */
+		zbx_hashset_iter_reset(&manager->prefixes, &iter);
+		while (NULL != (entry = (zbx_pp_manager_prefixes_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_flathashset_search(&manager->items, &entry->itemid))
+				zbx_hashset_iter_remove(&iter);
+		}
+	}
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE) && revision != old_revision)
 		zbx_pp_manager_dump_items(manager);
 
@@ -706,17 +828,15 @@ static void	preprocessor_sync_configuration(zbx_pp_manager_t *manager)
  *                                                                            *
  * Parameters: value - [IN] value to be freed                                 *
  *                                                                            *
+ * Comments: Timestamp and agent result structures belong to value reader.    *
+ *                                                                            *
  ******************************************************************************/
 static void	preproc_item_value_clear(zbx_preproc_item_value_t *value)
 {
 	zbx_free(value->error);
-	zbx_free(value->ts);
 
 	if (NULL != value->result)
-	{
 		zbx_free_agent_result(value->result);
-		zbx_free(value->result);
-	}
 }
 
 /******************************************************************************
@@ -846,26 +966,28 @@ static void	preprocessing_flush_value(zbx_pp_manager_t *manager, zbx_uint64_t it
  ******************************************************************************/
 static zbx_uint64_t	preprocessor_add_request(zbx_pp_manager_t *manager, zbx_ipc_message_t *message)
 {
-	zbx_uint32_t			offset = 0;
+	zbx_pp_value_reader_t		reader;
 	zbx_preproc_item_value_t	value;
 	zbx_uint64_t			queued_num = 0;
 	zbx_vector_pp_task_ptr_t	tasks;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	if (SUCCEED != zbx_pp_value_reader_init(&reader, message->data, message->size))
+		goto out;
+
 	zbx_vector_pp_task_ptr_create(&tasks);
-	zbx_vector_pp_task_ptr_reserve(&tasks, ZBX_PREPROCESSING_BATCH_SIZE);
+	zbx_vector_pp_task_ptr_reserve(&tasks, reader.values_num);
 
 	preprocessor_sync_configuration(manager);
 
-	while (offset < message->size)
+	while (SUCCEED == zbx_pp_value_reader_next(&reader, &value))
 	{
 		zbx_variant_t		var;
 		zbx_pp_value_opt_t	var_opt;
 		zbx_timespec_t		ts;
 		zbx_pp_task_t		*task;
 
-		offset += zbx_preprocessor_unpack_value(&value, message->data + offset);
 		preproc_item_value_extract_data(&value, &var, &ts, &var_opt);
 
 		if (NULL == (task = zbx_pp_manager_create_task(manager, value.itemid, &var, ts, &var_opt)))
@@ -887,7 +1009,8 @@ static zbx_uint64_t	preprocessor_add_request(zbx_pp_manager_t *manager, zbx_ipc_
 
 	queued_num = tasks.values_num;
 	zbx_vector_pp_task_ptr_destroy(&tasks);
-
+	zbx_pp_value_reader_clear(&reader);
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return queued_num;
@@ -1008,12 +1131,15 @@ static void	preprocessor_flush_tasks(zbx_pp_manager_t *manager, zbx_vector_pp_ta
  ******************************************************************************/
 static void	preprocessor_reply_diag_info(zbx_pp_manager_t *manager, zbx_ipc_client_t *client)
 {
-	zbx_uint64_t	preproc_num, pending_num, finished_num, sequences_num;
+	zbx_uint64_t	preproc_num, pending_num, finished_num, sequences_num, steals_num;
+	double		lock_wait;
 	unsigned char	*data;
 	zbx_uint32_t	data_len;
 
-	zbx_pp_manager_get_diag_stats(manager, &preproc_num, &pending_num, &finished_num, &sequences_num);
-	data_len = zbx_preprocessor_pack_diag_stats(&data, preproc_num, pending_num, finished_num, sequences_num);
+	zbx_pp_manager_get_diag_stats(manager, &preproc_num, &pending_num, &finished_num, &sequences_num,
+			&steals_num, &lock_wait);
+	data_len = zbx_preprocessor_pack_diag_stats(&data, preproc_num, pending_num, finished_num, sequences_num,
+			steals_num, lock_wait);
 
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT, data, data_len);
 
@@ -1066,6 +1192,68 @@ static void	preprocessor_reply_top_sequences(zbx_pp_manager_t *manager, zbx_ipc_
 	zbx_vector_pp_sequence_stats_ptr_destroy(&sequences);
 }
 
+static int	preprocessor_compare_prefix_stats(const void *d1, const void *d2)
+{
+	const zbx_pp_prefix_stats_t *s1 = *(const zbx_pp_prefix_stats_t * const *)d1;
+	const zbx_pp_prefix_stats_t *s2 = *(const zbx_pp_prefix_stats_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(s2->hits + s2->misses, s1->hits + s1->misses);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: respond to top shared step prefix cache statistics request        *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] request source                                  *
+ *             message - [IN] request message                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_reply_top_prefixes(zbx_pp_manager_t *manager, zbx_ipc_client_t *client,
+		zbx_ipc_message_t *message)
+{
+	int					limit;
+	zbx_vector_pp_prefix_stats_ptr_t	prefixes;
+	zbx_hashset_iter_t			iter;
+	zbx_pp_manager_prefixes_t		*entry;
+	unsigned char				*data;
+	zbx_uint32_t				data_len;
+
+	zbx_vector_pp_prefix_stats_ptr_create(&prefixes);
+
+	zbx_preprocessor_unpack_top_request(&limit, message->data);
+
+	zbx_hashset_iter_reset(&manager->prefixes, &iter);
+	while (NULL != (entry = (zbx_pp_manager_prefixes_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_pp_prefix_stats_t	*stat;
+
+		if (0 == entry->prefixes->hits + entry->prefixes->misses)
+			continue;
+
+		stat = (zbx_pp_prefix_stats_t *)zbx_malloc(NULL, sizeof(zbx_pp_prefix_stats_t));
+		stat->itemid = entry->itemid;
+		stat->hits = entry->prefixes->hits;
+		stat->misses = entry->prefixes->misses;
+		zbx_vector_pp_prefix_stats_ptr_append(&prefixes, stat);
+	}
+
+	if (limit > prefixes.values_num)
+		limit = prefixes.values_num;
+
+	zbx_vector_pp_prefix_stats_ptr_sort(&prefixes, preprocessor_compare_prefix_stats);
+
+	data_len = zbx_preprocessor_pack_top_prefixes_result(&data, &prefixes, limit);
+
+	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_TOP_PREFIXES_RESULT, data, data_len);
+
+	zbx_free(data);
+	zbx_vector_pp_prefix_stats_ptr_clear_ext(&prefixes, (zbx_pp_prefix_stats_ptr_free_func_t)zbx_ptr_free);
+	zbx_vector_pp_prefix_stats_ptr_destroy(&prefixes);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: respond to worker usage statistics request                        *
@@ -1156,11 +1344,12 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 {
 #define PP_MANAGER_DELAY_SEC	0
 #define PP_MANAGER_DELAY_NS	5e8
+#define PP_MANAGER_RECV_MAX	64	/* maximum number of messages received from a client at once */
 
 	zbx_ipc_service_t			service;
 	char					*error = NULL;
 	zbx_ipc_client_t			*client;
-	zbx_ipc_message_t			*message;
+	zbx_vector_ipcmsg_t			messages;
 	double					time_stat, time_idle = 0, time_flush, time_vps_update;
 	zbx_timespec_t				timeout = {PP_MANAGER_DELAY_SEC, PP_MANAGER_DELAY_NS};
 	const zbx_thread_info_t			*info = &((zbx_thread_args_t *)args)->info;
@@ -1207,6 +1396,8 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 			pp_args->config_timeout, ZBX_IPC_SERVICE_PREPROCESSING);
 
 	zbx_vector_pp_task_ptr_create(&tasks);
+	zbx_vector_ipcmsg_create(&messages);
+	zbx_vector_ipcmsg_reserve(&messages, PP_MANAGER_RECV_MAX);
 
 	/* initialize statistics */
 	time_stat = zbx_time();
@@ -1234,7 +1425,7 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 
-		int	ret = zbx_ipc_service_recv(&service, &timeout, &client, &message);
+		int	ret = zbx_ipc_service_recv_batch(&service, &timeout, &client, &messages, PP_MANAGER_RECV_MAX);
 
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
 
@@ -1245,8 +1436,10 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 		if (ZBX_IPC_RECV_IMMEDIATE != ret)
 			time_idle += sec - time_now;
 
-		if (NULL != message)
+		for (int i = 0; i < messages.values_num; i++)
 		{
+			zbx_ipc_message_t	*message = messages.values[i];
+
 			switch (message->code)
 			{
 				case ZBX_IPC_PREPROCESSOR_REQUEST:
@@ -1264,6 +1457,9 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 				case ZBX_IPC_PREPROCESSOR_TOP_SEQUENCES:
 					preprocessor_reply_top_sequences(manager, client, message);
 					break;
+				case ZBX_IPC_PREPROCESSOR_TOP_PREFIXES:
+					preprocessor_reply_top_prefixes(manager, client, message);
+					break;
 				case ZBX_IPC_PREPROCESSOR_USAGE_STATS:
 					preprocessor_reply_usage_stats(manager, pp_args->workers_num, client);
 					break;
@@ -1277,10 +1473,10 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 					zabbix_log(LOG_LEVEL_DEBUG, "shutdown message received, terminating...");
 					goto out;
 			}
-
-			zbx_ipc_message_free(message);
 		}
 
+		zbx_vector_ipcmsg_clear_ext(&messages, zbx_ipc_message_free);
+
 		if (NULL != client)
 			zbx_ipc_client_release(client);
 
@@ -1321,6 +1517,8 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 out:
 	zbx_setproctitle("%s #%d [terminating]", get_process_type_string(process_type), process_num);
 
+	zbx_vector_ipcmsg_clear_ext(&messages, zbx_ipc_message_free);
+	zbx_vector_ipcmsg_destroy(&messages);
 	zbx_vector_pp_task_ptr_destroy(&tasks);
 	zbx_pp_manager_free(manager);
 
@@ -1330,4 +1528,5 @@ out:
 #undef STAT_INTERVAL
 #undef PP_MANAGER_DELAY_SEC
 #undef PP_MANAGER_DELAY_NS
+#undef PP_MANAGER_RECV_MAX
 }
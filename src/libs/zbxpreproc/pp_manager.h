@@ -33,9 +33,12 @@ struct zbx_pp_manager
 	int				workers_num;
 	int				program_type;
 
-	zbx_hashset_t			items;
+	zbx_flathashset_t		items;
 	zbx_uint64_t			revision;
 
+	/* shared step prefixes of master item dependents */
+	zbx_hashset_t			prefixes;
+
 	zbx_pp_queue_t			queue;
 
 	zbx_timekeeper_t		*timekeeper;
@@ -29,13 +29,21 @@
 #define PACKED_FIELD_RAW	0
 #define PACKED_FIELD_STRING	1
 
+/* size of shared memory ring used to send values to preprocessing manager, */
+/* fits several value batches of typical size                               */
+#define PP_SHM_RING_SIZE	ZBX_MEBIBYTE
+
 #define PACKED_FIELD(value, size)	\
 		(zbx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)}
 
-static zbx_ipc_message_t	cached_message;
-static int			cached_values;
+/* full value batches are kept until flush and sent to preprocessing manager with a single write */
+#define PP_CACHED_BATCHES_MAX		16
+#define PP_CACHED_BATCHES_SIZE_MAX	ZBX_MEBIBYTE
 
-ZBX_PTR_VECTOR_IMPL(ipcmsg, zbx_ipc_message_t *)
+static zbx_pp_value_writer_t	cached_writer;
+static zbx_ipc_message_t	cached_batches[PP_CACHED_BATCHES_MAX];
+static int			cached_batches_num;
+static zbx_uint64_t		cached_batches_size;
 
 static zbx_uint32_t	fields_calc_size(zbx_packed_field_t *fields, int fields_num)
 {
@@ -127,67 +135,6 @@ static zbx_uint32_t	message_pack_data(zbx_ipc_message_t *message, zbx_packed_fie
 	return data_size;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: pack item value data into a single buffer that can be used in IPC *
- *                                                                            *
- * Parameters: message - [OUT] IPC message                                    *
- *             value   - [IN] value to be packed                              *
- *                                                                            *
- * Return value: size of packed data                                          *
- *                                                                            *
- ******************************************************************************/
-static zbx_uint32_t	preprocessor_pack_value(zbx_ipc_message_t *message, zbx_preproc_item_value_t *value)
-{
-	zbx_packed_field_t	fields[24], *offset = fields;	/* 24 - max field count */
-	unsigned char		ts_marker, result_marker, log_marker;
-
-	ts_marker = (NULL != value->ts);
-	result_marker = (NULL != value->result);
-
-	*offset++ = PACKED_FIELD(&value->itemid, sizeof(zbx_uint64_t));
-	*offset++ = PACKED_FIELD(&value->hostid, sizeof(zbx_uint64_t));
-	*offset++ = PACKED_FIELD(&value->item_value_type, sizeof(unsigned char));
-	*offset++ = PACKED_FIELD(&value->item_flags, sizeof(unsigned char));
-	*offset++ = PACKED_FIELD(&value->state, sizeof(unsigned char));
-	*offset++ = PACKED_FIELD(value->error, 0);
-	*offset++ = PACKED_FIELD(&ts_marker, sizeof(unsigned char));
-
-	if (NULL != value->ts)
-	{
-		*offset++ = PACKED_FIELD(&value->ts->sec, sizeof(int));
-		*offset++ = PACKED_FIELD(&value->ts->ns, sizeof(int));
-	}
-
-	*offset++ = PACKED_FIELD(&result_marker, sizeof(unsigned char));
-
-	if (NULL != value->result)
-	{
-
-		*offset++ = PACKED_FIELD(&value->result->lastlogsize, sizeof(zbx_uint64_t));
-		*offset++ = PACKED_FIELD(&value->result->ui64, sizeof(zbx_uint64_t));
-		*offset++ = PACKED_FIELD(&value->result->dbl, sizeof(double));
-		*offset++ = PACKED_FIELD(value->result->str, 0);
-		*offset++ = PACKED_FIELD(value->result->text, 0);
-		*offset++ = PACKED_FIELD(value->result->msg, 0);
-		*offset++ = PACKED_FIELD(&value->result->type, sizeof(int));
-		*offset++ = PACKED_FIELD(&value->result->mtime, sizeof(int));
-
-		log_marker = (NULL != value->result->log);
-		*offset++ = PACKED_FIELD(&log_marker, sizeof(unsigned char));
-		if (NULL != value->result->log)
-		{
-			*offset++ = PACKED_FIELD(value->result->log->value, 0);
-			*offset++ = PACKED_FIELD(value->result->log->source, 0);
-			*offset++ = PACKED_FIELD(&value->result->log->timestamp, sizeof(int));
-			*offset++ = PACKED_FIELD(&value->result->log->severity, sizeof(int));
-			*offset++ = PACKED_FIELD(&value->result->log->logeventid, sizeof(int));
-		}
-	}
-
-	return message_pack_data(message, fields, (int)(offset - fields));
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: packs variant value for serialization                             *
@@ -482,10 +429,13 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
  *                               preprocessed                                 *
  *             finished_num  - [IN] number of values being preprocessed       *
  *             sequences_num - [IN] number of registered task sequences       *
+ *             steals_num    - [IN] number of task steals between workers     *
+ *             lock_wait     - [IN] time spent waiting for task queue locks   *
  *                                                                            *
  ******************************************************************************/
 zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t preproc_num,
-		zbx_uint64_t pending_num, zbx_uint64_t finished_num, zbx_uint64_t sequences_num)
+		zbx_uint64_t pending_num, zbx_uint64_t finished_num, zbx_uint64_t sequences_num,
+		zbx_uint64_t steals_num, double lock_wait)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0;
@@ -494,6 +444,8 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t
 	zbx_serialize_prepare_value(data_len, pending_num);
 	zbx_serialize_prepare_value(data_len, finished_num);
 	zbx_serialize_prepare_value(data_len, sequences_num);
+	zbx_serialize_prepare_value(data_len, steals_num);
+	zbx_serialize_prepare_value(data_len, lock_wait);
 
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
@@ -501,7 +453,9 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t
 	ptr += zbx_serialize_value(ptr, preproc_num);
 	ptr += zbx_serialize_value(ptr, pending_num);
 	ptr += zbx_serialize_value(ptr, finished_num);
-	(void)zbx_serialize_value(ptr, sequences_num);
+	ptr += zbx_serialize_value(ptr, sequences_num);
+	ptr += zbx_serialize_value(ptr, steals_num);
+	(void)zbx_serialize_value(ptr, lock_wait);
 
 	return data_len;
 }
@@ -593,72 +547,42 @@ zbx_uint32_t	zbx_preprocessor_pack_top_sequences_result(unsigned char **data,
 
 /******************************************************************************
  *                                                                            *
- * Purpose: unpack item value data from IPC data buffer                       *
- *                                                                            *
- * Parameters: value - [OUT] unpacked item value                              *
- *             data  - [IN]  IPC data buffer                                  *
+ * Purpose: pack top prefix cache statistics into a single buffer that can be *
+ *          used in IPC                                                       *
  *                                                                            *
- * Return value: size of packed data                                          *
+ * Parameters: data         - [OUT] memory buffer for packed data             *
+ *             prefixes     - [IN] prefix cache statistics of master items    *
+ *             prefixes_num - [IN] number of statistics to pack               *
  *                                                                            *
  ******************************************************************************/
-zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data)
+zbx_uint32_t	zbx_preprocessor_pack_top_prefixes_result(unsigned char **data,
+		zbx_vector_pp_prefix_stats_ptr_t *prefixes, int prefixes_num)
 {
-	zbx_uint32_t	value_len;
-	zbx_timespec_t	*timespec = NULL;
-	AGENT_RESULT	*agent_result = NULL;
-	zbx_log_t	*log = NULL;
-	unsigned char	*offset = data, ts_marker, result_marker, log_marker;
-
-	offset += zbx_deserialize_uint64(offset, &value->itemid);
-	offset += zbx_deserialize_uint64(offset, &value->hostid);
-	offset += zbx_deserialize_char(offset, &value->item_value_type);
-	offset += zbx_deserialize_char(offset, &value->item_flags);
-	offset += zbx_deserialize_char(offset, &value->state);
-	offset += zbx_deserialize_str(offset, &value->error, value_len);
-	offset += zbx_deserialize_char(offset, &ts_marker);
-
-	if (0 != ts_marker)
-	{
-		timespec = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, prefix_len = 0;
 
-		offset += zbx_deserialize_int(offset, &timespec->sec);
-		offset += zbx_deserialize_int(offset, &timespec->ns);
+	if (0 != prefixes_num)
+	{
+		zbx_serialize_prepare_value(prefix_len, prefixes->values[0]->itemid);
+		zbx_serialize_prepare_value(prefix_len, prefixes->values[0]->hits);
+		zbx_serialize_prepare_value(prefix_len, prefixes->values[0]->misses);
 	}
 
-	value->ts = timespec;
-
-	offset += zbx_deserialize_char(offset, &result_marker);
-	if (0 != result_marker)
-	{
-		agent_result = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT));
-
-		offset += zbx_deserialize_uint64(offset, &agent_result->lastlogsize);
-		offset += zbx_deserialize_uint64(offset, &agent_result->ui64);
-		offset += zbx_deserialize_double(offset, &agent_result->dbl);
-		offset += zbx_deserialize_str(offset, &agent_result->str, value_len);
-		offset += zbx_deserialize_str(offset, &agent_result->text, value_len);
-		offset += zbx_deserialize_str(offset, &agent_result->msg, value_len);
-		offset += zbx_deserialize_int(offset, &agent_result->type);
-		offset += zbx_deserialize_int(offset, &agent_result->mtime);
-
-		offset += zbx_deserialize_char(offset, &log_marker);
-		if (0 != log_marker)
-		{
-			log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+	zbx_serialize_prepare_value(data_len, prefixes_num);
+	data_len += prefix_len * (zbx_uint32_t)prefixes_num;
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
-			offset += zbx_deserialize_str(offset, &log->value, value_len);
-			offset += zbx_deserialize_str(offset, &log->source, value_len);
-			offset += zbx_deserialize_int(offset, &log->timestamp);
-			offset += zbx_deserialize_int(offset, &log->severity);
-			offset += zbx_deserialize_int(offset, &log->logeventid);
-		}
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, prefixes_num);
 
-		agent_result->log = log;
+	for (int i = 0; i < prefixes_num; i++)
+	{
+		ptr += zbx_serialize_value(ptr, prefixes->values[i]->itemid);
+		ptr += zbx_serialize_value(ptr, prefixes->values[i]->hits);
+		ptr += zbx_serialize_value(ptr, prefixes->values[i]->misses);
 	}
 
-	value->result = agent_result;
-
-	return (zbx_uint32_t)(offset - data);
+	return data_len;
 }
 
 /******************************************************************************
@@ -704,18 +628,23 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_pp_result_ptr_t *results, zb
  *                               preprocessed                                 *
  *             finished_num  - [OUT] number of values being preprocessed      *
  *             sequences_num - [OUT] number of registered task sequences      *
+ *             steals_num    - [OUT] number of task steals between workers    *
+ *             lock_wait     - [OUT] time spent waiting for task queue locks  *
  *             data          - [OUT] data buffer                              *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_unpack_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, const unsigned char *data)
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_uint64_t *steals_num, double *lock_wait,
+		const unsigned char *data)
 {
 	const unsigned char	*offset = data;
 
 	offset += zbx_deserialize_value(offset, preproc_num);
 	offset += zbx_deserialize_value(offset, pending_num);
 	offset += zbx_deserialize_value(offset, finished_num);
-	(void)zbx_deserialize_value(offset, sequences_num);
+	offset += zbx_deserialize_value(offset, sequences_num);
+	offset += zbx_deserialize_value(offset, steals_num);
+	(void)zbx_deserialize_value(offset, lock_wait);
 }
 
 /******************************************************************************
@@ -790,6 +719,38 @@ void	zbx_preprocessor_unpack_top_sequences_result(zbx_vector_pp_sequence_stats_p
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unpack top prefix cache statistics from IPC data buffer           *
+ *                                                                            *
+ * Parameters: prefixes - [OUT] prefix cache statistics of master items       *
+ *             data     - [IN] memory buffer for packed data                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_unpack_top_prefixes_result(zbx_vector_pp_prefix_stats_ptr_t *prefixes,
+		const unsigned char *data)
+{
+	int	prefixes_num;
+
+	data += zbx_deserialize_value(data, &prefixes_num);
+
+	if (0 != prefixes_num)
+	{
+		zbx_vector_pp_prefix_stats_ptr_reserve(prefixes, (size_t)prefixes_num);
+
+		for (int i = 0; i < prefixes_num; i++)
+		{
+			zbx_pp_prefix_stats_t	*stat;
+
+			stat = (zbx_pp_prefix_stats_t *)zbx_malloc(NULL, sizeof(zbx_pp_prefix_stats_t));
+			data += zbx_deserialize_value(data, &stat->itemid);
+			data += zbx_deserialize_value(data, &stat->hits);
+			data += zbx_deserialize_value(data, &stat->misses);
+			zbx_vector_pp_prefix_stats_ptr_append(prefixes, stat);
+		}
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: sends command to preprocessor manager                             *
@@ -801,33 +762,88 @@ void	zbx_preprocessor_unpack_top_sequences_result(zbx_vector_pp_sequence_stats_p
  *                              not requested)                                *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
-		zbx_ipc_message_t *response)
+static zbx_ipc_socket_t	*preprocessor_get_socket(void)
 {
 	char			*error = NULL;
 	static zbx_ipc_socket_t	socket = {0};
 
 	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+	if (0 == socket.fd && FAIL == zbx_ipc_socket_open_ext(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
+			PP_SHM_RING_SIZE, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		exit(EXIT_FAILURE);
 	}
 
-	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
+	return &socket;
+}
+
+static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
+		zbx_ipc_message_t *response)
+{
+	zbx_ipc_socket_t	*socket;
+
+	socket = preprocessor_get_socket();
+
+	if (FAIL == zbx_ipc_socket_write(socket, code, data, size))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 
-	if (NULL != response && FAIL == zbx_ipc_socket_read(&socket, response))
+	if (NULL != response && FAIL == zbx_ipc_socket_read(socket, response))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot receive data from preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends multiple messages to preprocessor manager                   *
+ *                                                                            *
+ * Parameters: messages     - [IN] messages to send                           *
+ *             messages_num - [IN] number of messages                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_send_batch(zbx_ipc_message_t *messages, int messages_num)
+{
+	zbx_vector_ipcmsg_t	batch;
+
+	zbx_vector_ipcmsg_create(&batch);
+	zbx_vector_ipcmsg_reserve(&batch, (size_t)messages_num);
+
+	for (int i = 0; i < messages_num; i++)
+		zbx_vector_ipcmsg_append(&batch, &messages[i]);
+
+	if (FAIL == zbx_ipc_socket_write_batch(preprocessor_get_socket(), &batch))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_vector_ipcmsg_destroy(&batch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves full value batch to batches waiting to be sent              *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_cache_batch(void)
+{
+	if (PP_CACHED_BATCHES_MAX - 1 <= cached_batches_num ||
+			PP_CACHED_BATCHES_SIZE_MAX <= cached_batches_size + cached_writer.size)
+	{
+		zbx_preprocessor_flush();
+		return;
+	}
+
+	cached_batches[cached_batches_num].code = ZBX_IPC_PREPROCESSOR_REQUEST;
+	zbx_pp_value_writer_detach(&cached_writer, &cached_batches[cached_batches_num]);
+	cached_batches_size += cached_batches[cached_batches_num++].size;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: perform item value preprocessing and dependent item processing    *
@@ -885,14 +901,14 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
 		}
 	}
 
-	if (0 == preprocessor_pack_value(&cached_message, &value))
+	if (SUCCEED != zbx_pp_value_writer_add(&cached_writer, &value))
 	{
-		zbx_preprocessor_flush();
-		preprocessor_pack_value(&cached_message, &value);
+		preprocessor_cache_batch();
+		(void)zbx_pp_value_writer_add(&cached_writer, &value);
 	}
 
-	if (ZBX_PREPROCESSING_BATCH_SIZE < ++cached_values)
-		zbx_preprocessor_flush();
+	if (ZBX_PREPROCESSING_BATCH_SIZE < cached_writer.values_num)
+		preprocessor_cache_batch();
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -904,14 +920,27 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
  ******************************************************************************/
 void	zbx_preprocessor_flush(void)
 {
-	if (0 < cached_message.size)
+	if (0 < cached_writer.size)
 	{
-		preprocessor_send(ZBX_IPC_PREPROCESSOR_REQUEST, cached_message.data, cached_message.size, NULL);
+		cached_batches[cached_batches_num].code = ZBX_IPC_PREPROCESSOR_REQUEST;
+		zbx_pp_value_writer_detach(&cached_writer, &cached_batches[cached_batches_num++]);
+	}
 
-		zbx_ipc_message_clean(&cached_message);
-		zbx_ipc_message_init(&cached_message);
-		cached_values = 0;
+	if (0 == cached_batches_num)
+		return;
+
+	if (1 == cached_batches_num)
+	{
+		preprocessor_send(ZBX_IPC_PREPROCESSOR_REQUEST, cached_batches[0].data, cached_batches[0].size, NULL);
 	}
+	else
+		preprocessor_send_batch(cached_batches, cached_batches_num);
+
+	for (int i = 0; i < cached_batches_num; i++)
+		zbx_ipc_message_clean(&cached_batches[i]);
+
+	cached_batches_num = 0;
+	cached_batches_size = 0;
 }
 
 /******************************************************************************
@@ -1061,7 +1090,8 @@ out:
  *                                                                            *
  ******************************************************************************/
 int	zbx_preprocessor_get_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, char **error)
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_uint64_t *steals_num, double *lock_wait,
+		char **error)
 {
 	unsigned char	*result;
 
@@ -1071,7 +1101,8 @@ int	zbx_preprocessor_get_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pen
 		return FAIL;
 	}
 
-	zbx_preprocessor_unpack_diag_stats(preproc_num, pending_num, finished_num, sequences_num, result);
+	zbx_preprocessor_unpack_diag_stats(preproc_num, pending_num, finished_num, sequences_num, steals_num,
+			lock_wait, result);
 	zbx_free(result);
 
 	return SUCCEED;
@@ -1115,6 +1146,34 @@ int	zbx_preprocessor_get_top_sequences(int limit, zbx_vector_pp_sequence_stats_p
 	return preprocessor_get_top_view(limit, sequences, error, ZBX_IPC_PREPROCESSOR_TOP_SEQUENCES);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the top N master items by the number of shared step prefix    *
+ *          cache lookups                                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_top_prefixes(int limit, zbx_vector_pp_prefix_stats_ptr_t *prefixes, char **error)
+{
+	int		ret;
+	unsigned char	*data, *result;
+	zbx_uint32_t	data_len;
+
+	data_len = zbx_preprocessor_pack_top_sequences_request(&data, limit);
+
+	if (SUCCEED != (ret = zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_TOP_PREFIXES,
+			SEC_PER_MIN, data, data_len, &result, error)))
+	{
+		goto out;
+	}
+
+	zbx_preprocessor_unpack_top_prefixes_result(prefixes, result);
+	zbx_free(result);
+out:
+	zbx_free(data);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get preprocessing manager diagnostic statistics                   *
@@ -37,6 +37,8 @@
 #define ZBX_IPC_PREPROCESSOR_TOP_SEQUENCES		10007
 #define ZBX_IPC_PREPROCESSOR_TOP_SEQUENCES_RESULT	10008
 #define ZBX_IPC_PREPROCESSOR_USAGE_STATS		10009
+#define ZBX_IPC_PREPROCESSOR_TOP_PREFIXES		10010
+#define ZBX_IPC_PREPROCESSOR_TOP_PREFIXES_RESULT	10011
 
 /* item value data used in preprocessing manager */
 typedef struct
@@ -52,8 +54,6 @@ typedef struct
 }
 zbx_preproc_item_value_t;
 
-ZBX_PTR_VECTOR_DECL(ipcmsg, zbx_ipc_message_t *)
-
 /* packed field data description */
 typedef struct
 {
@@ -63,7 +63,58 @@ typedef struct
 }
 zbx_packed_field_t;
 
-zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data);
+/* number of string table slots used to find repeated strings when packing values */
+#define ZBX_PP_STRING_SLOTS	256
+
+typedef struct
+{
+	zbx_uint32_t	offset;		/* offset of string data in the packed batch, 0 for unused slot */
+	zbx_uint32_t	len;
+	zbx_uint32_t	index;		/* string table index */
+}
+zbx_pp_string_slot_t;
+
+/* single pass item value batch packer */
+typedef struct
+{
+	unsigned char		*data;
+	zbx_uint32_t		size;
+	zbx_uint32_t		alloc;
+	zbx_uint32_t		values_num;
+	zbx_uint32_t		strings_num;
+	zbx_pp_string_slot_t	strings[ZBX_PP_STRING_SLOTS];
+}
+zbx_pp_value_writer_t;
+
+typedef struct
+{
+	const unsigned char	*str;
+	zbx_uint32_t		len;
+}
+zbx_pp_string_ref_t;
+
+/* item value batch unpacker, timestamp and agent result of unpacked value point to */
+/* reader storage that is reused by the next value                                 */
+typedef struct
+{
+	const unsigned char	*data;
+	zbx_uint32_t		values_num;
+	zbx_uint32_t		values_left;
+	zbx_pp_string_ref_t	*strings;
+	zbx_uint32_t		strings_num;
+	zbx_uint32_t		strings_alloc;
+	zbx_timespec_t		ts;
+	AGENT_RESULT		result;
+}
+zbx_pp_value_reader_t;
+
+int	zbx_pp_value_writer_add(zbx_pp_value_writer_t *writer, const zbx_preproc_item_value_t *value);
+void	zbx_pp_value_writer_detach(zbx_pp_value_writer_t *writer, zbx_ipc_message_t *message);
+void	zbx_pp_value_writer_clear(zbx_pp_value_writer_t *writer);
+
+int	zbx_pp_value_reader_init(zbx_pp_value_reader_t *reader, const unsigned char *data, zbx_uint32_t size);
+int	zbx_pp_value_reader_next(zbx_pp_value_reader_t *reader, zbx_preproc_item_value_t *value);
+void	zbx_pp_value_reader_clear(zbx_pp_value_reader_t *reader);
 
 void	zbx_preprocessor_unpack_test_request(zbx_pp_item_preproc_t *preproc, zbx_variant_t *value, zbx_timespec_t *ts,
 		const unsigned char *data);
@@ -75,10 +126,12 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_pp_result_ptr_t *results, zb
 		const unsigned char *data);
 
 zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t preproc_num,
-		zbx_uint64_t pending_num, zbx_uint64_t finished_num, zbx_uint64_t sequences_num);
+		zbx_uint64_t pending_num, zbx_uint64_t finished_num, zbx_uint64_t sequences_num,
+		zbx_uint64_t steals_num, double lock_wait);
 
 void	zbx_preprocessor_unpack_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, const unsigned char *data);
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_uint64_t *steals_num, double *lock_wait,
+		const unsigned char *data);
 
 zbx_uint32_t	zbx_preprocessor_pack_top_sequences_request(unsigned char **data, int limit);
 
@@ -90,6 +143,12 @@ zbx_uint32_t	zbx_preprocessor_pack_top_sequences_result(unsigned char **data,
 void	zbx_preprocessor_unpack_top_sequences_result(zbx_vector_pp_sequence_stats_ptr_t *sequences,
 		const unsigned char *data);
 
+zbx_uint32_t	zbx_preprocessor_pack_top_prefixes_result(unsigned char **data,
+		zbx_vector_pp_prefix_stats_ptr_t *prefixes, int prefixes_num);
+
+void	zbx_preprocessor_unpack_top_prefixes_result(zbx_vector_pp_prefix_stats_ptr_t *prefixes,
+		const unsigned char *data);
+
 zbx_uint32_t	zbx_preprocessor_pack_usage_stats(unsigned char **data, const zbx_vector_dbl_t *usage, int count);
 
 #endif
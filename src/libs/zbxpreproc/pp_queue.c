@@ -21,13 +21,37 @@
 #include "pp_task.h"
 #include "zbxcommon.h"
 #include "zbxalgo.h"
+#include "zbxtime.h"
+#include "zbxatomic.h"
+
+/*
+ * Tasks are distributed between per worker queues in round-robin order. Workers pop tasks from
+ * their own queues and when those are empty steal half of immediate (or pending if there are no
+ * immediate) tasks from other worker queues. Finished tasks are pushed into per worker finished
+ * lists, so workers take only their own queue lock while processing tasks and the main queue lock
+ * is used by manager to protect task sequences and to wake up idle workers.
+ *
+ * Per item ordering is ensured by adding serial tasks to item task sequences when tasks are
+ * pushed, so only one task of the item is queued at any time.
+ */
 
 #define PP_TASK_QUEUE_INIT_NONE		0x00
 #define PP_TASK_QUEUE_INIT_LOCK		0x01
 #define PP_TASK_QUEUE_INIT_EVENT	0x02
 
+#define PP_TASK_QUEUE_STEAL_MAX		64
+
 ZBX_PTR_VECTOR_IMPL(pp_sequence_stats_ptr, zbx_pp_sequence_stats_t *)
 
+/* worker queue task counter is updated within worker queue lock and read without it */
+#if defined(HAVE_ATOMIC_BUILTINS)
+#	define PP_DEQUE_QUEUED_UPDATE(deque)	\
+		ZBX_ATOMIC_STORE_RELEASE(&(deque)->queued_num, (deque)->immediate_num + (deque)->pending_num)
+#	define PP_DEQUE_QUEUED_NUM(deque)	ZBX_ATOMIC_LOAD_ACQUIRE(&(deque)->queued_num)
+#else
+#	define PP_DEQUE_QUEUED_UPDATE(deque)	((deque)->queued_num = (deque)->immediate_num + (deque)->pending_num)
+#endif
+
 /* task sequence registry by itemid */
 typedef struct
 {
@@ -47,7 +71,7 @@ zbx_pp_item_task_sequence_t;
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error)
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int deques_num, char **error)
 {
 	int	err, ret = FAIL;
 
@@ -55,12 +79,36 @@ int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error)
 	queue->pending_num = 0;
 	queue->finished_num = 0;
 	queue->processing_num = 0;
-	zbx_list_create(&queue->pending);
-	zbx_list_create(&queue->immediate);
-	zbx_list_create(&queue->finished);
+	queue->steals_num = 0;
+	queue->lock_wait = 0;
+	queue->pushed_num = 0;
+	queue->collected_num = 0;
+	queue->queue_lock_wait = 0;
+	queue->push_next = 0;
+	queue->finished_next = 0;
 
 	zbx_hashset_create(&queue->sequences, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
+	queue->deques_num = deques_num;
+	queue->deques_init_num = 0;
+	queue->deques = (zbx_pp_deque_t *)zbx_calloc(NULL, (size_t)deques_num, sizeof(zbx_pp_deque_t));
+
+	for (int i = 0; i < deques_num; i++)
+	{
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+		if (0 != (err = pthread_mutex_init(&deque->lock, NULL)))
+		{
+			*error = zbx_dsprintf(NULL, "cannot initialize task queue mutex: %s", zbx_strerror(err));
+			goto out;
+		}
+
+		zbx_list_create(&deque->immediate);
+		zbx_list_create(&deque->pending);
+		zbx_list_create(&deque->finished);
+		queue->deques_init_num++;
+	}
+
 	if (0 != (err = pthread_mutex_init(&queue->lock, NULL)))
 	{
 		*error = zbx_dsprintf(NULL, "cannot initialize task queue mutex: %s", zbx_strerror(err));
@@ -109,20 +157,54 @@ void	pp_task_queue_destroy(zbx_pp_queue_t *queue)
 	if (0 != (queue->init_flags & PP_TASK_QUEUE_INIT_EVENT))
 		pthread_cond_destroy(&queue->event);
 
-	pp_task_queue_clear_tasks(&queue->pending);
-	zbx_list_destroy(&queue->pending);
+	for (int i = 0; i < queue->deques_init_num; i++)
+	{
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+		pp_task_queue_clear_tasks(&deque->pending);
+		zbx_list_destroy(&deque->pending);
+
+		pp_task_queue_clear_tasks(&deque->immediate);
+		zbx_list_destroy(&deque->immediate);
 
-	pp_task_queue_clear_tasks(&queue->immediate);
-	zbx_list_destroy(&queue->immediate);
+		pp_task_queue_clear_tasks(&deque->finished);
+		zbx_list_destroy(&deque->finished);
 
-	pp_task_queue_clear_tasks(&queue->finished);
-	zbx_list_destroy(&queue->finished);
+		pthread_mutex_destroy(&deque->lock);
+	}
+
+	zbx_free(queue->deques);
+	queue->deques_num = 0;
+	queue->deques_init_num = 0;
 
 	zbx_hashset_destroy(&queue->sequences);
 
 	queue->init_flags = PP_TASK_QUEUE_INIT_NONE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock mutex, measuring time spent waiting for it                   *
+ *                                                                            *
+ * Parameters: lock - [IN] mutex to lock                                      *
+ *             wait - [OUT] total lock wait time                              *
+ *                                                                            *
+ * Comments: Time is measured only when the mutex is already locked, so       *
+ *           uncontended locking does not have clock overhead.                *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_mutex_lock(pthread_mutex_t *lock, double *wait)
+{
+	double	time_start;
+
+	if (0 == pthread_mutex_trylock(lock))
+		return;
+
+	time_start = zbx_time();
+	pthread_mutex_lock(lock);
+	*wait += zbx_time() - time_start;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: lock task queue                                                   *
@@ -130,7 +212,10 @@ void	pp_task_queue_destroy(zbx_pp_queue_t *queue)
  ******************************************************************************/
 void	pp_task_queue_lock(zbx_pp_queue_t *queue)
 {
-	pthread_mutex_lock(&queue->lock);
+	double	wait = 0;
+
+	pp_mutex_lock(&queue->lock, &wait);
+	queue->queue_lock_wait += wait;
 }
 
 /******************************************************************************
@@ -163,6 +248,43 @@ void	pp_task_queue_deregister_worker(zbx_pp_queue_t *queue)
 	queue->workers_num--;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: push task into the next worker queue                              *
+ *                                                                            *
+ * Parameters: queue     - [IN] task queue                                    *
+ *             task      - [IN] task to push                                  *
+ *             immediate - [IN] 1 - push task into immediate list             *
+ *                              0 - push task into pending list               *
+ *                                                                            *
+ * Comments: This function is called by manager within task queue lock.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_queue_push_deque(zbx_pp_queue_t *queue, zbx_pp_task_t *task, int immediate)
+{
+	zbx_pp_deque_t	*deque = &queue->deques[queue->push_next];
+
+	if (++queue->push_next == queue->deques_num)
+		queue->push_next = 0;
+
+	pp_mutex_lock(&deque->lock, &queue->queue_lock_wait);
+
+	if (0 != immediate)
+	{
+		(void)zbx_list_append(&deque->immediate, task, NULL);
+		deque->immediate_num++;
+	}
+	else
+	{
+		(void)zbx_list_append(&deque->pending, task, NULL);
+		deque->pending_num++;
+	}
+
+	PP_DEQUE_QUEUED_UPDATE(deque);
+
+	pthread_mutex_unlock(&deque->lock);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add task to an existing sequence or create/append to a new one    *
@@ -213,20 +335,20 @@ void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 	{
 		case ZBX_PP_TASK_VALUE_SEQ:
 		case ZBX_PP_TASK_DEPENDENT:
-			queue->pending_num++;
+			queue->pushed_num++;
 			if (NULL == (task = pp_task_queue_add_sequence(queue, task)))
 				return;
 			break;
 		case ZBX_PP_TASK_SEQUENCE:
 			/* sequence task is just a container for other tasks - it does not affect statistics, */
-			/* so there is no need to increment queue->pending_num                                */
+			/* so there is no need to increment queue->pushed_num                                 */
 			break;
 		default:
-			queue->pending_num++;
+			queue->pushed_num++;
 			break;
 	}
 
-	(void)zbx_list_append(&queue->immediate, task, NULL);
+	pp_task_queue_push_deque(queue, task, 1);
 }
 
 /******************************************************************************
@@ -252,8 +374,8 @@ void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid)
  ******************************************************************************/
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
-	queue->pending_num++;
-	(void)zbx_list_append(&queue->immediate, task, NULL);
+	queue->pushed_num++;
+	pp_task_queue_push_deque(queue, task, 1);
 }
 
 /******************************************************************************
@@ -264,79 +386,198 @@ void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
  *             task  - [IN] task                                              *
  *                                                                            *
  * Comments: This function is used to push tasks created by new preprocessing *
- *           or testing requests.                                             *
+ *           or testing requests. Serial tasks are added to item task         *
+ *           sequences, so that per item ordering is kept regardless of which *
+ *           worker pops or steals the task.                                  *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
 	zbx_pp_task_value_t	*d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
-	queue->pending_num++;
+	int			immediate;
 
-	if (ITEM_TYPE_INTERNAL != d->preproc->type)
-	{
-		(void)zbx_list_append(&queue->pending, task, NULL);
+	queue->pushed_num++;
+
+	immediate = (ITEM_TYPE_INTERNAL == d->preproc->type ? 1 : 0);
+
+	if (ZBX_PP_TASK_VALUE_SEQ == task->type && NULL == (task = pp_task_queue_add_sequence(queue, task)))
 		return;
+
+	pp_task_queue_push_deque(queue, task, immediate);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop task from worker queue                                        *
+ *                                                                            *
+ * Parameters: deque - [IN] worker queue                                      *
+ *                                                                            *
+ * Return value: The popped task or NULL if the worker queue is empty.        *
+ *                                                                            *
+ * Comments: This function is called within worker queue lock.               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_task_t	*pp_task_deque_pop(zbx_pp_deque_t *deque)
+{
+	zbx_pp_task_t	*task;
+
+	if (SUCCEED == zbx_list_pop(&deque->immediate, (void **)&task))
+	{
+		deque->immediate_num--;
+		PP_DEQUE_QUEUED_UPDATE(deque);
+		return task;
 	}
 
-	if (ZBX_PP_TASK_VALUE == task->type)
+	if (SUCCEED == zbx_list_pop(&deque->pending, (void **)&task))
 	{
-		(void)zbx_list_append(&queue->immediate, task, NULL);
-		return;
+		deque->pending_num--;
+		PP_DEQUE_QUEUED_UPDATE(deque);
+		return task;
 	}
 
-	zbx_pp_task_t	*seq_task;
+	return NULL;
+}
 
-	if (NULL != (seq_task = pp_task_queue_add_sequence(queue, task)))
-		(void)zbx_list_append(&queue->immediate, seq_task, NULL);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: steal tasks from other worker queues                              *
+ *                                                                            *
+ * Parameters: queue     - [IN] task queue                                    *
+ *             index     - [IN] index of the stealing worker queue            *
+ *             tasks     - [OUT] stolen tasks                                 *
+ *             immediate - [OUT] 1 - immediate tasks were stolen              *
+ *                               0 - pending tasks were stolen                *
+ *             wait      - [OUT] lock wait time                               *
+ *                                                                            *
+ * Return value: The number of stolen tasks.                                  *
+ *                                                                            *
+ * Comments: Half of the immediate tasks, or pending tasks if there are no    *
+ *           immediate tasks, are taken from the first non-empty queue. The   *
+ *           victim queue lock is released before the stolen tasks are moved, *
+ *           so worker queue locks are never nested.                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_task_queue_steal(zbx_pp_queue_t *queue, int index, zbx_pp_task_t **tasks, int *immediate,
+		double *wait)
+{
+	for (int i = 1; i < queue->deques_num; i++)
+	{
+		zbx_pp_deque_t	*victim = &queue->deques[(index + i) % queue->deques_num];
+		int		tasks_num = 0, steal_num;
+
+		pp_mutex_lock(&victim->lock, wait);
+
+		if (0 != victim->immediate_num)
+		{
+			steal_num = MIN((victim->immediate_num + 1) / 2, PP_TASK_QUEUE_STEAL_MAX);
+
+			while (tasks_num < steal_num && SUCCEED == zbx_list_pop(&victim->immediate,
+					(void **)&tasks[tasks_num]))
+			{
+				tasks_num++;
+			}
+
+			victim->immediate_num -= tasks_num;
+			*immediate = 1;
+		}
+		else if (0 != victim->pending_num)
+		{
+			steal_num = MIN((victim->pending_num + 1) / 2, PP_TASK_QUEUE_STEAL_MAX);
+
+			while (tasks_num < steal_num && SUCCEED == zbx_list_pop(&victim->pending,
+					(void **)&tasks[tasks_num]))
+			{
+				tasks_num++;
+			}
+
+			victim->pending_num -= tasks_num;
+			*immediate = 0;
+		}
+
+		PP_DEQUE_QUEUED_UPDATE(victim);
+
+		pthread_mutex_unlock(&victim->lock);
+
+		if (0 != tasks_num)
+			return tasks_num;
+	}
+
+	return 0;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: pop task from task queue                                          *
+ * Purpose: pop task for processing                                           *
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
+ *             index - [IN] worker queue index                                *
  *                                                                            *
  * Return value: The popped task or NULL if there are no tasks to be          *
  *               processed.                                                   *
  *                                                                            *
- * Comments: This function is used by workers to pop tasks for processing.    *
- *           Sequence tasks will be moved to existing tasks sequences or      *
- *           returned if there are no registered sequences for this item.     *
+ * Comments: This function is used by workers to pop tasks for processing     *
+ *           and must be called outside task queue lock. Immediate tasks are  *
+ *           popped before pending tasks. When the worker queue is empty the  *
+ *           tasks are stolen from other worker queues - the first stolen     *
+ *           task is returned and the rest are moved to the worker queue.     *
  *                                                                            *
  ******************************************************************************/
-zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
+zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue, int index)
 {
-	zbx_pp_task_t	*task = NULL;
+	zbx_pp_deque_t	*deque = &queue->deques[index];
+	zbx_pp_task_t	*task, *tasks[PP_TASK_QUEUE_STEAL_MAX];
+	double		wait = 0;
+	int		tasks_num, immediate;
+
+	pp_mutex_lock(&deque->lock, &wait);
 
-	if (SUCCEED == zbx_list_pop(&queue->immediate, (void **)&task))
+	if (NULL != (task = pp_task_deque_pop(deque)))
 	{
 		/* while sequence tasks do not affect statistics, the first task in sequence */
 		/* does, so the statistics can be updated for all tasks                      */
-		queue->pending_num--;
-		queue->processing_num++;
+		deque->popped_num++;
+		deque->lock_wait += wait;
+		pthread_mutex_unlock(&deque->lock);
+
+		return task;
+	}
+
+	pthread_mutex_unlock(&deque->lock);
 
-		return (zbx_pp_task_t *)task;
+	if (0 == (tasks_num = pp_task_queue_steal(queue, index, tasks, &immediate, &wait)))
+	{
+		pp_mutex_lock(&deque->lock, &wait);
+		deque->lock_wait += wait;
+		pthread_mutex_unlock(&deque->lock);
+
+		return NULL;
 	}
 
-	while (SUCCEED == zbx_list_pop(&queue->pending, (void **)&task))
+	pp_mutex_lock(&deque->lock, &wait);
+
+	for (int i = 1; i < tasks_num; i++)
 	{
-		if (ZBX_PP_TASK_VALUE_SEQ == task->type)
+		if (0 != immediate)
 		{
-			/* task is being moved from pending to immediate queue */
-			/* while still pending, so statistics are not affected */
-			task = pp_task_queue_add_sequence(queue, task);
+			(void)zbx_list_append(&deque->immediate, tasks[i], NULL);
+			deque->immediate_num++;
 		}
-
-		if (NULL != task)
+		else
 		{
-			queue->pending_num--;
-			queue->processing_num++;
-
-			return task;
+			(void)zbx_list_append(&deque->pending, tasks[i], NULL);
+			deque->pending_num++;
 		}
 	}
 
-	return NULL;
+	PP_DEQUE_QUEUED_UPDATE(deque);
+
+	deque->popped_num++;
+	deque->steals_num++;
+	deque->lock_wait += wait;
+
+	pthread_mutex_unlock(&deque->lock);
+
+	return tasks[0];
 }
 
 /******************************************************************************
@@ -344,14 +585,25 @@ zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
  * Purpose: push finished task into queue                                     *
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
+ *             index - [IN] worker queue index                                *
  *             task  - [IN] task                                              *
  *                                                                            *
+ * Comments: This function is used by workers and must be called outside     *
+ *           task queue lock.                                                 *
+ *                                                                            *
  ******************************************************************************/
-void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
+void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, int index, zbx_pp_task_t *task)
 {
-	queue->finished_num++;
-	queue->processing_num--;
-	(void)zbx_list_append(&queue->finished, task, NULL);
+	zbx_pp_deque_t	*deque = &queue->deques[index];
+	double		wait = 0;
+
+	pp_mutex_lock(&deque->lock, &wait);
+
+	(void)zbx_list_append(&deque->finished, task, NULL);
+	deque->finished_num++;
+	deque->lock_wait += wait;
+
+	pthread_mutex_unlock(&deque->lock);
 }
 
 /******************************************************************************
@@ -362,20 +614,101 @@ void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
  *                                                                            *
  * Return value: The popped task or NULL if there are no finished tasks.      *
  *                                                                            *
+ * Comments: This function is called by manager within task queue lock.       *
+ *                                                                            *
  ******************************************************************************/
 zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
 {
 	zbx_pp_task_t	*task;
 
-	if (SUCCEED == zbx_list_pop(&queue->finished, (void **)&task))
+	for (int i = 0; i < queue->deques_num; i++)
 	{
-		queue->finished_num--;
-		return task;
+		zbx_pp_deque_t	*deque = &queue->deques[queue->finished_next];
+		int		ret;
+
+		pp_mutex_lock(&deque->lock, &queue->queue_lock_wait);
+		ret = zbx_list_pop(&deque->finished, (void **)&task);
+		pthread_mutex_unlock(&deque->lock);
+
+		if (SUCCEED == ret)
+		{
+			queue->collected_num++;
+			return task;
+		}
+
+		if (++queue->finished_next == queue->deques_num)
+			queue->finished_next = 0;
 	}
 
 	return NULL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update queue statistics from worker queue counters                *
+ *                                                                            *
+ * Parameters: queue - [IN] task queue                                        *
+ *                                                                            *
+ * Comments: This function is called by manager within task queue lock.       *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_update_stats(zbx_pp_queue_t *queue)
+{
+	zbx_uint64_t	popped_num = 0, finished_num = 0, steals_num = 0;
+	double		lock_wait = queue->queue_lock_wait;
+
+	for (int i = 0; i < queue->deques_num; i++)
+	{
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+		pthread_mutex_lock(&deque->lock);
+		popped_num += deque->popped_num;
+		finished_num += deque->finished_num;
+		steals_num += deque->steals_num;
+		lock_wait += deque->lock_wait;
+		pthread_mutex_unlock(&deque->lock);
+	}
+
+	queue->pending_num = queue->pushed_num - popped_num;
+	queue->processing_num = popped_num - finished_num;
+	queue->finished_num = finished_num - queue->collected_num;
+	queue->steals_num = steals_num;
+	queue->lock_wait = lock_wait;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get number of tasks queued for processing                         *
+ *                                                                            *
+ * Parameters: queue - [IN] task queue                                        *
+ *                                                                            *
+ * Comments: This function is used by workers within task queue lock before   *
+ *           waiting for notifications. As manager pushes tasks within task   *
+ *           queue lock, notifications cannot be missed.                      *
+ *           Worker queue counters are read without taking worker queue       *
+ *           locks, so idle workers do not contend with busy ones.            *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_task_queue_queued_num(zbx_pp_queue_t *queue)
+{
+	int	queued_num = 0;
+
+	for (int i = 0; i < queue->deques_num; i++)
+	{
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+		queued_num += PP_DEQUE_QUEUED_NUM(deque);
+#else
+		pthread_mutex_lock(&deque->lock);
+		queued_num += deque->queued_num;
+		pthread_mutex_unlock(&deque->lock);
+#endif
+	}
+
+	return queued_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: wait for queue notifications                                      *
@@ -23,26 +23,59 @@
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
 
+/* per worker task queue, other workers steal tasks from it when their own queues are empty */
+typedef struct
+{
+	zbx_list_t	immediate;
+	zbx_list_t	pending;
+	zbx_list_t	finished;
+
+	int		immediate_num;
+	int		pending_num;
+
+	/* the number of queued tasks, read by idle workers without locking worker queue */
+	int		queued_num;
+
+	/* statistics */
+	zbx_uint64_t	popped_num;
+	zbx_uint64_t	finished_num;
+	zbx_uint64_t	steals_num;
+	double		lock_wait;
+
+	pthread_mutex_t	lock;
+}
+zbx_pp_deque_t;
+
 typedef struct
 {
 	zbx_uint32_t	init_flags;
 	int		workers_num;
+
+	/* statistics, refreshed by pp_task_queue_update_stats() */
 	zbx_uint64_t	pending_num;
 	zbx_uint64_t	finished_num;
 	zbx_uint64_t	processing_num;
+	zbx_uint64_t	steals_num;
+	double		lock_wait;
+
+	zbx_uint64_t	pushed_num;
+	zbx_uint64_t	collected_num;
+	double		queue_lock_wait;
 
 	zbx_hashset_t	sequences;
 
-	zbx_list_t	pending;
-	zbx_list_t	immediate;
-	zbx_list_t	finished;
+	zbx_pp_deque_t	*deques;
+	int		deques_num;
+	int		deques_init_num;
+	int		push_next;
+	int		finished_next;
 
 	pthread_mutex_t	lock;
 	pthread_cond_t	event;
 }
 zbx_pp_queue_t;
 
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int deques_num, char **error);
 void	pp_task_queue_destroy(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_lock(zbx_pp_queue_t *queue);
@@ -52,16 +85,18 @@ void	pp_task_queue_deregister_worker(zbx_pp_queue_t *queue);
 void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid);
 
 int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_queued_num(zbx_pp_queue_t *queue);
 void	pp_task_queue_notify(zbx_pp_queue_t *queue);
 void	pp_task_queue_notify_all(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
 
-zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue);
+zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue, int index);
 void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
-void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
+void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, int index, zbx_pp_task_t *task);
 zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue);
+void	pp_task_queue_update_stats(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_sequence_stats_ptr_t *stats);
 
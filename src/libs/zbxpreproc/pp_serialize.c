@@ -0,0 +1,565 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "pp_protocol.h"
+
+#include "zbxserialize.h"
+#include "zbxalgo.h"
+
+/* Item value batch format. The batch starts with format version byte and value count followed */
+/* by values with integers packed as varints and strings either inline or as references to     */
+/* strings already written in the same batch.                                                  */
+#define PP_VALUE_FORMAT_VERSION	1
+#define PP_BATCH_HEADER_SIZE	(1 + sizeof(zbx_uint32_t))
+
+#define PP_VALUE_TS		0x01
+#define PP_VALUE_RESULT		0x02
+#define PP_VALUE_LOG		0x04
+
+/* agent result fields written only when not zero */
+#define PP_RESULT_LASTLOGSIZE	0x01
+#define PP_RESULT_UI64		0x02
+#define PP_RESULT_DBL		0x04
+#define PP_RESULT_MTIME		0x08
+
+/* string field tags, larger tags are string table references */
+#define PP_STRING_NULL		0
+#define PP_STRING_INLINE	1
+#define PP_STRING_INTERNED	2
+#define PP_STRING_REF_BASE	3
+
+/* strings longer than this are always written inline */
+#define PP_STRING_INTERN_LEN_MAX	128
+
+/* upper bound of value size without string data */
+#define PP_VALUE_SIZE_MAX	128
+
+#define PP_WRITER_ALLOC_INIT	(16 * ZBX_KIBIBYTE)
+
+/* most tags and lengths fit in one byte, avoid function call for them */
+#define pp_serialize_uint31(ptr, value)								\
+	(0x7f >= (value) ? (*(ptr) = (unsigned char)(value), 1) : zbx_serialize_uint31_compact(ptr, value))
+
+#define pp_deserialize_uint31(ptr, value)							\
+	(0 == (*(ptr) & 0x80) ? (*(value) = *(ptr), 1) : zbx_deserialize_uint31_compact(ptr, value))
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes 64 bit unsigned integer as base 128 varint             *
+ *                                                                            *
+ * Parameters: ptr   - [OUT] the output buffer, must have space for at least  *
+ *                           10 bytes                                         *
+ *             value - [IN] the value to serialize                            *
+ *                                                                            *
+ * Return value: The number of bytes written.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	pp_serialize_uint64_compact(unsigned char *ptr, zbx_uint64_t value)
+{
+	unsigned char	*start = ptr;
+
+	while (0x7f < value)
+	{
+		*ptr++ = (unsigned char)(0x80 | (value & 0x7f));
+		value >>= 7;
+	}
+
+	*ptr++ = (unsigned char)value;
+
+	return (zbx_uint32_t)(ptr - start);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes 64 bit unsigned integer from base 128 varint         *
+ *                                                                            *
+ * Parameters: ptr   - [IN] the input buffer                                  *
+ *             value - [OUT] the deserialized value                           *
+ *                                                                            *
+ * Return value: The number of bytes read.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	pp_deserialize_uint64_compact(const unsigned char *ptr, zbx_uint64_t *value)
+{
+	const unsigned char	*start = ptr;
+	int			shift = 0;
+
+	*value = 0;
+
+	do
+	{
+		*value |= (zbx_uint64_t)(*ptr & 0x7f) << shift;
+		shift += 7;
+	}
+	while (0 != (*ptr++ & 0x80));
+
+	return (zbx_uint32_t)(ptr - start);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: ensures the packed batch has enough free space                    *
+ *                                                                            *
+ * Parameters: writer - [IN/OUT] the value batch writer                       *
+ *             size   - [IN] the required free space                          *
+ *                                                                            *
+ * Return value: SUCCEED - the space was reserved                             *
+ *               FAIL    - the batch size would exceed 4GB limit              *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_writer_reserve(zbx_pp_value_writer_t *writer, zbx_uint64_t size)
+{
+	zbx_uint64_t	alloc;
+
+	if (UINT32_MAX < writer->size + size)
+		return FAIL;
+
+	if (writer->size + size <= writer->alloc)
+		return SUCCEED;
+
+	alloc = (0 == writer->alloc ? PP_WRITER_ALLOC_INIT : (zbx_uint64_t)writer->alloc * 2);
+
+	while (alloc < writer->size + size)
+		alloc *= 2;
+
+	writer->alloc = (zbx_uint32_t)MIN(alloc, UINT32_MAX);
+	writer->data = (unsigned char *)zbx_realloc(writer->data, writer->alloc);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes string field                                               *
+ *                                                                            *
+ * Parameters: writer - [IN/OUT] the value batch writer                       *
+ *             ptr    - [OUT] the output position within reserved space       *
+ *             str    - [IN] the string to write, can be NULL                 *
+ *             len    - [IN] the string length                                *
+ *                                                                            *
+ * Return value: The number of bytes written.                                 *
+ *                                                                            *
+ * Comments: Short strings are looked up in the batch string table and        *
+ *           repeated ones are written as references to the first copy.       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	pp_writer_write_str(zbx_pp_value_writer_t *writer, unsigned char *ptr, const char *str,
+		zbx_uint32_t len)
+{
+	unsigned char		*start = ptr;
+	zbx_pp_string_slot_t	*slot = NULL;
+
+	if (NULL == str)
+	{
+		*ptr = PP_STRING_NULL;
+		return 1;
+	}
+
+	if (PP_STRING_INTERN_LEN_MAX >= len)
+	{
+		slot = &writer->strings[ZBX_DEFAULT_STRING_HASH_ALGO(str, len, ZBX_DEFAULT_HASH_SEED) %
+				ZBX_PP_STRING_SLOTS];
+
+		if (0 != slot->offset && len == slot->len && 0 == memcmp(writer->data + slot->offset, str, len))
+			return pp_serialize_uint31(ptr, PP_STRING_REF_BASE + slot->index);
+
+		*ptr++ = PP_STRING_INTERNED;
+	}
+	else
+		*ptr++ = PP_STRING_INLINE;
+
+	ptr += pp_serialize_uint31(ptr, len);
+
+	if (NULL != slot)
+	{
+		slot->offset = (zbx_uint32_t)(ptr - writer->data);
+		slot->len = len;
+		slot->index = writer->strings_num++;
+	}
+
+	memcpy(ptr, str, len);
+	ptr += len;
+
+	return (zbx_uint32_t)(ptr - start);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends item value to the packed batch                            *
+ *                                                                            *
+ * Parameters: writer - [IN/OUT] the value batch writer                       *
+ *             value  - [IN] the value to pack                                *
+ *                                                                            *
+ * Return value: SUCCEED - the value was packed                               *
+ *               FAIL    - the batch size would exceed 4GB limit              *
+ *                                                                            *
+ * Comments: The space for value is reserved with a single check using       *
+ *           string lengths and maximum size of the other fields, then the    *
+ *           value is written in one pass.                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pp_value_writer_add(zbx_pp_value_writer_t *writer, const zbx_preproc_item_value_t *value)
+{
+	const AGENT_RESULT	*result = value->result;
+	zbx_uint32_t		error_len, str_len = 0, text_len = 0, msg_len = 0, log_value_len = 0,
+				log_source_len = 0;
+	zbx_uint64_t		reserve;
+	unsigned char		*ptr, *flags, result_flags = 0;
+
+	error_len = (NULL != value->error ? (zbx_uint32_t)strlen(value->error) : 0);
+	reserve = PP_VALUE_SIZE_MAX + (zbx_uint64_t)error_len;
+
+	if (NULL != result)
+	{
+		if (NULL != result->str)
+			reserve += (str_len = (zbx_uint32_t)strlen(result->str));
+
+		if (NULL != result->text)
+			reserve += (text_len = (zbx_uint32_t)strlen(result->text));
+
+		if (NULL != result->msg)
+			reserve += (msg_len = (zbx_uint32_t)strlen(result->msg));
+
+		if (NULL != result->log)
+		{
+			if (NULL != result->log->value)
+				reserve += (log_value_len = (zbx_uint32_t)strlen(result->log->value));
+
+			if (NULL != result->log->source)
+				reserve += (log_source_len = (zbx_uint32_t)strlen(result->log->source));
+		}
+	}
+
+	if (0 == writer->size)
+		reserve += PP_BATCH_HEADER_SIZE;
+
+	if (SUCCEED != pp_writer_reserve(writer, reserve))
+		return FAIL;
+
+	ptr = writer->data + writer->size;
+
+	if (0 == writer->size)
+	{
+		/* value count is patched when the batch is detached */
+		*ptr = PP_VALUE_FORMAT_VERSION;
+		ptr += PP_BATCH_HEADER_SIZE;
+
+		memset(writer->strings, 0, sizeof(writer->strings));
+		writer->strings_num = 0;
+		writer->values_num = 0;
+	}
+
+	flags = ptr++;
+	*flags = 0;
+
+	ptr += zbx_serialize_char(ptr, value->item_value_type);
+	ptr += zbx_serialize_char(ptr, value->item_flags);
+	ptr += zbx_serialize_char(ptr, value->state);
+	ptr += pp_serialize_uint64_compact(ptr, value->itemid);
+	ptr += pp_serialize_uint64_compact(ptr, value->hostid);
+	ptr += pp_writer_write_str(writer, ptr, value->error, error_len);
+
+	if (NULL != value->ts)
+	{
+		*flags |= PP_VALUE_TS;
+		ptr += zbx_serialize_int(ptr, value->ts->sec);
+		ptr += zbx_serialize_int(ptr, value->ts->ns);
+	}
+
+	if (NULL != result)
+	{
+		unsigned char	*presence = ptr++;
+		zbx_uint64_t	dbl_bits;
+
+		*flags |= PP_VALUE_RESULT;
+
+		if (0 != result->lastlogsize)
+		{
+			result_flags |= PP_RESULT_LASTLOGSIZE;
+			ptr += pp_serialize_uint64_compact(ptr, result->lastlogsize);
+		}
+
+		if (0 != result->ui64)
+		{
+			result_flags |= PP_RESULT_UI64;
+			ptr += pp_serialize_uint64_compact(ptr, result->ui64);
+		}
+
+		/* compare bits to keep negative zero */
+		memcpy(&dbl_bits, &result->dbl, sizeof(dbl_bits));
+
+		if (0 != dbl_bits)
+		{
+			result_flags |= PP_RESULT_DBL;
+			ptr += zbx_serialize_double(ptr, result->dbl);
+		}
+
+		if (0 != result->mtime)
+		{
+			result_flags |= PP_RESULT_MTIME;
+			ptr += zbx_serialize_int(ptr, result->mtime);
+		}
+
+		*presence = result_flags;
+
+		ptr += pp_serialize_uint31(ptr, (zbx_uint32_t)result->type);
+		ptr += pp_writer_write_str(writer, ptr, result->str, str_len);
+		ptr += pp_writer_write_str(writer, ptr, result->text, text_len);
+		ptr += pp_writer_write_str(writer, ptr, result->msg, msg_len);
+
+		if (NULL != result->log)
+		{
+			*flags |= PP_VALUE_LOG;
+			ptr += pp_writer_write_str(writer, ptr, result->log->value, log_value_len);
+			ptr += pp_writer_write_str(writer, ptr, result->log->source, log_source_len);
+			ptr += zbx_serialize_int(ptr, result->log->timestamp);
+			ptr += zbx_serialize_int(ptr, result->log->severity);
+			ptr += zbx_serialize_int(ptr, result->log->logeventid);
+		}
+	}
+
+	writer->size = (zbx_uint32_t)(ptr - writer->data);
+	writer->values_num++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves packed batch data to IPC message and resets writer          *
+ *                                                                            *
+ * Parameters: writer  - [IN/OUT] the value batch writer                      *
+ *             message - [OUT] the message taking ownership of batch data     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pp_value_writer_detach(zbx_pp_value_writer_t *writer, zbx_ipc_message_t *message)
+{
+	if (0 != writer->size)
+		memcpy(writer->data + 1, &writer->values_num, sizeof(writer->values_num));
+
+	message->data = writer->data;
+	message->size = writer->size;
+
+	writer->data = NULL;
+	writer->size = 0;
+	writer->alloc = 0;
+	writer->values_num = 0;
+}
+
+void	zbx_pp_value_writer_clear(zbx_pp_value_writer_t *writer)
+{
+	zbx_free(writer->data);
+	writer->size = 0;
+	writer->alloc = 0;
+	writer->values_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads string field                                                *
+ *                                                                            *
+ * Parameters: reader - [IN/OUT] the value batch reader                       *
+ *             ptr    - [IN] the input position                               *
+ *             str    - [OUT] the allocated string or NULL                    *
+ *                                                                            *
+ * Return value: The number of bytes read.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	pp_reader_read_str(zbx_pp_value_reader_t *reader, const unsigned char *ptr, char **str)
+{
+	const unsigned char	*start = ptr, *data;
+	zbx_uint32_t		tag, len;
+
+	ptr += pp_deserialize_uint31(ptr, &tag);
+
+	switch (tag)
+	{
+		case PP_STRING_NULL:
+			*str = NULL;
+			return (zbx_uint32_t)(ptr - start);
+		case PP_STRING_INLINE:
+		case PP_STRING_INTERNED:
+			ptr += pp_deserialize_uint31(ptr, &len);
+			data = ptr;
+			ptr += len;
+
+			if (PP_STRING_INTERNED == tag)
+			{
+				if (reader->strings_num == reader->strings_alloc)
+				{
+					reader->strings_alloc = (0 == reader->strings_alloc ? ZBX_PP_STRING_SLOTS :
+							reader->strings_alloc * 2);
+					reader->strings = (zbx_pp_string_ref_t *)zbx_realloc(reader->strings,
+							sizeof(zbx_pp_string_ref_t) * reader->strings_alloc);
+				}
+
+				reader->strings[reader->strings_num].str = data;
+				reader->strings[reader->strings_num++].len = len;
+			}
+			break;
+		default:
+			if (reader->strings_num <= tag - PP_STRING_REF_BASE)
+			{
+				THIS_SHOULD_NEVER_HAPPEN;
+				*str = NULL;
+				return (zbx_uint32_t)(ptr - start);
+			}
+
+			data = reader->strings[tag - PP_STRING_REF_BASE].str;
+			len = reader->strings[tag - PP_STRING_REF_BASE].len;
+			break;
+	}
+
+	*str = (char *)zbx_malloc(NULL, (size_t)len + 1);
+	memcpy(*str, data, len);
+	(*str)[len] = '\0';
+
+	return (zbx_uint32_t)(ptr - start);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes reader of packed item value batch                     *
+ *                                                                            *
+ * Parameters: reader - [OUT] the value batch reader                          *
+ *             data   - [IN] the packed batch                                 *
+ *             size   - [IN] the packed batch size                            *
+ *                                                                            *
+ * Return value: SUCCEED - the reader was initialized                         *
+ *               FAIL    - the batch is empty or has unsupported format       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pp_value_reader_init(zbx_pp_value_reader_t *reader, const unsigned char *data, zbx_uint32_t size)
+{
+	memset(reader, 0, sizeof(zbx_pp_value_reader_t));
+
+	if (PP_BATCH_HEADER_SIZE > size)
+		return FAIL;
+
+	if (PP_VALUE_FORMAT_VERSION != *data)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "unsupported preprocessing value batch format version %d", (int)*data);
+		return FAIL;
+	}
+
+	memcpy(&reader->values_num, data + 1, sizeof(reader->values_num));
+	reader->values_left = reader->values_num;
+	reader->data = data + PP_BATCH_HEADER_SIZE;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unpacks next item value from the batch                            *
+ *                                                                            *
+ * Parameters: reader - [IN/OUT] the value batch reader                       *
+ *             value  - [OUT] the unpacked item value                         *
+ *                                                                            *
+ * Return value: SUCCEED - the value was unpacked                             *
+ *               FAIL    - no more values in batch                            *
+ *                                                                            *
+ * Comments: The value timestamp and agent result structures are owned by     *
+ *           reader, the caller must free only the data they reference.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pp_value_reader_next(zbx_pp_value_reader_t *reader, zbx_preproc_item_value_t *value)
+{
+	const unsigned char	*ptr = reader->data;
+	unsigned char		flags;
+
+	if (0 == reader->values_left)
+		return FAIL;
+
+	ptr += zbx_deserialize_char(ptr, &flags);
+	ptr += zbx_deserialize_char(ptr, &value->item_value_type);
+	ptr += zbx_deserialize_char(ptr, &value->item_flags);
+	ptr += zbx_deserialize_char(ptr, &value->state);
+	ptr += pp_deserialize_uint64_compact(ptr, &value->itemid);
+	ptr += pp_deserialize_uint64_compact(ptr, &value->hostid);
+	ptr += pp_reader_read_str(reader, ptr, &value->error);
+
+	if (0 != (flags & PP_VALUE_TS))
+	{
+		value->ts = &reader->ts;
+		ptr += zbx_deserialize_int(ptr, &value->ts->sec);
+		ptr += zbx_deserialize_int(ptr, &value->ts->ns);
+	}
+	else
+		value->ts = NULL;
+
+	if (0 != (flags & PP_VALUE_RESULT))
+	{
+		AGENT_RESULT	*result = &reader->result;
+		unsigned char	result_flags;
+		zbx_uint32_t	type;
+
+		zbx_init_agent_result(result);
+
+		ptr += zbx_deserialize_char(ptr, &result_flags);
+
+		if (0 != (result_flags & PP_RESULT_LASTLOGSIZE))
+			ptr += pp_deserialize_uint64_compact(ptr, &result->lastlogsize);
+
+		if (0 != (result_flags & PP_RESULT_UI64))
+			ptr += pp_deserialize_uint64_compact(ptr, &result->ui64);
+
+		if (0 != (result_flags & PP_RESULT_DBL))
+			ptr += zbx_deserialize_double(ptr, &result->dbl);
+
+		if (0 != (result_flags & PP_RESULT_MTIME))
+			ptr += zbx_deserialize_int(ptr, &result->mtime);
+
+		ptr += pp_deserialize_uint31(ptr, &type);
+		result->type = (int)type;
+
+		ptr += pp_reader_read_str(reader, ptr, &result->str);
+		ptr += pp_reader_read_str(reader, ptr, &result->text);
+		ptr += pp_reader_read_str(reader, ptr, &result->msg);
+
+		if (0 != (flags & PP_VALUE_LOG))
+		{
+			zbx_log_t	*log;
+
+			log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+
+			ptr += pp_reader_read_str(reader, ptr, &log->value);
+			ptr += pp_reader_read_str(reader, ptr, &log->source);
+			ptr += zbx_deserialize_int(ptr, &log->timestamp);
+			ptr += zbx_deserialize_int(ptr, &log->severity);
+			ptr += zbx_deserialize_int(ptr, &log->logeventid);
+
+			result->log = log;
+		}
+
+		value->result = result;
+	}
+	else
+		value->result = NULL;
+
+	reader->data = ptr;
+	reader->values_left--;
+
+	return SUCCEED;
+}
+
+void	zbx_pp_value_reader_clear(zbx_pp_value_reader_t *reader)
+{
+	zbx_free(reader->strings);
+}
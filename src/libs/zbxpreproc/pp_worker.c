@@ -137,13 +137,12 @@ static void	*pp_worker_entry(void *args)
 	pp_context_init(&worker->execute_ctx);
 	pp_task_queue_lock(queue);
 	pp_task_queue_register_worker(queue);
+	pp_task_queue_unlock(queue);
 
 	while (0 == worker->stop)
 	{
-		if (NULL != (in = pp_task_queue_pop_new(queue)))
+		if (NULL != (in = pp_task_queue_pop_new(queue, worker->id - 1)))
 		{
-			pp_task_queue_unlock(queue);
-
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_BUSY);
 
 			zabbix_log(LOG_LEVEL_TRACE, "%s() process task type:%u itemid:" ZBX_FS_UI64, __func__,
@@ -168,8 +167,7 @@ static void	*pp_worker_entry(void *args)
 
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_IDLE);
 
-			pp_task_queue_lock(queue);
-			pp_task_queue_push_finished(queue, in);
+			pp_task_queue_push_finished(queue, worker->id - 1, in);
 
 			if (NULL != worker->finished_cb)
 				worker->finished_cb(worker->finished_data);
@@ -177,17 +175,26 @@ static void	*pp_worker_entry(void *args)
 			continue;
 		}
 
-		if (SUCCEED != pp_task_queue_wait(queue, &error))
+		pp_task_queue_lock(queue);
+
+		/* manager stops workers and pushes tasks within task queue lock */
+		if (0 == worker->stop && 0 == pp_task_queue_queued_num(queue))
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "[%d] %s", worker->id, error);
-			zbx_free(error);
-			worker->stop = 1;
+			if (SUCCEED != pp_task_queue_wait(queue, &error))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "[%d] %s", worker->id, error);
+				zbx_free(error);
+				worker->stop = 1;
+			}
+
+			if (1 < pp_task_queue_queued_num(queue))
+				pp_task_queue_notify(queue);
 		}
 
-		if (1 < queue->pending_num)
-			pp_task_queue_notify(queue);
+		pp_task_queue_unlock(queue);
 	}
 
+	pp_task_queue_lock(queue);
 	pp_task_queue_deregister_worker(queue);
 	pp_task_queue_unlock(queue);
 
@@ -81,6 +81,31 @@
  *  lo_bound             `size' fields in chunk B                   hi_bound  *
  *  (aligned)            have SHMEM_FLG_USED bit set               (aligned)  *
  *                                                                            *
+ * (*) slabs: optional size classes for frequently allocated fixed size       *
+ *     objects (see zbx_shmem_add_slab_class())                               *
+ *                                                                            *
+ *     a slab is a used chunk split into a header and equally sized objects,  *
+ *     each object is preceded by a single 8 byte field with SHMEM_FLG_USED   *
+ *     and SHMEM_FLG_SLAB bits set and the object offset from the slab start  *
+ *     in the lower bits                                                      *
+ *                                                                            *
+ *                +------------------ slab chunk -------------------+         *
+ *                |                                                 |         *
+ *                v                                                 v         *
+ *                |size|header|off|object|off|object|...|off|object|size|     *
+ *                                                                            *
+ *     free objects of a slab are kept in a singly-linked list stored in the  *
+ *     first ZBX_PTR_SIZE bytes of object memory, slabs having free objects   *
+ *     are kept in a doubly-linked list of their size class                   *
+ *                                                                            *
+ *     allocating and freeing slab objects does not require free chunk list  *
+ *     lookups or merging, slabs are returned to the shared memory only when  *
+ *     they become empty and the size class has enough other free objects    *
+ *                                                                            *
+ *     memory of free slab objects is counted in free_size and memory of      *
+ *     used slab objects in used_size, slab headers and object offset fields  *
+ *     are counted in used_size                                               *
+ *                                                                            *
  ******************************************************************************/
 
 static void	*ALIGN4(void *ptr);
@@ -107,6 +132,10 @@ static void	*__mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size);
 static void	*__mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size);
 static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 
+static void	*mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size);
+static void	*mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size);
+static void	mem_free(zbx_shmem_info_t *info, void *ptr);
+
 #define SHMEM_SIZE_FIELD	sizeof(zbx_uint64_t)
 
 #define SHMEM_FLG_USED		((__UINT64_C(1))<<63)
@@ -117,6 +146,26 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 #define SHMEM_MIN_SIZE		__UINT64_C(128)
 #define SHMEM_MAX_SIZE		__UINT64_C(0x1000000000)	/* 64 GB */
 
+#define SHMEM_FLG_SLAB		((__UINT64_C(1))<<62)
+
+#define SLAB_OBJECT(ptr)	(((*(zbx_uint64_t *)(ptr)) & SHMEM_FLG_SLAB) != 0)
+#define SLAB_OBJECT_OFFSET(ptr)	((*(zbx_uint64_t *)(ptr)) & ~(SHMEM_FLG_USED | SHMEM_FLG_SLAB))
+
+#define SHMEM_SLAB_SIZE		__UINT64_C(16384)
+#define SHMEM_SLAB_MEM_RATIO	64	/* slab size is limited to 1/64 of the shared memory size */
+
+typedef struct
+{
+	void		*prev;
+	void		*next;
+	void		*free_objects;
+	zbx_uint64_t	used_num;
+	int		class_index;
+}
+zbx_shmem_slab_t;
+
+#define SHMEM_SLAB_HEADER_SIZE	((sizeof(zbx_shmem_slab_t) + 7) & ~(size_t)7)
+
 /* helper functions */
 
 static void	*ALIGN4(void *ptr)
@@ -523,6 +572,217 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr)
 	}
 }
 
+/* slab functions */
+
+static zbx_uint64_t	mem_slab_object_size(zbx_uint64_t size)
+{
+	size += (8 - (size & 7)) & 7;
+
+	return MAX(size, (zbx_uint64_t)ZBX_PTR_SIZE);
+}
+
+static int	mem_slab_class_by_size(const zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	int	i;
+
+	size = mem_slab_object_size(size);
+
+	for (i = 0; i < info->slab_classes_num; i++)
+	{
+		if (info->slab_classes[i].size == size)
+			return i;
+	}
+
+	return FAIL;
+}
+
+static void	mem_slab_link(zbx_shmem_slab_class_t *slab_class, zbx_shmem_slab_t *slab)
+{
+	if (NULL != slab_class->slabs)
+		((zbx_shmem_slab_t *)slab_class->slabs)->prev = slab;
+
+	slab->prev = NULL;
+	slab->next = slab_class->slabs;
+	slab_class->slabs = slab;
+}
+
+static void	mem_slab_unlink(zbx_shmem_slab_class_t *slab_class, zbx_shmem_slab_t *slab)
+{
+	if (NULL != slab->prev)
+		((zbx_shmem_slab_t *)slab->prev)->next = slab->next;
+	else
+		slab_class->slabs = slab->next;
+
+	if (NULL != slab->next)
+		((zbx_shmem_slab_t *)slab->next)->prev = slab->prev;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate new slab for the specified size class                    *
+ *                                                                            *
+ * Return value: the allocated slab or NULL if there is not enough memory     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_shmem_slab_t	*mem_slab_create(zbx_shmem_info_t *info, int index)
+{
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[index];
+	zbx_shmem_slab_t	*slab;
+	void			*chunk;
+	char			*object;
+	unsigned int		i;
+
+	if (NULL == (chunk = __mem_malloc(info, slab_class->slab_size)))
+		return NULL;
+
+	slab = (zbx_shmem_slab_t *)((char *)chunk + SHMEM_SIZE_FIELD);
+	slab->used_num = 0;
+	slab->class_index = index;
+	slab->free_objects = NULL;
+
+	object = (char *)slab + SHMEM_SLAB_HEADER_SIZE + (slab_class->objects_num - 1) *
+			(SHMEM_SIZE_FIELD + slab_class->size);
+
+	/* link objects in reverse order so the first allocations are done from the slab start */
+	for (i = 0; i < slab_class->objects_num; i++)
+	{
+		*(zbx_uint64_t *)object = SHMEM_FLG_USED | SHMEM_FLG_SLAB | (zbx_uint64_t)(object - (char *)slab);
+		*(void **)(object + SHMEM_SIZE_FIELD) = slab->free_objects;
+		slab->free_objects = object;
+		object -= SHMEM_SIZE_FIELD + slab_class->size;
+	}
+
+	mem_slab_link(slab_class, slab);
+	slab_class->slabs_num++;
+	slab_class->free_num += slab_class->objects_num;
+
+	info->used_size -= slab_class->objects_num * slab_class->size;
+	info->free_size += slab_class->objects_num * slab_class->size;
+
+	return slab;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate object from the specified size class                     *
+ *                                                                            *
+ * Return value: the object (pointing at its header field, same as chunks     *
+ *               returned by __mem_malloc()) or NULL if there is not enough   *
+ *               memory to allocate new slab                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	*mem_slab_malloc(zbx_shmem_info_t *info, int index)
+{
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[index];
+	zbx_shmem_slab_t	*slab;
+	void			*object;
+
+	if (NULL == (slab = (zbx_shmem_slab_t *)slab_class->slabs) && NULL == (slab = mem_slab_create(info, index)))
+		return NULL;
+
+	object = slab->free_objects;
+	slab->free_objects = *(void **)((char *)object + SHMEM_SIZE_FIELD);
+
+	if (NULL == slab->free_objects)
+		mem_slab_unlink(slab_class, slab);
+
+	slab->used_num++;
+	slab_class->used_num++;
+	slab_class->free_num--;
+
+	info->used_size += slab_class->size;
+	info->free_size -= slab_class->size;
+
+	return object;
+}
+
+static void	mem_slab_free(zbx_shmem_info_t *info, void *object)
+{
+	zbx_shmem_slab_t	*slab;
+	zbx_shmem_slab_class_t	*slab_class;
+
+	slab = (zbx_shmem_slab_t *)((char *)object - SLAB_OBJECT_OFFSET(object));
+	slab_class = &info->slab_classes[slab->class_index];
+
+	if (NULL == slab->free_objects)
+		mem_slab_link(slab_class, slab);
+
+	*(void **)((char *)object + SHMEM_SIZE_FIELD) = slab->free_objects;
+	slab->free_objects = object;
+
+	slab->used_num--;
+	slab_class->used_num--;
+	slab_class->free_num++;
+
+	info->used_size -= slab_class->size;
+	info->free_size += slab_class->size;
+
+	/* keep at least one slab worth of free objects to avoid slab allocation thrashing */
+	if (0 == slab->used_num && slab_class->free_num >= 2 * (zbx_uint64_t)slab_class->objects_num)
+	{
+		mem_slab_unlink(slab_class, slab);
+		slab_class->slabs_num--;
+		slab_class->free_num -= slab_class->objects_num;
+
+		/* the whole slab chunk is accounted as used memory when it is freed */
+		info->used_size += slab_class->objects_num * slab_class->size;
+		info->free_size -= slab_class->objects_num * slab_class->size;
+
+		__mem_free(info, slab);
+	}
+}
+
+/* memory functions dispatching between slabs and free chunk lists */
+
+static void	*mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	int	index;
+	void	*object;
+
+	if (0 != info->slab_classes_num && FAIL != (index = mem_slab_class_by_size(info, size)) &&
+			NULL != (object = mem_slab_malloc(info, index)))
+	{
+		return object;
+	}
+
+	return __mem_malloc(info, size);
+}
+
+static void	*mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size)
+{
+	void		*object, *new_object;
+	zbx_uint64_t	object_size;
+
+	object = (void *)((char *)old - SHMEM_SIZE_FIELD);
+
+	if (!SLAB_OBJECT(object))
+		return __mem_realloc(info, old, size);
+
+	object_size = info->slab_classes[((zbx_shmem_slab_t *)((char *)object -
+			SLAB_OBJECT_OFFSET(object)))->class_index].size;
+
+	if (mem_slab_object_size(size) == object_size)
+		return object;
+
+	if (NULL == (new_object = mem_malloc(info, size)))
+		return NULL;
+
+	memcpy((char *)new_object + SHMEM_SIZE_FIELD, old, MIN(object_size, size));
+	mem_slab_free(info, object);
+
+	return new_object;
+}
+
+static void	mem_free(zbx_shmem_info_t *info, void *ptr)
+{
+	void	*object = (void *)((char *)ptr - SHMEM_SIZE_FIELD);
+
+	if (SLAB_OBJECT(object))
+		mem_slab_free(info, object);
+	else
+		__mem_free(info, ptr);
+}
+
 /* public memory interface */
 
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
@@ -596,6 +856,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 	base = (void *)((char *)base + strlen(param) + 1);
 
 	(*info)->allow_oom = allow_oom;
+	(*info)->slab_classes_num = 0;
 
 	/* prepare shared memory for further allocation by creating one big chunk */
 	(*info)->lo_bound = ALIGN8(base);
@@ -665,6 +926,59 @@ void	zbx_shmem_destroy(zbx_shmem_info_t *info)
 	(void)shmdt(info->base);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serve allocations of the specified size from slabs                *
+ *                                                                            *
+ * Parameters: info - [IN] the shared memory                                  *
+ *             size - [IN] the object size                                    *
+ *                                                                            *
+ * Comments: Slab objects have lower overhead and are allocated/freed in      *
+ *           constant time without fragmenting the shared memory. Size        *
+ *           classes should be added only for small fixed size objects that   *
+ *           are frequently allocated and freed, for example hashset entries  *
+ *           of cache items.                                                  *
+ *           Allocations that cannot be served from slabs fall back to the    *
+ *           free chunk lists.                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_shmem_add_slab_class(zbx_shmem_info_t *info, size_t size)
+{
+	zbx_shmem_slab_class_t	*slab_class;
+	zbx_uint64_t		slab_size;
+
+	if (0 == size || FAIL != mem_slab_class_by_size(info, size))
+		return;
+
+	if (ZBX_SHMEM_SLAB_CLASSES_MAX == info->slab_classes_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	slab_class = &info->slab_classes[info->slab_classes_num];
+	slab_class->size = mem_slab_object_size(size);
+
+	slab_size = MIN(SHMEM_SLAB_SIZE, info->total_size / SHMEM_SLAB_MEM_RATIO);
+
+	if (slab_size < SHMEM_SLAB_HEADER_SIZE + SHMEM_SIZE_FIELD + slab_class->size)
+		slab_class->objects_num = 1;
+	else
+		slab_class->objects_num = (slab_size - SHMEM_SLAB_HEADER_SIZE) / (SHMEM_SIZE_FIELD + slab_class->size);
+
+	slab_class->slab_size = SHMEM_SLAB_HEADER_SIZE + slab_class->objects_num *
+			(SHMEM_SIZE_FIELD + slab_class->size);
+	slab_class->slabs = NULL;
+	slab_class->slabs_num = 0;
+	slab_class->used_num = 0;
+	slab_class->free_num = 0;
+
+	info->slab_classes_num++;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s: added slab class for %s object size:" ZBX_FS_UI64 " objects per slab:%u",
+			__func__, info->mem_descr, slab_class->size, slab_class->objects_num);
+}
+
 void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size)
 {
 	void	*chunk;
@@ -683,7 +997,7 @@ void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, con
 		exit(EXIT_FAILURE);
 	}
 
-	chunk = __mem_malloc(info, size);
+	chunk = mem_malloc(info, size);
 
 	if (NULL == chunk)
 	{
@@ -695,8 +1009,16 @@ void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, con
 
 		zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): out of memory (requested " ZBX_FS_SIZE_T " bytes)",
 				file, line, __func__, (zbx_fs_size_t)size);
-		zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): please increase %s configuration parameter",
-				file, line, __func__, info->mem_param);
+		if ('\0' != *info->mem_param)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): please increase %s configuration parameter",
+					file, line, __func__, info->mem_param);
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): %s size is not configurable",
+					file, line, __func__, info->mem_descr);
+		}
 		exit(EXIT_FAILURE);
 	}
 
@@ -715,9 +1037,9 @@ void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, vo
 	}
 
 	if (NULL == old)
-		chunk = __mem_malloc(info, size);
+		chunk = mem_malloc(info, size);
 	else
-		chunk = __mem_realloc(info, old, size);
+		chunk = mem_realloc(info, old, size);
 
 	if (NULL == chunk)
 	{
@@ -729,8 +1051,16 @@ void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, vo
 
 		zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): out of memory (requested " ZBX_FS_SIZE_T " bytes)",
 				file, line, __func__, (zbx_fs_size_t)size);
-		zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): please increase %s configuration parameter",
-				file, line, __func__, info->mem_param);
+		if ('\0' != *info->mem_param)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): please increase %s configuration parameter",
+					file, line, __func__, info->mem_param);
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "[file:%s,line:%d] %s(): %s size is not configurable",
+					file, line, __func__, info->mem_descr);
+		}
 		exit(EXIT_FAILURE);
 	}
 
@@ -745,12 +1075,12 @@ void	__zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *
 		exit(EXIT_FAILURE);
 	}
 
-	__mem_free(info, ptr);
+	mem_free(info, ptr);
 }
 
 void	zbx_shmem_clear(zbx_shmem_info_t *info)
 {
-	int	index;
+	int	index, i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -763,6 +1093,14 @@ void	zbx_shmem_clear(zbx_shmem_info_t *info)
 	info->used_size = 0;
 	info->free_size = info->total_size;
 
+	for (i = 0; i < info->slab_classes_num; i++)
+	{
+		info->slab_classes[i].slabs = NULL;
+		info->slab_classes[i].slabs_num = 0;
+		info->slab_classes[i].used_num = 0;
+		info->slab_classes[i].free_num = 0;
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -800,6 +1138,16 @@ void	zbx_shmem_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats)
 	stats->used_chunks = stats->overhead / (2 * SHMEM_SIZE_FIELD) + 1 - stats->free_chunks;
 	stats->free_size = info->free_size;
 	stats->used_size = info->used_size;
+
+	for (i = 0; i < info->slab_classes_num; i++)
+	{
+		stats->slab_classes[i].size = info->slab_classes[i].size;
+		stats->slab_classes[i].slabs_num = info->slab_classes[i].slabs_num;
+		stats->slab_classes[i].used_num = info->slab_classes[i].used_num;
+		stats->slab_classes[i].free_num = info->slab_classes[i].free_num;
+	}
+
+	stats->slab_classes_num = info->slab_classes_num;
 }
 
 void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
@@ -833,6 +1181,15 @@ void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
 	zabbix_log(level, "of those, %10llu bytes are used by allocation overhead",
 			(unsigned long long)stats.overhead);
 
+	for (i = 0; i < stats.slab_classes_num; i++)
+	{
+		zabbix_log(level, "slab class of size %5llu bytes: %8llu slabs, %8llu used and %8llu free objects",
+				(unsigned long long)stats.slab_classes[i].size,
+				(unsigned long long)stats.slab_classes[i].slabs_num,
+				(unsigned long long)stats.slab_classes[i].used_num,
+				(unsigned long long)stats.slab_classes[i].free_num);
+	}
+
 	zabbix_log(level, "================================");
 }
 
@@ -207,6 +207,26 @@ void	zbx_zabbix_stats_get(struct zbx_json *json, int config_startup_time)
 			(double)wcache_info.index_total);
 	zbx_json_close(json);
 
+	zbx_json_addarray(json, "shards");
+
+	for (i = 0; i < wcache_info.shards_num; i++)
+	{
+		const zbx_hc_shard_stats_t	*shard = &wcache_info.shards[i];
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addfloat(json, "history pused", 100 * (double)(shard->history_total - shard->history_free) /
+				(double)shard->history_total);
+		zbx_json_addfloat(json, "index pused", 100 * (double)(shard->index_total - shard->index_free) /
+				(double)shard->index_total);
+		zbx_json_adduint64(json, "items", shard->items_num);
+		zbx_json_adduint64(json, "values", shard->values_num);
+		zbx_json_adduint64(json, "locks", shard->lock_num);
+		zbx_json_addfloat(json, "lock wait", shard->lock_wait);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		zbx_json_addobject(json, "trend");
@@ -217,6 +237,26 @@ void	zbx_zabbix_stats_get(struct zbx_json *json, int config_startup_time)
 		zbx_json_addfloat(json, "pused", 100 * (double)(wcache_info.trend_total - wcache_info.trend_free) /
 				(double)wcache_info.trend_total);
 		zbx_json_close(json);
+
+		/* write rates are calculated over the time spent writing to the table */
+		zbx_json_addarray(json, "writes");
+
+		for (i = 0; i < ZBX_DB_INSERT_STATS_TABLES_NUM; i++)
+		{
+			const zbx_db_insert_stats_t	*stats = &wcache_info.insert_stats[i];
+
+			zbx_json_addobject(json, NULL);
+			zbx_json_addstring(json, "table", zbx_db_insert_stats_table(i), ZBX_JSON_TYPE_STRING);
+			zbx_json_adduint64(json, "rows", stats->rows);
+			zbx_json_adduint64(json, "bytes", stats->bytes);
+			zbx_json_addfloat(json, "rows per sec", 0 < stats->time ? (double)stats->rows / stats->time : 0);
+			zbx_json_addfloat(json, "bytes per sec", 0 < stats->time ? (double)stats->bytes / stats->time : 0);
+			zbx_json_adduint64(json, "copy rows", stats->copy_rows);
+			zbx_json_adduint64(json, "copy fallbacks", stats->copy_fallbacks);
+			zbx_json_close(json);
+		}
+
+		zbx_json_close(json);
 	}
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_PROXY))
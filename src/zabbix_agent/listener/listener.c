@@ -25,6 +25,8 @@
 #include "zbxlog.h"
 #include "zbxstr.h"
 #include "zbxtime.h"
+#include "zbxjson.h"
+#include "zbxnum.h"
 #include "zbx_rtc_constants.h"
 
 #if defined(ZABBIX_SERVICE)
@@ -37,67 +39,217 @@
 static volatile sig_atomic_t	need_update_userparam;
 #endif
 
-static void	process_listener(zbx_socket_t *s, int config_timeout)
+static int	process_passive_check(zbx_socket_t *s, int config_timeout)
 {
 	AGENT_RESULT	result;
 	char		**value = NULL;
-	int		ret;
+	int		ret = SUCCEED;
+	zbx_uint32_t	timeout;
 
-	if (SUCCEED == (ret = zbx_tcp_recv_to(s, config_timeout)))
+	zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
+
+	if (0 != s->reserved_payload)
+		timeout = s->reserved_payload;
+	else
+		timeout = (zbx_uint32_t)config_timeout;
+
+	zbx_init_agent_result(&result);
+
+	if (SUCCEED == zbx_execute_agent_check(s->buffer, ZBX_PROCESS_WITH_ALIAS, &result, (int)timeout))
+	{
+		if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
+			ret = zbx_tcp_send_to(s, *value, config_timeout);
+		}
+	}
+	else
 	{
-		zbx_uint32_t	timeout;
+		value = ZBX_GET_MSG_RESULT(&result);
 
-		zbx_rtrim(s->buffer, "\r\n");
+		if (NULL != value)
+		{
+			static char	*buffer = NULL;
+			static size_t	buffer_alloc = 256;
+			size_t		buffer_offset = 0;
 
-		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]", *value);
 
-		if (0 != s->reserved_payload)
-			timeout = s->reserved_payload;
-		else
-			timeout = (zbx_uint32_t)config_timeout;
+			if (NULL == buffer)
+				buffer = (char *)zbx_malloc(buffer, buffer_alloc);
 
-		zbx_init_agent_result(&result);
+			zbx_strncpy_alloc(&buffer, &buffer_alloc, &buffer_offset,
+					ZBX_NOTSUPPORTED, ZBX_CONST_STRLEN(ZBX_NOTSUPPORTED));
+			buffer_offset++;
+			zbx_strcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, *value);
 
-		if (SUCCEED == zbx_execute_agent_check(s->buffer, ZBX_PROCESS_WITH_ALIAS, &result, (int)timeout))
-		{
-			if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
-				ret = zbx_tcp_send_to(s, *value, config_timeout);
-			}
+			ret = zbx_tcp_send_bytes_to(s, buffer, buffer_offset, config_timeout);
 		}
 		else
 		{
-			value = ZBX_GET_MSG_RESULT(&result);
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED "]");
+			ret = zbx_tcp_send_to(s, ZBX_NOTSUPPORTED, config_timeout);
+		}
+	}
 
-			if (NULL != value)
+	zbx_free_agent_result(&result);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process passive checks batch request                              *
+ *                                                                            *
+ * Parameters: s                      - [IN] socket with received request     *
+ *             jp                     - [IN] parsed request                   *
+ *             config_timeout         - [IN]                                  *
+ *             config_session_timeout - [IN] time in seconds to wait for the  *
+ *                                           next request on the same         *
+ *                                           connection, 0 - close connection *
+ *                                           after response                   *
+ *                                                                            *
+ * Return value: SUCCEED - response was sent                                  *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: Request:                                                         *
+ *             {"request":"passive checks",                                   *
+ *              "data":[{"key":"<key>","timeout":<seconds>},...]}             *
+ *           Response (values are returned in the same order as requested):  *
+ *             {"session_timeout":<seconds>,                                  *
+ *              "data":[{"value":"<value>"},{"error":"<error>"},...]}         *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_checks(zbx_socket_t *s, const struct zbx_json_parse *jp, int config_timeout,
+		int config_session_timeout)
+{
+	struct zbx_json_parse	jp_data, jp_row;
+	struct zbx_json		j;
+	const char		*p = NULL;
+	char			*key = NULL, buf[MAX_ID_LEN + 1];
+	size_t			key_alloc = 0;
+	int			ret;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+
+	if (0 != config_session_timeout)
+		zbx_json_addint64(&j, ZBX_PROTO_TAG_SESSION_TIMEOUT, config_session_timeout);
+
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		while (NULL != (p = zbx_json_next(&jp_data, p)))
+		{
+			AGENT_RESULT	result;
+			char		**value;
+			int		timeout;
+
+			zbx_json_addobject(&j, NULL);
+
+			if (SUCCEED != zbx_json_brackets_open(p, &jp_row) || SUCCEED != zbx_json_value_by_name_dyn(
+					&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc, NULL))
 			{
-				static char	*buffer = NULL;
-				static size_t	buffer_alloc = 256;
-				size_t		buffer_offset = 0;
+				zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, "Invalid passive check request.",
+						ZBX_JSON_TYPE_STRING);
+				zbx_json_close(&j);
+				continue;
+			}
 
-				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]", *value);
+			if (SUCCEED != zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_TIMEOUT, buf, sizeof(buf), NULL) ||
+					SUCCEED != zbx_is_uint_range(buf, &timeout, 1, SEC_PER_MIN * 10))
+			{
+				timeout = config_timeout;
+			}
 
-				if (NULL == buffer)
-					buffer = (char *)zbx_malloc(buffer, buffer_alloc);
+			zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", key);
 
-				zbx_strncpy_alloc(&buffer, &buffer_alloc, &buffer_offset,
-						ZBX_NOTSUPPORTED, ZBX_CONST_STRLEN(ZBX_NOTSUPPORTED));
-				buffer_offset++;
-				zbx_strcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, *value);
+			zbx_init_agent_result(&result);
 
-				ret = zbx_tcp_send_bytes_to(s, buffer, buffer_offset, config_timeout);
+			if (SUCCEED == zbx_execute_agent_check(key, ZBX_PROCESS_WITH_ALIAS, &result, timeout))
+			{
+				if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
+					zbx_json_addstring(&j, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
+				}
+				else
+				{
+					zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, "Agent returned no value.",
+							ZBX_JSON_TYPE_STRING);
+				}
 			}
 			else
 			{
-				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED "]");
-				ret = zbx_tcp_send_to(s, ZBX_NOTSUPPORTED, config_timeout);
+				const char	*error;
+
+				error = (NULL != (value = ZBX_GET_MSG_RESULT(&result)) ? *value :
+						"Not supported by Zabbix Agent");
+
+				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]", error);
+				zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, error, ZBX_JSON_TYPE_STRING);
 			}
+
+			zbx_free_agent_result(&result);
+			zbx_json_close(&j);
 		}
+	}
+
+	ret = zbx_tcp_send_to(s, j.buffer, config_timeout);
+
+	zbx_free(key);
+	zbx_json_free(&j);
+
+	return ret;
+}
 
-		zbx_free_agent_result(&result);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process passive check requests received on accepted connection   *
+ *                                                                            *
+ * Comments: Single key requests are answered and the connection is closed.  *
+ *           Passive checks batch requests can be followed by more requests   *
+ *           on the same connection within session timeout.                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_listener(zbx_socket_t *s, int config_timeout, int config_session_timeout)
+{
+	struct zbx_json_parse	jp;
+	char			request[MAX_STRING_LEN];
+	ssize_t			received_len;
+	int			ret = SUCCEED, timeout = config_timeout, requests_num = 0;
+
+	while (FAIL != (received_len = zbx_tcp_recv_ext(s, timeout, 0)))
+	{
+		/* the connection was closed by server between session requests */
+		if (0 == received_len && 0 != requests_num)
+			break;
+
+		zbx_rtrim(s->buffer, "\r\n");
+
+		if ('{' != *s->buffer || SUCCEED != zbx_json_open(s->buffer, &jp) ||
+				SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_REQUEST, request, sizeof(request),
+				NULL) || 0 != strcmp(request, ZBX_PROTO_VALUE_PASSIVE_CHECKS))
+		{
+			ret = process_passive_check(s, config_timeout);
+			break;
+		}
+
+		requests_num++;
+
+		if (SUCCEED != (ret = process_passive_checks(s, &jp, config_timeout, config_session_timeout)) ||
+				0 == config_session_timeout || !ZBX_IS_RUNNING())
+		{
+			break;
+		}
+
+		timeout = config_session_timeout;
 	}
 
+	/* idle session timeout is a normal way to end the session */
+	if (FAIL == received_len && 0 == requests_num)
+		ret = FAIL;
+
 	if (FAIL == ret)
 		zabbix_log(LOG_LEVEL_DEBUG, "Process listener error: %s", zbx_socket_strerror());
 }
@@ -175,7 +327,8 @@ ZBX_THREAD_ENTRY(listener_thread, args)
 						&msg)))
 #endif
 				{
-					process_listener(&s, init_child_args_in->config_timeout);
+					process_listener(&s, init_child_args_in->config_timeout,
+							init_child_args_in->config_listen_session_timeout);
 				}
 			}
 
@@ -32,6 +32,7 @@ typedef struct
 	int			config_timeout;
 	const char		*config_hosts_allowed;
 	char			**config_user_parameters;
+	int			config_listen_session_timeout;
 }
 zbx_thread_listener_args;
 
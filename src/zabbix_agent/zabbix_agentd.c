@@ -46,6 +46,7 @@ ZBX_GET_CONFIG_VAR(int, zbx_config_unsafe_user_parameters, 0)
 static int	zbx_config_listen_port			= ZBX_DEFAULT_AGENT_PORT;
 static char	*zbx_config_listen_ip			= NULL;
 static int	zbx_config_refresh_active_checks	= 5;
+static int	zbx_config_listen_session_timeout	= 3;
 
 ZBX_GET_CONFIG_VAR2(char*, const char *, zbx_config_source_ip, NULL)
 
@@ -1014,6 +1015,8 @@ static void	zbx_load_config(int requirement, ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"ListenBacklog",		&CONFIG_TCP_MAX_BACKLOG_SIZE,		TYPE_INT,
 			PARM_OPT,	0,			INT_MAX},
+		{"ListenSessionTimeout",	&zbx_config_listen_session_timeout,	TYPE_INT,
+			PARM_OPT,	0,			30},
 		{"HeartbeatFrequency",		&zbx_config_heartbeat_frequency,	TYPE_INT,
 			PARM_OPT,	0,			3600},
 		{NULL}
@@ -1338,7 +1341,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		zbx_thread_info_t		*thread_info;
 		zbx_thread_listener_args	listener_args = {&listen_sock, zbx_config_tls, get_program_type,
 								config_file, zbx_config_timeout,
-								zbx_config_hosts_allowed, zbx_config_user_parameters};
+								zbx_config_hosts_allowed, zbx_config_user_parameters,
+								zbx_config_listen_session_timeout};
 
 		thread_args = (zbx_thread_args_t *)zbx_malloc(NULL, sizeof(zbx_thread_args_t));
 		thread_info = &thread_args->info;
@@ -100,8 +100,9 @@ const char	*help_message[] = {
 	"                                   target is not specified",
 	"      " ZBX_SNMP_CACHE_RELOAD "          Reload SNMP cache",
 	"      " ZBX_DIAGINFO "=section           Log internal diagnostic information of the",
-	"                                 section (historycache, preprocessing, locks) or",
-	"                                 everything if section is not specified",
+	"                                 section (historycache, preprocessing, locks,",
+	"                                 configcache) or everything if section is not",
+	"                                 specified",
 	"      " ZBX_PROF_ENABLE "=target         Enable profiling, affects all processes if",
 	"                                   target is not specified",
 	"      " ZBX_PROF_DISABLE "=target        Disable profiling, affects all processes if",
@@ -263,12 +264,16 @@ static int	config_vmware_timeout		= 10;
 static zbx_uint64_t	config_conf_cache_size		= 8 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
+static int		config_history_cache_shards	= 1;
 static zbx_uint64_t	config_trends_cache_size	= 0;
 static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
 
 static int	config_unreachable_period		= 45;
 static int	config_unreachable_delay		= 15;
 static int	config_max_concurrent_checks_per_poller	= 1000;
+static int	config_poller_items_ownership		= 0;
+static int	config_poller_io_uring			= 0;
+static int	config_poller_agent_sessions		= 0;
 
 static int	config_log_level		= LOG_LEVEL_WARNING;
 
@@ -625,6 +630,20 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (ZBX_HC_SHARD_SIZE_MIN > config_history_cache_size / (zbx_uint64_t)config_history_cache_shards)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"HistoryCacheSize\" configuration parameter must be at least 128KB"
+				" per history cache shard (\"HistoryCacheShards\" is %d)", config_history_cache_shards);
+		err = 1;
+	}
+
+	if (ZBX_HC_SHARD_SIZE_MIN > config_history_index_cache_size / (zbx_uint64_t)config_history_cache_shards)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"HistoryIndexCacheSize\" configuration parameter must be at least 128KB"
+				" per history cache shard (\"HistoryCacheShards\" is %d)", config_history_cache_shards);
+		err = 1;
+	}
+
 	if (ZBX_PROXYMODE_ACTIVE == config_proxymode)
 	{
 		if (NULL != strchr(config_server, ','))
@@ -869,6 +888,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheShards",		&config_history_cache_shards,		TYPE_INT,
+			PARM_OPT,	1,			ZBX_HC_SHARDS_MAX},
 		{"HousekeepingFrequency",	&config_housekeeping_frequency,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&config_proxy_local_buffer,		TYPE_INT,
@@ -1045,6 +1066,12 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"MaxConcurrentChecksPerPoller",	&config_max_concurrent_checks_per_poller,	TYPE_INT,
 			PARM_OPT,	1,			1000},
+		{"PollerItemsOwnership",	&config_poller_items_ownership,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"PollerIoUring",		&config_poller_io_uring,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"PollerAgentSessions",		&config_poller_agent_sessions,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{NULL}
 	};
 
@@ -1374,7 +1401,9 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	zbx_thread_poller_args			poller_args = {&config_comms, get_program_type, ZBX_NO_POLLER,
 								config_startup_time, config_unavailable_delay,
 								config_unreachable_period, config_unreachable_delay,
-								config_max_concurrent_checks_per_poller};
+								config_max_concurrent_checks_per_poller,
+								config_poller_items_ownership, config_poller_io_uring,
+								config_poller_agent_sessions, get_config_forks};
 	zbx_thread_proxyconfig_args		proxyconfig_args = {zbx_config_tls, &zbx_config_vault,
 								get_program_type, zbx_config_timeout,
 								&config_server_addrs, config_hostname,
@@ -1404,7 +1433,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 							.workers_num = CONFIG_FORKS[ZBX_PROCESS_TYPE_PREPROCESSOR],
 							.config_timeout = zbx_config_timeout,
 							zbx_config_source_ip};
-	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency};
+	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency, 0};
 	zbx_thread_vmware_args			vmware_args = {zbx_config_source_ip, config_vmware_frequency,
 								config_vmware_perf_frequency, config_vmware_timeout};
 	zbx_thread_snmptrapper_args		snmptrapper_args = {zbx_config_snmptrap_file};
@@ -1525,7 +1554,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_database_cache(get_program_type, zbx_sync_proxy_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, config_history_cache_shards, &config_trends_cache_size,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
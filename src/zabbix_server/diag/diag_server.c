@@ -240,6 +240,39 @@ static void	diag_add_lld_items(struct zbx_json *json, const char *field, const z
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add LLD rule processing time top list to output json              *
+ *                                                                            *
+ * Parameters: json  - [OUT] the output json                                  *
+ *             field - [IN] the field name                                    *
+ *             rules - [IN] a top LLD rule list                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_lld_rules(struct zbx_json *json, const char *field, const zbx_vector_lld_rule_stats_t *rules)
+{
+	int	i;
+
+	zbx_json_addarray(json, field);
+
+	for (i = 0; i < rules->values_num; i++)
+	{
+		const zbx_lld_rule_stats_t	*stats = &rules->values[i];
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_adduint64(json, "itemid", stats->itemid);
+		zbx_json_addint64(json, "rows", stats->rows_num);
+		zbx_json_addint64(json, "passed", stats->rows_passed);
+		zbx_json_addfloat(json, "filter_time", stats->filter_time);
+		zbx_json_addfloat(json, "time", stats->time);
+		zbx_json_adduint64(json, "rows_skipped", stats->rows_skipped);
+		zbx_json_adduint64(json, "rows_processed", stats->rows_processed);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add requested lld manager diagnostic information to json data     *
@@ -315,6 +348,24 @@ static int	diag_add_lld_info(const struct zbx_json_parse *jp, struct zbx_json *j
 					diag_add_lld_items(json, map->name, &items);
 					zbx_vector_uint64_pair_destroy(&items);
 				}
+				else if (0 == strcmp(map->name, "time"))
+				{
+					zbx_vector_lld_rule_stats_t	rules;
+
+					zbx_vector_lld_rule_stats_create(&rules);
+
+					time1 = zbx_time();
+					if (FAIL == (ret = zbx_lld_get_top_time(map->value, &rules, error)))
+					{
+						zbx_vector_lld_rule_stats_destroy(&rules);
+						goto out;
+					}
+					time2 = zbx_time();
+					time_total += time2 - time1;
+
+					diag_add_lld_rules(json, map->name, &rules);
+					zbx_vector_lld_rule_stats_destroy(&rules);
+				}
 				else
 				{
 					*error = zbx_dsprintf(*error, "Unsupported top field: %s", map->name);
@@ -545,6 +596,8 @@ int	diag_add_section_info(const char *section, const struct zbx_json_parse *jp,
 		zbx_diag_add_locks_info(json);
 		ret = SUCCEED;
 	}
+	else if (0 == strcmp(section, ZBX_DIAG_CONFIGCACHE))
+		ret = zbx_diag_add_configcache_info(jp, json, error);
 	else if (0 == strcmp(section, ZBX_DIAG_CONNECTOR))
 		ret = zbx_diag_add_connector_info(jp, json, error);
 	else
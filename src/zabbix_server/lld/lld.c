@@ -27,6 +27,8 @@
 #include "zbx_trigger_constants.h"
 #include "zbx_item_constants.h"
 #include "zbxvariant.h"
+#include "zbxtime.h"
+#include "zbxhash.h"
 
 /* lld rule filter condition (item_condition table record) */
 typedef struct
@@ -36,9 +38,32 @@ typedef struct
 	char			*regexp;
 	zbx_vector_expression_t	regexps;
 	unsigned char		op;
+	int			column;		/* index of the macro value in row cache */
+	zbx_regexp_t		*compiled;	/* precompiled regular expression, NULL for global regexps */
 }
 lld_condition_t;
 
+/* macro value extracted from the currently evaluated lld row */
+typedef struct
+{
+	const char	*macro;
+	const char	*path;		/* json path to extract the value or NULL to look up macro by name */
+	char		*value;
+	size_t		value_alloc;
+	zbx_uint64_t	rowid;		/* the row the value was extracted from */
+	int		ret;		/* SUCCEED - the row has value for the macro, FAIL - otherwise */
+}
+lld_row_value_t;
+
+/* lazily extracted macro values of the currently evaluated lld row, shared by filter and override conditions */
+typedef struct
+{
+	zbx_vector_ptr_t		values;
+	const struct zbx_json_parse	*jp_row;
+	zbx_uint64_t			rowid;
+}
+lld_row_cache_t;
+
 ZBX_PTR_VECTOR_IMPL(lld_item_link, zbx_lld_item_link_t*)
 
 ZBX_PTR_VECTOR_IMPL(lld_override, zbx_lld_override_t*)
@@ -54,6 +79,9 @@ ZBX_PTR_VECTOR_IMPL(lld_row, zbx_lld_row_t*)
  ******************************************************************************/
 static void	lld_condition_free(lld_condition_t *condition)
 {
+	if (NULL != condition->compiled)
+		zbx_regexp_free(condition->compiled);
+
 	zbx_regexp_clean_expressions(&condition->regexps);
 	zbx_vector_expression_destroy(&condition->regexps);
 
@@ -98,6 +126,8 @@ static void	lld_filter_init(zbx_lld_filter_t *filter)
 	zbx_vector_ptr_create(&filter->conditions);
 	filter->expression = NULL;
 	filter->evaltype = ZBX_CONDITION_EVAL_TYPE_AND_OR;
+	filter->expression_plan = NULL;
+	zbx_vector_uint64_pair_create(&filter->expression_refs);
 }
 
 /******************************************************************************
@@ -108,6 +138,8 @@ static void	lld_filter_init(zbx_lld_filter_t *filter)
 static void	lld_filter_clean(zbx_lld_filter_t *filter)
 {
 	zbx_free(filter->expression);
+	zbx_free(filter->expression_plan);
+	zbx_vector_uint64_pair_destroy(&filter->expression_refs);
 	lld_conditions_free(&filter->conditions);
 }
 
@@ -121,6 +153,8 @@ static int	lld_filter_condition_add(zbx_vector_ptr_t *conditions, const char *id
 	condition->macro = zbx_strdup(NULL, macro);
 	condition->regexp = zbx_strdup(NULL, regexp);
 	condition->op = (unsigned char)atoi(op);
+	condition->column = -1;
+	condition->compiled = NULL;
 
 	zbx_vector_expression_create(&condition->regexps);
 
@@ -186,26 +220,245 @@ static int	lld_filter_load(zbx_lld_filter_t *filter, zbx_uint64_t lld_ruleid, co
 
 /******************************************************************************
  *                                                                            *
- * Purpose: check if the lld data passes filter evaluation                    *
+ * Purpose: initializes lld row cache                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_cache_init(lld_row_cache_t *cache)
+{
+	zbx_vector_ptr_create(&cache->values);
+	cache->jp_row = NULL;
+	cache->rowid = 0;
+}
+
+static void	lld_row_value_free(lld_row_value_t *row_value)
+{
+	zbx_free(row_value->value);
+	zbx_free(row_value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases resources allocated by lld row cache                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_cache_clean(lld_row_cache_t *cache)
+{
+	zbx_vector_ptr_clear_ext(&cache->values, (zbx_clean_func_t)lld_row_value_free);
+	zbx_vector_ptr_destroy(&cache->values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets lld row to be evaluated, invalidating the cached values      *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_cache_set_row(lld_row_cache_t *cache, const struct zbx_json_parse *jp_row)
+{
+	cache->jp_row = jp_row;
+	cache->rowid++;
+}
+
+/******************************************************************************
  *                                                                            *
- * Parameters: jp_row          - [IN] lld data row                            *
+ * Purpose: gets index of macro value in lld row cache, adding the macro if   *
+ *          necessary                                                         *
+ *                                                                            *
+ * Parameters: cache           - [IN/OUT] lld row cache                       *
  *             lld_macro_paths - [IN] use json path to extract from jp_row    *
- *             condition       - [IN] lld filter condition                    *
- *             result          - [OUT] result of evaluation                   *
- *             err_msg         - [OUT]                                        *
+ *             macro           - [IN] LLD macro                               *
+ *                                                                            *
+ * Return value: index of the macro value in lld row cache                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_row_cache_add_macro(lld_row_cache_t *cache, const zbx_vector_lld_macro_path_t *lld_macro_paths,
+		const char *macro)
+{
+	int			i;
+	lld_row_value_t		*row_value;
+	zbx_lld_macro_path_t	lld_macro_path_local;
+
+	for (i = 0; i < cache->values.values_num; i++)
+	{
+		if (0 == strcmp(((lld_row_value_t *)cache->values.values[i])->macro, macro))
+			return i;
+	}
+
+	row_value = (lld_row_value_t *)zbx_malloc(NULL, sizeof(lld_row_value_t));
+	row_value->macro = macro;
+	row_value->path = NULL;
+	row_value->value = NULL;
+	row_value->value_alloc = 0;
+	row_value->rowid = 0;
+	row_value->ret = FAIL;
+
+	lld_macro_path_local.lld_macro = (char *)macro;
+
+	if (FAIL != (i = zbx_vector_ptr_bsearch((const zbx_vector_ptr_t *)lld_macro_paths, &lld_macro_path_local,
+			zbx_lld_macro_paths_compare)))
+	{
+		row_value->path = lld_macro_paths->values[i]->path;
+	}
+
+	zbx_vector_ptr_append(&cache->values, row_value);
+
+	return cache->values.values_num - 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets macro value of the current lld row, extracting it from row   *
+ *          data on the first request                                         *
+ *                                                                            *
+ * Parameters: cache - [IN/OUT] lld row cache                                 *
+ *             index - [IN] index of the macro value                          *
+ *             value - [OUT] macro value                                      *
+ *                                                                            *
+ * Return value: SUCCEED - the row has value for the macro                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_row_cache_get_value(lld_row_cache_t *cache, int index, const char **value)
+{
+	lld_row_value_t	*row_value = (lld_row_value_t *)cache->values.values[index];
+
+	if (row_value->rowid != cache->rowid)
+	{
+		row_value->rowid = cache->rowid;
+		row_value->ret = FAIL;
+
+		if (NULL != row_value->path)
+		{
+			zbx_free(row_value->value);
+			row_value->value_alloc = 0;
+
+			if (SUCCEED == zbx_jsonpath_query(cache->jp_row, row_value->path, &row_value->value) &&
+					NULL != row_value->value)
+			{
+				row_value->ret = SUCCEED;
+			}
+		}
+		else
+		{
+			zbx_json_type_t	type;
+
+			if (FAIL != zbx_json_value_by_name_dyn(cache->jp_row, row_value->macro, &row_value->value,
+					&row_value->value_alloc, &type) && ZBX_JSON_TYPE_NULL != type)
+			{
+				row_value->ret = SUCCEED;
+			}
+		}
+	}
+
+	*value = row_value->value;
+
+	return row_value->ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces condition references in custom filter expression with    *
+ *          single character placeholders for condition results               *
+ *                                                                            *
+ * Parameters: filter - [IN/OUT] lld filter                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_filter_compile_expression(zbx_lld_filter_t *filter)
+{
+	int		i;
+	char		id[ZBX_MAX_UINT64_LEN + 2];
+	const char	*p;
+	size_t		plan_alloc = 0, plan_offset = 0, pos = 0, id_len;
+
+	for (i = 0; i < filter->conditions.values_num; i++)
+	{
+		const lld_condition_t	*condition = (lld_condition_t *)filter->conditions.values[i];
+
+		id_len = zbx_snprintf(id, sizeof(id), "{" ZBX_FS_UI64 "}", condition->id);
+
+		for (p = strstr(filter->expression, id); NULL != p; p = strstr(p + id_len, id))
+		{
+			zbx_uint64_pair_t	ref = {(zbx_uint64_t)(p - filter->expression), (zbx_uint64_t)i};
+
+			zbx_vector_uint64_pair_append(&filter->expression_refs, ref);
+		}
+	}
+
+	zbx_vector_uint64_pair_sort(&filter->expression_refs, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+
+	for (i = 0; i < filter->expression_refs.values_num; i++)
+	{
+		zbx_uint64_pair_t	*ref = &filter->expression_refs.values[i];
+		const lld_condition_t	*condition = (lld_condition_t *)filter->conditions.values[ref->second];
+
+		zbx_strncpy_alloc(&filter->expression_plan, &plan_alloc, &plan_offset, filter->expression + pos,
+				(size_t)ref->first - pos);
+
+		pos = (size_t)ref->first + zbx_snprintf(id, sizeof(id), "{" ZBX_FS_UI64 "}", condition->id);
+		ref->first = plan_offset;
+
+		zbx_chrcpy_alloc(&filter->expression_plan, &plan_alloc, &plan_offset, '0');
+	}
+
+	zbx_strcpy_alloc(&filter->expression_plan, &plan_alloc, &plan_offset, filter->expression + pos);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares lld filter for evaluating many rows - maps condition     *
+ *          macros to row cache values and precompiles regular expressions    *
+ *          and custom expression                                             *
+ *                                                                            *
+ * Parameters: filter          - [IN/OUT] lld filter                          *
+ *             cache           - [IN/OUT] lld row cache                       *
+ *             lld_macro_paths - [IN] use json path to extract from jp_row    *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_filter_compile(zbx_lld_filter_t *filter, lld_row_cache_t *cache,
+		const zbx_vector_lld_macro_path_t *lld_macro_paths)
+{
+	int	i;
+
+	for (i = 0; i < filter->conditions.values_num; i++)
+	{
+		lld_condition_t	*condition = (lld_condition_t *)filter->conditions.values[i];
+
+		condition->column = lld_row_cache_add_macro(cache, lld_macro_paths, condition->macro);
+
+		if (ZBX_CONDITION_OPERATOR_EXIST != condition->op && ZBX_CONDITION_OPERATOR_NOT_EXIST != condition->op &&
+				'@' != *condition->regexp && '\0' != *condition->regexp)
+		{
+			char	*errmsg = NULL;
+
+			/* invalid regular expression is reported when evaluating rows */
+			if (SUCCEED != zbx_regexp_compile(condition->regexp, &condition->compiled, &errmsg))
+				zbx_free(errmsg);
+		}
+	}
+
+	if (ZBX_CONDITION_EVAL_TYPE_EXPRESSION == filter->evaltype && NULL != filter->expression)
+		lld_filter_compile_expression(filter);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if the lld data passes filter evaluation                    *
+ *                                                                            *
+ * Parameters: cache     - [IN/OUT] lld row cache with the row to evaluate    *
+ *             condition - [IN] lld filter condition                          *
+ *             result    - [OUT] result of evaluation                         *
+ *             err_msg   - [OUT]                                              *
  *                                                                            *
  * Return value: SUCCEED - the lld data passed filter evaluation              *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	filter_condition_match(const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_t *lld_macro_paths, const lld_condition_t *condition, int *result,
+static int	filter_condition_match(lld_row_cache_t *cache, const lld_condition_t *condition, int *result,
 		char **err_msg)
 {
-	char	*value = NULL;
-	int	ret = SUCCEED;
+	const char	*value;
+	int		ret = SUCCEED;
 
-	if (SUCCEED == zbx_lld_macro_value_by_name(jp_row, lld_macro_paths, condition->macro, &value))
+	if (SUCCEED == lld_row_cache_get_value(cache, condition->column, &value))
 	{
 		if (ZBX_CONDITION_OPERATOR_NOT_EXIST == condition->op)
 		{
@@ -217,7 +470,19 @@ static int	filter_condition_match(const struct zbx_json_parse *jp_row,
 		}
 		else
 		{
-			switch (zbx_regexp_match_ex(&condition->regexps, value, condition->regexp, ZBX_CASE_SENSITIVE))
+			int	match;
+
+			if (NULL != condition->compiled)
+			{
+				match = zbx_regexp_match_precompiled2(value, condition->compiled, NULL);
+			}
+			else
+			{
+				match = zbx_regexp_match_ex(&condition->regexps, value, condition->regexp,
+						ZBX_CASE_SENSITIVE);
+			}
+
+			switch (match)
 			{
 				case ZBX_REGEXP_MATCH:
 					*result = (ZBX_CONDITION_OPERATOR_REGEXP == condition->op ? 1 : 0);
@@ -251,8 +516,6 @@ static int	filter_condition_match(const struct zbx_json_parse *jp_row,
 		}
 	}
 
-	zbx_free(value);
-
 	return ret;
 }
 
@@ -260,17 +523,15 @@ static int	filter_condition_match(const struct zbx_json_parse *jp_row,
  *                                                                                      *
  * Purpose: check if the lld data passes filter evaluation by and/or/andor rules        *
  *                                                                                      *
- * Parameters: filter          - [IN] lld filter                                        *
- *             jp_row          - [IN] lld data row                                      *
- *             lld_macro_paths - [IN] use json path to extract from jp_row              *
- *             info            - [OUT] warning description                              *
+ * Parameters: filter - [IN] lld filter                                                 *
+ *             cache  - [IN/OUT] lld row cache with the row to evaluate                 *
+ *             info   - [OUT] warning description                                       *
  *                                                                                      *
  * Return value: SUCCEED - the lld data passed filter evaluation                        *
  *               FAIL    - otherwise                                                    *
  *                                                                                      *
  ****************************************************************************************/
-static int	filter_evaluate_and_or_andor(const zbx_lld_filter_t *filter, const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_t *lld_macro_paths, char **info)
+static int	filter_evaluate_and_or_andor(const zbx_lld_filter_t *filter, lld_row_cache_t *cache, char **info)
 {
 	int			i, ret = SUCCEED, error_num = 0, res;
 	double			result;
@@ -320,7 +581,7 @@ static int	filter_evaluate_and_or_andor(const zbx_lld_filter_t *filter, const st
 				goto out;
 		}
 
-		if (SUCCEED == (ret = filter_condition_match(jp_row, lld_macro_paths, condition, &res, &errmsg)))
+		if (SUCCEED == (ret = filter_condition_match(cache, condition, &res, &errmsg)))
 		{
 			zbx_snprintf_alloc(&expression, &expression_alloc, &expression_offset, "%d", res);
 		}
@@ -360,10 +621,9 @@ out:
  * Purpose: check if the lld data passes filter evaluation by custom          *
  *          expression                                                        *
  *                                                                            *
- * Parameters: filter          - [IN] lld filter                              *
- *             jp_row          - [IN] lld data row                            *
- *             lld_macro_paths - [IN] use json path to extract from jp_row    *
- *             err_msg         - [OUT]                                        *
+ * Parameters: filter  - [IN] lld filter                                      *
+ *             cache   - [IN/OUT] lld row cache with the row to evaluate      *
+ *             err_msg - [OUT]                                                *
  *                                                                            *
  * Return value: SUCCEED - lld data passed filter evaluation                  *
  *               FAIL    - otherwise                                          *
@@ -373,8 +633,7 @@ out:
  *           2) call zbx_evaluate() to calculate the final result             *
  *                                                                            *
  ******************************************************************************/
-static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_t *lld_macro_paths, char **err_msg)
+static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, lld_row_cache_t *cache, char **err_msg)
 {
 	int			i, ret, res, error_num = 0;
 	char			*expression = NULL, id[ZBX_MAX_UINT64_LEN + 2], *p, error[256], value[16],
@@ -396,7 +655,7 @@ static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const stru
 	{
 		const lld_condition_t	*condition = (lld_condition_t *)filter->conditions.values[i];
 
-		if (SUCCEED == filter_condition_match(jp_row, lld_macro_paths, condition, &res, &errmsg))
+		if (SUCCEED == filter_condition_match(cache, condition, &res, &errmsg))
 		{
 			zbx_snprintf(value, sizeof(value), "%d", res);
 		}
@@ -442,33 +701,164 @@ static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const stru
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluate compiled lld filter without building and parsing filter  *
+ *          expression for each row                                           *
+ *                                                                            *
+ * Parameters: filter - [IN] compiled lld filter                              *
+ *             cache  - [IN/OUT] lld row cache with the row to evaluate       *
+ *             result - [OUT] SUCCEED - the lld data passed filter evaluation *
+ *                            FAIL    - otherwise                             *
+ *                                                                            *
+ * Return value: SUCCEED - the filter was evaluated                           *
+ *               FAIL    - the filter result depends on conditions that       *
+ *                         cannot be evaluated, full evaluation is required   *
+ *                         to report errors                                   *
+ *                                                                            *
+ * Comments: conditions are evaluated lazily following ZBX_UNKNOWN rules of   *
+ *           zbx_evaluate() - 'and' with false or 'or' with true operand does *
+ *           not depend on the other operands                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	filter_evaluate_plan(zbx_lld_filter_t *filter, lld_row_cache_t *cache, int *result)
+{
+	int		i, res, unknown = 0;
+	char		*errmsg = NULL, error[256];
+	double		value;
+	lld_condition_t	**conditions = (lld_condition_t **)filter->conditions.values;
+
+	switch (filter->evaltype)
+	{
+		case ZBX_CONDITION_EVAL_TYPE_AND:
+			for (i = 0; i < filter->conditions.values_num; i++)
+			{
+				if (SUCCEED != filter_condition_match(cache, conditions[i], &res, &errmsg))
+				{
+					zbx_free(errmsg);
+					unknown = 1;
+				}
+				else if (0 == res)
+				{
+					*result = FAIL;
+					return SUCCEED;
+				}
+			}
+
+			*result = SUCCEED;
+			break;
+		case ZBX_CONDITION_EVAL_TYPE_OR:
+			for (i = 0; i < filter->conditions.values_num; i++)
+			{
+				if (SUCCEED != filter_condition_match(cache, conditions[i], &res, &errmsg))
+				{
+					zbx_free(errmsg);
+					unknown = 1;
+				}
+				else if (0 != res)
+				{
+					*result = SUCCEED;
+					return SUCCEED;
+				}
+			}
+
+			*result = FAIL;
+			break;
+		case ZBX_CONDITION_EVAL_TYPE_AND_OR:
+			/* conditions are sorted by macro, conditions of the same macro are combined with 'or' */
+			for (i = 0; i < filter->conditions.values_num;)
+			{
+				const char	*macro = conditions[i]->macro;
+				int		group_res = 0, group_unknown = 0;
+
+				for (; i < filter->conditions.values_num && 0 == strcmp(macro, conditions[i]->macro);
+						i++)
+				{
+					if (0 != group_res)
+						continue;
+
+					if (SUCCEED != filter_condition_match(cache, conditions[i], &res, &errmsg))
+					{
+						zbx_free(errmsg);
+						group_unknown = 1;
+					}
+					else
+						group_res = res;
+				}
+
+				if (0 == group_res)
+				{
+					if (0 == group_unknown)
+					{
+						*result = FAIL;
+						return SUCCEED;
+					}
+
+					unknown = 1;
+				}
+			}
+
+			*result = SUCCEED;
+			break;
+		case ZBX_CONDITION_EVAL_TYPE_EXPRESSION:
+			if (NULL == filter->expression_plan)
+				return FAIL;
+
+			for (i = 0; i < filter->expression_refs.values_num; i++)
+			{
+				const zbx_uint64_pair_t	*ref = &filter->expression_refs.values[i];
+
+				if (SUCCEED != filter_condition_match(cache, conditions[ref->second], &res, &errmsg))
+				{
+					zbx_free(errmsg);
+					return FAIL;
+				}
+
+				filter->expression_plan[ref->first] = (0 != res ? '1' : '0');
+			}
+
+			if (SUCCEED != zbx_evaluate(&value, filter->expression_plan, error, sizeof(error), NULL))
+				return FAIL;
+
+			*result = (SUCCEED != zbx_double_compare(value, 0) ? SUCCEED : FAIL);
+			break;
+		default:
+			return FAIL;
+	}
+
+	return 0 == unknown ? SUCCEED : FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: check if the lld data passes filter evaluation                    *
  *                                                                            *
- * Parameters: filter          - [IN] lld filter                              *
- *             jp_row          - [IN] lld data row                            *
- *             lld_macro_paths - [IN] use json path to extract from jp_row    *
- *             info            - [OUT] warning description                    *
+ * Parameters: filter - [IN] compiled lld filter                              *
+ *             cache  - [IN/OUT] lld row cache with the row to evaluate       *
+ *             info   - [OUT] warning description                             *
  *                                                                            *
  * Return value: SUCCEED - the lld data passed filter evaluation              *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	filter_evaluate(const zbx_lld_filter_t *filter, const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_t *lld_macro_paths, char **info)
+static int	filter_evaluate(zbx_lld_filter_t *filter, lld_row_cache_t *cache, char **info)
 {
+	int	result;
+
 	if (0 == filter->conditions.values_num)
 		return SUCCEED;
 
+	if (SUCCEED == filter_evaluate_plan(filter, cache, &result))
+		return result;
+
 	switch (filter->evaltype)
 	{
 		case ZBX_CONDITION_EVAL_TYPE_AND_OR:
 		case ZBX_CONDITION_EVAL_TYPE_AND:
 		case ZBX_CONDITION_EVAL_TYPE_OR:
-			return filter_evaluate_and_or_andor(filter, jp_row, lld_macro_paths, info);
+			return filter_evaluate_and_or_andor(filter, cache, info);
 		case ZBX_CONDITION_EVAL_TYPE_EXPRESSION:
-			return filter_evaluate_expression(filter, jp_row, lld_macro_paths, info);
+			return filter_evaluate_expression(filter, cache, info);
 	}
 
 	return FAIL;
@@ -965,15 +1355,18 @@ int	lld_validate_item_override_no_discover(const zbx_vector_lld_override_t *over
 
 static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_lld_row_t *lld_rows,
 		const zbx_vector_lld_macro_path_t *lld_macro_paths, const zbx_vector_lld_override_t *overrides,
-		char **info, char **error)
+		zbx_lld_rule_stats_t *stats, char **info, char **error)
 {
 	struct zbx_json_parse	jp, jp_array, jp_row;
 	const char		*p;
 	zbx_lld_row_t		*lld_row;
 	int			ret = FAIL, i;
+	lld_row_cache_t		cache;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	lld_row_cache_init(&cache);
+
 	if (SUCCEED != zbx_json_open(value, &jp))
 	{
 		*error = zbx_dsprintf(*error, "Invalid discovery rule value: %s", zbx_json_strerror());
@@ -991,19 +1384,31 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 		goto out;
 	}
 
+	/* compile filter and override conditions once for all rows */
+	lld_filter_compile(filter, &cache, lld_macro_paths);
+
+	for (i = 0; i < overrides->values_num; i++)
+		lld_filter_compile(&overrides->values[i]->filter, &cache, lld_macro_paths);
+
 	p = NULL;
 	while (NULL != (p = zbx_json_next(&jp_array, p)))
 	{
 		if (FAIL == zbx_json_brackets_open(p, &jp_row))
 			continue;
 
-		if (SUCCEED != filter_evaluate(filter, &jp_row, lld_macro_paths, info))
+		stats->rows_num++;
+		lld_row_cache_set_row(&cache, &jp_row);
+
+		if (SUCCEED != filter_evaluate(filter, &cache, info))
 			continue;
 
+		stats->rows_passed++;
+
 		lld_row = (zbx_lld_row_t *)zbx_malloc(NULL, sizeof(zbx_lld_row_t));
 		zbx_vector_lld_row_append(lld_rows, lld_row);
 
 		lld_row->jp_row = jp_row;
+		lld_row->unchanged = 0;
 		zbx_vector_lld_item_link_create(&lld_row->item_links);
 		zbx_vector_lld_override_create(&lld_row->overrides);
 
@@ -1013,7 +1418,7 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 		{
 			zbx_lld_override_t	*override = overrides->values[i];
 
-			if (SUCCEED != filter_evaluate(&override->filter, &jp_row, lld_macro_paths, info))
+			if (SUCCEED != filter_evaluate(&override->filter, &cache, info))
 				continue;
 
 			zbx_vector_lld_override_append(&lld_row->overrides, override);
@@ -1027,6 +1432,8 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 
 	ret = SUCCEED;
 out:
+	lld_row_cache_clean(&cache);
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
 	{
 		for (i = 0; i < lld_rows->values_num; i++)
@@ -1065,24 +1472,336 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
 	zbx_free(lld_row);
 }
 
+static void	lld_md5_append_str(md5_state_t *state, const char *str)
+{
+	unsigned char	is_null = (NULL == str ? 1 : 0);
+
+	zbx_md5_append(state, &is_null, sizeof(is_null));
+
+	if (NULL != str)
+		zbx_md5_append(state, (const md5_byte_t *)str, (int)strlen(str) + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends override operations to fingerprint                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_overrides_md5_append(md5_state_t *state, const zbx_vector_lld_override_t *overrides)
+{
+	int	i, j, k;
+
+	zbx_md5_append(state, (const md5_byte_t *)&overrides->values_num, sizeof(overrides->values_num));
+
+	for (i = 0; i < overrides->values_num; i++)
+	{
+		const zbx_lld_override_t	*override = overrides->values[i];
+
+		zbx_md5_append(state, (const md5_byte_t *)&override->overrideid, sizeof(override->overrideid));
+		zbx_md5_append(state, (const md5_byte_t *)&override->override_operations.values_num,
+				sizeof(override->override_operations.values_num));
+
+		for (j = 0; j < override->override_operations.values_num; j++)
+		{
+			const zbx_lld_override_operation_t	*op = override->override_operations.values[j];
+
+			zbx_md5_append(state, (const md5_byte_t *)&op->override_operationid,
+					sizeof(op->override_operationid));
+			zbx_md5_append(state, &op->operationtype, sizeof(op->operationtype));
+			zbx_md5_append(state, &op->operator, sizeof(op->operator));
+			zbx_md5_append(state, &op->status, sizeof(op->status));
+			zbx_md5_append(state, &op->severity, sizeof(op->severity));
+			zbx_md5_append(state, (const md5_byte_t *)&op->inventory_mode, sizeof(op->inventory_mode));
+			zbx_md5_append(state, &op->discover, sizeof(op->discover));
+			lld_md5_append_str(state, op->value);
+			lld_md5_append_str(state, op->delay);
+			lld_md5_append_str(state, op->history);
+			lld_md5_append_str(state, op->trends);
+
+			zbx_md5_append(state, (const md5_byte_t *)&op->tags.values_num, sizeof(op->tags.values_num));
+
+			for (k = 0; k < op->tags.values_num; k++)
+			{
+				lld_md5_append_str(state, op->tags.values[k]->tag);
+				lld_md5_append_str(state, op->tags.values[k]->value);
+			}
+
+			zbx_md5_append(state, (const md5_byte_t *)&op->templateids.values_num,
+					sizeof(op->templateids.values_num));
+			zbx_md5_append(state, (const md5_byte_t *)op->templateids.values,
+					op->templateids.values_num * (int)sizeof(zbx_uint64_t));
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates fingerprint of discovery rule configuration affecting  *
+ *          processing of discovery rows                                      *
+ *                                                                            *
+ * Parameters: lld_macro_paths - [IN]                                         *
+ *             overrides       - [IN] discovery rule overrides                *
+ *             lifetime        - [IN] lost resource lifetime                  *
+ *             revision        - [IN] configuration cache revision of         *
+ *                                    discovery rule and its prototypes       *
+ *                                                                            *
+ * Return value: The fingerprint, never 0.                                    *
+ *                                                                            *
+ * Comments: Row fingerprints can be compared only while this fingerprint     *
+ *           does not change, so changing configuration forces processing of  *
+ *           all rows.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_rule_fingerprint(const zbx_vector_lld_macro_path_t *lld_macro_paths,
+		const zbx_vector_lld_override_t *overrides, int lifetime, zbx_uint64_t revision)
+{
+	md5_state_t	state;
+	md5_byte_t	digest[ZBX_MD5_DIGEST_SIZE];
+	zbx_uint64_t	fingerprint;
+	int		i;
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, (const md5_byte_t *)&revision, sizeof(revision));
+	zbx_md5_append(&state, (const md5_byte_t *)&lifetime, sizeof(lifetime));
+
+	for (i = 0; i < lld_macro_paths->values_num; i++)
+	{
+		const zbx_lld_macro_path_t	*macro_path = lld_macro_paths->values[i];
+
+		lld_md5_append_str(&state, macro_path->lld_macro);
+		lld_md5_append_str(&state, macro_path->path);
+	}
+
+	lld_overrides_md5_append(&state, overrides);
+
+	zbx_md5_finish(&state, digest);
+	memcpy(&fingerprint, digest, sizeof(fingerprint));
+
+	/* 0 is reserved for 'no fingerprint' */
+	return 0 != fingerprint ? fingerprint : 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates fingerprint of discovery row                           *
+ *                                                                            *
+ * Comments: Besides row contents the fingerprint covers overrides matched    *
+ *           by the row.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_row_fingerprint(const zbx_lld_row_t *lld_row)
+{
+	md5_state_t	state;
+	md5_byte_t	digest[ZBX_MD5_DIGEST_SIZE];
+	zbx_uint64_t	fingerprint;
+	int		i;
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, (const md5_byte_t *)lld_row->jp_row.start,
+			(int)(lld_row->jp_row.end - lld_row->jp_row.start + 1));
+
+	for (i = 0; i < lld_row->overrides.values_num; i++)
+	{
+		zbx_md5_append(&state, (const md5_byte_t *)&lld_row->overrides.values[i]->overrideid,
+				sizeof(lld_row->overrides.values[i]->overrideid));
+	}
+
+	zbx_md5_finish(&state, digest);
+	memcpy(&fingerprint, digest, sizeof(fingerprint));
+
+	return fingerprint;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if row fingerprints of the previous processing can be      *
+ *          compared with current discovery rows                              *
+ *                                                                            *
+ * Parameters: fingerprint - [IN] discovery rule configuration fingerprint    *
+ *             prev        - [IN] fingerprints of the previous processing     *
+ *             state       - [IN] discovery rule state                        *
+ *             lifetime    - [IN] lost resource lifetime                      *
+ *             period      - [IN] how long after processing of all rows       *
+ *                                unchanged rows can be skipped, 0 - never    *
+ *             now         - [IN] current time                                *
+ *                                                                            *
+ * Return value: SUCCEED - unchanged rows can be skipped                      *
+ *               FAIL    - all rows must be processed                         *
+ *                                                                            *
+ * Comments: Skipped rows are processed again after the period to apply      *
+ *           changes of trigger, graph and host prototypes, and after a tenth *
+ *           of lost resource lifetime to limit the delay of lastcheck        *
+ *           updates when processing of the rule is skipped. Lifetime 0       *
+ *           removes lost resources regardless of lastcheck, so then only the *
+ *           period applies.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_rows_fingerprints_valid(zbx_uint64_t fingerprint, const zbx_lld_rule_stats_t *prev,
+		unsigned char state, int lifetime, int period, time_t now)
+{
+	int	max_age = period;
+
+	if (0 == prev->fingerprint || fingerprint != prev->fingerprint)
+		return FAIL;
+
+	/* not supported rule must be processed to update its state */
+	if (ITEM_STATE_NORMAL != state)
+		return FAIL;
+
+	if (0 != lifetime && lifetime / 10 < max_age)
+		max_age = lifetime / 10;
+
+	if (now - prev->fingerprint_clock >= max_age)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds discovery rows that did not change since the previous       *
+ *          processing                                                        *
+ *                                                                            *
+ * Parameters: lld_rows    - [IN/OUT] rows passed through filter, unchanged   *
+ *                                    rows are marked                         *
+ *             fingerprint - [IN] discovery rule configuration fingerprint    *
+ *             state       - [IN] discovery rule state                        *
+ *             lifetime    - [IN] lost resource lifetime                      *
+ *             period      - [IN] how long after processing of all rows       *
+ *                                unchanged rows can be skipped, 0 - never    *
+ *             now         - [IN] current time                                *
+ *             prev        - [IN] fingerprints of the previous processing     *
+ *             stats       - [OUT] fingerprints of this processing and the    *
+ *                                 number of unchanged rows                   *
+ *                                                                            *
+ * Return value: SUCCEED - no rows were changed, added or removed, processing *
+ *                         of the rule can be skipped                         *
+ *               FAIL    - changed rows must be processed                     *
+ *                                                                            *
+ * Comments: Fingerprint time is the time all rows were processed, so that    *
+ *           unchanged rows are processed again when it expires.              *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_rows_diff(zbx_vector_lld_row_t *lld_rows, zbx_uint64_t fingerprint, unsigned char state,
+		int lifetime, int period, time_t now, const zbx_lld_rule_stats_t *prev, zbx_lld_rule_stats_t *stats)
+{
+	int	i, valid;
+
+	stats->fingerprint = fingerprint;
+	stats->fingerprint_clock = (int)now;
+	stats->row_fingerprints_num = lld_rows->values_num;
+	stats->rows_unchanged = 0;
+
+	if (0 != lld_rows->values_num)
+	{
+		stats->row_fingerprints = (zbx_uint64_t *)zbx_malloc(NULL,
+				sizeof(zbx_uint64_t) * (size_t)lld_rows->values_num);
+	}
+
+	for (i = 0; i < lld_rows->values_num; i++)
+		stats->row_fingerprints[i] = lld_row_fingerprint(lld_rows->values[i]);
+
+	if (SUCCEED == (valid = lld_rows_fingerprints_valid(fingerprint, prev, state, lifetime, period, now)))
+	{
+		stats->fingerprint_clock = prev->fingerprint_clock;
+
+		for (i = 0; i < lld_rows->values_num; i++)
+		{
+			if (NULL != bsearch(&stats->row_fingerprints[i], prev->row_fingerprints,
+					(size_t)prev->row_fingerprints_num, sizeof(zbx_uint64_t),
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				lld_rows->values[i]->unchanged = 1;
+				stats->rows_unchanged++;
+			}
+		}
+	}
+
+	if (0 != lld_rows->values_num)
+	{
+		qsort(stats->row_fingerprints, (size_t)lld_rows->values_num, sizeof(zbx_uint64_t),
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	/* the same rows, including duplicates, as during the previous processing */
+	if (SUCCEED == valid && prev->row_fingerprints_num == lld_rows->values_num &&
+			(0 == lld_rows->values_num || 0 == memcmp(stats->row_fingerprints, prev->row_fingerprints,
+			sizeof(zbx_uint64_t) * (size_t)lld_rows->values_num)))
+	{
+		return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resets discovery row fingerprints, forcing processing of all rows *
+ *          next time                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rows_fingerprints_clear(zbx_lld_rule_stats_t *stats)
+{
+	stats->fingerprint = 0;
+	stats->fingerprint_clock = 0;
+	zbx_free(stats->row_fingerprints);
+	stats->row_fingerprints_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: marks all discovery rows as changed or unchanged                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rows_set_unchanged(zbx_vector_lld_row_t *lld_rows, unsigned char unchanged)
+{
+	int	i;
+
+	for (i = 0; i < lld_rows->values_num; i++)
+		lld_rows->values[i]->unchanged = unchanged;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add or update items, triggers and graphs for discovery item       *
  *                                                                            *
- * Parameters: lld_ruleid - [IN] discovery item identifier from database      *
- *             value      - [IN] received value from agent                    *
- *             error      - [OUT] error or informational message. Will be set *
- *                               to empty string on successful discovery      *
- *                               without additional information.              *
+ * Parameters: lld_ruleid            - [IN] discovery item identifier from    *
+ *                                          database                          *
+ *             value                 - [IN] received value from agent or a    *
+ *                                          chunk of its rows                 *
+ *             mode                  - [IN] ZBX_LLD_PROCESS_FULL,             *
+ *                                          ZBX_LLD_PROCESS_CHUNK or          *
+ *                                          ZBX_LLD_PROCESS_RECONCILE         *
+ *             skip_unchanged_period - [IN] how long after processing of all  *
+ *                                          rows unchanged rows can be        *
+ *                                          skipped, 0 - never                *
+ *             prev                  - [IN] fingerprints of the previous      *
+ *                                          processing                        *
+ *             stats                 - [OUT] processing statistics            *
+ *             error                 - [OUT] error or informational message.  *
+ *                                          Will be set to empty string on    *
+ *                                          successful discovery without      *
+ *                                          additional information.           *
+ *                                                                            *
+ * Comments: Entities discovered from rows that did not change since the      *
+ *           previous processing are kept without updating them, while lost   *
+ *           resources are still found using all rows. If no rows changed the *
+ *           rule is not processed further.                                   *
+ *           A chunk of rows only creates and updates items, triggers and     *
+ *           graphs. Reconciliation after all chunks matches them with all    *
+ *           rows like unchanged ones to find lost resources and processes    *
+ *           host prototypes.                                                 *
  *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, unsigned char mode,
+		int skip_unchanged_period, const zbx_lld_rule_stats_t *prev, zbx_lld_rule_stats_t *stats,
+		char **error)
 {
 	zbx_db_result_t			result;
 	zbx_db_row_t			row;
 	zbx_uint64_t			hostid;
 	char				*discovery_key = NULL, *info = NULL;
-	int				lifetime, ret = SUCCEED, errcode;
+	int				lifetime, lastcheck, ret = SUCCEED, errcode;
 	zbx_vector_lld_macro_path_t	lld_macro_paths;
 	zbx_lld_filter_t		filter;
 	time_t				now;
@@ -1091,6 +1810,8 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	zbx_dc_um_handle_t		*um_handle;
 	zbx_vector_lld_override_t	overrides;
 	zbx_vector_lld_row_t		lld_rows;
+	double				time_start;
+	zbx_uint64_t			revision;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
 
@@ -1111,6 +1832,9 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 		goto out;
 	}
 
+	/* get revision before reading configuration, so that concurrent changes force the next processing */
+	revision = zbx_dc_get_lld_rule_revision(lld_ruleid);
+
 	result = zbx_db_select(
 			"select hostid,key_,evaltype,formula,lifetime"
 			" from items"
@@ -1162,44 +1886,94 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	if (SUCCEED != (ret = lld_overrides_load(&overrides, lld_ruleid, &item, error)))
 		goto out;
 
-	if (SUCCEED != lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &overrides, &info, error))
+	time_start = zbx_time();
+	ret = lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &overrides, stats, &info, error);
+	stats->filter_time = zbx_time() - time_start;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() rows:%d passed:%d filter time:" ZBX_FS_DBL " sec", __func__,
+			stats->rows_num, stats->rows_passed, stats->filter_time);
+
+	if (SUCCEED != ret)
+		goto out;
+
+	now = time(NULL);
+
+	/* fingerprints of all rows are found by reconciliation */
+	if (ZBX_LLD_PROCESS_CHUNK != mode && SUCCEED == lld_rows_diff(&lld_rows,
+			lld_rule_fingerprint(&lld_macro_paths, &overrides, lifetime, revision), item.state, lifetime,
+			skip_unchanged_period, now, prev, stats))
 	{
-		ret = FAIL;
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() discovery data did not change, skipping processing", __func__);
+
+		/* keep the informational message of the last processing */
+		*error = zbx_strdup(*error, ZBX_NULL2EMPTY_STR(item.error));
+
+		stats->skipped = 1;
 		goto out;
 	}
 
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() unchanged rows:%d", __func__, stats->rows_unchanged);
+
 	*error = zbx_strdup(*error, "");
 
-	now = time(NULL);
+	if (ZBX_LLD_PROCESS_CHUNK == mode)
+	{
+		lastcheck = ZBX_LLD_LASTCHECK_CHUNK;
+	}
+	else
+	{
+		lastcheck = (int)now;
+
+		/* entities were created and updated by chunks, only match them with rows */
+		if (ZBX_LLD_PROCESS_RECONCILE == mode)
+			lld_rows_set_unchanged(&lld_rows, 1);
+	}
 
 	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_AUDITLOG_ENABLED);
 	zbx_audit_init(cfg.auditlog_enabled);
 
-	if (SUCCEED != lld_update_items(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
+	if (SUCCEED != lld_update_items(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime,
+			lastcheck))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add items because parent host was removed while"
 				" processing lld rule");
+		lld_rows_fingerprints_clear(stats);
 		goto out;
 	}
 
 	lld_item_links_sort(&lld_rows);
 
-	if (SUCCEED != lld_update_triggers(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
+	if (SUCCEED != lld_update_triggers(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime,
+			lastcheck))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add triggers because parent host was removed while"
 				" processing lld rule");
+		lld_rows_fingerprints_clear(stats);
 		goto out;
 	}
 
-	if (SUCCEED != lld_update_graphs(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
+	if (SUCCEED != lld_update_graphs(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime,
+			lastcheck))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add graphs because parent host was removed while"
 				" processing lld rule");
+		lld_rows_fingerprints_clear(stats);
 		goto out;
 	}
 
+	/* host prototypes are processed with all rows */
+	if (ZBX_LLD_PROCESS_CHUNK == mode)
+		goto out;
+
+	if (ZBX_LLD_PROCESS_RECONCILE == mode)
+		lld_rows_set_unchanged(&lld_rows, 0);
+
 	lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now);
 
+	/* entities that failed to be created or updated must be retried with the next value */
+	if ('\0' != **error)
+		lld_rows_fingerprints_clear(stats);
+
 	/* add informative warning to the error message about lack of data for macros used in filter */
 	if (NULL != info)
 		*error = zbx_strdcat(*error, info);
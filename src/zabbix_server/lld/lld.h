@@ -24,6 +24,7 @@
 #include "zbxjson.h"
 #include "zbxdbhigh.h"
 #include "zbxcacheconfig.h"
+#include "lld_manager.h"
 
 typedef struct
 {
@@ -37,9 +38,15 @@ ZBX_PTR_VECTOR_DECL(lld_item_link, zbx_lld_item_link_t*)
 /* lld rule filter */
 typedef struct
 {
-	zbx_vector_ptr_t	conditions;
-	char			*expression;
-	int			evaltype;
+	zbx_vector_ptr_t		conditions;
+	char				*expression;
+	int				evaltype;
+
+	/* custom expression with condition references replaced by single character placeholders */
+	char				*expression_plan;
+
+	/* placeholder offset, condition index pairs of the compiled custom expression */
+	zbx_vector_uint64_pair_t	expression_refs;
 }
 zbx_lld_filter_t;
 
@@ -61,6 +68,10 @@ typedef struct
 	struct zbx_json_parse		jp_row;
 	zbx_vector_lld_item_link_t	item_links;	/* the list of item prototypes */
 	zbx_vector_lld_override_t	overrides;
+
+	/* 1 if the row and overrides it matches did not change since the previous processing, */
+	/* entities discovered from unchanged rows are kept without updating them              */
+	unsigned char			unchanged;
 }
 zbx_lld_row_t;
 
@@ -319,12 +330,17 @@ void	lld_update_hosts(zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_t *lld_r
 
 int	lld_end_of_life(int lastcheck, int lifetime);
 
+/* lastcheck of entities discovered from a chunk of rows, their lost resources are found by reconciliation */
+#define ZBX_LLD_LASTCHECK_CHUNK	0
+
 typedef void	(*delete_ids_f)(zbx_vector_uint64_t *ids);
 typedef void	(*get_object_info_f)(const void *object, zbx_uint64_t *id, int *discovered, int *lastcheck,
 		int *ts_delete, const char **name);
 void	lld_remove_lost_objects(const char *table, const char *id_name, const zbx_vector_ptr_t *objects,
 		int lifetime, int lastcheck, delete_ids_f cb, get_object_info_f cb_info);
 
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error);
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, unsigned char mode,
+		int skip_unchanged_period, const zbx_lld_rule_stats_t *prev, zbx_lld_rule_stats_t *stats,
+		char **error);
 
 #endif
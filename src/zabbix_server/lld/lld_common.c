@@ -50,6 +50,9 @@ int	lld_end_of_life(int lastcheck, int lifetime)
  *                                                                            *
  * Purpose: updates lastcheck and ts_delete fields; removes lost resources    *
  *                                                                            *
+ * Comments: Objects discovered from a chunk of rows are not updated, because *
+ *           lost resources can be found only with all rows.                  *
+ *                                                                            *
  ******************************************************************************/
 void	lld_remove_lost_objects(const char *table, const char *id_name, const zbx_vector_ptr_t *objects,
 		int lifetime, int lastcheck, delete_ids_f cb, get_object_info_f cb_info)
@@ -62,7 +65,7 @@ void	lld_remove_lost_objects(const char *table, const char *id_name, const zbx_v
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (0 == objects->values_num)
+	if (0 == objects->values_num || ZBX_LLD_LASTCHECK_CHUNK == lastcheck)
 		goto out;
 
 	zbx_vector_uint64_create(&del_ids);
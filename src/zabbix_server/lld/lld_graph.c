@@ -686,7 +686,24 @@ static void	lld_graph_make(const zbx_vector_ptr_t *gitems_proto, zbx_vector_ptr_
 	else if (SUCCEED != lld_item_get(ymax_itemid_proto, items, &lld_row->item_links, &ymax_itemid))
 		goto out;
 
-	if (NULL != (graph = lld_graph_get(graphs, &lld_row->item_links)))
+	if (NULL != (graph = lld_graph_get(graphs, &lld_row->item_links)) && 0 != lld_row->unchanged)
+	{
+		int	i;
+
+		/* existing graph discovered from lld row that did not change is kept as is */
+		lld_override_graph(&lld_row->overrides, graph->name, &discover_proto);
+
+		if (ZBX_PROTOTYPE_NO_DISCOVER == discover_proto)
+			goto out;
+
+		for (i = 0; i < graph->gitems.values_num; i++)
+			((zbx_lld_gitem_t *)graph->gitems.values[i])->flags |= ZBX_FLAG_LLD_GITEM_DISCOVERED;
+
+		graph->flags |= ZBX_FLAG_LLD_GRAPH_DISCOVERED;
+		goto out;
+	}
+
+	if (NULL != graph)
 	{
 		char	*buffer = zbx_strdup(NULL, name_proto);
 
@@ -995,16 +995,19 @@ static zbx_lld_host_t	*lld_host_make(zbx_vector_ptr_t *hosts, const char *host_p
 			host->flags |= ZBX_FLAG_LLD_HOST_UPDATE_CUSTOM_INTERFACES;
 		}
 
-		/* host visible name */
-		buffer = zbx_strdup(buffer, name_proto);
-		zbx_substitute_lld_macros(&buffer, &lld_row->jp_row, lld_macros, ZBX_MACRO_ANY, NULL, 0);
-		zbx_lrtrim(buffer, ZBX_WHITESPACE);
-		if (0 != strcmp(host->name, buffer))
+		/* host visible name, kept as is for lld row that did not change */
+		if (0 == lld_row->unchanged)
 		{
-			host->name_orig = host->name;
-			host->name = buffer;
-			buffer = NULL;
-			host->flags |= ZBX_FLAG_LLD_HOST_UPDATE_NAME;
+			buffer = zbx_strdup(buffer, name_proto);
+			zbx_substitute_lld_macros(&buffer, &lld_row->jp_row, lld_macros, ZBX_MACRO_ANY, NULL, 0);
+			zbx_lrtrim(buffer, ZBX_WHITESPACE);
+			if (0 != strcmp(host->name, buffer))
+			{
+				host->name_orig = host->name;
+				host->name = buffer;
+				buffer = NULL;
+				host->flags |= ZBX_FLAG_LLD_HOST_UPDATE_NAME;
+			}
 		}
 
 		host->flags |= ZBX_FLAG_LLD_HOST_DISCOVERED;
@@ -1012,7 +1015,8 @@ static zbx_lld_host_t	*lld_host_make(zbx_vector_ptr_t *hosts, const char *host_p
 
 	host->jp_row = &lld_row->jp_row;
 
-	if (0 != (host->flags & ZBX_FLAG_LLD_HOST_DISCOVERED))
+	/* tags of existing host discovered from lld row that did not change are kept as is */
+	if (0 != (host->flags & ZBX_FLAG_LLD_HOST_DISCOVERED) && (0 == host->hostid || 0 == lld_row->unchanged))
 	{
 		zbx_db_tag_t	*db_tag;
 
@@ -1048,12 +1052,12 @@ static zbx_lld_host_t	*lld_host_make(zbx_vector_ptr_t *hosts, const char *host_p
 		/* sort existing tags by their ids for update operations */
 		zbx_vector_db_tag_ptr_sort(&host->tags, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
 		zbx_vector_db_tag_ptr_clear_ext(&new_tags, zbx_db_tag_free);
+	}
 
-		if (0 != lnk_templateids.values_num)
-		{
-			zbx_vector_uint64_append_array(&host->lnk_templateids, lnk_templateids.values,
-					lnk_templateids.values_num);
-		}
+	if (0 != (host->flags & ZBX_FLAG_LLD_HOST_DISCOVERED) && 0 != lnk_templateids.values_num)
+	{
+		zbx_vector_uint64_append_array(&host->lnk_templateids, lnk_templateids.values,
+				lnk_templateids.values_num);
 	}
 out:
 	zbx_vector_db_tag_ptr_destroy(&new_tags);
@@ -2424,9 +2424,17 @@ static void	lld_items_make(const zbx_vector_ptr_t *item_prototypes, zbx_vector_l
 				item_index_local.item = item;
 				zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
 			}
+			else if (0 != item_index_local.lld_row->unchanged)
+			{
+				/* matching already checked that overrides do not prevent discovery */
+				item_index->item->flags |= ZBX_FLAG_LLD_ITEM_DISCOVERED;
+				item_index->item->lld_row = item_index_local.lld_row;
+			}
 			else
+			{
 				lld_item_update(item_prototype, item_index_local.lld_row, lld_macro_paths,
 						item_index->item, error);
+			}
 		}
 	}
 
@@ -2435,6 +2443,20 @@ static void	lld_items_make(const zbx_vector_ptr_t *item_prototypes, zbx_vector_l
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d items", __func__, items->values_num);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if existing item was discovered from lld row that did not  *
+ *          change since the previous processing and must be kept as is       *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_item_unchanged(const zbx_lld_item_full_t *item)
+{
+	if (0 == item->itemid || 0 == item->lld_row->unchanged)
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: escaping of symbols in items preprocessing steps for discovery    *
@@ -2546,6 +2568,14 @@ static void	lld_items_preproc_make(const zbx_vector_ptr_t *item_prototypes,
 		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED))
 			continue;
 
+		if (SUCCEED == lld_item_unchanged(item))
+		{
+			for (j = 0; j < item->preproc_ops.values_num; j++)
+				item->preproc_ops.values[j]->flags |= ZBX_FLAG_LLD_ITEM_PREPROC_DISCOVERED;
+
+			continue;
+		}
+
 		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
 				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
 		{
@@ -2666,7 +2696,7 @@ static void	lld_items_param_make(const zbx_vector_ptr_t *item_prototypes,
 	{
 		zbx_lld_item_full_t	*item = items->values[i];
 
-		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED))
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED) || SUCCEED == lld_item_unchanged(item))
 			continue;
 
 		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
@@ -2733,7 +2763,7 @@ static void	lld_items_tags_make(const zbx_vector_ptr_t *item_prototypes,
 	{
 		zbx_lld_item_full_t	*item = items->values[i];
 
-		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED))
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED) || SUCCEED == lld_item_unchanged(item))
 			continue;
 
 		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
@@ -27,6 +27,7 @@
 #include "lld_protocol.h"
 #include "zbxstr.h"
 #include "zbxtime.h"
+#include "zbxjson.h"
 
 /*
  * The LLD queue is organized as a queue (rule_queue binary heap) of LLD rules,
@@ -41,8 +42,26 @@
  * values in the list the rule is removed from the index (rule_index hashset),
  * otherwise the rule is enqueued back in LLD queue.
  *
+ * To keep cheap LLD rules from waiting behind expensive ones the queue position
+ * of a rule is postponed by the last processing time of the rule owning its
+ * oldest value. An expensive rule is delayed by its own processing time at most,
+ * so it cannot be starved by a flow of cheap rules.
+ *
+ * Values of the same host are processed sequentially, because processing of host's
+ * LLD rules updates the same host's entities. A value with many rows, processed
+ * without fingerprints of the previous processing, is split into chunks of rows that
+ * are sent to free workers in parallel. Chunks only create and update items,
+ * triggers and graphs. After all chunks are processed the whole value is sent to
+ * the worker that processed the last chunk to reconcile - match the entities with
+ * all rows to find lost resources and process host prototypes, which can be done
+ * only with the complete rule data. Only then the value is removed from the list.
+ *
  */
 
+/* the minimum number of rows in a chunk, so that the gain of parallel processing */
+/* outweighs loading of all discovery rule entities by every chunk                */
+#define LLD_CHUNK_ROWS_MIN	1000
+
 typedef struct
 {
 	/* workers vector, created during manager initialization */
@@ -60,12 +79,17 @@ typedef struct
 	/* index of queued LLD rules */
 	zbx_hashset_t		rule_index;
 
-	/* LLD rule queue, ordered by the oldest values */
+	/* LLD rule queue, ordered by the oldest values postponed by the expected processing time */
 	zbx_binary_heap_t	rule_queue;
 
 	/* the number of queued LLD rules */
 	zbx_uint64_t		queued_num;
 
+	/* processing statistics of LLD rules, indexed by LLD rule item id */
+	zbx_hashset_t		rule_stats;
+
+	/* how long after full processing unchanged discovery data can be skipped, 0 - never skip */
+	int			skip_unchanged_period;
 }
 zbx_lld_manager_t;
 
@@ -95,6 +119,16 @@ static int	worker_compare_func(const void *d1, const void *d2)
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns time in milliseconds the LLD rule is ordered by in queue  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_rule_queue_time(const zbx_lld_rule_t *rule)
+{
+	return (zbx_uint64_t)rule->head->ts.sec * 1000 + (zbx_uint64_t)(rule->head->ts.ns / 1000000) + rule->cost;
+}
+
 /* rule_queue binary heap support */
 static int	rule_elem_compare_func(const void *d1, const void *d2)
 {
@@ -104,7 +138,9 @@ static int	rule_elem_compare_func(const void *d1, const void *d2)
 	const zbx_lld_rule_t	*rule1 = (const zbx_lld_rule_t *)e1->data;
 	const zbx_lld_rule_t	*rule2 = (const zbx_lld_rule_t *)e2->data;
 
-	/* compare by timestamp of the oldest value */
+	/* compare by timestamp of the oldest value, postponed by the expected processing time */
+	ZBX_RETURN_IF_NOT_EQUAL(lld_rule_queue_time(rule1), lld_rule_queue_time(rule2));
+
 	return zbx_timespec_compare(&rule1->head->ts, &rule2->head->ts);
 }
 
@@ -120,6 +156,19 @@ static void	lld_data_free(zbx_lld_data_t *data)
 	zbx_free(data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees chunks of LLD value rows                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_chunks_free(zbx_lld_chunks_t *chunks)
+{
+	zbx_vector_str_clear_ext(&chunks->values, zbx_str_free);
+	zbx_vector_str_destroy(&chunks->values);
+	zbx_free(chunks->error);
+	zbx_free(chunks);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: clears LLD rule                                                   *
@@ -135,6 +184,19 @@ static void	lld_rule_clear(zbx_lld_rule_t *rule)
 		rule->head = data->next;
 		lld_data_free(data);
 	}
+
+	if (NULL != rule->chunks)
+		lld_chunks_free(rule->chunks);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: clears LLD rule processing statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rule_stats_clear(zbx_lld_rule_stats_t *rule_stats)
+{
+	zbx_free(rule_stats->row_fingerprints);
 }
 
 /******************************************************************************
@@ -152,7 +214,8 @@ static void	lld_worker_free(zbx_lld_worker_t *worker)
  * Purpose: initializes LLD manager                                           *
  *                                                                            *
  ******************************************************************************/
-static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f get_config_forks_cb)
+static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f get_config_forks_cb,
+		int skip_unchanged_period)
 {
 	int			i;
 	zbx_lld_worker_t	*worker;
@@ -169,6 +232,11 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 
 	zbx_binary_heap_create(&manager->rule_queue, rule_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
 
+	zbx_hashset_create_ext(&manager->rule_stats, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			(zbx_clean_func_t)lld_rule_stats_clear,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	manager->skip_unchanged_period = skip_unchanged_period;
+
 	manager->next_worker_index = 0;
 
 	for (i = 0; i < get_config_forks_cb(ZBX_PROCESS_TYPE_LLDWORKER); i++)
@@ -194,6 +262,7 @@ static void	lld_manager_destroy(zbx_lld_manager_t *manager)
 {
 	zbx_binary_heap_destroy(&manager->rule_queue);
 	zbx_hashset_destroy(&manager->rule_index);
+	zbx_hashset_destroy(&manager->rule_stats);
 	zbx_queue_ptr_destroy(&manager->free_workers);
 	zbx_hashset_destroy(&manager->workers_client);
 	zbx_vector_ptr_clear_ext(&manager->workers, (zbx_clean_func_t)lld_worker_free);
@@ -279,6 +348,15 @@ static void	lld_register_worker(zbx_lld_manager_t *manager, zbx_ipc_client_t *cl
 static void	lld_queue_rule(zbx_lld_manager_t *manager, zbx_lld_rule_t *rule)
 {
 	zbx_binary_heap_elem_t	elem = {rule->hostid, rule};
+	zbx_lld_rule_stats_t	*rule_stats;
+
+	if (NULL != (rule_stats = (zbx_lld_rule_stats_t *)zbx_hashset_search(&manager->rule_stats,
+			&rule->head->itemid)))
+	{
+		rule->cost = rule_stats->full_time_ms;
+	}
+	else
+		rule->cost = 0;
 
 	zbx_binary_heap_insert(&manager->rule_queue, &elem);
 }
@@ -351,6 +429,122 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes JSON array of chunk rows and adds it to chunks             *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_chunks_add(zbx_lld_chunks_t *chunks, char **value, size_t *value_alloc, size_t *value_offset)
+{
+	if (0 == *value_offset)
+		zbx_chrcpy_alloc(value, value_alloc, value_offset, '[');
+
+	zbx_chrcpy_alloc(value, value_alloc, value_offset, ']');
+	zbx_vector_str_append(&chunks->values, *value);
+
+	*value = NULL;
+	*value_alloc = 0;
+	*value_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: splits LLD value rows into chunks to be processed by several      *
+ *          workers                                                           *
+ *                                                                            *
+ * Parameters: data        - [IN] LLD value                                   *
+ *             workers_num - [IN] the number of LLD workers                   *
+ *                                                                            *
+ * Return value: The chunks of rows or NULL if the value must be processed by *
+ *               one worker.                                                  *
+ *                                                                            *
+ * Comments: There are not more chunks than workers. Values that cannot be    *
+ *           parsed are not split, so that their errors are reported by       *
+ *           processing them as a whole.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_lld_chunks_t	*lld_data_split(const zbx_lld_data_t *data, int workers_num)
+{
+	struct zbx_json_parse	jp, jp_array, jp_row;
+	const char		*p;
+	zbx_lld_chunks_t	*chunks;
+	char			*value = NULL;
+	size_t			value_alloc = 0, value_offset = 0;
+	int			i, rows_num = 0, chunks_num, chunk_rows_num;
+
+	if (NULL != data->error || NULL == data->value || SUCCEED != zbx_json_open(data->value, &jp))
+		return NULL;
+
+	if ('[' == *jp.start)
+		jp_array = jp;
+	else if (SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_array))	/* deprecated */
+		return NULL;
+
+	for (p = NULL; NULL != (p = zbx_json_next(&jp_array, p));)
+		rows_num++;
+
+	if (2 > (chunks_num = MIN(workers_num, rows_num / LLD_CHUNK_ROWS_MIN)))
+		return NULL;
+
+	chunk_rows_num = (rows_num + chunks_num - 1) / chunks_num;
+
+	chunks = (zbx_lld_chunks_t *)zbx_malloc(NULL, sizeof(zbx_lld_chunks_t));
+	zbx_vector_str_create(&chunks->values);
+	zbx_vector_str_reserve(&chunks->values, (size_t)chunks_num);
+	chunks->sent_num = 0;
+	chunks->done_num = 0;
+	chunks->error = NULL;
+	chunks->filter_time = 0;
+	chunks->time = 0;
+
+	for (p = NULL, i = 0; NULL != (p = zbx_json_next(&jp_array, p)); i++)
+	{
+		if (0 != i && 0 == i % chunk_rows_num)
+			lld_chunks_add(chunks, &value, &value_alloc, &value_offset);
+
+		/* rows that are not objects are ignored by discovery */
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+			continue;
+
+		zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, 0 == value_offset ? '[' : ',');
+		zbx_strncpy_alloc(&value, &value_alloc, &value_offset, jp_row.start,
+				(size_t)(jp_row.end - jp_row.start + 1));
+	}
+
+	lld_chunks_add(chunks, &value, &value_alloc, &value_offset);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "split %d rows of discovery rule:" ZBX_FS_UI64 " into %d chunks", rows_num,
+			data->itemid, chunks->values.values_num);
+
+	return chunks;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends LLD value to worker                                         *
+ *                                                                            *
+ * Parameters: worker                - [IN] target worker                     *
+ *             data                  - [IN] LLD value                         *
+ *             mode                  - [IN] ZBX_LLD_PROCESS_FULL or           *
+ *                                          ZBX_LLD_PROCESS_RECONCILE         *
+ *             chunks_error          - [IN] errors of processed chunks        *
+ *             skip_unchanged_period - [IN]                                   *
+ *             rule_stats            - [IN] fingerprints of the previous      *
+ *                                          processing, NULL for none         *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_send_task(zbx_lld_worker_t *worker, const zbx_lld_data_t *data, unsigned char mode,
+		const char *chunks_error, int skip_unchanged_period, const zbx_lld_rule_stats_t *rule_stats)
+{
+	unsigned char	*buf;
+	zbx_uint32_t	buf_len;
+
+	buf_len = zbx_lld_serialize_task(&buf, data->itemid, data->value, &data->ts, data->meta, data->lastlogsize,
+			data->mtime, data->error, mode, chunks_error, skip_unchanged_period, rule_stats);
+	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
+	zbx_free(buf);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes next LLD request from queue                             *
@@ -364,17 +558,49 @@ static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_
 	zbx_binary_heap_elem_t	*elem;
 	unsigned char		*buf;
 	zbx_uint32_t		buf_len;
+	zbx_lld_rule_t		*rule;
 	zbx_lld_data_t		*data;
+	zbx_lld_rule_stats_t	*rule_stats = NULL;
 
 	elem = zbx_binary_heap_find_min(&manager->rule_queue);
-	worker->rule = (zbx_lld_rule_t *)elem->data;
+	rule = (zbx_lld_rule_t *)elem->data;
 	zbx_binary_heap_remove_min(&manager->rule_queue);
 
-	data = worker->rule->head;
-	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
-			data->lastlogsize, data->mtime, data->error);
-	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
+	worker->rule = rule;
+	data = rule->head;
+
+	if (NULL == rule->chunks)
+	{
+		/* allow worker to skip unchanged discovery rows only within the configured period after full */
+		/* processing                                                                                  */
+		if (0 != manager->skip_unchanged_period && NULL != (rule_stats =
+				(zbx_lld_rule_stats_t *)zbx_hashset_search(&manager->rule_stats, &data->itemid)) &&
+				time(NULL) - rule_stats->fingerprint_clock >= manager->skip_unchanged_period)
+		{
+			rule_stats = NULL;
+		}
+
+		/* without fingerprints all rows are processed, so large values are split among workers */
+		if (NULL == rule_stats)
+			rule->chunks = lld_data_split(data, manager->workers.values_num);
+
+		if (NULL == rule->chunks)
+		{
+			lld_send_task(worker, data, ZBX_LLD_PROCESS_FULL, NULL, manager->skip_unchanged_period,
+					rule_stats);
+			return;
+		}
+	}
+
+	buf_len = zbx_lld_serialize_chunk(&buf, data->itemid, rule->chunks->values.values[rule->chunks->sent_num]);
+	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_CHUNK, buf, buf_len);
 	zbx_free(buf);
+
+	zbx_free(rule->chunks->values.values[rule->chunks->sent_num]);
+
+	/* the remaining chunks are taken by the next free workers */
+	if (++rule->chunks->sent_num < rule->chunks->values.values_num)
+		lld_queue_rule(manager, rule);
 }
 
 /******************************************************************************
@@ -395,15 +621,95 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates LLD rule processing statistics                            *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             message - [IN] worker's 'done' response                        *
+ *             chunks  - [IN] processed chunks of value rows, NULL if the     *
+ *                            value was processed by one worker               *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_update_rule_stats(zbx_lld_manager_t *manager, const zbx_ipc_message_t *message,
+		const zbx_lld_chunks_t *chunks)
+{
+	zbx_lld_rule_stats_t	stats, *rule_stats;
+
+	zbx_lld_deserialize_rule_stats(message->data, &stats);
+	stats.lastclock = (int)time(NULL);
+
+	if (NULL != chunks)
+	{
+		stats.filter_time += chunks->filter_time;
+		stats.time += chunks->time;
+
+		/* rows that failed to be processed in chunks must be processed again */
+		if (NULL != chunks->error)
+		{
+			stats.fingerprint = 0;
+			stats.fingerprint_clock = 0;
+			zbx_free(stats.row_fingerprints);
+			stats.row_fingerprints_num = 0;
+		}
+	}
+
+	if (NULL == (rule_stats = (zbx_lld_rule_stats_t *)zbx_hashset_search(&manager->rule_stats, &stats)))
+	{
+		stats.rows_skipped = 0;
+		stats.rows_processed = 0;
+		stats.full_time_ms = 0;
+		rule_stats = (zbx_lld_rule_stats_t *)zbx_hashset_insert(&manager->rule_stats, &stats, sizeof(stats));
+	}
+	else
+	{
+		stats.rows_skipped = rule_stats->rows_skipped;
+		stats.rows_processed = rule_stats->rows_processed;
+		stats.full_time_ms = rule_stats->full_time_ms;
+		zbx_free(rule_stats->row_fingerprints);
+		*rule_stats = stats;
+	}
+
+	/* skipped processing time does not show the cost of processing changed data */
+	if (0 == rule_stats->skipped)
+		rule_stats->full_time_ms = (zbx_uint64_t)(rule_stats->time * 1000);
+
+	rule_stats->rows_skipped += (zbx_uint64_t)rule_stats->rows_unchanged;
+	rule_stats->rows_processed += (zbx_uint64_t)(rule_stats->rows_passed - rule_stats->rows_unchanged);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes statistics of LLD rules not processed for a day           *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             now     - [IN] current time                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_cleanup_rule_stats(zbx_lld_manager_t *manager, int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_lld_rule_stats_t	*rule_stats;
+
+	zbx_hashset_iter_reset(&manager->rule_stats, &iter);
+	while (NULL != (rule_stats = (zbx_lld_rule_stats_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (rule_stats->lastclock < now - SEC_PER_DAY)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes LLD worker 'done' response                              *
  *                                                                            *
  * Parameters: manager - [IN]                                                 *
- * Parameters: client  - [IN] worker's IPC client connection                  *
+ *             client  - [IN] worker's IPC client connection                  *
+ *             message - [IN] received message                                *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
 	zbx_lld_worker_t	*worker;
 	zbx_lld_rule_t		*rule;
@@ -418,6 +724,14 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 	rule = worker->rule;
 	worker->rule = NULL;
 
+	lld_update_rule_stats(manager, message, rule->chunks);
+
+	if (NULL != rule->chunks)
+	{
+		lld_chunks_free(rule->chunks);
+		rule->chunks = NULL;
+	}
+
 	data = rule->head;
 	rule->head = rule->head->next;
 
@@ -442,6 +756,61 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes LLD worker 'chunk done' response                        *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             client  - [IN] worker's IPC client connection                  *
+ *             message - [IN] received message                                *
+ *                                                                            *
+ * Comments: After the last chunk is processed the value is sent to the same  *
+ *           worker for reconciliation.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_process_chunk_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
+{
+	zbx_lld_worker_t	*worker;
+	zbx_lld_chunks_t	*chunks;
+	zbx_lld_rule_stats_t	stats;
+	char			*error;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	worker = lld_get_worker_by_client(manager, client);
+	chunks = worker->rule->chunks;
+
+	zbx_lld_deserialize_chunk_result(message->data, &stats, &error);
+
+	chunks->filter_time += stats.filter_time;
+	chunks->time += stats.time;
+
+	if (NULL != error && '\0' != *error)
+		chunks->error = zbx_strdcat(chunks->error, error);
+
+	zbx_free(error);
+	zbx_free(stats.row_fingerprints);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "discovery rule:" ZBX_FS_UI64 " chunk has been processed, %d of %d done",
+			worker->rule->head->itemid, chunks->done_num + 1, chunks->values.values_num);
+
+	if (++chunks->done_num == chunks->values.values_num)
+	{
+		lld_send_task(worker, worker->rule->head, ZBX_LLD_PROCESS_RECONCILE, chunks->error, 0, NULL);
+		goto out;
+	}
+
+	worker->rule = NULL;
+
+	if (SUCCEED != zbx_binary_heap_empty(&manager->rule_queue))
+		lld_process_next_request(manager, worker);
+	else
+		zbx_queue_ptr_push(&manager->free_workers, worker);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes external diagnostic statistics request                  *
@@ -537,6 +906,69 @@ static void	lld_process_top_items(zbx_lld_manager_t *manager, zbx_ipc_client_t *
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sort LLD rule statistics by processing time in descending order   *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_diag_rule_compare_time_desc(const void *d1, const void *d2)
+{
+	const zbx_lld_rule_stats_t	*s1 = *(const zbx_lld_rule_stats_t * const *)d1;
+	const zbx_lld_rule_stats_t	*s2 = *(const zbx_lld_rule_stats_t * const *)d2;
+
+	if (s1->time > s2->time)
+		return -1;
+
+	if (s1->time < s2->time)
+		return 1;
+
+	ZBX_RETURN_IF_NOT_EQUAL(s1->itemid, s2->itemid);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes external top LLD rules by processing time request       *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             client  - [IN] connected IPC client                            *
+ *             message - [IN] received message                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_process_top_time(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
+{
+	int			limit;
+	unsigned char		*data;
+	zbx_uint32_t		data_len;
+	zbx_vector_ptr_t	view;
+	zbx_hashset_iter_t	iter;
+	zbx_lld_rule_stats_t	*rule_stats;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_lld_deserialize_top_items_request(message->data, &limit);
+
+	zbx_vector_ptr_create(&view);
+	zbx_vector_ptr_reserve(&view, (size_t)manager->rule_stats.num_data);
+
+	zbx_hashset_iter_reset(&manager->rule_stats, &iter);
+	while (NULL != (rule_stats = (zbx_lld_rule_stats_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_ptr_append(&view, rule_stats);
+
+	zbx_vector_ptr_sort(&view, lld_diag_rule_compare_time_desc);
+
+	data_len = zbx_lld_serialize_top_time_result(&data, (const zbx_lld_rule_stats_t **)view.values,
+			MIN(limit, view.values_num));
+	zbx_ipc_client_send(client, ZBX_IPC_LLD_TOP_TIME_RESULT, data, data_len);
+
+	zbx_free(data);
+	zbx_vector_ptr_destroy(&view);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: main processing loop                                              *
@@ -551,7 +983,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 	char			*error = NULL;
 	zbx_ipc_client_t	*client;
 	zbx_ipc_message_t	*message;
-	double			time_stat, time_now, sec, time_idle = 0;
+	double			time_stat, time_now, sec, time_idle = 0, time_cleanup;
 	zbx_lld_manager_t	manager;
 	zbx_uint64_t		processed_num = 0;
 	int			ret;
@@ -575,10 +1007,11 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
-	lld_manager_init(&manager, args_in->get_process_forks_cb_arg);
+	lld_manager_init(&manager, args_in->get_process_forks_cb_arg, args_in->skip_unchanged_period);
 
 	/* initialize statistics */
 	time_stat = zbx_time();
+	time_cleanup = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -600,6 +1033,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 			processed_num = 0;
 		}
 
+		if (SEC_PER_HOUR < time_now - time_cleanup)
+		{
+			lld_cleanup_rule_stats(&manager, (int)time_now);
+			time_cleanup = time_now;
+		}
+
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 		ret = zbx_ipc_service_recv(&lld_service, &timeout, &client, &message);
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
@@ -622,10 +1061,13 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
+					lld_process_result(&manager, client, message);
 					processed_num++;
 					manager.queued_num--;
 					break;
+				case ZBX_IPC_LLD_CHUNK_DONE:
+					lld_process_chunk_result(&manager, client, message);
+					break;
 				case ZBX_IPC_LLD_QUEUE:
 					zbx_ipc_client_send(client, message->code, (unsigned char *)&manager.queued_num,
 							sizeof(zbx_uint64_t));
@@ -636,6 +1078,9 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 				case ZBX_IPC_LLD_TOP_ITEMS:
 					lld_process_top_items(&manager, client, message);
 					break;
+				case ZBX_IPC_LLD_TOP_TIME:
+					lld_process_top_time(&manager, client, message);
+					break;
 			}
 
 			zbx_ipc_message_free(message);
@@ -21,8 +21,16 @@
 #define ZABBIX_LLD_MANAGER_H
 
 #include "zbxthreads.h"
+#include "zbxalgo.h"
 #include "zbxtime.h"
 
+/* discovery rule value processing modes */
+#define ZBX_LLD_PROCESS_FULL		0	/* all rows are processed by one worker                      */
+#define ZBX_LLD_PROCESS_CHUNK		1	/* a part of rows is processed without lost resources and    */
+						/* host prototypes                                           */
+#define ZBX_LLD_PROCESS_RECONCILE	2	/* entities created from chunks are matched with all rows to */
+						/* process lost resources, host prototypes are processed     */
+
 typedef struct zbx_lld_value
 {
 	/* the LLD rule id */
@@ -40,20 +48,46 @@ typedef struct zbx_lld_value
 }
 zbx_lld_data_t;
 
+/* rows of a large value split into chunks processed in parallel by several workers */
+typedef struct
+{
+	/* chunks of rows as JSON arrays */
+	zbx_vector_str_t	values;
+
+	/* the number of chunks sent to workers and processed by workers */
+	int			sent_num;
+	int			done_num;
+
+	/* errors of processed chunks, NULL if there were none */
+	char			*error;
+
+	/* the time spent on processing chunks */
+	double			filter_time;
+	double			time;
+}
+zbx_lld_chunks_t;
+
 /* queue of values for one host */
 typedef struct
 {
 	/* the LLD rule host id */
-	zbx_uint64_t	hostid;
+	zbx_uint64_t		hostid;
 
 	/* the number of queued values */
-	int		values_num;
+	int			values_num;
 
 	/* the newest value in queue */
-	zbx_lld_data_t	*tail;
+	zbx_lld_data_t		*tail;
 
 	/* the oldest value in queue */
-	zbx_lld_data_t	*head;
+	zbx_lld_data_t		*head;
+
+	/* the last full processing time of the oldest value's LLD rule in milliseconds, */
+	/* used to postpone expensive rules in favor of cheap ones                       */
+	zbx_uint64_t		cost;
+
+	/* chunks of the oldest value's rows, NULL if the value is processed by one worker */
+	zbx_lld_chunks_t	*chunks;
 }
 zbx_lld_rule_t;
 
@@ -67,9 +101,56 @@ typedef struct
 }
 zbx_lld_rule_info_t;
 
+/* LLD rule processing statistics */
+typedef struct
+{
+	/* the LLD rule item id */
+	zbx_uint64_t	itemid;
+
+	/* the number of received rows and rows passing the filter */
+	int		rows_num;
+	int		rows_passed;
+
+	/* the time of the last processing */
+	int		lastclock;
+
+	/* 1 if no discovery rows changed and the rule was not processed further, 0 otherwise */
+	int		skipped;
+
+	/* the number of rows passing the filter that did not change since the previous processing */
+	int		rows_unchanged;
+
+	/* fingerprint of discovery rule configuration, sorted fingerprints of discovery rows of the last */
+	/* successful processing and the time all rows were processed, 0 fingerprint forces processing   */
+	/* of all rows                                                                                  */
+	zbx_uint64_t	fingerprint;
+	zbx_uint64_t	*row_fingerprints;
+	int		row_fingerprints_num;
+	int		fingerprint_clock;
+
+	/* the number of unchanged discovery rows skipped and changed rows processed since LLD manager start */
+	zbx_uint64_t	rows_skipped;
+	zbx_uint64_t	rows_processed;
+
+	/* the time spent on parsing rows and evaluating filter and overrides */
+	double		filter_time;
+
+	/* the total processing time */
+	double		time;
+
+	/* the total processing time of the last processing that was not skipped, in milliseconds */
+	zbx_uint64_t	full_time_ms;
+}
+zbx_lld_rule_stats_t;
+
+ZBX_VECTOR_DECL(lld_rule_stats, zbx_lld_rule_stats_t)
+
 typedef struct
 {
 	zbx_get_config_forks_f	get_process_forks_cb_arg;
+
+	/* how long after processing of all rows unchanged discovery rows can be skipped, 0 - never skip */
+	int			skip_unchanged_period;
 }
 zbx_thread_lld_manager_args;
 
@@ -23,6 +23,8 @@
 #include "zbxipcservice.h"
 #include "zbxsysinfo.h"
 
+ZBX_VECTOR_IMPL(lld_rule_stats, zbx_lld_rule_stats_t)
+
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
 		const char *error)
@@ -61,11 +63,12 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 	return data_len;
 }
 
-void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
-		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
-		char **error)
+static zbx_uint32_t	lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid,
+		zbx_uint64_t *hostid, char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize,
+		int *mtime, char **error)
 {
-	zbx_uint32_t	value_len, error_len;
+	zbx_uint32_t		value_len, error_len;
+	const unsigned char	*start = data;
 
 	data += zbx_deserialize_value(data, itemid);
 	data += zbx_deserialize_value(data, hostid);
@@ -76,8 +79,147 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 	if (0 != *meta)
 	{
 		data += zbx_deserialize_value(data, lastlogsize);
-		(void)zbx_deserialize_value(data, mtime);
+		data += zbx_deserialize_value(data, mtime);
+	}
+
+	return (zbx_uint32_t)(data - start);
+}
+
+void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
+		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
+		char **error)
+{
+	(void)lld_deserialize_item_value(data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes discovery rule and row fingerprints                    *
+ *                                                                            *
+ * Parameters: ptr   - [OUT] buffer, NULL to calculate required size only     *
+ *             stats - [IN] fingerprints, NULL for none                       *
+ *                                                                            *
+ * Return value: The number of bytes serialized.                              *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	lld_serialize_fingerprints(unsigned char *ptr, const zbx_lld_rule_stats_t *stats)
+{
+	zbx_uint64_t	fingerprint = 0;
+	int		fingerprint_clock = 0, row_fingerprints_num = 0;
+	zbx_uint32_t	row_fingerprints_len, data_len = 0;
+
+	if (NULL != stats)
+	{
+		fingerprint = stats->fingerprint;
+		fingerprint_clock = stats->fingerprint_clock;
+		row_fingerprints_num = stats->row_fingerprints_num;
+	}
+
+	row_fingerprints_len = (zbx_uint32_t)(sizeof(zbx_uint64_t) * (size_t)row_fingerprints_num);
+
+	zbx_serialize_prepare_value(data_len, fingerprint);
+	zbx_serialize_prepare_value(data_len, fingerprint_clock);
+	zbx_serialize_prepare_value(data_len, row_fingerprints_num);
+	data_len += row_fingerprints_len;
+
+	if (NULL == ptr)
+		return data_len;
+
+	ptr += zbx_serialize_value(ptr, fingerprint);
+	ptr += zbx_serialize_value(ptr, fingerprint_clock);
+	ptr += zbx_serialize_value(ptr, row_fingerprints_num);
+
+	if (0 != row_fingerprints_num)
+		memcpy(ptr, stats->row_fingerprints, row_fingerprints_len);
+
+	return data_len;
+}
+
+static zbx_uint32_t	lld_deserialize_fingerprints(const unsigned char *data, zbx_lld_rule_stats_t *stats)
+{
+	const unsigned char	*start = data;
+	zbx_uint32_t		row_fingerprints_len;
+
+	data += zbx_deserialize_value(data, &stats->fingerprint);
+	data += zbx_deserialize_value(data, &stats->fingerprint_clock);
+	data += zbx_deserialize_value(data, &stats->row_fingerprints_num);
+
+	if (0 != stats->row_fingerprints_num)
+	{
+		row_fingerprints_len = (zbx_uint32_t)(sizeof(zbx_uint64_t) * (size_t)stats->row_fingerprints_num);
+		stats->row_fingerprints = (zbx_uint64_t *)zbx_malloc(NULL, row_fingerprints_len);
+		memcpy(stats->row_fingerprints, data, row_fingerprints_len);
+		data += row_fingerprints_len;
 	}
+	else
+		stats->row_fingerprints = NULL;
+
+	return (zbx_uint32_t)(data - start);
+}
+
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, zbx_uint64_t itemid, const char *value,
+		const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error,
+		unsigned char mode, const char *chunks_error, int skip_unchanged_period,
+		const zbx_lld_rule_stats_t *stats)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len, task_len = 0, chunks_error_len;
+
+	data_len = zbx_lld_serialize_item_value(data, itemid, 0, value, ts, meta, lastlogsize, mtime, error);
+
+	zbx_serialize_prepare_value(task_len, mode);
+	zbx_serialize_prepare_str(task_len, chunks_error);
+	zbx_serialize_prepare_value(task_len, skip_unchanged_period);
+	task_len += lld_serialize_fingerprints(NULL, stats);
+
+	*data = (unsigned char *)zbx_realloc(*data, data_len + task_len);
+
+	ptr = *data + data_len;
+	ptr += zbx_serialize_value(ptr, mode);
+	ptr += zbx_serialize_str(ptr, chunks_error, chunks_error_len);
+	ptr += zbx_serialize_value(ptr, skip_unchanged_period);
+	(void)lld_serialize_fingerprints(ptr, stats);
+
+	return data_len + task_len;
+}
+
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_uint64_t *itemid, char **value, zbx_timespec_t *ts,
+		unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error, unsigned char *mode,
+		char **chunks_error, int *skip_unchanged_period, zbx_lld_rule_stats_t *stats)
+{
+	zbx_uint64_t	hostid;
+	zbx_uint32_t	chunks_error_len;
+
+	data += lld_deserialize_item_value(data, itemid, &hostid, value, ts, meta, lastlogsize, mtime, error);
+	data += zbx_deserialize_value(data, mode);
+	data += zbx_deserialize_str(data, chunks_error, chunks_error_len);
+	data += zbx_deserialize_value(data, skip_unchanged_period);
+	(void)lld_deserialize_fingerprints(data, stats);
+}
+
+zbx_uint32_t	zbx_lld_serialize_chunk(unsigned char **data, zbx_uint64_t itemid, const char *value)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, value_len;
+
+	zbx_serialize_prepare_value(data_len, itemid);
+	zbx_serialize_prepare_str(data_len, value);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, itemid);
+	(void)zbx_serialize_str(ptr, value, value_len);
+
+	return data_len;
+}
+
+void	zbx_lld_deserialize_chunk(const unsigned char *data, zbx_uint64_t *itemid, char **value)
+{
+	zbx_uint32_t	value_len;
+
+	data += zbx_deserialize_value(data, itemid);
+	(void)zbx_deserialize_str(data, value, value_len);
 }
 
 zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num)
@@ -172,6 +314,144 @@ static void	zbx_lld_deserialize_top_items_result(const unsigned char *data, zbx_
 	}
 }
 
+zbx_uint32_t	zbx_lld_serialize_rule_stats(unsigned char **data, const zbx_lld_rule_stats_t *stats)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0;
+
+	zbx_serialize_prepare_value(data_len, stats->itemid);
+	zbx_serialize_prepare_value(data_len, stats->rows_num);
+	zbx_serialize_prepare_value(data_len, stats->rows_passed);
+	zbx_serialize_prepare_value(data_len, stats->filter_time);
+	zbx_serialize_prepare_value(data_len, stats->time);
+	zbx_serialize_prepare_value(data_len, stats->skipped);
+	zbx_serialize_prepare_value(data_len, stats->rows_unchanged);
+	data_len += lld_serialize_fingerprints(NULL, stats);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, stats->itemid);
+	ptr += zbx_serialize_value(ptr, stats->rows_num);
+	ptr += zbx_serialize_value(ptr, stats->rows_passed);
+	ptr += zbx_serialize_value(ptr, stats->filter_time);
+	ptr += zbx_serialize_value(ptr, stats->time);
+	ptr += zbx_serialize_value(ptr, stats->skipped);
+	ptr += zbx_serialize_value(ptr, stats->rows_unchanged);
+	(void)lld_serialize_fingerprints(ptr, stats);
+
+	return data_len;
+}
+
+static zbx_uint32_t	lld_deserialize_rule_stats(const unsigned char *data, zbx_lld_rule_stats_t *stats)
+{
+	const unsigned char	*start = data;
+
+	data += zbx_deserialize_value(data, &stats->itemid);
+	data += zbx_deserialize_value(data, &stats->rows_num);
+	data += zbx_deserialize_value(data, &stats->rows_passed);
+	data += zbx_deserialize_value(data, &stats->filter_time);
+	data += zbx_deserialize_value(data, &stats->time);
+	data += zbx_deserialize_value(data, &stats->skipped);
+	data += zbx_deserialize_value(data, &stats->rows_unchanged);
+	data += lld_deserialize_fingerprints(data, stats);
+
+	return (zbx_uint32_t)(data - start);
+}
+
+void	zbx_lld_deserialize_rule_stats(const unsigned char *data, zbx_lld_rule_stats_t *stats)
+{
+	(void)lld_deserialize_rule_stats(data, stats);
+}
+
+zbx_uint32_t	zbx_lld_serialize_chunk_result(unsigned char **data, const zbx_lld_rule_stats_t *stats,
+		const char *error)
+{
+	zbx_uint32_t	data_len, error_len, result_len = 0;
+
+	data_len = zbx_lld_serialize_rule_stats(data, stats);
+
+	zbx_serialize_prepare_str(result_len, error);
+
+	*data = (unsigned char *)zbx_realloc(*data, data_len + result_len);
+	(void)zbx_serialize_str(*data + data_len, error, error_len);
+
+	return data_len + result_len;
+}
+
+void	zbx_lld_deserialize_chunk_result(const unsigned char *data, zbx_lld_rule_stats_t *stats, char **error)
+{
+	zbx_uint32_t	error_len;
+
+	data += lld_deserialize_rule_stats(data, stats);
+	(void)zbx_deserialize_str(data, error, error_len);
+}
+
+zbx_uint32_t	zbx_lld_serialize_top_time_result(unsigned char **data, const zbx_lld_rule_stats_t **rule_stats,
+		int num)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, rule_len = 0;
+	int		i;
+
+	if (0 != num)
+	{
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->itemid);
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->rows_num);
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->rows_passed);
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->filter_time);
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->time);
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->rows_skipped);
+		zbx_serialize_prepare_value(rule_len, rule_stats[0]->rows_processed);
+	}
+
+	zbx_serialize_prepare_value(data_len, num);
+	data_len += rule_len * num;
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, num);
+
+	for (i = 0; i < num; i++)
+	{
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->itemid);
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->rows_num);
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->rows_passed);
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->filter_time);
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->time);
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->rows_skipped);
+		ptr += zbx_serialize_value(ptr, rule_stats[i]->rows_processed);
+	}
+
+	return data_len;
+}
+
+static void	zbx_lld_deserialize_top_time_result(const unsigned char *data, zbx_vector_lld_rule_stats_t *rules)
+{
+	int	i, rules_num;
+
+	data += zbx_deserialize_value(data, &rules_num);
+
+	if (0 != rules_num)
+	{
+		zbx_vector_lld_rule_stats_reserve(rules, (size_t)rules_num);
+
+		for (i = 0; i < rules_num; i++)
+		{
+			zbx_lld_rule_stats_t	stats = {0};
+
+			data += zbx_deserialize_value(data, &stats.itemid);
+			data += zbx_deserialize_value(data, &stats.rows_num);
+			data += zbx_deserialize_value(data, &stats.rows_passed);
+			data += zbx_deserialize_value(data, &stats.filter_time);
+			data += zbx_deserialize_value(data, &stats.time);
+			data += zbx_deserialize_value(data, &stats.rows_skipped);
+			data += zbx_deserialize_value(data, &stats.rows_processed);
+			zbx_vector_lld_rule_stats_append_ptr(rules, &stats);
+		}
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: enqueue low level discovery value/error                           *
@@ -345,3 +625,37 @@ out:
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the top N LLD rules by the last processing time               *
+ *                                                                            *
+ * Parameters limit - [IN] number of top records to retrieve                  *
+ *            rules - [OUT] vector of top LLD rule processing statistics      *
+ *            error - [OUT] error message                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the top n rules were returned successfully         *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_lld_get_top_time(int limit, zbx_vector_lld_rule_stats_t *rules, char **error)
+{
+	int		ret;
+	unsigned char	*data, *result;
+	zbx_uint32_t	data_len;
+
+	data_len = zbx_lld_serialize_top_items_request(&data, limit);
+
+	if (SUCCEED != (ret = zbx_ipc_async_exchange(ZBX_IPC_SERVICE_LLD, ZBX_IPC_LLD_TOP_TIME, SEC_PER_MIN, data,
+			data_len, &result, error)))
+	{
+		goto out;
+	}
+
+	zbx_lld_deserialize_top_time_result(result, rules);
+	zbx_free(result);
+out:
+	zbx_free(data);
+
+	return ret;
+}
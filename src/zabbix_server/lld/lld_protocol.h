@@ -29,9 +29,11 @@
 /* poller -> manager */
 #define ZBX_IPC_LLD_REGISTER		1000
 #define ZBX_IPC_LLD_DONE		1001
+#define ZBX_IPC_LLD_CHUNK_DONE		1002
 
 /* manager -> poller */
 #define ZBX_IPC_LLD_TASK		1100
+#define ZBX_IPC_LLD_CHUNK		1101
 
 /* manager -> poller */
 #define ZBX_IPC_LLD_REQUEST		1200
@@ -51,6 +53,12 @@
 /* manager -> process */
 #define ZBX_IPC_LLD_TOP_ITEMS_RESULT	1403
 
+/* process -> manager */
+#define ZBX_IPC_LLD_TOP_TIME		1404
+
+/* manager -> process */
+#define ZBX_IPC_LLD_TOP_TIME_RESULT	1405
+
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
 		const char *error);
@@ -59,6 +67,19 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
 		char **error);
 
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, zbx_uint64_t itemid, const char *value,
+		const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error,
+		unsigned char mode, const char *chunks_error, int skip_unchanged_period,
+		const zbx_lld_rule_stats_t *stats);
+
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_uint64_t *itemid, char **value, zbx_timespec_t *ts,
+		unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error, unsigned char *mode,
+		char **chunks_error, int *skip_unchanged_period, zbx_lld_rule_stats_t *stats);
+
+zbx_uint32_t	zbx_lld_serialize_chunk(unsigned char **data, zbx_uint64_t itemid, const char *value);
+
+void	zbx_lld_deserialize_chunk(const unsigned char *data, zbx_uint64_t *itemid, char **value);
+
 zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num);
 
 void	zbx_lld_deserialize_top_items_request(const unsigned char *data, int *limit);
@@ -66,6 +87,18 @@ void	zbx_lld_deserialize_top_items_request(const unsigned char *data, int *limit
 zbx_uint32_t	zbx_lld_serialize_top_items_result(unsigned char **data, const zbx_lld_rule_info_t **rule_infos,
 		int num);
 
+zbx_uint32_t	zbx_lld_serialize_rule_stats(unsigned char **data, const zbx_lld_rule_stats_t *stats);
+
+void	zbx_lld_deserialize_rule_stats(const unsigned char *data, zbx_lld_rule_stats_t *stats);
+
+zbx_uint32_t	zbx_lld_serialize_chunk_result(unsigned char **data, const zbx_lld_rule_stats_t *stats,
+		const char *error);
+
+void	zbx_lld_deserialize_chunk_result(const unsigned char *data, zbx_lld_rule_stats_t *stats, char **error);
+
+zbx_uint32_t	zbx_lld_serialize_top_time_result(unsigned char **data, const zbx_lld_rule_stats_t **rule_stats,
+		int num);
+
 void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *value, const zbx_timespec_t *ts,
 		unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error);
 
@@ -78,4 +111,6 @@ int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, ch
 
 int	zbx_lld_get_top_items(int limit, zbx_vector_uint64_pair_t *items, char **error);
 
+int	zbx_lld_get_top_time(int limit, zbx_vector_lld_rule_stats_t *rules, char **error);
+
 #endif
@@ -1347,13 +1347,32 @@ static void 	lld_trigger_make(const zbx_lld_trigger_prototype_t *trigger_prototy
 	const char			*operation_msg;
 	const struct zbx_json_parse	*jp_row = &lld_row->jp_row;
 	unsigned char			discover;
-	int				func_num;
+	int				func_num, i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	trigger = lld_trigger_get(trigger_prototype->triggerid, items_triggers, &lld_row->item_links);
 	operation_msg = NULL != trigger ? "update" : "create";
 
+	/* existing trigger discovered from lld row that did not change is kept as is */
+	if (NULL != trigger && 0 != lld_row->unchanged)
+	{
+		unsigned char	priority = trigger->priority;
+
+		discover = trigger_prototype->discover;
+		lld_override_trigger(&lld_row->overrides, trigger->description, &priority, &trigger->override_tags,
+				NULL, &discover);
+
+		if (ZBX_PROTOTYPE_NO_DISCOVER == discover)
+			goto out;
+
+		for (i = 0; i < trigger->functions.values_num; i++)
+			((zbx_lld_function_t *)trigger->functions.values[i])->flags = ZBX_FLAG_LLD_FUNCTION_DISCOVERED;
+
+		trigger->flags |= ZBX_FLAG_LLD_TRIGGER_DISCOVERED;
+		goto out;
+	}
+
 	if (NULL == (expression = lld_eval_get_expanded_expression(&trigger_prototype->eval_ctx, jp_row, lld_macros,
 			err, sizeof(err))) ||
 			NULL == (recovery_expression = lld_eval_get_expanded_expression(&trigger_prototype->eval_ctx_r,
@@ -1892,6 +1911,10 @@ static void 	lld_trigger_tag_make(const zbx_lld_trigger_prototype_t *trigger_pro
 	if (NULL == (trigger = lld_trigger_get(trigger_prototype->triggerid, items_triggers, &lld_row->item_links)))
 		goto out;
 
+	/* tags of existing trigger discovered from lld row that did not change are kept as is */
+	if (0 != lld_row->unchanged && 0 != trigger->triggerid)
+		goto out;
+
 	zbx_vector_db_tag_ptr_create(&new_tags);
 
 	for (i = 0; i < trigger_prototype->tags.values_num; i++)
@@ -48,28 +48,87 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
 	zbx_ipc_socket_write(socket, ZBX_IPC_LLD_REGISTER, (unsigned char *)&ppid, sizeof(ppid));
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if error message has the line                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_error_has_line(const char *error, const char *line, size_t line_len)
+{
+	const char	*p = error;
+
+	do
+	{
+		if (0 == strncmp(p, line, line_len) && ('\0' == p[line_len] || '\n' == p[line_len]))
+			return SUCCEED;
+	}
+	while (NULL != (p = strchr(p, '\n')) && '\0' != *(++p));
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds errors of processed chunks to discovery rule error           *
+ *                                                                            *
+ * Parameters: error        - [IN/OUT] discovery rule error                   *
+ *             chunks_error - [IN] errors of chunks                           *
+ *                                                                            *
+ * Comments: Reconciliation retries creating entities that failed to be       *
+ *           created in chunks, so repeated error lines are added once.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_add_chunks_error(char **error, const char *chunks_error)
+{
+	const char	*line, *next;
+	size_t		line_len;
+
+	for (line = chunks_error; '\0' != *line; line = next)
+	{
+		if (NULL == (next = strchr(line, '\n')))
+			next = line + strlen(line);
+
+		line_len = (size_t)(next - line);
+
+		if ('\n' == *next)
+			next++;
+
+		if (0 != line_len && SUCCEED != lld_error_has_line(*error, line, line_len))
+			*error = zbx_strdcatf(*error, "%.*s\n", (int)line_len, line);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes lld task and updates rule state/error in configuration  *
  *          cache and database                                                *
  *                                                                            *
  * Parameters: message - [IN] message with LLD request                        *
+ *             stats   - [OUT] LLD rule processing statistics                 *
+ *                                                                            *
+ * Comments: The fingerprints of the previous rule processing sent by manager *
+ *           are passed to discovery, which returns new ones in statistics.   *
+ *           When value rows were processed in chunks the errors of chunks    *
+ *           are added to the rule error.                                     *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(zbx_ipc_message_t *message)
+static void	lld_process_task(zbx_ipc_message_t *message, zbx_lld_rule_stats_t *stats)
 {
-	zbx_uint64_t		itemid, hostid, lastlogsize;
-	char			*value, *error;
+	zbx_uint64_t		itemid, lastlogsize;
+	char			*value, *error, *chunks_error;
 	zbx_timespec_t		ts;
 	zbx_item_diff_t		diff;
 	zbx_dc_item_t		item;
-	int			errcode, mtime;
-	unsigned char		state, meta;
+	zbx_lld_rule_stats_t	prev;
+	int			errcode, mtime, skip_unchanged_period;
+	unsigned char		state, meta, mode;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_lld_deserialize_item_value(message->data, &itemid, &hostid, &value, &ts, &meta, &lastlogsize, &mtime,
-			&error);
+	zbx_lld_deserialize_task(message->data, &itemid, &value, &ts, &meta, &lastlogsize, &mtime, &error, &mode,
+			&chunks_error, &skip_unchanged_period, &prev);
+
+	stats->itemid = itemid;
 
 	zbx_dc_config_get_items_by_itemids(&item, &itemid, &errcode, 1);
 
@@ -82,11 +141,15 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 
 	if (NULL != error || NULL != value)
 	{
-		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
+		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, mode, skip_unchanged_period,
+				&prev, stats, &error))
 			state = ITEM_STATE_NORMAL;
 		else
 			state = ITEM_STATE_NOTSUPPORTED;
 
+		if (NULL != chunks_error && NULL != error)
+			lld_add_chunks_error(&error, chunks_error);
+
 		if (state != item.state)
 		{
 			diff.state = state;
@@ -161,12 +224,47 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 
 	zbx_dc_config_clean_items(&item, &errcode, 1);
 out:
+	zbx_free(prev.row_fingerprints);
+	zbx_free(chunks_error);
 	zbx_free(value);
 	zbx_free(error);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes chunk of discovery rule value rows                      *
+ *                                                                            *
+ * Parameters: message - [IN] message with chunk of rows                      *
+ *             stats   - [OUT] chunk processing statistics                    *
+ *             error   - [OUT] errors of chunk processing                     *
+ *                                                                            *
+ * Comments: Rule state and error are updated by reconciliation after all     *
+ *           chunks are processed.                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_process_chunk(zbx_ipc_message_t *message, zbx_lld_rule_stats_t *stats, char **error)
+{
+	zbx_uint64_t		itemid;
+	char			*value;
+	zbx_lld_rule_stats_t	prev = {0};
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_lld_deserialize_chunk(message->data, &itemid, &value);
+
+	stats->itemid = itemid;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "processing chunk of discovery rule:" ZBX_FS_UI64, itemid);
+
+	(void)lld_process_discovery_rule(itemid, value, ZBX_LLD_PROCESS_CHUNK, 0, &prev, stats, error);
+
+	zbx_free(value);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 ZBX_THREAD_ENTRY(lld_worker_thread, args)
 {
 	char			*error = NULL;
@@ -178,6 +276,10 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 	int			server_num = ((zbx_thread_args_t *)args)->info.server_num;
 	int			process_num = ((zbx_thread_args_t *)args)->info.process_num;
 	unsigned char		process_type = ((zbx_thread_args_t *)args)->info.process_type;
+	zbx_lld_rule_stats_t	stats;
+	unsigned char		*data;
+	zbx_uint32_t		data_len;
+	char			*chunk_error;
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
 			server_num, get_process_type_string(process_type), process_num);
@@ -234,10 +336,27 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				memset(&stats, 0, sizeof(stats));
+				lld_process_task(&message, &stats);
+				stats.time = zbx_time() - time_read;
+
+				data_len = zbx_lld_serialize_rule_stats(&data, &stats);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, data, data_len);
+				zbx_free(data);
+				zbx_free(stats.row_fingerprints);
 				processed_num++;
 				break;
+			case ZBX_IPC_LLD_CHUNK:
+				memset(&stats, 0, sizeof(stats));
+				chunk_error = NULL;
+				lld_process_chunk(&message, &stats, &chunk_error);
+				stats.time = zbx_time() - time_read;
+
+				data_len = zbx_lld_serialize_chunk_result(&data, &stats, chunk_error);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_CHUNK_DONE, data, data_len);
+				zbx_free(data);
+				zbx_free(chunk_error);
+				break;
 		}
 
 		zbx_ipc_message_clean(&message);
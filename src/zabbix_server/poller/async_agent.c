@@ -16,10 +16,13 @@
 ** along with this program; if not, write to the Free Software
 ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 **/
+
 #include "async_agent.h"
 #include "zbxcommon.h"
 #include "zbxcomms.h"
 #include "zbxip.h"
+#include "zbxjson.h"
+#include "zbxnix.h"
 #include "zbxself.h"
 #include "zbxsysinfo.h"
 #include "async_poller.h"
@@ -53,9 +56,243 @@ static zbx_async_task_state_t	get_task_state_for_event(short event)
 	return ZBX_ASYNC_TASK_STOP;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set error for the current and remaining items of agent context    *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_set_error(zbx_agent_context *agent_context, int ret, char *error)
+{
+	int	i;
+
+	for (i = agent_context->index; i < agent_context->items_num; i++)
+	{
+		agent_context->items[i].ret = ret;
+		SET_MSG_RESULT(&agent_context->items[i].result, zbx_strdup(NULL, error));
+	}
+
+	zbx_free(error);
+}
+
+static int	agent_send_init(zbx_agent_context *agent_context)
+{
+	zbx_dc_item_context_t	*item = &agent_context->items[agent_context->index];
+
+	if (ZABBIX_AGENT_MODE_BATCH == agent_context->mode)
+	{
+		return zbx_tcp_send_context_init(agent_context->request, strlen(agent_context->request), 0,
+				ZBX_TCP_PROTOCOL, &agent_context->tcp_send_context);
+	}
+
+	return zbx_tcp_send_context_init(item->key, strlen(item->key),
+			(size_t)agent_context->timeouts[agent_context->index], ZBX_TCP_PROTOCOL,
+			&agent_context->tcp_send_context);
+}
+
+static int	agent_connect(zbx_agent_context *agent_context, const char *addr, int *fd)
+{
+	zbx_dc_item_context_t	*item = &agent_context->items[agent_context->index];
+
+	agent_context->step = ZABBIX_AGENT_STEP_CONNECT_WAIT;
+	agent_context->reused = 0;
+
+	if (SUCCEED != zbx_socket_connect(&agent_context->s, SOCK_STREAM, agent_context->config_source_ip, addr,
+			item->interface.port, agent_context->config_timeout))
+	{
+		agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Get value from agent failed"
+				" during %s", get_agent_step_string(agent_context->step)));
+		return FAIL;
+	}
+
+	if (ZABBIX_AGENT_MODE_BATCH == agent_context->mode)
+		agent_context->sessions->stats.connections++;
+
+	*fd = agent_context->s.socket;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close the current connection and open a new one                   *
+ *                                                                            *
+ * Comments: Used when reused connection turns out to be closed by agent and  *
+ *           to check items one by one when agent does not support batch      *
+ *           requests.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_reconnect(zbx_agent_context *agent_context, const char *addr, int *fd)
+{
+	zbx_tcp_send_context_clear(&agent_context->tcp_send_context);
+	zbx_tcp_close(&agent_context->s);
+
+	if (SUCCEED != agent_send_init(agent_context))
+	{
+		agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Get value from agent failed: %s",
+				zbx_socket_strerror()));
+		zbx_socket_clean(&agent_context->s);
+		return FAIL;
+	}
+
+	return agent_connect(agent_context, addr, fd);
+}
+
+static char	*agent_batch_request(const zbx_agent_context *agent_context)
+{
+	struct zbx_json	j;
+	char		*request;
+	int		i;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PASSIVE_CHECKS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	for (i = 0; i < agent_context->items_num; i++)
+	{
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_KEY, agent_context->items[i].key, ZBX_JSON_TYPE_STRING);
+		zbx_json_addint64(&j, ZBX_PROTO_TAG_TIMEOUT, agent_context->timeouts[i]);
+		zbx_json_close(&j);
+	}
+
+	request = zbx_strdup(NULL, j.buffer);
+	zbx_json_free(&j);
+
+	return request;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set item result from value of passive checks batch response       *
+ *                                                                            *
+ * Comments: Values are mapped the same way as single check responses, so     *
+ *           empty value is treated as dropped connection.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_handle_batch_value(zbx_dc_item_context_t *item, char *value)
+{
+	if ('\0' == *value)
+	{
+		item->ret = NETWORK_ERROR;
+		SET_MSG_RESULT(&item->result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+	}
+	else if (0 == strcmp(value, ZBX_ERROR))
+	{
+		item->ret = AGENT_ERROR;
+		SET_MSG_RESULT(&item->result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+	}
+	else
+	{
+		item->ret = SUCCEED;
+		zbx_set_agent_result_type(&item->result, ITEM_VALUE_TYPE_TEXT, value);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set item results from passive checks batch response               *
+ *                                                                            *
+ * Return value: SUCCEED - the response was parsed                            *
+ *               FAIL    - the response is not batch response, agent does not *
+ *                         support batch requests                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_handle_batch_response(zbx_agent_context *agent_context)
+{
+	struct zbx_json_parse	jp, jp_data, jp_row;
+	const char		*p = NULL;
+	char			*value = NULL, buf[MAX_ID_LEN + 1];
+	size_t			value_alloc = 0;
+	int			i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "get values from agent result: '%s'", agent_context->s.buffer);
+
+	if ('{' != *agent_context->s.buffer || SUCCEED != zbx_json_open(agent_context->s.buffer, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_SESSION_TIMEOUT, buf, sizeof(buf), NULL) ||
+			SUCCEED != zbx_is_uint_range(buf, &agent_context->session_timeout, 0, SEC_PER_MIN))
+	{
+		agent_context->session_timeout = 0;
+	}
+
+	for (i = 0; i < agent_context->items_num; i++)
+	{
+		zbx_dc_item_context_t	*item = &agent_context->items[i];
+
+		if (NULL == (p = zbx_json_next(&jp_data, p)))
+		{
+			for (; i < agent_context->items_num; i++)
+			{
+				agent_context->items[i].ret = NOTSUPPORTED;
+				SET_MSG_RESULT(&agent_context->items[i].result, zbx_strdup(NULL, "Value is missing in"
+						" passive checks batch response."));
+			}
+
+			break;
+		}
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+		{
+			item->ret = NOTSUPPORTED;
+			SET_MSG_RESULT(&item->result, zbx_dsprintf(NULL, "Invalid passive checks batch response: %s",
+					zbx_json_strerror()));
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, &value, &value_alloc,
+				NULL))
+		{
+			agent_handle_batch_value(item, value);
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_ERROR, &value, &value_alloc,
+				NULL))
+		{
+			item->ret = NOTSUPPORTED;
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, value));
+		}
+		else
+		{
+			item->ret = NOTSUPPORTED;
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, "Value is missing in passive checks batch"
+					" response."));
+		}
+	}
+
+	zbx_free(value);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get receive flags of the current request                          *
+ *                                                                            *
+ * Comments: Batch response carries values of all items, so it is received    *
+ *           with flags of all items instead of the first one.                *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	agent_recv_flags(const zbx_agent_context *agent_context)
+{
+	unsigned char	flags = 0;
+	int		i;
+
+	if (ZABBIX_AGENT_MODE_BATCH != agent_context->mode)
+		return agent_context->items[agent_context->index].flags;
+
+	for (i = 0; i < agent_context->items_num; i++)
+		flags |= agent_context->items[i].flags;
+
+	return flags;
+}
+
 static int	agent_task_process(short event, void *data, int *fd, const char *addr, char *dnserr)
 {
 	zbx_agent_context	*agent_context = (zbx_agent_context *)data;
+	zbx_dc_item_context_t	*item = &agent_context->items[agent_context->index];
 	ssize_t			received_len;
 	short			event_new;
 	zbx_async_task_state_t	state;
@@ -63,8 +300,6 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 	int			errnum = 0;
 	socklen_t		optlen = sizeof(int);
 
-	ZBX_UNUSED(fd);
-
 	if (NULL != poller_config && ZBX_PROCESS_STATE_IDLE == poller_config->state)
 	{
 		zbx_update_selfmon_counter(poller_config->info, ZBX_PROCESS_STATE_BUSY);
@@ -74,36 +309,40 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 	if (0 == event)
 	{
 		/* initialization */
-		zabbix_log(LOG_LEVEL_DEBUG, "In %s() step '%s' event:%d itemid:" ZBX_FS_UI64, __func__,
-				get_agent_step_string(agent_context->step), event, agent_context->item.itemid);
-
-		if (SUCCEED != zbx_socket_connect(&agent_context->s, SOCK_STREAM, agent_context->config_source_ip,
-				addr, agent_context->item.interface.port, agent_context->config_timeout))
+		zabbix_log(LOG_LEVEL_DEBUG, "In %s() step '%s' event:%d itemid:" ZBX_FS_UI64 " items:%d", __func__,
+				get_agent_step_string(agent_context->step), event, item->itemid,
+				agent_context->items_num);
+
+		if (ZABBIX_AGENT_MODE_BATCH == agent_context->mode && SUCCEED == async_session_acquire(
+				agent_context->sessions, item->interface.interfaceid, item->interface.addr,
+				item->interface.port, agent_context->tls_connect, agent_context->tls_arg1,
+				agent_context->tls_arg2, &agent_context->s))
 		{
-			agent_context->item.ret = NETWORK_ERROR;
-			SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent failed"
-					" during %s", get_agent_step_string(agent_context->step)));
-			goto stop;
+			agent_context->reused = 1;
+			agent_context->step = ZABBIX_AGENT_STEP_SEND;
+			*fd = agent_context->s.socket;
+
+			return ZBX_ASYNC_TASK_WRITE;
 		}
 
-		*fd = agent_context->s.socket;
+		if (SUCCEED != agent_connect(agent_context, addr, fd))
+			goto stop;
 
 		return ZBX_ASYNC_TASK_WRITE;
 	}
 	else
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "In %s() step '%s' event:%d itemid:" ZBX_FS_UI64, __func__,
-				get_agent_step_string(agent_context->step), event, agent_context->item.itemid);
+				get_agent_step_string(agent_context->step), event, item->itemid);
 	}
 
-
 	if (0 != (event & EV_TIMEOUT))
 	{
-		agent_context->item.ret = TIMEOUT_ERROR;
+		char	*error = NULL;
 
 		if (NULL != dnserr)
 		{
-			SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
+			agent_set_error(agent_context, TIMEOUT_ERROR, zbx_dsprintf(NULL, "Get value from agent"
 					" failed: Cannot resolve address: %s", dnserr));
 			goto stop;
 		}
@@ -111,28 +350,26 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 		switch (agent_context->step)
 		{
 			case ZABBIX_AGENT_STEP_CONNECT_WAIT:
-				SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
-						" failed: cannot establish TCP connection to [[%s]:%hu]:"
-						" timed out", agent_context->item.interface.addr,
-						agent_context->item.interface.port));
+				error = zbx_dsprintf(NULL, "Get value from agent failed: cannot establish TCP"
+						" connection to [[%s]:%hu]: timed out", item->interface.addr,
+						item->interface.port);
 				break;
 			case ZABBIX_AGENT_STEP_TLS_WAIT:
-				SET_MSG_RESULT(&agent_context->item.result,
-						zbx_dsprintf(NULL, "Get value from agent failed: TCP successful, cannot"
-						" establish TLS to [[%s]:%hu]: timed out",
-						agent_context->item.interface.addr,
-						agent_context->item.interface.port));
+				error = zbx_dsprintf(NULL, "Get value from agent failed: TCP successful, cannot"
+						" establish TLS to [[%s]:%hu]: timed out", item->interface.addr,
+						item->interface.port);
 				break;
 			case ZABBIX_AGENT_STEP_RECV:
-				SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
-						" failed: cannot read response: timed out"));
+				error = zbx_dsprintf(NULL, "Get value from agent failed: cannot read response:"
+						" timed out");
 				break;
 			case ZABBIX_AGENT_STEP_SEND:
-				SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
-						" failed: cannot send: timed out"));
+				error = zbx_dsprintf(NULL, "Get value from agent failed: cannot send: timed out");
 				break;
 		}
 
+		agent_set_error(agent_context, TIMEOUT_ERROR, error);
+
 		goto stop;
 	}
 
@@ -142,19 +379,16 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 			if (0 == getsockopt(agent_context->s.socket, SOL_SOCKET, SO_ERROR, &errnum, &optlen) &&
 					0 != errnum)
 			{
-				SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
+				agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Get value from agent"
 						" failed: Cannot establish TCP connection to [[%s]:%hu]: %s",
-						agent_context->item.interface.addr, agent_context->item.interface.port,
-						zbx_strerror(errnum)));
-				agent_context->item.ret = NETWORK_ERROR;
+						item->interface.addr, item->interface.port, zbx_strerror(errnum)));
 				break;
 			}
 
 			agent_context->step = ZABBIX_AGENT_STEP_TLS_WAIT;
 
 			zabbix_log(LOG_LEVEL_DEBUG, "%s() step '%s' event:%d itemid:" ZBX_FS_UI64, __func__,
-					get_agent_step_string(agent_context->step), event,
-					agent_context->item.itemid);
+					get_agent_step_string(agent_context->step), event, item->itemid);
 			ZBX_FALLTHROUGH;
 		case ZABBIX_AGENT_STEP_TLS_WAIT:
 			if (ZBX_TCP_SEC_TLS_CERT == agent_context->tls_connect ||
@@ -169,25 +403,22 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 					if (ZBX_ASYNC_TASK_STOP != (state = get_task_state_for_event(event_new)))
 						return state;
 
-					SET_MSG_RESULT(&agent_context->item.result,
-							zbx_dsprintf(NULL, "Get value from agent failed:"
-							" TCP successful, cannot establish TLS to [[%s]:%hu]: %s",
-							agent_context->item.interface.addr,
-							agent_context->item.interface.port, error));
+					agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Get value from"
+							" agent failed: TCP successful, cannot establish TLS to"
+							" [[%s]:%hu]: %s", item->interface.addr, item->interface.port,
+							error));
 					zbx_free(error);
-					agent_context->item.ret = NETWORK_ERROR;
 					break;
 				}
 			}
 
 			agent_context->step = ZABBIX_AGENT_STEP_SEND;
 			zabbix_log(LOG_LEVEL_DEBUG, "%s() step '%s' event:%d itemid:" ZBX_FS_UI64, __func__,
-					get_agent_step_string(agent_context->step), event,
-					agent_context->item.itemid);
+					get_agent_step_string(agent_context->step), event, item->itemid);
 			ZBX_FALLTHROUGH;
 		case ZABBIX_AGENT_STEP_SEND:
-			zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s] itemid:" ZBX_FS_UI64, agent_context->item.key,
-					agent_context->item.itemid);
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s] itemid:" ZBX_FS_UI64, ZABBIX_AGENT_MODE_BATCH ==
+					agent_context->mode ? agent_context->request : item->key, item->itemid);
 
 			if (SUCCEED != zbx_tcp_send_context(&agent_context->s, &agent_context->tcp_send_context,
 					&event_new))
@@ -195,82 +426,221 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 				if (ZBX_ASYNC_TASK_STOP != (state = get_task_state_for_event(event_new)))
 					return state;
 
-				SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
+				/* idle connection was closed by agent, retry with a new connection */
+				if (0 != agent_context->reused)
+				{
+					agent_context->sessions->stats.expired++;
+
+					if (SUCCEED != agent_reconnect(agent_context, addr, fd))
+						break;
+
+					return ZBX_ASYNC_TASK_WRITE;
+				}
+
+				agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Get value from agent"
 						" failed: cannot send: %s", zbx_socket_strerror()));
-				agent_context->item.ret = NETWORK_ERROR;
 				break;
 			}
 
+			if (ZABBIX_AGENT_MODE_BATCH == agent_context->mode)
+			{
+				agent_context->sessions->stats.requests++;
+				agent_context->sessions->stats.checks += (zbx_uint64_t)agent_context->items_num;
+			}
+
 			agent_context->step = ZABBIX_AGENT_STEP_RECV;
 			zbx_tcp_recv_context_init(&agent_context->s, &agent_context->tcp_recv_context,
-					agent_context->item.flags);
+					agent_recv_flags(agent_context));
 
 			return ZBX_ASYNC_TASK_READ;
 		case ZABBIX_AGENT_STEP_RECV:
-			if (FAIL != (received_len = zbx_tcp_recv_context(&agent_context->s,
-					&agent_context->tcp_recv_context, agent_context->item.flags, &event_new)))
+			if (FAIL == (received_len = zbx_tcp_recv_context(&agent_context->s,
+					&agent_context->tcp_recv_context, agent_recv_flags(agent_context), &event_new)))
 			{
-				agent_context->item.ret = SUCCEED;
-				zbx_agent_handle_response(&agent_context->s, received_len, &agent_context->item.ret,
-						agent_context->item.interface.addr, &agent_context->item.result);
+				if (ZBX_ASYNC_TASK_STOP != (state = get_task_state_for_event(event_new)))
+					return state;
+			}
 
+			/* idle connection was closed by agent before the request was received, retry */
+			if (0 != agent_context->reused && 0 >= received_len)
+			{
+				agent_context->sessions->stats.expired++;
+
+				if (SUCCEED != agent_reconnect(agent_context, addr, fd))
+					break;
+
+				return ZBX_ASYNC_TASK_WRITE;
+			}
+
+			if (FAIL == received_len)
+			{
+				agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Get value from agent"
+						" failed: cannot read response: %s", zbx_socket_strerror()));
 				break;
 			}
 
-			if (ZBX_ASYNC_TASK_STOP != (state = get_task_state_for_event(event_new)))
-				return state;
+			if (ZABBIX_AGENT_MODE_BATCH == agent_context->mode)
+			{
+				if (0 != received_len && SUCCEED == agent_handle_batch_response(agent_context))
+				{
+					agent_context->probe_result = ASYNC_SESSION_SUPPORTED;
+					break;
+				}
+
+				if (0 == received_len)
+				{
+					agent_set_error(agent_context, NETWORK_ERROR, zbx_dsprintf(NULL, "Received empty"
+							" response from Zabbix Agent at [%s]. Assuming that agent"
+							" dropped connection because of access permissions.",
+							item->interface.addr));
+					break;
+				}
+
+				/* agent does not support batch requests, check items one by one */
+				zabbix_log(LOG_LEVEL_DEBUG, "agent at [%s] does not support passive checks batch"
+						" requests", item->interface.addr);
+
+				agent_context->probe_result = ASYNC_SESSION_UNSUPPORTED;
+				async_session_set_support(agent_context->sessions, item->interface.interfaceid,
+						ASYNC_SESSION_UNSUPPORTED);
+				agent_context->mode = ZABBIX_AGENT_MODE_SINGLE;
+				zbx_free(agent_context->request);
+
+				if (SUCCEED != agent_reconnect(agent_context, addr, fd))
+					break;
+
+				return ZBX_ASYNC_TASK_WRITE;
+			}
+
+			item->ret = SUCCEED;
+			zbx_agent_handle_response(&agent_context->s, received_len, &item->ret, item->interface.addr,
+					&item->result);
+
+			/* agent closes connection after single check response */
+			if (++agent_context->index < agent_context->items_num)
+			{
+				if (SUCCEED != agent_reconnect(agent_context, addr, fd))
+					break;
+
+				return ZBX_ASYNC_TASK_WRITE;
+			}
 
-			SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent failed:"
-					" cannot read response: %s", zbx_socket_strerror()));
-			agent_context->item.ret = NETWORK_ERROR;
 			break;
 	}
 stop:
 	zbx_tcp_send_context_clear(&agent_context->tcp_send_context);
-	zbx_tcp_close(&agent_context->s);
+
+	if (0 != agent_context->probe)
+	{
+		async_session_set_support(agent_context->sessions, agent_context->items[0].interface.interfaceid,
+				agent_context->probe_result);
+	}
+
+	if (ZABBIX_AGENT_MODE_BATCH == agent_context->mode && 0 != agent_context->session_timeout &&
+			ZBX_IS_RUNNING())
+	{
+		item = &agent_context->items[0];
+
+		async_session_release(agent_context->sessions, item->interface.interfaceid, item->interface.addr,
+				item->interface.port, agent_context->tls_connect, agent_context->tls_arg1,
+				agent_context->tls_arg2, &agent_context->s, agent_context->session_timeout);
+	}
+	else
+		zbx_tcp_close(&agent_context->s);
 
 	return ZBX_ASYNC_TASK_STOP;
 }
 
 void	zbx_async_check_agent_clean(zbx_agent_context *agent_context)
 {
-	zbx_free(agent_context->item.key_orig);
-	zbx_free(agent_context->item.key);
+	int	i;
+
+	for (i = 0; i < agent_context->items_num; i++)
+	{
+		zbx_free(agent_context->items[i].key_orig);
+		zbx_free(agent_context->items[i].key);
+		zbx_free_agent_result(&agent_context->items[i].result);
+	}
+
+	zbx_free(agent_context->items);
+	zbx_free(agent_context->timeouts);
+	zbx_free(agent_context->request);
 	zbx_free(agent_context->tls_arg1);
 	zbx_free(agent_context->tls_arg2);
-	zbx_free_agent_result(&agent_context->item.result);
 }
 
-int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_task_clear_cb_t clear_cb,
-		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
-		const char *config_source_ip)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start asynchronous check of Zabbix agent items                    *
+ *                                                                            *
+ * Parameters: items            - [IN] the items of the same interface        *
+ *             items_num        - [IN] the number of items                    *
+ *             result           - [OUT] the error message if check could not  *
+ *                                      be started                            *
+ *             clear_cb         - [IN]                                        *
+ *             arg              - [IN]                                        *
+ *             arg_action       - [IN]                                        *
+ *             base             - [IN]                                        *
+ *             dnsbase          - [IN]                                        *
+ *             config_source_ip - [IN]                                        *
+ *             sessions         - [IN] the agent session pool, NULL to check  *
+ *                                     the item with one connection           *
+ *                                                                            *
+ * Comments: Multiple items are checked with one passive checks batch request *
+ *           over agent session connection, a single item with agent session  *
+ *           pool probes batch request support if it is not known yet.        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_async_check_agent(zbx_dc_item_t **items, int items_num, AGENT_RESULT *result,
+		zbx_async_task_clear_cb_t clear_cb, void *arg, void *arg_action, struct event_base *base,
+		struct evdns_base *dnsbase, const char *config_source_ip, zbx_async_session_pool_t *sessions)
 {
 	zbx_agent_context	*agent_context = zbx_malloc(NULL, sizeof(zbx_agent_context));
-	int			ret = NOTSUPPORTED;
+	zbx_dc_item_t		*item = items[0];
+	int			ret = NOTSUPPORTED, i, timeout = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' host:'%s' addr:'%s'  conn:'%s'", __func__, item->key,
-			item->host.host, item->interface.addr, zbx_tcp_connection_type_name(item->host.tls_connect));
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' host:'%s' addr:'%s'  conn:'%s' items:%d", __func__, item->key,
+			item->host.host, item->interface.addr, zbx_tcp_connection_type_name(item->host.tls_connect),
+			items_num);
 
 	agent_context->arg = arg;
 	agent_context->arg_action = arg_action;
-	agent_context->item.itemid = item->itemid;
-	agent_context->item.hostid = item->host.hostid;
-	agent_context->item.value_type = item->value_type;
-	agent_context->item.flags = item->flags;
-	agent_context->item.interface = item->interface;
-	agent_context->item.interface.addr = (item->interface.addr == item->interface.dns_orig ?
-			agent_context->item.interface.dns_orig : agent_context->item.interface.ip_orig);
-	agent_context->item.key = item->key;
-	agent_context->item.key_orig = zbx_strdup(NULL, item->key_orig);
-	item->key = NULL;
-	agent_context->tls_connect = item->host.tls_connect;
-	zbx_strlcpy(agent_context->item.host, item->host.host, sizeof(agent_context->item.host));
+	agent_context->items = (zbx_dc_item_context_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_context_t) *
+			(size_t)items_num);
+	agent_context->timeouts = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)items_num);
+	agent_context->items_num = items_num;
+	agent_context->index = 0;
 
-	agent_context->config_source_ip = config_source_ip;
-
-	zbx_init_agent_result(&agent_context->item.result);
+	for (i = 0; i < items_num; i++)
+	{
+		zbx_dc_item_context_t	*item_context = &agent_context->items[i];
+
+		item_context->itemid = items[i]->itemid;
+		item_context->hostid = items[i]->host.hostid;
+		item_context->value_type = items[i]->value_type;
+		item_context->flags = items[i]->flags;
+		item_context->interface = items[i]->interface;
+		item_context->interface.addr = (items[i]->interface.addr == items[i]->interface.dns_orig ?
+				item_context->interface.dns_orig : item_context->interface.ip_orig);
+		item_context->key = items[i]->key;
+		item_context->key_orig = zbx_strdup(NULL, items[i]->key_orig);
+		items[i]->key = NULL;
+		zbx_strlcpy(item_context->host, items[i]->host.host, sizeof(item_context->host));
+		zbx_init_agent_result(&item_context->result);
+
+		agent_context->timeouts[i] = items[i]->timeout;
+		timeout += items[i]->timeout;
+	}
 
+	agent_context->tls_connect = item->host.tls_connect;
+	agent_context->config_source_ip = config_source_ip;
 	agent_context->config_timeout = item->timeout;
+	agent_context->sessions = sessions;
+	agent_context->request = NULL;
+	agent_context->reused = 0;
+	agent_context->probe = 0;
+	agent_context->probe_result = ASYNC_SESSION_UNKNOWN;
+	agent_context->session_timeout = 0;
 
 	switch (agent_context->tls_connect)
 	{
@@ -306,18 +676,31 @@ int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_
 			goto out;
 	}
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-	if (SUCCEED != zbx_is_ip(agent_context->item.interface.addr))
-		agent_context->server_name = agent_context->item.interface.addr;
+	if (SUCCEED != zbx_is_ip(agent_context->items[0].interface.addr))
+		agent_context->server_name = agent_context->items[0].interface.addr;
 	else
 		agent_context->server_name = NULL;
 #endif
+	if (NULL != sessions)
+	{
+		agent_context->mode = ZABBIX_AGENT_MODE_BATCH;
+		agent_context->request = agent_batch_request(agent_context);
+
+		if (ASYNC_SESSION_UNKNOWN == async_session_get_support(sessions, item->interface.interfaceid))
+		{
+			agent_context->probe = 1;
+			async_session_set_support(sessions, item->interface.interfaceid, ASYNC_SESSION_PROBING);
+		}
+	}
+	else
+		agent_context->mode = ZABBIX_AGENT_MODE_SINGLE;
+
 	zbx_socket_clean(&agent_context->s);
-	zbx_tcp_send_context_init(agent_context->item.key, strlen(agent_context->item.key), (size_t)item->timeout,
-		ZBX_TCP_PROTOCOL, &agent_context->tcp_send_context);
+	agent_send_init(agent_context);
 
 	agent_context->step = ZABBIX_AGENT_STEP_CONNECT_WAIT;
 
-	zbx_async_poller_add_task(base, dnsbase, agent_context->item.interface.addr, agent_context, item->timeout + 1,
+	zbx_async_poller_add_task(base, dnsbase, agent_context->items[0].interface.addr, agent_context, timeout + 1,
 			agent_task_process, clear_cb);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(SUCCEED));
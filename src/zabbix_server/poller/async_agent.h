@@ -22,6 +22,7 @@
 
 #include "zbxcacheconfig.h"
 #include "zbxasyncpoller.h"
+#include "async_session.h"
 
 typedef enum
 {
@@ -32,9 +33,19 @@ typedef enum
 }
 zbx_zabbix_agent_step_t;
 
+typedef enum
+{
+	ZABBIX_AGENT_MODE_SINGLE = 0,	/* one check per connection */
+	ZABBIX_AGENT_MODE_BATCH		/* all checks in one passive checks batch request */
+}
+zbx_zabbix_agent_mode_t;
+
 typedef struct
 {
-	zbx_dc_item_context_t	item;
+	zbx_dc_item_context_t	*items;
+	int			*timeouts;
+	int			items_num;
+	int			index;		/* the item being checked in single check mode */
 	void			*arg;
 	void			*arg_action;
 	zbx_socket_t		s;
@@ -47,12 +58,19 @@ typedef struct
 	unsigned char		tls_connect;
 	const char		*config_source_ip;
 	int			config_timeout;
+	zbx_zabbix_agent_mode_t	mode;
+	char			*request;
+	zbx_async_session_pool_t	*sessions;	/* NULL if connections are not reused */
+	unsigned char		reused;		/* the connection was taken from session pool */
+	unsigned char		probe;		/* the request probes batch request support */
+	unsigned char		probe_result;
+	int			session_timeout;
 }
 zbx_agent_context;
 
-int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_task_clear_cb_t clear_cb,
-		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
-		const char *config_source_ip);
+int	zbx_async_check_agent(zbx_dc_item_t **items, int items_num, AGENT_RESULT *result,
+		zbx_async_task_clear_cb_t clear_cb, void *arg, void *arg_action, struct event_base *base,
+		struct evdns_base *dnsbase, const char *config_source_ip, zbx_async_session_pool_t *sessions);
 void	zbx_async_check_agent_clean(zbx_agent_context *agent_context);
 
 #endif
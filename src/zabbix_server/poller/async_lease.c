@@ -0,0 +1,381 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Item ownership for asynchronous pollers.
+ *
+ * Items of an interface (or host for items without interface) are leased by the poller process selected by
+ * interface hash. When such item is taken from the poller queue and successfully checked it is not returned
+ * to the queue, but kept by the owner and scheduled in its local queue. Owned items keep poller location in
+ * configuration cache, so the owner reads them under configuration cache read lock. Configuration cache is
+ * write locked only to flush the next checks of owned items once per second and to return items to the
+ * poller queue when their configuration changes, their host becomes unreachable or check fails with network
+ * error.
+ */
+
+#include "async_lease.h"
+
+#include "zbxcommon.h"
+#include "zbxtime.h"
+
+#define ASYNC_LEASE_FLUSH_INTERVAL	1
+
+static int	async_lease_item_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_async_lease_item_t	*i1 = (const zbx_async_lease_item_t *)e1->data;
+	const zbx_async_lease_item_t	*i2 = (const zbx_async_lease_item_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->itemid, i2->itemid);
+
+	return 0;
+}
+
+void	async_lease_init(zbx_async_lease_t *lease, unsigned char poller_type, int process_num, int processes_num)
+{
+	lease->poller_type = poller_type;
+	lease->process_num = process_num;
+	lease->processes_num = processes_num;
+	lease->revision = zbx_dc_get_config_revision();
+	lease->flush_time = 0;
+
+	zbx_hashset_create(&lease->items, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_timewheel_create(&lease->queue, async_lease_item_compare);
+	zbx_vector_uint64_create(&lease->flush_itemids);
+	zbx_vector_int32_create(&lease->flush_nextchecks);
+}
+
+void	async_lease_destroy(zbx_async_lease_t *lease)
+{
+	zbx_vector_int32_destroy(&lease->flush_nextchecks);
+	zbx_vector_uint64_destroy(&lease->flush_itemids);
+	zbx_timewheel_destroy(&lease->queue);
+	zbx_hashset_destroy(&lease->items);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if item belongs to the poller process partition            *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_lease_is_owner(const zbx_async_lease_t *lease, const zbx_dc_item_t *item)
+{
+	zbx_uint64_t	id;
+
+	id = (0 != item->interface.interfaceid ? item->interface.interfaceid : item->host.hostid);
+
+	if (lease->process_num - 1 != (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&id) % (zbx_hash_t)lease->processes_num))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: take ownership of items retrieved from poller queue               *
+ *                                                                            *
+ * Parameters: lease - [IN]                                                   *
+ *             items - [IN] the items retrieved from poller queue             *
+ *             num   - [IN] the number of items                               *
+ *                                                                            *
+ * Comments: The ownership is kept only if the item check succeeds.           *
+ *           Items were retrieved after owned items were validated, so they   *
+ *           are up to date at least with the lease revision.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	async_lease_acquire(zbx_async_lease_t *lease, const zbx_dc_item_t *items, int num)
+{
+	int	i;
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_async_lease_item_t	item_local = {.itemid = items[i].itemid, .revision = lease->revision};
+
+		if (SUCCEED == async_lease_is_owner(lease, &items[i]))
+			zbx_hashset_insert(&lease->items, &item_local, sizeof(item_local));
+	}
+}
+
+static void	async_lease_release(zbx_async_lease_t *lease, const zbx_vector_uint64_t *itemids)
+{
+	int	i;
+
+	for (i = 0; i < itemids->values_num; i++)
+		zbx_hashset_remove(&lease->items, &itemids->values[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reschedule checked owned items                                    *
+ *                                                                            *
+ * Parameters: lease      - [IN]                                              *
+ *             itemids    - [IN/OUT] the checked items, owned items that were *
+ *                                   rescheduled locally are removed          *
+ *             errcodes   - [IN/OUT] the item check results                   *
+ *             lastclocks - [IN/OUT] the item check times                     *
+ *                                                                            *
+ * Comments: Items failed with network errors are released and left to be     *
+ *           returned to poller queue, which handles unreachable interfaces.  *
+ *                                                                            *
+ ******************************************************************************/
+void	async_lease_requeue(zbx_async_lease_t *lease, zbx_vector_uint64_t *itemids, zbx_vector_int32_t *errcodes,
+		zbx_vector_int32_t *lastclocks)
+{
+	zbx_vector_uint64_t	owned_itemids;
+	zbx_vector_int32_t	owned_lastclocks, nextchecks;
+	int			i, j;
+
+	if (0 == lease->items.num_data)
+		return;
+
+	zbx_vector_uint64_create(&owned_itemids);
+	zbx_vector_int32_create(&owned_lastclocks);
+
+	for (i = 0, j = 0; i < itemids->values_num; i++)
+	{
+		zbx_async_lease_item_t	*item;
+
+		if (NULL != (item = (zbx_async_lease_item_t *)zbx_hashset_search(&lease->items, &itemids->values[i])))
+		{
+			switch (errcodes->values[i])
+			{
+				case SUCCEED:
+				case NOTSUPPORTED:
+				case AGENT_ERROR:
+				case CONFIG_ERROR:
+					zbx_vector_uint64_append(&owned_itemids, itemids->values[i]);
+					zbx_vector_int32_append(&owned_lastclocks, lastclocks->values[i]);
+					continue;
+				default:
+					zbx_hashset_remove_direct(&lease->items, item);
+			}
+		}
+
+		itemids->values[j] = itemids->values[i];
+		errcodes->values[j] = errcodes->values[i];
+		lastclocks->values[j] = lastclocks->values[i];
+		j++;
+	}
+
+	itemids->values_num = errcodes->values_num = lastclocks->values_num = j;
+
+	if (0 != owned_itemids.values_num)
+	{
+		zbx_vector_int32_create(&nextchecks);
+		zbx_vector_int32_reserve(&nextchecks, (size_t)owned_itemids.values_num);
+		nextchecks.values_num = owned_itemids.values_num;
+
+		zbx_dc_poller_get_owned_nextchecks(owned_itemids.values, owned_lastclocks.values, nextchecks.values,
+				(size_t)owned_itemids.values_num);
+
+		for (i = 0; i < owned_itemids.values_num; i++)
+		{
+			zbx_async_lease_item_t	*item;
+			zbx_binary_heap_elem_t	elem;
+
+			item = (zbx_async_lease_item_t *)zbx_hashset_search(&lease->items, &owned_itemids.values[i]);
+
+			/* item was removed from configuration cache */
+			if (FAIL == nextchecks.values[i])
+			{
+				zbx_hashset_remove_direct(&lease->items, item);
+				continue;
+			}
+
+			item->nextcheck = nextchecks.values[i];
+
+			elem.key = item->itemid;
+			elem.data = (void *)item;
+			zbx_timewheel_insert(&lease->queue, &elem, item->nextcheck);
+
+			zbx_vector_uint64_append(&lease->flush_itemids, item->itemid);
+			zbx_vector_int32_append(&lease->flush_nextchecks, item->nextcheck);
+		}
+
+		zbx_vector_int32_destroy(&nextchecks);
+	}
+
+	zbx_vector_int32_destroy(&owned_lastclocks);
+	zbx_vector_uint64_destroy(&owned_itemids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get owned items due for check                                     *
+ *                                                                            *
+ * Parameters: lease     - [IN]                                               *
+ *             max_items - [IN] the maximum number of items to get            *
+ *             items     - [OUT] the items to check                           *
+ *             released  - [OUT] the items that must be returned to poller    *
+ *                               queue                                        *
+ *                                                                            *
+ * Return value: the number of items to check                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	async_lease_get_items(zbx_async_lease_t *lease, int max_items, zbx_dc_item_t **items,
+		zbx_vector_uint64_t *released)
+{
+	zbx_vector_uint64_t	itemids, revisions;
+	zbx_uint64_t		revision;
+	int			i, now, num = 0, released_num = released->values_num;
+
+	now = (int)time(NULL);
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_create(&revisions);
+
+	while (itemids.values_num < max_items && FAIL == zbx_timewheel_empty(&lease->queue))
+	{
+		zbx_async_lease_item_t	*item;
+
+		item = (zbx_async_lease_item_t *)zbx_timewheel_find_min(&lease->queue)->data;
+
+		if (item->nextcheck > now)
+			break;
+
+		zbx_timewheel_remove_min(&lease->queue);
+		item->nextcheck = 0;
+		zbx_vector_uint64_append(&itemids, item->itemid);
+		zbx_vector_uint64_append(&revisions, item->revision);
+	}
+
+	if (0 != itemids.values_num)
+	{
+		*items = (zbx_dc_item_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_t) * (size_t)itemids.values_num);
+
+		num = zbx_dc_config_get_owned_poller_items(lease->poller_type, itemids.values, revisions.values,
+				itemids.values_num, *items, released, &revision);
+
+		for (i = released_num; i < released->values_num; i++)
+			zbx_hashset_remove(&lease->items, &released->values[i]);
+
+		for (i = 0; i < num; i++)
+		{
+			zbx_async_lease_item_t	*item;
+
+			if (NULL != (item = (zbx_async_lease_item_t *)zbx_hashset_search(&lease->items,
+					&(*items)[i].itemid)))
+			{
+				item->revision = revision;
+			}
+		}
+
+		if (0 == num)
+			zbx_free(*items);
+	}
+
+	zbx_vector_uint64_destroy(&revisions);
+	zbx_vector_uint64_destroy(&itemids);
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the next check of owned items                                 *
+ *                                                                            *
+ * Return value: the next check or FAIL if no items are scheduled             *
+ *                                                                            *
+ ******************************************************************************/
+int	async_lease_nextcheck(const zbx_async_lease_t *lease)
+{
+	return zbx_timewheel_next_expire(&lease->queue);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: synchronize owned items with configuration cache                  *
+ *                                                                            *
+ * Parameters: lease    - [IN]                                                *
+ *             released - [OUT] the items that must be returned to poller     *
+ *                              queue                                         *
+ *                                                                            *
+ * Comments: Scheduled items are validated only when configuration revision   *
+ *           changes, items being checked keep the revision they were         *
+ *           validated at and are validated against it when they are due      *
+ *           next time.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	async_lease_sync(zbx_async_lease_t *lease, zbx_vector_uint64_t *released)
+{
+	time_t	now;
+
+	if (lease->revision != zbx_dc_get_config_revision())
+	{
+		zbx_vector_uint64_t	itemids, revisions, released_local;
+		zbx_hashset_iter_t	iter;
+		zbx_async_lease_item_t	*item;
+		int			i;
+
+		zbx_vector_uint64_create(&itemids);
+		zbx_vector_uint64_create(&revisions);
+		zbx_vector_uint64_create(&released_local);
+		zbx_vector_uint64_reserve(&itemids, (size_t)lease->items.num_data);
+		zbx_vector_uint64_reserve(&revisions, (size_t)lease->items.num_data);
+
+		zbx_hashset_iter_reset(&lease->items, &iter);
+		while (NULL != (item = (zbx_async_lease_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (0 != item->nextcheck)
+			{
+				zbx_vector_uint64_append(&itemids, item->itemid);
+				zbx_vector_uint64_append(&revisions, item->revision);
+			}
+		}
+
+		zbx_dc_poller_validate_owned_items(lease->poller_type, itemids.values, revisions.values,
+				itemids.values_num, &released_local, &lease->revision);
+
+		for (i = 0; i < released_local.values_num; i++)
+			zbx_timewheel_remove_direct(&lease->queue, released_local.values[i]);
+
+		async_lease_release(lease, &released_local);
+		zbx_vector_uint64_append_array(released, released_local.values, released_local.values_num);
+
+		/* only the validated scheduled items are up to date with the new revision */
+		for (i = 0; i < itemids.values_num; i++)
+		{
+			if (NULL != (item = (zbx_async_lease_item_t *)zbx_hashset_search(&lease->items,
+					&itemids.values[i])))
+			{
+				item->revision = lease->revision;
+			}
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() revision:" ZBX_FS_UI64 " owned:%d released:%d", __func__,
+				lease->revision, lease->items.num_data, released_local.values_num);
+
+		zbx_vector_uint64_destroy(&released_local);
+		zbx_vector_uint64_destroy(&revisions);
+		zbx_vector_uint64_destroy(&itemids);
+	}
+
+	if (0 != lease->flush_itemids.values_num && ASYNC_LEASE_FLUSH_INTERVAL <= (now = time(NULL)) -
+			lease->flush_time)
+	{
+		zbx_dc_poller_flush_owned_nextchecks(lease->flush_itemids.values, lease->flush_nextchecks.values,
+				(size_t)lease->flush_itemids.values_num);
+
+		zbx_vector_uint64_clear(&lease->flush_itemids);
+		zbx_vector_int32_clear(&lease->flush_nextchecks);
+		lease->flush_time = now;
+	}
+}
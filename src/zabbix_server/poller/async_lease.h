@@ -0,0 +1,66 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ASYNC_LEASE_H
+#define ZABBIX_ASYNC_LEASE_H
+
+#include "zbxalgo.h"
+#include "zbxcacheconfig.h"
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	revision;	/* the configuration revision the item was validated at */
+	int		nextcheck;	/* 0 while the item is being checked */
+}
+zbx_async_lease_item_t;
+
+typedef struct
+{
+	unsigned char		poller_type;
+	int			process_num;
+	int			processes_num;
+
+	/* items owned by the poller process */
+	zbx_hashset_t		items;
+
+	/* owned items waiting for the next check */
+	zbx_timewheel_t		queue;
+
+	/* the configuration revision scheduled owned items were validated at */
+	zbx_uint64_t		revision;
+
+	/* the next checks of owned items to be written back to configuration cache */
+	zbx_vector_uint64_t	flush_itemids;
+	zbx_vector_int32_t	flush_nextchecks;
+	time_t			flush_time;
+}
+zbx_async_lease_t;
+
+void	async_lease_init(zbx_async_lease_t *lease, unsigned char poller_type, int process_num, int processes_num);
+void	async_lease_destroy(zbx_async_lease_t *lease);
+void	async_lease_acquire(zbx_async_lease_t *lease, const zbx_dc_item_t *items, int num);
+void	async_lease_requeue(zbx_async_lease_t *lease, zbx_vector_uint64_t *itemids, zbx_vector_int32_t *errcodes,
+		zbx_vector_int32_t *lastclocks);
+int	async_lease_get_items(zbx_async_lease_t *lease, int max_items, zbx_dc_item_t **items,
+		zbx_vector_uint64_t *released);
+int	async_lease_nextcheck(const zbx_async_lease_t *lease);
+void	async_lease_sync(zbx_async_lease_t *lease, zbx_vector_uint64_t *released);
+
+#endif
@@ -34,7 +34,8 @@ struct zbx_async_manager
 };
 
 zbx_async_manager_t	*zbx_async_manager_create(int workers_num, zbx_async_notify_cb_t finished_cb,
-		void *finished_data, zbx_thread_poller_args *poller_args_in, char **error)
+		void *finished_data, zbx_thread_poller_args *poller_args_in, int process_num, int processes_num,
+		char **error)
 {
 	int			i, ret = FAIL, started_num = 0;
 	time_t			time_start;
@@ -46,7 +47,7 @@ zbx_async_manager_t	*zbx_async_manager_create(int workers_num, zbx_async_notify_
 	manager = (zbx_async_manager_t *)zbx_malloc(NULL, sizeof(zbx_async_manager_t));
 	memset(manager, 0, sizeof(zbx_async_manager_t));
 
-	if (SUCCEED != async_task_queue_init(&manager->queue, poller_args_in, error))
+	if (SUCCEED != async_task_queue_init(&manager->queue, poller_args_in, process_num, processes_num, error))
 		goto out;
 
 	manager->workers_num = workers_num;
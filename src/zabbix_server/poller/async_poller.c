@@ -22,6 +22,7 @@
 #include "async_agent.h"
 #include "checks_snmp.h"
 #include "zbxasynchttppoller.h"
+#include "zbxasyncpoller.h"
 #include "zbxlog.h"
 #include "zbxalgo.h"
 #include "zbxcommon.h"
@@ -119,7 +120,8 @@ static void	process_agent_result(void *data)
 	zbx_agent_context	*agent_context = (zbx_agent_context *)data;
 	zbx_poller_config_t	*poller_config = (zbx_poller_config_t *)agent_context->arg;
 
-	process_async_result(&agent_context->item, poller_config);
+	for (int i = 0; i < agent_context->items_num; i++)
+		process_async_result(&agent_context->items[i], poller_config);
 
 	zbx_async_check_agent_clean(agent_context);
 	zbx_free(agent_context);
@@ -213,6 +215,96 @@ static void	async_wake(evutil_socket_t fd, short events, void *arg)
 	ZBX_UNUSED(arg);
 }
 
+static void	async_check_agent(zbx_poller_config_t *poller_config, zbx_dc_item_t *items, AGENT_RESULT *results,
+		int *errcodes, zbx_dc_item_t **batch, int batch_num, zbx_async_session_pool_t *sessions)
+{
+	int	i, index, ret;
+
+	index = (int)(batch[0] - items);
+	ret = zbx_async_check_agent(batch, batch_num, &results[index], process_agent_result, poller_config,
+			poller_config, poller_config->base, poller_config->dnsbase, poller_config->config_source_ip,
+			sessions);
+
+	for (i = 0; i < batch_num; i++)
+	{
+		index = (int)(batch[i] - items);
+		errcodes[index] = ret;
+
+		if (SUCCEED == ret)
+			poller_config->processing++;
+		else if (0 != i)
+			SET_MSG_RESULT(&results[index], zbx_strdup(NULL, results[batch[0] - items].msg));
+	}
+}
+
+static int	agent_item_compare_by_interface(const void *d1, const void *d2)
+{
+	const zbx_dc_item_t	*i1 = *(const zbx_dc_item_t * const *)d1;
+	const zbx_dc_item_t	*i2 = *(const zbx_dc_item_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interface.interfaceid, i2->interface.interfaceid);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check Zabbix agent items using agent sessions                     *
+ *                                                                            *
+ * Parameters: poller_config - [IN]                                           *
+ *             items         - [IN] the items retrieved from poller queue     *
+ *             results       - [OUT] the item results                         *
+ *             errcodes      - [OUT] the item check errors                    *
+ *             agent_items   - [IN] the Zabbix agent items to check           *
+ *                                                                            *
+ * Comments: Items of interfaces supporting batch requests are checked in     *
+ *           batches limited by number of items and total item timeout.       *
+ *           The first item of interface with unknown support is checked      *
+ *           alone to probe the support while other items of the interface    *
+ *           are checked one per connection.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_check_agent_sessions(zbx_poller_config_t *poller_config, zbx_dc_item_t *items,
+		AGENT_RESULT *results, int *errcodes, zbx_vector_ptr_t *agent_items)
+{
+	zbx_dc_item_t	**batch = (zbx_dc_item_t **)agent_items->values;
+	int		i, j, timeout;
+
+	zbx_vector_ptr_sort(agent_items, agent_item_compare_by_interface);
+
+	for (i = 0; i < agent_items->values_num; i = j)
+	{
+		switch (async_session_get_support(poller_config->sessions, batch[i]->interface.interfaceid))
+		{
+			case ASYNC_SESSION_UNKNOWN:
+				async_check_agent(poller_config, items, results, errcodes, &batch[i], 1,
+						poller_config->sessions);
+				j = i + 1;
+				break;
+			case ASYNC_SESSION_SUPPORTED:
+				timeout = batch[i]->timeout;
+
+				for (j = i + 1; j < agent_items->values_num && j - i < ASYNC_SESSION_BATCH_MAX; j++)
+				{
+					if (batch[j]->interface.interfaceid != batch[i]->interface.interfaceid ||
+							ASYNC_SESSION_BATCH_TIMEOUT_MAX < timeout + batch[j]->timeout)
+					{
+						break;
+					}
+
+					timeout += batch[j]->timeout;
+				}
+
+				async_check_agent(poller_config, items, results, errcodes, &batch[i], j - i,
+						poller_config->sessions);
+				break;
+			default:
+				async_check_agent(poller_config, items, results, errcodes, &batch[i], 1, NULL);
+				j = i + 1;
+		}
+	}
+}
+
 static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config)
 {
 	zbx_dc_item_t			*items = NULL;
@@ -221,8 +313,10 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config)
 	zbx_timespec_t			timespec;
 	int				i, total = 0;
 	zbx_vector_poller_item_t	poller_items;
+	zbx_vector_ptr_t		agent_items;
 
 	zbx_vector_poller_item_create(&poller_items);
+	zbx_vector_ptr_create(&agent_items);
 #ifdef HAVE_NETSNMP
 	if (1 == poller_config->clear_cache)
 	{
@@ -274,9 +368,17 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config)
 			}
 			else if (ITEM_TYPE_ZABBIX == items[i].type)
 			{
-				errcodes[i] = zbx_async_check_agent(&items[i], &results[i], process_agent_result,
-						poller_config, poller_config, poller_config->base, poller_config->dnsbase,
-						poller_config->config_source_ip);
+				zbx_dc_item_t	*item = &items[i];
+
+				/* agent session items are checked when all items of the same interface are known */
+				if (NULL != poller_config->sessions)
+				{
+					zbx_vector_ptr_append(&agent_items, item);
+					continue;
+				}
+
+				async_check_agent(poller_config, items, results, errcodes, &item, 1, NULL);
+				continue;
 			}
 			else
 			{
@@ -296,6 +398,12 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config)
 				poller_config->processing++;
 		}
 
+		if (0 != agent_items.values_num)
+		{
+			async_check_agent_sessions(poller_config, items, results, errcodes, &agent_items);
+			zbx_vector_ptr_clear(&agent_items);
+		}
+
 		zbx_timespec(&timespec);
 
 		/* process item values */
@@ -325,6 +433,7 @@ exit:
 
 	poller_config->queued += total;
 
+	zbx_vector_ptr_destroy(&agent_items);
 	zbx_vector_poller_item_destroy(&poller_items);
 }
 
@@ -342,10 +451,13 @@ static void	async_timer(evutil_socket_t fd, short events, void *arg)
 
 	if (ZBX_IS_RUNNING())
 		zbx_async_manager_queue_sync(poller_config->manager);
+
+	if (NULL != poller_config->sessions)
+		async_session_pool_expire(poller_config->sessions);
 }
 
 static void	async_poller_init(zbx_poller_config_t *poller_config, zbx_thread_poller_args *poller_args_in,
-		int process_num)
+		int process_num, int processes_num)
 {
 	struct timeval	tv = {1, 0};
 	char		*error = NULL;
@@ -362,6 +474,15 @@ static void	async_poller_init(zbx_poller_config_t *poller_config, zbx_thread_pol
 		exit(EXIT_FAILURE);
 	}
 
+	/* HTTP agent checks are driven by libcurl socket callbacks and stay on libevent */
+	if (0 != poller_args_in->config_poller_io_uring && ZBX_POLLER_TYPE_HTTPAGENT != poller_args_in->poller_type &&
+			SUCCEED != zbx_async_poller_uring_init(poller_config->base, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot use io_uring for asynchronous checks, falling back to libevent:"
+				" %s", error);
+		zbx_free(error);
+	}
+
 	poller_config->config_source_ip = poller_args_in->config_comms->config_source_ip;
 	poller_config->config_timeout = poller_args_in->config_comms->config_timeout;
 	poller_config->poller_type = poller_args_in->poller_type;
@@ -372,6 +493,15 @@ static void	async_poller_init(zbx_poller_config_t *poller_config, zbx_thread_pol
 	poller_config->clear_cache = 0;
 	poller_config->process_num = process_num;
 
+	if (0 != poller_args_in->config_poller_agent_sessions && ZBX_POLLER_TYPE_AGENT == poller_args_in->poller_type)
+	{
+		poller_config->sessions = (zbx_async_session_pool_t *)zbx_malloc(NULL,
+				sizeof(zbx_async_session_pool_t));
+		async_session_pool_init(poller_config->sessions);
+	}
+	else
+		poller_config->sessions = NULL;
+
 	if (NULL == (poller_config->async_wake_timer = event_new(poller_config->base, -1, EV_PERSIST, async_wake,
 			poller_config)))
 	{
@@ -391,7 +521,7 @@ static void	async_poller_init(zbx_poller_config_t *poller_config, zbx_thread_pol
 	evtimer_add(poller_config->async_timer, &tv);
 
 	if (NULL == (poller_config->manager = zbx_async_manager_create(1, async_wake_cb,
-			(void *)poller_config->async_wake_timer, poller_args_in, &error)))
+			(void *)poller_config->async_wake_timer, poller_args_in, process_num, processes_num, &error)))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize async manager: %s", error);
 		zbx_free(error);
@@ -440,7 +570,14 @@ static void	async_poller_stop(zbx_poller_config_t *poller_config)
 
 static void	async_poller_destroy(zbx_poller_config_t *poller_config)
 {
+	if (NULL != poller_config->sessions)
+	{
+		async_session_pool_destroy(poller_config->sessions);
+		zbx_free(poller_config->sessions);
+	}
+
 	zbx_async_manager_free(poller_config->manager);
+	zbx_async_poller_uring_destroy();
 	event_base_free(poller_config->base);
 	zbx_hashset_clear(&poller_config->interfaces);
 	zbx_hashset_destroy(&poller_config->interfaces);
@@ -498,7 +635,8 @@ ZBX_THREAD_ENTRY(async_poller_thread, args)
 	zbx_rtc_subscribe(process_type, process_num, rtc_msgs, msgs_num, poller_args_in->config_comms->config_timeout,
 			&rtc);
 
-	async_poller_init(&poller_config, poller_args_in, process_num);
+	async_poller_init(&poller_config, poller_args_in, process_num,
+			poller_args_in->get_process_forks_cb_arg(process_type));
 	rtc_event = event_new(poller_config.base, zbx_ipc_client_get_fd(rtc.client), EV_READ | EV_PERSIST,
 			socket_read_event_cb, NULL);
 	event_add(rtc_event, NULL);
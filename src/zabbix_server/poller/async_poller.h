@@ -24,6 +24,7 @@
 #include "zbxthreads.h"
 #include "zbxcacheconfig.h"
 #include "async_manager.h"
+#include "async_session.h"
 
 typedef struct
 {
@@ -47,6 +48,7 @@ typedef struct
 	struct event_base	*base;
 	struct evdns_base	*dnsbase;
 	zbx_hashset_t		interfaces;
+	zbx_async_session_pool_t	*sessions;	/* passive agent sessions, NULL if disabled */
 #ifdef HAVE_LIBCURL
 	CURLM			*curl_handle;
 #endif
@@ -47,7 +47,8 @@ void	async_task_queue_destroy(zbx_async_queue_t *queue)
 	queue->init_flags = ASYNC_TASK_QUEUE_INIT_NONE;
 }
 
-int	async_task_queue_init(zbx_async_queue_t *queue, zbx_thread_poller_args *poller_args_in, char **error)
+int	async_task_queue_init(zbx_async_queue_t *queue, zbx_thread_poller_args *poller_args_in, int process_num,
+		int processes_num, char **error)
 {
 	int	err, ret = FAIL;
 
@@ -59,6 +60,9 @@ int	async_task_queue_init(zbx_async_queue_t *queue, zbx_thread_poller_args *poll
 	queue->config_unavailable_delay = poller_args_in->config_unavailable_delay;
 	queue->config_unreachable_delay = poller_args_in->config_unreachable_delay;
 	queue->config_unreachable_period = poller_args_in-> config_unreachable_period;
+	queue->items_ownership = (unsigned char)poller_args_in->config_poller_items_ownership;
+	queue->process_num = process_num;
+	queue->processes_num = processes_num;
 
 	zbx_vector_uint64_create(&queue->itemids);
 	zbx_vector_int32_create(&queue->errcodes);
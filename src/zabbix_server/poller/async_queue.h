@@ -37,6 +37,11 @@ typedef struct
 	int				config_unreachable_delay;
 	int				config_unreachable_period;
 
+	/* item ownership by poller process, see async_lease.c */
+	unsigned char			items_ownership;
+	int				process_num;
+	int				processes_num;
+
 	zbx_vector_poller_item_t	poller_items;
 	zbx_vector_interface_status_t	interfaces;
 	zbx_vector_uint64_t		itemids;
@@ -49,7 +54,8 @@ typedef struct
 }
 zbx_async_queue_t;
 
-int	async_task_queue_init(zbx_async_queue_t *queue, zbx_thread_poller_args *poller_args_in, char **error);
+int	async_task_queue_init(zbx_async_queue_t *queue, zbx_thread_poller_args *poller_args_in, int process_num,
+		int processes_num, char **error);
 void	async_task_queue_destroy(zbx_async_queue_t *queue);
 void	async_task_queue_lock(zbx_async_queue_t *queue);
 void	async_task_queue_unlock(zbx_async_queue_t *queue);
@@ -0,0 +1,321 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Passive agent sessions of asynchronous agent pollers.
+ *
+ * Checks of the same interface are sent to agent in one passive checks batch request. Agent answers them in
+ * order and keeps the connection open for the session timeout returned in response, so the poller keeps one
+ * idle connection per interface and reuses it for the next batch request. Support of batch requests is probed
+ * with the first check of interface - older agents reply with ZBX_NOTSUPPORTED and their checks are sent one
+ * per connection until support is probed again after renegotiation period.
+ */
+
+#include "async_session.h"
+
+#include "zbxcommon.h"
+#include "zbxstr.h"
+
+#define ASYNC_SESSION_RENEGOTIATE_PERIOD	SEC_PER_HOUR
+#define ASYNC_SESSION_FORGET_PERIOD		SEC_PER_HOUR
+#define ASYNC_SESSION_FLUSH_INTERVAL		5
+
+void	async_session_pool_init(zbx_async_session_pool_t *pool)
+{
+	zbx_hashset_create(&pool->sessions, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	memset(&pool->stats, 0, sizeof(pool->stats));
+	pool->idle_delta = 0;
+	pool->flush_time = time(NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close idle connection of agent session                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_session_close(zbx_async_session_pool_t *pool, zbx_async_session_t *session)
+{
+	if (NULL == session->s)
+		return;
+
+	zbx_tcp_close(session->s);
+	zbx_free(session->s);
+	zbx_free(session->addr);
+	zbx_free(session->tls_arg1);
+	zbx_free(session->tls_arg2);
+	session->idle_timeout = 0;
+
+	pool->idle_delta--;
+}
+
+static void	async_session_pool_flush(zbx_async_session_pool_t *pool, time_t now)
+{
+	zbx_dc_agent_session_stats_t	empty = {0};
+
+	if (0 != pool->idle_delta || 0 != memcmp(&pool->stats, &empty, sizeof(empty)))
+	{
+		zbx_dc_add_agent_session_stats(&pool->stats, pool->idle_delta);
+		memset(&pool->stats, 0, sizeof(pool->stats));
+		pool->idle_delta = 0;
+	}
+
+	pool->flush_time = now;
+}
+
+void	async_session_pool_destroy(zbx_async_session_pool_t *pool)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_async_session_t	*session;
+
+	zbx_hashset_iter_reset(&pool->sessions, &iter);
+	while (NULL != (session = (zbx_async_session_t *)zbx_hashset_iter_next(&iter)))
+		async_session_close(pool, session);
+
+	async_session_pool_flush(pool, time(NULL));
+	zbx_hashset_destroy(&pool->sessions);
+}
+
+static zbx_async_session_t	*async_session_get(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid)
+{
+	zbx_async_session_t	*session;
+
+	if (NULL == (session = (zbx_async_session_t *)zbx_hashset_search(&pool->sessions, &interfaceid)))
+	{
+		zbx_async_session_t	session_local = {.interfaceid = interfaceid};
+
+		session = (zbx_async_session_t *)zbx_hashset_insert(&pool->sessions, &session_local,
+				sizeof(session_local));
+	}
+
+	session->lastaccess = time(NULL);
+
+	return session;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get batch request support of interface agent                      *
+ *                                                                            *
+ * Return value: ASYNC_SESSION_UNKNOWN     - support must be probed           *
+ *               ASYNC_SESSION_PROBING     - support is being probed          *
+ *               ASYNC_SESSION_SUPPORTED   - batch requests are supported     *
+ *               ASYNC_SESSION_UNSUPPORTED - batch requests are not supported *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	async_session_get_support(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid)
+{
+	zbx_async_session_t	*session;
+
+	session = async_session_get(pool, interfaceid);
+
+	if (ASYNC_SESSION_UNSUPPORTED == session->support &&
+			ASYNC_SESSION_RENEGOTIATE_PERIOD <= session->lastaccess - session->support_time)
+	{
+		session->support = ASYNC_SESSION_UNKNOWN;
+	}
+
+	return session->support;
+}
+
+void	async_session_set_support(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid, unsigned char support)
+{
+	zbx_async_session_t	*session;
+
+	session = async_session_get(pool, interfaceid);
+
+	if (ASYNC_SESSION_UNSUPPORTED == support)
+	{
+		if (ASYNC_SESSION_UNSUPPORTED != session->support)
+			pool->stats.fallbacks++;
+
+		async_session_close(pool, session);
+	}
+
+	session->support = support;
+	session->support_time = session->lastaccess;
+}
+
+static int	async_session_match(const zbx_async_session_t *session, const char *addr, unsigned short port,
+		unsigned char tls_connect, const char *tls_arg1, const char *tls_arg2)
+{
+	if (port != session->port || tls_connect != session->tls_connect || 0 != strcmp(addr, session->addr))
+		return FAIL;
+
+	if (0 != zbx_strcmp_null(tls_arg1, session->tls_arg1) || 0 != zbx_strcmp_null(tls_arg2, session->tls_arg2))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: take idle connection of interface agent session                   *
+ *                                                                            *
+ * Parameters: pool        - [IN]                                             *
+ *             interfaceid - [IN]                                             *
+ *             addr        - [IN] the interface address                       *
+ *             port        - [IN] the interface port                          *
+ *             tls_connect - [IN] the connection type                         *
+ *             tls_arg1    - [IN] the issuer or PSK identity                  *
+ *             tls_arg2    - [IN] the subject or PSK                          *
+ *             s           - [OUT] the connection                             *
+ *                                                                            *
+ * Return value: SUCCEED - open connection was returned                       *
+ *               FAIL    - there is no usable idle connection                 *
+ *                                                                            *
+ ******************************************************************************/
+int	async_session_acquire(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid, const char *addr,
+		unsigned short port, unsigned char tls_connect, const char *tls_arg1, const char *tls_arg2,
+		zbx_socket_t *s)
+{
+	zbx_async_session_t	*session;
+	ssize_t			n;
+	char			buf;
+
+	if (NULL == (session = (zbx_async_session_t *)zbx_hashset_search(&pool->sessions, &interfaceid)) ||
+			NULL == session->s)
+	{
+		return FAIL;
+	}
+
+	session->lastaccess = time(NULL);
+
+	/* leave a second for the request to reach agent before it closes the connection */
+	if (session->idle_timeout - 1 <= session->lastaccess - session->idle_since ||
+			SUCCEED != async_session_match(session, addr, port, tls_connect, tls_arg1, tls_arg2))
+	{
+		goto expire;
+	}
+
+	n = recv(session->s->socket, &buf, 1, MSG_PEEK | MSG_DONTWAIT);
+
+	/* connection was closed by agent or has unexpected data, TLS records are allowed between requests */
+	if (0 == n || (0 > n && EAGAIN != errno && EWOULDBLOCK != errno) ||
+			(0 < n && ZBX_TCP_SEC_UNENCRYPTED == session->s->connection_type))
+	{
+		goto expire;
+	}
+
+	memcpy(s, session->s, sizeof(zbx_socket_t));
+	s->buf_type = ZBX_BUF_TYPE_STAT;
+	s->buffer = s->buf_stat;
+
+	zbx_free(session->s);
+	zbx_free(session->addr);
+	zbx_free(session->tls_arg1);
+	zbx_free(session->tls_arg2);
+	session->idle_timeout = 0;
+
+	pool->idle_delta--;
+	pool->stats.reused++;
+
+	return SUCCEED;
+expire:
+	async_session_close(pool, session);
+	pool->stats.expired++;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keep connection as idle connection of interface agent session     *
+ *                                                                            *
+ * Parameters: pool         - [IN]                                            *
+ *             interfaceid  - [IN]                                            *
+ *             addr         - [IN] the interface address                      *
+ *             port         - [IN] the interface port                         *
+ *             tls_connect  - [IN] the connection type                        *
+ *             tls_arg1     - [IN] the issuer or PSK identity                 *
+ *             tls_arg2     - [IN] the subject or PSK                         *
+ *             s            - [IN/OUT] the connection, it is either kept or   *
+ *                                     closed                                 *
+ *             idle_timeout - [IN] the session timeout returned by agent      *
+ *                                                                            *
+ ******************************************************************************/
+void	async_session_release(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid, const char *addr,
+		unsigned short port, unsigned char tls_connect, const char *tls_arg1, const char *tls_arg2,
+		zbx_socket_t *s, int idle_timeout)
+{
+	zbx_async_session_t	*session;
+
+	session = async_session_get(pool, interfaceid);
+
+	/* only one idle connection is kept per interface */
+	if (NULL != session->s || 1 >= idle_timeout || ASYNC_SESSION_UNSUPPORTED == session->support)
+	{
+		zbx_tcp_close(s);
+		zbx_socket_clean(s);
+		return;
+	}
+
+	if (ZBX_BUF_TYPE_DYN == s->buf_type)
+		zbx_free(s->buffer);
+
+	session->s = (zbx_socket_t *)zbx_malloc(NULL, sizeof(zbx_socket_t));
+	memcpy(session->s, s, sizeof(zbx_socket_t));
+	session->s->buf_type = ZBX_BUF_TYPE_STAT;
+	session->s->buffer = session->s->buf_stat;
+
+	session->idle_timeout = idle_timeout;
+	session->idle_since = session->lastaccess;
+	session->addr = zbx_strdup(NULL, addr);
+	session->port = port;
+	session->tls_connect = tls_connect;
+	session->tls_arg1 = (NULL != tls_arg1 ? zbx_strdup(NULL, tls_arg1) : NULL);
+	session->tls_arg2 = (NULL != tls_arg2 ? zbx_strdup(NULL, tls_arg2) : NULL);
+
+	pool->idle_delta++;
+
+	zbx_socket_clean(s);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close expired idle connections, forget unused interfaces and      *
+ *          flush statistics to configuration cache                           *
+ *                                                                            *
+ ******************************************************************************/
+void	async_session_pool_expire(zbx_async_session_pool_t *pool)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_async_session_t	*session;
+	time_t			now;
+
+	now = time(NULL);
+
+	zbx_hashset_iter_reset(&pool->sessions, &iter);
+	while (NULL != (session = (zbx_async_session_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL != session->s && session->idle_timeout - 1 <= now - session->idle_since)
+		{
+			async_session_close(pool, session);
+			pool->stats.expired++;
+		}
+
+		if (NULL == session->s && ASYNC_SESSION_PROBING != session->support &&
+				ASYNC_SESSION_FORGET_PERIOD <= now - session->lastaccess)
+		{
+			zbx_hashset_iter_remove(&iter);
+		}
+	}
+
+	if (ASYNC_SESSION_FLUSH_INTERVAL <= now - pool->flush_time)
+		async_session_pool_flush(pool, now);
+}
@@ -0,0 +1,82 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ASYNC_SESSION_H
+#define ZABBIX_ASYNC_SESSION_H
+
+#include "zbxalgo.h"
+#include "zbxcacheconfig.h"
+#include "zbxcomms.h"
+
+#define ASYNC_SESSION_BATCH_MAX		32		/* the maximum number of checks in one batch request */
+#define ASYNC_SESSION_BATCH_TIMEOUT_MAX	SEC_PER_MIN	/* the maximum sum of check timeouts in one batch */
+
+typedef enum
+{
+	ASYNC_SESSION_UNKNOWN = 0,
+	ASYNC_SESSION_PROBING,
+	ASYNC_SESSION_SUPPORTED,
+	ASYNC_SESSION_UNSUPPORTED
+}
+zbx_async_session_support_t;
+
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	unsigned char	support;
+	time_t		support_time;
+	time_t		lastaccess;
+
+	/* idle connection kept for the next batch request, NULL if there is none */
+	zbx_socket_t	*s;
+	int		idle_timeout;
+	time_t		idle_since;
+	char		*addr;
+	unsigned short	port;
+	unsigned char	tls_connect;
+	char		*tls_arg1;
+	char		*tls_arg2;
+}
+zbx_async_session_t;
+
+typedef struct
+{
+	/* agent sessions by interfaceid */
+	zbx_hashset_t			sessions;
+
+	/* statistics collected since the last flush to configuration cache */
+	zbx_dc_agent_session_stats_t	stats;
+	int				idle_delta;
+	time_t				flush_time;
+}
+zbx_async_session_pool_t;
+
+void	async_session_pool_init(zbx_async_session_pool_t *pool);
+void	async_session_pool_destroy(zbx_async_session_pool_t *pool);
+unsigned char	async_session_get_support(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid);
+void	async_session_set_support(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid, unsigned char support);
+int	async_session_acquire(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid, const char *addr,
+		unsigned short port, unsigned char tls_connect, const char *tls_arg1, const char *tls_arg2,
+		zbx_socket_t *s);
+void	async_session_release(zbx_async_session_pool_t *pool, zbx_uint64_t interfaceid, const char *addr,
+		unsigned short port, unsigned char tls_connect, const char *tls_arg1, const char *tls_arg2,
+		zbx_socket_t *s, int idle_timeout);
+void	async_session_pool_expire(zbx_async_session_pool_t *pool);
+
+#endif
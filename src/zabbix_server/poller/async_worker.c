@@ -19,6 +19,7 @@
 
 #include "async_manager.h"
 #include "async_worker.h"
+#include "async_lease.h"
 #include "zbxalgo.h"
 #include "zbxtime.h"
 #include "zbxthreads.h"
@@ -31,31 +32,66 @@
 #define ASYNC_WORKER_INIT_NONE		0x00
 #define ASYNC_WORKER_INIT_THREAD	0x01
 
-static zbx_poller_item_t	*dc_config_async_get_poller_items(const zbx_async_queue_t *queue)
+static zbx_poller_item_t	*async_poller_item_create(zbx_dc_item_t *items, int num)
 {
 	zbx_poller_item_t	*poller_item;
 
 	poller_item = zbx_malloc(NULL, sizeof(zbx_poller_item_t));
-	poller_item->items = NULL;
+	poller_item->items = items;
+	poller_item->num = num;
+	poller_item->results = zbx_malloc(NULL, (size_t)num * sizeof(AGENT_RESULT));
+	poller_item->errcodes = zbx_malloc(NULL, (size_t)num * sizeof(int));
 
-	poller_item->num = zbx_dc_config_get_poller_items(queue->poller_type, queue->config_timeout,
-			queue->processing_num, queue->processing_limit, &poller_item->items);
+	zbx_prepare_items(poller_item->items, poller_item->errcodes, poller_item->num, poller_item->results,
+			ZBX_MACRO_EXPAND_YES);
 
-	if (0 != poller_item->num)
-	{
-		poller_item->results = zbx_malloc(NULL, (size_t)poller_item->num * sizeof(AGENT_RESULT));
-		poller_item->errcodes = zbx_malloc(NULL, (size_t)poller_item->num * sizeof(int));
+	return poller_item;
+}
+
+static zbx_poller_item_t	*dc_config_async_get_poller_items(const zbx_async_queue_t *queue, int processing)
+{
+	zbx_dc_item_t	*items = NULL;
+	int		num;
 
-		zbx_prepare_items(poller_item->items, poller_item->errcodes, poller_item->num, poller_item->results,
-				ZBX_MACRO_EXPAND_YES);
+	if (0 == (num = zbx_dc_config_get_poller_items(queue->poller_type, queue->config_timeout, processing,
+			queue->processing_limit, &items)))
+	{
+		zbx_free(items);
+		return NULL;
 	}
-	else
+
+	return async_poller_item_create(items, num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: return items released by owner to poller queue                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_worker_release_items(const zbx_async_queue_t *queue, zbx_vector_uint64_t *released)
+{
+	int	*lastclocks, *errcodes, now, nextcheck;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "release owned items num:%d", released->values_num);
+
+	lastclocks = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)released->values_num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)released->values_num);
+
+	now = (int)time(NULL);
+
+	for (int i = 0; i < released->values_num; i++)
 	{
-		zbx_free(poller_item->items);
-		zbx_free(poller_item);
+		lastclocks[i] = now;
+		errcodes[i] = SUCCEED;
 	}
 
-	return poller_item;
+	zbx_dc_poller_requeue_items(released->values, lastclocks, errcodes, (size_t)released->values_num,
+			queue->poller_type, &nextcheck);
+
+	zbx_free(errcodes);
+	zbx_free(lastclocks);
+
+	zbx_vector_uint64_clear(released);
 }
 
 static void	poller_update_interfaces(zbx_vector_interface_status_t *interfaces,
@@ -138,6 +174,8 @@ static void	*async_worker_entry(void *args)
 	zbx_vector_uint64_t		itemids;
 	zbx_vector_int32_t		errcodes;
 	zbx_vector_int32_t		lastclocks;
+	zbx_vector_uint64_t		released;
+	zbx_async_lease_t		lease, *please = NULL;
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "thread started");
 
@@ -162,10 +200,17 @@ static void	*async_worker_entry(void *args)
 	zbx_vector_uint64_create(&itemids);
 	zbx_vector_int32_create(&errcodes);
 	zbx_vector_int32_create(&lastclocks);
+	zbx_vector_uint64_create(&released);
+
+	if (0 != queue->items_ownership)
+	{
+		async_lease_init(&lease, queue->poller_type, queue->process_num, queue->processes_num);
+		please = &lease;
+	}
 
 	while (0 == worker->stop)
 	{
-		zbx_poller_item_t	*poller_item = NULL;
+		zbx_poller_item_t	*poller_item = NULL, *owned_item = NULL;
 		unsigned char		check_queue = queue->check_queue;
 
 		queue->check_queue = 0;
@@ -204,6 +249,17 @@ static void	*async_worker_entry(void *args)
 			zbx_vector_interface_status_clear_ext(&interfaces, zbx_interface_status_free);
 		}
 
+		if (NULL != please)
+		{
+			if (0 != itemids.values_num)
+				async_lease_requeue(please, &itemids, &errcodes, &lastclocks);
+
+			async_lease_sync(please, &released);
+
+			if (0 != released.values_num)
+				async_worker_release_items(queue, &released);
+		}
+
 		if (0 != itemids.values_num)
 		{
 			int	nextcheck;
@@ -223,21 +279,66 @@ static void	*async_worker_entry(void *args)
 			zabbix_log(LOG_LEVEL_DEBUG, "requeue items nextcheck:%d", nextcheck);
 		}
 
+		if (NULL != please && 0 == check_queue)
+		{
+			int	nextcheck;
+
+			if (FAIL != (nextcheck = async_lease_nextcheck(please)) && nextcheck <= time(NULL))
+				check_queue = 1;
+		}
+
 		/* only check queue if requested to preserve resources */
 		if (1 == check_queue)
 		{
-			poller_item = dc_config_async_get_poller_items(queue);
-
-			zabbix_log(LOG_LEVEL_DEBUG, "queue processing_num:" ZBX_FS_UI64 " pending:%d",
-					queue->processing_num, queue->poller_items.values_num);
+			int	processing = (int)queue->processing_num, nextcheck;
+
+			if (NULL != please)
+			{
+				zbx_dc_item_t	*items;
+				int		num;
+
+				if (0 != (num = async_lease_get_items(please, (int)queue->processing_limit - processing,
+						&items, &released)))
+				{
+					owned_item = async_poller_item_create(items, num);
+					processing += num;
+				}
+
+				if (0 != released.values_num)
+					async_worker_release_items(queue, &released);
+			}
+
+			/* owned items are not in poller queue, avoid locking it for writing when nothing is due */
+			if (NULL == please || (FAIL != (nextcheck = zbx_dc_config_get_poller_nextcheck(
+					queue->poller_type)) && nextcheck <= time(NULL)))
+			{
+				if (NULL != (poller_item = dc_config_async_get_poller_items(queue, processing)) &&
+						NULL != please)
+				{
+					async_lease_acquire(please, poller_item->items, poller_item->num);
+				}
+			}
+
+			zabbix_log(LOG_LEVEL_DEBUG, "queue processing_num:" ZBX_FS_UI64 " pending:%d owned:%d",
+					queue->processing_num, queue->poller_items.values_num,
+					NULL != please ? please->items.num_data : 0);
 		}
 
 		async_task_queue_lock(queue);
 
-		if (NULL != poller_item)
+		if (NULL != poller_item || NULL != owned_item)
 		{
-			queue->processing_num += poller_item->num;
-			zbx_vector_poller_item_append(&queue->poller_items, poller_item);
+			if (NULL != owned_item)
+			{
+				queue->processing_num += owned_item->num;
+				zbx_vector_poller_item_append(&queue->poller_items, owned_item);
+			}
+
+			if (NULL != poller_item)
+			{
+				queue->processing_num += poller_item->num;
+				zbx_vector_poller_item_append(&queue->poller_items, poller_item);
+			}
 
 			if (NULL != worker->finished_cb)
 				worker->finished_cb(worker->finished_data);
@@ -257,6 +358,10 @@ static void	*async_worker_entry(void *args)
 	zbx_vector_interface_status_clear_ext(&interfaces, zbx_interface_status_free);
 	zbx_vector_interface_status_destroy(&interfaces);
 
+	if (NULL != please)
+		async_lease_destroy(please);
+
+	zbx_vector_uint64_destroy(&released);
 	zbx_vector_int32_destroy(&lastclocks);
 	zbx_vector_int32_destroy(&errcodes);
 	zbx_vector_uint64_destroy(&itemids);
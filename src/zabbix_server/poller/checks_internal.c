@@ -948,6 +948,54 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 
 		SET_UI64_RESULT(result, size);
 	}
+	else if (0 == strcmp(tmp, "agent_sessions"))		/* zabbix[agent_sessions,<mode>] */
+	{
+		zbx_dc_agent_session_stats_t	stats;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 1);
+
+		zbx_dc_get_agent_session_stats(&stats);
+
+		if (0 == strcmp(tmp, "connections"))
+		{
+			SET_UI64_RESULT(result, stats.connections);
+		}
+		else if (0 == strcmp(tmp, "reused"))
+		{
+			SET_UI64_RESULT(result, stats.reused);
+		}
+		else if (0 == strcmp(tmp, "expired"))
+		{
+			SET_UI64_RESULT(result, stats.expired);
+		}
+		else if (0 == strcmp(tmp, "requests"))
+		{
+			SET_UI64_RESULT(result, stats.requests);
+		}
+		else if (0 == strcmp(tmp, "checks"))
+		{
+			SET_UI64_RESULT(result, stats.checks);
+		}
+		else if (0 == strcmp(tmp, "fallbacks"))
+		{
+			SET_UI64_RESULT(result, stats.fallbacks);
+		}
+		else if (0 == strcmp(tmp, "idle"))
+		{
+			SET_UI64_RESULT(result, stats.idle);
+		}
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
 	else if (0 == strcmp(tmp, "tcache"))			/* zabbix[tcache,cache,<parameter>] */
 	{
 		char		*error = NULL;
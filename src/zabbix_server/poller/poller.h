@@ -34,6 +34,10 @@ typedef struct
 	int			config_unreachable_period;
 	int			config_unreachable_delay;
 	int			config_max_concurrent_checks_per_poller;
+	int			config_poller_items_ownership;
+	int			config_poller_io_uring;
+	int			config_poller_agent_sessions;
+	zbx_get_config_forks_f	get_process_forks_cb_arg;
 }
 zbx_thread_poller_args;
 
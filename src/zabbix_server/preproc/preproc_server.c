@@ -38,7 +38,7 @@ void	preproc_flush_value_server(zbx_pp_manager_t *manager, zbx_uint64_t itemid,
 	{
 		zbx_pp_item_t	*item;
 
-		if (NULL != (item = (zbx_pp_item_t *)zbx_hashset_search(zbx_pp_manager_items(manager), &itemid)))
+		if (NULL != (item = (zbx_pp_item_t *)zbx_flathashset_search(zbx_pp_manager_items(manager), &itemid)))
 		{
 			const char	*value_lld = NULL, *error_lld = NULL;
 			unsigned char	meta = 0;
@@ -121,8 +121,8 @@ const char	*help_message[] = {
 	"      " ZBX_SECRETS_RELOAD "                  Reload secrets from Vault",
 	"      " ZBX_DIAGINFO "=section                Log internal diagnostic information of the",
 	"                                        section (historycache, preprocessing, alerting,",
-	"                                        lld, valuecache, locks, connector) or everything if section is",
-	"                                        not specified",
+	"                                        lld, valuecache, locks, connector, configcache) or",
+	"                                        everything if section is not specified",
 	"      " ZBX_PROF_ENABLE "=target              Enable profiling, affects all processes if",
 	"                                        target is not specified",
 	"      " ZBX_PROF_DISABLE "=target             Disable profiling, affects all processes if",
@@ -280,6 +280,7 @@ int	zbx_config_trapper_timeout = 300;
 static int	config_startup_time		= 0;
 static int	config_unavailable_delay	= 60;
 static int	config_histsyncer_frequency	= 1;
+static int	config_history_sync_pipeline	= 0;
 
 static int	zbx_config_listen_port		= ZBX_DEFAULT_SERVER_PORT;
 static char	*zbx_config_listen_ip		= NULL;
@@ -298,6 +299,7 @@ static int	config_vmware_timeout		= 10;
 static zbx_uint64_t	config_conf_cache_size		= 32 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
+static int		config_history_cache_shards	= 1;
 static zbx_uint64_t	config_trends_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_value_cache_size		= 8 * ZBX_MEBIBYTE;
@@ -306,6 +308,10 @@ static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
 static int	config_unreachable_period		= 45;
 static int	config_unreachable_delay		= 15;
 static int	config_max_concurrent_checks_per_poller	= 1000;
+static int	config_poller_items_ownership		= 0;
+static int	config_poller_io_uring			= 0;
+static int	config_poller_agent_sessions		= 0;
+static int	config_lld_skip_unchanged_period	= SEC_PER_HOUR;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
 int	CONFIG_ALLOW_UNSUPPORTED_DB_VERSIONS = 0;
@@ -338,7 +344,7 @@ char	*CONFIG_SSL_CERT_LOCATION	= NULL;
 char	*CONFIG_SSL_KEY_LOCATION	= NULL;
 
 static zbx_config_tls_t		*zbx_config_tls = NULL;
-static zbx_config_export_t	zbx_config_export = {NULL, NULL, ZBX_GIBIBYTE};
+static zbx_config_export_t	zbx_config_export = {NULL, NULL, ZBX_GIBIBYTE, 1, 0, 0, 1};
 static zbx_config_vault_t	zbx_config_vault = {NULL, NULL, NULL, NULL, NULL, NULL};
 static zbx_config_dbhigh_t	*zbx_config_dbhigh = NULL;
 
@@ -685,6 +691,20 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (ZBX_HC_SHARD_SIZE_MIN > config_history_cache_size / (zbx_uint64_t)config_history_cache_shards)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"HistoryCacheSize\" configuration parameter must be at least 128KB"
+				" per history cache shard (\"HistoryCacheShards\" is %d)", config_history_cache_shards);
+		err = 1;
+	}
+
+	if (ZBX_HC_SHARD_SIZE_MIN > config_history_index_cache_size / (zbx_uint64_t)config_history_cache_shards)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"HistoryIndexCacheSize\" configuration parameter must be at least 128KB"
+				" per history cache shard (\"HistoryCacheShards\" is %d)", config_history_cache_shards);
+		err = 1;
+	}
+
 	if (0 != config_value_cache_size && 128 * ZBX_KIBIBYTE > config_value_cache_size)
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "\"ValueCacheSize\" configuration parameter must be either 0"
@@ -814,6 +834,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			MANDATORY,	MIN,			MAX */
 		{"StartDBSyncers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER],		TYPE_INT,
 			PARM_OPT,	1,			100},
+		{"HistorySyncPipeline",		&config_history_sync_pipeline,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"StartDiscoverers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_DISCOVERER],		TYPE_INT,
 			PARM_OPT,	0,			1000},
 		{"StartHTTPPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPPOLLER],		TYPE_INT,
@@ -848,6 +870,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheShards",		&config_history_cache_shards,		TYPE_INT,
+			PARM_OPT,	1,			ZBX_HC_SHARDS_MAX},
 		{"TrendCacheSize",		&config_trends_cache_size,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"TrendFunctionCacheSize",	&CONFIG_TREND_FUNC_CACHE_SIZE,		TYPE_UINT64,
@@ -1008,8 +1032,18 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"ExportFileSize",		&(zbx_config_export.file_size),		TYPE_UINT64,
 			PARM_OPT,	ZBX_MEBIBYTE,	ZBX_GIBIBYTE},
+		{"ExportFileCount",		&(zbx_config_export.file_count),		TYPE_INT,
+			PARM_OPT,	1,			100},
+		{"ExportCompress",		&(zbx_config_export.compress),		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"ExportFsync",			&(zbx_config_export.fsync),			TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"ExportAsync",			&(zbx_config_export.async),			TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"StartLLDProcessors",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_LLDWORKER],		TYPE_INT,
 			PARM_OPT,	1,			100},
+		{"LLDSkipUnchangedPeriod",	&config_lld_skip_unchanged_period,	TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY},
 		{"StatsAllowedIP",		&CONFIG_STATS_ALLOWED_IP,		TYPE_STRING_LIST,
 			PARM_OPT,	0,			0},
 		{"StartHistoryPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTORYPOLLER],		TYPE_INT,
@@ -1040,6 +1074,12 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"MaxConcurrentChecksPerPoller",	&config_max_concurrent_checks_per_poller,	TYPE_INT,
 			PARM_OPT,	1,			1000},
+		{"PollerItemsOwnership",	&config_poller_items_ownership,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"PollerIoUring",		&config_poller_io_uring,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"PollerAgentSessions",		&config_poller_agent_sessions,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"VPSLimit",			&config_vps_limit,	TYPE_INT,
 			PARM_OPT,	0,			ZBX_MEBIBYTE},
 		{"VPSOvercommitLimit",		&config_vps_overcommit_limit,	TYPE_INT,
@@ -1406,7 +1446,9 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 	zbx_thread_poller_args		poller_args = {&config_comms, get_program_type, ZBX_NO_POLLER,
 							config_startup_time, config_unavailable_delay,
 							config_unreachable_period, config_unreachable_delay,
-							config_max_concurrent_checks_per_poller};
+							config_max_concurrent_checks_per_poller,
+							config_poller_items_ownership, config_poller_io_uring,
+							config_poller_agent_sessions, get_config_forks};
 	zbx_thread_trapper_args		trapper_args = {&config_comms, &zbx_config_vault, get_program_type,
 							&events_cbs, listen_sock, config_startup_time,
 							config_proxydata_frequency, get_config_forks};
@@ -1447,16 +1489,18 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 	zbx_thread_alert_syncer_args	alert_syncer_args = {CONFIG_CONFSYNCER_FREQUENCY};
 	zbx_thread_alert_manager_args	alert_manager_args = {get_config_forks, get_zbx_config_alert_scripts_path,
 			zbx_config_dbhigh, zbx_config_source_ip};
-	zbx_thread_lld_manager_args	lld_manager_args = {get_config_forks};
+	zbx_thread_lld_manager_args	lld_manager_args = {get_config_forks, config_lld_skip_unchanged_period};
 	zbx_thread_connector_manager_args	connector_manager_args = {get_config_forks};
-	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency};
+	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency,
+								config_history_sync_pipeline};
 	zbx_thread_vmware_args			vmware_args = {zbx_config_source_ip, config_vmware_frequency,
 								config_vmware_perf_frequency, config_vmware_timeout};
 	zbx_thread_timer_args		timer_args = {get_config_forks};
 	zbx_thread_snmptrapper_args	snmptrapper_args = {zbx_config_snmptrap_file};
 
 	if (SUCCEED != zbx_init_database_cache(get_program_type, zbx_sync_server_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, config_history_cache_shards, &config_trends_cache_size,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -2090,7 +2134,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_database_cache(get_program_type, zbx_sync_server_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, config_history_cache_shards, &config_trends_cache_size,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
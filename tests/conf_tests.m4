@@ -56,14 +56,17 @@ AC_DEFUN([CONF_TESTS],
 			tests/Makefile
 			tests/libs/Makefile
 			tests/libs/zbxalgo/Makefile
+			tests/libs/zbxasyncpoller/Makefile
 			tests/libs/zbxcommon/Makefile
 			tests/libs/zbxcomms/Makefile
 			tests/libs/zbxcommshigh/Makefile
 			tests/libs/zbxconf/Makefile
 			tests/libs/zbxdbcache/Makefile
 			tests/libs/zbxdbhigh/Makefile
+			tests/libs/zbxexport/Makefile
 			tests/libs/zbxeval/Makefile
 			tests/libs/zbxhistory/Makefile
+			tests/libs/zbxipcservice/Makefile
 			tests/libs/zbxjson/Makefile
 			tests/libs/zbxmodules/Makefile
 			tests/libs/zbxpoller/Makefile
@@ -71,13 +74,16 @@ AC_DEFUN([CONF_TESTS],
 			tests/libs/zbxprometheus/Makefile
 			tests/libs/zbxregexp/Makefile
 			tests/libs/zbxexpression/Makefile
+			tests/libs/zbxshmem/Makefile
 			tests/libs/zbxsysinfo/Makefile
 			tests/libs/zbxsysinfo/common/Makefile
 			tests/libs/zbxtagfilter/Makefile
 			tests/libs/zbxtrends/Makefile
 			tests/libs/zbxtime/Makefile
 			tests/zabbix_server/Makefile
+			tests/zabbix_server/lld/Makefile
 			tests/zabbix_server/pinger/Makefile
+			tests/zabbix_server/poller/Makefile
 			tests/zabbix_server/service/Makefile
 			tests/zabbix_server/trapper/Makefile
 			tests/mocks/Makefile
@@ -0,0 +1,273 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	value;
+}
+fhs_test_elem_t;
+
+/* the number of distinct hashes, 0 - default hash function is used */
+static zbx_uint64_t	hashes_num;
+
+static int	cleaned_num, blocks_num;
+
+static zbx_hash_t	fhs_test_hash(const void *data)
+{
+	const fhs_test_elem_t	*elem = (const fhs_test_elem_t *)data;
+	zbx_uint64_t		key;
+
+	if (0 == hashes_num)
+		return ZBX_DEFAULT_UINT64_HASH_FUNC(&elem->id);
+
+	/* force elements to share the same hash and control bytes */
+	key = elem->id % hashes_num;
+
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(&key);
+}
+
+static void	fhs_test_clean(void *data)
+{
+	ZBX_UNUSED(data);
+
+	cleaned_num++;
+}
+
+static void	*fhs_test_malloc(void *old, size_t size)
+{
+	blocks_num++;
+
+	return zbx_malloc(old, size);
+}
+
+static void	fhs_test_free(void *ptr)
+{
+	blocks_num--;
+
+	zbx_free(ptr);
+}
+
+static fhs_test_elem_t	*fhs_test_insert(zbx_flathashset_t *fhs, zbx_uint64_t id)
+{
+	fhs_test_elem_t	elem_local = {id, id * 10}, *elem;
+
+	if (NULL == (elem = (fhs_test_elem_t *)zbx_flathashset_insert(fhs, &elem_local, sizeof(elem_local))))
+		fail_msg("cannot insert element " ZBX_FS_UI64, id);
+
+	return elem;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks that flat hashset contains elements with identifiers from  *
+ *          1 to ids_num, except the removed ones                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	fhs_test_check(zbx_flathashset_t *fhs, zbx_uint64_t ids_num, const unsigned char *removed)
+{
+	zbx_flathashset_iter_t	iter;
+	fhs_test_elem_t		*elem, elem_local;
+	zbx_uint64_t		id;
+	int			num = 0;
+	unsigned char		*seen;
+
+	for (id = 1; id <= ids_num; id++)
+	{
+		elem_local.id = id;
+		elem = (fhs_test_elem_t *)zbx_flathashset_search(fhs, &elem_local);
+
+		if (0 != removed[id])
+		{
+			zbx_mock_assert_ptr_eq("removed element", NULL, elem);
+			continue;
+		}
+
+		if (NULL == elem)
+			fail_msg("cannot find element " ZBX_FS_UI64, id);
+
+		zbx_mock_assert_uint64_eq("element value", id * 10, elem->value);
+		num++;
+	}
+
+	zbx_mock_assert_int_eq("number of elements", num, fhs->num_data);
+
+	/* load factor must be kept below 7/8 including deleted slots */
+	if (fhs->num_slots / 8 * 7 < fhs->num_data + fhs->num_deleted)
+	{
+		fail_msg("%d used and %d deleted slots exceed maximum load of %d slots", fhs->num_data,
+				fhs->num_deleted, fhs->num_slots);
+	}
+
+	if (0 != (fhs->num_slots & (fhs->num_slots - 1)))
+		fail_msg("number of slots %d is not power of two", fhs->num_slots);
+
+	/* every element must be iterated exactly once */
+	seen = (unsigned char *)zbx_calloc(NULL, ids_num + 1, 1);
+	num = 0;
+
+	zbx_flathashset_iter_reset(fhs, &iter);
+
+	while (NULL != (elem = (fhs_test_elem_t *)zbx_flathashset_iter_next(&iter)))
+	{
+		if (1 > elem->id || ids_num < elem->id || 0 != removed[elem->id])
+			fail_msg("unexpected element " ZBX_FS_UI64 " while iterating", elem->id);
+
+		if (0 != seen[elem->id]++)
+			fail_msg("element " ZBX_FS_UI64 " was iterated twice", elem->id);
+
+		num++;
+	}
+
+	zbx_mock_assert_int_eq("number of iterated elements", fhs->num_data, num);
+
+	zbx_free(seen);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_flathashset_t	fhs;
+	zbx_flathashset_iter_t	iter;
+	fhs_test_elem_t		*elem, elem_local;
+	zbx_uint64_t		ids_num, remove_step, id;
+	unsigned char		*removed;
+	int			num_slots, removed_num = 0;
+
+	ZBX_UNUSED(state);
+
+	ids_num = zbx_mock_get_parameter_uint64("in.elements");
+	remove_step = zbx_mock_get_parameter_uint64("in.remove_step");
+	hashes_num = zbx_mock_get_parameter_uint64("in.hashes");
+
+	removed = (unsigned char *)zbx_calloc(NULL, ids_num + 1, 1);
+
+	zbx_flathashset_create_ext(&fhs, zbx_mock_get_parameter_uint64("in.init_size"), sizeof(fhs_test_elem_t),
+			fhs_test_hash, ZBX_DEFAULT_UINT64_COMPARE_FUNC, fhs_test_clean, fhs_test_malloc,
+			fhs_test_free);
+
+	/* insert elements, growing the slot array */
+	for (id = 1; id <= ids_num; id++)
+	{
+		elem = fhs_test_insert(&fhs, id);
+		zbx_mock_assert_uint64_eq("inserted element", id, elem->id);
+	}
+
+	fhs_test_check(&fhs, ids_num, removed);
+
+	/* elements and control bytes are kept in single memory block */
+	zbx_mock_assert_int_eq("allocated blocks", 1, blocks_num);
+
+	/* inserting existing element must return it without changes */
+	elem_local.id = 1;
+	elem_local.value = 0;
+	elem = (fhs_test_elem_t *)zbx_flathashset_insert(&fhs, &elem_local, sizeof(elem_local));
+	zbx_mock_assert_uint64_eq("existing element value", 10, elem->value);
+	zbx_mock_assert_int_eq("number of elements after duplicate insert", (int)ids_num, fhs.num_data);
+
+	/* remove every remove_step element by key and the next one directly, leaving deleted slots */
+	for (id = 1; id <= ids_num; id += remove_step)
+	{
+		if (0 != removed[id])
+			continue;
+
+		elem_local.id = id;
+		zbx_flathashset_remove(&fhs, &elem_local);
+		removed[id] = 1;
+		removed_num++;
+
+		if (id + 1 <= ids_num && 0 == removed[id + 1])
+		{
+			elem_local.id = id + 1;
+			elem = (fhs_test_elem_t *)zbx_flathashset_search(&fhs, &elem_local);
+			zbx_flathashset_remove_direct(&fhs, elem);
+			removed[id + 1] = 1;
+			removed_num++;
+		}
+	}
+
+	/* removing missing element must not change the hashset */
+	elem_local.id = ids_num + 1;
+	zbx_flathashset_remove(&fhs, &elem_local);
+
+	zbx_mock_assert_int_eq("cleaned elements", removed_num, cleaned_num);
+	fhs_test_check(&fhs, ids_num, removed);
+
+	/* reinserting removed elements must reuse deleted slots without growing the slot array */
+	num_slots = fhs.num_slots;
+
+	for (id = 1; id <= ids_num; id++)
+	{
+		if (0 != removed[id])
+		{
+			fhs_test_insert(&fhs, id);
+			removed[id] = 0;
+		}
+	}
+
+	zbx_mock_assert_int_eq("number of slots after reinsert", num_slots, fhs.num_slots);
+	fhs_test_check(&fhs, ids_num, removed);
+
+	/* remove odd elements while iterating */
+	zbx_flathashset_iter_reset(&fhs, &iter);
+
+	while (NULL != (elem = (fhs_test_elem_t *)zbx_flathashset_iter_next(&iter)))
+	{
+		if (0 != elem->id % 2)
+		{
+			removed[elem->id] = 1;
+			zbx_flathashset_iter_remove(&iter);
+			removed_num++;
+		}
+	}
+
+	zbx_mock_assert_int_eq("cleaned elements after iterator removal", removed_num, cleaned_num);
+	fhs_test_check(&fhs, ids_num, removed);
+
+	/* reserving space for more elements than slots must grow slot array without losing elements */
+	num_slots = fhs.num_slots;
+
+	if (SUCCEED != zbx_flathashset_reserve(&fhs, num_slots))
+		fail_msg("cannot reserve flat hashset slots");
+
+	zbx_mock_assert_int_ne("number of slots after reserve", num_slots, fhs.num_slots);
+	zbx_mock_assert_int_eq("deleted slots after reserve", 0, fhs.num_deleted);
+	fhs_test_check(&fhs, ids_num, removed);
+
+	/* clear must clean all elements and keep the slot array */
+	num_slots = fhs.num_slots;
+	removed_num += fhs.num_data;
+	zbx_flathashset_clear(&fhs);
+
+	zbx_mock_assert_int_eq("cleaned elements after clear", removed_num, cleaned_num);
+	zbx_mock_assert_int_eq("number of slots after clear", num_slots, fhs.num_slots);
+	memset(removed, 1, ids_num + 1);
+	fhs_test_check(&fhs, ids_num, removed);
+
+	zbx_flathashset_destroy(&fhs);
+	zbx_mock_assert_int_eq("allocated blocks after destroy", 0, blocks_num);
+
+	zbx_free(removed);
+}
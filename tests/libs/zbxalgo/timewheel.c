@@ -0,0 +1,335 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+#define	LIST	1
+#define	RANDOM	2
+
+typedef struct
+{
+	zbx_uint64_t	key;
+	int		expire;
+	int		removed;
+}
+zbx_tw_test_elem_t;
+
+ZBX_PTR_VECTOR_DECL(tw_test_elem, zbx_tw_test_elem_t *)
+ZBX_PTR_VECTOR_IMPL(tw_test_elem, zbx_tw_test_elem_t *)
+
+static int	tw_test_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_tw_test_elem_t	*t1 = (const zbx_tw_test_elem_t *)e1->data;
+	const zbx_tw_test_elem_t	*t2 = (const zbx_tw_test_elem_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(t1->expire, t2->expire);
+	ZBX_RETURN_IF_NOT_EQUAL(t1->key, t2->key);
+
+	return 0;
+}
+
+static int	tw_test_compare_ptr(const void *d1, const void *d2)
+{
+	const zbx_tw_test_elem_t	*t1 = *(const zbx_tw_test_elem_t * const *)d1;
+	const zbx_tw_test_elem_t	*t2 = *(const zbx_tw_test_elem_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(t1->expire, t2->expire);
+	ZBX_RETURN_IF_NOT_EQUAL(t1->key, t2->key);
+
+	return 0;
+}
+
+static zbx_tw_test_elem_t	*tw_test_find(zbx_vector_tw_test_elem_t *elems, zbx_uint64_t key)
+{
+	int	i;
+
+	for (i = 0; i < elems->values_num; i++)
+	{
+		if (elems->values[i]->key == key)
+			return elems->values[i];
+	}
+
+	fail_msg("cannot find element with key " ZBX_FS_UI64, key);
+
+	return NULL;
+}
+
+static void	tw_test_insert(zbx_timewheel_t *tw, zbx_vector_tw_test_elem_t *elems, zbx_uint64_t key, int expire)
+{
+	zbx_tw_test_elem_t	*elem;
+	zbx_binary_heap_elem_t	tw_elem;
+
+	elem = (zbx_tw_test_elem_t *)zbx_malloc(NULL, sizeof(zbx_tw_test_elem_t));
+	elem->key = key;
+	elem->expire = expire;
+	elem->removed = 0;
+	zbx_vector_tw_test_elem_append(elems, elem);
+
+	tw_elem.key = key;
+	tw_elem.data = elem;
+	zbx_timewheel_insert(tw, &tw_elem, expire);
+}
+
+static void	tw_test_update(zbx_timewheel_t *tw, zbx_tw_test_elem_t *elem, int expire)
+{
+	zbx_binary_heap_elem_t	tw_elem;
+
+	elem->expire = expire;
+
+	tw_elem.key = elem->key;
+	tw_elem.data = elem;
+	zbx_timewheel_update_direct(tw, &tw_elem, expire);
+}
+
+static void	tw_test_remove(zbx_timewheel_t *tw, zbx_tw_test_elem_t *elem)
+{
+	elem->removed = 1;
+	zbx_timewheel_remove_direct(tw, elem->key);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pops all elements from timing wheel and checks they are returned  *
+ *          in ascending expiration order                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	tw_test_pop_all(zbx_timewheel_t *tw, zbx_vector_tw_test_elem_t *elems, zbx_vector_uint64_t *keys)
+{
+	zbx_vector_tw_test_elem_t	expected;
+	int				i;
+
+	zbx_vector_tw_test_elem_create(&expected);
+
+	for (i = 0; i < elems->values_num; i++)
+	{
+		if (0 == elems->values[i]->removed)
+			zbx_vector_tw_test_elem_append(&expected, elems->values[i]);
+	}
+
+	zbx_vector_tw_test_elem_sort(&expected, tw_test_compare_ptr);
+
+	zbx_mock_assert_int_eq("timing wheel size", expected.values_num, zbx_timewheel_size(tw));
+
+	for (i = 0; i < expected.values_num; i++)
+	{
+		const zbx_binary_heap_elem_t	*min;
+		int				next_expire;
+
+		next_expire = zbx_timewheel_next_expire(tw);
+
+		if (next_expire > expected.values[i]->expire)
+		{
+			fail_msg("next expiration time %d is after the earliest element expiration time %d",
+					next_expire, expected.values[i]->expire);
+		}
+
+		min = zbx_timewheel_find_min(tw);
+		zbx_mock_assert_uint64_eq("element key", expected.values[i]->key, min->key);
+		zbx_mock_assert_int_eq("next expiration time", expected.values[i]->expire,
+				zbx_timewheel_next_expire(tw));
+
+		zbx_timewheel_remove_min(tw);
+
+		if (NULL != keys)
+			zbx_vector_uint64_append(keys, min->key);
+	}
+
+	zbx_mock_assert_int_eq("timing wheel empty", SUCCEED, zbx_timewheel_empty(tw));
+	zbx_mock_assert_int_eq("next expiration time of empty wheel", FAIL, zbx_timewheel_next_expire(tw));
+
+	zbx_vector_tw_test_elem_destroy(&expected);
+}
+
+static void	test_timewheel_list(void)
+{
+	zbx_timewheel_t			tw;
+	zbx_vector_tw_test_elem_t	elems;
+	zbx_vector_uint64_t		keys, keys_exp;
+	zbx_mock_handle_t		hdata, helem;
+	zbx_mock_error_t		err;
+	int				i;
+
+	zbx_timewheel_create(&tw, tw_test_compare);
+	zbx_vector_tw_test_elem_create(&elems);
+	zbx_vector_uint64_create(&keys);
+	zbx_vector_uint64_create(&keys_exp);
+
+	hdata = zbx_mock_get_parameter_handle("in.elements");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hdata, &helem))))
+	{
+		tw_test_insert(&tw, &elems, zbx_mock_get_object_member_uint64(helem, "key"),
+				(int)zbx_mock_get_object_member_uint64(helem, "expire"));
+	}
+
+	/* advance wheel time by taking the specified number of elements and inserting them back */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.advance", &hdata))
+	{
+		int	advance = (int)zbx_mock_get_parameter_uint64("in.advance");
+
+		for (i = 0; i < advance; i++)
+		{
+			zbx_binary_heap_elem_t	min = *zbx_timewheel_find_min(&tw);
+
+			zbx_timewheel_remove_min(&tw);
+			zbx_timewheel_insert(&tw, &min, ((zbx_tw_test_elem_t *)min.data)->expire);
+		}
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.updates", &hdata))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hdata, &helem))))
+		{
+			tw_test_update(&tw, tw_test_find(&elems, zbx_mock_get_object_member_uint64(helem, "key")),
+					(int)zbx_mock_get_object_member_uint64(helem, "expire"));
+		}
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.removes", &hdata))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hdata, &helem))))
+		{
+			zbx_uint64_t	key;
+
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(helem, &key)))
+				fail_msg("Cannot read vector member: %s", zbx_mock_error_string(err));
+
+			tw_test_remove(&tw, tw_test_find(&elems, key));
+		}
+	}
+
+	tw_test_pop_all(&tw, &elems, &keys);
+
+	hdata = zbx_mock_get_parameter_handle("out.keys");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hdata, &helem))))
+	{
+		zbx_uint64_t	key;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(helem, &key)))
+			fail_msg("Cannot read vector member: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(&keys_exp, key);
+	}
+
+	zbx_mock_assert_int_eq("number of keys", keys_exp.values_num, keys.values_num);
+
+	for (i = 0; i < keys.values_num; i++)
+		zbx_mock_assert_uint64_eq("key", keys_exp.values[i], keys.values[i]);
+
+	zbx_vector_uint64_destroy(&keys_exp);
+	zbx_vector_uint64_destroy(&keys);
+	zbx_vector_tw_test_elem_clear_ext(&elems, (zbx_tw_test_elem_free_func_t)zbx_ptr_free);
+	zbx_vector_tw_test_elem_destroy(&elems);
+	zbx_timewheel_destroy(&tw);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: schedules elements over the whole range covered by wheel levels,  *
+ *          simulates polling with requeuing, updates and removals and checks *
+ *          that elements are returned in expiration order                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_timewheel_random(void)
+{
+	zbx_timewheel_t			tw;
+	zbx_vector_tw_test_elem_t	elems;
+	int				i, now, count, start, span, seconds;
+
+	count = (int)zbx_mock_get_parameter_uint64("in.count");
+	start = (int)zbx_mock_get_parameter_uint64("in.start");
+	span = (int)zbx_mock_get_parameter_uint64("in.span");
+	seconds = (int)zbx_mock_get_parameter_uint64("in.seconds");
+
+	srand((unsigned int)zbx_mock_get_parameter_uint64("in.seed"));
+
+	zbx_timewheel_create(&tw, tw_test_compare);
+	zbx_vector_tw_test_elem_create(&elems);
+
+	for (i = 0; i < count; i++)
+		tw_test_insert(&tw, &elems, (zbx_uint64_t)i + 1, start + rand() % span);
+
+	/* take expired elements and requeue them later or in the past */
+	for (now = start; now < start + seconds; now++)
+	{
+		while (FAIL == zbx_timewheel_empty(&tw))
+		{
+			zbx_binary_heap_elem_t	min = *zbx_timewheel_find_min(&tw);
+			zbx_tw_test_elem_t	*elem = (zbx_tw_test_elem_t *)min.data;
+
+			if (elem->expire > now)
+				break;
+
+			if (elem->expire < now - 1)
+				fail_msg("element with expiration time %d was not returned at %d", elem->expire, now);
+
+			zbx_timewheel_remove_min(&tw);
+			elem->expire = now + (0 == rand() % 10 ? -1 : rand() % span);
+			zbx_timewheel_insert(&tw, &min, elem->expire);
+		}
+
+		tw_test_update(&tw, elems.values[rand() % elems.values_num], now + rand() % span);
+	}
+
+	for (i = 0; i < elems.values_num; i += 7)
+		tw_test_remove(&tw, elems.values[i]);
+
+	tw_test_pop_all(&tw, &elems, NULL);
+
+	zbx_vector_tw_test_elem_clear_ext(&elems, (zbx_tw_test_elem_free_func_t)zbx_ptr_free);
+	zbx_vector_tw_test_elem_destroy(&elems);
+	zbx_timewheel_destroy(&tw);
+}
+
+static int	get_type(const char *str)
+{
+	if (0 == strcmp(str, "LIST"))
+		return LIST;
+
+	if (0 == strcmp(str, "RANDOM"))
+		return RANDOM;
+
+	fail_msg("unknown cmocka step type: %s", str);
+	return FAIL;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	switch (get_type(zbx_mock_get_parameter_string("in.type")))
+	{
+		case LIST:
+			test_timewheel_list();
+			break;
+		case RANDOM:
+			test_timewheel_random();
+			break;
+		default:
+			fail_msg("unknown cmocka step type: %s", zbx_mock_get_parameter_string("in.type"));
+	}
+}
@@ -0,0 +1,256 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Hashset benchmark.
+ *
+ * Compares chained zbx_hashset_t with open addressing zbx_flathashset_t using 24 byte elements
+ * with 64-bit keys (the size of preprocessing manager items). Inserts, successful and failed
+ * searches, iteration and removals are measured over 1k, 100k and 1M element sets and reported
+ * in millions of operations per second. Both implementations must find the same elements.
+ *
+ * Usage: zbx_hashset_bench [operations per set size]
+ */
+
+#include "zbxalgo.h"
+#include "zbxtime.h"
+
+#define HS_BENCH_OPERATIONS	20000000
+
+const char	title_message[] = "zbx_hashset_bench";
+const char	*usage_message[] = {"[operations per set size]", NULL};
+const char	*help_message[] = {"Hashset benchmark.", NULL};
+const char	*progname = "zbx_hashset_bench";
+const char	syslog_app_name[] = "zbx_hashset_bench";
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	revision;
+	void		*data;
+}
+zbx_hs_bench_elem_t;
+
+typedef enum
+{
+	HS_BENCH_INSERT = 0,
+	HS_BENCH_SEARCH_HIT,
+	HS_BENCH_SEARCH_MISS,
+	HS_BENCH_ITERATE,
+	HS_BENCH_REMOVE,
+	HS_BENCH_OPS_NUM
+}
+zbx_hs_bench_op_t;
+
+static const char	*op_names[HS_BENCH_OPS_NUM] = {"insert", "search(hit)", "search(miss)", "iterate",
+		"remove"};
+
+static const char	*impl_names[] = {"chained", "flat"};
+
+/* keys are sparse like database identifiers of items spread over hosts */
+static zbx_uint64_t	bench_key(int i)
+{
+	return (zbx_uint64_t)i * 7 + 100000;
+}
+
+static zbx_uint64_t	run_chained(int op, zbx_hashset_t *hs, int num)
+{
+	zbx_uint64_t	found = 0, key;
+	int		i;
+
+	switch (op)
+	{
+		case HS_BENCH_INSERT:
+			for (i = 0; i < num; i++)
+			{
+				zbx_hs_bench_elem_t	elem = {.id = bench_key(i), .revision = (zbx_uint64_t)i};
+
+				zbx_hashset_insert(hs, &elem, sizeof(elem));
+			}
+			return (zbx_uint64_t)hs->num_data;
+		case HS_BENCH_SEARCH_HIT:
+		case HS_BENCH_SEARCH_MISS:
+			for (i = 0; i < num; i++)
+			{
+				zbx_hs_bench_elem_t	*elem;
+
+				key = bench_key(i) + (HS_BENCH_SEARCH_MISS == op ? 1 : 0);
+
+				if (NULL != (elem = (zbx_hs_bench_elem_t *)zbx_hashset_search(hs, &key)))
+					found += elem->revision;
+			}
+			return found;
+		case HS_BENCH_ITERATE:
+		{
+			zbx_hashset_iter_t	iter;
+			zbx_hs_bench_elem_t	*elem;
+
+			zbx_hashset_iter_reset(hs, &iter);
+			while (NULL != (elem = (zbx_hs_bench_elem_t *)zbx_hashset_iter_next(&iter)))
+				found += elem->revision;
+
+			return found;
+		}
+		case HS_BENCH_REMOVE:
+			for (i = 0; i < num; i++)
+			{
+				key = bench_key(i);
+				zbx_hashset_remove(hs, &key);
+			}
+			return (zbx_uint64_t)hs->num_data;
+	}
+
+	return 0;
+}
+
+static zbx_uint64_t	run_flat(int op, zbx_flathashset_t *fhs, int num)
+{
+	zbx_uint64_t	found = 0, key;
+	int		i;
+
+	switch (op)
+	{
+		case HS_BENCH_INSERT:
+			for (i = 0; i < num; i++)
+			{
+				zbx_hs_bench_elem_t	elem = {.id = bench_key(i), .revision = (zbx_uint64_t)i};
+
+				zbx_flathashset_insert(fhs, &elem, sizeof(elem));
+			}
+			return (zbx_uint64_t)fhs->num_data;
+		case HS_BENCH_SEARCH_HIT:
+		case HS_BENCH_SEARCH_MISS:
+			for (i = 0; i < num; i++)
+			{
+				zbx_hs_bench_elem_t	*elem;
+
+				key = bench_key(i) + (HS_BENCH_SEARCH_MISS == op ? 1 : 0);
+
+				if (NULL != (elem = (zbx_hs_bench_elem_t *)zbx_flathashset_search(fhs, &key)))
+					found += elem->revision;
+			}
+			return found;
+		case HS_BENCH_ITERATE:
+		{
+			zbx_flathashset_iter_t	iter;
+			zbx_hs_bench_elem_t	*elem;
+
+			zbx_flathashset_iter_reset(fhs, &iter);
+			while (NULL != (elem = (zbx_hs_bench_elem_t *)zbx_flathashset_iter_next(&iter)))
+				found += elem->revision;
+
+			return found;
+		}
+		case HS_BENCH_REMOVE:
+			for (i = 0; i < num; i++)
+			{
+				key = bench_key(i);
+				zbx_flathashset_remove(fhs, &key);
+			}
+			return (zbx_uint64_t)fhs->num_data;
+	}
+
+	return 0;
+}
+
+int	main(int argc, char **argv)
+{
+	static const int	sizes[] = {1000, 100000, 1000000};
+	double			elapsed[ARRSIZE(impl_names)][HS_BENCH_OPS_NUM][ARRSIZE(sizes)];
+	zbx_uint64_t		results[ARRSIZE(impl_names)][HS_BENCH_OPS_NUM];
+	int			i, j, op, impl, total = HS_BENCH_OPERATIONS, ret = EXIT_SUCCESS;
+
+	if (1 < argc)
+		total = atoi(argv[1]);
+
+	memset(elapsed, 0, sizeof(elapsed));
+
+	for (i = 0; i < (int)ARRSIZE(sizes); i++)
+	{
+		int	loops = MAX(1, total / sizes[i]);
+
+		for (impl = 0; impl < (int)ARRSIZE(impl_names); impl++)
+		{
+			/* every loop builds the set from scratch, so inserts include rehashing */
+			for (j = 0; j < loops; j++)
+			{
+				zbx_hashset_t		hs;
+				zbx_flathashset_t	fhs;
+
+				if (0 == impl)
+				{
+					zbx_hashset_create(&hs, 0, ZBX_DEFAULT_UINT64_HASH_FUNC,
+							ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+				}
+				else
+				{
+					zbx_flathashset_create(&fhs, 0, sizeof(zbx_hs_bench_elem_t),
+							ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+				}
+
+				for (op = 0; op < HS_BENCH_OPS_NUM; op++)
+				{
+					double	start = zbx_time();
+
+					if (0 == impl)
+						results[impl][op] = run_chained(op, &hs, sizes[i]);
+					else
+						results[impl][op] = run_flat(op, &fhs, sizes[i]);
+
+					elapsed[impl][op][i] += zbx_time() - start;
+				}
+
+				if (0 == impl)
+					zbx_hashset_destroy(&hs);
+				else
+					zbx_flathashset_destroy(&fhs);
+			}
+
+			for (op = 0; op < HS_BENCH_OPS_NUM; op++)
+				elapsed[impl][op][i] = (double)loops * sizes[i] / elapsed[impl][op][i] / 1e6;
+		}
+
+		for (op = 0; op < HS_BENCH_OPS_NUM; op++)
+		{
+			if (results[0][op] != results[1][op])
+			{
+				printf("MISMATCH %s %d: " ZBX_FS_UI64 " != " ZBX_FS_UI64 "\n", op_names[op], sizes[i],
+						results[1][op], results[0][op]);
+				ret = EXIT_FAILURE;
+			}
+		}
+	}
+
+	printf("%-14s %-8s %10s %10s %10s\n", "operation", "hashset", "1k", "100k", "1M");
+
+	for (op = 0; op < HS_BENCH_OPS_NUM; op++)
+	{
+		for (impl = 0; impl < (int)ARRSIZE(impl_names); impl++)
+		{
+			printf("%-14s %-8s", op_names[op], impl_names[impl]);
+
+			for (i = 0; i < (int)ARRSIZE(sizes); i++)
+				printf(" %10.1f", elapsed[impl][op][i]);
+
+			printf("\n");
+		}
+	}
+
+	return ret;
+}
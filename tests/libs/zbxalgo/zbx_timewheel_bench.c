@@ -0,0 +1,276 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Item scheduling queue benchmark.
+ *
+ * Compares zbx_binary_heap_t with zbx_timewheel_t as the poller queue of the configuration cache. Items
+ * with mixed update intervals (10s - 1d) are scheduled, then polling is simulated by taking expired
+ * items and requeuing them at their next check for the specified number of seconds. Finally all items
+ * are rescheduled at once, like after maintenance or proxy changes. Both queues must return items in
+ * the same order.
+ *
+ * Usage: zbx_timewheel_bench [items] [seconds]
+ */
+
+#include "zbxalgo.h"
+#include "zbxtime.h"
+
+#define TW_BENCH_ITEMS		5000000
+#define TW_BENCH_SECONDS	600
+#define TW_BENCH_START		1700000000
+
+const char	title_message[] = "zbx_timewheel_bench";
+const char	*usage_message[] = {"[items] [seconds]", NULL};
+const char	*help_message[] = {"Item scheduling queue benchmark.", NULL};
+const char	*progname = "zbx_timewheel_bench";
+const char	syslog_app_name[] = "zbx_timewheel_bench";
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		nextcheck;
+	int		delay;
+}
+zbx_tw_bench_item_t;
+
+typedef enum
+{
+	TW_BENCH_SCHEDULE = 0,
+	TW_BENCH_POLL,
+	TW_BENCH_RESCHEDULE,
+	TW_BENCH_DRAIN,
+	TW_BENCH_OPS_NUM
+}
+zbx_tw_bench_op_t;
+
+static const char	*op_names[TW_BENCH_OPS_NUM] = {"schedule", "poll", "reschedule", "drain"};
+
+static const char	*impl_names[] = {"heap", "wheel"};
+
+typedef struct
+{
+	double		sec[TW_BENCH_OPS_NUM];
+	zbx_uint64_t	ops[TW_BENCH_OPS_NUM];
+	zbx_uint64_t	checksum;
+}
+zbx_tw_bench_result_t;
+
+static int	tw_bench_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_tw_bench_item_t	*i1 = (const zbx_tw_bench_item_t *)e1->data;
+	const zbx_tw_bench_item_t	*i2 = (const zbx_tw_bench_item_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->itemid, i2->itemid);
+
+	return 0;
+}
+
+/* the queue interface used by benchmark, implemented by both binary heap and timing wheel */
+
+static int	queue_empty(int impl, void *queue)
+{
+	if (0 == impl)
+		return zbx_binary_heap_empty((zbx_binary_heap_t *)queue);
+
+	return zbx_timewheel_empty((zbx_timewheel_t *)queue);
+}
+
+static zbx_tw_bench_item_t	*queue_min(int impl, void *queue)
+{
+	zbx_binary_heap_elem_t	*min;
+
+	if (0 == impl)
+		min = zbx_binary_heap_find_min((zbx_binary_heap_t *)queue);
+	else
+		min = zbx_timewheel_find_min((zbx_timewheel_t *)queue);
+
+	return (zbx_tw_bench_item_t *)min->data;
+}
+
+static void	queue_remove_min(int impl, void *queue)
+{
+	if (0 == impl)
+		zbx_binary_heap_remove_min((zbx_binary_heap_t *)queue);
+	else
+		zbx_timewheel_remove_min((zbx_timewheel_t *)queue);
+}
+
+static void	queue_insert(int impl, void *queue, zbx_tw_bench_item_t *item)
+{
+	zbx_binary_heap_elem_t	elem = {item->itemid, item};
+
+	if (0 == impl)
+		zbx_binary_heap_insert((zbx_binary_heap_t *)queue, &elem);
+	else
+		zbx_timewheel_insert((zbx_timewheel_t *)queue, &elem, item->nextcheck);
+}
+
+static void	queue_update(int impl, void *queue, zbx_tw_bench_item_t *item)
+{
+	zbx_binary_heap_elem_t	elem = {item->itemid, item};
+
+	if (0 == impl)
+		zbx_binary_heap_update_direct((zbx_binary_heap_t *)queue, &elem);
+	else
+		zbx_timewheel_update_direct((zbx_timewheel_t *)queue, &elem, item->nextcheck);
+}
+
+static void	items_init(zbx_tw_bench_item_t *items, int items_num)
+{
+	static const int	delays[] = {10, 30, 60, 60, 60, 300, 300, 600, 3600, 86400};
+	int			i;
+
+	for (i = 0; i < items_num; i++)
+	{
+		items[i].itemid = (zbx_uint64_t)i * 3 + 10000;
+		items[i].delay = delays[i % ARRSIZE(delays)];
+
+		/* spread items over their interval like item nextcheck calculation does */
+		items[i].nextcheck = TW_BENCH_START + (int)(items[i].itemid % (zbx_uint64_t)items[i].delay);
+	}
+}
+
+static void	bench_run(int impl, zbx_tw_bench_item_t *items, int items_num, int seconds,
+		zbx_tw_bench_result_t *result)
+{
+	zbx_binary_heap_t	heap;
+	zbx_timewheel_t		wheel;
+	void			*queue;
+	int			i, now;
+	double			start;
+
+	memset(result, 0, sizeof(zbx_tw_bench_result_t));
+	items_init(items, items_num);
+
+	if (0 == impl)
+	{
+		zbx_binary_heap_create(&heap, tw_bench_compare, ZBX_BINARY_HEAP_OPTION_DIRECT);
+		queue = &heap;
+	}
+	else
+	{
+		zbx_timewheel_create(&wheel, tw_bench_compare);
+		queue = &wheel;
+	}
+
+	start = zbx_time();
+
+	for (i = 0; i < items_num; i++)
+		queue_insert(impl, queue, &items[i]);
+
+	result->sec[TW_BENCH_SCHEDULE] = zbx_time() - start;
+	result->ops[TW_BENCH_SCHEDULE] = (zbx_uint64_t)items_num;
+
+	start = zbx_time();
+
+	for (now = TW_BENCH_START; now < TW_BENCH_START + seconds; now++)
+	{
+		while (FAIL == queue_empty(impl, queue))
+		{
+			zbx_tw_bench_item_t	*item;
+
+			if ((item = queue_min(impl, queue))->nextcheck > now)
+				break;
+
+			queue_remove_min(impl, queue);
+
+			result->checksum = result->checksum * 31 + item->itemid;
+			item->nextcheck += item->delay;
+			queue_insert(impl, queue, item);
+			result->ops[TW_BENCH_POLL]++;
+		}
+	}
+
+	result->sec[TW_BENCH_POLL] = zbx_time() - start;
+
+	start = zbx_time();
+
+	/* reschedule all items with a shifted offset, as after maintenance period ends */
+	for (i = 0; i < items_num; i++)
+	{
+		items[i].nextcheck = now + (int)((items[i].itemid / 3) % (zbx_uint64_t)items[i].delay);
+		queue_update(impl, queue, &items[i]);
+	}
+
+	result->sec[TW_BENCH_RESCHEDULE] = zbx_time() - start;
+	result->ops[TW_BENCH_RESCHEDULE] = (zbx_uint64_t)items_num;
+
+	start = zbx_time();
+
+	while (FAIL == queue_empty(impl, queue))
+	{
+		result->checksum = result->checksum * 31 + queue_min(impl, queue)->itemid;
+		queue_remove_min(impl, queue);
+		result->ops[TW_BENCH_DRAIN]++;
+	}
+
+	result->sec[TW_BENCH_DRAIN] = zbx_time() - start;
+
+	if (0 == impl)
+		zbx_binary_heap_destroy(&heap);
+	else
+		zbx_timewheel_destroy(&wheel);
+}
+
+int	main(int argc, char **argv)
+{
+	zbx_tw_bench_result_t	results[ARRSIZE(impl_names)];
+	zbx_tw_bench_item_t	*items;
+	int			op, impl, items_num = TW_BENCH_ITEMS, seconds = TW_BENCH_SECONDS, ret = EXIT_SUCCESS;
+
+	if (1 < argc)
+		items_num = atoi(argv[1]);
+
+	if (2 < argc)
+		seconds = atoi(argv[2]);
+
+	items = (zbx_tw_bench_item_t *)zbx_malloc(NULL, sizeof(zbx_tw_bench_item_t) * (size_t)items_num);
+
+	for (impl = 0; impl < (int)ARRSIZE(impl_names); impl++)
+		bench_run(impl, items, items_num, seconds, &results[impl]);
+
+	zbx_free(items);
+
+	if (results[0].checksum != results[1].checksum)
+	{
+		printf("MISMATCH: items were returned in different order\n");
+		ret = EXIT_FAILURE;
+	}
+
+	printf("%d items, %d seconds polled\n", items_num, seconds);
+	printf("%-12s %-6s %12s %10s %12s\n", "operation", "queue", "ops", "sec", "Mops/sec");
+
+	for (op = 0; op < TW_BENCH_OPS_NUM; op++)
+	{
+		for (impl = 0; impl < (int)ARRSIZE(impl_names); impl++)
+		{
+			const zbx_tw_bench_result_t	*r = &results[impl];
+
+			printf("%-12s %-6s %12.0f %10.3f %12.2f\n", op_names[op], impl_names[impl],
+					(double)r->ops[op], r->sec[op],
+					0 < r->sec[op] ? (double)r->ops[op] / r->sec[op] / 1e6 : 0);
+		}
+	}
+
+	return ret;
+}
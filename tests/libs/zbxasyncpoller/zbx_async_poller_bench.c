@@ -0,0 +1,387 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Asynchronous poller event backend benchmark.
+ *
+ * Starts fake passive agents on a loopback port in child processes and runs agent.ping checks against them
+ * through zbx_async_poller_add_task() in one process, keeping the specified number of checks in flight like an
+ * agent poller does. Each check connects, sends the request, receives the response and closes the connection.
+ * Checks are run with libevent and io_uring socket readiness backends and the number of checks per second is
+ * reported together with io_uring system calls per check.
+ *
+ * Usage: zbx_async_poller_bench [checks] [concurrency]
+ */
+
+#include "zbxasyncpoller.h"
+#include "zbxtime.h"
+
+#include <event2/dns.h>
+
+#define AP_BENCH_CHECKS		100000
+#define AP_BENCH_CONCURRENCY	1000
+#define AP_BENCH_AGENTS		2
+#define AP_BENCH_TIMEOUT	10
+
+/* ZBXD signature, protocol flags, little endian data length and reserved fields */
+#define AP_BENCH_HEADER		"ZBXD\x01"
+#define AP_BENCH_HEADER_LEN	(ZBX_CONST_STRLEN(AP_BENCH_HEADER) + 8)
+#define AP_BENCH_REQUEST	"agent.ping"
+#define AP_BENCH_RESPONSE	"1"
+
+const char	title_message[] = "zbx_async_poller_bench";
+const char	*usage_message[] = {"[checks] [concurrency]", NULL};
+const char	*help_message[] = {"Asynchronous poller event backend benchmark.", NULL};
+const char	*progname = "zbx_async_poller_bench";
+const char	syslog_app_name[] = "zbx_async_poller_bench";
+
+int	CONFIG_TCP_MAX_BACKLOG_SIZE = SOMAXCONN;
+
+typedef enum
+{
+	AP_BENCH_BACKEND_LIBEVENT = 0,
+	AP_BENCH_BACKEND_IO_URING,
+	AP_BENCH_BACKENDS_NUM
+}
+zbx_ap_bench_backend_t;
+
+static const char	*backend_names[AP_BENCH_BACKENDS_NUM] = {"libevent", "io_uring"};
+
+static void	bench_log_impl(int level, const char *fmt, va_list args)
+{
+	if (LOG_LEVEL_WARNING < level)
+		return;
+
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+}
+
+typedef struct
+{
+	int		s;
+	size_t		offset;
+	char		buf[AP_BENCH_HEADER_LEN + ZBX_CONST_STRLEN(AP_BENCH_REQUEST)];
+	struct event	*event;
+}
+zbx_ap_bench_conn_t;
+
+typedef enum
+{
+	AP_BENCH_STEP_CONNECT = 0,
+	AP_BENCH_STEP_RECV
+}
+zbx_ap_bench_step_t;
+
+typedef struct
+{
+	int			s;
+	zbx_ap_bench_step_t	step;
+	size_t			offset;
+	char			buf[AP_BENCH_HEADER_LEN + ZBX_CONST_STRLEN(AP_BENCH_RESPONSE)];
+}
+zbx_ap_bench_check_t;
+
+static struct sockaddr_in	agent_addr;
+static zbx_uint64_t		checks_active, checks_ok, checks_failed;
+
+static size_t	ap_bench_packet(char *buf, const char *data)
+{
+	size_t	len = strlen(data);
+
+	memcpy(buf, AP_BENCH_HEADER, ZBX_CONST_STRLEN(AP_BENCH_HEADER));
+	memset(buf + ZBX_CONST_STRLEN(AP_BENCH_HEADER), 0, AP_BENCH_HEADER_LEN - ZBX_CONST_STRLEN(AP_BENCH_HEADER));
+	buf[ZBX_CONST_STRLEN(AP_BENCH_HEADER)] = (char)len;
+	memcpy(buf + AP_BENCH_HEADER_LEN, data, len);
+
+	return AP_BENCH_HEADER_LEN + len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads request and responds with the agent.ping result, then       *
+ *          closes connection like a passive agent does                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_event(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_ap_bench_conn_t	*conn = (zbx_ap_bench_conn_t *)arg;
+	ssize_t			n;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	while (conn->offset < sizeof(conn->buf))
+	{
+		if (0 >= (n = recv(conn->s, conn->buf + conn->offset, sizeof(conn->buf) - conn->offset, 0)))
+		{
+			if (0 > n && EAGAIN == errno)
+				return;
+
+			goto out;
+		}
+
+		conn->offset += (size_t)n;
+	}
+
+	n = (ssize_t)ap_bench_packet(conn->buf, AP_BENCH_RESPONSE);
+
+	if (n != send(conn->s, conn->buf, (size_t)n, 0))
+		printf("cannot send response: %s\n", zbx_strerror(errno));
+out:
+	event_free(conn->event);
+	close(conn->s);
+	zbx_free(conn);
+}
+
+static void	agent_accept_event(evutil_socket_t fd, short what, void *arg)
+{
+	struct event_base	*base = (struct event_base *)arg;
+	int			s;
+
+	ZBX_UNUSED(what);
+
+	while (-1 != (s = accept(fd, NULL, NULL)))
+	{
+		zbx_ap_bench_conn_t	*conn;
+
+		fcntl(s, F_SETFL, O_NONBLOCK);
+
+		conn = (zbx_ap_bench_conn_t *)zbx_malloc(NULL, sizeof(zbx_ap_bench_conn_t));
+		conn->s = s;
+		conn->offset = 0;
+		conn->event = event_new(base, s, EV_READ | EV_PERSIST, agent_conn_event, conn);
+		event_add(conn->event, NULL);
+	}
+}
+
+static int	run_agent(int s)
+{
+	struct event_base	*base;
+	struct event		*accept_event;
+
+	base = event_base_new();
+	accept_event = event_new(base, s, EV_READ | EV_PERSIST, agent_accept_event, base);
+	event_add(accept_event, NULL);
+
+	event_base_dispatch(base);
+
+	return EXIT_SUCCESS;
+}
+
+static int	ap_bench_check_process(short event, void *data, int *fd, const char *addr, char *dnserr)
+{
+	zbx_ap_bench_check_t	*check = (zbx_ap_bench_check_t *)data;
+	ssize_t			n;
+	size_t			len;
+	int			err = 0;
+	socklen_t		optlen = sizeof(err);
+
+	ZBX_UNUSED(addr);
+	ZBX_UNUSED(dnserr);
+
+	if (0 == event)
+	{
+		if (-1 == (check->s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)))
+			goto fail;
+
+		if (0 != connect(check->s, (struct sockaddr *)&agent_addr, sizeof(agent_addr)) &&
+				EINPROGRESS != errno)
+		{
+			goto fail;
+		}
+
+		*fd = check->s;
+		check->step = AP_BENCH_STEP_CONNECT;
+
+		return ZBX_ASYNC_TASK_WRITE;
+	}
+
+	if (0 != (event & EV_TIMEOUT))
+		goto fail;
+
+	switch (check->step)
+	{
+		case AP_BENCH_STEP_CONNECT:
+			if (0 != getsockopt(check->s, SOL_SOCKET, SO_ERROR, &err, &optlen) || 0 != err)
+				goto fail;
+
+			len = ap_bench_packet(check->buf, AP_BENCH_REQUEST);
+
+			if ((ssize_t)len != send(check->s, check->buf, len, 0))
+				goto fail;
+
+			check->step = AP_BENCH_STEP_RECV;
+			check->offset = 0;
+
+			return ZBX_ASYNC_TASK_READ;
+		case AP_BENCH_STEP_RECV:
+			while (check->offset < sizeof(check->buf))
+			{
+				if (0 >= (n = recv(check->s, check->buf + check->offset,
+						sizeof(check->buf) - check->offset, 0)))
+				{
+					if (0 > n && EAGAIN == errno)
+						return ZBX_ASYNC_TASK_READ;
+
+					goto fail;
+				}
+
+				check->offset += (size_t)n;
+			}
+
+			if ('1' != check->buf[AP_BENCH_HEADER_LEN])
+				goto fail;
+
+			checks_ok++;
+			return ZBX_ASYNC_TASK_STOP;
+	}
+fail:
+	checks_failed++;
+
+	return ZBX_ASYNC_TASK_STOP;
+}
+
+static void	ap_bench_check_clear(void *data)
+{
+	zbx_ap_bench_check_t	*check = (zbx_ap_bench_check_t *)data;
+
+	if (-1 != check->s)
+		close(check->s);
+
+	zbx_free(check);
+	checks_active--;
+}
+
+static int	run_poller(int backend, int checks, int concurrency, double *elapsed, zbx_async_uring_stats_t *stats)
+{
+	struct event_base	*base;
+	struct evdns_base	*dnsbase;
+	double			start;
+	char			*error = NULL;
+	int			started = 0, ret = FAIL;
+
+	base = event_base_new();
+	dnsbase = evdns_base_new(base, 0);
+
+	if (AP_BENCH_BACKEND_IO_URING == backend && SUCCEED != zbx_async_poller_uring_init(base, &error))
+	{
+		printf("%-10s %s\n", backend_names[backend], error);
+		zbx_free(error);
+		goto out;
+	}
+
+	checks_ok = checks_failed = 0;
+	start = zbx_time();
+
+	while (started < checks || 0 != checks_active)
+	{
+		/* start new checks after event loop pass like agent poller does */
+		for (; started < checks && checks_active < (zbx_uint64_t)concurrency; started++)
+		{
+			zbx_ap_bench_check_t	*check;
+
+			check = (zbx_ap_bench_check_t *)zbx_malloc(NULL, sizeof(zbx_ap_bench_check_t));
+			check->s = -1;
+			checks_active++;
+
+			zbx_async_poller_add_task(base, dnsbase, "127.0.0.1", check, AP_BENCH_TIMEOUT,
+					ap_bench_check_process, ap_bench_check_clear);
+		}
+
+		event_base_loop(base, EVLOOP_ONCE);
+	}
+
+	*elapsed = zbx_time() - start;
+
+	memset(stats, 0, sizeof(zbx_async_uring_stats_t));
+	zbx_async_poller_uring_get_stats(stats);
+	zbx_async_poller_uring_destroy();
+
+	ret = SUCCEED;
+out:
+	evdns_base_free(dnsbase, 0);
+	event_base_free(base);
+
+	return ret;
+}
+
+int	main(int argc, char **argv)
+{
+	int		i, s, checks = AP_BENCH_CHECKS, concurrency = AP_BENCH_CONCURRENCY, backend, ret = EXIT_SUCCESS;
+	socklen_t	addr_len = sizeof(agent_addr);
+	pid_t		pids[AP_BENCH_AGENTS];
+
+	zbx_init_library_common(bench_log_impl);
+
+	if (1 < argc)
+		checks = atoi(argv[1]);
+
+	if (2 < argc)
+		concurrency = atoi(argv[2]);
+
+	memset(&agent_addr, 0, sizeof(agent_addr));
+	agent_addr.sin_family = AF_INET;
+	agent_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (-1 == (s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) ||
+			0 != bind(s, (struct sockaddr *)&agent_addr, sizeof(agent_addr)) ||
+			0 != listen(s, SOMAXCONN) ||
+			0 != getsockname(s, (struct sockaddr *)&agent_addr, &addr_len))
+	{
+		printf("cannot start fake agent: %s\n", zbx_strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < AP_BENCH_AGENTS; i++)
+	{
+		if (0 == (pids[i] = fork()))
+			exit(run_agent(s));
+	}
+
+	close(s);
+
+	printf("%-10s %12s %10s %16s\n", "backend", "checks/s", "failed", "uring_enter/check");
+
+	for (backend = 0; backend < AP_BENCH_BACKENDS_NUM; backend++)
+	{
+		zbx_async_uring_stats_t	stats;
+		double			elapsed;
+
+		if (SUCCEED != run_poller(backend, checks, concurrency, &elapsed, &stats))
+			continue;
+
+		if (0 != checks_failed)
+			ret = EXIT_FAILURE;
+
+		printf("%-10s %12.0f %10d", backend_names[backend], checks / elapsed, (int)checks_failed);
+
+		if (AP_BENCH_BACKEND_IO_URING == backend)
+			printf(" %16.3f\n", (double)stats.enters / checks);
+		else
+			printf(" %16s\n", "-");
+	}
+
+	for (i = 0; i < AP_BENCH_AGENTS; i++)
+	{
+		kill(pids[i], SIGTERM);
+		waitpid(pids[i], NULL, 0);
+	}
+
+	return ret;
+}
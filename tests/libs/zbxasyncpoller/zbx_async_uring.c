@@ -0,0 +1,280 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxasyncpoller.h"
+#include "zbxstr.h"
+
+#include <event2/dns.h>
+#include <sys/syscall.h>
+
+#define MOCK_REQUEST		"ping"
+#define MOCK_RESPONSE		"pong"
+
+/* time in seconds to wait for all tasks to finish */
+#define MOCK_LOOP_TIMEOUT	10
+
+/* task connects to its peer socket, writes request and reads response, events seen by task are recorded */
+typedef struct
+{
+	int	fds[2];
+	int	respond;
+	char	*events;
+	size_t	events_alloc;
+	size_t	events_offset;
+}
+mock_task_t;
+
+static int	uring_unavailable;
+static int	tasks_finished;
+
+long	__real_syscall(long number, ...);
+
+/* simulates kernel without io_uring support */
+long	__wrap_syscall(long number, ...)
+{
+	va_list	args;
+	long	arg[6];
+	int	i;
+
+#ifdef __NR_io_uring_setup
+	if (__NR_io_uring_setup == number && 0 != uring_unavailable)
+	{
+		errno = ENOSYS;
+		return -1;
+	}
+#endif
+	va_start(args, number);
+
+	for (i = 0; i < (int)ARRSIZE(arg); i++)
+		arg[i] = va_arg(args, long);
+
+	va_end(args);
+
+	return __real_syscall(number, arg[0], arg[1], arg[2], arg[3], arg[4], arg[5]);
+}
+
+static void	mock_task_event(mock_task_t *task, const char *event)
+{
+	if (0 != task->events_offset)
+		zbx_chrcpy_alloc(&task->events, &task->events_alloc, &task->events_offset, ' ');
+
+	zbx_strcpy_alloc(&task->events, &task->events_alloc, &task->events_offset, event);
+}
+
+static int	mock_task_process(short event, void *data, int *fd, const char *addr, char *dnserr)
+{
+	mock_task_t	*task = (mock_task_t *)data;
+	char		buf[MAX_STRING_LEN];
+	ssize_t		n;
+
+	ZBX_UNUSED(addr);
+	ZBX_UNUSED(dnserr);
+
+	if (0 != (event & EV_TIMEOUT))
+	{
+		mock_task_event(task, "timeout");
+		return ZBX_ASYNC_TASK_STOP;
+	}
+
+	if (-1 == task->fds[0])
+	{
+		if (0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, task->fds))
+			fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+		*fd = task->fds[0];
+		mock_task_event(task, "connect");
+
+		return ZBX_ASYNC_TASK_WRITE;
+	}
+
+	if (0 != (event & EV_WRITE))
+	{
+		if (ZBX_CONST_STRLEN(MOCK_REQUEST) != write(task->fds[0], MOCK_REQUEST, ZBX_CONST_STRLEN(MOCK_REQUEST)))
+			fail_msg("cannot write request: %s", zbx_strerror(errno));
+
+		if (0 != task->respond && ZBX_CONST_STRLEN(MOCK_RESPONSE) != write(task->fds[1], MOCK_RESPONSE,
+				ZBX_CONST_STRLEN(MOCK_RESPONSE)))
+		{
+			fail_msg("cannot write response: %s", zbx_strerror(errno));
+		}
+
+		mock_task_event(task, "write");
+
+		return ZBX_ASYNC_TASK_READ;
+	}
+
+	if (0 != (event & EV_READ))
+	{
+		if (0 >= (n = read(task->fds[0], buf, sizeof(buf) - 1)))
+			fail_msg("socket was reported readable without data");
+
+		buf[n] = '\0';
+		zbx_mock_assert_str_eq("response", MOCK_RESPONSE, buf);
+		mock_task_event(task, "read");
+
+		return ZBX_ASYNC_TASK_STOP;
+	}
+
+	fail_msg("unexpected task event 0x%x", (unsigned int)event);
+
+	return ZBX_ASYNC_TASK_STOP;
+}
+
+static void	mock_task_clear(void *data)
+{
+	mock_task_t	*task = (mock_task_t *)data;
+
+	if (-1 != task->fds[0])
+	{
+		close(task->fds[0]);
+		close(task->fds[1]);
+	}
+
+	tasks_finished++;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	struct event_base	*ev;
+	struct evdns_base	*dnsbase;
+	zbx_mock_handle_t	htasks, htask, hstats;
+	zbx_mock_error_t	err;
+	zbx_async_uring_stats_t	stats;
+	mock_task_t		*tasks = NULL;
+	const char		*uring;
+	char			*error = NULL, prefix[MAX_STRING_LEN];
+	int			i, tasks_num = 0, ret, expected_ret;
+	time_t			start;
+
+	ZBX_UNUSED(state);
+
+	uring = zbx_mock_get_parameter_string("in.uring");
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.init"));
+
+#ifndef HAVE_IO_URING
+	if (SUCCEED == expected_ret)
+		skip();
+#endif
+	if (NULL == (ev = event_base_new()))
+		fail_msg("cannot create event base");
+
+	if (NULL == (dnsbase = evdns_base_new(ev, 0)))
+		fail_msg("cannot create DNS base");
+
+	uring_unavailable = (0 == strcmp(uring, "unavailable") ? 1 : 0);
+
+	ret = zbx_async_poller_uring_init(ev, &error);
+
+	/* io_uring can be disabled in kernel or by container security profile */
+	if (SUCCEED == expected_ret && SUCCEED != ret)
+	{
+		zbx_free(error);
+		skip();
+	}
+
+	zbx_mock_assert_result_eq("zbx_async_poller_uring_init()", expected_ret, ret);
+
+#ifdef HAVE_IO_URING
+	if (SUCCEED != ret)
+		zbx_mock_assert_str_eq("io_uring error", zbx_mock_get_parameter_string("out.error"), error);
+#endif
+	zbx_free(error);
+
+	htasks = zbx_mock_get_parameter_handle("in.tasks");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(htasks, &htask)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read task: %s", zbx_mock_error_string(err));
+
+		tasks = (mock_task_t *)zbx_realloc(tasks, sizeof(mock_task_t) * (size_t)(tasks_num + 1));
+		memset(&tasks[tasks_num], 0, sizeof(mock_task_t));
+		tasks[tasks_num].fds[0] = -1;
+		tasks[tasks_num].fds[1] = -1;
+		tasks[tasks_num].respond = (0 == strcmp(zbx_mock_get_object_member_string(htask, "respond"), "yes") ?
+				1 : 0);
+		tasks_num++;
+	}
+
+	/* tasks are added after the array is complete because task data is referenced by event loop */
+	for (i = 0; i < tasks_num; i++)
+	{
+		zbx_async_poller_add_task(ev, dnsbase, "127.0.0.1", &tasks[i],
+				(int)zbx_mock_get_parameter_uint64("in.timeout"), mock_task_process, mock_task_clear);
+	}
+
+	tasks_finished = 0;
+	start = time(NULL);
+
+	while (tasks_finished < tasks_num)
+	{
+		if (MOCK_LOOP_TIMEOUT < time(NULL) - start)
+			fail_msg("%d of %d tasks finished", tasks_finished, tasks_num);
+
+		event_base_loop(ev, EVLOOP_ONCE);
+	}
+
+	/* submit requests queued by the last callbacks */
+	event_base_loop(ev, EVLOOP_NONBLOCK);
+
+	htasks = zbx_mock_get_parameter_handle("out.tasks");
+
+	for (i = 0; i < tasks_num; i++)
+	{
+		const char	*events;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(htasks, &htask)) ||
+				ZBX_MOCK_SUCCESS != (err = zbx_mock_string(htask, &events)))
+		{
+			fail_msg("cannot read task %d events: %s", i, zbx_mock_error_string(err));
+		}
+
+		zbx_snprintf(prefix, sizeof(prefix), "task %d events", i);
+		zbx_mock_assert_str_eq(prefix, events, tasks[i].events);
+	}
+
+	ret = zbx_async_poller_uring_get_stats(&stats);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("out.stats", &hstats))
+	{
+		zbx_mock_assert_result_eq("zbx_async_poller_uring_get_stats()", SUCCEED, ret);
+		zbx_mock_assert_uint64_eq("io_uring_enter() calls", zbx_mock_get_object_member_uint64(hstats, "enters"),
+				stats.enters);
+		zbx_mock_assert_uint64_eq("submitted requests", zbx_mock_get_object_member_uint64(hstats,
+				"submitted"), stats.submitted);
+		zbx_mock_assert_uint64_eq("completed requests", zbx_mock_get_object_member_uint64(hstats,
+				"completed"), stats.completed);
+	}
+	else
+		zbx_mock_assert_result_eq("zbx_async_poller_uring_get_stats()", FAIL, ret);
+
+	zbx_async_poller_uring_destroy();
+	evdns_base_free(dnsbase, 0);
+	event_base_free(ev);
+
+	for (i = 0; i < tasks_num; i++)
+		zbx_free(tasks[i].events);
+
+	zbx_free(tasks);
+}
@@ -0,0 +1,229 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcacheconfig.h"
+#include "zbxmutexs.h"
+#include "zbxdbhigh.h"
+#include "dbconfig.h"
+#include "dbsync.h"
+#include "dc_config_sync_test.h"
+
+/* columns selected by zbx_dbsync_compare_config() */
+static const char	*config_columns[] = {"configid", "discovery_groupid", "snmptrap_logging",
+		"severity_name_0", "severity_name_1", "severity_name_2", "severity_name_3", "severity_name_4",
+		"severity_name_5", "hk_events_mode", "hk_events_trigger", "hk_events_internal", "hk_events_discovery",
+		"hk_events_autoreg", "hk_services_mode", "hk_services", "hk_audit_mode", "hk_audit", "hk_sessions_mode",
+		"hk_sessions", "hk_history_mode", "hk_history_global", "hk_history", "hk_trends_mode",
+		"hk_trends_global", "hk_trends", "default_inventory_mode", "db_extension", "autoreg_tls_accept",
+		"compression_status", "compress_older", "instanceid", "default_timezone", "hk_events_service",
+		"auditlog_enabled", "timeout_zabbix_agent", "timeout_simple_check", "timeout_snmp_agent",
+		"timeout_external_check", "timeout_db_monitor", "timeout_http_agent", "timeout_ssh_agent",
+		"timeout_telnet_agent", "timeout_script"};
+
+/* columns selected by zbx_dbsync_compare_autoreg_psk() */
+static const char	*autoreg_columns[] = {"autoreg_tlsid", "tls_psk_identity", "tls_psk"};
+
+/* reads changeset rows in the given order, columns not listed in row get schema default values */
+static void	mock_read_rows(zbx_mock_handle_t hrows, zbx_dbsync_t *sync, const char *table_name,
+		const char **columns, int columns_num)
+{
+	const zbx_db_table_t	*table;
+	zbx_mock_handle_t	hrow, hvalue;
+	zbx_mock_error_t	err;
+	int			i;
+
+	if (NULL == (table = zbx_db_get_table(table_name)))
+		fail_msg("cannot find table \"%s\" in database schema", table_name);
+
+	zbx_dbsync_init(sync, ZBX_DBSYNC_UPDATE);
+	sync->columns_num = columns_num;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrows, &hrow)))
+	{
+		zbx_dbsync_row_t	*row;
+		const char		*tag, *value;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read row: %s", zbx_mock_error_string(err));
+
+		row = (zbx_dbsync_row_t *)zbx_malloc(NULL, sizeof(zbx_dbsync_row_t));
+		row->rowid = zbx_mock_get_object_member_uint64(hrow, columns[0]);
+		row->row = NULL;
+
+		tag = zbx_mock_get_object_member_string(hrow, "tag");
+
+		if (0 == strcmp(tag, "add"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_ADD;
+			sync->add_num++;
+		}
+		else if (0 == strcmp(tag, "update"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_UPDATE;
+			sync->update_num++;
+		}
+		else if (0 == strcmp(tag, "remove"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_REMOVE;
+			sync->remove_num++;
+		}
+		else
+			fail_msg("unknown row tag \"%s\"", tag);
+
+		/* removed rows are read from changelog without data */
+		if (ZBX_DBSYNC_ROW_REMOVE != row->tag)
+		{
+			row->row = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)columns_num);
+
+			for (i = 0; i < columns_num; i++)
+			{
+				if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrow, columns[i], &hvalue))
+				{
+					if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &value)))
+					{
+						fail_msg("cannot read column \"%s\": %s", columns[i],
+								zbx_mock_error_string(err));
+					}
+				}
+				else
+					value = zbx_db_get_field(table, columns[i])->default_value;
+
+				row->row[i] = (NULL != value ? zbx_strdup(NULL, value) : NULL);
+			}
+		}
+
+		zbx_vector_ptr_append(&sync->rows, row);
+	}
+}
+
+static void	mock_free_rows(zbx_dbsync_t *sync)
+{
+	int	i, j;
+
+	for (i = 0; i < sync->rows.values_num; i++)
+	{
+		zbx_dbsync_row_t	*row = (zbx_dbsync_row_t *)sync->rows.values[i];
+
+		if (NULL != row->row)
+		{
+			for (j = 0; j < sync->columns_num; j++)
+				zbx_free(row->row[j]);
+
+			zbx_free(row->row);
+		}
+
+		zbx_free(row);
+	}
+
+	zbx_vector_ptr_destroy(&sync->rows);
+	zbx_vector_ptr_destroy(&sync->columns);
+}
+
+static void	mock_check_str(zbx_mock_handle_t hout, const char *name, const char *returned)
+{
+	zbx_mock_handle_t	hvalue;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hout, name, &hvalue))
+		zbx_mock_assert_str_eq(name, zbx_mock_get_object_member_string(hout, name), returned);
+}
+
+static void	mock_check_uint64(zbx_mock_handle_t hout, const char *name, zbx_uint64_t returned)
+{
+	zbx_mock_handle_t	hvalue;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hout, name, &hvalue))
+		zbx_mock_assert_uint64_eq(name, zbx_mock_get_object_member_uint64(hout, name), returned);
+}
+
+static void	mock_check_config(zbx_mock_handle_t hout)
+{
+	const ZBX_DC_CONFIG_TABLE	*table = config->config;
+
+	mock_check_uint64(hout, "revision", config->revision.config_table);
+	mock_check_uint64(hout, "discovery_groupid", table->discovery_groupid);
+	mock_check_uint64(hout, "snmptrap_logging", table->snmptrap_logging);
+	mock_check_str(hout, "severity_name_0", table->severity_name[0]);
+	mock_check_str(hout, "default_timezone", table->default_timezone);
+	mock_check_uint64(hout, "auditlog_enabled", (zbx_uint64_t)table->auditlog_enabled);
+	mock_check_str(hout, "timeout_zabbix_agent", table->item_timeouts.agent);
+}
+
+static void	mock_check_autoreg_config(zbx_mock_handle_t hout)
+{
+	mock_check_uint64(hout, "revision", config->revision.autoreg_tls);
+	mock_check_str(hout, "tls_psk_identity", config->autoreg_psk_identity);
+	mock_check_str(hout, "tls_psk", config->autoreg_psk);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep, hrows, hout;
+	zbx_mock_error_t	err;
+	zbx_dbsync_t		sync;
+	zbx_uint64_t		revision;
+	char			*error = NULL;
+	int			i;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	if (SUCCEED != zbx_init_configuration_cache(get_program_type, get_config_forks, 8 * ZBX_MEBIBYTE, &error))
+		fail_msg("cannot initialize configuration cache: %s", error);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	/* each step is a configuration sync with changesets read from changelog */
+	for (i = 0, revision = 1; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep));
+			i++, revision++)
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step #%d: %s", i, zbx_mock_error_string(err));
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "config", &hrows))
+		{
+			mock_read_rows(hrows, &sync, "config", config_columns, (int)ARRSIZE(config_columns));
+			dc_config_sync_test_config(&sync, revision);
+			mock_free_rows(&sync);
+		}
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "autoreg", &hrows))
+		{
+			mock_read_rows(hrows, &sync, "config_autoreg_tls", autoreg_columns,
+					(int)ARRSIZE(autoreg_columns));
+			dc_config_sync_test_autoreg_config(&sync, revision);
+			mock_free_rows(&sync);
+		}
+
+		hout = zbx_mock_get_object_member_handle(hstep, "out");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hout, "config", &hrows))
+			mock_check_config(hrows);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hout, "autoreg", &hrows))
+			mock_check_autoreg_config(hrows);
+	}
+}
@@ -0,0 +1,329 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcacheconfig.h"
+#include "zbxmutexs.h"
+#include "dbconfig.h"
+#include "dbsync.h"
+#include "dc_history_export_info_test.h"
+
+#define ITEMS_COLUMNS_NUM	51
+
+static void	mock_read_rows(zbx_mock_handle_t hrows, zbx_dbsync_t *sync, int columns_num, const char **columns)
+{
+	zbx_mock_handle_t	hrow, hvalue;
+	zbx_mock_error_t	err;
+	int			i;
+
+	zbx_dbsync_init(sync, ZBX_DBSYNC_UPDATE);
+	sync->columns_num = columns_num;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrows, &hrow)))
+	{
+		zbx_dbsync_row_t	*row;
+		const char		*tag, *value;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read row: %s", zbx_mock_error_string(err));
+
+		row = (zbx_dbsync_row_t *)zbx_malloc(NULL, sizeof(zbx_dbsync_row_t));
+		row->row = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)columns_num);
+
+		for (i = 0; i < columns_num; i++)
+		{
+			if (NULL != columns[i] && ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrow, columns[i], &hvalue))
+			{
+				if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &value)))
+					fail_msg("cannot read column \"%s\": %s", columns[i], zbx_mock_error_string(err));
+			}
+			else
+				value = (NULL != columns[i] ? "" : "0");
+
+			row->row[i] = zbx_strdup(NULL, value);
+		}
+
+		ZBX_STR2UINT64(row->rowid, row->row[0]);
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrow, "tag", &hvalue) ||
+				ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &tag) || 0 == strcmp(tag, "add"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_ADD;
+			sync->add_num++;
+		}
+		else if (0 == strcmp(tag, "update"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_UPDATE;
+			sync->update_num++;
+		}
+		else if (0 == strcmp(tag, "remove"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_REMOVE;
+			sync->remove_num++;
+		}
+		else
+			fail_msg("unknown row tag \"%s\"", tag);
+
+		zbx_vector_ptr_append(&sync->rows, row);
+	}
+
+	/* configuration cache sync expects removed rows at the end */
+	for (i = 1; i < sync->rows.values_num; i++)
+	{
+		int	j;
+
+		for (j = i; 0 < j && ZBX_DBSYNC_ROW_REMOVE == ((zbx_dbsync_row_t *)sync->rows.values[j - 1])->tag &&
+				ZBX_DBSYNC_ROW_REMOVE != ((zbx_dbsync_row_t *)sync->rows.values[j])->tag; j--)
+		{
+			void	*tmp = sync->rows.values[j];
+
+			sync->rows.values[j] = sync->rows.values[j - 1];
+			sync->rows.values[j - 1] = tmp;
+		}
+	}
+}
+
+static void	mock_free_rows(zbx_dbsync_t *sync)
+{
+	int	i, j;
+
+	for (i = 0; i < sync->rows.values_num; i++)
+	{
+		zbx_dbsync_row_t	*row = (zbx_dbsync_row_t *)sync->rows.values[i];
+
+		for (j = 0; j < sync->columns_num; j++)
+			zbx_free(row->row[j]);
+
+		zbx_free(row->row);
+		zbx_free(row);
+	}
+
+	zbx_vector_ptr_destroy(&sync->rows);
+	zbx_vector_ptr_destroy(&sync->columns);
+}
+
+static void	mock_sync_step(zbx_mock_handle_t hstep, zbx_uint64_t revision)
+{
+	const char		*hostgroups_columns[] = {"groupid", "name"};
+	const char		*hostgroup_hosts_columns[] = {"groupid", "hostid"};
+	const char		*items_columns[ITEMS_COLUMNS_NUM];
+	zbx_mock_handle_t	hrows;
+	zbx_dbsync_t		sync;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "hostgroups", &hrows))
+	{
+		mock_read_rows(hrows, &sync, 2, hostgroups_columns);
+		dc_export_info_test_sync_hostgroups(&sync);
+		mock_free_rows(&sync);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "hostgroup_hosts", &hrows))
+	{
+		mock_read_rows(hrows, &sync, 2, hostgroup_hosts_columns);
+		dc_export_info_test_sync_hostgroup_hosts(&sync);
+		mock_free_rows(&sync);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "items", &hrows))
+	{
+		/* disabled trapper items with text values, unnamed numeric columns are set to 0 */
+		memset(items_columns, 0, sizeof(items_columns));
+		items_columns[0] = "itemid";
+		items_columns[1] = "hostid";
+		items_columns[2] = "status";
+		items_columns[3] = "type";
+		items_columns[4] = "value_type";
+		items_columns[5] = "key";
+		items_columns[50] = "name";	/* i.name selected by zbx_dbsync_compare_items() */
+
+		mock_read_rows(hrows, &sync, ITEMS_COLUMNS_NUM, items_columns);
+		dc_export_info_test_sync_items(&sync, revision);
+		mock_free_rows(&sync);
+	}
+}
+
+static void	mock_check_export_info(zbx_mock_handle_t hstep, const zbx_vector_uint64_t *hostids)
+{
+	zbx_mock_handle_t		hout, hhosts, hhost, hitems, hitem, hgroups, hgroup;
+	zbx_mock_error_t		err;
+	zbx_hashset_t			hosts_info, items_info;
+	zbx_hashset_iter_t		iter;
+	zbx_history_export_host_t	host_info_local, *host_info;
+	zbx_history_export_item_t	item_info_local, *item_info;
+	int				i, check_items;
+	char				prefix[MAX_STRING_LEN];
+
+	zbx_hashset_create(&hosts_info, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&items_info, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < hostids->values_num; i++)
+	{
+		host_info_local.hostid = hostids->values[i];
+		host_info = (zbx_history_export_host_t *)zbx_hashset_insert(&hosts_info, &host_info_local,
+				sizeof(host_info_local));
+		zbx_vector_str_create(&host_info->groups);
+	}
+
+	hout = zbx_mock_get_object_member_handle(hstep, "out");
+
+	check_items = (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hout, "items", &hitems));
+
+	while (0 != check_items &&
+			ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		item_info_local.itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		item_info_local.name = NULL;
+		item_info_local.item = NULL;
+		item_info = (zbx_history_export_item_t *)zbx_hashset_insert(&items_info, &item_info_local,
+				sizeof(item_info_local));
+		zbx_vector_tags_create(&item_info->item_tags);
+	}
+
+	zbx_dc_config_history_sync_get_export_info(&hosts_info, &items_info);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hout, "hosts", &hhosts))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hhosts, &hhost)))
+		{
+			zbx_uint64_t	hostid;
+
+			if (ZBX_MOCK_SUCCESS != err)
+				fail_msg("cannot read host: %s", zbx_mock_error_string(err));
+
+			hostid = zbx_mock_get_object_member_uint64(hhost, "hostid");
+
+			if (NULL == (host_info = (zbx_history_export_host_t *)zbx_hashset_search(&hosts_info, &hostid)))
+				fail_msg("host " ZBX_FS_UI64 " is not listed in input hosts", hostid);
+
+			hgroups = zbx_mock_get_object_member_handle(hhost, "groups");
+
+			for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hgroups, &hgroup)); i++)
+			{
+				const char	*name;
+
+				if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hgroup, &name)))
+					fail_msg("cannot read host group: %s", zbx_mock_error_string(err));
+
+				zbx_snprintf(prefix, sizeof(prefix), "host " ZBX_FS_UI64 " group #%d", hostid, i);
+
+				if (i >= host_info->groups.values_num)
+					fail_msg("%s \"%s\" is missing", prefix, name);
+
+				zbx_mock_assert_str_eq(prefix, name, host_info->groups.values[i]);
+			}
+
+			zbx_snprintf(prefix, sizeof(prefix), "host " ZBX_FS_UI64 " groups number", hostid);
+			zbx_mock_assert_int_eq(prefix, i, host_info->groups.values_num);
+		}
+	}
+
+	if (0 != check_items)
+		hitems = zbx_mock_get_object_member_handle(hout, "items");
+
+	while (0 != check_items && ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		zbx_uint64_t	itemid;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		item_info = (zbx_history_export_item_t *)zbx_hashset_search(&items_info, &itemid);
+
+		zbx_snprintf(prefix, sizeof(prefix), "item " ZBX_FS_UI64 " name", itemid);
+
+		if (NULL == item_info->name)
+			fail_msg("%s is not set", prefix);
+
+		zbx_mock_assert_str_eq(prefix, zbx_mock_get_object_member_string(hitem, "name"), item_info->name);
+	}
+
+	zbx_hashset_iter_reset(&hosts_info, &iter);
+
+	while (NULL != (host_info = (zbx_history_export_host_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vector_str_clear_ext(&host_info->groups, zbx_str_free);
+		zbx_vector_str_destroy(&host_info->groups);
+	}
+
+	zbx_hashset_iter_reset(&items_info, &iter);
+
+	while (NULL != (item_info = (zbx_history_export_item_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_free(item_info->name);
+		zbx_vector_tags_clear_ext(&item_info->item_tags, zbx_free_tag);
+		zbx_vector_tags_destroy(&item_info->item_tags);
+	}
+
+	zbx_hashset_destroy(&items_info);
+	zbx_hashset_destroy(&hosts_info);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hhosts, hhost, hsteps, hstep;
+	zbx_mock_error_t	err;
+	zbx_vector_uint64_t	hostids;
+	zbx_uint64_t		hostid, revision;
+	char			*error = NULL;
+	int			i;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	if (SUCCEED != zbx_init_configuration_cache(get_program_type, get_config_forks, 8 * ZBX_MEBIBYTE, &error))
+		fail_msg("cannot initialize configuration cache: %s", error);
+
+	zbx_vector_uint64_create(&hostids);
+	hhosts = zbx_mock_get_parameter_handle("in.hosts");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hhosts, &hhost)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hhost, &hostid)))
+			fail_msg("cannot read host: %s", zbx_mock_error_string(err));
+
+		dc_export_info_test_add_host(hostid);
+		zbx_vector_uint64_append(&hostids, hostid);
+	}
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	/* export information is checked after each configuration sync */
+	for (i = 0, revision = 1; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep));
+			i++, revision++)
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step #%d: %s", i, zbx_mock_error_string(err));
+
+		mock_sync_step(hstep, revision);
+		mock_check_export_info(hstep, &hostids);
+	}
+
+	zbx_vector_uint64_destroy(&hostids);
+}
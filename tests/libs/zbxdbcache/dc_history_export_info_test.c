@@ -0,0 +1,52 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_history_export_info_test.h"
+
+void	dc_export_info_test_add_host(zbx_uint64_t hostid)
+{
+	ZBX_DC_HOST	*host;
+	int		found;
+
+	host = (ZBX_DC_HOST *)DCfind_id(&config->hosts, hostid, sizeof(ZBX_DC_HOST), &found);
+
+	if (0 != found)
+		return;
+
+	host->status = HOST_STATUS_NOT_MONITORED;
+	host->proxyid = 0;
+	host->revision = 0;
+	zbx_vector_dc_item_ptr_create_ext(&host->items, __config_shmem_malloc_func, __config_shmem_realloc_func,
+			__config_shmem_free_func);
+}
+
+void	dc_export_info_test_sync_hostgroups(zbx_dbsync_t *sync)
+{
+	DCsync_hostgroups(sync);
+}
+
+void	dc_export_info_test_sync_hostgroup_hosts(zbx_dbsync_t *sync)
+{
+	DCsync_hostgroup_hosts(sync);
+}
+
+void	dc_export_info_test_sync_items(zbx_dbsync_t *sync, zbx_uint64_t revision)
+{
+	DCsync_items(sync, revision, 0, ZBX_SYNCED_NEW_CONFIG_NO, NULL);
+}
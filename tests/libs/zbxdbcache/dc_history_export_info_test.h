@@ -0,0 +1,28 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef DC_HISTORY_EXPORT_INFO_TEST_H
+#define DC_HISTORY_EXPORT_INFO_TEST_H
+
+void	dc_export_info_test_add_host(zbx_uint64_t hostid);
+void	dc_export_info_test_sync_hostgroups(zbx_dbsync_t *sync);
+void	dc_export_info_test_sync_hostgroup_hosts(zbx_dbsync_t *sync);
+void	dc_export_info_test_sync_items(zbx_dbsync_t *sync, zbx_uint64_t revision);
+
+#endif /* DC_HISTORY_EXPORT_INFO_TEST_H */
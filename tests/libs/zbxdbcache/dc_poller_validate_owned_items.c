@@ -0,0 +1,202 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbx_host_constants.h"
+#include "zbx_item_constants.h"
+#include "zbxcacheconfig.h"
+#include "dbconfig.h"
+#include "dc_poller_validate_owned_items_test.h"
+
+static zbx_uint64_t	mock_get_object_member_uint64_default(zbx_mock_handle_t object, const char *name,
+		zbx_uint64_t value)
+{
+	zbx_mock_handle_t	hmember;
+	zbx_mock_error_t	err;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(object, name, &hmember))
+		return value;
+
+	if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hmember, &value)))
+		fail_msg("cannot read \"%s\": %s", name, zbx_mock_error_string(err));
+
+	return value;
+}
+
+static void	mock_read_hosts(void)
+{
+	zbx_mock_handle_t	hhosts, hhost;
+	zbx_mock_error_t	err;
+
+	hhosts = zbx_mock_get_parameter_handle("in.hosts");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hhosts, &hhost)))
+	{
+		ZBX_DC_HOST	host;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read host: %s", zbx_mock_error_string(err));
+
+		memset(&host, 0, sizeof(host));
+		host.hostid = zbx_mock_get_object_member_uint64(hhost, "hostid");
+		host.revision = zbx_mock_get_object_member_uint64(hhost, "revision");
+		host.status = (unsigned char)mock_get_object_member_uint64_default(hhost, "status",
+				HOST_STATUS_MONITORED);
+		host.maintenance_status = (unsigned char)mock_get_object_member_uint64_default(hhost,
+				"maintenance_status", HOST_MAINTENANCE_STATUS_OFF);
+		host.maintenance_type = (unsigned char)mock_get_object_member_uint64_default(hhost,
+				"maintenance_type", MAINTENANCE_TYPE_NORMAL);
+
+		dc_owned_items_test_add_host(&host);
+	}
+}
+
+static void	mock_read_interfaces(void)
+{
+	zbx_mock_handle_t	hinterfaces, hinterface;
+	zbx_mock_error_t	err;
+
+	hinterfaces = zbx_mock_get_parameter_handle("in.interfaces");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hinterfaces, &hinterface)))
+	{
+		ZBX_DC_INTERFACE	interface;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read interface: %s", zbx_mock_error_string(err));
+
+		memset(&interface, 0, sizeof(interface));
+		interface.interfaceid = zbx_mock_get_object_member_uint64(hinterface, "interfaceid");
+		interface.disable_until = (int)mock_get_object_member_uint64_default(hinterface, "disable_until", 0);
+
+		dc_owned_items_test_add_interface(&interface);
+	}
+}
+
+static void	mock_read_items(unsigned char poller_type)
+{
+	zbx_mock_handle_t	hitems, hitem, htype;
+	zbx_mock_error_t	err;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		ZBX_DC_ITEM	item;
+		const char	*type;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		memset(&item, 0, sizeof(item));
+		item.itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		item.hostid = zbx_mock_get_object_member_uint64(hitem, "hostid");
+		item.interfaceid = mock_get_object_member_uint64_default(hitem, "interfaceid", 0);
+		item.revision = zbx_mock_get_object_member_uint64(hitem, "revision");
+		item.status = (unsigned char)mock_get_object_member_uint64_default(hitem, "status", ITEM_STATUS_ACTIVE);
+		item.location = (unsigned char)mock_get_object_member_uint64_default(hitem, "location",
+				ZBX_LOC_POLLER);
+		item.poller_type = (unsigned char)mock_get_object_member_uint64_default(hitem, "poller_type",
+				poller_type);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, "type", &htype) &&
+				ZBX_MOCK_SUCCESS == zbx_mock_string(htype, &type))
+		{
+			item.type = (unsigned char)zbx_mock_str_to_item_type(type);
+		}
+		else
+			item.type = ITEM_TYPE_ZABBIX;
+
+		dc_owned_items_test_add_item(&item);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	howned, hitem, hreleased;
+	zbx_mock_error_t	err;
+	zbx_vector_uint64_t	itemids, revisions, released, released_exp;
+	zbx_uint64_t		revision = 0, itemid;
+	unsigned char		poller_type;
+	char			*error = NULL;
+	int			i;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != dc_owned_items_test_init(ZBX_MEBIBYTE, zbx_mock_get_parameter_uint64("in.revision"),
+			&error))
+	{
+		fail_msg("cannot initialize configuration cache: %s", error);
+	}
+
+	poller_type = (unsigned char)zbx_mock_get_parameter_uint64("in.poller_type");
+
+	mock_read_hosts();
+	mock_read_interfaces();
+	mock_read_items(poller_type);
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_create(&revisions);
+	zbx_vector_uint64_create(&released);
+	zbx_vector_uint64_create(&released_exp);
+
+	howned = zbx_mock_get_parameter_handle("in.owned");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(howned, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read owned item: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(&itemids, zbx_mock_get_object_member_uint64(hitem, "itemid"));
+		zbx_vector_uint64_append(&revisions, zbx_mock_get_object_member_uint64(hitem, "revision"));
+	}
+
+	hreleased = zbx_mock_get_parameter_handle("out.released");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hreleased, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hitem, &itemid)))
+			fail_msg("cannot read released item: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(&released_exp, itemid);
+	}
+
+	zbx_dc_poller_validate_owned_items(poller_type, itemids.values, revisions.values, itemids.values_num,
+			&released, &revision);
+
+	zbx_mock_assert_uint64_eq("validated revision", zbx_mock_get_parameter_uint64("out.revision"), revision);
+
+	zbx_vector_uint64_sort(&released, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(&released_exp, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_mock_assert_int_eq("number of released items", released_exp.values_num, released.values_num);
+
+	for (i = 0; i < released.values_num; i++)
+		zbx_mock_assert_uint64_eq("released item", released_exp.values[i], released.values[i]);
+
+	zbx_vector_uint64_destroy(&released_exp);
+	zbx_vector_uint64_destroy(&released);
+	zbx_vector_uint64_destroy(&revisions);
+	zbx_vector_uint64_destroy(&itemids);
+}
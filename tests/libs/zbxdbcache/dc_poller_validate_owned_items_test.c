@@ -0,0 +1,57 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_poller_validate_owned_items_test.h"
+
+int	dc_owned_items_test_init(zbx_uint64_t size, zbx_uint64_t revision, char **error)
+{
+	if (SUCCEED != zbx_shmem_create(&config_mem, size, "configuration cache", "CacheSize", 0, error))
+		return FAIL;
+
+	config = (ZBX_DC_CONFIG *)zbx_malloc(NULL, sizeof(ZBX_DC_CONFIG));
+	memset(config, 0, sizeof(ZBX_DC_CONFIG));
+
+	zbx_hashset_create_ext(&config->items, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			NULL, __config_shmem_malloc_func, __config_shmem_realloc_func, __config_shmem_free_func);
+	zbx_hashset_create_ext(&config->hosts, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			NULL, __config_shmem_malloc_func, __config_shmem_realloc_func, __config_shmem_free_func);
+	zbx_hashset_create_ext(&config->interfaces, 0, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL, __config_shmem_malloc_func, __config_shmem_realloc_func,
+			__config_shmem_free_func);
+
+	config->um_cache = um_cache_create();
+	config->revision.config = revision;
+
+	return SUCCEED;
+}
+
+void	dc_owned_items_test_add_host(const ZBX_DC_HOST *host)
+{
+	zbx_hashset_insert(&config->hosts, host, sizeof(ZBX_DC_HOST));
+}
+
+void	dc_owned_items_test_add_interface(const ZBX_DC_INTERFACE *interface)
+{
+	zbx_hashset_insert(&config->interfaces, interface, sizeof(ZBX_DC_INTERFACE));
+}
+
+void	dc_owned_items_test_add_item(const ZBX_DC_ITEM *item)
+{
+	zbx_hashset_insert(&config->items, item, sizeof(ZBX_DC_ITEM));
+}
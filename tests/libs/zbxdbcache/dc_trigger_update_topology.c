@@ -0,0 +1,191 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcacheconfig.h"
+#include "dbconfig.h"
+#include "dbsync.h"
+#include "dc_trigger_update_topology_test.h"
+
+static void	mock_read_dependencies(const char *path, zbx_dbsync_t *sync)
+{
+	zbx_mock_handle_t	hdeps, hdep, htag;
+	zbx_mock_error_t	err;
+	int			i;
+
+	zbx_dbsync_init(sync, ZBX_DBSYNC_UPDATE);
+	sync->columns_num = 2;
+
+	hdeps = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hdeps, &hdep)))
+	{
+		zbx_dbsync_row_t	*row;
+		const char		*tag;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read dependency: %s", zbx_mock_error_string(err));
+
+		row = (zbx_dbsync_row_t *)zbx_malloc(NULL, sizeof(zbx_dbsync_row_t));
+		row->rowid = 0;
+		row->row = (char **)zbx_malloc(NULL, sizeof(char *) * 2);
+		row->row[0] = zbx_strdup(NULL, zbx_mock_get_object_member_string(hdep, "down"));
+		row->row[1] = zbx_strdup(NULL, zbx_mock_get_object_member_string(hdep, "up"));
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hdep, "tag", &htag) ||
+				ZBX_MOCK_SUCCESS != zbx_mock_string(htag, &tag) || 0 == strcmp(tag, "add"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_ADD;
+			sync->add_num++;
+		}
+		else if (0 == strcmp(tag, "remove"))
+		{
+			row->tag = ZBX_DBSYNC_ROW_REMOVE;
+			sync->remove_num++;
+		}
+		else
+			fail_msg("unknown dependency tag \"%s\"", tag);
+
+		zbx_vector_ptr_append(&sync->rows, row);
+	}
+
+	/* trigger dependency sync expects removed rows at the end */
+	for (i = 0; i < sync->rows.values_num; i++)
+	{
+		int	j;
+
+		for (j = i + 1; j < sync->rows.values_num; j++)
+		{
+			if (((zbx_dbsync_row_t *)sync->rows.values[i])->tag >
+					((zbx_dbsync_row_t *)sync->rows.values[j])->tag)
+			{
+				void	*tmp = sync->rows.values[i];
+
+				sync->rows.values[i] = sync->rows.values[j];
+				sync->rows.values[j] = tmp;
+			}
+		}
+	}
+}
+
+static void	mock_free_dependencies(zbx_dbsync_t *sync)
+{
+	int	i;
+
+	for (i = 0; i < sync->rows.values_num; i++)
+	{
+		zbx_dbsync_row_t	*row = (zbx_dbsync_row_t *)sync->rows.values[i];
+
+		zbx_free(row->row[0]);
+		zbx_free(row->row[1]);
+		zbx_free(row->row);
+		zbx_free(row);
+	}
+
+	zbx_vector_ptr_destroy(&sync->rows);
+	zbx_vector_ptr_destroy(&sync->columns);
+}
+
+static void	mock_check_topology(const char *path)
+{
+	zbx_mock_handle_t	htriggers, htrigger;
+	zbx_mock_error_t	err;
+
+	htriggers = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(htriggers, &htrigger)))
+	{
+		zbx_uint64_t	triggerid;
+		char		name[64];
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read trigger: %s", zbx_mock_error_string(err));
+
+		triggerid = zbx_mock_get_object_member_uint64(htrigger, "triggerid");
+		zbx_snprintf(name, sizeof(name), "topoindex of trigger " ZBX_FS_UI64, triggerid);
+
+		zbx_mock_assert_uint64_eq(name, zbx_mock_get_object_member_uint64(htrigger, "topoindex"),
+				dc_trigger_topology_test_get_topoindex(triggerid));
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	htriggers, htrigger;
+	zbx_mock_error_t	err;
+	zbx_dbsync_t		sync;
+	zbx_hashset_t		topology;
+	char			*error = NULL;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != dc_trigger_topology_test_init(ZBX_MEBIBYTE, &error))
+		fail_msg("cannot initialize configuration cache: %s", error);
+
+	htriggers = zbx_mock_get_parameter_handle("in.triggers");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(htriggers, &htrigger)))
+	{
+		zbx_mock_handle_t	hflags;
+		zbx_uint64_t		flags = ZBX_FLAG_DISCOVERY_NORMAL;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read trigger: %s", zbx_mock_error_string(err));
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(htrigger, "flags", &hflags) &&
+				ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hflags, &flags)))
+		{
+			fail_msg("cannot read trigger flags: %s", zbx_mock_error_string(err));
+		}
+
+		dc_trigger_topology_test_add_trigger(zbx_mock_get_object_member_uint64(htrigger, "triggerid"),
+				(unsigned char)flags);
+	}
+
+	/* initial dependencies, topology is calculated from cache */
+	mock_read_dependencies("in.dependencies", &sync);
+	dc_trigger_topology_test_sync_trigdeps(&sync);
+	dc_trigger_topology_test_update(NULL);
+	mock_free_dependencies(&sync);
+
+	mock_check_topology("out.initial");
+
+	/* changed dependencies, topology is calculated before applying changes to cache */
+	mock_read_dependencies("in.changes", &sync);
+	dc_trigger_topology_test_calculate(&sync, &topology);
+
+	/* calculating topology must not change cache */
+	mock_check_topology("out.initial");
+
+	dc_trigger_topology_test_sync_trigdeps(&sync);
+	dc_trigger_topology_test_update(&topology);
+	dc_trigger_topology_test_destroy(&topology);
+	mock_free_dependencies(&sync);
+
+	mock_check_topology("out.changed");
+
+	/* topology calculated before applying changes must match topology recalculated from cache */
+	dc_trigger_topology_test_update(NULL);
+	mock_check_topology("out.changed");
+}
@@ -0,0 +1,76 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_trigger_update_topology_test.h"
+
+int	dc_trigger_topology_test_init(zbx_uint64_t size, char **error)
+{
+	if (SUCCEED != zbx_shmem_create(&config_mem, size, "configuration cache", "CacheSize", 0, error))
+		return FAIL;
+
+	config = (ZBX_DC_CONFIG *)zbx_malloc(NULL, sizeof(ZBX_DC_CONFIG));
+	zbx_hashset_create_ext(&config->triggers, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			NULL, __config_shmem_malloc_func, __config_shmem_realloc_func, __config_shmem_free_func);
+	zbx_hashset_create_ext(&config->trigdeps, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			NULL, __config_shmem_malloc_func, __config_shmem_realloc_func, __config_shmem_free_func);
+
+	return SUCCEED;
+}
+
+void	dc_trigger_topology_test_add_trigger(zbx_uint64_t triggerid, unsigned char flags)
+{
+	ZBX_DC_TRIGGER	trigger_local;
+
+	memset(&trigger_local, 0, sizeof(trigger_local));
+	trigger_local.triggerid = triggerid;
+	trigger_local.flags = flags;
+	trigger_local.topoindex = 1;
+
+	zbx_hashset_insert(&config->triggers, &trigger_local, sizeof(trigger_local));
+}
+
+unsigned char	dc_trigger_topology_test_get_topoindex(zbx_uint64_t triggerid)
+{
+	const ZBX_DC_TRIGGER	*trigger;
+
+	if (NULL == (trigger = (const ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &triggerid)))
+		return 0;
+
+	return trigger->topoindex;
+}
+
+void	dc_trigger_topology_test_sync_trigdeps(zbx_dbsync_t *sync)
+{
+	DCsync_trigdeps(sync);
+}
+
+void	dc_trigger_topology_test_calculate(const zbx_dbsync_t *tdep_sync, zbx_hashset_t *topology)
+{
+	dc_trigger_topology_calculate(NULL, tdep_sync, topology);
+}
+
+void	dc_trigger_topology_test_update(zbx_hashset_t *topology)
+{
+	dc_trigger_update_topology(topology);
+}
+
+void	dc_trigger_topology_test_destroy(zbx_hashset_t *topology)
+{
+	dc_trigger_topology_destroy(topology);
+}
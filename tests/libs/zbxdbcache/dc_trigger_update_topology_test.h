@@ -0,0 +1,31 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef DC_TRIGGER_UPDATE_TOPOLOGY_TEST_H
+#define DC_TRIGGER_UPDATE_TOPOLOGY_TEST_H
+
+int	dc_trigger_topology_test_init(zbx_uint64_t size, char **error);
+void	dc_trigger_topology_test_add_trigger(zbx_uint64_t triggerid, unsigned char flags);
+unsigned char	dc_trigger_topology_test_get_topoindex(zbx_uint64_t triggerid);
+void	dc_trigger_topology_test_sync_trigdeps(zbx_dbsync_t *sync);
+void	dc_trigger_topology_test_calculate(const zbx_dbsync_t *tdep_sync, zbx_hashset_t *topology);
+void	dc_trigger_topology_test_update(zbx_hashset_t *topology);
+void	dc_trigger_topology_test_destroy(zbx_hashset_t *topology);
+
+#endif /* DC_TRIGGER_UPDATE_TOPOLOGY_TEST_H */
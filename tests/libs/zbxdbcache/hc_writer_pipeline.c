@@ -0,0 +1,177 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcachehistory.h"
+#include "history_writer.h"
+
+/* history batch, the same batch structures are reused as in history syncer */
+typedef struct
+{
+	int	num;		/* the batch number, starting with 1 */
+	int	written;	/* the batch number the last written history belonged to */
+}
+hc_test_batch_t;
+
+static pthread_t	main_thread;
+static int		write_delay;
+
+static int		connects, closes;
+static int		*written, written_num;
+
+/* rows written by the current thread, collected by zbx_db_insert_stats_collect() */
+static ZBX_THREAD_LOCAL zbx_uint64_t	rows;
+
+int	zbx_db_connect(int flag)
+{
+	ZBX_UNUSED(flag);
+
+	if (0 != pthread_equal(main_thread, pthread_self()))
+		fail_msg("history writer connected to database in main thread");
+
+	connects++;
+
+	return ZBX_DB_OK;
+}
+
+void	zbx_db_close(void)
+{
+	if (0 != pthread_equal(main_thread, pthread_self()))
+		fail_msg("history writer closed database connection in main thread");
+
+	closes++;
+}
+
+void	zbx_db_insert_stats_collect(zbx_db_insert_stats_t *stats)
+{
+	stats[0].rows += rows;
+	rows = 0;
+}
+
+static void	hc_test_batch_write(void *data)
+{
+	hc_test_batch_t	*batch = (hc_test_batch_t *)data;
+
+	if (0 != pthread_equal(main_thread, pthread_self()))
+		fail_msg("batch %d was written in main thread", batch->num);
+
+	if (0 != write_delay)
+		usleep((useconds_t)write_delay);
+
+	written[written_num++] = batch->num;
+	batch->written = batch->num;
+	rows++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes batches the same way as history syncer does with        *
+ *          pipelining enabled                                                *
+ *                                                                            *
+ * Comments: The next batch is submitted to writer before the previous batch  *
+ *           is processed and processing waits for the batch to be written.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_test_pipeline(int batches_num)
+{
+	hc_test_batch_t	batches[2] = {{0}}, *next = &batches[0], *batch = &batches[1], *tmp;
+	int		i, processed = 0;
+
+	for (i = 1; i <= batches_num + 1; i++)
+	{
+		if (i <= batches_num)
+		{
+			next->num = i;
+			hc_writer_submit(hc_test_batch_write, next);
+		}
+		else
+			next->num = 0;
+
+		if (0 != batch->num)
+		{
+			if (batch->written != batch->num)
+				fail_msg("batch %d was processed before it was written", batch->num);
+
+			zbx_mock_assert_int_eq("processed batch", ++processed, batch->num);
+		}
+
+		if (0 != next->num)
+			hc_writer_wait();
+
+		tmp = next;
+		next = batch;
+		batch = tmp;
+	}
+
+	zbx_mock_assert_int_eq("processed batches", batches_num, processed);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int			batches_num, i;
+	char			*error = NULL;
+	zbx_db_insert_stats_t	stats[ZBX_DB_INSERT_STATS_TABLES_NUM];
+	hc_test_batch_t		last = {0};
+
+	ZBX_UNUSED(state);
+
+	batches_num = (int)zbx_mock_get_parameter_uint64("in.batches");
+	write_delay = (int)zbx_mock_get_parameter_uint64("in.delay");
+
+	main_thread = pthread_self();
+	written = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)(batches_num + 1));
+
+	zbx_mock_assert_result_eq("hc_writer_started()", FAIL, hc_writer_started());
+
+	if (SUCCEED != zbx_hc_writer_start(&error))
+		fail_msg("cannot start history writer: %s", error);
+
+	zbx_mock_assert_result_eq("hc_writer_started()", SUCCEED, hc_writer_started());
+
+	hc_test_pipeline(batches_num);
+
+	/* batches must be written in the order they were submitted */
+	zbx_mock_assert_int_eq("written batches", batches_num, written_num);
+
+	for (i = 0; i < written_num; i++)
+		zbx_mock_assert_int_eq("written batch", i + 1, written[i]);
+
+	/* rows written by writer thread are reported to history syncer */
+	memset(stats, 0, sizeof(stats));
+	hc_writer_stats_collect(stats);
+	zbx_mock_assert_uint64_eq("collected rows", (zbx_uint64_t)batches_num, stats[0].rows);
+
+	/* the submitted batch must be written before writer is stopped */
+	last.num = batches_num + 1;
+	hc_writer_submit(hc_test_batch_write, &last);
+	zbx_hc_writer_stop();
+
+	zbx_mock_assert_int_eq("last batch", last.num, last.written);
+	zbx_mock_assert_result_eq("hc_writer_started()", FAIL, hc_writer_started());
+
+	/* writer uses its own database connection for its lifetime */
+	zbx_mock_assert_int_eq("database connects", 1, connects);
+	zbx_mock_assert_int_eq("database closes", 1, closes);
+
+	zbx_free(written);
+}
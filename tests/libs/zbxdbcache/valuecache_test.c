@@ -40,7 +40,11 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+		{
+			zbx_history_record_t	record = {.timestamp = VC_CHUNK_TS(chunk, i), .value = chunk->values[i]};
+
+			vc_history_record_vector_append(values, value_type, &record);
+		}
 	}
 
 	return SUCCEED;
@@ -0,0 +1,324 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcachevalue.h"
+#include "zbxhistory.h"
+#include "history.h"
+#include "zbxmutexs.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* reader process exit codes */
+#define VC_TEST_READ_FAILED		2
+#define VC_TEST_READ_INCONSISTENT	3
+#define VC_TEST_READ_NONE		4
+
+/* the number of reads after which reader flushes statistics, write locking the cache */
+#define VC_TEST_FLUSH_PERIOD		100
+
+/* test state shared between appending (parent) and reader processes */
+typedef struct
+{
+	volatile int	appended;
+	volatile int	done;
+}
+vc_test_state_t;
+
+int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
+		zbx_vector_history_record_t *values);
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush);
+void	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type);
+int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
+void	__wrap_zbx_elastic_version_extract(struct zbx_json *json, int *result);
+zbx_uint32_t	__wrap_zbx_elastic_version_get(void);
+
+int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	ZBX_UNUSED(itemid);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(start);
+	ZBX_UNUSED(count);
+	ZBX_UNUSED(end);
+	ZBX_UNUSED(values);
+
+	return SUCCEED;
+}
+
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush)
+{
+	ZBX_UNUSED(history);
+
+	*ret_flush = FLUSH_SUCCEED;
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type)
+{
+	ZBX_UNUSED(hist);
+	ZBX_UNUSED(value_type);
+}
+
+int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error)
+{
+	ZBX_UNUSED(hist);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(error);
+
+	return FAIL;
+}
+
+void	__wrap_zbx_elastic_version_extract(struct zbx_json *json, int *result)
+{
+	ZBX_UNUSED(json);
+	ZBX_UNUSED(result);
+}
+
+zbx_uint32_t	__wrap_zbx_elastic_version_get(void)
+{
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks that values read from cache are a consistent sequence of   *
+ *          appended values                                                   *
+ *                                                                            *
+ * Parameters: values - [IN] the values in descending order                   *
+ *             base   - [IN] the timestamp of the first appended value        *
+ *                                                                            *
+ * Return value: SUCCEED - the values are consecutive appended values         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The appended value N has timestamp base + N and value N, so      *
+ *           uninitialized slots, lost values and mixed up chunks are         *
+ *           detected.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_test_check_values(const zbx_vector_history_record_t *values, int base)
+{
+	int	i;
+
+	for (i = 0; i < values->values_num; i++)
+	{
+		const zbx_history_record_t	*record = &values->values[i];
+
+		if (record->value.dbl != (double)(record->timestamp.sec - base))
+			return FAIL;
+
+		if (0 < i && record->timestamp.sec != values->values[i - 1].timestamp.sec - 1)
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static int	vc_test_reader(const vc_test_state_t *state, int items_num, int seconds, int count, int base)
+{
+	zbx_vector_history_record_t	values;
+	zbx_timespec_t			ts = {0, 0};
+	int				reads = 0, ret = SUCCEED;
+
+	zbx_history_record_vector_create(&values);
+
+	while (0 == state->done)
+	{
+		zbx_uint64_t	itemid = (zbx_uint64_t)(reads % items_num) + 1;
+
+		ts.sec = base + state->appended;
+
+		if (SUCCEED != zbx_vc_get_values(itemid, ITEM_VALUE_TYPE_FLOAT, &values, seconds, count, &ts))
+		{
+			ret = VC_TEST_READ_FAILED;
+			break;
+		}
+
+		if (SUCCEED != vc_test_check_values(&values, base))
+		{
+			ret = VC_TEST_READ_INCONSISTENT;
+			break;
+		}
+
+		zbx_history_record_vector_clean(&values, ITEM_VALUE_TYPE_FLOAT);
+
+		if (0 == ++reads % VC_TEST_FLUSH_PERIOD)
+			zbx_vc_flush_stats();
+	}
+
+	zbx_history_record_vector_destroy(&values, ITEM_VALUE_TYPE_FLOAT);
+
+	if (SUCCEED == ret && 0 == reads)
+		ret = VC_TEST_READ_NONE;
+
+	return ret;
+}
+
+static void	vc_test_append(vc_test_state_t *state, int items_num, int values_num, int batch_size, int base)
+{
+	zbx_dc_history_t	*history;
+	zbx_vector_ptr_t	batch;
+	int			i, j, ret_flush;
+
+	history = (zbx_dc_history_t *)zbx_calloc(NULL, (size_t)(batch_size * items_num), sizeof(zbx_dc_history_t));
+	zbx_vector_ptr_create(&batch);
+
+	for (i = 0; i < values_num; i += batch_size)
+	{
+		int	num = MIN(batch_size, values_num - i);
+
+		zbx_vector_ptr_clear(&batch);
+
+		for (j = 0; j < num * items_num; j++)
+		{
+			zbx_dc_history_t	*h = &history[j];
+
+			h->itemid = (zbx_uint64_t)(j % items_num) + 1;
+			h->value_type = ITEM_VALUE_TYPE_FLOAT;
+			h->ts.sec = base + i + j / items_num;
+			h->ts.ns = 0;
+			h->value.dbl = (double)(i + j / items_num);
+			zbx_vector_ptr_append(&batch, h);
+		}
+
+		if (SUCCEED != zbx_vc_add_values(&batch, &ret_flush))
+		{
+			state->done = 1;
+			fail_msg("cannot add values to value cache");
+		}
+
+		state->appended = i + num;
+	}
+
+	zbx_vector_ptr_destroy(&batch);
+	zbx_free(history);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int				items_num, values_num, batch_size, readers_num, seconds, count, base, i, status;
+	char				*error = NULL;
+	vc_test_state_t			*test_state;
+	zbx_vector_history_record_t	values;
+	zbx_timespec_t			ts;
+	zbx_uint64_t			itemid;
+
+	ZBX_UNUSED(state);
+
+	items_num = (int)zbx_mock_get_parameter_uint64("in.items");
+	values_num = (int)zbx_mock_get_parameter_uint64("in.values");
+	batch_size = (int)zbx_mock_get_parameter_uint64("in.batch");
+	readers_num = (int)zbx_mock_get_parameter_uint64("in.readers");
+	seconds = (int)zbx_mock_get_parameter_uint64("in.seconds");
+	count = (int)zbx_mock_get_parameter_uint64("in.count");
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	if (SUCCEED != zbx_vc_init(zbx_mock_get_parameter_uint64("in.cache_size"), &error))
+		fail_msg("cannot initialize value cache: %s", error);
+
+	zbx_vc_enable();
+
+	test_state = (vc_test_state_t *)mmap(NULL, sizeof(vc_test_state_t), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (MAP_FAILED == test_state)
+		fail_msg("cannot allocate shared memory: %s", zbx_strerror(errno));
+
+	/* Values are appended with one second interval starting with the current time. Requests ending */
+	/* with the last appended value set item active range close to the requested period, so old     */
+	/* chunks are removed while appending values.                                                   */
+	base = (int)time(NULL);
+
+	/* cache items before appending values, only cached items get appended values */
+	zbx_history_record_vector_create(&values);
+	ts.sec = base - 1;
+	ts.ns = 0;
+
+	for (itemid = 1; itemid <= (zbx_uint64_t)items_num; itemid++)
+	{
+		zbx_mock_assert_result_eq("zbx_vc_get_values()", SUCCEED, zbx_vc_get_values(itemid,
+				ITEM_VALUE_TYPE_FLOAT, &values, seconds, count, &ts));
+		zbx_history_record_vector_clean(&values, ITEM_VALUE_TYPE_FLOAT);
+	}
+
+	zbx_vc_flush_stats();
+
+	for (i = 0; i < readers_num; i++)
+	{
+		pid_t	pid;
+
+		if (-1 == (pid = fork()))
+			fail_msg("cannot fork: %s", zbx_strerror(errno));
+
+		if (0 == pid)
+			exit(vc_test_reader(test_state, items_num, seconds, count, base));
+	}
+
+	vc_test_append(test_state, items_num, values_num, batch_size, base);
+	test_state->done = 1;
+
+	while (0 < wait(&status))
+	{
+		if (!WIFEXITED(status))
+			fail_msg("reader process terminated abnormally");
+
+		switch (WEXITSTATUS(status))
+		{
+			case SUCCEED:
+				break;
+			case VC_TEST_READ_FAILED:
+				fail_msg("reader process failed to get values");
+				break;
+			case VC_TEST_READ_INCONSISTENT:
+				fail_msg("reader process got inconsistent values");
+				break;
+			case VC_TEST_READ_NONE:
+				fail_msg("reader process did not read any values");
+				break;
+			default:
+				fail_msg("reader process exited with code %d", WEXITSTATUS(status));
+		}
+	}
+
+	/* the newest values of all items must be cached after appending is finished */
+	ts.sec = base + values_num;
+
+	for (itemid = 1; itemid <= (zbx_uint64_t)items_num; itemid++)
+	{
+		zbx_mock_assert_result_eq("zbx_vc_get_values()", SUCCEED, zbx_vc_get_values(itemid,
+				ITEM_VALUE_TYPE_FLOAT, &values, 0, 1, &ts));
+		zbx_mock_assert_int_eq("number of values", 1, values.values_num);
+		zbx_mock_assert_int_eq("last value timestamp", base + values_num - 1, values.values[0].timestamp.sec);
+
+		zbx_history_record_vector_clean(&values, ITEM_VALUE_TYPE_FLOAT);
+	}
+
+	zbx_history_record_vector_destroy(&values, ITEM_VALUE_TYPE_FLOAT);
+
+	munmap(test_state, sizeof(vc_test_state_t));
+	zbx_vc_destroy();
+}
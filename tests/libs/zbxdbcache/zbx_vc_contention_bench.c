@@ -0,0 +1,314 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Value cache read/append contention benchmark.
+ *
+ * Forks reader processes requesting the last values of random items and appender processes
+ * adding new values to the same items in batches (like history syncers), then reports the
+ * read and append throughput. History backend is replaced with stubs, so the benchmark
+ * measures only value cache locking and data access.
+ *
+ * Usage: zbx_vc_contention_bench [readers] [appenders] [items] [seconds]
+ */
+
+#include "zbxcachevalue.h"
+#include "zbxhistory.h"
+#include "history.h"
+#include "zbxmutexs.h"
+#include "zbxtime.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define VC_BENCH_CACHE_SIZE	(256 * ZBX_MEBIBYTE)
+#define VC_BENCH_BATCH_SIZE	100
+#define VC_BENCH_READ_COUNT	10
+#define VC_BENCH_FLUSH_PERIOD	1000
+
+const char	title_message[] = "zbx_vc_contention_bench";
+const char	*usage_message[] = {"[readers] [appenders] [items] [seconds]", NULL};
+const char	*help_message[] = {"Value cache read/append contention benchmark.", NULL};
+const char	*progname = "zbx_vc_contention_bench";
+const char	syslog_app_name[] = "zbx_vc_contention_bench";
+
+char	*CONFIG_HISTORY_STORAGE_URL	= NULL;
+char	*CONFIG_HISTORY_STORAGE_OPTS	= NULL;
+
+int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
+		zbx_vector_history_record_t *values);
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush);
+void	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type);
+int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
+void	__wrap_zbx_elastic_version_extract(struct zbx_json *json, int *result);
+zbx_uint32_t	__wrap_zbx_elastic_version_get(void);
+
+int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	ZBX_UNUSED(itemid);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(start);
+	ZBX_UNUSED(count);
+	ZBX_UNUSED(end);
+	ZBX_UNUSED(values);
+
+	return SUCCEED;
+}
+
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush)
+{
+	ZBX_UNUSED(history);
+
+	*ret_flush = FLUSH_SUCCEED;
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type)
+{
+	ZBX_UNUSED(hist);
+	ZBX_UNUSED(value_type);
+}
+
+int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error)
+{
+	ZBX_UNUSED(hist);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(error);
+
+	return FAIL;
+}
+
+void	__wrap_zbx_elastic_version_extract(struct zbx_json *json, int *result)
+{
+	ZBX_UNUSED(json);
+	ZBX_UNUSED(result);
+}
+
+zbx_uint32_t	__wrap_zbx_elastic_version_get(void)
+{
+	return 0;
+}
+
+static void	bench_log_impl(int level, const char *fmt, va_list args)
+{
+	ZBX_UNUSED(level);
+
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+}
+
+static zbx_uint64_t	bench_reader(int items_num, double end, unsigned int seed)
+{
+	zbx_vector_history_record_t	values;
+	zbx_timespec_t			ts;
+	zbx_uint64_t			reads = 0;
+	int				i;
+
+	zbx_history_record_vector_create(&values);
+
+	while (zbx_time() < end)
+	{
+		zbx_uint64_t	itemid = (zbx_uint64_t)(rand_r(&seed) % items_num) + 1;
+
+		zbx_timespec(&ts);
+
+		if (SUCCEED != zbx_vc_get_values(itemid, ITEM_VALUE_TYPE_FLOAT, &values, 0, VC_BENCH_READ_COUNT, &ts))
+		{
+			printf("cannot get values of item " ZBX_FS_UI64 "\n", itemid);
+			exit(EXIT_FAILURE);
+		}
+
+		/* values read while being appended must still be consistent */
+		for (i = 1; i < values.values_num; i++)
+		{
+			if (0 <= zbx_timespec_compare(&values.values[i].timestamp, &values.values[i - 1].timestamp))
+			{
+				printf("inconsistent values of item " ZBX_FS_UI64 "\n", itemid);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		zbx_history_record_vector_clean(&values, ITEM_VALUE_TYPE_FLOAT);
+
+		if (0 == ++reads % VC_BENCH_FLUSH_PERIOD)
+			zbx_vc_flush_stats();
+	}
+
+	zbx_vc_flush_stats();
+	zbx_history_record_vector_destroy(&values, ITEM_VALUE_TYPE_FLOAT);
+
+	return reads;
+}
+
+static zbx_uint64_t	bench_appender(int items_num, int index, int appenders_num, double end)
+{
+	zbx_dc_history_t	history[VC_BENCH_BATCH_SIZE];
+	zbx_vector_ptr_t	batch;
+	zbx_uint64_t		appends = 0, itemid;
+	int			i, ret_flush;
+
+	zbx_vector_ptr_create(&batch);
+	memset(history, 0, sizeof(history));
+
+	/* each appender owns its items, similarly to history syncers */
+	itemid = (zbx_uint64_t)index + 1;
+
+	while (zbx_time() < end)
+	{
+		zbx_vector_ptr_clear(&batch);
+
+		for (i = 0; i < VC_BENCH_BATCH_SIZE; i++)
+		{
+			zbx_dc_history_t	*h = &history[i];
+
+			h->itemid = itemid;
+			h->value_type = ITEM_VALUE_TYPE_FLOAT;
+			h->value.dbl = (double)appends;
+			zbx_timespec(&h->ts);
+			zbx_vector_ptr_append(&batch, h);
+
+			if ((int)(itemid += (zbx_uint64_t)appenders_num) > items_num)
+				itemid = (zbx_uint64_t)index + 1;
+
+			appends++;
+		}
+
+		if (SUCCEED != zbx_vc_add_values(&batch, &ret_flush))
+		{
+			printf("cannot add values\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	zbx_vector_ptr_destroy(&batch);
+
+	return appends;
+}
+
+int	main(int argc, char **argv)
+{
+	int				readers_num = 4, appenders_num = 1, items_num = 1000, seconds = 5, i, status,
+					failed = 0;
+	char				*error = NULL;
+	zbx_uint64_t			*counters, reads = 0, appends = 0, itemid;
+	zbx_vector_history_record_t	values;
+	zbx_timespec_t			ts;
+	double				start, end;
+
+	if (1 < argc)
+		readers_num = atoi(argv[1]);
+	if (2 < argc)
+		appenders_num = atoi(argv[2]);
+	if (3 < argc)
+		items_num = atoi(argv[3]);
+	if (4 < argc)
+		seconds = atoi(argv[4]);
+
+	if (0 > readers_num || 0 > appenders_num || appenders_num > items_num || 0 >= seconds)
+	{
+		printf("usage: %s %s\n", progname, usage_message[0]);
+		return EXIT_FAILURE;
+	}
+
+	zbx_init_library_common(bench_log_impl);
+
+	if (SUCCEED != zbx_locks_create(&error) || SUCCEED != zbx_vc_init(VC_BENCH_CACHE_SIZE, &error))
+	{
+		printf("cannot initialize value cache: %s\n", error);
+		return EXIT_FAILURE;
+	}
+
+	zbx_vc_enable();
+
+	counters = (zbx_uint64_t *)mmap(NULL, sizeof(zbx_uint64_t) * (size_t)(readers_num + appenders_num),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (MAP_FAILED == counters)
+	{
+		printf("cannot allocate shared memory: %s\n", zbx_strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	/* add items to value cache */
+	zbx_history_record_vector_create(&values);
+	zbx_timespec(&ts);
+
+	for (itemid = 1; itemid <= (zbx_uint64_t)items_num; itemid++)
+	{
+		zbx_vc_get_values(itemid, ITEM_VALUE_TYPE_FLOAT, &values, 0, VC_BENCH_READ_COUNT, &ts);
+		zbx_history_record_vector_clean(&values, ITEM_VALUE_TYPE_FLOAT);
+	}
+
+	zbx_history_record_vector_destroy(&values, ITEM_VALUE_TYPE_FLOAT);
+	zbx_vc_flush_stats();
+
+	start = zbx_time();
+	end = start + seconds;
+
+	for (i = 0; i < readers_num + appenders_num; i++)
+	{
+		pid_t	pid;
+
+		if (-1 == (pid = fork()))
+		{
+			printf("cannot fork: %s\n", zbx_strerror(errno));
+			return EXIT_FAILURE;
+		}
+
+		if (0 == pid)
+		{
+			if (i < readers_num)
+				counters[i] = bench_reader(items_num, end, (unsigned int)i);
+			else
+				counters[i] = bench_appender(items_num, i - readers_num, appenders_num, end);
+
+			exit(EXIT_SUCCESS);
+		}
+	}
+
+	while (0 < wait(&status))
+	{
+		if (!WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status))
+			failed = 1;
+	}
+
+	end = zbx_time() - start;
+
+	for (i = 0; i < readers_num; i++)
+		reads += counters[i];
+
+	for (; i < readers_num + appenders_num; i++)
+		appends += counters[i];
+
+	printf("readers:%d appenders:%d items:%d seconds:%.3f\n", readers_num, appenders_num, items_num, end);
+	printf("reads:" ZBX_FS_UI64 " (%.0f/s) appends:" ZBX_FS_UI64 " (%.0f/s)\n", reads, (double)reads / end,
+			appends, (double)appends / end);
+
+	zbx_vc_destroy();
+
+	if (0 != failed)
+	{
+		printf("benchmark process failed\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
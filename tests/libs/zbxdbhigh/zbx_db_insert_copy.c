@@ -0,0 +1,279 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxdbhigh.h"
+#include "zbxdbschema.h"
+#include "zbxnum.h"
+#include "zbxstr.h"
+
+/* history tables written with COPY, defined here to not depend on generated database schema */
+static zbx_db_table_t	mock_tables[] = {
+	{"history", "", 0,
+		{
+			{"itemid", NULL, "items", "itemid", 0, ZBX_TYPE_ID, ZBX_NOTNULL, ZBX_FK_CASCADE_DELETE},
+			{"clock", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+			{"value", "0.0000", NULL, NULL, 0, ZBX_TYPE_FLOAT, ZBX_NOTNULL, 0},
+			{"ns", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+			{0}
+		},
+		NULL
+	},
+	{"history_str", "", 0,
+		{
+			{"itemid", NULL, "items", "itemid", 0, ZBX_TYPE_ID, ZBX_NOTNULL, ZBX_FK_CASCADE_DELETE},
+			{"clock", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+			{"value", "", NULL, NULL, 255, ZBX_TYPE_CHAR, ZBX_NOTNULL, 0},
+			{"ns", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0},
+			{0}
+		},
+		NULL
+	},
+	{0}
+};
+
+static zbx_vector_str_t	statements;
+static int		copy_rc;
+static int		txn_level;
+
+int	__wrap_zbx_db_vexecute(const char *fmt, va_list args)
+{
+	zbx_vector_str_append(&statements, zbx_dvsprintf(NULL, fmt, args));
+
+	return ZBX_DB_OK;
+}
+
+int	__wrap_zbx_db_txn_level(void)
+{
+	return txn_level;
+}
+
+int	__wrap_zbx_db_copy_from(const char *sql, const char *data, size_t data_len)
+{
+	ZBX_UNUSED(data);
+	ZBX_UNUSED(data_len);
+
+	zbx_vector_str_append(&statements, zbx_strdup(NULL, sql));
+
+	return copy_rc;
+}
+
+static const zbx_db_table_t	*mock_get_table(const char *name)
+{
+	zbx_db_table_t	*table;
+
+	for (table = mock_tables; NULL != table->table; table++)
+	{
+		if (0 == strcmp(table->table, name))
+			return table;
+	}
+
+	fail_msg("unknown table \"%s\"", name);
+
+	return NULL;
+}
+
+/* adds rows with values given as strings and converted according to field types */
+static void	mock_add_rows(zbx_db_insert_t *db_insert, int repeat)
+{
+	zbx_mock_handle_t	hrows, hrow, hvalue;
+	zbx_mock_error_t	err;
+	zbx_db_value_t		values[ZBX_MAX_FIELDS], *pvalues[ZBX_MAX_FIELDS];
+	int			i, j;
+
+	for (j = 0; j < repeat; j++)
+	{
+		hrows = zbx_mock_get_parameter_handle("in.rows");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrows, &hrow)))
+		{
+			if (ZBX_MOCK_SUCCESS != err)
+				fail_msg("cannot read row: %s", zbx_mock_error_string(err));
+
+			for (i = 0; i < db_insert->fields.values_num; i++)
+			{
+				const zbx_db_field_t	*field = (const zbx_db_field_t *)db_insert->fields.values[i];
+				const char		*value;
+
+				if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hrow, &hvalue)) ||
+						ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &value)))
+				{
+					fail_msg("cannot read field \"%s\" value: %s", field->name,
+							zbx_mock_error_string(err));
+				}
+
+				switch (field->type)
+				{
+					case ZBX_TYPE_ID:
+					case ZBX_TYPE_UINT:
+						if (SUCCEED != zbx_is_uint64(value, &values[i].ui64))
+							fail_msg("invalid field \"%s\" value \"%s\"", field->name, value);
+						break;
+					case ZBX_TYPE_INT:
+						values[i].i32 = atoi(value);
+						break;
+					case ZBX_TYPE_FLOAT:
+						values[i].dbl = atof(value);
+						break;
+					default:
+						values[i].str = (char *)value;
+				}
+
+				pvalues[i] = &values[i];
+			}
+
+			zbx_db_insert_add_values_dyn(db_insert, pvalues, db_insert->fields.values_num);
+		}
+	}
+}
+
+static void	mock_check_statements(void)
+{
+	zbx_mock_handle_t	hstatements, hstatement;
+	zbx_mock_error_t	err;
+	const char		*expected;
+	char			prefix[MAX_STRING_LEN];
+	int			i;
+
+	hstatements = zbx_mock_get_parameter_handle("out.statements");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hstatements, &hstatement)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hstatement, &expected)))
+			fail_msg("cannot read statement %d: %s", i, zbx_mock_error_string(err));
+
+		if (i == statements.values_num)
+			fail_msg("expected statement \"%s\" was not executed", expected);
+
+		/* bulk insert statements are long, so only their beginning is compared */
+		if (strlen(expected) < strlen(statements.values[i]))
+			statements.values[i][strlen(expected)] = '\0';
+
+		zbx_snprintf(prefix, sizeof(prefix), "statement %d", i);
+		zbx_mock_assert_str_eq(prefix, expected, statements.values[i]);
+	}
+
+	zbx_mock_assert_int_eq("executed statements", i, statements.values_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_db_insert_t		db_insert;
+	const zbx_db_table_t	*table;
+	const zbx_db_field_t	*fields[ZBX_MAX_FIELDS];
+	zbx_db_insert_stats_t	stats[ZBX_DB_INSERT_STATS_TABLES_NUM];
+	zbx_mock_handle_t	hfields, hfield;
+	zbx_mock_error_t	err;
+	const char		*name, *copy;
+	char			*data = NULL;
+	size_t			data_alloc = 0, data_offset = 0;
+	int			i, fields_num = 0, repeat = 1, index, ret;
+
+	ZBX_UNUSED(state);
+
+	table = mock_get_table(zbx_mock_get_parameter_string("in.table"));
+	hfields = zbx_mock_get_parameter_handle("in.fields");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hfields, &hfield)))
+	{
+		const zbx_db_field_t	*field;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hfield, &name)))
+			fail_msg("cannot read field name: %s", zbx_mock_error_string(err));
+
+		for (field = table->fields; NULL != field->name && 0 != strcmp(field->name, name); field++)
+			;
+
+		if (NULL == field->name)
+			fail_msg("unknown field \"%s\"", name);
+
+		fields[fields_num++] = field;
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.repeat"))
+		repeat = (int)zbx_mock_get_parameter_uint64("in.repeat");
+
+	zbx_vector_str_create(&statements);
+	zbx_db_insert_prepare_dyn(&db_insert, table, fields, fields_num);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists("in.copy"))
+	{
+		/* strings are stored unescaped for COPY */
+		db_insert.copy = 1;
+		mock_add_rows(&db_insert, repeat);
+
+		ret = zbx_db_insert_format_copy(&db_insert, &data, &data_alloc, &data_offset);
+		zbx_mock_assert_result_eq("zbx_db_insert_format_copy()", SUCCEED, ret);
+		zbx_mock_assert_str_eq("COPY data", zbx_mock_get_parameter_string("out.data"), data);
+
+		zbx_free(data);
+		goto out;
+	}
+#ifndef HAVE_POSTGRESQL
+	skip();
+#endif
+	copy = zbx_mock_get_parameter_string("in.copy");
+
+	if (0 == strcmp(copy, "ZBX_DB_OK"))
+		copy_rc = ZBX_DB_OK;
+	else if (0 == strcmp(copy, "ZBX_DB_FAIL"))
+		copy_rc = ZBX_DB_FAIL;
+	else if (0 == strcmp(copy, "ZBX_DB_DOWN"))
+		copy_rc = ZBX_DB_DOWN;
+	else
+		fail_msg("unknown COPY result \"%s\"", copy);
+
+	txn_level = (int)zbx_mock_get_parameter_uint64("in.txn_level");
+
+	/* reset statistics collected by previous test cases */
+	zbx_db_insert_stats_collect(stats);
+	memset(stats, 0, sizeof(stats));
+
+	mock_add_rows(&db_insert, repeat);
+
+	ret = zbx_db_insert_execute(&db_insert);
+	zbx_mock_assert_result_eq("zbx_db_insert_execute()", SUCCEED, ret);
+
+	mock_check_statements();
+
+	zbx_db_insert_stats_collect(stats);
+
+	for (index = 0; index < ZBX_DB_INSERT_STATS_TABLES_NUM; index++)
+	{
+		if (0 == strcmp(zbx_db_insert_stats_table(index), table->table))
+			break;
+	}
+
+	zbx_mock_assert_uint64_eq("inserted rows", zbx_mock_get_parameter_uint64("out.rows"), stats[index].rows);
+	zbx_mock_assert_uint64_eq("rows written with COPY", zbx_mock_get_parameter_uint64("out.copy_rows"),
+			stats[index].copy_rows);
+	zbx_mock_assert_uint64_eq("COPY fallbacks", zbx_mock_get_parameter_uint64("out.copy_fallbacks"),
+			stats[index].copy_fallbacks);
+out:
+	zbx_db_insert_clean(&db_insert);
+
+	for (i = 0; i < statements.values_num; i++)
+		zbx_free(statements.values[i]);
+
+	zbx_vector_str_destroy(&statements);
+}
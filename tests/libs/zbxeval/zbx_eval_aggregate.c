@@ -0,0 +1,244 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxeval.h"
+
+static const char	*isa_names[] = {"scalar", "sse2", "avx2"};
+
+/* NaN, infinity and signed zero are not accepted by numeric mock parameter parser */
+static double	mock_str_to_dbl(const char *str)
+{
+	char	*end;
+	double	value;
+
+	value = strtod(str, &end);
+
+	if ('\0' != *end || end == str)
+		fail_msg("invalid floating point value \"%s\"", str);
+
+	return value;
+}
+
+static void	mock_read_values(const char *path, zbx_vector_dbl_t *dbl, zbx_vector_uint64_t *ui64)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	const char		*str;
+
+	hvalues = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hvalues, &hvalue)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &str)))
+			fail_msg("cannot read value: %s", zbx_mock_error_string(err));
+
+		if (NULL != dbl)
+		{
+			zbx_vector_dbl_append(dbl, mock_str_to_dbl(str));
+		}
+		else
+		{
+			zbx_uint64_t	value;
+
+			if (SUCCEED != zbx_is_uint64(str, &value))
+				fail_msg("invalid unsigned integer value \"%s\"", str);
+
+			zbx_vector_uint64_append(ui64, value);
+		}
+	}
+}
+
+/* floating point results must be bit-identical, NaN results must be both NaN */
+static void	mock_assert_dbl_same(const char *kernel, int isa, int values_num, double expected, double returned)
+{
+	if (0 != isnan(expected) && 0 != isnan(returned))
+		return;
+
+	if (0 != memcmp(&expected, &returned, sizeof(double)))
+	{
+		fail_msg("%s kernel %s with %d values returned " ZBX_FS_DBL " instead of " ZBX_FS_DBL,
+				isa_names[isa], kernel, values_num, returned, expected);
+	}
+}
+
+/* minimum and maximum of positive and negative zeros are allowed to differ in sign */
+static void	mock_assert_dbl_eq(const char *kernel, int isa, int values_num, double expected, double returned)
+{
+	if (0 != isnan(expected) && 0 != isnan(returned))
+		return;
+
+	if (expected != returned)
+	{
+		fail_msg("%s kernel %s with %d values returned " ZBX_FS_DBL " instead of " ZBX_FS_DBL,
+				isa_names[isa], kernel, values_num, returned, expected);
+	}
+}
+
+static void	mock_assert_ui64_eq(const char *kernel, int isa, int values_num, zbx_uint64_t expected,
+		zbx_uint64_t returned)
+{
+	if (expected != returned)
+	{
+		fail_msg("%s kernel %s with %d values returned " ZBX_FS_UI64 " instead of " ZBX_FS_UI64,
+				isa_names[isa], kernel, values_num, returned, expected);
+	}
+}
+
+static void	test_aggregate_dbl(const double *values, int values_num, double pattern, double epsilon, double mean)
+{
+	double	sum, min, max, sumsq;
+	int	isa, op, count[OP_LE + 1];
+
+	zbx_eval_aggr_set_isa(ZBX_EVAL_AGGR_ISA_SCALAR);
+
+	sum = zbx_eval_aggr_sum_dbl(values, values_num);
+	min = zbx_eval_aggr_min_dbl(values, values_num);
+	max = zbx_eval_aggr_max_dbl(values, values_num);
+	sumsq = zbx_eval_aggr_sumsq_dbl(values, values_num, mean);
+
+	for (op = OP_EQ; op <= OP_LE; op++)
+		count[op] = zbx_eval_aggr_count_dbl(values, values_num, op, pattern, epsilon);
+
+	for (isa = ZBX_EVAL_AGGR_ISA_SSE2; isa <= ZBX_EVAL_AGGR_ISA_AVX2; isa++)
+	{
+		if (SUCCEED != zbx_eval_aggr_set_isa(isa))
+			continue;
+
+		mock_assert_dbl_same("sum", isa, values_num, sum, zbx_eval_aggr_sum_dbl(values, values_num));
+		mock_assert_dbl_eq("min", isa, values_num, min, zbx_eval_aggr_min_dbl(values, values_num));
+		mock_assert_dbl_eq("max", isa, values_num, max, zbx_eval_aggr_max_dbl(values, values_num));
+		mock_assert_dbl_same("sumsq", isa, values_num, sumsq,
+				zbx_eval_aggr_sumsq_dbl(values, values_num, mean));
+
+		for (op = OP_EQ; op <= OP_LE; op++)
+		{
+			mock_assert_ui64_eq("count", isa, values_num, (zbx_uint64_t)count[op],
+					(zbx_uint64_t)zbx_eval_aggr_count_dbl(values, values_num, op, pattern, epsilon));
+		}
+	}
+}
+
+static void	test_aggregate_ui64(const zbx_uint64_t *values, int values_num, zbx_uint64_t pattern, zbx_uint64_t mask)
+{
+	zbx_uint64_t	sum, min, max;
+	int		isa, op, count[OP_BITAND + 1];
+
+	zbx_eval_aggr_set_isa(ZBX_EVAL_AGGR_ISA_SCALAR);
+
+	sum = zbx_eval_aggr_sum_ui64(values, values_num);
+	min = zbx_eval_aggr_min_ui64(values, values_num);
+	max = zbx_eval_aggr_max_ui64(values, values_num);
+
+	for (op = OP_EQ; op <= OP_BITAND; op++)
+	{
+		if (OP_LE < op && OP_BITAND != op)
+			continue;
+
+		count[op] = zbx_eval_aggr_count_ui64(values, values_num, op, pattern, mask);
+	}
+
+	for (isa = ZBX_EVAL_AGGR_ISA_SSE2; isa <= ZBX_EVAL_AGGR_ISA_AVX2; isa++)
+	{
+		if (SUCCEED != zbx_eval_aggr_set_isa(isa))
+			continue;
+
+		mock_assert_ui64_eq("sum", isa, values_num, sum, zbx_eval_aggr_sum_ui64(values, values_num));
+		mock_assert_ui64_eq("min", isa, values_num, min, zbx_eval_aggr_min_ui64(values, values_num));
+		mock_assert_ui64_eq("max", isa, values_num, max, zbx_eval_aggr_max_ui64(values, values_num));
+
+		for (op = OP_EQ; op <= OP_BITAND; op++)
+		{
+			if (OP_LE < op && OP_BITAND != op)
+				continue;
+
+			mock_assert_ui64_eq("count", isa, values_num, (zbx_uint64_t)count[op],
+					(zbx_uint64_t)zbx_eval_aggr_count_ui64(values, values_num, op, pattern, mask));
+		}
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*type;
+	int		values_num;
+
+	ZBX_UNUSED(state);
+
+	type = zbx_mock_get_parameter_string("in.type");
+
+	if (0 == strcmp(type, "float"))
+	{
+		zbx_vector_dbl_t	values;
+		double			pattern, epsilon, mean;
+
+		zbx_vector_dbl_create(&values);
+		mock_read_values("in.values", &values, NULL);
+
+		pattern = mock_str_to_dbl(zbx_mock_get_parameter_string("in.pattern"));
+		epsilon = zbx_mock_get_parameter_float("in.epsilon");
+		mean = zbx_mock_get_parameter_float("in.mean");
+
+		/* check all value array lengths to cover vectorized loops with every tail length */
+		for (values_num = 1; values_num <= values.values_num; values_num++)
+			test_aggregate_dbl(values.values, values_num, pattern, epsilon, mean);
+
+		zbx_eval_aggr_set_isa(ZBX_EVAL_AGGR_ISA_SCALAR);
+
+		mock_assert_dbl_eq("min", ZBX_EVAL_AGGR_ISA_SCALAR, values.values_num,
+				mock_str_to_dbl(zbx_mock_get_parameter_string("out.min")),
+				zbx_eval_aggr_min_dbl(values.values, values.values_num));
+		mock_assert_dbl_eq("max", ZBX_EVAL_AGGR_ISA_SCALAR, values.values_num,
+				mock_str_to_dbl(zbx_mock_get_parameter_string("out.max")),
+				zbx_eval_aggr_max_dbl(values.values, values.values_num));
+
+		zbx_vector_dbl_destroy(&values);
+	}
+	else if (0 == strcmp(type, "uint64"))
+	{
+		zbx_vector_uint64_t	values;
+		zbx_uint64_t		pattern, mask;
+
+		zbx_vector_uint64_create(&values);
+		mock_read_values("in.values", NULL, &values);
+
+		pattern = zbx_mock_get_parameter_uint64("in.pattern");
+		mask = zbx_mock_get_parameter_uint64("in.mask");
+
+		for (values_num = 1; values_num <= values.values_num; values_num++)
+			test_aggregate_ui64(values.values, values_num, pattern, mask);
+
+		zbx_eval_aggr_set_isa(ZBX_EVAL_AGGR_ISA_SCALAR);
+
+		mock_assert_ui64_eq("min", ZBX_EVAL_AGGR_ISA_SCALAR, values.values_num,
+				zbx_mock_get_parameter_uint64("out.min"),
+				zbx_eval_aggr_min_ui64(values.values, values.values_num));
+		mock_assert_ui64_eq("max", ZBX_EVAL_AGGR_ISA_SCALAR, values.values_num,
+				zbx_mock_get_parameter_uint64("out.max"),
+				zbx_eval_aggr_max_ui64(values.values, values.values_num));
+
+		zbx_vector_uint64_destroy(&values);
+	}
+	else
+		fail_msg("unknown value type \"%s\"", type);
+}
@@ -0,0 +1,155 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Aggregation kernel benchmark.
+ *
+ * Runs scalar, SSE2 and AVX2 (when supported by CPU) aggregation kernels over 1k, 100k and 1M
+ * value windows, reports throughput in millions of values per second and checks that vectorized
+ * kernels return the same results as scalar ones.
+ *
+ * Usage: zbx_eval_aggregate_bench [values per window size]
+ */
+
+#include "zbxeval.h"
+#include "zbxtime.h"
+
+#define AGGR_BENCH_VALUES	200000000
+
+const char	title_message[] = "zbx_eval_aggregate_bench";
+const char	*usage_message[] = {"[values per window size]", NULL};
+const char	*help_message[] = {"Aggregation kernel benchmark.", NULL};
+const char	*progname = "zbx_eval_aggregate_bench";
+const char	syslog_app_name[] = "zbx_eval_aggregate_bench";
+
+typedef enum
+{
+	AGGR_BENCH_SUM_DBL = 0,
+	AGGR_BENCH_MIN_DBL,
+	AGGR_BENCH_MAX_DBL,
+	AGGR_BENCH_SUMSQ_DBL,
+	AGGR_BENCH_COUNT_DBL,
+	AGGR_BENCH_SUM_UI64,
+	AGGR_BENCH_MIN_UI64,
+	AGGR_BENCH_MAX_UI64,
+	AGGR_BENCH_COUNT_UI64,
+	AGGR_BENCH_KERNELS_NUM
+}
+zbx_aggr_bench_kernel_t;
+
+static const char	*kernel_names[AGGR_BENCH_KERNELS_NUM] = {"sum(dbl)", "min(dbl)", "max(dbl)", "sumsq(dbl)",
+		"count(dbl,gt)", "sum(ui64)", "min(ui64)", "max(ui64)", "count(ui64,bitand)"};
+
+static const char	*isa_names[] = {"scalar", "sse2", "avx2"};
+
+static double	run_kernel(int kernel, const double *dbl, const zbx_uint64_t *ui64, int values_num)
+{
+	switch (kernel)
+	{
+		case AGGR_BENCH_SUM_DBL:
+			return zbx_eval_aggr_sum_dbl(dbl, values_num);
+		case AGGR_BENCH_MIN_DBL:
+			return zbx_eval_aggr_min_dbl(dbl, values_num);
+		case AGGR_BENCH_MAX_DBL:
+			return zbx_eval_aggr_max_dbl(dbl, values_num);
+		case AGGR_BENCH_SUMSQ_DBL:
+			return zbx_eval_aggr_sumsq_dbl(dbl, values_num, 500.0);
+		case AGGR_BENCH_COUNT_DBL:
+			return zbx_eval_aggr_count_dbl(dbl, values_num, OP_GT, 500.0, 0.000001);
+		case AGGR_BENCH_SUM_UI64:
+			return (double)zbx_eval_aggr_sum_ui64(ui64, values_num);
+		case AGGR_BENCH_MIN_UI64:
+			return (double)zbx_eval_aggr_min_ui64(ui64, values_num);
+		case AGGR_BENCH_MAX_UI64:
+			return (double)zbx_eval_aggr_max_ui64(ui64, values_num);
+		case AGGR_BENCH_COUNT_UI64:
+			return zbx_eval_aggr_count_ui64(ui64, values_num, OP_BITAND, 4, 12);
+	}
+
+	return 0;
+}
+
+int	main(int argc, char **argv)
+{
+	static const int	windows[] = {1000, 100000, 1000000};
+	double			*dbl, expected[AGGR_BENCH_KERNELS_NUM];
+	zbx_uint64_t		*ui64;
+	int			i, j, kernel, isa, total = AGGR_BENCH_VALUES, ret = EXIT_SUCCESS;
+
+	if (1 < argc)
+		total = atoi(argv[1]);
+
+	dbl = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)windows[ARRSIZE(windows) - 1]);
+	ui64 = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)windows[ARRSIZE(windows) - 1]);
+
+	srand(0);
+
+	for (i = 0; i < windows[ARRSIZE(windows) - 1]; i++)
+	{
+		/* keep values exactly representable, so that summation order does not change results */
+		ui64[i] = (zbx_uint64_t)(rand() % 1000);
+		dbl[i] = (double)ui64[i] + 0.5;
+	}
+
+	printf("%-20s %-8s %10s %10s %10s\n", "kernel", "isa", "1k", "100k", "1M");
+
+	for (kernel = 0; kernel < AGGR_BENCH_KERNELS_NUM; kernel++)
+	{
+		for (isa = ZBX_EVAL_AGGR_ISA_SCALAR; isa <= ZBX_EVAL_AGGR_ISA_AVX2; isa++)
+		{
+			if (SUCCEED != zbx_eval_aggr_set_isa(isa))
+				continue;
+
+			printf("%-20s %-8s", kernel_names[kernel], isa_names[isa]);
+
+			for (i = 0; i < (int)ARRSIZE(windows); i++)
+			{
+				int	loops = MAX(1, total / windows[i]);
+				double	start, result;
+
+				start = zbx_time();
+
+				for (j = 0; j < loops; j++)
+					run_kernel(kernel, dbl, ui64, windows[i]);
+
+				printf(" %10.1f", (double)loops * windows[i] / (zbx_time() - start) / 1e6);
+
+				result = run_kernel(kernel, dbl, ui64, windows[i]);
+
+				if (ZBX_EVAL_AGGR_ISA_SCALAR == isa)
+				{
+					if (i == (int)ARRSIZE(windows) - 1)
+						expected[kernel] = result;
+				}
+				else if (i == (int)ARRSIZE(windows) - 1 && result != expected[kernel])
+				{
+					printf(" MISMATCH: " ZBX_FS_DBL " != " ZBX_FS_DBL, result, expected[kernel]);
+					ret = EXIT_FAILURE;
+				}
+			}
+
+			printf("\n");
+		}
+	}
+
+	zbx_free(ui64);
+	zbx_free(dbl);
+
+	return ret;
+}
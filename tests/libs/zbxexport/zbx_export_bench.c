@@ -0,0 +1,205 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Real-time history export benchmark.
+ *
+ * Formats history values the way history syncer exports them (host, host groups, item tags,
+ * item name and value) and writes them to an export file in batches, flushing after each batch.
+ * Runs without and with host groups and item tags, writing export files either directly or from
+ * export writer thread. Reports exported bytes per value, the time history syncer spends per value
+ * and the total time per value including writing of the queued data. Export files are removed
+ * after each run.
+ *
+ * Usage: zbx_export_bench [directory] [values]
+ */
+
+#include "zbxexport.h"
+#include "zbxjson.h"
+#include "zbxtime.h"
+#include "zbxstr.h"
+
+#define EXPORT_BENCH_VALUES	1000000
+#define EXPORT_BENCH_BATCH	1000
+#define EXPORT_BENCH_ITEMS	10000
+#define EXPORT_BENCH_TAGS	5
+#define EXPORT_BENCH_GROUPS	3
+
+const char	title_message[] = "zbx_export_bench";
+const char	*usage_message[] = {"[directory] [values]", NULL};
+const char	*help_message[] = {"Real-time history export benchmark.", NULL};
+const char	*progname = "zbx_export_bench";
+const char	syslog_app_name[] = "zbx_export_bench";
+
+static zbx_export_file_t	*history_export;
+
+static zbx_export_file_t	*get_history_export(void)
+{
+	return history_export;
+}
+
+static void	bench_log_impl(int level, const char *fmt, va_list args)
+{
+	if (LOG_LEVEL_WARNING < level)
+		return;
+
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+}
+
+static void	bench_export_value(struct zbx_json *json, int i, int tagged)
+{
+	char	buf[64];
+	int	j, itemid = i % EXPORT_BENCH_ITEMS;
+
+	zbx_json_clean(json);
+
+	zbx_json_addobject(json, ZBX_PROTO_TAG_HOST);
+	zbx_snprintf(buf, sizeof(buf), "Host %d", itemid / 100);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_HOST, buf, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_NAME, buf, ZBX_JSON_TYPE_STRING);
+	zbx_json_close(json);
+
+	zbx_json_addarray(json, ZBX_PROTO_TAG_GROUPS);
+
+	for (j = 0; 0 != tagged && j < EXPORT_BENCH_GROUPS; j++)
+	{
+		zbx_snprintf(buf, sizeof(buf), "Host group %d", j);
+		zbx_json_addstring(json, NULL, buf, ZBX_JSON_TYPE_STRING);
+	}
+
+	zbx_json_close(json);
+
+	zbx_json_addarray(json, ZBX_PROTO_TAG_ITEM_TAGS);
+
+	for (j = 0; 0 != tagged && j < EXPORT_BENCH_TAGS; j++)
+	{
+		zbx_json_addobject(json, NULL);
+		zbx_snprintf(buf, sizeof(buf), "component%d", j);
+		zbx_json_addstring(json, ZBX_PROTO_TAG_TAG, buf, ZBX_JSON_TYPE_STRING);
+		zbx_snprintf(buf, sizeof(buf), "value%d", itemid % 10);
+		zbx_json_addstring(json, ZBX_PROTO_TAG_VALUE, buf, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_ITEMID, (zbx_uint64_t)(100000 + itemid));
+	zbx_snprintf(buf, sizeof(buf), "CPU utilization of core %d", itemid);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_NAME, buf, ZBX_JSON_TYPE_STRING);
+	zbx_json_addint64(json, ZBX_PROTO_TAG_CLOCK, 1700000000 + i / EXPORT_BENCH_ITEMS);
+	zbx_json_addint64(json, ZBX_PROTO_TAG_NS, i);
+	zbx_json_addfloat(json, ZBX_PROTO_TAG_VALUE, (double)i / 7);
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_TYPE, ITEM_VALUE_TYPE_FLOAT);
+}
+
+static void	bench_export(const char *dir, int values_num, int tagged, int async, int process_num,
+		zbx_uint64_t *size, double *sync_time, double *total_time)
+{
+	struct zbx_json	json;
+	char		*error = NULL, filename[MAX_STRING_LEN];
+	double		start, syncer = 0;
+	int		i;
+
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+
+	history_export = zbx_history_export_init(get_history_export, "export-bench", process_num);
+
+	if (0 != async && SUCCEED != zbx_export_writer_start(&error))
+	{
+		printf("cannot start export writer: %s\n", error);
+		zbx_free(error);
+	}
+
+	*size = 0;
+	start = zbx_time();
+
+	for (i = 0; i < values_num; i += EXPORT_BENCH_BATCH)
+	{
+		double	batch_start = zbx_time();
+		int	j;
+
+		for (j = i; j < i + EXPORT_BENCH_BATCH && j < values_num; j++)
+		{
+			bench_export_value(&json, j, tagged);
+			zbx_history_export_write(json.buffer, json.buffer_size);
+			*size += json.buffer_size + 1;
+		}
+
+		zbx_history_export_flush();
+		syncer += zbx_time() - batch_start;
+	}
+
+	zbx_export_writer_stop();
+	zbx_export_deinit(history_export);
+
+	*sync_time = syncer;
+	*total_time = zbx_time() - start;
+
+	zbx_snprintf(filename, sizeof(filename), "%s/history-export-bench-%d.ndjson", dir, process_num);
+
+	if (0 != remove(filename))
+		printf("cannot remove export file '%s': %s\n", filename, zbx_strerror(errno));
+
+	zbx_json_free(&json);
+}
+
+int	main(int argc, char **argv)
+{
+	static zbx_config_export_t	config_export = {NULL, NULL, ZBX_GIBIBYTE, 1, 0, 0, 1};
+	static const char		*modes[] = {"direct", "writer"};
+	char				*error = NULL;
+	int				values_num = EXPORT_BENCH_VALUES, tagged, async, process_num = 0;
+
+	zbx_init_library_common(bench_log_impl);
+
+	config_export.dir = zbx_strdup(NULL, 1 < argc ? argv[1] : "/tmp");
+
+	if (2 < argc)
+		values_num = atoi(argv[2]);
+
+	if (SUCCEED != zbx_init_library_export(&config_export, &error))
+	{
+		printf("cannot initialize export: %s\n", error);
+		zbx_free(error);
+		return EXIT_FAILURE;
+	}
+
+	printf("%-6s %-6s %12s %12s %12s\n", "tags", "mode", "bytes/value", "syncer ns", "total ns");
+
+	for (tagged = 0; tagged < 2; tagged++)
+	{
+		for (async = 0; async < 2; async++)
+		{
+			zbx_uint64_t	size;
+			double		sync_time, total_time;
+
+			bench_export(config_export.dir, values_num, tagged, async, ++process_num, &size, &sync_time,
+					&total_time);
+
+			printf("%-6s %-6s %12.1f %12.1f %12.1f\n", 0 != tagged ? "yes" : "no", modes[async],
+					(double)size / values_num, sync_time * 1e9 / values_num,
+					total_time * 1e9 / values_num);
+		}
+	}
+
+	zbx_deinit_library_export();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxexport.h"
+#include "zbxstr.h"
+#include "zbxalgo.h"
+
+#ifdef HAVE_ZLIB
+#include "zlib.h"
+#endif
+
+#define EXPORT_RECORD_SIZE	99
+
+static zbx_export_file_t	*history_export;
+
+static zbx_export_file_t	*get_history_export(void)
+{
+	return history_export;
+}
+
+static char	*mock_read_file(const char *name, size_t *size)
+{
+	FILE	*fp;
+	char	*data = NULL;
+	size_t	data_alloc = 0, n;
+	char	buf[4096];
+
+	*size = 0;
+
+	if (NULL == (fp = fopen(name, "r")))
+		fail_msg("cannot open export file \"%s\": %s", name, zbx_strerror(errno));
+
+	while (0 != (n = fread(buf, 1, sizeof(buf), fp)))
+		zbx_str_memcpy_alloc(&data, &data_alloc, size, buf, n);
+
+	fclose(fp);
+
+	return data;
+}
+
+/* export file may contain several concatenated gzip members */
+static char	*mock_decompress(const char *name, const char *in, size_t in_size, size_t *size)
+{
+#ifdef HAVE_ZLIB
+	z_stream	zs;
+	char		*data = NULL, buf[4096];
+	size_t		data_alloc = 0;
+	int		ret, members = 0;
+
+	memset(&zs, 0, sizeof(zs));
+	*size = 0;
+
+	if (Z_OK != inflateInit2(&zs, MAX_WBITS + 16))
+		fail_msg("cannot initialize decompression");
+
+	zs.next_in = (Bytef *)in;
+	zs.avail_in = (uInt)in_size;
+
+	while (0 != zs.avail_in)
+	{
+		zs.next_out = (Bytef *)buf;
+		zs.avail_out = sizeof(buf);
+
+		ret = inflate(&zs, Z_NO_FLUSH);
+
+		if (Z_OK != ret && Z_STREAM_END != ret)
+			fail_msg("cannot decompress export file \"%s\": error %d", name, ret);
+
+		zbx_str_memcpy_alloc(&data, &data_alloc, size, buf, sizeof(buf) - zs.avail_out);
+
+		if (Z_STREAM_END == ret)
+		{
+			members++;
+			inflateReset(&zs);
+		}
+		else if (0 == zs.avail_in)
+			fail_msg("export file \"%s\" ends with incomplete gzip member", name);
+	}
+
+	inflateEnd(&zs);
+
+	if (0 == members)
+		fail_msg("export file \"%s\" has no gzip members", name);
+
+	return data;
+#else
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(in_size);
+	ZBX_UNUSED(size);
+
+	fail_msg("cannot decompress export file \"%s\": zlib support is not compiled in", name);
+
+	return NULL;
+#endif
+}
+
+static void	mock_format_record(char *buf, size_t size, int num)
+{
+	size_t	offset;
+
+	offset = zbx_snprintf(buf, size, "{\"n\":%d,\"pad\":\"", num);
+	memset(buf + offset, 'x', EXPORT_RECORD_SIZE - 2 - offset);
+	memcpy(buf + EXPORT_RECORD_SIZE - 2, "\"}", 3);
+}
+
+/* checks that export file contains the expected consecutive records */
+static void	mock_check_file(const char *name, int compress, int first, int records)
+{
+	char	*raw, *data, *ptr, record[EXPORT_RECORD_SIZE + 1], prefix[MAX_STRING_LEN];
+	size_t	raw_size, size;
+	int	i;
+
+	raw = mock_read_file(name, &raw_size);
+
+	if (0 != compress)
+	{
+		data = mock_decompress(name, raw, raw_size, &size);
+		zbx_free(raw);
+	}
+	else
+	{
+		data = raw;
+		size = raw_size;
+	}
+
+	zbx_snprintf(prefix, sizeof(prefix), "size of \"%s\"", name);
+	zbx_mock_assert_uint64_eq(prefix, (zbx_uint64_t)records * (EXPORT_RECORD_SIZE + 1), size);
+
+	for (i = 0, ptr = data; i < records; i++, ptr += EXPORT_RECORD_SIZE + 1)
+	{
+		mock_format_record(record, sizeof(record), first + i);
+
+		if (0 != strncmp(ptr, record, EXPORT_RECORD_SIZE) || '\n' != ptr[EXPORT_RECORD_SIZE])
+			fail_msg("export file \"%s\" record %d does not match \"%s\"", name, i, record);
+	}
+
+	zbx_free(data);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_config_export_t	config_export;
+	zbx_mock_handle_t	hfiles, hfile;
+	zbx_mock_error_t	err;
+	char			dir[] = "/tmp/zbx_export_XXXXXX", *error = NULL, record[EXPORT_RECORD_SIZE + 1],
+				name[MAX_STRING_LEN];
+	const char		*ext;
+	int			i, records;
+	zbx_vector_str_t	names;
+
+	ZBX_UNUSED(state);
+
+#ifndef HAVE_ZLIB
+	if (0 != zbx_mock_get_parameter_uint64("in.compress"))
+		skip();
+#endif
+	if (NULL == mkdtemp(dir))
+		fail_msg("cannot create export directory: %s", zbx_strerror(errno));
+
+	memset(&config_export, 0, sizeof(config_export));
+	config_export.dir = zbx_strdup(NULL, dir);
+	config_export.file_size = zbx_mock_get_parameter_uint64("in.file_size");
+	config_export.file_count = (int)zbx_mock_get_parameter_uint64("in.file_count");
+	config_export.compress = (int)zbx_mock_get_parameter_uint64("in.compress");
+
+	if (SUCCEED != zbx_init_library_export(&config_export, &error))
+		fail_msg("cannot initialize export: %s", error);
+
+	history_export = zbx_history_export_init(get_history_export, "test", 1);
+
+	/* each record is flushed separately so that files are rotated between records */
+	records = (int)zbx_mock_get_parameter_uint64("in.records");
+
+	for (i = 1; i <= records; i++)
+	{
+		mock_format_record(record, sizeof(record), i);
+		zbx_history_export_write(record, EXPORT_RECORD_SIZE);
+		zbx_history_export_flush();
+	}
+
+	zbx_export_deinit(history_export);
+
+	ext = (0 != config_export.compress ? ".gz" : "");
+	zbx_vector_str_create(&names);
+	hfiles = zbx_mock_get_parameter_handle("out.files");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hfiles, &hfile)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read export file: %s", zbx_mock_error_string(err));
+
+		zbx_snprintf(name, sizeof(name), "%s/history-test-1.ndjson%s%s", dir,
+				zbx_mock_get_object_member_string(hfile, "suffix"), ext);
+
+		mock_check_file(name, config_export.compress,
+				(int)zbx_mock_get_object_member_uint64(hfile, "first"),
+				(int)zbx_mock_get_object_member_uint64(hfile, "records"));
+
+		zbx_vector_str_append(&names, zbx_strdup(NULL, name));
+	}
+
+	/* rotated files beyond ExportFileCount must be removed */
+	hfiles = zbx_mock_get_parameter_handle("out.missing");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hfiles, &hfile)))
+	{
+		const char	*suffix;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hfile, &suffix)))
+			fail_msg("cannot read missing export file: %s", zbx_mock_error_string(err));
+
+		zbx_snprintf(name, sizeof(name), "%s/history-test-1.ndjson%s%s", dir, suffix, ext);
+
+		if (0 == access(name, F_OK))
+			fail_msg("export file \"%s\" was not expected", name);
+	}
+
+	for (i = 0; i < names.values_num; i++)
+		remove(names.values[i]);
+
+	zbx_vector_str_clear_ext(&names, zbx_str_free);
+	zbx_vector_str_destroy(&names);
+
+	if (0 != rmdir(dir))
+		fail_msg("unexpected files left in export directory \"%s\": %s", dir, zbx_strerror(errno));
+
+	zbx_deinit_library_export();
+}
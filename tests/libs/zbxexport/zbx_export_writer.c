@@ -0,0 +1,258 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+
+static pthread_mutex_t	gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	gate_event = PTHREAD_COND_INITIALIZER;
+static int		gate_closed, process_writes;
+
+static ssize_t	mock_export_write(int fd, const void *buf, size_t count);
+
+/* export file writes are intercepted to hold the writer and to check which thread writes */
+#define write	mock_export_write
+#include "../../../src/libs/zbxexport/export.c"
+#undef write
+
+#define EXPORT_RECORD_SIZE_MIN	32
+
+static ssize_t	mock_export_write(int fd, const void *buf, size_t count)
+{
+	pthread_mutex_lock(&gate_lock);
+
+	if (0 == writer.started || 0 == pthread_equal(pthread_self(), writer.thread))
+		process_writes++;
+
+	while (0 != gate_closed)
+		pthread_cond_wait(&gate_event, &gate_lock);
+
+	pthread_mutex_unlock(&gate_lock);
+
+	return write(fd, buf, count);
+}
+
+typedef struct
+{
+	zbx_export_file_t	*files[2];
+	int			files_num;
+	int			records;
+	int			record_size;
+	size_t			queued_max;
+	int			done;
+}
+mock_producer_t;
+
+static mock_producer_t	producer;
+
+static zbx_export_file_t	*get_history_export(void)
+{
+	return producer.files[0];
+}
+
+static zbx_export_file_t	*get_trends_export(void)
+{
+	return producer.files[1];
+}
+
+static void	mock_format_record(char *buf, int size, int file, int num)
+{
+	int	offset;
+
+	offset = (int)zbx_snprintf(buf, (size_t)size, "{\"file\":%d,\"n\":%d,\"pad\":\"", file, num);
+	memset(buf + offset, 'x', (size_t)(size - 2 - offset));
+	memcpy(buf + size - 2, "\"}", 3);
+}
+
+static size_t	mock_writer_queued(void)
+{
+	size_t	queued;
+
+	pthread_mutex_lock(&writer.lock);
+	queued = writer.queued;
+	pthread_mutex_unlock(&writer.lock);
+
+	return queued;
+}
+
+/* emulates history syncer exporting values without explicit flushing */
+static void	*mock_producer_entry(void *args)
+{
+	char	*record;
+	int	i, j;
+	size_t	queued;
+
+	ZBX_UNUSED(args);
+
+	record = (char *)zbx_malloc(NULL, (size_t)producer.record_size + 1);
+
+	for (i = 1; i <= producer.records; i++)
+	{
+		for (j = 0; j < producer.files_num; j++)
+		{
+			mock_format_record(record, producer.record_size, j, i);
+
+			if (0 == j)
+				zbx_history_export_write(record, (size_t)producer.record_size);
+			else
+				zbx_trends_export_write(record, (size_t)producer.record_size);
+		}
+
+		if (producer.queued_max < (queued = mock_writer_queued()))
+			producer.queued_max = queued;
+	}
+
+	zbx_free(record);
+
+	pthread_mutex_lock(&gate_lock);
+	producer.done = 1;
+	pthread_mutex_unlock(&gate_lock);
+
+	return NULL;
+}
+
+static void	mock_check_file(const char *name, int index)
+{
+	FILE	*fp;
+	char	*record, *line, prefix[MAX_STRING_LEN];
+	int	i;
+
+	if (NULL == (fp = fopen(name, "r")))
+		fail_msg("cannot open export file \"%s\": %s", name, zbx_strerror(errno));
+
+	record = (char *)zbx_malloc(NULL, (size_t)producer.record_size + 2);
+	line = (char *)zbx_malloc(NULL, (size_t)producer.record_size + 2);
+
+	for (i = 1; i <= producer.records; i++)
+	{
+		if (NULL == fgets(line, producer.record_size + 2, fp))
+			fail_msg("export file \"%s\" ends before record %d", name, i);
+
+		mock_format_record(record, producer.record_size, index, i);
+		zbx_strlcat(record, "\n", (size_t)producer.record_size + 2);
+
+		zbx_snprintf(prefix, sizeof(prefix), "export file \"%s\" record %d", name, i);
+		zbx_mock_assert_str_eq(prefix, record, line);
+	}
+
+	if (EOF != fgetc(fp))
+		fail_msg("export file \"%s\" has data after the last record", name);
+
+	fclose(fp);
+	zbx_free(line);
+	zbx_free(record);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_config_export_t	config;
+	char			dir[] = "/tmp/zbx_export_XXXXXX", *error = NULL, *names[2];
+	int			i, block_writer, done;
+	pthread_t		thread;
+
+	ZBX_UNUSED(state);
+
+	if (NULL == mkdtemp(dir))
+		fail_msg("cannot create export directory: %s", zbx_strerror(errno));
+
+	memset(&config, 0, sizeof(config));
+	config.dir = zbx_strdup(NULL, dir);
+	config.file_size = ZBX_GIBIBYTE;
+	config.file_count = 1;
+	config.async = 1;
+
+	if (SUCCEED != zbx_init_library_export(&config, &error))
+		fail_msg("cannot initialize export: %s", error);
+
+	memset(&producer, 0, sizeof(producer));
+	producer.files_num = (int)zbx_mock_get_parameter_uint64("in.files");
+	producer.records = (int)zbx_mock_get_parameter_uint64("in.records");
+	producer.record_size = (int)zbx_mock_get_parameter_uint64("in.record_size");
+	block_writer = (int)zbx_mock_get_parameter_uint64("in.block_writer");
+
+	if (EXPORT_RECORD_SIZE_MIN > producer.record_size)
+		fail_msg("record size must be at least %d bytes", EXPORT_RECORD_SIZE_MIN);
+
+	producer.files[0] = zbx_history_export_init(get_history_export, "test", 1);
+
+	if (1 < producer.files_num)
+		producer.files[1] = zbx_trends_export_init(get_trends_export, "test", 1);
+
+	if (SUCCEED != zbx_export_writer_start(&error))
+		fail_msg("cannot start export writer: %s", error);
+
+	gate_closed = block_writer;
+	process_writes = 0;
+
+	if (0 != pthread_create(&thread, NULL, mock_producer_entry, NULL))
+		fail_msg("cannot create producer thread");
+
+	if (0 != block_writer)
+	{
+		/* writer is held in its first write, so the queue can only grow until the process waits */
+		for (i = 0; ZBX_EXPORT_QUEUE_MAX > mock_writer_queued(); i++)
+		{
+			if (10000 == i)
+				fail_msg("export queue did not reach its limit");
+
+			usleep(1000);
+		}
+
+		usleep(100000);
+
+		pthread_mutex_lock(&gate_lock);
+		done = producer.done;
+		gate_closed = 0;
+		pthread_cond_broadcast(&gate_event);
+		pthread_mutex_unlock(&gate_lock);
+
+		if (0 != done)
+			fail_msg("process did not wait for export writer");
+	}
+
+	pthread_join(thread, NULL);
+
+	if (ZBX_EXPORT_QUEUE_MAX + ZBX_EXPORT_BUFFER_SIZE + (size_t)producer.record_size < producer.queued_max)
+		fail_msg("export queue size " ZBX_FS_SIZE_T " exceeds its limit", (zbx_fs_size_t)producer.queued_max);
+
+	/* buffered data of all files must be written by writer before it stops */
+	for (i = 0; i < producer.files_num; i++)
+	{
+		names[i] = zbx_strdup(NULL, producer.files[i]->name);
+		zbx_export_deinit(producer.files[i]);
+	}
+
+	zbx_mock_assert_int_eq("writes by process", 0, process_writes);
+
+	for (i = 0; i < producer.files_num; i++)
+	{
+		mock_check_file(names[i], i);
+		remove(names[i]);
+		zbx_free(names[i]);
+	}
+
+	if (0 != rmdir(dir))
+		fail_msg("unexpected files left in export directory \"%s\": %s", dir, zbx_strerror(errno));
+
+	zbx_deinit_library_export();
+}
@@ -0,0 +1,331 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxipcservice/ipcservice.c"
+
+#define MOCK_SERVICE		"ipc_batch"
+
+/* time in seconds to wait for all messages */
+#define MOCK_RECV_TIMEOUT	30
+
+typedef struct
+{
+	zbx_vector_ipcmsg_t	messages;
+	zbx_ipc_socket_t	csocket;
+	int			ret;
+	char			*error;
+}
+mock_client_t;
+
+static void	mock_fill_data(unsigned char *data, zbx_uint32_t code, zbx_uint32_t size)
+{
+	zbx_uint32_t	i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (unsigned char)(code + i);
+}
+
+static void	mock_read_messages(zbx_vector_ipcmsg_t *messages)
+{
+	zbx_mock_handle_t	hsizes, hsize;
+	zbx_mock_error_t	err;
+
+	hsizes = zbx_mock_get_parameter_handle("in.sizes");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsizes, &hsize)))
+	{
+		zbx_uint64_t		size;
+		zbx_ipc_message_t	*message;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hsize, &size)))
+			fail_msg("cannot read message size: %s", zbx_mock_error_string(err));
+
+		message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
+		message->code = (zbx_uint32_t)messages->values_num + 1;
+		message->size = (zbx_uint32_t)size;
+		message->data = (unsigned char *)zbx_malloc(NULL, message->size + 1);
+		mock_fill_data(message->data, message->code, message->size);
+
+		zbx_vector_ipcmsg_append(messages, message);
+	}
+}
+
+/* checks that received message is the next sent message */
+static void	mock_check_message(const zbx_vector_ipcmsg_t *messages, int index, zbx_uint32_t code, zbx_uint32_t size,
+		const unsigned char *data)
+{
+	const zbx_ipc_message_t	*message;
+	char			prefix[MAX_STRING_LEN];
+
+	if (index >= messages->values_num)
+		fail_msg("received more than %d messages", messages->values_num);
+
+	message = messages->values[index];
+
+	zbx_snprintf(prefix, sizeof(prefix), "message %d code", index);
+	zbx_mock_assert_uint64_eq(prefix, message->code, code);
+
+	zbx_snprintf(prefix, sizeof(prefix), "message %d size", index);
+	zbx_mock_assert_uint64_eq(prefix, message->size, size);
+
+	if (0 != size && 0 != memcmp(message->data, data, size))
+		fail_msg("message %d data does not match", index);
+}
+
+static void	*mock_write_entry(void *args)
+{
+	mock_client_t	*client = (mock_client_t *)args;
+
+	client->ret = zbx_ipc_socket_write_batch(&client->csocket, &client->messages);
+	zbx_ipc_socket_close(&client->csocket);
+
+	return NULL;
+}
+
+static void	*mock_client_entry(void *args)
+{
+	mock_client_t	*client = (mock_client_t *)args;
+
+	if (SUCCEED != zbx_ipc_socket_open(&client->csocket, MOCK_SERVICE, SEC_PER_MIN, &client->error))
+		return NULL;
+
+	return mock_write_entry(args);
+}
+
+static size_t	mock_read_all(int fd, unsigned char **data)
+{
+	size_t	data_alloc = 0, data_offset = 0;
+	ssize_t	n;
+
+	*data = NULL;
+
+	do
+	{
+		if (data_alloc - data_offset < ZBX_MEBIBYTE)
+		{
+			data_alloc += ZBX_MEBIBYTE;
+			*data = (unsigned char *)zbx_realloc(*data, data_alloc);
+		}
+
+		if (-1 == (n = read(fd, *data + data_offset, data_alloc - data_offset)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			fail_msg("cannot read socket: %s", zbx_strerror(errno));
+		}
+
+		data_offset += (size_t)n;
+	}
+	while (0 != n);
+
+	return data_offset;
+}
+
+/* splits data written to socket into frames and checks the number of messages in each frame */
+static void	mock_check_frames(const zbx_vector_ipcmsg_t *messages)
+{
+	mock_client_t		client;
+	pthread_t		thread;
+	int			fds[2], frame_num = 0, index = 0;
+	unsigned char		*data, *ptr, *end;
+	size_t			size;
+	zbx_mock_handle_t	hframes, hframe;
+	zbx_mock_error_t	err;
+	char			prefix[MAX_STRING_LEN];
+
+	if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+		fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+	memset(&client, 0, sizeof(client));
+	client.messages = *messages;
+	client.csocket.fd = fds[0];
+
+	if (0 != pthread_create(&thread, NULL, mock_write_entry, &client))
+		fail_msg("cannot create writer thread");
+
+	size = mock_read_all(fds[1], &data);
+	pthread_join(thread, NULL);
+	close(fds[1]);
+
+	zbx_mock_assert_result_eq("zbx_ipc_socket_write_batch()", SUCCEED, client.ret);
+
+	hframes = zbx_mock_get_parameter_handle("out.frames");
+
+	for (ptr = data, end = data + size; ptr < end; frame_num++)
+	{
+		zbx_uint32_t	header[2];
+		int		count = 0;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hframes, &hframe)))
+			fail_msg("frame %d was not expected: %s", frame_num, zbx_mock_error_string(err));
+
+		if ((size_t)(end - ptr) < ZBX_IPC_HEADER_SIZE)
+			fail_msg("frame %d header is truncated", frame_num);
+
+		memcpy(header, ptr, ZBX_IPC_HEADER_SIZE);
+		ptr += ZBX_IPC_HEADER_SIZE;
+
+		if ((size_t)(end - ptr) < header[ZBX_IPC_MESSAGE_SIZE])
+			fail_msg("frame %d data is truncated", frame_num);
+
+		if (ZBX_IPC_BATCH != header[ZBX_IPC_MESSAGE_CODE])
+		{
+			/* single message frames are sent as normal messages */
+			mock_check_message(messages, index++, header[ZBX_IPC_MESSAGE_CODE],
+					header[ZBX_IPC_MESSAGE_SIZE], ptr);
+			ptr += header[ZBX_IPC_MESSAGE_SIZE];
+			count = 1;
+		}
+		else
+		{
+			unsigned char	*frame_end = ptr + header[ZBX_IPC_MESSAGE_SIZE];
+
+			if (ZBX_IPC_BATCH_SIZE_MAX < header[ZBX_IPC_MESSAGE_SIZE])
+				fail_msg("frame %d size %u exceeds limit", frame_num, header[ZBX_IPC_MESSAGE_SIZE]);
+
+			while (ptr < frame_end)
+			{
+				zbx_uint32_t	message_header[2];
+
+				if ((size_t)(frame_end - ptr) < ZBX_IPC_HEADER_SIZE)
+					fail_msg("frame %d message header is truncated", frame_num);
+
+				memcpy(message_header, ptr, ZBX_IPC_HEADER_SIZE);
+				ptr += ZBX_IPC_HEADER_SIZE;
+
+				if ((size_t)(frame_end - ptr) < message_header[ZBX_IPC_MESSAGE_SIZE])
+					fail_msg("frame %d message data is truncated", frame_num);
+
+				mock_check_message(messages, index++, message_header[ZBX_IPC_MESSAGE_CODE],
+						message_header[ZBX_IPC_MESSAGE_SIZE], ptr);
+				ptr += message_header[ZBX_IPC_MESSAGE_SIZE];
+				count++;
+			}
+
+			if (1 == count)
+				fail_msg("frame %d with single message was not sent as normal message", frame_num);
+		}
+
+		zbx_snprintf(prefix, sizeof(prefix), "frame %d messages", frame_num);
+		zbx_mock_assert_int_eq(prefix, zbx_mock_get_object_member_int(hframe, "messages"), count);
+	}
+
+	if (ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hframes, &hframe))
+		fail_msg("expected more than %d frames", frame_num);
+
+	zbx_mock_assert_int_eq("written messages", messages->values_num, index);
+
+	zbx_free(data);
+}
+
+/* receives the messages through IPC service in batches of limited size */
+static void	mock_check_service(const zbx_vector_ipcmsg_t *messages)
+{
+	zbx_ipc_service_t	service;
+	mock_client_t		client;
+	pthread_t		thread;
+	zbx_timespec_t		timeout = {1, 0};
+	zbx_vector_ipcmsg_t	received;
+	char			path[] = "/tmp/zbx_ipc_XXXXXX", *error = NULL;
+	int			i, max_num, index = 0, disconnected = 0;
+	time_t			start;
+
+	max_num = (int)zbx_mock_get_parameter_uint64("in.max_num");
+
+	if (NULL == mkdtemp(path))
+		fail_msg("cannot create IPC directory: %s", zbx_strerror(errno));
+
+	if (SUCCEED != zbx_ipc_service_init_env(path, &error))
+		fail_msg("cannot initialize IPC environment: %s", error);
+
+	if (SUCCEED != zbx_ipc_service_start(&service, MOCK_SERVICE, &error))
+		fail_msg("cannot start IPC service: %s", error);
+
+	memset(&client, 0, sizeof(client));
+	client.messages = *messages;
+	client.ret = FAIL;
+
+	if (0 != pthread_create(&thread, NULL, mock_client_entry, &client))
+		fail_msg("cannot create client thread");
+
+	zbx_vector_ipcmsg_create(&received);
+	start = time(NULL);
+
+	/* client closes connection after sending all messages */
+	while (0 == disconnected)
+	{
+		zbx_ipc_client_t	*ipc_client;
+
+		if (MOCK_RECV_TIMEOUT < time(NULL) - start)
+			fail_msg("received %d of %d messages", index, messages->values_num);
+
+		zbx_ipc_service_recv_batch(&service, &timeout, &ipc_client, &received, max_num);
+
+		if (max_num < received.values_num)
+			fail_msg("received %d messages in batch of %d", received.values_num, max_num);
+
+		for (i = 0; i < received.values_num; i++)
+		{
+			mock_check_message(messages, index++, received.values[i]->code, received.values[i]->size,
+					received.values[i]->data);
+		}
+
+		if (NULL != ipc_client && 0 == received.values_num)
+			disconnected = 1;
+
+		zbx_vector_ipcmsg_clear_ext(&received, zbx_ipc_message_free);
+
+		if (NULL != ipc_client)
+			zbx_ipc_client_release(ipc_client);
+	}
+
+	pthread_join(thread, NULL);
+
+	if (SUCCEED != client.ret)
+		fail_msg("client failed: %s", ZBX_NULL2EMPTY_STR(client.error));
+
+	zbx_mock_assert_int_eq("received messages", messages->values_num, index);
+
+	zbx_vector_ipcmsg_destroy(&received);
+	zbx_ipc_service_close(&service);
+	zbx_ipc_service_free_env();
+	rmdir(path);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_ipcmsg_t	messages;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_ipcmsg_create(&messages);
+	mock_read_messages(&messages);
+
+	mock_check_frames(&messages);
+	mock_check_service(&messages);
+
+	zbx_vector_ipcmsg_clear_ext(&messages, zbx_ipc_message_free);
+	zbx_vector_ipcmsg_destroy(&messages);
+}
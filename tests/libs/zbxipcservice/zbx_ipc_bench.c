@@ -0,0 +1,278 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * IPC throughput benchmark.
+ *
+ * Starts IPC service in a child process and sends messages of 256B, 4KB, 64KB and 512KB to it
+ * one by one through socket, in batches of 64 messages through socket and through shared memory
+ * ring. Reports throughput in thousands of messages and megabytes per second. The service
+ * receives messages in batches and confirms the number of received messages and their total
+ * size after each run.
+ *
+ * Usage: zbx_ipc_bench [megabytes per message size]
+ */
+
+#include "zbxipcservice.h"
+#include "zbxtime.h"
+
+#define IPC_BENCH_MEGABYTES	1024
+#define IPC_BENCH_MESSAGES_MAX	2000000
+#define IPC_BENCH_SHM_SIZE	(4 * ZBX_MEBIBYTE)
+#define IPC_BENCH_BATCH_SIZE	64
+
+#define IPC_BENCH_SERVICE	"ipc_bench"
+
+#define IPC_BENCH_DATA		1
+#define IPC_BENCH_SYNC		2
+#define IPC_BENCH_STOP		3
+
+const char	title_message[] = "zbx_ipc_bench";
+const char	*usage_message[] = {"[megabytes per message size]", NULL};
+const char	*help_message[] = {"IPC throughput benchmark.", NULL};
+const char	*progname = "zbx_ipc_bench";
+const char	syslog_app_name[] = "zbx_ipc_bench";
+
+typedef enum
+{
+	IPC_BENCH_TRANSPORT_SOCKET = 0,
+	IPC_BENCH_TRANSPORT_BATCH,
+	IPC_BENCH_TRANSPORT_SHM,
+	IPC_BENCH_TRANSPORTS_NUM
+}
+zbx_ipc_bench_transport_t;
+
+static const char	*transport_names[IPC_BENCH_TRANSPORTS_NUM] = {"socket", "batch", "shm"};
+
+static void	bench_log_impl(int level, const char *fmt, va_list args)
+{
+	if (LOG_LEVEL_WARNING < level)
+		return;
+
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+}
+
+static int	run_service(void)
+{
+	zbx_ipc_service_t	service;
+	zbx_timespec_t		timeout = {1, 0};
+	zbx_uint64_t		counters[2] = {0, 0};
+	zbx_vector_ipcmsg_t	messages;
+	char			*error = NULL;
+	int			stop = 0;
+
+	if (FAIL == zbx_ipc_service_start(&service, IPC_BENCH_SERVICE, &error))
+	{
+		printf("cannot start IPC service: %s\n", error);
+		zbx_free(error);
+		return EXIT_FAILURE;
+	}
+
+	zbx_vector_ipcmsg_create(&messages);
+
+	while (0 == stop)
+	{
+		zbx_ipc_client_t	*client;
+		int			i;
+
+		zbx_ipc_service_recv_batch(&service, &timeout, &client, &messages, IPC_BENCH_BATCH_SIZE);
+
+		for (i = 0; i < messages.values_num; i++)
+		{
+			zbx_ipc_message_t	*message = messages.values[i];
+
+			switch (message->code)
+			{
+				case IPC_BENCH_DATA:
+					counters[0]++;
+					counters[1] += message->size;
+					break;
+				case IPC_BENCH_SYNC:
+					zbx_ipc_client_send(client, IPC_BENCH_SYNC, (unsigned char *)counters,
+							sizeof(counters));
+					counters[0] = 0;
+					counters[1] = 0;
+					break;
+				case IPC_BENCH_STOP:
+					stop = 1;
+					break;
+			}
+		}
+
+		zbx_vector_ipcmsg_clear_ext(&messages, zbx_ipc_message_free);
+
+		if (NULL != client)
+			zbx_ipc_client_release(client);
+	}
+
+	zbx_vector_ipcmsg_destroy(&messages);
+	zbx_ipc_service_close(&service);
+
+	return EXIT_SUCCESS;
+}
+
+static int	run_client(int transport, const unsigned char *data, zbx_uint32_t size, int messages, double *elapsed)
+{
+	zbx_ipc_socket_t	csocket;
+	zbx_ipc_message_t	message, batch_messages[IPC_BENCH_BATCH_SIZE];
+	zbx_vector_ipcmsg_t	batch;
+	zbx_uint64_t		counters[2];
+	double			start;
+	char			*error = NULL;
+	int			i, ret = FAIL;
+
+	if (FAIL == zbx_ipc_socket_open_ext(&csocket, IPC_BENCH_SERVICE, SEC_PER_MIN,
+			IPC_BENCH_TRANSPORT_SHM == transport ? IPC_BENCH_SHM_SIZE : 0, &error))
+	{
+		printf("cannot connect to IPC service: %s\n", error);
+		zbx_free(error);
+		return FAIL;
+	}
+
+	zbx_vector_ipcmsg_create(&batch);
+
+	for (i = 0; i < IPC_BENCH_BATCH_SIZE; i++)
+	{
+		batch_messages[i].code = IPC_BENCH_DATA;
+		batch_messages[i].size = size;
+		batch_messages[i].data = (unsigned char *)data;
+		zbx_vector_ipcmsg_append(&batch, &batch_messages[i]);
+	}
+
+	if (IPC_BENCH_TRANSPORT_SHM == transport && NULL == csocket.shm)
+	{
+		printf("shared memory ring is not supported\n");
+		goto out;
+	}
+
+	start = zbx_time();
+
+	for (i = 0; i < messages; i++)
+	{
+		if (IPC_BENCH_TRANSPORT_BATCH == transport && i + IPC_BENCH_BATCH_SIZE <= messages)
+		{
+			if (FAIL == zbx_ipc_socket_write_batch(&csocket, &batch))
+				goto out;
+
+			i += IPC_BENCH_BATCH_SIZE - 1;
+			continue;
+		}
+
+		if (FAIL == zbx_ipc_socket_write(&csocket, IPC_BENCH_DATA, data, size))
+			goto out;
+	}
+
+	if (FAIL == zbx_ipc_socket_write(&csocket, IPC_BENCH_SYNC, NULL, 0) ||
+			FAIL == zbx_ipc_socket_read(&csocket, &message))
+	{
+		goto out;
+	}
+
+	*elapsed = zbx_time() - start;
+
+	memcpy(counters, message.data, sizeof(counters));
+	zbx_ipc_message_clean(&message);
+
+	if (counters[0] != (zbx_uint64_t)messages || counters[1] != (zbx_uint64_t)messages * size)
+	{
+		printf("MISMATCH: received " ZBX_FS_UI64 " messages of " ZBX_FS_UI64 " bytes\n", counters[0],
+				counters[1]);
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_vector_ipcmsg_destroy(&batch);
+	zbx_ipc_socket_close(&csocket);
+
+	return ret;
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_uint32_t	sizes[] = {256, 4 * ZBX_KIBIBYTE, 64 * ZBX_KIBIBYTE, 512 * ZBX_KIBIBYTE};
+	zbx_ipc_socket_t		csocket;
+	char				path[] = "/tmp/zbx_ipc_bench_XXXXXX", *error = NULL;
+	unsigned char			*data;
+	int				i, transport, megabytes = IPC_BENCH_MEGABYTES, ret = EXIT_SUCCESS, status;
+	pid_t				pid;
+
+	zbx_init_library_common(bench_log_impl);
+
+	if (1 < argc)
+		megabytes = atoi(argv[1]);
+
+	if (NULL == mkdtemp(path))
+	{
+		printf("cannot create temporary directory: %s\n", zbx_strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	if (FAIL == zbx_ipc_service_init_env(path, &error))
+	{
+		printf("cannot initialize IPC environment: %s\n", error);
+		zbx_free(error);
+		rmdir(path);
+		return EXIT_FAILURE;
+	}
+
+	if (0 == (pid = fork()))
+		exit(run_service());
+
+	data = (unsigned char *)zbx_malloc(NULL, sizes[ARRSIZE(sizes) - 1]);
+	memset(data, 'x', sizes[ARRSIZE(sizes) - 1]);
+
+	printf("%-10s %-8s %12s %12s\n", "size", "ipc", "kmsg/s", "MB/s");
+
+	for (i = 0; i < (int)ARRSIZE(sizes); i++)
+	{
+		int	messages = (int)MIN(IPC_BENCH_MESSAGES_MAX, (zbx_uint64_t)megabytes * ZBX_MEBIBYTE / sizes[i]);
+
+		for (transport = 0; transport < IPC_BENCH_TRANSPORTS_NUM; transport++)
+		{
+			double	elapsed;
+
+			if (SUCCEED != run_client(transport, data, sizes[i], messages, &elapsed))
+			{
+				ret = EXIT_FAILURE;
+				continue;
+			}
+
+			printf("%-10u %-8s %12.1f %12.1f\n", sizes[i], transport_names[transport],
+					messages / elapsed / 1e3, (double)messages * sizes[i] / elapsed / ZBX_MEBIBYTE);
+		}
+	}
+
+	if (SUCCEED == zbx_ipc_socket_open(&csocket, IPC_BENCH_SERVICE, SEC_PER_MIN, &error))
+	{
+		zbx_ipc_socket_write(&csocket, IPC_BENCH_STOP, NULL, 0);
+		zbx_ipc_socket_close(&csocket);
+	}
+	else
+		zbx_free(error);
+
+	waitpid(pid, &status, 0);
+
+	zbx_ipc_service_free_env();
+	rmdir(path);
+	zbx_free(data);
+
+	return ret;
+}
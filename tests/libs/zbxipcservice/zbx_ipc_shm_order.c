@@ -0,0 +1,214 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxipcservice.h"
+#include "zbxstr.h"
+#include "../../../src/libs/zbxipcservice/ipcshm.h"
+
+#define MOCK_SERVICE		"ipc_shm_order"
+
+/* time in seconds to wait for all messages */
+#define MOCK_RECV_TIMEOUT	30
+
+typedef struct
+{
+	zbx_vector_uint32_t	sizes;
+	zbx_uint32_t		shm_size;
+	int			repeat;
+	int			shm_used;
+	int			ret;
+	char			*error;
+}
+mock_client_t;
+
+static void	mock_fill_data(unsigned char *data, zbx_uint32_t code, zbx_uint32_t size)
+{
+	zbx_uint32_t	i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (unsigned char)(code + i);
+}
+
+/* sends messages in the specified order, message code is its sequence number starting with 1 */
+static void	*mock_client_entry(void *args)
+{
+	mock_client_t		*client = (mock_client_t *)args;
+	zbx_ipc_socket_t	csocket;
+	unsigned char		*data;
+	zbx_uint32_t		code = 0, size_max = 0;
+	int			i, j;
+
+	for (i = 0; i < client->sizes.values_num; i++)
+	{
+		if (size_max < client->sizes.values[i])
+			size_max = client->sizes.values[i];
+	}
+
+	if (SUCCEED != zbx_ipc_socket_open_ext(&csocket, MOCK_SERVICE, SEC_PER_MIN, client->shm_size,
+			&client->error))
+	{
+		return NULL;
+	}
+
+	client->shm_used = (NULL != csocket.shm ? SUCCEED : FAIL);
+	data = (unsigned char *)zbx_malloc(NULL, size_max + 1);
+
+	for (j = 0; j < client->repeat; j++)
+	{
+		for (i = 0; i < client->sizes.values_num; i++)
+		{
+			mock_fill_data(data, ++code, client->sizes.values[i]);
+
+			if (SUCCEED != zbx_ipc_socket_write(&csocket, code, data, client->sizes.values[i]))
+			{
+				client->error = zbx_dsprintf(NULL, "cannot write message %u", code);
+				goto out;
+			}
+		}
+	}
+
+	client->ret = SUCCEED;
+out:
+	zbx_free(data);
+	zbx_ipc_socket_close(&csocket);
+
+	return NULL;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_ipc_service_t	service;
+	zbx_mock_handle_t	hsizes, hsize;
+	zbx_mock_error_t	err;
+	mock_client_t		client;
+	pthread_t		thread;
+	zbx_timespec_t		timeout = {1, 0};
+	char			path[] = "/tmp/zbx_ipc_XXXXXX", *error = NULL, prefix[MAX_STRING_LEN];
+	unsigned char		*data = NULL;
+	size_t			data_alloc = 0;
+	zbx_uint32_t		code = 0;
+	int			messages, disconnected = 0;
+	time_t			start;
+
+	ZBX_UNUSED(state);
+
+	memset(&client, 0, sizeof(client));
+	client.ret = FAIL;
+	client.shm_size = (zbx_uint32_t)zbx_mock_get_parameter_uint64("in.shm_size");
+	client.repeat = (int)zbx_mock_get_parameter_uint64("in.repeat");
+	zbx_vector_uint32_create(&client.sizes);
+
+	hsizes = zbx_mock_get_parameter_handle("in.sizes");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsizes, &hsize)))
+	{
+		zbx_uint64_t	size;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hsize, &size)))
+			fail_msg("cannot read message size: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint32_append(&client.sizes, (zbx_uint32_t)size);
+	}
+
+	messages = client.sizes.values_num * client.repeat;
+
+	if (NULL == mkdtemp(path))
+		fail_msg("cannot create IPC directory: %s", zbx_strerror(errno));
+
+	if (SUCCEED != zbx_ipc_service_init_env(path, &error))
+		fail_msg("cannot initialize IPC environment: %s", error);
+
+	if (SUCCEED != zbx_ipc_service_start(&service, MOCK_SERVICE, &error))
+		fail_msg("cannot start IPC service: %s", error);
+
+	if (0 != pthread_create(&thread, NULL, mock_client_entry, &client))
+		fail_msg("cannot create client thread");
+
+	start = time(NULL);
+
+	/* client closes connection after sending all messages */
+	while (0 == disconnected)
+	{
+		zbx_ipc_client_t	*ipc_client;
+		zbx_ipc_message_t	*message;
+
+		if (MOCK_RECV_TIMEOUT < time(NULL) - start)
+			fail_msg("received %u of %d messages", code, messages);
+
+		zbx_ipc_service_recv(&service, &timeout, &ipc_client, &message);
+
+		if (NULL != message)
+		{
+			zbx_uint32_t	size;
+
+			if (code == (zbx_uint32_t)messages)
+				fail_msg("received more than %d messages", messages);
+
+			size = client.sizes.values[code % (zbx_uint32_t)client.sizes.values_num];
+
+			zbx_snprintf(prefix, sizeof(prefix), "message %u code", ++code);
+			zbx_mock_assert_uint64_eq(prefix, code, message->code);
+
+			zbx_snprintf(prefix, sizeof(prefix), "message %u size", code);
+			zbx_mock_assert_uint64_eq(prefix, size, message->size);
+
+			if (data_alloc < size + 1)
+			{
+				data_alloc = size + 1;
+				data = (unsigned char *)zbx_realloc(data, data_alloc);
+			}
+
+			mock_fill_data(data, code, size);
+
+			if (0 != size && 0 != memcmp(data, message->data, size))
+				fail_msg("message %u data does not match", code);
+
+			zbx_ipc_message_free(message);
+		}
+		else if (NULL != ipc_client)
+			disconnected = 1;
+
+		if (NULL != ipc_client)
+			zbx_ipc_client_release(ipc_client);
+	}
+
+	pthread_join(thread, NULL);
+
+	zbx_mock_assert_int_eq("received messages", messages, (int)code);
+
+	if (SUCCEED != client.ret)
+		fail_msg("client failed: %s", ZBX_NULL2EMPTY_STR(client.error));
+
+#ifdef ZBX_HAVE_IPC_SHM
+	zbx_mock_assert_result_eq("shared memory ring", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.shm")), client.shm_used);
+#endif
+
+	zbx_ipc_service_close(&service);
+	zbx_ipc_service_free_env();
+	rmdir(path);
+
+	zbx_free(data);
+	zbx_vector_uint32_destroy(&client.sizes);
+}
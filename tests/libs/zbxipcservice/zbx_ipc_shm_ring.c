@@ -0,0 +1,365 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* included first as it enables memfd_create() declaration before system headers are included */
+#include "../../../src/libs/zbxipcservice/ipcshm.c"
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#ifdef ZBX_HAVE_IPC_SHM
+
+/* time in milliseconds to wait for the producer thread, the woken up producer must not */
+/* rely on periodic checks done after ZBX_IPC_SHM_WAIT_TIMEOUT                        */
+#define MOCK_WAIT_BLOCKED	200
+#define MOCK_WAIT_WAKEUP	(ZBX_IPC_SHM_WAIT_TIMEOUT / 2)
+#define MOCK_WAIT_STOPPED	(ZBX_IPC_SHM_WAIT_TIMEOUT * 3)
+
+typedef struct
+{
+	zbx_ipc_shm_t		*producer;
+	zbx_ipc_shm_t		*consumer;
+
+	/* socket pair emulating connection to the service */
+	int			sockfd[2];
+
+	/* sizes of written messages, message code is the index of its size */
+	zbx_vector_uint32_t	sizes;
+	int			read_num;
+
+	/* ring head saved by consumer before reading socket */
+	zbx_uint64_t		head;
+
+	/* producer thread waiting for ring space */
+	pthread_t		thread;
+	int			thread_started;
+	int			thread_done;
+	int			thread_result;
+	zbx_uint32_t		thread_code;
+	zbx_uint32_t		thread_size;
+}
+mock_ring_t;
+
+static mock_ring_t	mock;
+
+static void	mock_fill_data(unsigned char *data, zbx_uint32_t code, zbx_uint32_t size)
+{
+	zbx_uint32_t	i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (unsigned char)(code + i);
+}
+
+static int	mock_write(zbx_uint32_t code, zbx_uint32_t size)
+{
+	unsigned char	*data;
+	int		ret;
+
+	data = (unsigned char *)zbx_malloc(NULL, size + 1);
+	mock_fill_data(data, code, size);
+	ret = ipc_shm_write(mock.producer, mock.sockfd[0], code, data, size);
+	zbx_free(data);
+
+	return ret;
+}
+
+static void	*mock_producer_entry(void *args)
+{
+	int	ret;
+
+	ZBX_UNUSED(args);
+
+	ret = mock_write(mock.thread_code, mock.thread_size);
+
+	__atomic_store_n(&mock.thread_result, ret, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&mock.thread_done, 1, __ATOMIC_SEQ_CST);
+
+	return NULL;
+}
+
+static int	mock_wait_thread(int timeout)
+{
+	int	i;
+
+	for (i = 0; i < timeout; i++)
+	{
+		if (0 != __atomic_load_n(&mock.thread_done, __ATOMIC_SEQ_CST))
+			return SUCCEED;
+
+		usleep(1000);
+	}
+
+	return FAIL;
+}
+
+static void	mock_join_thread(void)
+{
+	if (0 == mock.thread_started)
+		return;
+
+	pthread_join(mock.thread, NULL);
+	mock.thread_started = 0;
+}
+
+static zbx_uint32_t	mock_ring_free(void)
+{
+	return mock.producer->size - (zbx_uint32_t)(__atomic_load_n(&mock.producer->ring->head, __ATOMIC_SEQ_CST) -
+			__atomic_load_n(&mock.producer->ring->tail, __ATOMIC_SEQ_CST));
+}
+
+static int	mock_is_notified(int fd)
+{
+	struct pollfd	pd;
+
+	pd.fd = fd;
+	pd.events = POLLIN;
+
+	return 1 == poll(&pd, 1, 0) ? SUCCEED : FAIL;
+}
+
+static int	mock_read(int max_num, zbx_uint64_t head)
+{
+	zbx_queue_ptr_t		queue;
+	zbx_ipc_message_t	*message;
+	int			num = 0;
+	char			prefix[MAX_STRING_LEN];
+
+	zbx_queue_ptr_create(&queue);
+
+	if (SUCCEED != ipc_shm_read_messages(mock.consumer, &queue, max_num, head))
+		fail_msg("cannot read messages from ring");
+
+	while (NULL != (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&queue)))
+	{
+		unsigned char	*data;
+
+		zbx_snprintf(prefix, sizeof(prefix), "message %d code", mock.read_num);
+		zbx_mock_assert_uint64_eq(prefix, (zbx_uint64_t)mock.read_num, message->code);
+
+		if (mock.read_num >= mock.sizes.values_num)
+			fail_msg("message %d was not written", mock.read_num);
+
+		zbx_snprintf(prefix, sizeof(prefix), "message %d size", mock.read_num);
+		zbx_mock_assert_uint64_eq(prefix, mock.sizes.values[mock.read_num], message->size);
+
+		data = (unsigned char *)zbx_malloc(NULL, message->size + 1);
+		mock_fill_data(data, message->code, message->size);
+
+		if (0 != message->size && 0 != memcmp(data, message->data, message->size))
+			fail_msg("message %d data does not match", mock.read_num);
+
+		zbx_free(data);
+		zbx_ipc_message_free(message);
+
+		mock.read_num++;
+		num++;
+	}
+
+	zbx_queue_ptr_destroy(&queue);
+
+	return num;
+}
+
+static void	mock_step(zbx_mock_handle_t hstep, int index)
+{
+	const char		*op;
+	zbx_mock_handle_t	hsizes, hsize, hvalue;
+	zbx_mock_error_t	err;
+	char			prefix[MAX_STRING_LEN];
+
+	op = zbx_mock_get_object_member_string(hstep, "op");
+
+	if (0 == strcmp(op, "write"))
+	{
+		/* the writes must not block as there is no consumer thread */
+		hsizes = zbx_mock_get_object_member_handle(hstep, "sizes");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsizes, &hsize)))
+		{
+			zbx_uint64_t	size;
+
+			if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hsize, &size)))
+				fail_msg("step %d cannot read message size: %s", index, zbx_mock_error_string(err));
+
+			if (SUCCEED != ipc_shm_fits(mock.producer, (zbx_uint32_t)size) ||
+					mock_ring_free() < size + ZBX_IPC_SHM_RECORD_HEADER_SIZE)
+			{
+				fail_msg("step %d message of " ZBX_FS_UI64 " bytes does not fit ring", index, size);
+			}
+
+			zbx_vector_uint32_append(&mock.sizes, (zbx_uint32_t)size);
+
+			if (SUCCEED != mock_write((zbx_uint32_t)mock.sizes.values_num - 1, (zbx_uint32_t)size))
+				fail_msg("step %d cannot write message", index);
+		}
+	}
+	else if (0 == strcmp(op, "snapshot"))
+	{
+		mock.head = ipc_shm_get_head(mock.consumer);
+	}
+	else if (0 == strcmp(op, "read"))
+	{
+		zbx_uint64_t	head;
+
+		/* messages are read up to the snapshot when socket is read, otherwise up to the last message */
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "snapshot", &hvalue))
+			head = mock.head;
+		else
+			head = ipc_shm_get_head(mock.consumer);
+
+		zbx_snprintf(prefix, sizeof(prefix), "step %d read messages", index);
+		zbx_mock_assert_int_eq(prefix, zbx_mock_get_object_member_int(hstep, "messages"),
+				mock_read(zbx_mock_get_object_member_int(hstep, "max"), head));
+	}
+	else if (0 == strcmp(op, "write wait"))
+	{
+		/* writes message in a separate thread that waits for ring space */
+		mock.thread_size = (zbx_uint32_t)zbx_mock_get_object_member_uint64(hstep, "size");
+		mock.thread_code = (zbx_uint32_t)mock.sizes.values_num;
+		mock.thread_done = 0;
+		zbx_vector_uint32_append(&mock.sizes, mock.thread_size);
+
+		if (0 != pthread_create(&mock.thread, NULL, mock_producer_entry, NULL))
+			fail_msg("step %d cannot create producer thread", index);
+
+		mock.thread_started = 1;
+	}
+	else if (0 == strcmp(op, "check blocked"))
+	{
+		if (SUCCEED == mock_wait_thread(MOCK_WAIT_BLOCKED))
+			fail_msg("step %d producer did not wait for ring space", index);
+
+		zbx_mock_assert_uint64_eq("producer waiting flag", 1,
+				__atomic_load_n(&mock.producer->ring->waiting, __ATOMIC_SEQ_CST));
+	}
+	else if (0 == strcmp(op, "check done"))
+	{
+		int	expected_ret;
+
+		expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "result"));
+
+		if (SUCCEED != mock_wait_thread(SUCCEED == expected_ret ? MOCK_WAIT_WAKEUP : MOCK_WAIT_STOPPED))
+			fail_msg("step %d producer was not woken up", index);
+
+		mock_join_thread();
+
+		zbx_snprintf(prefix, sizeof(prefix), "step %d write result", index);
+		zbx_mock_assert_result_eq(prefix, expected_ret, mock.thread_result);
+
+		/* message was not written if the service has closed connection */
+		if (SUCCEED != mock.thread_result)
+			mock.sizes.values_num--;
+	}
+	else if (0 == strcmp(op, "close peer"))
+	{
+		close(mock.sockfd[1]);
+		mock.sockfd[1] = -1;
+	}
+	else
+		fail_msg("step %d unknown operation \"%s\"", index, op);
+
+	/* data notification after the step */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "notified", &hvalue))
+	{
+		const char	*value;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &value)))
+			fail_msg("step %d cannot read notification: %s", index, zbx_mock_error_string(err));
+
+		zbx_snprintf(prefix, sizeof(prefix), "step %d data notification", index);
+		zbx_mock_assert_result_eq(prefix, 0 == strcmp(value, "yes") ? SUCCEED : FAIL,
+				mock_is_notified(ipc_shm_get_notify_fd(mock.consumer)));
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		start;
+	int			fds[ZBX_IPC_SHM_FDS_NUM], i;
+	char			*error = NULL;
+
+	ZBX_UNUSED(state);
+
+	memset(&mock, 0, sizeof(mock));
+	zbx_vector_uint32_create(&mock.sizes);
+
+	if (NULL == (mock.producer = ipc_shm_create((zbx_uint32_t)zbx_mock_get_parameter_uint64("in.size"), &error)))
+		fail_msg("cannot create ring: %s", error);
+
+	zbx_mock_assert_uint64_eq("ring size", zbx_mock_get_parameter_uint64("out.size"),
+			ipc_shm_get_size(mock.producer));
+
+	/* consumer maps the ring from descriptors as if they were received by the service */
+	ipc_shm_get_fds(mock.producer, fds);
+
+	for (i = 0; i < ZBX_IPC_SHM_FDS_NUM; i++)
+		fds[i] = dup(fds[i]);
+
+	if (NULL == (mock.consumer = ipc_shm_create_pending(fds, ZBX_IPC_SHM_FDS_NUM)))
+		fail_msg("cannot create consumer side ring");
+
+	if (SUCCEED != ipc_shm_attach(mock.consumer, ipc_shm_get_size(mock.producer), &error))
+		fail_msg("cannot attach ring: %s", error);
+
+	/* start from the specified byte counter to test wrapping of records and counters */
+	start = zbx_mock_get_parameter_uint64("in.start");
+	mock.producer->ring->head = start;
+	mock.producer->ring->tail = start;
+
+	if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, mock.sockfd))
+		fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step: %s", zbx_mock_error_string(err));
+
+		mock_step(hstep, i);
+	}
+
+	mock_join_thread();
+
+	zbx_mock_assert_int_eq("written messages", mock.sizes.values_num, mock.read_num);
+
+	close(mock.sockfd[0]);
+
+	if (-1 != mock.sockfd[1])
+		close(mock.sockfd[1]);
+
+	ipc_shm_free(mock.consumer);
+	ipc_shm_free(mock.producer);
+	zbx_vector_uint32_destroy(&mock.sizes);
+}
+
+#else
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+
+#endif
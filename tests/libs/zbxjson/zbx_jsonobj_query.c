@@ -87,6 +87,40 @@ static void	test_query(zbx_jsonobj_t *obj, const char *path, int expected_ret)
 
 }
 
+/* check that streaming query returns the same result as json object query */
+static void	test_stream_query(zbx_jsonobj_t *obj, const char *data, const char *path)
+{
+	char			*output = NULL;
+	zbx_jsonpath_t		jsonpath;
+	zbx_jsonpath_query_t	query;
+
+	if (SUCCEED != zbx_jsonpath_compile(path, &jsonpath))
+		return;
+
+	if (SUCCEED == zbx_jsonpath_is_streamable(&jsonpath))
+	{
+		if (SUCCEED != zbx_jsonobj_query(obj, path, &output))
+			fail_msg("Cannot query json object: %s", zbx_json_strerror());
+
+		query.path = &jsonpath;
+
+		if (SUCCEED != zbx_jsonpath_query_stream(data, &query, 1))
+			fail_msg("Cannot perform streaming query: %s", zbx_json_strerror());
+
+		printf("\tzbx_jsonpath_query_stream() query result: %s\n", ZBX_NULL2EMPTY_STR(query.output));
+
+		if (NULL == output)
+			zbx_mock_assert_ptr_eq("Streaming query result", NULL, query.output);
+		else
+			zbx_mock_assert_str_eq("Streaming query result", output, query.output);
+
+		zbx_free(query.output);
+		zbx_free(output);
+	}
+
+	zbx_jsonpath_clear(&jsonpath);
+}
+
 void	zbx_mock_test_entry(void **state)
 {
 	const char	*data, *path;
@@ -110,5 +144,7 @@ void	zbx_mock_test_entry(void **state)
 	/* query second time to check index reuse */
 	test_query(&obj, path, expected_ret);
 
+	test_stream_query(&obj, data, path);
+
 	zbx_jsonobj_clear(&obj);
 }
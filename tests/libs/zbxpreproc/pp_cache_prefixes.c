@@ -0,0 +1,251 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxpreproc.h"
+#include "libs/zbxpreproc/pp_execute.h"
+#include "libs/zbxpreproc/pp_cache.h"
+#include "libs/zbxpreproc/pp_error.h"
+
+#define MOCK_MASTER_ITEMID	1
+
+static int	mock_str_to_preproc_type(const char *str)
+{
+	if (0 == strcmp(str, "ZBX_PREPROC_MULTIPLIER"))
+		return ZBX_PREPROC_MULTIPLIER;
+	if (0 == strcmp(str, "ZBX_PREPROC_TRIM"))
+		return ZBX_PREPROC_TRIM;
+	if (0 == strcmp(str, "ZBX_PREPROC_JSONPATH"))
+		return ZBX_PREPROC_JSONPATH;
+	if (0 == strcmp(str, "ZBX_PREPROC_STR_REPLACE"))
+		return ZBX_PREPROC_STR_REPLACE;
+	if (0 == strcmp(str, "ZBX_PREPROC_DELTA_VALUE"))
+		return ZBX_PREPROC_DELTA_VALUE;
+	if (0 == strcmp(str, "ZBX_PREPROC_THROTTLE_VALUE"))
+		return ZBX_PREPROC_THROTTLE_VALUE;
+	if (0 == strcmp(str, "ZBX_PREPROC_SCRIPT"))
+		return ZBX_PREPROC_SCRIPT;
+
+	fail_msg("unknown preprocessing step type: %s", str);
+	return FAIL;
+}
+
+static zbx_pp_item_preproc_t	*mock_read_preproc(zbx_mock_handle_t hitem)
+{
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_mock_handle_t	hsteps, hstep, hparams;
+	zbx_mock_error_t	err;
+
+	preproc = zbx_pp_item_preproc_create(0, ITEM_TYPE_DEPENDENT,
+			zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hitem, "value_type")), 0);
+
+	hsteps = zbx_mock_get_object_member_handle(hitem, "steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		zbx_pp_step_t	*step;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step: %s", zbx_mock_error_string(err));
+
+		preproc->steps = (zbx_pp_step_t *)zbx_realloc(preproc->steps, sizeof(zbx_pp_step_t) *
+				(size_t)(preproc->steps_num + 1));
+		step = &preproc->steps[preproc->steps_num++];
+
+		step->type = mock_str_to_preproc_type(zbx_mock_get_object_member_string(hstep, "type"));
+		step->error_handler = ZBX_PREPROC_FAIL_DEFAULT;
+		step->error_handler_params = zbx_strdup(NULL, "");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "params", &hparams))
+			step->params = zbx_strdup(NULL, zbx_mock_get_object_member_string(hstep, "params"));
+		else
+			step->params = zbx_strdup(NULL, "");
+
+		if (SUCCEED == zbx_pp_preproc_has_history(step->type))
+			preproc->history_num++;
+	}
+
+	return preproc;
+}
+
+/* replaces dependent items of master item with the items of configuration revision */
+static void	mock_read_items(zbx_mock_handle_t hitems, zbx_flathashset_t *items, zbx_pp_item_preproc_t *master,
+		zbx_vector_uint64_t *itemids)
+{
+	zbx_mock_handle_t	hitem;
+	zbx_mock_error_t	err;
+
+	zbx_flathashset_clear(items);
+	zbx_vector_uint64_clear(itemids);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		zbx_pp_item_t	item_local;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		item_local.itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		item_local.revision = 0;
+		item_local.preproc = mock_read_preproc(hitem);
+
+		zbx_flathashset_insert(items, &item_local, sizeof(item_local));
+		zbx_vector_uint64_append(itemids, item_local.itemid);
+	}
+
+	zbx_free(master->dep_itemids);
+	master->dep_itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)itemids->values_num);
+	memcpy(master->dep_itemids, itemids->values, sizeof(zbx_uint64_t) * (size_t)itemids->values_num);
+	master->dep_itemids_num = itemids->values_num;
+}
+
+static void	mock_check_prefixids(int round, int index, zbx_mock_handle_t hprefixids,
+		const zbx_pp_prefix_item_t *prefix)
+{
+	zbx_mock_handle_t	hprefixid;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		prefixid;
+	char			msg[MAX_STRING_LEN];
+	int			i;
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hprefixids, &hprefixid)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hprefixid, &prefixid)))
+			fail_msg("cannot read prefix identifier: %s", zbx_mock_error_string(err));
+
+		if (NULL == prefix || i >= prefix->prefixes_num)
+			fail_msg("round %d item %d step %d prefix was not found", round, index, i);
+
+		zbx_snprintf(msg, sizeof(msg), "round %d item %d step %d prefix", round, index, i);
+		zbx_mock_assert_uint64_eq(msg, prefixid, prefix->prefixids[i]);
+	}
+
+	zbx_snprintf(msg, sizeof(msg), "round %d item %d prefixes", round, index);
+	zbx_mock_assert_int_eq(msg, i, NULL == prefix ? 0 : prefix->prefixes_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_pp_context_t	ctx;
+	zbx_flathashset_t	items;
+	zbx_vector_uint64_t	itemids;
+	zbx_pp_item_preproc_t	*master;
+	zbx_pp_prefixes_t	*prefixes = NULL;
+	zbx_mock_handle_t	hrounds_in, hrounds_out, hin, hout, hitems, hvalues, hvalue, hprefixes, hprefixids;
+	zbx_mock_error_t	err;
+	zbx_variant_t		value;
+	zbx_timespec_t		ts = {1700000000, 0};
+	char			msg[MAX_STRING_LEN];
+	int			round;
+
+	ZBX_UNUSED(state);
+
+	pp_context_init(&ctx);
+
+	zbx_flathashset_create_ext(&items, 0, sizeof(zbx_pp_item_t), ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_pp_item_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_vector_uint64_create(&itemids);
+
+	master = zbx_pp_item_preproc_create(0, ITEM_TYPE_TRAPPER, ITEM_VALUE_TYPE_TEXT, 0);
+	zbx_variant_set_str(&value, zbx_strdup(NULL, zbx_mock_get_parameter_string("in.value")));
+
+	hrounds_in = zbx_mock_get_parameter_handle("in.rounds");
+	hrounds_out = zbx_mock_get_parameter_handle("out.rounds");
+
+	/* every round processes master item value with configuration of the round revision */
+	for (round = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrounds_in, &hin)); round++)
+	{
+		zbx_pp_prefixes_t	*prefixes_old = prefixes;
+		zbx_pp_cache_t		*cache;
+		const char		*expected;
+		int			i;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hrounds_out, &hout)))
+			fail_msg("cannot read round %d: %s", round, zbx_mock_error_string(err));
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hin, "items", &hitems))
+			mock_read_items(hitems, &items, master, &itemids);
+
+		prefixes = pp_prefixes_update(prefixes, zbx_mock_get_object_member_uint64(hin, "revision"), master,
+				&items);
+
+		zbx_snprintf(msg, sizeof(msg), "round %d prefixes are found again", round);
+		zbx_mock_assert_str_eq(msg, zbx_mock_get_object_member_string(hout, "update"),
+				prefixes_old == prefixes ? "no" : "yes");
+
+		hprefixes = zbx_mock_get_object_member_handle(hout, "prefixes");
+		hvalues = zbx_mock_get_object_member_handle(hout, "values");
+
+		cache = pp_cache_create(master, &value);
+		pp_cache_set_prefixes(cache, prefixes);
+
+		for (i = 0; i < itemids.values_num; i++)
+		{
+			zbx_pp_item_t	*item;
+			zbx_variant_t	value_out;
+			zbx_pp_result_t	*results = NULL;
+			int		results_num = 0;
+
+			item = (zbx_pp_item_t *)zbx_flathashset_search(&items, &itemids.values[i]);
+
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hprefixes, &hprefixids)))
+				fail_msg("cannot read round %d item %d prefixes: %s", round, i, zbx_mock_error_string(err));
+
+			mock_check_prefixids(round, i, hprefixids, pp_cache_get_prefix_item(cache, item->preproc));
+
+			pp_execute(&ctx, item->preproc, cache, NULL, NULL, ts, NULL, &value_out, &results, &results_num);
+
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hvalues, &hvalue)) ||
+					ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &expected)))
+			{
+				fail_msg("cannot read round %d item %d value: %s", round, i, zbx_mock_error_string(err));
+			}
+
+			zbx_snprintf(msg, sizeof(msg), "round %d item %d value", round, i);
+			zbx_mock_assert_str_eq(msg, expected, zbx_variant_value_desc(&value_out));
+
+			zbx_variant_clear(&value_out);
+			pp_free_results(results, results_num);
+		}
+
+		/* cache statistics are added to prefixes when the last reference is released */
+		pp_cache_release(cache);
+
+		zbx_snprintf(msg, sizeof(msg), "round %d prefix hits", round);
+		zbx_mock_assert_uint64_eq(msg, zbx_mock_get_object_member_uint64(hout, "hits"), prefixes->hits);
+
+		zbx_snprintf(msg, sizeof(msg), "round %d prefix misses", round);
+		zbx_mock_assert_uint64_eq(msg, zbx_mock_get_object_member_uint64(hout, "misses"), prefixes->misses);
+	}
+
+	if (ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hrounds_out, &hout))
+		fail_msg("expected more than %d rounds", round);
+
+	pp_prefixes_release(prefixes);
+	zbx_variant_clear(&value);
+	zbx_pp_item_preproc_release(master);
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_flathashset_destroy(&items);
+	pp_context_destroy(&ctx);
+}
@@ -0,0 +1,392 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxpreproc.h"
+#include "zbxcacheconfig.h"
+#include "zbxcachehistory.h"
+#include "libs/zbxpreproc/pp_queue.h"
+#include "libs/zbxpreproc/pp_task.h"
+
+/* task queue test worker */
+typedef struct
+{
+	zbx_pp_queue_t	*queue;
+	int		index;
+	pthread_t	thread;
+}
+pp_test_worker_t;
+
+/* tasks pushed for an item, in the order they must be processed */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	zbx_vector_ptr_t	tasks;
+	int			processed_num;
+
+	/* the number of item tasks being processed by workers */
+	int			processing_num;
+}
+pp_test_item_t;
+
+static pthread_mutex_t	items_lock = PTHREAD_MUTEX_INITIALIZER;
+static pp_test_item_t	*items;
+static int		items_num;
+static volatile int	workers_stop;
+
+zbx_dc_um_shared_handle_t	*zbx_dc_um_shared_handle_copy(zbx_dc_um_shared_handle_t *handle)
+{
+	return handle;
+}
+
+void	zbx_dc_um_shared_handle_release(zbx_dc_um_shared_handle_t *handle)
+{
+	ZBX_UNUSED(handle);
+}
+
+void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
+{
+	ZBX_UNUSED(opt);
+}
+
+static pp_test_item_t	*pp_test_get_item(zbx_uint64_t itemid)
+{
+	if (1 > itemid || (zbx_uint64_t)items_num < itemid)
+		fail_msg("unexpected task itemid " ZBX_FS_UI64, itemid);
+
+	return &items[itemid - 1];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pops all tasks from the specified worker queue                    *
+ *                                                                            *
+ * Comments: The worker pops tasks from its own queue first and then steals  *
+ *           tasks from other worker queues.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_steal(void)
+{
+	zbx_pp_queue_t		queue;
+	zbx_pp_item_preproc_t	*preproc, *preproc_internal;
+	zbx_pp_task_t		*task;
+	zbx_vector_ptr_t	tasks;
+	char			*error = NULL;
+	int			deques_num, tasks_num, index, i, popped_num = 0;
+	unsigned char		*popped;
+
+	deques_num = (int)zbx_mock_get_parameter_uint64("in.workers");
+	tasks_num = (int)zbx_mock_get_parameter_uint64("in.tasks");
+	index = (int)zbx_mock_get_parameter_uint64("in.index");
+
+	if (SUCCEED != pp_task_queue_init(&queue, deques_num, &error))
+		fail_msg("cannot initialize task queue: %s", error);
+
+	preproc = zbx_pp_item_preproc_create(1, ITEM_TYPE_TRAPPER, ITEM_VALUE_TYPE_UINT64, 0);
+	preproc_internal = zbx_pp_item_preproc_create(1, ITEM_TYPE_INTERNAL, ITEM_VALUE_TYPE_UINT64, 0);
+
+	zbx_vector_ptr_create(&tasks);
+	popped = (unsigned char *)zbx_calloc(NULL, (size_t)tasks_num, 1);
+
+	/* every third task is immediate, tasks are distributed between worker queues in round-robin */
+	pp_task_queue_lock(&queue);
+
+	for (i = 0; i < tasks_num; i++)
+	{
+		zbx_timespec_t	ts = {i, 0};
+
+		task = pp_task_value_create((zbx_uint64_t)i + 1, 0 == i % 3 ? preproc_internal : preproc, NULL, NULL,
+				ts, NULL, NULL);
+		zbx_vector_ptr_append(&tasks, task);
+		pp_task_queue_push(&queue, task);
+	}
+
+	pp_task_queue_unlock(&queue);
+
+	zbx_mock_assert_int_eq("queued tasks", tasks_num, pp_task_queue_queued_num(&queue));
+
+	while (NULL != (task = pp_task_queue_pop_new(&queue, index)))
+	{
+		if (FAIL == (i = zbx_vector_ptr_search(&tasks, task, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+			fail_msg("popped unknown task");
+
+		if (0 != popped[i]++)
+			fail_msg("task %d was popped twice", i);
+
+		popped_num++;
+
+		/* stolen tasks are moved to the stealing worker queue, so tasks are neither lost nor duplicated */
+		zbx_mock_assert_int_eq("queued tasks after pop", tasks_num - popped_num,
+				pp_task_queue_queued_num(&queue));
+
+		pp_task_queue_push_finished(&queue, index, task);
+	}
+
+	zbx_mock_assert_int_eq("popped tasks", tasks_num, popped_num);
+
+	pp_task_queue_lock(&queue);
+	pp_task_queue_update_stats(&queue);
+
+	zbx_mock_assert_uint64_eq("pending tasks", 0, queue.pending_num);
+	zbx_mock_assert_uint64_eq("processing tasks", 0, queue.processing_num);
+	zbx_mock_assert_uint64_eq("finished tasks", (zbx_uint64_t)tasks_num, queue.finished_num);
+	zbx_mock_assert_uint64_eq("steals", zbx_mock_get_parameter_uint64("out.steals"), queue.steals_num);
+
+	while (NULL != (task = pp_task_queue_pop_finished(&queue)))
+		pp_task_free(task);
+
+	pp_task_queue_update_stats(&queue);
+	zbx_mock_assert_uint64_eq("finished tasks after collecting", 0, queue.finished_num);
+
+	pp_task_queue_unlock(&queue);
+
+	zbx_free(popped);
+	zbx_vector_ptr_destroy(&tasks);
+
+	zbx_pp_item_preproc_release(preproc_internal);
+	zbx_pp_item_preproc_release(preproc);
+
+	pp_task_queue_destroy(&queue);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes tasks the same way as preprocessing worker does         *
+ *                                                                            *
+ ******************************************************************************/
+static void	*pp_test_worker_entry(void *args)
+{
+	pp_test_worker_t	*worker = (pp_test_worker_t *)args;
+	zbx_pp_task_t		*task;
+
+	while (0 == workers_stop)
+	{
+		pp_test_item_t	*item;
+
+		if (NULL == (task = pp_task_queue_pop_new(worker->queue, worker->index)))
+		{
+			sched_yield();
+			continue;
+		}
+
+		pthread_mutex_lock(&items_lock);
+		item = pp_test_get_item(task->itemid);
+
+		/* serial tasks of one item must never be processed in parallel */
+		if (1 < ++item->processing_num)
+			fail_msg("item " ZBX_FS_UI64 " tasks are processed in parallel", task->itemid);
+
+		pthread_mutex_unlock(&items_lock);
+
+		sched_yield();
+
+		pthread_mutex_lock(&items_lock);
+		item->processing_num--;
+		pthread_mutex_unlock(&items_lock);
+
+		pp_task_queue_push_finished(worker->queue, worker->index, task);
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requeues finished sequence task the same way as preprocessing     *
+ *          manager does and checks the order of processed item tasks         *
+ *                                                                            *
+ * Return value: The number of finished item tasks.                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_test_process_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task_seq)
+{
+	zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task_seq);
+	zbx_pp_task_t		*task;
+	pp_test_item_t		*item;
+
+	if (ZBX_PP_TASK_SEQUENCE != task_seq->type)
+		fail_msg("unexpected finished task type %d", task_seq->type);
+
+	if (SUCCEED != zbx_list_pop(&d_seq->tasks, (void **)&task))
+		fail_msg("finished empty sequence task");
+
+	item = pp_test_get_item(task->itemid);
+
+	if (item->processed_num >= item->tasks.values_num || task != item->tasks.values[item->processed_num])
+	{
+		fail_msg("item " ZBX_FS_UI64 " task %d was not processed in the order it was pushed", item->itemid,
+				item->processed_num);
+	}
+
+	item->processed_num++;
+	pp_task_free(task);
+
+	if (SUCCEED == zbx_list_peek(&d_seq->tasks, (void **)&task))
+	{
+		pp_task_queue_push_immediate(queue, task_seq);
+	}
+	else
+	{
+		pp_task_queue_remove_sequence(queue, task_seq->itemid);
+		pp_task_free(task_seq);
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes serial value and dependent tasks by multiple workers    *
+ *                                                                            *
+ * Comments: New tasks are pushed while the previous ones are being processed *
+ *           so they are added to sequences being processed or requeued.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_sequence(void)
+{
+	zbx_pp_queue_t		queue;
+	zbx_pp_item_preproc_t	*preproc;
+	pp_test_worker_t	*workers;
+	zbx_pp_task_t		*task;
+	char			*error = NULL;
+	int			workers_num, values_num, tasks_num, finished_num = 0, pushed_num = 0, i, j;
+
+	workers_num = (int)zbx_mock_get_parameter_uint64("in.workers");
+	items_num = (int)zbx_mock_get_parameter_uint64("in.items");
+	values_num = (int)zbx_mock_get_parameter_uint64("in.values");
+
+	if (SUCCEED != pp_task_queue_init(&queue, workers_num, &error))
+		fail_msg("cannot initialize task queue: %s", error);
+
+	preproc = zbx_pp_item_preproc_create(1, ITEM_TYPE_TRAPPER, ITEM_VALUE_TYPE_UINT64, 0);
+
+	items = (pp_test_item_t *)zbx_calloc(NULL, (size_t)items_num, sizeof(pp_test_item_t));
+
+	for (i = 0; i < items_num; i++)
+	{
+		items[i].itemid = (zbx_uint64_t)i + 1;
+		zbx_vector_ptr_create(&items[i].tasks);
+	}
+
+	workers = (pp_test_worker_t *)zbx_calloc(NULL, (size_t)workers_num, sizeof(pp_test_worker_t));
+	workers_stop = 0;
+
+	for (i = 0; i < workers_num; i++)
+	{
+		workers[i].queue = &queue;
+		workers[i].index = i;
+
+		if (0 != pthread_create(&workers[i].thread, NULL, pp_test_worker_entry, &workers[i]))
+			fail_msg("cannot create worker thread");
+	}
+
+	tasks_num = items_num * values_num;
+
+	while (finished_num < tasks_num)
+	{
+		pp_task_queue_lock(&queue);
+
+		/* push one value of every item, every other value is followed by dependent item task */
+		if (pushed_num < values_num)
+		{
+			for (i = 0; i < items_num; i++)
+			{
+				zbx_timespec_t	ts = {pushed_num, 0};
+
+				if (0 != pushed_num % 2)
+				{
+					task = pp_task_dependent_create(items[i].itemid, preproc);
+					pp_task_queue_push_immediate(&queue, task);
+				}
+				else
+				{
+					task = pp_task_value_seq_create(items[i].itemid, preproc, NULL, NULL, ts, NULL,
+							NULL);
+					pp_task_queue_push(&queue, task);
+				}
+
+				pthread_mutex_lock(&items_lock);
+				zbx_vector_ptr_append(&items[i].tasks, task);
+				pthread_mutex_unlock(&items_lock);
+			}
+
+			pushed_num++;
+
+			/* only one sequence task per item can be queued or processed */
+			if (items_num < pp_task_queue_queued_num(&queue))
+				fail_msg("more than one task of an item is queued");
+		}
+
+		pthread_mutex_lock(&items_lock);
+
+		while (NULL != (task = pp_task_queue_pop_finished(&queue)))
+			finished_num += pp_test_process_finished(&queue, task);
+
+		pthread_mutex_unlock(&items_lock);
+
+		pp_task_queue_unlock(&queue);
+
+		sched_yield();
+	}
+
+	workers_stop = 1;
+
+	for (i = 0; i < workers_num; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	zbx_mock_assert_int_eq("queued tasks", 0, pp_task_queue_queued_num(&queue));
+	zbx_mock_assert_int_eq("task sequences", 0, queue.sequences.num_data);
+
+	for (i = 0; i < items_num; i++)
+	{
+		zbx_mock_assert_int_eq("processed item tasks", values_num, items[i].processed_num);
+
+		for (j = 0; j < items[i].tasks.values_num; j++)
+			items[i].tasks.values[j] = NULL;
+
+		zbx_vector_ptr_destroy(&items[i].tasks);
+	}
+
+	zbx_free(items);
+	zbx_free(workers);
+
+	zbx_pp_item_preproc_release(preproc);
+
+	pp_task_queue_destroy(&queue);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*test;
+
+	ZBX_UNUSED(state);
+
+	test = zbx_mock_get_parameter_string("in.test");
+
+	if (0 == strcmp(test, "steal"))
+		test_steal();
+	else if (0 == strcmp(test, "sequence"))
+		test_sequence();
+	else
+		fail_msg("unknown test \"%s\"", test);
+}
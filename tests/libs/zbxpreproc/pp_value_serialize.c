@@ -0,0 +1,279 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "libs/zbxpreproc/pp_protocol.h"
+
+/* item value with the data it references */
+typedef struct
+{
+	zbx_preproc_item_value_t	value;
+	AGENT_RESULT			result;
+	zbx_log_t			log;
+	zbx_timespec_t			ts;
+}
+mock_value_t;
+
+static int	mock_get_member(zbx_mock_handle_t object, const char *name, zbx_mock_handle_t *member)
+{
+	return ZBX_MOCK_SUCCESS == zbx_mock_object_member(object, name, member) ? SUCCEED : FAIL;
+}
+
+static zbx_uint64_t	mock_get_uint64(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	handle;
+
+	if (SUCCEED != mock_get_member(object, name, &handle))
+		return 0;
+
+	return zbx_mock_get_object_member_uint64(object, name);
+}
+
+static int	mock_get_int(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	handle;
+
+	if (SUCCEED != mock_get_member(object, name, &handle))
+		return 0;
+
+	return zbx_mock_get_object_member_int(object, name);
+}
+
+static char	*mock_get_str(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	handle;
+
+	if (SUCCEED != mock_get_member(object, name, &handle))
+		return NULL;
+
+	return (char *)zbx_mock_get_object_member_string(object, name);
+}
+
+static void	mock_read_value(zbx_mock_handle_t hvalue, mock_value_t *mv)
+{
+	zbx_mock_handle_t	hts, hresult, hlog, hdbl;
+	zbx_mock_error_t	err;
+
+	memset(mv, 0, sizeof(mock_value_t));
+
+	mv->value.itemid = mock_get_uint64(hvalue, "itemid");
+	mv->value.hostid = mock_get_uint64(hvalue, "hostid");
+	mv->value.item_value_type = (unsigned char)mock_get_int(hvalue, "value_type");
+	mv->value.item_flags = (unsigned char)mock_get_int(hvalue, "flags");
+	mv->value.state = (unsigned char)mock_get_int(hvalue, "state");
+	mv->value.error = mock_get_str(hvalue, "error");
+
+	if (SUCCEED == mock_get_member(hvalue, "ts", &hts))
+	{
+		mv->ts.sec = mock_get_int(hts, "sec");
+		mv->ts.ns = mock_get_int(hts, "ns");
+		mv->value.ts = &mv->ts;
+	}
+
+	if (SUCCEED != mock_get_member(hvalue, "result", &hresult))
+		return;
+
+	mv->result.type = mock_get_int(hresult, "type");
+	mv->result.lastlogsize = mock_get_uint64(hresult, "lastlogsize");
+	mv->result.ui64 = mock_get_uint64(hresult, "ui64");
+	mv->result.mtime = mock_get_int(hresult, "mtime");
+	mv->result.str = mock_get_str(hresult, "str");
+	mv->result.text = mock_get_str(hresult, "text");
+	mv->result.msg = mock_get_str(hresult, "msg");
+
+	if (SUCCEED == mock_get_member(hresult, "dbl", &hdbl) &&
+			ZBX_MOCK_SUCCESS != (err = zbx_mock_float(hdbl, &mv->result.dbl)))
+	{
+		fail_msg("cannot read dbl: %s", zbx_mock_error_string(err));
+	}
+
+	if (SUCCEED == mock_get_member(hresult, "log", &hlog))
+	{
+		mv->log.value = mock_get_str(hlog, "value");
+		mv->log.source = mock_get_str(hlog, "source");
+		mv->log.timestamp = mock_get_int(hlog, "timestamp");
+		mv->log.severity = mock_get_int(hlog, "severity");
+		mv->log.logeventid = mock_get_int(hlog, "logeventid");
+		mv->result.log = &mv->log;
+	}
+
+	mv->value.result = &mv->result;
+}
+
+static void	mock_assert_str_eq(const char *prefix, const char *expected, const char *returned)
+{
+	if (NULL == expected || NULL == returned)
+	{
+		if (expected != returned)
+		{
+			fail_msg("%s: expected \"%s\" while got \"%s\"", prefix, ZBX_NULL2STR(expected),
+					ZBX_NULL2STR(returned));
+		}
+
+		return;
+	}
+
+	zbx_mock_assert_str_eq(prefix, expected, returned);
+}
+
+static void	mock_compare_values(int index, const zbx_preproc_item_value_t *expected,
+		const zbx_preproc_item_value_t *returned)
+{
+	const AGENT_RESULT	*er = expected->result, *rr = returned->result;
+	char			prefix[MAX_STRING_LEN];
+
+#define MOCK_PREFIX(field)	(zbx_snprintf(prefix, sizeof(prefix), "value %d " field, index), prefix)
+
+	zbx_mock_assert_uint64_eq(MOCK_PREFIX("itemid"), expected->itemid, returned->itemid);
+	zbx_mock_assert_uint64_eq(MOCK_PREFIX("hostid"), expected->hostid, returned->hostid);
+	zbx_mock_assert_int_eq(MOCK_PREFIX("value type"), expected->item_value_type, returned->item_value_type);
+	zbx_mock_assert_int_eq(MOCK_PREFIX("flags"), expected->item_flags, returned->item_flags);
+	zbx_mock_assert_int_eq(MOCK_PREFIX("state"), expected->state, returned->state);
+	mock_assert_str_eq(MOCK_PREFIX("error"), expected->error, returned->error);
+
+	if ((NULL == expected->ts) != (NULL == returned->ts))
+		fail_msg("value %d timestamp presence does not match", index);
+
+	if (NULL != expected->ts)
+	{
+		zbx_mock_assert_int_eq(MOCK_PREFIX("ts.sec"), expected->ts->sec, returned->ts->sec);
+		zbx_mock_assert_int_eq(MOCK_PREFIX("ts.ns"), expected->ts->ns, returned->ts->ns);
+	}
+
+	if ((NULL == er) != (NULL == rr))
+		fail_msg("value %d result presence does not match", index);
+
+	if (NULL == er)
+		return;
+
+	zbx_mock_assert_int_eq(MOCK_PREFIX("result type"), er->type, rr->type);
+	zbx_mock_assert_uint64_eq(MOCK_PREFIX("lastlogsize"), er->lastlogsize, rr->lastlogsize);
+	zbx_mock_assert_uint64_eq(MOCK_PREFIX("ui64"), er->ui64, rr->ui64);
+	zbx_mock_assert_int_eq(MOCK_PREFIX("mtime"), er->mtime, rr->mtime);
+
+	/* compare bits to distinguish negative zero */
+	if (0 != memcmp(&er->dbl, &rr->dbl, sizeof(double)))
+		fail_msg("value %d dbl: expected %.17g while got %.17g", index, er->dbl, rr->dbl);
+
+	mock_assert_str_eq(MOCK_PREFIX("str"), er->str, rr->str);
+	mock_assert_str_eq(MOCK_PREFIX("text"), er->text, rr->text);
+	mock_assert_str_eq(MOCK_PREFIX("msg"), er->msg, rr->msg);
+
+	if ((NULL == er->log) != (NULL == rr->log))
+		fail_msg("value %d log presence does not match", index);
+
+	if (NULL != er->log)
+	{
+		mock_assert_str_eq(MOCK_PREFIX("log value"), er->log->value, rr->log->value);
+		mock_assert_str_eq(MOCK_PREFIX("log source"), er->log->source, rr->log->source);
+		zbx_mock_assert_int_eq(MOCK_PREFIX("log timestamp"), er->log->timestamp, rr->log->timestamp);
+		zbx_mock_assert_int_eq(MOCK_PREFIX("log severity"), er->log->severity, rr->log->severity);
+		zbx_mock_assert_int_eq(MOCK_PREFIX("log eventid"), er->log->logeventid, rr->log->logeventid);
+	}
+
+#undef MOCK_PREFIX
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_pp_value_writer_t		*writer;
+	zbx_pp_value_reader_t		reader;
+	zbx_preproc_item_value_t	value;
+	zbx_ipc_message_t		message;
+	zbx_mock_handle_t		hvalues, hvalue;
+	zbx_mock_error_t		err;
+	mock_value_t			*values = NULL;
+	int				i, values_num = 0, ret;
+
+	ZBX_UNUSED(state);
+
+	writer = (zbx_pp_value_writer_t *)zbx_malloc(NULL, sizeof(zbx_pp_value_writer_t));
+	memset(writer, 0, sizeof(zbx_pp_value_writer_t));
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hvalues, &hvalue)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read value: %s", zbx_mock_error_string(err));
+
+		values = (mock_value_t *)zbx_realloc(values, sizeof(mock_value_t) * (size_t)(values_num + 1));
+		mock_read_value(hvalue, &values[values_num++]);
+	}
+
+	/* values reference their own data, so fix the pointers after the array is reallocated */
+	for (i = 0; i < values_num; i++)
+	{
+		if (NULL != values[i].value.ts)
+			values[i].value.ts = &values[i].ts;
+
+		if (NULL != values[i].value.result)
+		{
+			values[i].value.result = &values[i].result;
+
+			if (NULL != values[i].result.log)
+				values[i].result.log = &values[i].log;
+		}
+
+		if (SUCCEED != zbx_pp_value_writer_add(writer, &values[i].value))
+			fail_msg("cannot pack value %d", i);
+	}
+
+	zbx_mock_assert_uint64_eq("interned strings", zbx_mock_get_parameter_uint64("out.strings"),
+			writer->strings_num);
+
+	zbx_pp_value_writer_detach(writer, &message);
+
+	zbx_mock_assert_uint64_eq("packed size", zbx_mock_get_parameter_uint64("out.size"), message.size);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.version"))
+		message.data[0] = (unsigned char)zbx_mock_get_parameter_uint64("in.version");
+
+	ret = zbx_pp_value_reader_init(&reader, message.data, message.size);
+	zbx_mock_assert_result_eq("zbx_pp_value_reader_init()",
+			zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.result")), ret);
+
+	if (SUCCEED == ret)
+	{
+		for (i = 0; SUCCEED == zbx_pp_value_reader_next(&reader, &value); i++)
+		{
+			if (i == values_num)
+				fail_msg("unpacked more than %d values", values_num);
+
+			mock_compare_values(i, &values[i].value, &value);
+
+			zbx_free(value.error);
+
+			if (NULL != value.result)
+				zbx_free_agent_result(value.result);
+		}
+
+		zbx_mock_assert_int_eq("unpacked values", values_num, i);
+	}
+
+	zbx_pp_value_reader_clear(&reader);
+	zbx_free(message.data);
+	zbx_pp_value_writer_clear(writer);
+	zbx_free(writer);
+	zbx_free(values);
+}
@@ -0,0 +1,480 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/*
+ * Preprocessing value serialization benchmark.
+ *
+ * Packs and unpacks batches of item values sent to preprocessing manager with the previous fixed
+ * width field format (size calculation pass and reallocation per value) and with the current
+ * single pass batch format. The values are a mix of numeric, short and long text agent results,
+ * log values and not supported items. Reports packed bytes per value and nanoseconds per value
+ * for packing and unpacking. Unpacked values are compared with the source values.
+ *
+ * Usage: zbx_pp_protocol_bench [values]
+ */
+
+#include "libs/zbxpreproc/pp_protocol.h"
+#include "zbxserialize.h"
+#include "zbx_item_constants.h"
+#include "zbxtime.h"
+
+#define PP_BENCH_VALUES		1000000
+#define PP_BENCH_ROUNDS		5
+
+const char	title_message[] = "zbx_pp_protocol_bench";
+const char	*usage_message[] = {"[values]", NULL};
+const char	*help_message[] = {"Preprocessing value serialization benchmark.", NULL};
+const char	*progname = "zbx_pp_protocol_bench";
+const char	syslog_app_name[] = "zbx_pp_protocol_bench";
+
+typedef struct
+{
+	zbx_preproc_item_value_t	value;
+	AGENT_RESULT			result;
+	zbx_log_t			log;
+	zbx_timespec_t			ts;
+	char				buf[32];
+}
+zbx_pp_bench_value_t;
+
+static void	bench_value_init(zbx_pp_bench_value_t *bv, int i)
+{
+	memset(bv, 0, sizeof(zbx_pp_bench_value_t));
+
+	bv->value.itemid = 100000 + (zbx_uint64_t)i;
+	bv->value.hostid = 10000 + (zbx_uint64_t)i / 50;
+	bv->value.item_value_type = ITEM_VALUE_TYPE_FLOAT;
+	bv->value.state = ITEM_STATE_NORMAL;
+	bv->ts.sec = 1700000000 + i / 1000;
+	bv->ts.ns = (i * 7919) % 1000000000;
+	bv->value.ts = &bv->ts;
+
+	switch (i % 10)
+	{
+		case 0:
+			bv->value.state = ITEM_STATE_NOTSUPPORTED;
+			bv->value.error = "Cannot obtain filesystem information: [2] No such file or directory";
+			bv->value.ts = NULL;
+			return;
+		case 1:
+			bv->value.item_value_type = ITEM_VALUE_TYPE_LOG;
+			bv->log.value = "Oct 16 10:00:00 host sshd[1234]: Accepted publickey for zabbix from 10.0.0.1";
+			bv->log.source = "sshd";
+			bv->log.severity = 1;
+			bv->result.log = &bv->log;
+			bv->result.lastlogsize = 1000 + (zbx_uint64_t)i * 80;
+			bv->result.mtime = 1700000000;
+			bv->result.type = AR_LOG | AR_META;
+			break;
+		case 2:
+			bv->value.item_value_type = ITEM_VALUE_TYPE_UINT64;
+			bv->result.ui64 = (zbx_uint64_t)i * 3;
+			bv->result.type = AR_UINT64;
+			break;
+		case 3:
+			bv->value.item_value_type = ITEM_VALUE_TYPE_STR;
+			bv->result.text = "running";
+			bv->result.type = AR_TEXT;
+			break;
+		case 4:
+			bv->value.item_value_type = ITEM_VALUE_TYPE_TEXT;
+			bv->result.text = "{\"status\":\"ok\",\"uptime\":123456,\"connections\":{\"active\":12,"
+					"\"idle\":3},\"version\":\"7.0.0\",\"node\":\"node-01.example.com\","
+					"\"checks\":[\"disk\",\"memory\",\"network\",\"process\"]}";
+			bv->result.type = AR_TEXT;
+			break;
+		default:
+			zbx_snprintf(bv->buf, sizeof(bv->buf), "%d.%02d", i % 100, i % 97);
+			bv->result.text = bv->buf;
+			bv->result.type = AR_TEXT;
+			break;
+	}
+
+	bv->value.result = &bv->result;
+}
+
+/* the field by field format used before the batch format, packing calculates value size */
+/* and reallocates the batch for every value                                               */
+static void	legacy_pack_value(zbx_ipc_message_t *message, const zbx_preproc_item_value_t *value)
+{
+	zbx_uint32_t	size = 0, error_len, str_len, text_len, msg_len, log_value_len = 0, log_source_len = 0;
+	unsigned char	*ptr, ts_marker = (NULL != value->ts), result_marker = (NULL != value->result), log_marker = 0;
+	const char	*error = value->error, *str, *text, *msg, *log_value = NULL, *log_source = NULL;
+
+	size += 8 + 8 + 3;
+	zbx_serialize_prepare_str_len(size, error, error_len);
+	size += 1 + (0 != ts_marker ? 8 : 0) + 1;
+
+	if (0 != result_marker)
+	{
+		str = value->result->str;
+		text = value->result->text;
+		msg = value->result->msg;
+
+		size += 8 + 8 + 8;
+		zbx_serialize_prepare_str_len(size, str, str_len);
+		zbx_serialize_prepare_str_len(size, text, text_len);
+		zbx_serialize_prepare_str_len(size, msg, msg_len);
+		size += 4 + 4 + 1;
+
+		if (0 != (log_marker = (NULL != value->result->log)))
+		{
+			log_value = value->result->log->value;
+			log_source = value->result->log->source;
+			zbx_serialize_prepare_str_len(size, log_value, log_value_len);
+			zbx_serialize_prepare_str_len(size, log_source, log_source_len);
+			size += 4 + 4 + 4;
+		}
+	}
+
+	message->data = (unsigned char *)zbx_realloc(message->data, message->size + size);
+	ptr = message->data + message->size;
+	message->size += size;
+
+	ptr += zbx_serialize_uint64(ptr, value->itemid);
+	ptr += zbx_serialize_uint64(ptr, value->hostid);
+	ptr += zbx_serialize_char(ptr, value->item_value_type);
+	ptr += zbx_serialize_char(ptr, value->item_flags);
+	ptr += zbx_serialize_char(ptr, value->state);
+	ptr += zbx_serialize_str(ptr, error, error_len);
+	ptr += zbx_serialize_char(ptr, ts_marker);
+
+	if (0 != ts_marker)
+	{
+		ptr += zbx_serialize_int(ptr, value->ts->sec);
+		ptr += zbx_serialize_int(ptr, value->ts->ns);
+	}
+
+	ptr += zbx_serialize_char(ptr, result_marker);
+
+	if (0 == result_marker)
+		return;
+
+	ptr += zbx_serialize_uint64(ptr, value->result->lastlogsize);
+	ptr += zbx_serialize_uint64(ptr, value->result->ui64);
+	ptr += zbx_serialize_double(ptr, value->result->dbl);
+	ptr += zbx_serialize_str(ptr, str, str_len);
+	ptr += zbx_serialize_str(ptr, text, text_len);
+	ptr += zbx_serialize_str(ptr, msg, msg_len);
+	ptr += zbx_serialize_int(ptr, value->result->type);
+	ptr += zbx_serialize_int(ptr, value->result->mtime);
+	ptr += zbx_serialize_char(ptr, log_marker);
+
+	if (0 != log_marker)
+	{
+		ptr += zbx_serialize_str(ptr, log_value, log_value_len);
+		ptr += zbx_serialize_str(ptr, log_source, log_source_len);
+		ptr += zbx_serialize_int(ptr, value->result->log->timestamp);
+		ptr += zbx_serialize_int(ptr, value->result->log->severity);
+		(void)zbx_serialize_int(ptr, value->result->log->logeventid);
+	}
+}
+
+static zbx_uint32_t	legacy_unpack_value(zbx_preproc_item_value_t *value, const unsigned char *data)
+{
+	zbx_uint32_t		value_len;
+	const unsigned char	*offset = data;
+	unsigned char		ts_marker, result_marker, log_marker;
+
+	offset += zbx_deserialize_uint64(offset, &value->itemid);
+	offset += zbx_deserialize_uint64(offset, &value->hostid);
+	offset += zbx_deserialize_char(offset, &value->item_value_type);
+	offset += zbx_deserialize_char(offset, &value->item_flags);
+	offset += zbx_deserialize_char(offset, &value->state);
+	offset += zbx_deserialize_str(offset, &value->error, value_len);
+	offset += zbx_deserialize_char(offset, &ts_marker);
+
+	value->ts = NULL;
+	value->result = NULL;
+
+	if (0 != ts_marker)
+	{
+		value->ts = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+		offset += zbx_deserialize_int(offset, &value->ts->sec);
+		offset += zbx_deserialize_int(offset, &value->ts->ns);
+	}
+
+	offset += zbx_deserialize_char(offset, &result_marker);
+
+	if (0 != result_marker)
+	{
+		AGENT_RESULT	*result;
+
+		result = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT));
+		result->bin = NULL;
+		result->log = NULL;
+
+		offset += zbx_deserialize_uint64(offset, &result->lastlogsize);
+		offset += zbx_deserialize_uint64(offset, &result->ui64);
+		offset += zbx_deserialize_double(offset, &result->dbl);
+		offset += zbx_deserialize_str(offset, &result->str, value_len);
+		offset += zbx_deserialize_str(offset, &result->text, value_len);
+		offset += zbx_deserialize_str(offset, &result->msg, value_len);
+		offset += zbx_deserialize_int(offset, &result->type);
+		offset += zbx_deserialize_int(offset, &result->mtime);
+		offset += zbx_deserialize_char(offset, &log_marker);
+
+		if (0 != log_marker)
+		{
+			result->log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+			offset += zbx_deserialize_str(offset, &result->log->value, value_len);
+			offset += zbx_deserialize_str(offset, &result->log->source, value_len);
+			offset += zbx_deserialize_int(offset, &result->log->timestamp);
+			offset += zbx_deserialize_int(offset, &result->log->severity);
+			offset += zbx_deserialize_int(offset, &result->log->logeventid);
+		}
+
+		value->result = result;
+	}
+
+	return (zbx_uint32_t)(offset - data);
+}
+
+static int	str_equal(const char *s1, const char *s2)
+{
+	if (NULL == s1 || NULL == s2)
+		return s1 == s2;
+
+	return 0 == strcmp(s1, s2);
+}
+
+static int	value_equal(const zbx_preproc_item_value_t *v1, const zbx_preproc_item_value_t *v2)
+{
+	if (v1->itemid != v2->itemid || v1->hostid != v2->hostid || v1->item_value_type != v2->item_value_type ||
+			v1->item_flags != v2->item_flags || v1->state != v2->state || !str_equal(v1->error, v2->error))
+	{
+		return FAIL;
+	}
+
+	if ((NULL == v1->ts) != (NULL == v2->ts) || (NULL != v1->ts && (v1->ts->sec != v2->ts->sec ||
+			v1->ts->ns != v2->ts->ns)))
+	{
+		return FAIL;
+	}
+
+	if ((NULL == v1->result) != (NULL == v2->result))
+		return FAIL;
+
+	if (NULL == v1->result)
+		return SUCCEED;
+
+	if (v1->result->lastlogsize != v2->result->lastlogsize || v1->result->ui64 != v2->result->ui64 ||
+			v1->result->dbl != v2->result->dbl || v1->result->type != v2->result->type ||
+			v1->result->mtime != v2->result->mtime || !str_equal(v1->result->str, v2->result->str) ||
+			!str_equal(v1->result->text, v2->result->text) || !str_equal(v1->result->msg, v2->result->msg))
+	{
+		return FAIL;
+	}
+
+	if ((NULL == v1->result->log) != (NULL == v2->result->log))
+		return FAIL;
+
+	if (NULL != v1->result->log && (!str_equal(v1->result->log->value, v2->result->log->value) ||
+			!str_equal(v1->result->log->source, v2->result->log->source) ||
+			v1->result->log->timestamp != v2->result->log->timestamp ||
+			v1->result->log->severity != v2->result->log->severity ||
+			v1->result->log->logeventid != v2->result->log->logeventid))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static void	value_clear(zbx_preproc_item_value_t *value)
+{
+	zbx_free(value->error);
+	zbx_free(value->ts);
+
+	if (NULL != value->result)
+	{
+		zbx_free_agent_result(value->result);
+		zbx_free(value->result);
+	}
+}
+
+/* timestamp and agent result of values unpacked from batch belong to the reader */
+static void	batch_value_clear(zbx_preproc_item_value_t *value)
+{
+	zbx_free(value->error);
+
+	if (NULL != value->result)
+		zbx_free_agent_result(value->result);
+}
+
+static int	bench_fields(zbx_pp_bench_value_t *values, int values_num, zbx_ipc_message_t *batches, int batches_num,
+		zbx_uint64_t *size, double *pack_time, double *unpack_time)
+{
+	double	start;
+	int	i, j, ret = SUCCEED;
+
+	start = zbx_time();
+
+	for (i = 0; i < batches_num; i++)
+	{
+		zbx_ipc_message_init(&batches[i]);
+
+		for (j = i * ZBX_PREPROCESSING_BATCH_SIZE; j < values_num && j < (i + 1) * ZBX_PREPROCESSING_BATCH_SIZE;
+				j++)
+		{
+			legacy_pack_value(&batches[i], &values[j].value);
+		}
+	}
+
+	*pack_time = zbx_time() - start;
+	start = zbx_time();
+
+	for (i = 0, j = 0, *size = 0; i < batches_num; i++)
+	{
+		zbx_uint32_t	offset = 0;
+
+		*size += batches[i].size;
+
+		while (offset < batches[i].size)
+		{
+			zbx_preproc_item_value_t	value;
+
+			offset += legacy_unpack_value(&value, batches[i].data + offset);
+
+			if (SUCCEED != value_equal(&value, &values[j++].value))
+				ret = FAIL;
+
+			value_clear(&value);
+		}
+
+		zbx_ipc_message_clean(&batches[i]);
+	}
+
+	*unpack_time = zbx_time() - start;
+
+	return j == values_num ? ret : FAIL;
+}
+
+static int	bench_batch(zbx_pp_bench_value_t *values, int values_num, zbx_ipc_message_t *batches, int batches_num,
+		zbx_uint64_t *size, double *pack_time, double *unpack_time)
+{
+	double	start;
+	int	i, j, ret = SUCCEED;
+
+	start = zbx_time();
+
+	for (i = 0; i < batches_num; i++)
+	{
+		zbx_pp_value_writer_t	writer = {0};
+
+		for (j = i * ZBX_PREPROCESSING_BATCH_SIZE; j < values_num && j < (i + 1) * ZBX_PREPROCESSING_BATCH_SIZE;
+				j++)
+		{
+			if (SUCCEED != zbx_pp_value_writer_add(&writer, &values[j].value))
+				ret = FAIL;
+		}
+
+		zbx_pp_value_writer_detach(&writer, &batches[i]);
+	}
+
+	*pack_time = zbx_time() - start;
+	start = zbx_time();
+
+	for (i = 0, j = 0, *size = 0; i < batches_num; i++)
+	{
+		zbx_pp_value_reader_t		reader;
+		zbx_preproc_item_value_t	value;
+
+		*size += batches[i].size;
+
+		if (SUCCEED != zbx_pp_value_reader_init(&reader, batches[i].data, batches[i].size))
+		{
+			ret = FAIL;
+			continue;
+		}
+
+		while (SUCCEED == zbx_pp_value_reader_next(&reader, &value))
+		{
+			if (SUCCEED != value_equal(&value, &values[j++].value))
+				ret = FAIL;
+
+			batch_value_clear(&value);
+		}
+
+		zbx_pp_value_reader_clear(&reader);
+		zbx_ipc_message_clean(&batches[i]);
+	}
+
+	*unpack_time = zbx_time() - start;
+
+	return j == values_num ? ret : FAIL;
+}
+
+int	main(int argc, char **argv)
+{
+	static const char	*names[] = {"fields", "batch"};
+	zbx_pp_bench_value_t	*values;
+	zbx_ipc_message_t	*batches;
+	int			i, values_num = PP_BENCH_VALUES, batches_num, ret = EXIT_SUCCESS;
+
+	if (1 < argc)
+		values_num = atoi(argv[1]);
+
+	batches_num = (values_num + ZBX_PREPROCESSING_BATCH_SIZE - 1) / ZBX_PREPROCESSING_BATCH_SIZE;
+	values = (zbx_pp_bench_value_t *)zbx_malloc(NULL, sizeof(zbx_pp_bench_value_t) * (size_t)values_num);
+	batches = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t) * (size_t)batches_num);
+
+	for (i = 0; i < values_num; i++)
+		bench_value_init(&values[i], i);
+
+	printf("%-8s %12s %12s %12s\n", "format", "bytes/value", "pack ns", "unpack ns");
+
+	for (i = 0; i < (int)ARRSIZE(names); i++)
+	{
+		zbx_uint64_t	size;
+		double		pack_time, unpack_time, pack_min = 0, unpack_min = 0;
+		int		round;
+
+		/* the best of several rounds is reported to reduce scheduling noise */
+		for (round = 0; round < PP_BENCH_ROUNDS; round++)
+		{
+			int	rc;
+
+			if (0 == i)
+				rc = bench_fields(values, values_num, batches, batches_num, &size, &pack_time, &unpack_time);
+			else
+				rc = bench_batch(values, values_num, batches, batches_num, &size, &pack_time, &unpack_time);
+
+			if (SUCCEED != rc)
+			{
+				printf("MISMATCH: unpacked %s values differ from source values\n", names[i]);
+				ret = EXIT_FAILURE;
+			}
+
+			if (0 == round || pack_time < pack_min)
+				pack_min = pack_time;
+
+			if (0 == round || unpack_time < unpack_min)
+				unpack_min = unpack_time;
+		}
+
+		printf("%-8s %12.1f %12.1f %12.1f\n", names[i], (double)size / values_num, pack_min * 1e9 / values_num,
+				unpack_min * 1e9 / values_num);
+	}
+
+	zbx_free(batches);
+	zbx_free(values);
+
+	return ret;
+}
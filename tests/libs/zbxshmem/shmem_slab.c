@@ -0,0 +1,176 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxshmem.h"
+
+static zbx_uint64_t	slab_test_object_size(zbx_uint64_t size)
+{
+	return (size + 7) & ~(zbx_uint64_t)7;
+}
+
+static int	slab_test_class_index(const zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	int	i;
+
+	size = slab_test_object_size(size);
+
+	for (i = 0; i < info->slab_classes_num; i++)
+	{
+		if (info->slab_classes[i].size == size)
+			return i;
+	}
+
+	fail_msg("cannot find slab class for object size " ZBX_FS_UI64, size);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks slab class counters and that memory of free slab objects   *
+ *          is counted as free memory                                         *
+ *                                                                            *
+ * Comments: The shared memory must contain only slab allocations of the      *
+ *           checked class.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	slab_test_check(const zbx_shmem_info_t *info, int index, zbx_uint64_t used_num,
+		zbx_uint64_t free_size_init)
+{
+	const zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[index];
+	zbx_shmem_stats_t		stats;
+	zbx_uint64_t			used_size;
+
+	zbx_shmem_get_stats(info, &stats);
+
+	zbx_mock_assert_uint64_eq("used objects", used_num, stats.slab_classes[index].used_num);
+	zbx_mock_assert_uint64_eq("free objects", stats.slab_classes[index].slabs_num * slab_class->objects_num -
+			used_num, stats.slab_classes[index].free_num);
+
+	used_size = stats.slab_classes[index].slabs_num * slab_class->slab_size -
+			stats.slab_classes[index].free_num * slab_class->size;
+
+	zbx_mock_assert_uint64_eq("used size", used_size, stats.used_size);
+
+	/* every slab chunk has two size fields */
+	zbx_mock_assert_uint64_eq("free size", free_size_init - used_size - stats.slab_classes[index].slabs_num *
+			2 * sizeof(zbx_uint64_t), stats.free_size);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_shmem_info_t	*info;
+	char			*error = NULL;
+	zbx_mock_handle_t	hclasses, hclass;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		size, object_size, count, free_size_init, other_size, i, reused = 0;
+	void			**objects, *ptr;
+	int			index;
+
+	ZBX_UNUSED(state);
+
+	size = zbx_mock_get_parameter_uint64("in.size");
+	object_size = zbx_mock_get_parameter_uint64("in.object");
+	count = zbx_mock_get_parameter_uint64("in.count");
+	other_size = zbx_mock_get_parameter_uint64("in.other");
+
+	if (SUCCEED != zbx_shmem_create(&info, size, "slab test", "SlabTestSize", 0, &error))
+		fail_msg("cannot create shared memory: %s", error);
+
+	hclasses = zbx_mock_get_parameter_handle("in.classes");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hclasses, &hclass))))
+	{
+		zbx_uint64_t	class_size;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hclass, &class_size)))
+			fail_msg("Cannot read vector member: %s", zbx_mock_error_string(err));
+
+		zbx_shmem_add_slab_class(info, class_size);
+	}
+
+	index = slab_test_class_index(info, object_size);
+	free_size_init = info->free_size;
+
+	objects = (void **)zbx_malloc(NULL, sizeof(void *) * count);
+
+	/* allocate objects */
+	for (i = 0; i < count; i++)
+	{
+		objects[i] = zbx_shmem_malloc(info, NULL, object_size);
+		memset(objects[i], 0xff, object_size);
+	}
+
+	slab_test_check(info, index, count, free_size_init);
+
+	/* free every other object */
+	for (i = 0; i < count; i += 2)
+		__zbx_shmem_free(__FILE__, __LINE__, info, objects[i]);
+
+	slab_test_check(info, index, count / 2, free_size_init);
+
+	/* freed objects must be reused without allocating new slabs */
+	for (i = 0; i < count; i += 2)
+	{
+		zbx_uint64_t	j;
+
+		ptr = zbx_shmem_malloc(info, NULL, object_size);
+
+		for (j = 0; j < count; j += 2)
+		{
+			if (objects[j] == ptr)
+			{
+				reused++;
+				break;
+			}
+		}
+
+		objects[i] = ptr;
+	}
+
+	zbx_mock_assert_uint64_eq("reused objects", (count + 1) / 2, reused);
+	slab_test_check(info, index, count, free_size_init);
+
+	/* allocations of other sizes must not be served from the slab class */
+	ptr = zbx_shmem_malloc(info, NULL, other_size);
+	zbx_mock_assert_uint64_eq("used objects after other allocation", count,
+			info->slab_classes[index].used_num);
+	__zbx_shmem_free(__FILE__, __LINE__, info, ptr);
+
+	/* reallocating object to other size must move it out of slab */
+	objects[0] = zbx_shmem_realloc(info, objects[0], other_size);
+	zbx_mock_assert_uint64_eq("used objects after reallocation", count - 1,
+			info->slab_classes[index].used_num);
+	__zbx_shmem_free(__FILE__, __LINE__, info, objects[0]);
+
+	/* free all objects, only one slab worth of free objects must be kept */
+	for (i = 1; i < count; i++)
+		__zbx_shmem_free(__FILE__, __LINE__, info, objects[i]);
+
+	zbx_mock_assert_uint64_eq("slabs left", 1, info->slab_classes[index].slabs_num);
+	slab_test_check(info, index, 0, free_size_init);
+
+	zbx_free(objects);
+	zbx_shmem_destroy(info);
+}
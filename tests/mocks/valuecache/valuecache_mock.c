@@ -48,6 +48,7 @@ void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
 int	__wrap_zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error);
 void	__wrap_zbx_shmem_destroy(zbx_shmem_info_t *info);
+void	__wrap_zbx_shmem_add_slab_class(zbx_shmem_info_t *info, size_t size);
 void	*__wrap___zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size);
 void	*__wrap___zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, void *old, size_t size);
 void	__wrap___zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *ptr);
@@ -538,6 +539,12 @@ void	__wrap_zbx_shmem_destroy(zbx_shmem_info_t *info)
 	zbx_free(info);
 }
 
+void	__wrap_zbx_shmem_add_slab_class(zbx_shmem_info_t *info, size_t size)
+{
+	ZBX_UNUSED(info);
+	ZBX_UNUSED(size);
+}
+
 void	*__wrap___zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size)
 {
 	size_t	*psize;
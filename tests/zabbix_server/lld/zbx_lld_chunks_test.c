@@ -0,0 +1,144 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/lld/lld_manager.c"
+
+static int	mock_row_is_object(int index, int other_nth)
+{
+	return 0 == other_nth || 0 != (index + 1) % other_nth ? SUCCEED : FAIL;
+}
+
+/* rows have sequential identifiers, every nth element of rows array is not an object if requested */
+static char	*mock_build_value(int rows_num, int other_nth, const char *format)
+{
+	char	*value = NULL;
+	size_t	value_alloc = 0, value_offset = 0;
+	int	i;
+
+	if (0 == strcmp(format, "data"))
+		zbx_strcpy_alloc(&value, &value_alloc, &value_offset, "{\"data\":");
+
+	zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, '[');
+
+	for (i = 0; i < rows_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, ',');
+
+		if (SUCCEED == mock_row_is_object(i, other_nth))
+			zbx_snprintf_alloc(&value, &value_alloc, &value_offset, "{\"{#ID}\":\"%d\"}", i);
+		else
+			zbx_snprintf_alloc(&value, &value_alloc, &value_offset, "%d", i);
+	}
+
+	zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, ']');
+
+	if (0 == strcmp(format, "data"))
+		zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, '}');
+	else if (0 == strcmp(format, "invalid"))
+		value[value_offset - 1] = '\0';
+
+	return value;
+}
+
+/* checks that chunk has the rows following the rows of the previous chunk */
+static void	mock_check_chunk(int index, const char *chunk, int expected_rows_num, int other_nth, int *id)
+{
+	struct zbx_json_parse	jp, jp_row;
+	const char		*p = NULL;
+	char			buf[MAX_ID_LEN + 1], prefix[MAX_STRING_LEN];
+	int			rows_num = 0;
+
+	if (SUCCEED != zbx_json_open(chunk, &jp) || '[' != *jp.start)
+		fail_msg("chunk %d is not JSON array: %s", index, chunk);
+
+	while (NULL != (p = zbx_json_next(&jp, p)))
+	{
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+			fail_msg("chunk %d row %d is not JSON object", index, rows_num);
+
+		if (SUCCEED != zbx_json_value_by_name(&jp_row, "{#ID}", buf, sizeof(buf), NULL))
+			fail_msg("chunk %d row %d has no identifier", index, rows_num);
+
+		while (SUCCEED != mock_row_is_object(*id, other_nth))
+			(*id)++;
+
+		zbx_snprintf(prefix, sizeof(prefix), "chunk %d row %d identifier", index, rows_num);
+		zbx_mock_assert_int_eq(prefix, *id, atoi(buf));
+
+		rows_num++;
+		(*id)++;
+	}
+
+	zbx_snprintf(prefix, sizeof(prefix), "chunk %d rows", index);
+	zbx_mock_assert_int_eq(prefix, expected_rows_num, rows_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_data_t		data = {0};
+	zbx_lld_chunks_t	*chunks;
+	zbx_mock_handle_t	hchunks, hrows;
+	zbx_mock_error_t	err;
+	const char		*format = "array";
+	zbx_uint64_t		rows_num;
+	int			i, id = 0, other_nth = 0;
+
+	ZBX_UNUSED(state);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.format"))
+		format = zbx_mock_get_parameter_string("in.format");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.other"))
+		other_nth = (int)zbx_mock_get_parameter_uint64("in.other");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.error"))
+		data.error = zbx_strdup(NULL, zbx_mock_get_parameter_string("in.error"));
+
+	data.itemid = 1;
+	data.value = mock_build_value((int)zbx_mock_get_parameter_uint64("in.rows"), other_nth, format);
+
+	chunks = lld_data_split(&data, (int)zbx_mock_get_parameter_uint64("in.workers"));
+	hchunks = zbx_mock_get_parameter_handle("out.chunks");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hchunks, &hrows)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hrows, &rows_num)))
+			fail_msg("cannot read chunk %d rows: %s", i, zbx_mock_error_string(err));
+
+		if (NULL == chunks || i >= chunks->values.values_num)
+			fail_msg("expected chunk %d was not made", i);
+
+		mock_check_chunk(i, chunks->values.values[i], (int)rows_num, other_nth, &id);
+	}
+
+	zbx_mock_assert_int_eq("chunks", i, NULL == chunks ? 0 : chunks->values.values_num);
+
+	if (NULL != chunks)
+		lld_chunks_free(chunks);
+
+	zbx_free(data.value);
+	zbx_free(data.error);
+}
@@ -0,0 +1,204 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/lld/lld.c"
+
+static int	mock_str_to_evaltype(const char *str)
+{
+	if (0 == strcmp(str, "AND_OR"))
+		return ZBX_CONDITION_EVAL_TYPE_AND_OR;
+
+	if (0 == strcmp(str, "AND"))
+		return ZBX_CONDITION_EVAL_TYPE_AND;
+
+	if (0 == strcmp(str, "OR"))
+		return ZBX_CONDITION_EVAL_TYPE_OR;
+
+	if (0 == strcmp(str, "EXPRESSION"))
+		return ZBX_CONDITION_EVAL_TYPE_EXPRESSION;
+
+	/* unsupported evaluation type */
+	if (0 == strcmp(str, "UNKNOWN"))
+		return ZBX_CONDITION_EVAL_TYPE_EXPRESSION + 1;
+
+	fail_msg("unknown filter evaluation type \"%s\"", str);
+
+	return FAIL;
+}
+
+static unsigned char	mock_str_to_operator(const char *str)
+{
+	if (0 == strcmp(str, "REGEXP"))
+		return ZBX_CONDITION_OPERATOR_REGEXP;
+
+	if (0 == strcmp(str, "NOT_REGEXP"))
+		return ZBX_CONDITION_OPERATOR_NOT_REGEXP;
+
+	if (0 == strcmp(str, "EXIST"))
+		return ZBX_CONDITION_OPERATOR_EXIST;
+
+	if (0 == strcmp(str, "NOT_EXIST"))
+		return ZBX_CONDITION_OPERATOR_NOT_EXIST;
+
+	fail_msg("unknown condition operator \"%s\"", str);
+
+	return 0;
+}
+
+static void	mock_read_filter(zbx_lld_filter_t *filter)
+{
+	zbx_mock_handle_t	hconditions, hcondition;
+	zbx_mock_error_t	err;
+
+	filter->evaltype = mock_str_to_evaltype(zbx_mock_get_parameter_string("in.evaltype"));
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.expression"))
+		filter->expression = zbx_strdup(NULL, zbx_mock_get_parameter_string("in.expression"));
+
+	hconditions = zbx_mock_get_parameter_handle("in.conditions");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hconditions, &hcondition)))
+	{
+		lld_condition_t	*condition;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read condition: %s", zbx_mock_error_string(err));
+
+		condition = (lld_condition_t *)zbx_malloc(NULL, sizeof(lld_condition_t));
+		condition->id = zbx_mock_get_object_member_uint64(hcondition, "id");
+		condition->macro = zbx_strdup(NULL, zbx_mock_get_object_member_string(hcondition, "macro"));
+		condition->regexp = zbx_strdup(NULL, zbx_mock_get_object_member_string(hcondition, "regexp"));
+		condition->op = mock_str_to_operator(zbx_mock_get_object_member_string(hcondition, "operator"));
+		condition->column = -1;
+		condition->compiled = NULL;
+		zbx_vector_expression_create(&condition->regexps);
+
+		zbx_vector_ptr_append(&filter->conditions, condition);
+	}
+
+	/* the same as lld_filter_load() */
+	if (ZBX_CONDITION_EVAL_TYPE_AND_OR == filter->evaltype)
+		zbx_vector_ptr_sort(&filter->conditions, lld_condition_compare_by_macro);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluates filter by building and parsing the filter expression    *
+ *          like before filter compilation                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_filter_evaluate_full(const zbx_lld_filter_t *filter, lld_row_cache_t *cache)
+{
+	char	*info = NULL;
+	int	ret;
+
+	if (ZBX_CONDITION_EVAL_TYPE_EXPRESSION == filter->evaltype)
+		ret = filter_evaluate_expression(filter, cache, &info);
+	else
+		ret = filter_evaluate_and_or_andor(filter, cache, &info);
+
+	zbx_free(info);
+
+	return ret;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_filter_t		filter;
+	lld_row_cache_t			cache;
+	zbx_vector_lld_macro_path_t	lld_macro_paths;
+	zbx_mock_handle_t		hrows, hrow, hinfo;
+	zbx_mock_error_t		err;
+	int				i;
+
+	ZBX_UNUSED(state);
+
+	lld_filter_init(&filter);
+	lld_row_cache_init(&cache);
+	zbx_vector_lld_macro_path_create(&lld_macro_paths);
+
+	mock_read_filter(&filter);
+	lld_filter_compile(&filter, &cache, &lld_macro_paths);
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	/* rows are evaluated with the same row cache to check that values of the previous row are not used */
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrows, &hrow)); i++)
+	{
+		struct zbx_json_parse	jp_row;
+		const char		*row;
+		char			*info = NULL, prefix[64];
+		int			ret, expected_ret, result, expected_result;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read row: %s", zbx_mock_error_string(err));
+
+		row = zbx_mock_get_object_member_string(hrow, "row");
+
+		if (SUCCEED != zbx_json_open(row, &jp_row))
+			fail_msg("invalid row \"%s\": %s", row, zbx_json_strerror());
+
+		lld_row_cache_set_row(&cache, &jp_row);
+
+		expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hrow, "plan"));
+		expected_result = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hrow, "result"));
+
+		zbx_snprintf(prefix, sizeof(prefix), "row %d filter_evaluate_plan()", i);
+		ret = filter_evaluate_plan(&filter, &cache, &result);
+		zbx_mock_assert_result_eq(prefix, expected_ret, ret);
+
+		/* evaluated plan must give the same result as full evaluation */
+		if (SUCCEED == ret)
+		{
+			zbx_snprintf(prefix, sizeof(prefix), "row %d plan result", i);
+			zbx_mock_assert_result_eq(prefix, expected_result, result);
+
+			zbx_snprintf(prefix, sizeof(prefix), "row %d full evaluation result", i);
+			zbx_mock_assert_result_eq(prefix, result, mock_filter_evaluate_full(&filter, &cache));
+		}
+
+		zbx_snprintf(prefix, sizeof(prefix), "row %d filter_evaluate()", i);
+		zbx_mock_assert_result_eq(prefix, expected_result, filter_evaluate(&filter, &cache, &info));
+
+		/* only the fallback to full evaluation reports why filter could not be applied accurately */
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrow, "info", &hinfo))
+		{
+			const char	*expected_info;
+
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hinfo, &expected_info)))
+				fail_msg("cannot read info: %s", zbx_mock_error_string(err));
+
+			zbx_snprintf(prefix, sizeof(prefix), "row %d filter_evaluate() info", i);
+			zbx_mock_assert_str_eq(prefix, expected_info, ZBX_NULL2EMPTY_STR(info));
+		}
+		else if (NULL != info)
+			fail_msg("row %d unexpected filter_evaluate() info: %s", i, info);
+
+		zbx_free(info);
+	}
+
+	zbx_vector_lld_macro_path_destroy(&lld_macro_paths);
+	lld_row_cache_clean(&cache);
+	lld_filter_clean(&filter);
+}
@@ -0,0 +1,179 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/lld/lld.c"
+
+static unsigned char	mock_str_to_item_state(const char *str)
+{
+	if (0 == strcmp(str, "NORMAL"))
+		return ITEM_STATE_NORMAL;
+
+	if (0 == strcmp(str, "NOTSUPPORTED"))
+		return ITEM_STATE_NOTSUPPORTED;
+
+	fail_msg("unknown item state \"%s\"", str);
+
+	return ITEM_STATE_NORMAL;
+}
+
+/* overrides have empty filters, so they match all rows */
+static void	mock_read_overrides(zbx_mock_handle_t hrun, zbx_vector_lld_override_t *overrides)
+{
+	zbx_mock_handle_t	hoverrides, hoverride, hops, hop;
+	zbx_mock_error_t	err;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrun, "overrides", &hoverrides))
+		return;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hoverrides, &hoverride)))
+	{
+		zbx_lld_override_t	*override;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read override: %s", zbx_mock_error_string(err));
+
+		override = (zbx_lld_override_t *)zbx_malloc(NULL, sizeof(zbx_lld_override_t));
+		override->overrideid = zbx_mock_get_object_member_uint64(hoverride, "id");
+		override->step = overrides->values_num + 1;
+		override->stop = 0;
+		lld_filter_init(&override->filter);
+		zbx_vector_lld_override_operation_create(&override->override_operations);
+		zbx_vector_lld_override_append(overrides, override);
+
+		hops = zbx_mock_get_object_member_handle(hoverride, "operations");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hops, &hop)))
+		{
+			zbx_lld_override_operation_t	*op;
+
+			if (ZBX_MOCK_SUCCESS != err)
+				fail_msg("cannot read override operation: %s", zbx_mock_error_string(err));
+
+			op = (zbx_lld_override_operation_t *)zbx_malloc(NULL, sizeof(zbx_lld_override_operation_t));
+			memset(op, 0, sizeof(zbx_lld_override_operation_t));
+			op->override_operationid = zbx_mock_get_object_member_uint64(hop, "id");
+			op->overrideid = override->overrideid;
+			op->value = zbx_strdup(NULL, zbx_mock_get_object_member_string(hop, "value"));
+			op->discover = (unsigned char)zbx_mock_get_object_member_uint64(hop, "discover");
+			zbx_vector_db_tag_ptr_create(&op->tags);
+			zbx_vector_uint64_create(&op->templateids);
+
+			zbx_vector_lld_override_operation_append(&override->override_operations, op);
+		}
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hruns, hrun, hstate;
+	zbx_mock_error_t	err;
+	zbx_lld_rule_stats_t	prev;
+	int			period, i;
+
+	ZBX_UNUSED(state);
+
+	period = (int)zbx_mock_get_parameter_uint64("in.period");
+	hruns = zbx_mock_get_parameter_handle("in.runs");
+	memset(&prev, 0, sizeof(prev));
+
+	/* emulates processing of discovery rule values received one after another */
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hruns, &hrun)); i++)
+	{
+		zbx_lld_filter_t		filter;
+		zbx_vector_lld_macro_path_t	lld_macro_paths;
+		zbx_vector_lld_override_t	overrides;
+		zbx_vector_lld_row_t		lld_rows;
+		zbx_lld_rule_stats_t		stats;
+		zbx_uint64_t			fingerprint, revision;
+		unsigned char			item_state = ITEM_STATE_NORMAL;
+		char				*info = NULL, *error = NULL, prefix[64];
+		const char			*value;
+		int				lifetime, clock, ret, expected_ret, j, unchanged = 0;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read run: %s", zbx_mock_error_string(err));
+
+		value = zbx_mock_get_object_member_string(hrun, "value");
+		revision = zbx_mock_get_object_member_uint64(hrun, "revision");
+		lifetime = (int)zbx_mock_get_object_member_uint64(hrun, "lifetime");
+		clock = (int)zbx_mock_get_object_member_uint64(hrun, "clock");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrun, "state", &hstate))
+		{
+			const char	*str;
+
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hstate, &str)))
+				fail_msg("cannot read state: %s", zbx_mock_error_string(err));
+
+			item_state = mock_str_to_item_state(str);
+		}
+
+		lld_filter_init(&filter);
+		zbx_vector_lld_macro_path_create(&lld_macro_paths);
+		zbx_vector_lld_override_create(&overrides);
+		zbx_vector_lld_row_create(&lld_rows);
+		memset(&stats, 0, sizeof(stats));
+
+		mock_read_overrides(hrun, &overrides);
+
+		if (SUCCEED != lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &overrides, &stats, &info,
+				&error))
+		{
+			fail_msg("run %d cannot get discovery rows: %s", i, error);
+		}
+
+		fingerprint = lld_rule_fingerprint(&lld_macro_paths, &overrides, lifetime, revision);
+
+		expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hrun, "skip"));
+		ret = lld_rows_diff(&lld_rows, fingerprint, item_state, lifetime, period, (time_t)clock, &prev, &stats);
+
+		zbx_snprintf(prefix, sizeof(prefix), "run %d lld_rows_diff()", i);
+		zbx_mock_assert_result_eq(prefix, expected_ret, ret);
+
+		for (j = 0; j < lld_rows.values_num; j++)
+		{
+			if (0 != lld_rows.values[j]->unchanged)
+				unchanged++;
+		}
+
+		zbx_snprintf(prefix, sizeof(prefix), "run %d unchanged rows", i);
+		zbx_mock_assert_int_eq(prefix, (int)zbx_mock_get_object_member_uint64(hrun, "unchanged"), unchanged);
+		zbx_mock_assert_int_eq(prefix, unchanged, stats.rows_unchanged);
+
+		/* fingerprints are kept by manager for the next value after successful processing */
+		zbx_free(prev.row_fingerprints);
+		prev = stats;
+
+		zbx_free(info);
+		zbx_free(error);
+		zbx_vector_lld_row_clear_ext(&lld_rows, lld_row_free);
+		zbx_vector_lld_row_destroy(&lld_rows);
+		zbx_vector_lld_override_clear_ext(&overrides, lld_override_free);
+		zbx_vector_lld_override_destroy(&overrides);
+		zbx_vector_lld_macro_path_destroy(&lld_macro_paths);
+		lld_filter_clean(&filter);
+	}
+
+	zbx_free(prev.row_fingerprints);
+}
@@ -0,0 +1,330 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/poller/async_agent.c"
+
+#define MOCK_INTERFACES_MAX	16
+
+void	__wrap_zbx_dc_add_agent_session_stats(const zbx_dc_agent_session_stats_t *stats, int idle_delta);
+
+/* statistics are flushed to configuration cache when session pool is destroyed */
+void	__wrap_zbx_dc_add_agent_session_stats(const zbx_dc_agent_session_stats_t *stats, int idle_delta)
+{
+	ZBX_UNUSED(stats);
+	ZBX_UNUSED(idle_delta);
+}
+
+static unsigned char	mock_str_to_support(const char *str)
+{
+	if (0 == strcmp(str, "UNKNOWN"))
+		return ASYNC_SESSION_UNKNOWN;
+
+	if (0 == strcmp(str, "PROBING"))
+		return ASYNC_SESSION_PROBING;
+
+	if (0 == strcmp(str, "SUPPORTED"))
+		return ASYNC_SESSION_SUPPORTED;
+
+	if (0 == strcmp(str, "UNSUPPORTED"))
+		return ASYNC_SESSION_UNSUPPORTED;
+
+	fail_msg("unknown session support \"%s\"", str);
+
+	return ASYNC_SESSION_UNKNOWN;
+}
+
+static void	mock_read_items(zbx_agent_context *agent_context)
+{
+	zbx_mock_handle_t	hitems, hitem;
+	zbx_mock_error_t	err;
+	int			i;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)); i++)
+	{
+		zbx_dc_item_context_t	*item;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		agent_context->items = (zbx_dc_item_context_t *)zbx_realloc(agent_context->items,
+				sizeof(zbx_dc_item_context_t) * (size_t)(i + 1));
+		agent_context->timeouts = (int *)zbx_realloc(agent_context->timeouts, sizeof(int) * (size_t)(i + 1));
+
+		item = &agent_context->items[i];
+		memset(item, 0, sizeof(zbx_dc_item_context_t));
+		item->itemid = (zbx_uint64_t)(i + 1);
+		item->key = zbx_strdup(NULL, zbx_mock_get_object_member_string(hitem, "key"));
+		item->key_orig = zbx_strdup(NULL, item->key);
+		item->flags = (unsigned char)zbx_mock_get_object_member_uint64(hitem, "flags");
+		item->interface.addr = "127.0.0.1";
+		zbx_init_agent_result(&item->result);
+
+		agent_context->timeouts[i] = (int)zbx_mock_get_object_member_uint64(hitem, "timeout");
+		agent_context->items_num = i + 1;
+	}
+}
+
+static void	mock_check_results(const zbx_agent_context *agent_context)
+{
+	zbx_mock_handle_t	hresults, hresult, hvalue;
+	zbx_mock_error_t	err;
+	int			i;
+
+	hresults = zbx_mock_get_parameter_handle("out.results");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hresults, &hresult)); i++)
+	{
+		const zbx_dc_item_context_t	*item;
+		const char			*str;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read result: %s", zbx_mock_error_string(err));
+
+		if (i >= agent_context->items_num)
+			fail_msg("expected more than %d results", agent_context->items_num);
+
+		item = &agent_context->items[i];
+
+		zbx_mock_assert_int_eq("item return code", zbx_mock_str_to_return_code(
+				zbx_mock_get_object_member_string(hresult, "ret")), item->ret);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "value", &hvalue))
+		{
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &str)))
+				fail_msg("cannot read value: %s", zbx_mock_error_string(err));
+
+			if (!ZBX_ISSET_TEXT(&item->result))
+				fail_msg("item %d has no value", i);
+
+			zbx_mock_assert_str_eq("item value", str, item->result.text);
+		}
+		else
+		{
+			str = zbx_mock_get_object_member_string(hresult, "error");
+
+			if (!ZBX_ISSET_MSG(&item->result))
+				fail_msg("item %d has no error", i);
+
+			zbx_mock_assert_str_eq("item error", str, item->result.msg);
+		}
+	}
+
+	zbx_mock_assert_int_eq("number of results", agent_context->items_num, i);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks passive checks batch request and parsing of its response   *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_batch(void)
+{
+	zbx_agent_context	agent_context;
+	char			*response;
+
+	memset(&agent_context, 0, sizeof(agent_context));
+	agent_context.mode = ZABBIX_AGENT_MODE_BATCH;
+	zbx_socket_clean(&agent_context.s);
+
+	mock_read_items(&agent_context);
+
+	agent_context.request = agent_batch_request(&agent_context);
+	zbx_mock_assert_str_eq("batch request", zbx_mock_get_parameter_string("out.request"),
+			agent_context.request);
+
+	zbx_mock_assert_int_eq("receive flags", (int)zbx_mock_get_parameter_uint64("out.flags"),
+			agent_recv_flags(&agent_context));
+
+	response = zbx_strdup(NULL, zbx_mock_get_parameter_string("in.response"));
+	agent_context.s.buffer = response;
+
+	zbx_mock_assert_result_eq("agent_handle_batch_response()", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.return")), agent_handle_batch_response(&agent_context));
+
+	if (SUCCEED == zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return")))
+	{
+		zbx_mock_assert_int_eq("session timeout", (int)zbx_mock_get_parameter_uint64("out.session_timeout"),
+				agent_context.session_timeout);
+		mock_check_results(&agent_context);
+	}
+
+	zbx_free(response);
+	zbx_socket_clean(&agent_context.s);
+	zbx_async_check_agent_clean(&agent_context);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks reuse of idle agent session connections                    *
+ *                                                                            *
+ * Comments: Agent side of session connections is the peer socket of socket   *
+ *           pair, closing it simulates agent closing the idle connection.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_session(void)
+{
+	zbx_async_session_pool_t	pool;
+	zbx_mock_handle_t		hsteps, hstep;
+	zbx_mock_error_t		err;
+	int				fds[MOCK_INTERFACES_MAX], peers[MOCK_INTERFACES_MAX], i;
+
+	for (i = 0; i < MOCK_INTERFACES_MAX; i++)
+		fds[i] = peers[i] = -1;
+
+	async_session_pool_init(&pool);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		const char	*op;
+		zbx_uint64_t	interfaceid;
+		zbx_socket_t	s;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step: %s", zbx_mock_error_string(err));
+
+		op = zbx_mock_get_object_member_string(hstep, "op");
+		interfaceid = zbx_mock_get_object_member_uint64(hstep, "interfaceid");
+
+		if (MOCK_INTERFACES_MAX <= interfaceid)
+			fail_msg("interfaceid " ZBX_FS_UI64 " is out of range", interfaceid);
+
+		if (0 == strcmp(op, "release"))
+		{
+			int	pair[2];
+
+			if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, pair))
+				fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+			zbx_socket_clean(&s);
+			s.socket = pair[0];
+			s.connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+
+			if (-1 == fds[interfaceid])
+			{
+				fds[interfaceid] = pair[0];
+				peers[interfaceid] = pair[1];
+			}
+			else
+				close(pair[1]);
+
+			async_session_release(&pool, interfaceid, zbx_mock_get_object_member_string(hstep, "addr"),
+					(unsigned short)zbx_mock_get_object_member_uint64(hstep, "port"),
+					ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL, &s,
+					(int)zbx_mock_get_object_member_uint64(hstep, "timeout"));
+
+			/* connection that was not kept is closed */
+			if (NULL == ((zbx_async_session_t *)zbx_hashset_search(&pool.sessions, &interfaceid))->s)
+			{
+				close(peers[interfaceid]);
+				fds[interfaceid] = peers[interfaceid] = -1;
+			}
+		}
+		else if (0 == strcmp(op, "acquire"))
+		{
+			int	ret, expected_ret;
+
+			expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+
+			zbx_socket_clean(&s);
+			ret = async_session_acquire(&pool, interfaceid, zbx_mock_get_object_member_string(hstep, "addr"),
+					(unsigned short)zbx_mock_get_object_member_uint64(hstep, "port"),
+					ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL, &s);
+
+			zbx_mock_assert_result_eq("async_session_acquire()", expected_ret, ret);
+
+			if (SUCCEED == ret)
+			{
+				zbx_mock_assert_int_eq("acquired socket", fds[interfaceid], s.socket);
+				zbx_tcp_close(&s);
+			}
+
+			if (-1 != peers[interfaceid])
+				close(peers[interfaceid]);
+
+			fds[interfaceid] = peers[interfaceid] = -1;
+		}
+		else if (0 == strcmp(op, "close"))
+		{
+			close(peers[interfaceid]);
+			peers[interfaceid] = -1;
+		}
+		else if (0 == strcmp(op, "age"))
+		{
+			zbx_async_session_t	*session;
+
+			session = (zbx_async_session_t *)zbx_hashset_search(&pool.sessions, &interfaceid);
+			session->idle_since -= (time_t)zbx_mock_get_object_member_uint64(hstep, "seconds");
+		}
+		else if (0 == strcmp(op, "set_support"))
+		{
+			async_session_set_support(&pool, interfaceid, mock_str_to_support(
+					zbx_mock_get_object_member_string(hstep, "support")));
+		}
+		else if (0 == strcmp(op, "get_support"))
+		{
+			zbx_mock_assert_int_eq("session support", mock_str_to_support(
+					zbx_mock_get_object_member_string(hstep, "support")),
+					async_session_get_support(&pool, interfaceid));
+		}
+		else
+			fail_msg("unknown step \"%s\"", op);
+	}
+
+	zbx_mock_assert_uint64_eq("reused connections", zbx_mock_get_parameter_uint64("out.reused"),
+			pool.stats.reused);
+	zbx_mock_assert_uint64_eq("expired connections", zbx_mock_get_parameter_uint64("out.expired"),
+			pool.stats.expired);
+	zbx_mock_assert_uint64_eq("fallbacks", zbx_mock_get_parameter_uint64("out.fallbacks"),
+			pool.stats.fallbacks);
+	zbx_mock_assert_int_eq("idle connections", (int)zbx_mock_get_parameter_uint64("out.idle"),
+			pool.idle_delta);
+
+	async_session_pool_destroy(&pool);
+
+	for (i = 0; i < MOCK_INTERFACES_MAX; i++)
+	{
+		if (-1 != peers[i])
+			close(peers[i]);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*test;
+
+	ZBX_UNUSED(state);
+
+	test = zbx_mock_get_parameter_string("in.test");
+
+	if (0 == strcmp(test, "batch"))
+		test_batch();
+	else if (0 == strcmp(test, "session"))
+		test_session();
+	else
+		fail_msg("unknown test \"%s\"", test);
+}
@@ -0,0 +1,330 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/poller/async_lease.h"
+
+/* the configuration revision at which changed items were modified */
+#define MOCK_CHANGE_REVISION	2
+
+static zbx_uint64_t		mock_revision = 1;
+static zbx_vector_uint64_t	mock_changed, mock_validated;
+static zbx_vector_uint64_pair_t	mock_checked;
+
+/* configuration cache functions used by lease are mocked, configuration cache library is not linked */
+
+zbx_uint64_t	zbx_dc_get_config_revision(void)
+{
+	return mock_revision;
+}
+
+static int	mock_item_validate(zbx_uint64_t itemid, zbx_uint64_t revision)
+{
+	if (MOCK_CHANGE_REVISION > mock_revision || MOCK_CHANGE_REVISION <= revision)
+		return SUCCEED;
+
+	if (FAIL != zbx_vector_uint64_search(&mock_changed, itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+int	zbx_dc_config_get_owned_poller_items(unsigned char poller_type, const zbx_uint64_t *itemids,
+		const zbx_uint64_t *revisions, int itemids_num, zbx_dc_item_t *items, zbx_vector_uint64_t *released,
+		zbx_uint64_t *revision)
+{
+	int	i, num = 0;
+
+	ZBX_UNUSED(poller_type);
+
+	for (i = 0; i < itemids_num; i++)
+	{
+		zbx_uint64_pair_t	pair = {itemids[i], revisions[i]};
+
+		zbx_vector_uint64_pair_append(&mock_checked, pair);
+
+		if (SUCCEED != mock_item_validate(itemids[i], revisions[i]))
+		{
+			zbx_vector_uint64_append(released, itemids[i]);
+			continue;
+		}
+
+		memset(&items[num], 0, sizeof(zbx_dc_item_t));
+		items[num++].itemid = itemids[i];
+	}
+
+	*revision = mock_revision;
+
+	return num;
+}
+
+void	zbx_dc_poller_get_owned_nextchecks(const zbx_uint64_t *itemids, const int *lastclocks, int *nextchecks,
+		size_t num)
+{
+	size_t	i;
+
+	ZBX_UNUSED(itemids);
+
+	/* reschedule items to be due immediately */
+	for (i = 0; i < num; i++)
+		nextchecks[i] = lastclocks[i];
+}
+
+void	zbx_dc_poller_validate_owned_items(unsigned char poller_type, const zbx_uint64_t *itemids,
+		const zbx_uint64_t *revisions, int itemids_num, zbx_vector_uint64_t *released, zbx_uint64_t *revision)
+{
+	int	i;
+
+	ZBX_UNUSED(poller_type);
+
+	for (i = 0; i < itemids_num; i++)
+	{
+		zbx_vector_uint64_append(&mock_validated, itemids[i]);
+
+		if (SUCCEED != mock_item_validate(itemids[i], revisions[i]))
+			zbx_vector_uint64_append(released, itemids[i]);
+	}
+
+	*revision = mock_revision;
+}
+
+void	zbx_dc_poller_flush_owned_nextchecks(const zbx_uint64_t *itemids, const int *nextchecks, size_t num)
+{
+	ZBX_UNUSED(itemids);
+	ZBX_UNUSED(nextchecks);
+	ZBX_UNUSED(num);
+}
+
+static void	mock_read_itemids(const char *path, zbx_vector_uint64_t *itemids)
+{
+	zbx_mock_handle_t	hitemids, hitemid;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		itemid;
+
+	hitemids = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitemids, &hitemid)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hitemid, &itemid)))
+			fail_msg("cannot read item identifier: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(itemids, itemid);
+	}
+}
+
+static void	mock_assert_itemids(const char *path, zbx_vector_uint64_t *itemids)
+{
+	zbx_vector_uint64_t	expected;
+	int			i;
+
+	zbx_vector_uint64_create(&expected);
+	mock_read_itemids(path, &expected);
+
+	zbx_vector_uint64_sort(&expected, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_mock_assert_int_eq(path, expected.values_num, itemids->values_num);
+
+	for (i = 0; i < expected.values_num; i++)
+		zbx_mock_assert_uint64_eq(path, expected.values[i], itemids->values[i]);
+
+	zbx_vector_uint64_destroy(&expected);
+}
+
+static void	mock_assert_owned(const char *path, zbx_async_lease_t *lease)
+{
+	zbx_vector_uint64_t	itemids;
+	zbx_hashset_iter_t	iter;
+	zbx_async_lease_item_t	*item;
+
+	zbx_vector_uint64_create(&itemids);
+
+	zbx_hashset_iter_reset(&lease->items, &iter);
+	while (NULL != (item = (zbx_async_lease_item_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_append(&itemids, item->itemid);
+
+	mock_assert_itemids(path, &itemids);
+
+	zbx_vector_uint64_destroy(&itemids);
+}
+
+static void	mock_requeue(zbx_async_lease_t *lease, zbx_vector_uint64_t *itemids, const char *path)
+{
+	zbx_vector_int32_t	errcodes, lastclocks;
+	zbx_mock_handle_t	hresults = 0;
+	int			i, now;
+
+	if (NULL != path)
+		hresults = zbx_mock_get_parameter_handle(path);
+
+	zbx_vector_int32_create(&errcodes);
+	zbx_vector_int32_create(&lastclocks);
+
+	now = (int)time(NULL);
+
+	for (i = 0; i < itemids->values_num; i++)
+	{
+		zbx_mock_handle_t	hresult;
+		char			name[MAX_ID_LEN + 1];
+		int			errcode = SUCCEED;
+
+		zbx_snprintf(name, sizeof(name), ZBX_FS_UI64, itemids->values[i]);
+
+		if (NULL != path && ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresults, name, &hresult))
+		{
+			const char	*str;
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hresult, &str))
+				fail_msg("cannot read item " ZBX_FS_UI64 " check result", itemids->values[i]);
+
+			errcode = zbx_mock_str_to_return_code(str);
+		}
+
+		zbx_vector_int32_append(&errcodes, errcode);
+		zbx_vector_int32_append(&lastclocks, now - 1);
+	}
+
+	async_lease_requeue(lease, itemids, &errcodes, &lastclocks);
+
+	zbx_vector_int32_destroy(&lastclocks);
+	zbx_vector_int32_destroy(&errcodes);
+}
+
+static void	mock_get_items(zbx_async_lease_t *lease, int max_items, zbx_vector_uint64_t *itemids,
+		zbx_vector_uint64_t *released)
+{
+	zbx_dc_item_t	*items;
+	int		i, num;
+
+	if (0 != (num = async_lease_get_items(lease, max_items, &items, released)))
+	{
+		for (i = 0; i < num; i++)
+			zbx_vector_uint64_append(itemids, items[i].itemid);
+
+		zbx_free(items);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_async_lease_t	lease;
+	zbx_mock_handle_t	hitems, hitem, hrevisions, hrevision;
+	zbx_mock_error_t	err;
+	zbx_vector_uint64_t	itemids, released;
+	zbx_dc_item_t		*items = NULL;
+	int			i, items_num = 0;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_uint64_create(&mock_changed);
+	zbx_vector_uint64_create(&mock_validated);
+	zbx_vector_uint64_pair_create(&mock_checked);
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_create(&released);
+
+	mock_read_itemids("in.changed", &mock_changed);
+	zbx_vector_uint64_sort(&mock_changed, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	async_lease_init(&lease, ZBX_POLLER_TYPE_AGENT, (int)zbx_mock_get_parameter_uint64("in.process_num"),
+			(int)zbx_mock_get_parameter_uint64("in.processes_num"));
+
+	/* items taken from poller queue are owned only by the poller of their partition */
+	hitems = zbx_mock_get_parameter_handle("in.items");
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		items = (zbx_dc_item_t *)zbx_realloc(items, sizeof(zbx_dc_item_t) * (size_t)(items_num + 1));
+		memset(&items[items_num], 0, sizeof(zbx_dc_item_t));
+		items[items_num].itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		items[items_num].interface.interfaceid = zbx_mock_get_object_member_uint64(hitem, "interfaceid");
+		items[items_num].host.hostid = zbx_mock_get_object_member_uint64(hitem, "hostid");
+		zbx_vector_uint64_append(&itemids, items[items_num].itemid);
+		items_num++;
+	}
+
+	async_lease_acquire(&lease, items, items_num);
+	zbx_free(items);
+
+	mock_assert_owned("out.owned", &lease);
+
+	/* owned items are kept unless check fails with network error, the rest is returned to poller queue */
+	mock_requeue(&lease, &itemids, "in.results");
+	mock_assert_itemids("out.requeued", &itemids);
+	zbx_vector_uint64_clear(&itemids);
+
+	/* take some owned items for checking */
+	mock_get_items(&lease, (int)zbx_mock_get_parameter_uint64("in.checked_num"), &itemids, &released);
+	zbx_mock_assert_int_eq("released items", 0, released.values_num);
+
+	/* configuration change, only scheduled items are validated */
+	mock_revision = MOCK_CHANGE_REVISION;
+	async_lease_sync(&lease, &released);
+
+	mock_assert_itemids("out.validated", &mock_validated);
+	mock_assert_itemids("out.released", &released);
+	zbx_vector_uint64_clear(&released);
+
+	/* items being checked during configuration change are validated against their old revision */
+	mock_requeue(&lease, &itemids, NULL);
+	zbx_vector_uint64_clear(&itemids);
+	zbx_vector_uint64_pair_clear(&mock_checked);
+
+	mock_get_items(&lease, lease.items.num_data, &itemids, &released);
+	mock_assert_itemids("out.released_checked", &released);
+
+	hrevisions = zbx_mock_get_parameter_handle("out.revisions");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrevisions, &hrevision)))
+	{
+		zbx_uint64_t	itemid;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item revision: %s", zbx_mock_error_string(err));
+
+		itemid = zbx_mock_get_object_member_uint64(hrevision, "itemid");
+
+		for (i = 0; i < mock_checked.values_num; i++)
+		{
+			if (mock_checked.values[i].first == itemid)
+				break;
+		}
+
+		if (i == mock_checked.values_num)
+			fail_msg("item " ZBX_FS_UI64 " was not checked", itemid);
+
+		zbx_mock_assert_uint64_eq("validated revision", zbx_mock_get_object_member_uint64(hrevision,
+				"revision"), mock_checked.values[i].second);
+	}
+
+	mock_assert_owned("out.kept", &lease);
+
+	async_lease_destroy(&lease);
+
+	zbx_vector_uint64_destroy(&released);
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_vector_uint64_pair_destroy(&mock_checked);
+	zbx_vector_uint64_destroy(&mock_validated);
+	zbx_vector_uint64_destroy(&mock_changed);
+}
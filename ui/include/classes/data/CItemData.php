@@ -363,6 +363,7 @@ final class CItemData {
 			'snmptrap[<regex>]'
 		],
 		ITEM_TYPE_INTERNAL => [
+			'zabbix[agent_sessions,<mode>]',
 			'zabbix[boottime]',
 			'zabbix[connector_queue]',
 			'zabbix[discovery_queue]',
@@ -2757,6 +2758,13 @@ final class CItemData {
 					ITEM_TYPE_ZABBIX_ACTIVE => 'config/items/itemtypes/zabbix_agent#zabbix.stats'
 				]
 			],
+			'zabbix[agent_sessions,<mode>]' => [
+				'description' => _('Passive agent session statistics of asynchronous agent pollers, "mode" - connections/reused/expired/requests/checks/fallbacks/idle'),
+				'value_type' => ITEM_VALUE_TYPE_UINT64,
+				'documentation_link' => [
+					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#agent.sessions'
+				]
+			],
 			'zabbix[boottime]' => [
 				'description' => _('Startup time of Zabbix server, Unix timestamp.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64,